@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/allocator/AllocSizeHistogram.h"
+
+#include <folly/Format.h>
+
+#include <limits>
+#include <stdexcept>
+
+namespace facebook {
+namespace cachelib {
+
+constexpr size_t AllocSizeHistogram::kNumBuckets;
+
+AllocSizeHistogram::AllocSizeHistogram(uint32_t sampleRate)
+    : sampleRate_(sampleRate) {
+  if (sampleRate_ == 0) {
+    throw std::invalid_argument("Invalid sample rate 0");
+  }
+}
+
+uint32_t AllocSizeHistogram::getBucketMaxSize(size_t idx) noexcept {
+  constexpr size_t kNumLinear = kLinearMaxSize / kLinearStep;
+  if (idx < kNumLinear) {
+    return static_cast<uint32_t>((idx + 1) * kLinearStep);
+  }
+  const auto power = static_cast<unsigned int>(
+      folly::constexpr_log2(kLinearMaxSize) + (idx - kNumLinear) / kSubBuckets);
+  const auto sub = static_cast<uint32_t>((idx - kNumLinear) % kSubBuckets);
+  return (1u << power) + (sub + 1) * (1u << (power - kSubBucketBits));
+}
+
+std::vector<AllocSizeHistogram::Bucket> AllocSizeHistogram::getBuckets()
+    const {
+  std::vector<Bucket> buckets;
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    const auto count = buckets_[i].count.load(std::memory_order_relaxed);
+    if (count == 0) {
+      continue;
+    }
+    buckets.push_back(Bucket{getBucketMaxSize(i), count,
+                             buckets_[i].sizeSum.load(
+                                 std::memory_order_relaxed)});
+  }
+  return buckets;
+}
+
+uint64_t AllocSizeHistogram::getNumSamples() const {
+  uint64_t numSamples = 0;
+  for (const auto& bucket : buckets_) {
+    numSamples += bucket.count.load(std::memory_order_relaxed);
+  }
+  return numSamples;
+}
+
+void AllocSizeHistogram::reset() noexcept {
+  for (auto& bucket : buckets_) {
+    bucket.count.store(0, std::memory_order_relaxed);
+    bucket.sizeSum.store(0, std::memory_order_relaxed);
+  }
+}
+
+double AllocSizeHistogram::getCostPerAlloc(uint32_t allocSize) noexcept {
+  const auto allocsPerSlab = Slab::kSize / allocSize;
+  return allocSize +
+         static_cast<double>(Slab::kSize % allocSize) / allocsPerSlab;
+}
+
+std::set<uint32_t> AllocSizeHistogram::proposeAllocSizes(
+    unsigned int numClasses) const {
+  if (numClasses == 0 || numClasses > MemoryAllocator::kMaxClasses) {
+    throw std::invalid_argument(
+        folly::sformat("Invalid number of allocation classes {}", numClasses));
+  }
+
+  const auto buckets = getBuckets();
+  const size_t n = buckets.size();
+  if (n == 0) {
+    return {};
+  }
+
+  // prefix sums of the counts and sizes, so that the waste of a class
+  // serving the buckets (i, j] is known in constant time.
+  std::vector<double> counts(n + 1, 0);
+  std::vector<double> sums(n + 1, 0);
+  std::vector<uint32_t> classSizes(n);
+  for (size_t i = 0; i < n; i++) {
+    counts[i + 1] = counts[i] + static_cast<double>(buckets[i].count);
+    sums[i + 1] = sums[i] + static_cast<double>(buckets[i].sizeSum);
+    classSizes[i] = std::max<uint32_t>(
+        buckets[i].maxSize, static_cast<uint32_t>(Slab::kMinAllocSize));
+  }
+  const auto waste = [&](size_t i, size_t j) {
+    return (counts[j] - counts[i]) * getCostPerAlloc(classSizes[j - 1]) -
+           (sums[j] - sums[i]);
+  };
+
+  // best[k][j] is the least waste of serving the first j buckets with k
+  // classes, the largest of them serving bucket j - 1. Only the buckets'
+  // largest sizes are candidates, since any other class size wastes more
+  // for the same buckets.
+  const size_t maxClasses = std::min<size_t>(numClasses, n);
+  constexpr double kInf = std::numeric_limits<double>::infinity();
+  std::vector<std::vector<double>> best(maxClasses + 1,
+                                        std::vector<double>(n + 1, kInf));
+  std::vector<std::vector<size_t>> split(maxClasses + 1,
+                                         std::vector<size_t>(n + 1, 0));
+  best[0][0] = 0;
+  for (size_t k = 1; k <= maxClasses; k++) {
+    for (size_t j = k; j <= n; j++) {
+      for (size_t i = k - 1; i < j; i++) {
+        if (best[k - 1][i] == kInf) {
+          continue;
+        }
+        const auto w = best[k - 1][i] + waste(i, j);
+        if (w < best[k][j]) {
+          best[k][j] = w;
+          split[k][j] = i;
+        }
+      }
+    }
+  }
+
+  // more classes usually waste less, but not always because of the ends of
+  // the slabs.
+  size_t bestK = 1;
+  for (size_t k = 2; k <= maxClasses; k++) {
+    if (best[k][n] < best[bestK][n]) {
+      bestK = k;
+    }
+  }
+
+  std::set<uint32_t> allocSizes;
+  for (size_t k = bestK, j = n; k > 0; j = split[k][j], k--) {
+    allocSizes.insert(classSizes[j - 1]);
+  }
+  return allocSizes;
+}
+
+double AllocSizeHistogram::getWastedFraction(
+    const std::set<uint32_t>& allocSizes) const {
+  double wasted = 0;
+  double used = 0;
+  for (const auto& bucket : getBuckets()) {
+    const auto avgSize = static_cast<double>(bucket.sizeSum) / bucket.count;
+    const auto it = allocSizes.lower_bound(static_cast<uint32_t>(avgSize));
+    if (it == allocSizes.end()) {
+      continue;
+    }
+    const auto cost = bucket.count * getCostPerAlloc(*it);
+    wasted += cost - static_cast<double>(bucket.sizeSum);
+    used += cost;
+  }
+  return used == 0 ? 0 : wasted / used;
+}
+
+} // namespace cachelib
+} // namespace facebook
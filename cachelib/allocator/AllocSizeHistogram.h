@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/ConstexprMath.h>
+#include <folly/Random.h>
+#include <folly/lang/Bits.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <set>
+#include <vector>
+
+#include "cachelib/allocator/memory/MemoryAllocator.h"
+#include "cachelib/allocator/memory/Slab.h"
+
+namespace facebook {
+namespace cachelib {
+
+// Histogram of the allocation sizes requested from a pool. It is used to
+// propose allocation class sizes that fit the observed sizes better than the
+// ones generated from a fixed factor.
+//
+// Sizes up to kLinearMaxSize are counted in buckets of kLinearStep bytes.
+// Larger sizes are counted in kSubBuckets buckets per power of two, so a
+// bucket is at most ~3% wider than the sizes in it. Every bucket also keeps
+// the sum of its sizes, which makes the memory wasted by a class that serves
+// the bucket exact.
+class AllocSizeHistogram {
+ public:
+  // one bucket of the histogram
+  struct Bucket {
+    // largest size counted in this bucket
+    uint32_t maxSize{0};
+
+    // number of sizes recorded
+    uint64_t count{0};
+
+    // sum of the sizes recorded
+    uint64_t sizeSum{0};
+  };
+
+  static constexpr uint32_t kLinearStep = 8;
+  static constexpr uint32_t kLinearMaxSize = 256;
+  static constexpr unsigned int kSubBucketBits = 5;
+  static constexpr unsigned int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr size_t kNumBuckets =
+      kLinearMaxSize / kLinearStep +
+      (Slab::kNumSlabBits - folly::constexpr_log2(kLinearMaxSize)) *
+          kSubBuckets;
+
+  static_assert(kLinearStep % MemoryAllocator::kAlignment == 0,
+                "bucket sizes must be valid allocation sizes");
+  static_assert((kLinearMaxSize >> kSubBucketBits) >= kLinearStep,
+                "buckets must be at least as wide as the linear ones");
+
+  // @param sampleRate  record one out of sampleRate sizes on average. 1
+  //                    records every size.
+  //
+  // @throw std::invalid_argument if sampleRate is 0
+  explicit AllocSizeHistogram(uint32_t sampleRate = 1);
+
+  // record an allocation size. Recording only touches relaxed atomics, so
+  // it can be done on every allocation. With sampling, a call is recorded
+  // with a probability of 1/sampleRate, drawn from a thread local generator
+  // so that the calls that are not recorded share nothing.
+  void record(uint32_t size) noexcept {
+    if (sampleRate_ > 1 && !folly::Random::oneIn(sampleRate_)) {
+      return;
+    }
+    auto& bucket = buckets_[getBucketIdx(size)];
+    bucket.count.fetch_add(1, std::memory_order_relaxed);
+    bucket.sizeSum.fetch_add(size, std::memory_order_relaxed);
+  }
+
+  // @return the non empty buckets, in increasing order of sizes
+  std::vector<Bucket> getBuckets() const;
+
+  // @return the number of sizes recorded
+  uint64_t getNumSamples() const;
+
+  // drop everything recorded so far, to follow a changing distribution.
+  void reset() noexcept;
+
+  // propose the allocation class sizes that minimize the memory wasted by
+  // the recorded sizes. The wasted memory of an allocation is the difference
+  // between the size of its class and its size, plus its share of the end of
+  // the slab that is too small for another allocation of the class.
+  //
+  // The sizes only cover the recorded sizes. A pool also needs a class for
+  // the largest size it might be asked for.
+  //
+  // @param numClasses  the maximum number of class sizes to propose
+  // @return  the class sizes. empty if nothing was recorded.
+  //
+  // @throw std::invalid_argument if numClasses is 0 or more than
+  //        MemoryAllocator::kMaxClasses
+  std::set<uint32_t> proposeAllocSizes(unsigned int numClasses) const;
+
+  // @return the fraction of the memory used by the recorded sizes that would
+  //         be wasted with the given class sizes, counted the same way as
+  //         for proposeAllocSizes. The sizes of a bucket are assumed to go to
+  //         the class of their average size. Sizes that are larger than every
+  //         class are ignored.
+  double getWastedFraction(const std::set<uint32_t>& allocSizes) const;
+
+  // @return the index of the bucket for the size
+  static size_t getBucketIdx(uint32_t size) noexcept {
+    if (size <= kLinearMaxSize) {
+      return size == 0 ? 0 : (size - 1) / kLinearStep;
+    }
+    const uint32_t v = std::min<uint32_t>(size, Slab::kSize) - 1;
+    const unsigned int power = folly::findLastSet(v) - 1;
+    const unsigned int sub =
+        (v >> (power - kSubBucketBits)) & (kSubBuckets - 1);
+    return kLinearMaxSize / kLinearStep +
+           (power - folly::constexpr_log2(kLinearMaxSize)) * kSubBuckets +
+           sub;
+  }
+
+  // @return the largest size counted in the bucket
+  static uint32_t getBucketMaxSize(size_t idx) noexcept;
+
+ private:
+  struct BucketCounters {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sizeSum{0};
+  };
+
+  // memory an allocation of the class takes, including its share of the
+  // unusable end of the slab.
+  static double getCostPerAlloc(uint32_t allocSize) noexcept;
+
+  const uint32_t sampleRate_{1};
+
+  std::array<BucketCounters, kNumBuckets> buckets_;
+};
+} // namespace cachelib
+} // namespace facebook
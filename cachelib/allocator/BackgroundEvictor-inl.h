@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+namespace facebook {
+namespace cachelib {
+
+template <typename CacheT>
+BackgroundEvictor<CacheT>::BackgroundEvictor(Cache& cache,
+                                             unsigned int freeAllocsPercent,
+                                             unsigned int maxEvictionBatch)
+    : cache_(cache),
+      freeAllocsPercent_(freeAllocsPercent),
+      maxEvictionBatch_(maxEvictionBatch) {}
+
+template <typename CacheT>
+BackgroundEvictor<CacheT>::~BackgroundEvictor() {
+  stop(std::chrono::seconds(0));
+}
+
+template <typename CacheT>
+void BackgroundEvictor<CacheT>::work() {
+  using Wrapper = BackgroundEvictorAPIWrapper<CacheT>;
+
+  // inline evictions from now on wake us up for another run.
+  wakeUpPending_.store(false, std::memory_order_release);
+
+  // the last tier has no tier to demote into, so we only free memory in it
+  // when it is the only tier.
+  const auto numTiers = Wrapper::getNumTiers(cache_);
+  const TierId endTier = static_cast<TierId>(numTiers > 1 ? numTiers - 1 : 1);
+
+  for (TierId tid = 0; tid < endTier; tid++) {
+    for (const auto pid : Wrapper::getRegularPoolIds(cache_)) {
+      const auto& pool = Wrapper::getPool(cache_, tid, pid);
+
+      // allocations still get fresh slabs from this pool, nothing to do.
+      if (!pool.allSlabsAllocated()) {
+        continue;
+      }
+
+      for (ClassId cid = 0; cid < static_cast<ClassId>(pool.getNumClassId());
+           cid++) {
+        if (shouldStopWork()) {
+          return;
+        }
+
+        const auto toEvict =
+            getNumItemsToEvict(pool.getAllocationClass(cid).getStats());
+        if (toEvict == 0) {
+          continue;
+        }
+
+        numClassesBelowWatermark_.fetch_add(1, std::memory_order_relaxed);
+        const auto evicted =
+            Wrapper::traverseAndEvictItems(cache_, tid, pid, cid, toEvict);
+        numEvictedItems_.fetch_add(evicted, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+template <typename CacheT>
+size_t BackgroundEvictor<CacheT>::getNumItemsToEvict(
+    const ACStats& stats) const noexcept {
+  const auto capacity = stats.usedSlabs * stats.allocsPerSlab;
+  if (capacity == 0) {
+    return 0;
+  }
+
+  const auto target = capacity * freeAllocsPercent_ / 100;
+  const auto free = capacity - stats.activeAllocs;
+  if (free >= target) {
+    return 0;
+  }
+  return std::min<size_t>(target - free, maxEvictionBatch_);
+}
+
+template <typename CacheT>
+BackgroundEvictorStats BackgroundEvictor<CacheT>::getStats() const noexcept {
+  BackgroundEvictorStats stats;
+  stats.numEvictedItems = numEvictedItems_.load(std::memory_order_relaxed);
+  stats.numClassesBelowWatermark =
+      numClassesBelowWatermark_.load(std::memory_order_relaxed);
+  stats.numTraversals = getRunCount();
+  return stats;
+}
+
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <set>
+
+#include "cachelib/allocator/CacheStats.h"
+#include "cachelib/allocator/memory/MemoryPool.h"
+#include "cachelib/common/PeriodicWorker.h"
+
+namespace facebook {
+namespace cachelib {
+
+// wrapper that exposes the private APIs of CacheType that are specifically
+// needed for the BackgroundEvictor.
+template <typename C>
+struct BackgroundEvictorAPIWrapper {
+  static unsigned int getNumTiers(C& cache) { return cache.getNumTiers(); }
+
+  static std::set<PoolId> getRegularPoolIds(C& cache) {
+    return cache.getRegularPoolIds();
+  }
+
+  static const MemoryPool& getPool(C& cache, TierId tid, PoolId pid) {
+    return cache.getPoolByTid(pid, tid);
+  }
+
+  static size_t traverseAndEvictItems(
+      C& cache, TierId tid, PoolId pid, ClassId cid, size_t batch) {
+    return cache.traverseAndEvictItems(tid, pid, cid, batch);
+  }
+};
+
+// Evicts items in the background so that allocations find free memory
+// instead of evicting inline. For every (tier, pool, class) whose pool has
+// no more slabs to hand out, items are evicted from the tail of the class
+// in batches until the configured percentage of the class's allocations is
+// free. Evicting from a tier that has a tier below it demotes the items
+// into that tier.
+template <typename CacheT>
+class BackgroundEvictor : public PeriodicWorker {
+ public:
+  using Cache = CacheT;
+  // @param cache               instance of the cache
+  // @param freeAllocsPercent   percentage of a class's allocations to keep
+  //                            free
+  // @param maxEvictionBatch    max number of items evicted from a class in
+  //                            a single run
+  BackgroundEvictor(Cache& cache,
+                    unsigned int freeAllocsPercent,
+                    unsigned int maxEvictionBatch);
+
+  ~BackgroundEvictor();
+
+  BackgroundEvictorStats getStats() const noexcept;
+
+  // Wake the evictor up because an allocation had to evict inline. Only the
+  // first call since the last run wakes the worker, so allocating threads
+  // do not all take the worker's lock.
+  void wakeUpForInlineEviction() noexcept {
+    if (!wakeUpPending_.load(std::memory_order_relaxed) &&
+        !wakeUpPending_.exchange(true, std::memory_order_acq_rel)) {
+      wakeUp();
+    }
+  }
+
+ private:
+  // implement logic in the virtual function in PeriodicWorker
+  // evict from every class that is below the free watermark
+  void work() override final;
+
+  // @return number of items to evict from a class with the given stats to
+  //         bring it to the free watermark, capped at maxEvictionBatch_.
+  size_t getNumItemsToEvict(const ACStats& stats) const noexcept;
+
+  // reference to the cache
+  Cache& cache_;
+
+  const unsigned int freeAllocsPercent_;
+  const unsigned int maxEvictionBatch_;
+
+  // stats on evicted items
+  std::atomic<uint64_t> numEvictedItems_{0};
+  std::atomic<uint64_t> numClassesBelowWatermark_{0};
+
+  // set by the first inline eviction since the last run, cleared when the
+  // evictor runs.
+  std::atomic<bool> wakeUpPending_{false};
+};
+
+} // namespace cachelib
+} // namespace facebook
+
+#include "cachelib/allocator/BackgroundEvictor-inl.h"
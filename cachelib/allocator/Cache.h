@@ -94,12 +94,24 @@ class CacheBase {
   // @param poolId    The pool id to query
   virtual const MemoryPool& getPool(PoolId poolId) const = 0;
 
+  // Get the reference to a memory pool in a given memory tier
+  //
+  // @param poolId    The pool id to query
+  // @param tid       The memory tier of the pool
+  virtual const MemoryPool& getPoolByTid(PoolId poolId, TierId tid) const = 0;
+
   // Get Pool specific stats (regular pools). This includes stats from the
   // Memory Pool and also the cache.
   //
   // @param poolId   the pool id
   virtual PoolStats getPoolStats(PoolId poolId) const = 0;
 
+  // Get Pool specific stats (regular pools) for a single memory tier.
+  //
+  // @param tid      the memory tier
+  // @param poolId   the pool id
+  virtual PoolStats getPoolStats(TierId tid, PoolId poolId) const = 0;
+
   // @param poolId   the pool id
   virtual AllSlabReleaseEvents getAllSlabReleaseEvents(PoolId poolId) const = 0;
 
@@ -110,10 +122,14 @@ class CacheBase {
   //                              estimate the projected age. If 0, returns
   //                              tail age for projection age.
   //
-  // @return PoolEvictionAgeStats   see CacheStats.h
+  // @return PoolEvictionAgeStats   see CacheStats.h, for the top memory tier
   virtual PoolEvictionAgeStats getPoolEvictionAgeStats(
       PoolId pid, unsigned int slabProjectionLength) const = 0;
 
+  // Same as above, for the pool in a single memory tier.
+  virtual PoolEvictionAgeStats getPoolEvictionAgeStats(
+      TierId tid, PoolId pid, unsigned int slabProjectionLength) const = 0;
+
   // @return a map of <stat name -> stat value> representation for all the nvm
   // cache stats. This is useful for our monitoring to directly upload them.
   virtual std::unordered_map<std::string, double> getNvmCacheStatsMap()
@@ -174,6 +190,10 @@ class CacheBase {
   // return the list of currently active pools that are oversized
   virtual std::set<PoolId> getRegularPoolIdsForResize() const = 0;
 
+  // return the list of currently active pools that are oversized in a memory
+  // tier
+  virtual std::set<PoolId> getRegularPoolIdsForResize(TierId tid) const = 0;
+
   // return a list of all valid pool ids.
   virtual std::set<PoolId> getPoolIds() const = 0;
 
@@ -225,6 +245,8 @@ class CacheBase {
   //                   nullptr, a random slab is selected from the pool and
   //                   allocation class.
   //
+  // The slab is released from the top memory tier.
+  //
   // @throw std::invalid_argument if the hint is invalid or if the pid or cid
   //        is invalid.
   virtual void releaseSlab(PoolId pid,
@@ -258,6 +280,8 @@ class CacheBase {
   //              nullptr, a random slab is selected from the pool and
   //              allocation class.
   //
+  // The slab is released from the top memory tier.
+  //
   // @throw std::invalid_argument if the hint is invalid or if the pid or cid
   //        is invalid.
   virtual void releaseSlab(PoolId pid,
@@ -266,6 +290,14 @@ class CacheBase {
                            SlabReleaseMode mode,
                            const void* hint = nullptr) = 0;
 
+  // Same as above, releasing the slab from a pool in the given memory tier.
+  virtual void releaseSlab(TierId tid,
+                           PoolId pid,
+                           ClassId victim,
+                           ClassId receiver,
+                           SlabReleaseMode mode,
+                           const void* hint = nullptr) = 0;
+
   // Reclaim slabs from the slab allocator that were advised away using
   // releaseSlab in SlabReleaseMode::kAdvise mode.
   //
@@ -28,7 +28,9 @@ CacheAllocator<CacheTrait>::CacheAllocator(Config config)
       isOnShm_{config.memMonitoringEnabled()},
       config_(config.validate()),
       tempShm_(isOnShm_ ? std::make_unique<TempShmMapping>(
-                            config_.getCacheSize())
+                            config_.getCacheSize(),
+                            config_.hugePagePolicy,
+                            config_.hugePageFallback)
                         : nullptr),
       allocator_(createPrivateAllocator()),
       compactCacheManager_(std::make_unique<CCacheManager>(*allocator_[0] /* TODO */)),
@@ -49,7 +51,8 @@ CacheAllocator<CacheTrait>::CacheAllocator(Config config)
       cacheCreationTime_{util::getCurrentTimeSec()} {
 
   if (numTiers_ > 1 || std::holds_alternative<FileShmSegmentOpts>(
-      memoryTierConfigs[0].getShmTypeOpts())) {
+      memoryTierConfigs[0].getShmTypeOpts()) ||
+      !memoryTierConfigs[0].getNumaPolicy().isDefault()) {
     throw std::runtime_error(
       "Using custom memory tier or using more than one tier is only "
       "supported for Shared Memory.");
@@ -157,8 +160,12 @@ CacheAllocator<CacheTrait>::CacheAllocator(SharedMemAttachT, Config config)
       accessContainer_(std::make_unique<AccessContainer>(
           deserializer_->deserialize<AccessSerializationType>(),
           config_.accessConfig,
-          shmManager_->attachShm(detail::kShmHashTableName, nullptr,
-            ShmSegmentOpts(PageSizeT::NORMAL, false, config_.isUsingPosixShm())),
+          [this](uint32_t generation) {
+            return shmManager_->attachShm(
+                getAccessContainerShmName(generation), nullptr,
+                ShmSegmentOpts(PageSizeT::NORMAL, false,
+                               config_.isUsingPosixShm()));
+          },
           compressor_,
           [this](Item* it) -> ItemHandle { return acquire(it); })),
       chainedItemAccessContainer_(std::make_unique<AccessContainer>(
@@ -205,10 +212,26 @@ ShmSegmentOpts CacheAllocator<CacheTrait>::createShmCacheOpts(TierId tid) {
   if (auto *v = std::get_if<PosixSysVSegmentOpts>(&opts.typeOpts)) {
     v->usePosix = config_.usePosixShm;
   }
+  opts.numaPolicy = memoryTierConfigs[tid].getNumaPolicy();
+  opts.setHugePagePolicy(
+      memoryTierConfigs[tid].getHugePagePolicy(config_.hugePagePolicy));
 
   return opts;
 }
 
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::recordNumaAccess(
+    TierId tid, TLCounter& remoteAccesses) noexcept {
+  const auto& policy = memoryTierConfigs[tid].getNumaPolicy();
+  if (policy.isDefault()) {
+    return;
+  }
+  const auto node = util::getCurrentNumaNode();
+  if (node < kMaxNumaNodes && !policy.nodes.test(node)) {
+    remoteAccesses.inc();
+  }
+}
+
 template <typename CacheTrait>
 size_t CacheAllocator<CacheTrait>::memoryTierSize(TierId tid) const
 {
@@ -243,7 +266,8 @@ CacheAllocator<CacheTrait>::restoreMemoryAllocator(TierId tid) {
           ->attachShm(detail::kShmCacheName + std::to_string(tid),
             config_.slabMemoryBaseAddr, createShmCacheOpts(tid)).addr,
       memoryTierSize(tid),
-      config_.disableFullCoredump);
+      config_.disableFullCoredump,
+      config_.allocationMagazineSize);
 }
 
 template <typename CacheTrait>
@@ -273,6 +297,20 @@ void CacheAllocator<CacheTrait>::initCommon(bool dramCacheAttached) {
     }
   }
   initStats();
+  if (config_.allocSizeHistogramEnabled()) {
+    for (const auto pid : allocator_[0]->getPoolIds()) {
+      allocSizeHistograms_[pid] = std::make_unique<AllocSizeHistogram>(
+          config_.allocSizeHistogramSampleRate);
+    }
+  }
+  for (const auto pid : allocator_[0]->getPoolIds()) {
+    initValueCompressor(pid);
+  }
+  memoryTierAdmissionPolicy_ = config_.memoryTierAP;
+  if (config_.memoryTierPromotionEnabled()) {
+    promotionCandidates_ = std::make_unique<folly::MPMCQueue<std::string>>(
+        config_.memoryTierPromotionQueueSize);
+  }
   initNvmCache(dramCacheAttached);
   initWorkers();
 }
@@ -340,6 +378,24 @@ void CacheAllocator<CacheTrait>::initWorkers() {
                           config_.poolOptimizeStrategy,
                           config_.ccacheOptimizeStepSizePercent);
   }
+
+  if (config_.backgroundEvictorEnabled()) {
+    startNewBackgroundEvictor(config_.backgroundEvictorInterval,
+                              config_.backgroundEvictorFreeAllocsPercent,
+                              config_.backgroundEvictorBatch);
+  }
+
+  if (config_.memoryTierPromotionEnabled()) {
+    startNewMemoryTierPromoter(config_.memoryTierPromotionInterval,
+                               config_.memoryTierPromotionHits,
+                               config_.memoryTierPromotionsPerRun);
+  }
+
+  if (config_.slabCompactionEnabled()) {
+    startNewSlabCompactor(config_.slabCompactionInterval,
+                          config_.slabCompactionSlabsPerIter,
+                          config_.slabCompactionMinFreePercent);
+  }
 }
 
 template <typename CacheTrait>
@@ -358,6 +414,11 @@ CacheAllocator<CacheTrait>::allocate(PoolId poolId,
                                      uint32_t size,
                                      uint32_t ttlSecs,
                                      uint32_t creationTime) {
+  if (!Item::Times::kSupportsExpiry && ttlSecs > 0) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid ttl {}s, the items of this cache do not support expiry",
+        ttlSecs));
+  }
   if (creationTime == 0) {
     creationTime = util::getCurrentTimeSec();
   }
@@ -365,6 +426,50 @@ CacheAllocator<CacheTrait>::allocate(PoolId poolId,
                           ttlSecs == 0 ? 0 : creationTime + ttlSecs);
 }
 
+template <typename CacheTrait>
+typename CacheAllocator<CacheTrait>::WriteHandle
+CacheAllocator<CacheTrait>::allocateCompressed(PoolId poolId,
+                                               typename Item::Key key,
+                                               folly::ByteRange value,
+                                               uint32_t ttlSecs,
+                                               uint32_t creationTime) {
+  if (static_cast<size_t>(poolId) >= valueCompressors_.size()) {
+    throw std::invalid_argument(folly::sformat("Invalid PoolId: {}", poolId));
+  }
+
+  std::unique_ptr<folly::IOBuf> compressed;
+  if (auto* compressor = valueCompressors_[poolId].get()) {
+    compressed = compressor->compress(value);
+  }
+  const folly::ByteRange payload =
+      compressed ? compressed->coalesce() : value;
+
+  auto handle = allocate(poolId, key, static_cast<uint32_t>(payload.size()),
+                         ttlSecs, creationTime);
+  if (handle) {
+    std::memcpy(handle->getMemory(), payload.data(), payload.size());
+    if (compressed) {
+      handle->markValueCompressed();
+    }
+  }
+  return handle;
+}
+
+template <typename CacheTrait>
+std::unique_ptr<folly::IOBuf> CacheAllocator<CacheTrait>::uncompressValue(
+    const Item& item) {
+  XDCHECK(item.isValueCompressed());
+  const auto pid = getAllocInfo(&item).poolId;
+  auto* compressor = valueCompressors_[pid].get();
+  if (compressor == nullptr) {
+    throw std::invalid_argument(folly::sformat(
+        "Item is compressed, but pool {} has no value compression: {}", pid,
+        item.toString()));
+  }
+  return compressor->uncompress(folly::ByteRange(
+      reinterpret_cast<const uint8_t*>(item.getMemory()), item.getSize()));
+}
+
 template <typename CacheTrait>
 typename CacheAllocator<CacheTrait>::ItemHandle
 CacheAllocator<CacheTrait>::allocateInternalTier(TierId tid,
@@ -383,13 +488,17 @@ CacheAllocator<CacheTrait>::allocateInternalTier(TierId tid,
   // the allocation class in our memory allocator.
   const auto cid = allocator_[tid]->getAllocationClassId(pid, requiredSize);
 
-  // TODO: per-tier
-  (*stats_.allocAttempts)[pid][cid].inc();
+  (*stats_.allocAttempts)[tid][pid][cid].inc();
 
   void* memory = allocator_[tid]->allocate(pid, requiredSize);
   // TODO: Today disableEviction means do not evict from memory (DRAM).
   //       Should we support eviction between memory tiers (e.g. from DRAM to PMEM)?
   if (memory == nullptr && !config_.disableEviction) {
+    // the background evictor did not keep up, let it know we had to evict
+    // inline.
+    if (backgroundEvictor_) {
+      backgroundEvictor_->wakeUpForInlineEviction();
+    }
     memory = findEviction(tid, pid, cid);
   }
 
@@ -407,12 +516,15 @@ CacheAllocator<CacheTrait>::allocateInternalTier(TierId tid,
     handle = acquire(new (memory) Item(key, size, creationTime, expiryTime));
     if (handle) {
       handle.markNascent();
-      (*stats_.fragmentationSize)[pid][cid].add(
+      (*stats_.fragmentationSize)[tid][pid][cid].add(
           util::getFragmentation(*this, *handle));
+      if (UNLIKELY(hasNumaTiers_)) {
+        recordNumaAccess(tid, stats_.numRamRemoteNumaAllocs);
+      }
     }
 
   } else { // failed to allocate memory.
-    (*stats_.allocFailures)[pid][cid].inc(); // TODO: per-tier
+    (*stats_.allocFailures)[tid][pid][cid].inc();
     // wake up rebalancer
     if (poolRebalancer_) {
       poolRebalancer_->wakeUp();
@@ -436,8 +548,14 @@ CacheAllocator<CacheTrait>::allocateInternal(PoolId pid,
                                              uint32_t size,
                                              uint32_t creationTime,
                                              uint32_t expiryTime) {
-  auto tid = 0; /* TODO: consult admission policy */
-  for(TierId tid = 0; tid < numTiers_; ++tid) {
+  recordAllocSize(pid, Item::getRequiredSize(key, size));
+
+  TierId startTier = 0;
+  if (memoryTierAdmissionPolicy_) {
+    startTier = memoryTierAdmissionPolicy_->chooseAllocationTier(
+        key, size, expiryTime, static_cast<TierId>(numTiers_));
+  }
+  for (TierId tid = startTier; tid < numTiers_; ++tid) {
     auto handle = allocateInternalTier(tid, pid, key, size, creationTime, expiryTime);
     if (handle) return handle;
   }
@@ -479,17 +597,16 @@ CacheAllocator<CacheTrait>::allocateChainedItemInternal(
 
   const auto pid = allocator_[tid]->getAllocInfo(parent->getMemory()).poolId;
   const auto cid = allocator_[tid]->getAllocationClassId(pid, requiredSize);
+  recordAllocSize(pid, requiredSize);
 
-  // TODO: per-tier? Right now stats_ are not used in any public periodic
-  // worker
-  (*stats_.allocAttempts)[pid][cid].inc();
+  (*stats_.allocAttempts)[tid][pid][cid].inc();
 
   void* memory = allocator_[tid]->allocate(pid, requiredSize);
   if (memory == nullptr) {
     memory = findEviction(tid, pid, cid);
   }
   if (memory == nullptr) {
-    (*stats_.allocFailures)[pid][cid].inc();
+    (*stats_.allocFailures)[tid][pid][cid].inc();
     return ItemHandle{};
   }
 
@@ -501,7 +618,7 @@ CacheAllocator<CacheTrait>::allocateChainedItemInternal(
 
   if (child) {
     child.markNascent();
-    (*stats_.fragmentationSize)[pid][cid].add(
+    (*stats_.fragmentationSize)[tid][pid][cid].add(
         util::getFragmentation(*this, *child));
   }
 
@@ -518,6 +635,12 @@ void CacheAllocator<CacheTrait>::addChainedItem(ItemHandle& parent,
                        child ? child->toString() : "nullptr"));
   }
 
+  if (parent->isValueCompressed()) {
+    throw std::invalid_argument(folly::sformat(
+        "Compressed items can not have chained items. parent: {}",
+        parent->toString()));
+  }
+
   auto l = chainedItemLocks_.lockExclusive(parent->getKey());
 
   // Insert into secondary lookup table for chained allocation
@@ -649,6 +772,97 @@ void CacheAllocator<CacheTrait>::transferChainLocked(ItemHandle& parent,
   parent->unmarkHasChainedItem();
 }
 
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::allocateChainCopy(
+    const Item& parent,
+    const ReadHandle& newParent,
+    std::vector<WriteHandle>& newChain) {
+  XDCHECK(newChain.empty());
+
+  std::vector<uint32_t> sizes;
+  {
+    auto l = chainedItemLocks_.lockShared(parent.getKey());
+    if (!parent.hasChainedItem()) {
+      return true;
+    }
+    auto headHandle = findChainedItem(parent);
+    for (auto* curr = &headHandle->asChainedItem(); curr != nullptr;
+         curr = curr->getNext(compressor_)) {
+      sizes.push_back(curr->getSize());
+    }
+  }
+
+  newChain.reserve(sizes.size());
+  for (const auto size : sizes) {
+    auto child = allocateChainedItemInternal(newParent, size);
+    if (!child) {
+      newChain.clear();
+      return false;
+    }
+    newChain.push_back(std::move(child));
+  }
+  return true;
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::copyChainLocked(
+    const Item& parent,
+    WriteHandle& newParent,
+    std::vector<WriteHandle>& newChain) {
+  XDCHECK(newParent);
+  XDCHECK_EQ(parent.getKey(), newParent->getKey());
+  XDCHECK(!newParent->hasChainedItem());
+
+  std::vector<ChainedItem*> oldChain;
+  if (parent.hasChainedItem()) {
+    auto headHandle = findChainedItem(parent);
+    for (auto* curr = &headHandle->asChainedItem(); curr != nullptr;
+         curr = curr->getNext(compressor_)) {
+      oldChain.push_back(curr);
+    }
+  }
+
+  if (oldChain.size() != newChain.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < oldChain.size(); i++) {
+    if (oldChain[i]->getSize() != newChain[i]->getSize()) {
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < oldChain.size(); i++) {
+    if (config_.moveCb) {
+      config_.moveCb(*oldChain[i], *newChain[i], newParent.get());
+    } else {
+      std::memcpy(newChain[i]->getWritableMemory(), oldChain[i]->getMemory(),
+                  oldChain[i]->getSize());
+    }
+  }
+
+  // Same as addChainedItem(), the parent is marked before the children are
+  // inserted into MM container. Children are added from the tail so the copy
+  // ends up in the same order as the original chain.
+  newParent->markHasChainedItem();
+  stats_.numChainedParentItems.inc();
+  for (auto it = newChain.rbegin(); it != newChain.rend(); ++it) {
+    auto& child = **it;
+    auto oldHead = chainedItemAccessContainer_->insertOrReplace(child);
+    if (oldHead) {
+      child.asChainedItem().appendChain(oldHead->asChainedItem(), compressor_);
+    }
+    stats_.numChainedChildItems.inc();
+
+    insertInMMContainer(child);
+
+    // owned by the new parent from now on
+    child.incRef();
+    XDCHECK_EQ(2u, child.getRefCount());
+  }
+  newChain.clear();
+  return true;
+}
+
 template <typename CacheTrait>
 void CacheAllocator<CacheTrait>::transferChainAndReplace(
     ItemHandle& parent, ItemHandle& newParent) {
@@ -814,7 +1028,7 @@ CacheAllocator<CacheTrait>::releaseBackToAllocator(Item& it,
     stats_.perPoolEvictionAgeSecs_[allocInfo.poolId].trackValue(refreshTime);
   }
 
-  (*stats_.fragmentationSize)[allocInfo.poolId][allocInfo.classId].sub(
+  (*stats_.fragmentationSize)[tid][allocInfo.poolId][allocInfo.classId].sub(
       util::getFragmentation(*this, it));
 
   // Chained items can only end up in this place if the user has allocated
@@ -887,7 +1101,7 @@ CacheAllocator<CacheTrait>::releaseBackToAllocator(Item& it,
 
       const auto childInfo =
           allocator_[tid]->getAllocInfo(static_cast<const void*>(head));
-      (*stats_.fragmentationSize)[childInfo.poolId][childInfo.classId].sub(
+      (*stats_.fragmentationSize)[tid][childInfo.poolId][childInfo.classId].sub(
           util::getFragmentation(*this, *head));
 
       removeFromMMContainer(*head);
@@ -1221,6 +1435,18 @@ CacheAllocator<CacheTrait>::moveRegularItemOnEviction(
   if (oldItem.isNvmClean()) {
     newItemHdl->markNvmClean();
   }
+  if (oldItem.isValueCompressed()) {
+    newItemHdl->markValueCompressed();
+  }
+
+  // The chain has to live in the same tier as its parent, so we copy it
+  // along with the parent. Allocate the copy upfront so that we can still
+  // give up on the move if the next tier has no room for it.
+  std::vector<WriteHandle> newChain;
+  if (oldItem.hasChainedItem() &&
+      !allocateChainCopy(oldItem, newItemHdl, newChain)) {
+    return {};
+  }
 
   folly::StringPiece key(oldItem.getKey());
   auto shard = getShardForKey(key);
@@ -1296,22 +1522,23 @@ CacheAllocator<CacheTrait>::moveRegularItemOnEviction(
     return {};
   }
 
-  // no one can add or remove chained items at this point
-  if (oldItem.hasChainedItem()) {
-    // safe to acquire handle for a moving Item
-    auto oldHandle = acquire(&oldItem);
-    XDCHECK_EQ(1u, oldHandle->getRefCount()) << oldHandle->toString();
+  // no one can add or remove chained items at this point, but the chain
+  // could have changed since we allocated its copy.
+  if (oldItem.hasChainedItem() || !newChain.empty()) {
     XDCHECK(!newItemHdl->hasChainedItem()) << newItemHdl->toString();
-    try {
+    bool copied = false;
+    {
       auto l = chainedItemLocks_.lockExclusive(oldItem.getKey());
-      transferChainLocked(oldHandle, newItemHdl);
-    } catch (const std::exception& e) {
-      // this should never happen because we drained all the handles.
-      XLOGF(DFATAL, "{}", e.what());
-      throw;
+      copied = copyChainLocked(oldItem, newItemHdl, newChain);
     }
 
-    XDCHECK(!oldItem.hasChainedItem());
+    if (!copied) {
+      // the old item is no longer reachable, so leave it to the caller to
+      // release along with its chain.
+      accessContainer_->remove(*newItemHdl);
+      removeFromMMContainer(*newItemHdl);
+      return {};
+    }
     XDCHECK(newItemHdl->hasChainedItem());
   }
   newItemHdl.unmarkNascent();
@@ -1339,6 +1566,9 @@ bool CacheAllocator<CacheTrait>::moveRegularItem(Item& oldItem,
   if (oldItem.isNvmClean()) {
     newItemHdl->markNvmClean();
   }
+  if (oldItem.isValueCompressed()) {
+    newItemHdl->markValueCompressed();
+  }
 
   // Execute the move callback. We cannot make any guarantees about the
   // consistency of the old item beyond this point, because the callback can
@@ -1510,9 +1740,9 @@ CacheAllocator<CacheTrait>::findEviction(TierId tid, PoolId pid, ClassId cid) {
 
     if (toReleaseHandle || ref == 0u) {
       if (candidate->hasChainedItem()) {
-        (*stats_.chainedItemEvictions)[pid][cid].inc();
+        (*stats_.chainedItemEvictions)[tid][pid][cid].inc();
       } else {
-        (*stats_.regularItemEvictions)[pid][cid].inc();
+        (*stats_.regularItemEvictions)[tid][pid][cid].inc();
       }
     } else {
       if (candidate->hasChainedItem()) {
@@ -1609,11 +1839,21 @@ template <typename CacheTrait>
 typename CacheAllocator<CacheTrait>::WriteHandle
 CacheAllocator<CacheTrait>::tryEvictToNextMemoryTier(
     TierId tid, PoolId pid, Item& item) {
-  if(item.isChainedItem()) return {}; // TODO: We do not support ChainedItem yet
+  // chained items are evicted through their parent, which takes the whole
+  // chain along to the next tier.
+  XDCHECK(!item.isChainedItem());
   if(item.isExpired()) return acquire(&item);
 
-  TierId nextTier = tid; // TODO - calculate this based on some admission policy
+  TierId nextTier = tid;
   while (++nextTier < numTiers_) { // try to evict down to the next memory tiers
+    // items the policy does not want in the next tier are evicted out of
+    // memory instead of being written there.
+    if (memoryTierAdmissionPolicy_ &&
+        !memoryTierAdmissionPolicy_->acceptDemotion(item, tid, nextTier)) {
+      stats_.numDemotionRejectsByAP[tid].inc();
+      return {};
+    }
+
     // allocateInternal might trigger another eviction
     auto newItemHdl = allocateInternalTier(nextTier, pid,
                      item.getKey(),
@@ -1624,7 +1864,11 @@ CacheAllocator<CacheTrait>::tryEvictToNextMemoryTier(
     if (newItemHdl) {
       XDCHECK_EQ(newItemHdl->getSize(), item.getSize());
 
-      return moveRegularItemOnEviction(item, newItemHdl);
+      auto evictHandle = moveRegularItemOnEviction(item, newItemHdl);
+      if (evictHandle) {
+        stats_.numDemotions[tid].inc();
+      }
+      return evictHandle;
     }
   }
 
@@ -1639,6 +1883,94 @@ CacheAllocator<CacheTrait>::tryEvictToNextMemoryTier(Item& item) {
     return tryEvictToNextMemoryTier(tid, pid, item);
 }
 
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::tryPromoteToUpperMemoryTier(
+    typename Item::Key key) {
+  auto handle = findInternal(key);
+  if (!handle) {
+    return false;
+  }
+
+  auto& item = *handle;
+  const auto tid = getTierId(item);
+  if (tid == 0 || item.isExpired()) {
+    return false;
+  }
+
+  // The moving bit keeps the item from being evicted or released while we
+  // copy it. We have to drop our handle afterwards since the item can only
+  // be replaced in the access container once its refcount is zero.
+  if (!item.markMoving()) {
+    stats_.numPromotionFailures[tid].inc();
+    return false;
+  }
+  handle.reset();
+
+  const auto pid = allocator_[tid]->getAllocInfo(item.getMemory()).poolId;
+
+  // allocating in the upper tier might evict, and demote, a colder item
+  // from it.
+  auto newItemHdl =
+      allocateInternalTier(tid - 1, pid, item.getKey(), item.getSize(),
+                           item.getCreationTime(), item.getExpiryTime());
+
+  auto oldHandle =
+      newItemHdl ? moveRegularItemOnEviction(item, newItemHdl) : ItemHandle{};
+  const auto ref = item.unmarkMoving();
+
+  if (oldHandle) {
+    XDCHECK_EQ(1u, oldHandle->getRefCount());
+
+    // The item lives on in the upper tier, so we release the old copy
+    // without going through the remove callback or the item destructor.
+    auto& itemToRelease = *oldHandle.release();
+    const auto oldRef = decRef(itemToRelease);
+    XDCHECK_EQ(0u, oldRef);
+    releaseBackToAllocator(itemToRelease, RemoveContext::kNormal,
+                           /* isNascent */ true);
+    stats_.numPromotions[tid].inc();
+    return true;
+  }
+
+  if (ref == 0u) {
+    // someone removed the item while it was marked as moving and left it
+    // for us to release.
+    releaseBackToAllocator(item, RemoveContext::kNormal,
+                           /* isNascent */ false);
+  }
+  stats_.numPromotionFailures[tid].inc();
+  return false;
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::popPromotionCandidate(std::string& key) {
+  return promotionCandidates_ && promotionCandidates_->read(key);
+}
+
+template <typename CacheTrait>
+size_t CacheAllocator<CacheTrait>::traverseAndEvictItems(TierId tid,
+                                                         PoolId pid,
+                                                         ClassId cid,
+                                                         size_t batch) {
+  if (config_.disableEviction) {
+    return 0;
+  }
+
+  size_t evictions = 0;
+  while (evictions < batch) {
+    // findEviction hands us the memory of the evicted item to recycle. We
+    // give it back to the allocator instead so that the next allocation in
+    // this class finds it on the free list.
+    void* memory = findEviction(tid, pid, cid);
+    if (memory == nullptr) {
+      break;
+    }
+    allocator_[tid]->free(memory);
+    ++evictions;
+  }
+  return evictions;
+}
+
 template <typename CacheTrait>
 typename CacheAllocator<CacheTrait>::RemoveRes
 CacheAllocator<CacheTrait>::remove(typename Item::Key key) {
@@ -1895,14 +2227,22 @@ template <typename CacheTrait>
 typename CacheAllocator<CacheTrait>::ItemHandle
 CacheAllocator<CacheTrait>::findFastImpl(typename Item::Key key,
                                          AccessMode mode) {
-  auto handle = findInternal(key);
+  return onRamLookup(findInternal(key), mode);
+}
 
+template <typename CacheTrait>
+typename CacheAllocator<CacheTrait>::ItemHandle
+CacheAllocator<CacheTrait>::onRamLookup(ItemHandle handle, AccessMode mode) {
   stats_.numCacheGets.inc();
   if (UNLIKELY(!handle)) {
     stats_.numCacheGetMiss.inc();
     return handle;
   }
 
+  if (UNLIKELY(hasNumaTiers_)) {
+    recordNumaAccess(getTierId(*handle), stats_.numRamRemoteNumaHits);
+  }
+
   markUseful(handle, mode);
   return handle;
 }
@@ -1929,8 +2269,13 @@ CacheAllocator<CacheTrait>::findFast(typename Item::Key key, AccessMode mode) {
 template <typename CacheTrait>
 typename CacheAllocator<CacheTrait>::ItemHandle
 CacheAllocator<CacheTrait>::find(typename Item::Key key, AccessMode mode) {
-  auto handle = findFastImpl(key, mode);
+  return completeFind(key, findFastImpl(key, mode));
+}
 
+template <typename CacheTrait>
+typename CacheAllocator<CacheTrait>::ItemHandle
+CacheAllocator<CacheTrait>::completeFind(typename Item::Key key,
+                                         ItemHandle handle) {
   if (handle) {
     if (UNLIKELY(handle->isExpired())) {
       // update cache miss stats if the item has already been expired.
@@ -1990,6 +2335,66 @@ CacheAllocator<CacheTrait>::find(typename Item::Key key) {
   return find(key, AccessMode::kRead);
 }
 
+#if FOLLY_HAS_COROUTINES
+template <typename CacheTrait>
+folly::coro::Task<typename CacheAllocator<CacheTrait>::ReadHandle>
+CacheAllocator<CacheTrait>::co_find(typename Item::Key key) {
+  // not a coroutine, so that the lookup is issued before returning.
+  return co_awaitHandle(find(key));
+}
+
+template <typename CacheTrait>
+folly::coro::Task<typename CacheAllocator<CacheTrait>::ItemHandle>
+CacheAllocator<CacheTrait>::co_findToWrite(typename Item::Key key,
+                                           bool doNvmInvalidation) {
+  // not a coroutine, so that the lookup is issued before returning.
+  return co_completeFindToWrite(find(key, AccessMode::kWrite),
+                                doNvmInvalidation);
+}
+
+template <typename CacheTrait>
+folly::coro::Task<typename CacheAllocator<CacheTrait>::ItemHandle>
+CacheAllocator<CacheTrait>::co_completeFindToWrite(ItemHandle handle,
+                                                   bool doNvmInvalidation) {
+  handle = co_await std::move(handle);
+  if (handle == nullptr) {
+    co_return nullptr;
+  }
+  if (doNvmInvalidation) {
+    invalidateNvm(*handle);
+  }
+  co_return handle;
+}
+
+template <typename CacheTrait>
+folly::coro::Task<typename CacheAllocator<CacheTrait>::ItemHandle>
+CacheAllocator<CacheTrait>::co_insertOrReplace(const ItemHandle& handle) {
+  return co_awaitHandle(insertOrReplace(handle));
+}
+
+template <typename CacheTrait>
+template <typename HandleT>
+folly::coro::Task<HandleT> CacheAllocator<CacheTrait>::co_awaitHandle(
+    HandleT handle) {
+  co_return co_await std::move(handle);
+}
+#endif
+
+template <typename CacheTrait>
+std::vector<typename CacheAllocator<CacheTrait>::ReadHandle>
+CacheAllocator<CacheTrait>::findBatch(folly::Range<const Key*> keys) {
+  auto ramHandles = accessContainer_->findBatch(keys);
+  XDCHECK_EQ(ramHandles.size(), keys.size());
+
+  std::vector<ReadHandle> handles;
+  handles.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    handles.emplace_back(completeFind(
+        keys[i], onRamLookup(std::move(ramHandles[i]), AccessMode::kRead)));
+  }
+  return handles;
+}
+
 template <typename CacheTrait>
 void CacheAllocator<CacheTrait>::markUseful(const ItemHandle& handle,
                                             AccessMode mode) {
@@ -2017,13 +2422,28 @@ bool CacheAllocator<CacheTrait>::recordAccessInMMContainer(Item& item,
   const auto tid = getTierId(item);
   const auto allocInfo =
       allocator_[tid]->getAllocInfo(static_cast<const void*>(&item));
-  (*stats_.cacheHits)[allocInfo.poolId][allocInfo.classId].inc();
+  (*stats_.cacheHits)[tid][allocInfo.poolId][allocInfo.classId].inc();
 
   // track recently accessed items if needed
   if (UNLIKELY(config_.trackRecentItemsForDump)) {
     ring_->trackItem(reinterpret_cast<uintptr_t>(&item), item.getSize());
   }
 
+  if (UNLIKELY(memoryTierAdmissionPolicy_ != nullptr) &&
+      !item.isChainedItem()) {
+    memoryTierAdmissionPolicy_->trackAccess(item.getKey());
+  }
+
+  // queue hits on items in the lower memory tiers for promotion. When the
+  // promoter falls behind the queue fills up and the hit is dropped. The key
+  // is copied into the slot only once one is obtained, so a dropped hit does
+  // not allocate.
+  if (UNLIKELY(tid > 0 && promotionCandidates_ != nullptr) &&
+      !item.isChainedItem()) {
+    const auto key = item.getKey();
+    promotionCandidates_->write(key.data(), key.size());
+  }
+
   auto& mmContainer = getMMContainer(tid, allocInfo.poolId, allocInfo.classId);
   return mmContainer.recordAccess(item, mode);
 }
@@ -2101,6 +2521,13 @@ folly::IOBuf CacheAllocator<CacheTrait>::convertToIOBufT(Handle& handle) {
   }
 
   Item* item = handle.getInternal();
+  if (item->isValueCompressed()) {
+    // the value does not live in the item, so the handle is not needed
+    // past this point.
+    auto value = uncompressValue(*item);
+    handle.reset();
+    return std::move(*value);
+  }
   const uint32_t dataOffset = item->getOffsetForMemory();
 
   using ConvertChainedItem = std::function<std::unique_ptr<folly::IOBuf>(
@@ -2253,6 +2680,23 @@ folly::IOBuf CacheAllocator<CacheTrait>::wrapAsIOBuf(const Item& item) {
   return ioBuf;
 }
 
+template <typename CacheTrait>
+std::vector<size_t> CacheAllocator<CacheTrait>::getTierSizes(
+    size_t size) const {
+  size_t totalCacheSize = 0;
+  for (TierId tid = 0; tid < numTiers_; tid++) {
+    totalCacheSize += allocator_[tid]->getMemorySize();
+  }
+
+  std::vector<size_t> tierSizes;
+  for (TierId tid = 0; tid < numTiers_; tid++) {
+    auto tierSizeRatio =
+        static_cast<double>(allocator_[tid]->getMemorySize()) / totalCacheSize;
+    tierSizes.push_back(static_cast<size_t>(tierSizeRatio * size));
+  }
+  return tierSizes;
+}
+
 template <typename CacheTrait>
 PoolId CacheAllocator<CacheTrait>::addPool(
     folly::StringPiece name,
@@ -2265,21 +2709,7 @@ PoolId CacheAllocator<CacheTrait>::addPool(
   folly::SharedMutex::WriteHolder w(poolsResizeAndRebalanceLock_);
 
   PoolId pid = 0;
-  std::vector<size_t> tierPoolSizes;
-  const auto &tierConfigs = config_.getMemoryTierConfigs();
-  size_t totalCacheSize = 0;
-
-  for (TierId tid = 0; tid < numTiers_; tid++) {
-    totalCacheSize += allocator_[tid]->getMemorySize();
-  }
-
-  for (TierId tid = 0; tid < numTiers_; tid++) {
-    auto tierSizeRatio =
-        static_cast<double>(allocator_[tid]->getMemorySize()) / totalCacheSize;
-    size_t tierPoolSize = static_cast<size_t>(tierSizeRatio * size);
-
-    tierPoolSizes.push_back(tierPoolSize);
-  }
+  const auto tierPoolSizes = getTierSizes(size);
 
   for (TierId tid = 0; tid < numTiers_; tid++) {
     // TODO: what if we manage to add pool only in one tier?
@@ -2293,10 +2723,81 @@ PoolId CacheAllocator<CacheTrait>::addPool(
   createMMContainers(pid, std::move(config));
   setRebalanceStrategy(pid, std::move(rebalanceStrategy));
   setResizeStrategy(pid, std::move(resizeStrategy));
+  if (config_.allocSizeHistogramEnabled()) {
+    allocSizeHistograms_[pid] = std::make_unique<AllocSizeHistogram>(
+        config_.allocSizeHistogramSampleRate);
+  }
+  initValueCompressor(pid);
 
   return pid;
 }
 
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::initValueCompressor(PoolId pid) {
+  const auto it =
+      config_.valueCompressionConfigs.find(allocator_[0]->getPoolName(pid));
+  if (it != config_.valueCompressionConfigs.end()) {
+    valueCompressors_[pid] = std::make_unique<ValueCompressor>(it->second);
+  }
+}
+
+template <typename CacheTrait>
+ValueCompressionStats CacheAllocator<CacheTrait>::getValueCompressionStats(
+    PoolId pid) const {
+  if (static_cast<size_t>(pid) >= mmContainers_[0].size()) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid PoolId: {}, size of pools: {}", pid, mmContainers_[0].size()));
+  }
+  return valueCompressors_[pid] ? valueCompressors_[pid]->getStats()
+                                : ValueCompressionStats{};
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::shrinkPool(PoolId pid, size_t bytes) {
+  const auto tierSizes = getTierSizes(bytes);
+  for (TierId tid = 0; tid < numTiers_; tid++) {
+    if (!allocator_[tid]->shrinkPool(pid, tierSizes[tid])) {
+      // give back what we took from the tiers above so that the pool keeps
+      // the same ratio across the tiers.
+      while (tid-- > 0) {
+        allocator_[tid]->growPool(pid, tierSizes[tid]);
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::growPool(PoolId pid, size_t bytes) {
+  const auto tierSizes = getTierSizes(bytes);
+  for (TierId tid = 0; tid < numTiers_; tid++) {
+    if (!allocator_[tid]->growPool(pid, tierSizes[tid])) {
+      while (tid-- > 0) {
+        allocator_[tid]->shrinkPool(pid, tierSizes[tid]);
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::resizePools(PoolId src,
+                                             PoolId dest,
+                                             size_t bytes) {
+  const auto tierSizes = getTierSizes(bytes);
+  for (TierId tid = 0; tid < numTiers_; tid++) {
+    if (!allocator_[tid]->resizePools(src, dest, tierSizes[tid])) {
+      while (tid-- > 0) {
+        allocator_[tid]->resizePools(dest, src, tierSizes[tid]);
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
 template <typename CacheTrait>
 void CacheAllocator<CacheTrait>::overridePoolRebalanceStrategy(
     PoolId pid, std::shared_ptr<RebalanceStrategy> rebalanceStrategy) {
@@ -2344,6 +2845,68 @@ void CacheAllocator<CacheTrait>::overridePoolConfig(TierId tid, PoolId pid,
   }
 }
 
+template <typename CacheTrait>
+const AllocSizeHistogram& CacheAllocator<CacheTrait>::getAllocSizeHistogram(
+    PoolId pid) const {
+  if (static_cast<size_t>(pid) >= mmContainers_[0].size()) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid PoolId: {}, size of pools: {}", pid, mmContainers_[0].size()));
+  }
+  if (!allocSizeHistograms_[pid]) {
+    throw std::invalid_argument(folly::sformat(
+        "No alloc size histogram for pool {}. Histograms are not enabled.",
+        pid));
+  }
+  return *allocSizeHistograms_[pid];
+}
+
+template <typename CacheTrait>
+std::set<uint32_t> CacheAllocator<CacheTrait>::proposeAllocSizes(
+    PoolId pid, unsigned int numClasses) const {
+  return getAllocSizeHistogram(pid).proposeAllocSizes(numClasses);
+}
+
+template <typename CacheTrait>
+double CacheAllocator<CacheTrait>::getAllocSizeWastedFraction(
+    PoolId pid) const {
+  const auto& histogram = getAllocSizeHistogram(pid);
+  const auto allocSizes = allocator_[0]->getPool(pid).getAllocSizes();
+  return histogram.getWastedFraction(
+      std::set<uint32_t>(allocSizes.begin(), allocSizes.end()));
+}
+
+template <typename CacheTrait>
+std::vector<ClassId> CacheAllocator<CacheTrait>::addAllocationClasses(
+    PoolId pid, const std::set<uint32_t>& allocSizes) {
+  if (static_cast<size_t>(pid) >= mmContainers_[0].size()) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid PoolId: {}, size of pools: {}", pid, mmContainers_[0].size()));
+  }
+
+  folly::SharedMutex::WriteHolder w(poolsResizeAndRebalanceLock_);
+
+  // the pools validate the sizes and pick the class ids. The MMContainers of
+  // a tier must exist before the first allocation can land in its new
+  // classes, so they are created right before the pool of the tier publishes
+  // them. The pools of every tier have the same classes, so only the first
+  // one can reject the sizes.
+  const auto baseConfig = mmContainers_[0][pid][0]->getConfig();
+  std::vector<ClassId> cids;
+  for (TierId tid = 0; tid < numTiers_; tid++) {
+    auto res = allocator_[tid]->addAllocationClasses(
+        pid, allocSizes, [&](const AllocationClass& ac) {
+          auto config = baseConfig;
+          config.addExtraConfig(
+              config_.trackTailHits ? ac.getAllocsPerSlab() : 0);
+          mmContainers_[tid][pid][ac.getId()].reset(
+              new MMContainer(config, compressor_));
+        });
+    XDCHECK(tid == 0 || res == cids);
+    cids = std::move(res);
+  }
+  return cids;
+}
+
 template <typename CacheTrait>
 void CacheAllocator<CacheTrait>::createMMContainers(const PoolId pid,
                                                     MMConfig config) {
@@ -2432,14 +2995,25 @@ std::set<PoolId> CacheAllocator<CacheTrait>::getCCachePoolIds() const {
 template <typename CacheTrait>
 std::set<PoolId> CacheAllocator<CacheTrait>::getRegularPoolIdsForResize()
     const {
+  std::set<PoolId> ret;
+  for (TierId tid = 0; tid < numTiers_; tid++) {
+    auto tierPools = getRegularPoolIdsForResize(tid);
+    ret.insert(tierPools.begin(), tierPools.end());
+  }
+  return ret;
+}
+
+template <typename CacheTrait>
+std::set<PoolId> CacheAllocator<CacheTrait>::getRegularPoolIdsForResize(
+    TierId tid) const {
   folly::SharedMutex::ReadHolder r(poolsResizeAndRebalanceLock_);
   // If Slabs are getting advised away - as indicated by non-zero
   // getAdvisedMemorySize - then pools may be overLimit even when
   // all slabs are not allocated. Otherwise, pools may be overLimit
   // only after all slabs are allocated.
-  return (allocator_[currentTier()]->allSlabsAllocated()) ||
-                 (allocator_[currentTier()]->getAdvisedMemorySize() != 0)
-             ? filterCompactCachePools(allocator_[currentTier()]->getPoolsOverLimit())
+  return (allocator_[tid]->allSlabsAllocated()) ||
+                 (allocator_[tid]->getAdvisedMemorySize() != 0)
+             ? filterCompactCachePools(allocator_[tid]->getPoolsOverLimit())
              : std::set<PoolId>{};
 }
 
@@ -2460,9 +3034,24 @@ size_t CacheAllocator<CacheTrait>::getPoolSize(PoolId poolId) const {
 
 template <typename CacheTrait>
 PoolStats CacheAllocator<CacheTrait>::getPoolStats(PoolId poolId) const {
-  const auto& pool = allocator_[currentTier()]->getPool(poolId);
-  const auto& allocSizes = pool.getAllocSizes();
+  auto ret = getPoolStats(0, poolId);
+  for (TierId tid = 1; tid < numTiers_; tid++) {
+    const auto tierStats = getPoolStats(tid, poolId);
+    ret += tierStats;
+    ret.poolSize += tierStats.poolSize;
+    ret.poolUsableSize += tierStats.poolUsableSize;
+    ret.poolAdvisedSize += tierStats.poolAdvisedSize;
+  }
+  return ret;
+}
+
+template <typename CacheTrait>
+PoolStats CacheAllocator<CacheTrait>::getPoolStats(TierId tid,
+                                                   PoolId poolId) const {
+  const auto& pool = allocator_[tid]->getPool(poolId);
   auto mpStats = pool.getStats();
+  // fetched after the stats so that it covers any class added in between.
+  const auto allocSizes = pool.getAllocSizes();
   const auto& classIds = mpStats.classIds;
 
   // check if this is a compact cache.
@@ -2478,15 +3067,15 @@ PoolStats CacheAllocator<CacheTrait>::getPoolStats(PoolId poolId) const {
   // TODO export evictions, numItems etc from compact cache directly.
   if (!isCompactCache) {
     for (const ClassId cid : classIds) {
-      const auto& container = getMMContainer(currentTier(), poolId, cid);
-      uint64_t classHits = (*stats_.cacheHits)[poolId][cid].get();
+      const auto& container = getMMContainer(tid, poolId, cid);
+      uint64_t classHits = (*stats_.cacheHits)[tid][poolId][cid].get();
       cacheStats.insert(
           {cid,
-           {allocSizes[cid], (*stats_.allocAttempts)[poolId][cid].get(),
-            (*stats_.allocFailures)[poolId][cid].get(),
-            (*stats_.fragmentationSize)[poolId][cid].get(), classHits,
-            (*stats_.chainedItemEvictions)[poolId][cid].get(),
-            (*stats_.regularItemEvictions)[poolId][cid].get(),
+           {allocSizes[cid], (*stats_.allocAttempts)[tid][poolId][cid].get(),
+            (*stats_.allocFailures)[tid][poolId][cid].get(),
+            (*stats_.fragmentationSize)[tid][poolId][cid].get(), classHits,
+            (*stats_.chainedItemEvictions)[tid][poolId][cid].get(),
+            (*stats_.regularItemEvictions)[tid][poolId][cid].get(),
             container.getStats()}});
       totalHits += classHits;
     }
@@ -2494,7 +3083,7 @@ PoolStats CacheAllocator<CacheTrait>::getPoolStats(PoolId poolId) const {
 
   PoolStats ret;
   ret.isCompactCache = isCompactCache;
-  ret.poolName = allocator_[currentTier()]->getPoolName(poolId);
+  ret.poolName = allocator_[tid]->getPoolName(poolId);
   ret.poolSize = pool.getPoolSize();
   ret.poolUsableSize = pool.getPoolUsableSize();
   ret.poolAdvisedSize = pool.getPoolAdvisedSize();
@@ -2509,13 +3098,19 @@ PoolStats CacheAllocator<CacheTrait>::getPoolStats(PoolId poolId) const {
 template <typename CacheTrait>
 PoolEvictionAgeStats CacheAllocator<CacheTrait>::getPoolEvictionAgeStats(
     PoolId pid, unsigned int slabProjectionLength) const {
+  return getPoolEvictionAgeStats(0, pid, slabProjectionLength);
+}
+
+template <typename CacheTrait>
+PoolEvictionAgeStats CacheAllocator<CacheTrait>::getPoolEvictionAgeStats(
+    TierId tid, PoolId pid, unsigned int slabProjectionLength) const {
   PoolEvictionAgeStats stats;
-  const auto& pool = allocator_[currentTier()]->getPool(pid);
+  const auto& pool = allocator_[tid]->getPool(pid);
   const auto& allocSizes = pool.getAllocSizes();
   for (ClassId cid = 0; cid < static_cast<ClassId>(allocSizes.size()); ++cid) {
-    auto& mmContainer = getMMContainer(currentTier(), pid, cid);
+    auto& mmContainer = getMMContainer(tid, pid, cid);
     const auto numItemsPerSlab =
-        allocator_[currentTier()]->getPool(pid).getAllocationClass(cid).getAllocsPerSlab();
+        pool.getAllocationClass(cid).getAllocsPerSlab();
     const auto projectionLength = numItemsPerSlab * slabProjectionLength;
     stats.classEvictionAgeStats[cid] =
         mmContainer.getEvictionAgeStat(projectionLength);
@@ -2543,7 +3138,18 @@ void CacheAllocator<CacheTrait>::releaseSlab(PoolId pid,
                                              ClassId receiver,
                                              SlabReleaseMode mode,
                                              const void* hint) {
+  releaseSlab(0, pid, victim, receiver, mode, hint);
+}
+
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::releaseSlab(TierId tid,
+                                             PoolId pid,
+                                             ClassId victim,
+                                             ClassId receiver,
+                                             SlabReleaseMode mode,
+                                             const void* hint) {
   stats_.numActiveSlabReleases.inc();
+  stats_.numSlabReleases[tid].inc();
   SCOPE_EXIT { stats_.numActiveSlabReleases.dec(); };
   switch (mode) {
   case SlabReleaseMode::kRebalance:
@@ -2558,7 +3164,7 @@ void CacheAllocator<CacheTrait>::releaseSlab(PoolId pid,
   }
 
   try {
-    auto releaseContext = allocator_[currentTier()]->startSlabRelease(
+    auto releaseContext = allocator_[tid]->startSlabRelease(
         pid, victim, receiver, mode, hint,
         [this]() -> bool { return shutDownInProgress_; });
 
@@ -2567,21 +3173,22 @@ void CacheAllocator<CacheTrait>::releaseSlab(PoolId pid,
       return;
     }
 
-    releaseSlabImpl(currentTier(), releaseContext);
-    if (!allocator_[currentTier()]->allAllocsFreed(releaseContext)) {
+    releaseSlabImpl(tid, releaseContext);
+    if (!allocator_[tid]->allAllocsFreed(releaseContext)) {
       throw std::runtime_error(
           folly::sformat("Was not able to free all allocs. PoolId: {}, AC: {}",
                          releaseContext.getPoolId(),
                          releaseContext.getClassId()));
     }
 
-    allocator_[currentTier()]->completeSlabRelease(releaseContext);
+    allocator_[tid]->completeSlabRelease(releaseContext);
   } catch (const exception::SlabReleaseAborted& e) {
     stats_.numAbortedSlabReleases.inc();
     throw exception::SlabReleaseAborted(folly::sformat(
         "Slab release aborted while releasing "
-        "a slab in pool {} victim {} receiver {}. Original ex msg: ",
-        pid, static_cast<int>(victim), static_cast<int>(receiver), e.what()));
+        "a slab in tier {} pool {} victim {} receiver {}. Original ex msg: {}",
+        static_cast<int>(tid), pid, static_cast<int>(victim),
+        static_cast<int>(receiver), e.what()));
   }
 }
 
@@ -2717,7 +3324,7 @@ bool CacheAllocator<CacheTrait>::moveForSlabRelease(
   const auto allocInfo = allocator_[tid]->getAllocInfo(oldItem.getMemory());
   allocator_[tid]->free(&oldItem);
 
-  (*stats_.fragmentationSize)[allocInfo.poolId][allocInfo.classId].sub(
+  (*stats_.fragmentationSize)[tid][allocInfo.poolId][allocInfo.classId].sub(
       util::getFragmentation(*this, oldItem));
   stats_.numMoveSuccesses.inc();
   return true;
@@ -2866,13 +3473,14 @@ void CacheAllocator<CacheTrait>::evictForSlabRelease(
     // we managed to evict the corresponding owner of the item and have the
     // last handle for the owner.
     if (owningHandle) {
+      const auto tid = getTierId(item);
       const auto allocInfo =
-          allocator_[getTierId(item)]->getAllocInfo(static_cast<const void*>(&item));
+          allocator_[tid]->getAllocInfo(static_cast<const void*>(&item));
       if (owningHandle->hasChainedItem()) {
-        (*stats_.chainedItemEvictions)[allocInfo.poolId][allocInfo.classId]
+        (*stats_.chainedItemEvictions)[tid][allocInfo.poolId][allocInfo.classId]
             .inc();
       } else {
-        (*stats_.regularItemEvictions)[allocInfo.poolId][allocInfo.classId]
+        (*stats_.regularItemEvictions)[tid][allocInfo.poolId][allocInfo.classId]
             .inc();
       }
 
@@ -3252,10 +3860,13 @@ folly::IOBufQueue CacheAllocator<CacheTrait>::saveStateToIOBuf() {
   {
     folly::SharedMutex::ReadHolder lock(compactCachePoolsLock_);
     for (PoolId pid : pools) {
-      for (unsigned int cid = 0; cid < (*stats_.fragmentationSize)[pid].size();
+      // the metadata only has room for one tier; we persist the top tier's
+      // fragmentation and the lower tiers start counting from zero.
+      for (unsigned int cid = 0;
+           cid < (*stats_.fragmentationSize)[0][pid].size();
            ++cid) {
         metadata_.fragmentationSize_ref()[pid][static_cast<ClassId>(cid)] =
-            (*stats_.fragmentationSize)[pid][cid].get();
+            (*stats_.fragmentationSize)[0][pid][cid].get();
       }
       if (isCompactCachePool_[pid]) {
         metadata_.compactCachePools_ref()->push_back(pid);
@@ -3311,6 +3922,9 @@ bool CacheAllocator<CacheTrait>::stopWorkers(std::chrono::seconds timeout) {
   success &= stopPoolResizer(timeout);
   success &= stopMemMonitor(timeout);
   success &= stopReaper(timeout);
+  success &= stopBackgroundEvictor(timeout);
+  success &= stopMemoryTierPromoter(timeout);
+  success &= stopSlabCompactor(timeout);
   return success;
 }
 
@@ -3519,7 +4133,7 @@ void CacheAllocator<CacheTrait>::initStats() {
   // deserialize the fragmentation size of each thread.
   for (const auto& pid : *metadata_.fragmentationSize_ref()) {
     for (const auto& cid : pid.second) {
-      (*stats_.fragmentationSize)[pid.first][cid.first].set(
+      (*stats_.fragmentationSize)[0][pid.first][cid.first].set(
           static_cast<uint64_t>(cid.second));
     }
   }
@@ -3591,6 +4205,13 @@ GlobalCacheStats CacheAllocator<CacheTrait>::getGlobalCacheStats() const {
   ret.nvmCacheEnabled = nvmCache_ ? nvmCache_->isEnabled() : false;
   ret.nvmUpTime = currTime - getNVMCacheCreationTime();
   ret.reaperStats = getReaperStats();
+  ret.backgroundEvictorStats = getBackgroundEvictorStats();
+  ret.slabCompactorStats = getSlabCompactorStats();
+  for (const auto& compressor : valueCompressors_) {
+    if (compressor) {
+      ret.valueCompressionStats += compressor->getStats();
+    }
+  }
   ret.numActiveHandles = getNumActiveHandles();
 
   return ret;
@@ -3603,9 +4224,14 @@ CacheMemoryStats CacheAllocator<CacheTrait>::getCacheMemoryStats() const {
     totalCacheSize += allocator->getMemorySize();
   }
 
-  auto addSize = [this](size_t a, PoolId pid) {
-    return a + allocator_[currentTier()]->getPool(pid).getPoolSize();
-  };
+  size_t advisedSize = 0;
+  size_t unreservedSize = 0;
+  for (const auto& allocator : allocator_) {
+    advisedSize += allocator->getAdvisedMemorySize();
+    unreservedSize += allocator->getUnreservedMemorySize();
+  }
+
+  auto addSize = [this](size_t a, PoolId pid) { return a + getPoolSize(pid); };
   const auto regularPoolIds = getRegularPoolIds();
   const auto ccCachePoolIds = getCCachePoolIds();
   size_t regularCacheSize = std::accumulate(
@@ -3616,14 +4242,27 @@ CacheMemoryStats CacheAllocator<CacheTrait>::getCacheMemoryStats() const {
   return CacheMemoryStats{totalCacheSize,
                           regularCacheSize,
                           compactCacheSize,
-                          allocator_[currentTier()]->getAdvisedMemorySize(),
+                          advisedSize,
                           memMonitor_ ? memMonitor_->getMaxAdvisePct() : 0,
-                          allocator_[currentTier()]->getUnreservedMemorySize(),
+                          unreservedSize,
                           nvmCache_ ? nvmCache_->getSize() : 0,
                           util::getMemAvailable(),
                           util::getRSSBytes()};
 }
 
+template <typename CacheTrait>
+size_t CacheAllocator<CacheTrait>::getHugePageBackedSize() const {
+  std::vector<folly::ByteRange> ranges;
+  for (TierId tid = 0; tid < getNumTiers(); tid++) {
+    if (memoryTierConfigs[tid].getHugePagePolicy(config_.hugePagePolicy) !=
+        util::HugePagePolicy::kNone) {
+      ranges.push_back(allocator_[tid]->getSlabMemoryRange());
+    }
+  }
+  const auto backed = util::getHugePageBackedBytes(ranges);
+  return std::accumulate(backed.begin(), backed.end(), size_t{0});
+}
+
 template <typename CacheTrait>
 bool CacheAllocator<CacheTrait>::autoResizeEnabledForPool(PoolId pid) const {
   folly::SharedMutex::ReadHolder lock(compactCachePoolsLock_);
@@ -3726,6 +4365,43 @@ bool CacheAllocator<CacheTrait>::startNewReaper(
   return startNewWorker("Reaper", reaper_, interval, reaperThrottleConfig);
 }
 
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::startNewBackgroundEvictor(
+    std::chrono::milliseconds interval,
+    unsigned int freeAllocsPercent,
+    unsigned int maxEvictionBatch) {
+  return startNewWorker("BackgroundEvictor", backgroundEvictor_, interval,
+                        freeAllocsPercent, maxEvictionBatch);
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::startNewMemoryTierPromoter(
+    std::chrono::milliseconds interval,
+    uint32_t hitsToPromote,
+    uint32_t maxPromotionsPerRun) {
+  if (!promotionCandidates_) {
+    throw std::invalid_argument(
+        "Memory tier promotion is not enabled. It needs more than one memory "
+        "tier and enableMemoryTierPromotion() in the cache config.");
+  }
+  return startNewWorker("MemoryTierPromoter", memoryTierPromoter_, interval,
+                        hitsToPromote, maxPromotionsPerRun);
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::startNewSlabCompactor(
+    std::chrono::milliseconds interval,
+    unsigned int slabsPerIteration,
+    unsigned int minFreePercent) {
+  if (!config_.moveCb) {
+    throw std::invalid_argument(
+        "Slab compaction requires moving on slab release to be enabled. "
+        "Otherwise the items of the compacted slabs would be evicted.");
+  }
+  return startNewWorker("SlabCompactor", slabCompactor_, interval,
+                        slabsPerIteration, minFreePercent);
+}
+
 template <typename CacheTrait>
 bool CacheAllocator<CacheTrait>::stopPoolRebalancer(
     std::chrono::seconds timeout) {
@@ -3753,6 +4429,63 @@ bool CacheAllocator<CacheTrait>::stopReaper(std::chrono::seconds timeout) {
   return stopWorker("Reaper", reaper_, timeout);
 }
 
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::stopBackgroundEvictor(
+    std::chrono::seconds timeout) {
+  return stopWorker("BackgroundEvictor", backgroundEvictor_, timeout);
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::stopMemoryTierPromoter(
+    std::chrono::seconds timeout) {
+  return stopWorker("MemoryTierPromoter", memoryTierPromoter_, timeout);
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::stopSlabCompactor(
+    std::chrono::seconds timeout) {
+  return stopWorker("SlabCompactor", slabCompactor_, timeout);
+}
+
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::resizeAccessContainer(
+    unsigned int bucketsPower) {
+  if (!shmManager_) {
+    accessContainer_->startResize(bucketsPower);
+    return;
+  }
+
+  // the buckets of every generation live in their own segment, which is
+  // removed once a resize replaced them and no reader is left.
+  accessContainer_->startResize(
+      bucketsPower,
+      [this](uint32_t generation, size_t nBytes) {
+        return shmManager_
+            ->createShm(getAccessContainerShmName(generation), nBytes, nullptr,
+                        ShmSegmentOpts(config_.accessConfig.getPageSize(),
+                                       false, config_.isUsingPosixShm()))
+            .addr;
+      },
+      [this](uint32_t generation) { removeAccessContainerShm(generation); });
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::rehashAccessContainer(size_t numBuckets) {
+  if (!shmManager_) {
+    return accessContainer_->rehashStep(numBuckets);
+  }
+  return accessContainer_->rehashStep(
+      numBuckets,
+      [this](uint32_t generation) { removeAccessContainerShm(generation); });
+}
+
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::removeAccessContainerShm(
+    uint32_t generation) {
+  shmManager_->removeShm(getAccessContainerShmName(generation),
+                         PosixSysVSegmentOpts(config_.isUsingPosixShm()));
+}
+
 template <typename CacheTrait>
 bool CacheAllocator<CacheTrait>::cleanupStrayShmSegments(
   const std::string& cacheDir, bool posix /*TODO(SHM_FILE): const std::vector<CacheMemoryTierConfig>& config */) {
@@ -3774,7 +4507,11 @@ bool CacheAllocator<CacheTrait>::cleanupStrayShmSegments(
     ShmManager::removeByName(cacheDir, detail::kShmInfoName, posix);
     ShmManager::removeByName(cacheDir, detail::kShmCacheName
                              + std::to_string(0), posix);
-    ShmManager::removeByName(cacheDir, detail::kShmHashTableName, posix);
+    for (uint32_t generation = 0;
+         generation <= detail::kShmHashTableMaxGeneration; ++generation) {
+      ShmManager::removeByName(
+          cacheDir, detail::getShmHashTableName(generation), posix);
+    }
     ShmManager::removeByName(cacheDir, detail::kShmChainedItemHashTableName,
                              posix);
 
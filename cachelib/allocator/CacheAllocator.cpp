@@ -22,5 +22,8 @@ template class CacheAllocator<LruCacheTrait>;
 template class CacheAllocator<LruCacheWithSpinBucketsTrait>;
 template class CacheAllocator<Lru2QCacheTrait>;
 template class CacheAllocator<TinyLFUCacheTrait>;
+template class CacheAllocator<ClockCacheTrait>;
+template class CacheAllocator<LruCacheWithTagHashTableTrait>;
+template class CacheAllocator<LruCacheWithCompactItemTrait>;
 } // namespace cachelib
 } // namespace facebook
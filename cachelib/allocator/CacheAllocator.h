@@ -18,12 +18,19 @@
 
 #include <folly/CPortability.h>
 #include <folly/Likely.h>
+#include <folly/MPMCQueue.h>
+#include <folly/Portability.h>
 #include <folly/ScopeGuard.h>
 #include <folly/logging/xlog.h>
 #include <folly/synchronization/SanitizeThread.h>
 #include <folly/hash/Hash.h>
 #include <folly/container/F14Map.h>
+#include <folly/experimental/coro/Coroutine.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Task.h>
+#endif
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -37,6 +44,8 @@
 #include <folly/Range.h>
 #pragma GCC diagnostic pop
 
+#include "cachelib/allocator/AllocSizeHistogram.h"
+#include "cachelib/allocator/BackgroundEvictor.h"
 #include "cachelib/allocator/CCacheManager.h"
 #include "cachelib/allocator/Cache.h"
 #include "cachelib/allocator/CacheAllocatorConfig.h"
@@ -50,6 +59,8 @@
 #include "cachelib/allocator/ICompactCache.h"
 #include "cachelib/allocator/KAllocation.h"
 #include "cachelib/allocator/MemoryMonitor.h"
+#include "cachelib/allocator/MemoryTierAdmissionPolicy.h"
+#include "cachelib/allocator/MemoryTierPromoter.h"
 #include "cachelib/allocator/NvmAdmissionPolicy.h"
 #include "cachelib/allocator/NvmCacheState.h"
 #include "cachelib/allocator/PoolOptimizeStrategy.h"
@@ -58,12 +69,14 @@
 #include "cachelib/allocator/PoolResizer.h"
 #include "cachelib/allocator/ReadOnlySharedCacheView.h"
 #include "cachelib/allocator/Reaper.h"
+#include "cachelib/allocator/SlabCompactor.h"
 #include "cachelib/allocator/RebalanceStrategy.h"
 #include "cachelib/allocator/Refcount.h"
 #include "cachelib/allocator/TempShmMapping.h"
 #include "cachelib/allocator/TlsActiveItemRing.h"
 #include "cachelib/allocator/TypedHandle.h"
 #include "cachelib/allocator/Util.h"
+#include "cachelib/allocator/ValueCompressor.h"
 #include "cachelib/allocator/memory/MemoryAllocator.h"
 #include "cachelib/allocator/memory/MemoryAllocatorStats.h"
 #include "cachelib/allocator/memory/serialize/gen-cpp2/objects_types.h"
@@ -102,6 +115,9 @@ class AllocatorHitStatsTest;
 template <typename AllocatorT>
 class AllocatorResizeTest;
 
+template <typename AllocatorT>
+class AllocatorMemoryTiersTest;
+
 class NvmCacheTest;
 
 template <typename AllocatorT>
@@ -137,7 +153,8 @@ class PersistenceCache;
 // Similar to the MMType, the AccessType is an intrusive data type that
 // provides a container to access the keyed allocations. AccessType must
 // provide an AccessType::Hook and AccessType::Container with
-// find/insert/remove interface similar to a hash table.
+// find/insert/remove interface similar to a hash table, and an
+// AccessType::makeConfig that sizes the container for a number of entries.
 //
 template <typename CacheTrait>
 class CacheAllocator : public CacheBase {
@@ -328,13 +345,38 @@ class CacheAllocator : public CacheBase {
   //              and can not find an eviction.
   // @throw   std::invalid_argument if the poolId is invalid or the size
   //          requested is invalid or if the key is invalid(key.size() == 0 or
-  //          key.size() > 255)
+  //          key.size() > 255) or if ttlSecs is set for items that do not
+  //          support expiry (see ItemTimes.h)
   ItemHandle allocate(PoolId id,
                       Key key,
                       uint32_t size,
                       uint32_t ttlSecs = 0,
                       uint32_t creationTime = 0);
 
+  // Allocate an item for a value and copy the value into it. If the pool
+  // has value compression enabled (see
+  // CacheAllocatorConfig::enableValueCompression), the value is stored
+  // compressed when it compresses well enough. The item then takes a
+  // smaller allocation class, and convertToIOBuf uncompresses it.
+  //
+  // The payload of a compressed item must not be read or written through
+  // getMemory, and it can not have chained items.
+  //
+  // @param id              the pool id for the allocation
+  // @param key             the key for the allocation
+  // @param value           the value of the item
+  // @param ttlSecs         Time To Live(second) for the item,
+  //                        default with 0 means no expiration time.
+  //
+  // @return      the handle for the item or an invalid handle(nullptr) if the
+  //              allocation failed.
+  // @throw   std::invalid_argument for the same reasons as allocate()
+  WriteHandle allocateCompressed(PoolId id,
+                                 Key key,
+                                 folly::ByteRange value,
+                                 uint32_t ttlSecs = 0,
+                                 uint32_t creationTime = 0);
+
   // Allocate a chained item
   //
   // The resulting chained item does not have a parent item and
@@ -478,6 +520,37 @@ class CacheAllocator : public CacheBase {
   //              key does not exist.
   ItemHandle findToWrite(Key key, bool doNvmInvalidation = true);
 
+  // look up a batch of keys across the nvm cache as well if enabled. This is
+  // equivalent to calling find() for every key, but the RAM lookups for the
+  // whole batch are issued together so that their cache misses overlap, and
+  // each hash table lock stripe is taken once per batch.
+  //
+  // @param keys      the keys for lookup
+  //
+  // @return          a vector of read handles where the i-th handle
+  //                  corresponds to keys[i]. A handle is nullptr if the key
+  //                  does not exist.
+  std::vector<ReadHandle> findBatch(folly::Range<const Key*> keys);
+
+#if FOLLY_HAS_COROUTINES
+  // Coroutine versions of find, findToWrite and insertOrReplace. A lookup
+  // that goes to the nvm cache suspends the awaiting coroutine until the
+  // item is read, instead of blocking the thread in wait() or allocating a
+  // promise through toSemiFuture(). The coroutine is resumed on the executor
+  // of the task.
+  //
+  // The operation is issued when these are called, not when the task is
+  // awaited, so the key only needs to outlive the call and several lookups
+  // can be issued before awaiting any of them.
+  //
+  // See find, findToWrite and insertOrReplace for the parameters and the
+  // exceptions.
+  folly::coro::Task<ReadHandle> co_find(Key key);
+  folly::coro::Task<ItemHandle> co_findToWrite(Key key,
+                                               bool doNvmInvalidation = true);
+  folly::coro::Task<ItemHandle> co_insertOrReplace(const ItemHandle& handle);
+#endif
+
   // look up an item by its key. This ignores the nvm cache and only does RAM
   // lookup.
   //
@@ -628,10 +701,14 @@ class CacheAllocator : public CacheBase {
   //
   // @param handle    read handle that will transfer its ownership to an IOBuf
   //
+  // The value of an item compressed by allocateCompressed is uncompressed
+  // into a buffer owned by the returned IOBuf, and the handle is released.
+  //
   // @return   an IOBuf that contains the value of the item.
   //           This IOBuf acts as a Read Handle, on destruction, it will
   //           properly decrement the refcount (to release the item).
-  // @throw   std::invalid_argument if ReadHandle is nullptr
+  // @throw   std::invalid_argument if ReadHandle is nullptr, or if the item
+  //          is compressed and its pool has no value compression.
   folly::IOBuf convertToIOBuf(ReadHandle handle) {
     return convertToIOBufT<ReadHandle>(handle);
   }
@@ -645,10 +722,15 @@ class CacheAllocator : public CacheBase {
   //
   // @param handle    write handle that will transfer its ownership to an IOBuf
   //
+  // The value of an item compressed by allocateCompressed is uncompressed
+  // into a buffer owned by the returned IOBuf, so writes to it do not change
+  // the item.
+  //
   // @return   an IOBuf that contains the value of the item.
   //           This IOBuf acts as a Write Handle, on destruction, it will
   //           properly decrement the refcount (to release the item).
-  // @throw   std::invalid_argument if WriteHandle is nullptr
+  // @throw   std::invalid_argument if WriteHandle is nullptr, or if the item
+  //          is compressed and its pool has no value compression.
   folly::IOBuf convertToIOBufForWrite(WriteHandle handle) {
     return convertToIOBufT<WriteHandle>(handle);
   }
@@ -703,6 +785,47 @@ class CacheAllocator : public CacheBase {
   // @throw std::invalid_argument if the poolId is invalid
   void overridePoolConfig(TierId tid, PoolId pid, const MMConfig& config);
 
+  // propose allocation class sizes for a pool from the sizes allocated from
+  // it so far. Requires enableAllocSizeHistogram in the config.
+  //
+  // @param pid         the pool
+  // @param numClasses  the maximum number of class sizes to propose
+  //
+  // @return  the class sizes that waste the least memory for the sizes
+  //          allocated so far. empty if nothing was allocated yet.
+  // @throw std::invalid_argument if the poolId is invalid, the histograms
+  //        are not enabled or numClasses is invalid.
+  std::set<uint32_t> proposeAllocSizes(PoolId pid,
+                                       unsigned int numClasses) const;
+
+  // @return  the fraction of the memory used by the sizes allocated from the
+  //          pool so far that its current allocation classes waste.
+  //          Requires enableAllocSizeHistogram in the config.
+  // @throw std::invalid_argument if the poolId is invalid or the histograms
+  //        are not enabled.
+  double getAllocSizeWastedFraction(PoolId pid) const;
+
+  // @return  the stats of the compression of the values of the pool. Empty if
+  //          the pool has no value compression.
+  // @throw std::invalid_argument if the poolId is invalid
+  ValueCompressionStats getValueCompressionStats(PoolId pid) const;
+
+  // add allocation classes to an existing pool, typically the ones returned
+  // by proposeAllocSizes. The existing classes are kept, and the new ones
+  // start without slabs. Allocations that fit better in a new class go to it
+  // right away and it gets its slabs from the free memory of the pool or
+  // from the other classes through the pool rebalancer.
+  //
+  // @param pid         the pool
+  // @param allocSizes  the class sizes. Sizes the pool already has are
+  //                    ignored.
+  //
+  // @return  the class ids of the classes that were added
+  // @throw std::invalid_argument if the poolId or any size is invalid, or
+  //        the pool would have too many classes.
+  std::vector<ClassId> addAllocationClasses(
+      PoolId pid, const std::set<uint32_t>& allocSizes);
+
   // update an existing pool's rebalance strategy
   //
   // @param pid                 pool id for the pool to be updated
@@ -737,15 +860,16 @@ class CacheAllocator : public CacheBase {
    * exhausted and there is some pool that is over the limit
    */
 
+  // Like addPool(), the sizes passed to the following apis are for the pool
+  // across all the memory tiers and are split between the tiers in the ratio
+  // of their sizes.
+
   // shrink the existing pool by _bytes_ .
   // @param bytes  the number of bytes to be taken away from the pool
   // @return  true if the operation succeeded. false if the size of the pool is
   //          smaller than _bytes_
   // @throw   std::invalid_argument if the poolId is invalid.
-  // TODO: should call shrinkPool for specific tier?
-  bool shrinkPool(PoolId pid, size_t bytes) {
-    return allocator_[currentTier()]->shrinkPool(pid, bytes);
-  }
+  bool shrinkPool(PoolId pid, size_t bytes);
 
   // grow an existing pool by _bytes_. This will fail if there is no
   // available memory across all the pools to provide for this pool
@@ -753,10 +877,7 @@ class CacheAllocator : public CacheBase {
   // @return    true if the pool was grown. false if the necessary number of
   //            bytes were not available.
   // @throw     std::invalid_argument if the poolId is invalid.
-  // TODO: should call growPool for specific tier?
-  bool growPool(PoolId pid, size_t bytes) {
-    return allocator_[currentTier()]->growPool(pid, bytes);
-  }
+  bool growPool(PoolId pid, size_t bytes);
 
   // move bytes from one pool to another. The source pool should be at least
   // _bytes_ in size.
@@ -767,9 +888,7 @@ class CacheAllocator : public CacheBase {
   // @param   true if the resize succeeded. false if src does does not have
   //          correct size to do the transfer.
   // @throw   std::invalid_argument if src or dest is invalid pool
-  bool resizePools(PoolId src, PoolId dest, size_t bytes) override {
-    return allocator_[currentTier()]->resizePools(src, dest, bytes);
-  }
+  bool resizePools(PoolId src, PoolId dest, size_t bytes) override;
 
   // Add a new compact cache with given name and size
   //
@@ -946,6 +1065,37 @@ class CacheAllocator : public CacheBase {
   bool startNewReaper(std::chrono::milliseconds interval,
                       util::Throttler::Config reaperThrottleConfig);
 
+  // start background evictor
+  // @param interval            the period this worker fires
+  // @param freeAllocsPercent   percentage of each class to keep free
+  // @param maxEvictionBatch    max items evicted from a class in one run
+  bool startNewBackgroundEvictor(std::chrono::milliseconds interval,
+                                 unsigned int freeAllocsPercent,
+                                 unsigned int maxEvictionBatch);
+
+  // start memory tier promoter
+  // @param interval              the period this worker fires
+  // @param hitsToPromote         hits needed before an item is promoted
+  // @param maxPromotionsPerRun   max number of items promoted in one run
+  //
+  // @throw std::invalid_argument if promotion between memory tiers was not
+  //        enabled in the config
+  bool startNewMemoryTierPromoter(std::chrono::milliseconds interval,
+                                  uint32_t hitsToPromote,
+                                  uint32_t maxPromotionsPerRun);
+
+  // start slab compactor
+  // @param interval            the period this worker fires
+  // @param slabsPerIteration   max number of slabs compacted in one run
+  // @param minFreePercent      percentage of a slab's allocations that must
+  //                            be free for it to be compacted
+  //
+  // @throw std::invalid_argument if moving on slab release was not enabled in
+  //        the config
+  bool startNewSlabCompactor(std::chrono::milliseconds interval,
+                             unsigned int slabsPerIteration,
+                             unsigned int minFreePercent);
+
   // Stop existing workers with a timeout
   bool stopPoolRebalancer(std::chrono::seconds timeout = std::chrono::seconds{
                               0});
@@ -954,6 +1104,12 @@ class CacheAllocator : public CacheBase {
                              0});
   bool stopMemMonitor(std::chrono::seconds timeout = std::chrono::seconds{0});
   bool stopReaper(std::chrono::seconds timeout = std::chrono::seconds{0});
+  bool stopBackgroundEvictor(
+      std::chrono::seconds timeout = std::chrono::seconds{0});
+  bool stopMemoryTierPromoter(
+      std::chrono::seconds timeout = std::chrono::seconds{0});
+  bool stopSlabCompactor(std::chrono::seconds timeout = std::chrono::seconds{
+                             0});
 
   // Set pool optimization to either true or false
   //
@@ -984,20 +1140,29 @@ class CacheAllocator : public CacheBase {
   // return a list of pool ids for regular pools.
   std::set<PoolId> getRegularPoolIds() const override final;
 
-  // return the pool with speicified id.
+  // return the pool with speicified id in the top memory tier.
   const MemoryPool& getPool(PoolId pid) const override final {
-    return allocator_[currentTier()]->getPool(pid);
+    return allocator_[0]->getPool(pid);
+  }
+
+  // return the pool with speicified id in the given memory tier.
+  const MemoryPool& getPoolByTid(PoolId pid,
+                                 TierId tid) const override final {
+    return allocator_[tid]->getPool(pid);
   }
 
+  // The memory monitor advises away and reclaims slabs of the top memory
+  // tier only, which is the one backed by DRAM.
+
   // calculate the number of slabs to be advised/reclaimed in each pool
   PoolAdviseReclaimData calcNumSlabsToAdviseReclaim() override final {
     auto regularPoolIds = getRegularPoolIds();
-    return allocator_[currentTier()]->calcNumSlabsToAdviseReclaim(regularPoolIds);
+    return allocator_[0]->calcNumSlabsToAdviseReclaim(regularPoolIds);
   }
 
   // update number of slabs to advise in the cache
   void updateNumSlabsToAdvise(int32_t numSlabsToAdvise) override final {
-    allocator_[currentTier()]->updateNumSlabsToAdvise(numSlabsToAdvise);
+    allocator_[0]->updateNumSlabsToAdvise(numSlabsToAdvise);
   }
 
   // returns a valid PoolId corresponding to the name or kInvalidPoolId if the
@@ -1029,12 +1194,43 @@ class CacheAllocator : public CacheBase {
     return accessContainer_->getStats();
   }
 
+  // Grow the access container to 2^bucketsPower buckets without dropping
+  // the cache. Items are migrated to the new buckets a few at a time by
+  // subsequent inserts and by rehashAccessContainer(). The resize, finished
+  // or not, is preserved across a warm roll. The access config must not
+  // change across the warm roll for that.
+  //
+  // @throw std::invalid_argument if a resize is already in progress or the
+  //        bucket power is not larger than the current one.
+  void resizeAccessContainer(unsigned int bucketsPower);
+
+  // Migrate up to numBuckets buckets of the resize in progress. Call this
+  // until it returns true. The buckets replaced by the resize are only
+  // freed by the call that returns true.
+  //
+  // @return true if the access container is not being resized anymore.
+  bool rehashAccessContainer(size_t numBuckets);
+
   // returns the reaper stats
   ReaperStats getReaperStats() const {
     auto stats = reaper_ ? reaper_->getStats() : ReaperStats{};
     return stats;
   }
 
+  // returns the background evictor stats
+  BackgroundEvictorStats getBackgroundEvictorStats() const {
+    auto stats = backgroundEvictor_ ? backgroundEvictor_->getStats()
+                                    : BackgroundEvictorStats{};
+    return stats;
+  }
+
+  // returns the slab compactor stats
+  SlabCompactorStats getSlabCompactorStats() const {
+    auto stats = slabCompactor_ ? slabCompactor_->getStats()
+                                : SlabCompactorStats{};
+    return stats;
+  }
+
   // return the LruType of an item
   typename MMType::LruType getItemLruType(const Item& item) const;
 
@@ -1048,13 +1244,23 @@ class CacheAllocator : public CacheBase {
   // combined pool size for all memory tiers
   size_t getPoolSize(PoolId pid) const;
 
-  // pool stats by pool id
+  // pool stats by pool id, aggregated across all memory tiers
   PoolStats getPoolStats(PoolId pid) const override final;
 
-  // This can be expensive so it is not part of PoolStats.
+  // pool stats by pool id for a single memory tier
+  PoolStats getPoolStats(TierId tid, PoolId pid) const override final;
+
+  // This can be expensive so it is not part of PoolStats. Returns the stats
+  // of the top memory tier.
   PoolEvictionAgeStats getPoolEvictionAgeStats(
       PoolId pid, unsigned int slabProjectionLength) const override final;
 
+  // This can be expensive so it is not part of PoolStats.
+  PoolEvictionAgeStats getPoolEvictionAgeStats(
+      TierId tid,
+      PoolId pid,
+      unsigned int slabProjectionLength) const override final;
+
   // return the cache's metadata
   CacheMetadata getCacheMetadata() const noexcept override final;
 
@@ -1064,6 +1270,12 @@ class CacheAllocator : public CacheBase {
   // return cache's memory usage stats.
   CacheMemoryStats getCacheMemoryStats() const override final;
 
+  // return the cache memory currently backed by huge pages in bytes, summed
+  // over the memory tiers that are configured with huge pages. This reads
+  // and parses /proc/self/smaps once, so it is meant to be called on demand
+  // rather than on every memory check.
+  size_t getHugePageBackedSize() const;
+
   // return the nvm cache stats map
   std::unordered_map<std::string, double> getNvmCacheStatsMap()
       const override final;
@@ -1196,6 +1408,10 @@ class CacheAllocator : public CacheBase {
   static_assert(std::is_standard_layout<ChainedItemPayload<CacheTrait>>::value,
                 "ChainedItemPayload not standard layout");
 
+  // the per-tier stats are fixed size arrays indexed by the tier id.
+  static_assert(Config::kMaxCacheMemoryTiers <= detail::Stats::kMaxTiers,
+                "per-tier stats can not hold every memory tier");
+
 // ensure that Item::alloc_ is the last member of Item. If not,
 // Item::alloc_::data[0] will not work as a variable sized struct.
 // gcc is strict about using offsetof in Item when Item has a default
@@ -1397,13 +1613,46 @@ class CacheAllocator : public CacheBase {
   //              not exist.
   FOLLY_ALWAYS_INLINE ItemHandle findFastImpl(Key key, AccessMode mode);
 
-  // Moves a regular item to a different memory tier.
+#if FOLLY_HAS_COROUTINES
+  // wait for a handle returned by find(key, AccessMode::kWrite) and
+  // invalidate the item in the nvm cache. Used by co_findToWrite.
+  folly::coro::Task<ItemHandle> co_completeFindToWrite(ItemHandle handle,
+                                                       bool doNvmInvalidation);
+
+  // wait for a handle in a task
+  template <typename HandleT>
+  static folly::coro::Task<HandleT> co_awaitHandle(HandleT handle);
+#endif
+
+  // update the lookup stats and record the access for the result of a RAM
+  // lookup.
+  //
+  // @param handle      handle returned by the access container
+  // @param mode        the mode of access for the lookup.
+  //
+  // @return      the handle passed in
+  FOLLY_ALWAYS_INLINE ItemHandle onRamLookup(ItemHandle handle,
+                                             AccessMode mode);
+
+  // finish a lookup given the result of the RAM lookup. Expired items are
+  // reported as misses and RAM misses are looked up in the nvm cache.
+  //
+  // @param key         the key for lookup
+  // @param handle      handle returned by onRamLookup for the key
+  //
+  // @return      the handle for the item or a handle to nullptr if the key does
+  //              not exist.
+  ItemHandle completeFind(Key key, ItemHandle handle);
+
+  // Moves a regular item to a different memory tier. If the item has chained
+  // items, the whole chain is copied into the tier of the new item and the
+  // old chain stays with the old item, to be freed along with it.
   //
   // @param oldItem     Reference to the item being moved
   // @param newItemHdl  Reference to the handle of the new item being moved into
   //
-  // @return true  If the move was completed, and the containers were updated
-  //               successfully.
+  // @return handle to the old item if the move was completed, and the
+  //         containers were updated successfully.
   ItemHandle moveRegularItemOnEviction(Item& oldItem, ItemHandle& newItemHdl);
 
   // Moves a regular item to a different slab. This should only be used during
@@ -1462,6 +1711,34 @@ class CacheAllocator : public CacheBase {
   // @throw if any of the conditions for parent or newParent are not met.
   void transferChainLocked(ItemHandle& parent, ItemHandle& newParent);
 
+  // Allocates a copy of the parent's chain in the memory tier of newParent.
+  // Allocations are made outside of the chained item lock since they might
+  // evict and the eviction might need to look at another chain.
+  //
+  // @param parent    the current parent of the chain we want to copy
+  // @param newParent the parent the copy is allocated for
+  // @param newChain  filled with one nascent chained item per chained item of
+  //                  parent, in the order from head to tail
+  //
+  // @return false if any of the allocations failed
+  bool allocateChainCopy(const Item& parent,
+                         const ReadHandle& newParent,
+                         std::vector<WriteHandle>& newChain);
+
+  // Copies the chain of parent into the items allocated by allocateChainCopy
+  // and links them to newParent. The chain of parent is left intact so it is
+  // freed along with parent. Chained item lock for the parent's key needs to
+  // be held in exclusive mode.
+  //
+  // @param parent    the current parent of the chain we want to copy
+  // @param newParent the parent to link the copy to
+  // @param newChain  chained items allocated by allocateChainCopy
+  //
+  // @return false if the chain of parent no longer matches newChain
+  bool copyChainLocked(const Item& parent,
+                       WriteHandle& newParent,
+                       std::vector<WriteHandle>& newChain);
+
   // replace a chained item in the existing chain. This needs to be called
   // with the chained item lock held exclusive
   //
@@ -1581,6 +1858,62 @@ class CacheAllocator : public CacheBase {
   //         handle to the item. On failure an empty handle. 
   WriteHandle tryEvictToNextMemoryTier(Item& item);
 
+  // Try to move the item with the given key up to the memory tier above the
+  // one it lives in. This may evict (and demote) an item from the upper tier
+  // to make room.
+  //
+  // @param key   the key of the item to promote
+  //
+  // @return true if the item was moved. false if the item is not in the cache,
+  //         already lives in tier 0 or is busy.
+  bool tryPromoteToUpperMemoryTier(typename Item::Key key);
+
+  // Pop the next key queued by a hit on an item in a lower memory tier.
+  //
+  // @param key   set to the popped key
+  // @return false if there are no candidates queued.
+  bool popPromotionCandidate(std::string& key);
+
+  // exposed for the BackgroundEvictor to evict items ahead of allocations.
+  // Evicts up to batch items from the tail of the MMContainer of the given
+  // tier, pool and class and frees their memory. Items evicted from a tier
+  // that has a tier below it are demoted into that tier.
+  //
+  // @return the number of items evicted
+  size_t traverseAndEvictItems(TierId tid,
+                               PoolId pid,
+                               ClassId cid,
+                               size_t batch);
+
+  // record an allocation size in the histogram of the pool, if enabled.
+  void recordAllocSize(PoolId pid, uint32_t requiredSize) noexcept {
+    if (const auto& histogram = allocSizeHistograms_[pid]) {
+      histogram->record(requiredSize);
+    }
+  }
+
+  // @return the histogram of the pool
+  // @throw std::invalid_argument if the poolId is invalid or the histograms
+  //        are not enabled.
+  const AllocSizeHistogram& getAllocSizeHistogram(PoolId pid) const;
+
+  // create the value compressor of the pool if the config enables value
+  // compression for it.
+  void initValueCompressor(PoolId pid);
+
+  // @return the uncompressed value of an item compressed by
+  //         allocateCompressed
+  // @throw std::invalid_argument if the item's pool has no value compression
+  std::unique_ptr<folly::IOBuf> uncompressValue(const Item& item);
+
+  // exposed for the SlabCompactor to pick the slab to compact.
+  // See AllocationClass::getSparsestSlab
+  std::pair<const Slab*, uint32_t> getSparsestSlab(TierId tid,
+                                                   PoolId pid,
+                                                   ClassId cid) {
+    return allocator_[tid]->getSparsestSlab(pid, cid);
+  }
+
   size_t memoryTierSize(TierId tid) const;
 
   // Deserializer CacheAllocatorMetadata and verify the version
@@ -1603,7 +1936,7 @@ class CacheAllocator : public CacheBase {
   MMContainers createEmptyMMContainers();
 
   unsigned int reclaimSlabs(PoolId id, size_t numSlabs) final {
-    return allocator_[currentTier()]->reclaimSlabsAndGrow(id, numSlabs);
+    return allocator_[0]->reclaimSlabsAndGrow(id, numSlabs);
   }
 
   FOLLY_ALWAYS_INLINE EventTracker* getEventTracker() const {
@@ -1661,6 +1994,15 @@ class CacheAllocator : public CacheBase {
                    SlabReleaseMode mode,
                    const void* hint = nullptr) final;
 
+  // Same as above, releasing the slab from the pool in the given memory tier.
+  // The slab release apis above release from the top memory tier.
+  void releaseSlab(TierId tid,
+                   PoolId pid,
+                   ClassId victim,
+                   ClassId receiver,
+                   SlabReleaseMode mode,
+                   const void* hint = nullptr) final;
+
   // @param releaseContext  slab release context
   void releaseSlabImpl(TierId tid, const SlabReleaseContext& releaseContext);
 
@@ -1734,7 +2076,9 @@ class CacheAllocator : public CacheBase {
     // primitives. So we consciously exempt ourselves here from TSAN data race
     // detection.
     folly::annotate_ignore_thread_sanitizer_guard g(__FILE__, __LINE__);
-    allocator_[currentTier()]->forEachAllocation(std::forward<Fn>(f));
+    for (TierId tid = 0; tid < numTiers_; tid++) {
+      allocator_[tid]->forEachAllocation(f);
+    }
   }
 
   // returns true if nvmcache is enabled and we should write this item to
@@ -1752,7 +2096,7 @@ class CacheAllocator : public CacheBase {
 
   static typename MemoryAllocator::Config getAllocatorConfig(
       const Config& config) {
-    return MemoryAllocator::Config{
+    MemoryAllocator::Config allocatorConfig{
         config.defaultAllocSizes.empty()
             ? util::generateAllocSizes(
                   config.allocationClassSizeFactor,
@@ -1761,7 +2105,10 @@ class CacheAllocator : public CacheBase {
                   config.reduceFragmentationInAllocationClass)
             : config.defaultAllocSizes,
         config.enableZeroedSlabAllocs, config.disableFullCoredump,
-        config.lockMemory};
+        config.lockMemory, config.allocationMagazineSize};
+    allocatorConfig.hugePages = config.hugePagePolicy;
+    allocatorConfig.hugePageFallback = config.hugePageFallback;
+    return allocatorConfig;
   }
 
   // starts one of the cache workers passing the current instance and the args
@@ -1779,6 +2126,10 @@ class CacheAllocator : public CacheBase {
 
   ShmSegmentOpts createShmCacheOpts(TierId tid);
 
+  // counts the access to an item of the tier if the calling thread runs on a
+  // numa node that the memory of the tier is not placed on.
+  void recordNumaAccess(TierId tid, TLCounter& remoteAccesses) noexcept;
+
   std::unique_ptr<MemoryAllocator> createNewMemoryAllocator(TierId tid);
   std::unique_ptr<MemoryAllocator> restoreMemoryAllocator(TierId tid);
   std::unique_ptr<CCacheManager> restoreCCacheManager(TierId tid);
@@ -1789,6 +2140,14 @@ class CacheAllocator : public CacheBase {
   // limit
   PoolIds getRegularPoolIdsForResize() const override final;
 
+  // returns a list of pools excluding compact cache pools that are over the
+  // limit in the given memory tier
+  PoolIds getRegularPoolIdsForResize(TierId tid) const override final;
+
+  // splits a size given for the whole cache into the size for every memory
+  // tier, in the ratio of the tier sizes.
+  std::vector<size_t> getTierSizes(size_t size) const;
+
   // return whether a pool participates in auto-resizing
   bool autoResizeEnabledForPool(PoolId) const override final;
 
@@ -1800,6 +2159,16 @@ class CacheAllocator : public CacheBase {
     return config_.serialize();
   }
 
+  // name of the shm segment with the buckets of the given generation of the
+  // access container. Generation 0 keeps the name from before resizing.
+  static std::string getAccessContainerShmName(uint32_t generation) {
+    return detail::getShmHashTableName(generation);
+  }
+
+  // removes the shm segment with the buckets the access container replaced
+  // by resizing.
+  void removeAccessContainerShm(uint32_t generation);
+
   typename Item::PtrCompressor createPtrCompressor() const {
     return typename Item::PtrCompressor(allocator_);
   }
@@ -1875,13 +2244,6 @@ class CacheAllocator : public CacheBase {
 
   // BEGIN private members
 
-  TierId currentTier() const {
-    // TODO: every function which calls this method should be refactored.
-    // We should go case by case and either make such function work on
-    // all tiers or expose separate parameter to describe the tier ID.
-    return 0;
-  }
-
   bool addWaitContextForMovingItem(
       folly::StringPiece key, std::shared_ptr<WaitContext<ReadHandle>> waiter);
 
@@ -1970,6 +2332,15 @@ class CacheAllocator : public CacheBase {
 
   const typename Config::MemoryTierConfigs memoryTierConfigs;
 
+  // whether any memory tier is placed on specific numa nodes, in which case
+  // the accesses from the other nodes are counted.
+  const bool hasNumaTiers_{
+      std::any_of(memoryTierConfigs.begin(),
+                  memoryTierConfigs.end(),
+                  [](const MemoryTierCacheConfig& tierConfig) {
+                    return !tierConfig.getNumaPolicy().isDefault();
+                  })};
+
   // Manages the temporary shared memory segment for memory allocator that
   // is not persisted when cache process exits.
   std::unique_ptr<TempShmMapping> tempShm_;
@@ -2082,6 +2453,29 @@ class CacheAllocator : public CacheBase {
   // allocator's items reaper to evict expired items in bg checking
   std::unique_ptr<Reaper<CacheT>> reaper_;
 
+  // keys of items hit in a lower memory tier, waiting to be considered for
+  // promotion. Only created when promotion between memory tiers is enabled.
+  std::unique_ptr<folly::MPMCQueue<std::string>> promotionCandidates_;
+
+  // evicts items in the background to keep free memory for allocations
+  std::unique_ptr<BackgroundEvictor<CacheT>> backgroundEvictor_;
+
+  // moves hot items from the lower memory tiers to the tier above them
+  std::unique_ptr<MemoryTierPromoter<CacheT>> memoryTierPromoter_;
+
+  // moves the items out of sparsely used slabs and frees the slabs
+  std::unique_ptr<SlabCompactor<CacheT>> slabCompactor_;
+
+  // histograms of the sizes allocated from each pool. Only created when
+  // enabled in the config.
+  std::array<std::unique_ptr<AllocSizeHistogram>, MemoryPoolManager::kMaxPools>
+      allocSizeHistograms_;
+
+  // compressors of the values of each pool. Only created for the pools
+  // with value compression enabled in the config.
+  std::array<std::unique_ptr<ValueCompressor>, MemoryPoolManager::kMaxPools>
+      valueCompressors_;
+
   class DummyTlsActiveItemRingTag {};
   folly::ThreadLocal<TlsActiveItemRing, DummyTlsActiveItemRingTag> ring_;
 
@@ -2091,6 +2485,9 @@ class CacheAllocator : public CacheBase {
   // admission policy for nvmcache
   std::shared_ptr<NvmAdmissionPolicy<CacheT>> nvmAdmissionPolicy_;
 
+  // admission policy for allocations into and demotions between memory tiers
+  std::shared_ptr<MemoryTierAdmissionPolicy<CacheT>> memoryTierAdmissionPolicy_;
+
   // indicates if the shutdown of cache is in progress or not
   std::atomic<bool> shutDownInProgress_{false};
 
@@ -2099,6 +2496,9 @@ class CacheAllocator : public CacheBase {
   // Make this friend to give access to acquire and release
   friend ReadHandle;
   friend ReaperAPIWrapper<CacheT>;
+  friend MemoryTierPromoterAPIWrapper<CacheT>;
+  friend BackgroundEvictorAPIWrapper<CacheT>;
+  friend SlabCompactorAPIWrapper<CacheT>;
   friend class CacheAPIWrapperForNvm<CacheT>;
   friend class FbInternalRuntimeUpdateWrapper<CacheT>;
 
@@ -2111,6 +2511,8 @@ class CacheAllocator : public CacheBase {
   template <typename AllocatorT>
   friend class facebook::cachelib::tests::AllocatorResizeTest;
   template <typename AllocatorT>
+  friend class facebook::cachelib::tests::AllocatorMemoryTiersTest;
+  template <typename AllocatorT>
   friend class facebook::cachelib::tests::PoolOptimizeStrategyTest;
   friend class facebook::cachelib::tests::NvmAdmissionPolicyTest;
   friend class facebook::cachelib::tests::CacheAllocatorTestWrapper;
@@ -2133,11 +2535,22 @@ extern template class CacheAllocator<LruCacheTrait>;
 extern template class CacheAllocator<LruCacheWithSpinBucketsTrait>;
 extern template class CacheAllocator<Lru2QCacheTrait>;
 extern template class CacheAllocator<TinyLFUCacheTrait>;
+extern template class CacheAllocator<ClockCacheTrait>;
+extern template class CacheAllocator<LruCacheWithTagHashTableTrait>;
+extern template class CacheAllocator<LruCacheWithCompactItemTrait>;
 
 // CacheAllocator with an LRU eviction policy
 // LRU policy can be configured to act as a segmented LRU as well
 using LruAllocator = CacheAllocator<LruCacheTrait>;
 using LruAllocatorSpinBuckets = CacheAllocator<LruCacheWithSpinBucketsTrait>;
+// same as LruAllocator, with a bucketized hash table that filters lookups by
+// a tag of the key's hash. See TagHashTable.h
+using LruAllocatorTagHashTable =
+    CacheAllocator<LruCacheWithTagHashTableTrait>;
+// same as LruAllocator, with a 6 bytes smaller item header for caches of
+// small items. Items keep a creation time rounded to the minute and can not
+// have a time to live. See CompactItemTimes in ItemTimes.h
+using LruAllocatorCompactItem = CacheAllocator<LruCacheWithCompactItemTrait>;
 
 // CacheAllocator with 2Q eviction policy
 // Hot, Warm, Cold queues are maintained
@@ -2155,5 +2568,12 @@ using Lru2QAllocator = CacheAllocator<Lru2QCacheTrait>;
 // inserted items. And eventually it will onl admit items that are accessed
 // beyond a threshold into the warm cache.
 using TinyLFUAllocator = CacheAllocator<TinyLFUCacheTrait>;
+
+// CacheAllocator with CLOCK eviction policy
+// Items are never moved on access; a hit only sets a reference bit in the
+// item, so reads do not take the eviction container lock. Eviction sweeps a
+// hand over the items and evicts the first one that was not accessed since
+// the previous sweep.
+using ClockAllocator = CacheAllocator<ClockCacheTrait>;
 } // namespace cachelib
 } // namespace facebook
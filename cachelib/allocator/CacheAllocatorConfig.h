@@ -19,6 +19,7 @@
 #include <folly/Optional.h>
 
 #include <functional>
+#include <map>
 #include <memory>
 #include <set>
 #include <stdexcept>
@@ -28,11 +29,13 @@
 #include "cachelib/allocator/MemoryTierCacheConfig.h"
 #include "cachelib/allocator/MM2Q.h"
 #include "cachelib/allocator/MemoryMonitor.h"
+#include "cachelib/allocator/MemoryTierAdmissionPolicy.h"
 #include "cachelib/allocator/MemoryTierCacheConfig.h"
 #include "cachelib/allocator/NvmAdmissionPolicy.h"
 #include "cachelib/allocator/PoolOptimizeStrategy.h"
 #include "cachelib/allocator/RebalanceStrategy.h"
 #include "cachelib/allocator/Util.h"
+#include "cachelib/allocator/ValueCompressor.h"
 #include "cachelib/common/EventInterface.h"
 #include "cachelib/common/Throttler.h"
 
@@ -140,6 +143,19 @@ class CacheAllocatorConfig {
   // returned by CacheAllocator::getUsableSize()
   bool isNvmCacheTruncateAllocSizeEnabled() const;
 
+  // compress the items written to NvmCache. Smaller items take smaller slots
+  // in BlockCache and pack more items into a BigHash bucket, which saves
+  // flash space and writes. BigHash items are smaller than the default
+  // config.minSize, so lower it when BigHash or Kangaroo is used.
+  //
+  // @throw std::invalid_argument if nvmcache is not used or the config is
+  //        invalid
+  CacheAllocatorConfig& enableNvmCacheCompression(
+      ValueCompressor::Config config);
+
+  // return if items are compressed in NvmCache
+  bool isNvmCacheCompressionEnabled() const;
+
   // Enable compact cache support. Refer to our user guide for how ccache works.
   CacheAllocatorConfig& enableCompactCache();
 
@@ -193,6 +209,23 @@ class CacheAllocatorConfig {
   // If memory monitor is enabled, this is not usually needed.
   CacheAllocatorConfig& setMemoryLocking(bool enable);
 
+  // Cache up to magazineSize free allocations per allocation class and cpu,
+  // so that allocations and frees mostly avoid the lock of the allocation
+  // class. Free memory held by the magazines is reclaimed when a slab is
+  // released. Use this when many threads allocate from the same classes.
+  CacheAllocatorConfig& enableAllocationMagazines(uint32_t magazineSize);
+
+  // Back the cache memory with huge pages, which cuts the TLB misses of
+  // lookups in large caches. Pages from the hugetlb pool (kTwoMB, kOneGB)
+  // need to be reserved on the host. When they are not available, the cache
+  // uses transparent huge pages instead if hugePageFallback is set, and fails
+  // otherwise. Shared memory that persists across restarts has to be created
+  // and attached with the same page size, so it never falls back. File-backed
+  // memory tiers only follow kTransparent, use
+  // MemoryTierCacheConfig::setHugePagePolicy to override it per tier.
+  CacheAllocatorConfig& enableHugePages(util::HugePagePolicy policy,
+                                        bool hugePageFallback = true);
+
   // This allows cache to be persisted across restarts. One example use case is
   // to preserve the cache when releasing a new version of your service. Refer
   // to our user guide for how to set up cache persistence.
@@ -221,6 +254,93 @@ class CacheAllocatorConfig {
   CacheAllocatorConfig& enableItemReaperInBackground(
       std::chrono::milliseconds interval, util::Throttler::Config config = {});
 
+  // This turns on a background worker that evicts items ahead of time so
+  // that allocations are served from free memory instead of evicting inline.
+  // Once a pool has handed out all of its slabs, the worker keeps
+  // freeAllocsPercent of the allocations of every class free. Items evicted
+  // from a memory tier that has a tier below it are demoted into that tier.
+  //
+  // @param interval            waits for an interval between each run
+  // @param freeAllocsPercent   percentage of each class to keep free
+  // @param maxEvictionBatch    max items evicted from a class in one run
+  //
+  // @throw std::invalid_argument if freeAllocsPercent is above 100
+  CacheAllocatorConfig& enableBackgroundEvictor(
+      std::chrono::milliseconds interval,
+      unsigned int freeAllocsPercent = 2,
+      unsigned int maxEvictionBatch = 100);
+
+  // This turns on promotion of hot items out of the lower memory tiers. Every
+  // hit on an item outside of tier 0 is queued as a promotion candidate and a
+  // background worker moves the item one tier up once it has seen
+  // hitsToPromote hits for it. Hits that do not fit in the queue are dropped,
+  // which rate limits the promotion work the lower tiers can generate.
+  //
+  // @param interval              waits for an interval between each run
+  // @param hitsToPromote         hits needed before an item is promoted
+  // @param maxPromotionsPerRun   max number of items promoted in one run
+  // @param queueSize             max number of queued promotion candidates
+  //
+  // @throw std::invalid_argument if hitsToPromote or queueSize is 0
+  CacheAllocatorConfig& enableMemoryTierPromotion(
+      std::chrono::milliseconds interval,
+      uint32_t hitsToPromote = 2,
+      uint32_t maxPromotionsPerRun = 1000,
+      uint32_t queueSize = 64 * 1024);
+
+  // This turns on compaction of sparsely used slabs. Every run, a background
+  // worker picks the slabs with the most free allocations, moves their items
+  // into the free allocations of the other slabs of their class and gives
+  // the emptied slabs back to their pool, where any class can use them.
+  // Items are moved with the callback set by enableMovingOnSlabRelease, so
+  // that must be set as well.
+  //
+  // @param interval            waits for an interval between each run
+  // @param slabsPerIteration   max number of slabs compacted in one run
+  // @param minFreePercent      percentage of a slab's allocations that must
+  //                            be free for it to be compacted
+  //
+  // @throw std::invalid_argument if minFreePercent is above 100
+  CacheAllocatorConfig& enableSlabCompaction(
+      std::chrono::milliseconds interval,
+      unsigned int slabsPerIteration = 1,
+      unsigned int minFreePercent = 50);
+
+  // This turns on a histogram of the allocation sizes requested from every
+  // pool. The histogram is used to propose allocation class sizes that fit
+  // the workload better than the ones the pool was created with. See
+  // CacheAllocator::proposeAllocSizes and addAllocationClasses.
+  //
+  // @param sampleRate  record one out of sampleRate allocations
+  //
+  // @throw std::invalid_argument if sampleRate is 0
+  CacheAllocatorConfig& enableAllocSizeHistogram(uint32_t sampleRate = 100);
+
+  // This turns on compression of the values of a pool. Values allocated
+  // with CacheAllocator::allocateCompressed are stored compressed when
+  // they compress well enough, and are uncompressed on read by
+  // CacheAllocator::convertToIOBuf.
+  //
+  // Compressed items stay compressed across a restart, so the pool must be
+  // configured the same way, with the same dictionary, when the cache is
+  // attached again.
+  //
+  // @param poolName  name of the pool, as passed to addPool
+  // @param config    compression config for the pool
+  //
+  // @throw std::invalid_argument if the compression config is invalid
+  CacheAllocatorConfig& enableValueCompression(
+      std::string poolName, ValueCompressor::Config config);
+
+  // Set an admission policy for the memory tiers. The policy picks the tier
+  // new allocations start from and filters the items evicted from a tier
+  // before they get demoted into the tier below. Items the policy does not
+  // demote are evicted out of memory, to nvmcache if it is enabled.
+  //
+  // @throw std::invalid_argument if nullptr is passed.
+  CacheAllocatorConfig& setMemoryTierAdmissionPolicy(
+      std::shared_ptr<MemoryTierAdmissionPolicy<CacheT>> policy);
+
   // When using free memory monitoring mode, CacheAllocator shrinks the cache
   // size when the system is under memory pressure. Cache will grow back when
   // the memory pressure goes down.
@@ -349,6 +469,30 @@ class CacheAllocatorConfig {
     return reaperInterval.count() > 0;
   }
 
+  // @return whether background evictor is enabled
+  bool backgroundEvictorEnabled() const noexcept {
+    return backgroundEvictorInterval.count() > 0 &&
+           backgroundEvictorFreeAllocsPercent > 0 &&
+           backgroundEvictorBatch > 0;
+  }
+
+  // @return whether slab compaction is enabled
+  bool slabCompactionEnabled() const noexcept {
+    return slabCompactionInterval.count() > 0 &&
+           slabCompactionSlabsPerIter > 0;
+  }
+
+  // @return whether the allocation size histograms are enabled
+  bool allocSizeHistogramEnabled() const noexcept {
+    return allocSizeHistogramSampleRate > 0;
+  }
+
+  // @return whether promotion between memory tiers is enabled
+  bool memoryTierPromotionEnabled() const noexcept {
+    return memoryTierPromotionInterval.count() > 0 &&
+           memoryTierConfigs.size() > 1;
+  }
+
   const std::string& getCacheDir() const noexcept { return cacheDir; }
 
   const std::string& getCacheName() const noexcept { return cacheName; }
@@ -476,6 +620,54 @@ class CacheAllocatorConfig {
   // time to sleep between each reaping period.
   std::chrono::milliseconds reaperInterval{5000};
 
+  // time to sleep between each run of the background evictor.
+  // Set to 0 to disable background eviction.
+  std::chrono::milliseconds backgroundEvictorInterval{0};
+
+  // percentage of the allocations of each class the background evictor
+  // keeps free
+  unsigned int backgroundEvictorFreeAllocsPercent{2};
+
+  // max number of items the background evictor evicts from a class in one
+  // run
+  unsigned int backgroundEvictorBatch{100};
+
+  // time to sleep between each run of the memory tier promoter.
+  // Set to 0 to disable promotion between memory tiers.
+  std::chrono::milliseconds memoryTierPromotionInterval{0};
+
+  // number of hits an item needs in a lower memory tier to be promoted
+  uint32_t memoryTierPromotionHits{2};
+
+  // max number of items the memory tier promoter moves in one run
+  uint32_t memoryTierPromotionsPerRun{1000};
+
+  // max number of promotion candidates waiting for the promoter
+  uint32_t memoryTierPromotionQueueSize{64 * 1024};
+
+  // time to sleep between each run of the slab compactor.
+  // Set to 0 to disable slab compaction.
+  std::chrono::milliseconds slabCompactionInterval{0};
+
+  // max number of slabs the slab compactor compacts in one run
+  unsigned int slabCompactionSlabsPerIter{1};
+
+  // percentage of a slab's allocations that must be free for the slab
+  // compactor to compact it
+  unsigned int slabCompactionMinFreePercent{50};
+
+  // record one out of this many allocation sizes in the histogram of their
+  // pool. Set to 0 to disable the histograms.
+  uint32_t allocSizeHistogramSampleRate{0};
+
+  // compression of the values of the pools, by pool name
+  std::map<std::string, ValueCompressor::Config> valueCompressionConfigs;
+
+  // admission policy for allocations into and demotions between the memory
+  // tiers. Without one, allocations start at the top tier and every evicted
+  // item is demoted.
+  std::shared_ptr<MemoryTierAdmissionPolicy<CacheT>> memoryTierAP{nullptr};
+
   // interval during which we adjust dynamically the refresh ratio.
   std::chrono::milliseconds mmReconfigureInterval{0};
 
@@ -571,6 +763,16 @@ class CacheAllocatorConfig {
   // This option has no effect when attaching to existing cache.
   bool lockMemory{false};
 
+  // Max number of free allocations cached per allocation class and cpu.
+  // 0 disables the magazines.
+  uint32_t allocationMagazineSize{0};
+
+  // Huge pages backing the cache memory.
+  util::HugePagePolicy hugePagePolicy{util::HugePagePolicy::kNone};
+
+  // Use transparent huge pages when the hugetlb pool can not back the cache.
+  bool hugePageFallback{true};
+
   // These configs configure how MemoryAllocator will be generating
   // allocation class sizes for each pool by default
   double allocationClassSizeFactor{1.25};
@@ -649,9 +851,7 @@ CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::setAccessConfig(
 template <typename T>
 CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::setAccessConfig(
     size_t numEntries) {
-  AccessConfig config{};
-  config.sizeBucketsPowerAndLocksPower(numEntries);
-  accessConfig = std::move(config);
+  accessConfig = T::AccessType::makeConfig(numEntries);
   return *this;
 }
 
@@ -773,6 +973,23 @@ bool CacheAllocatorConfig<T>::isNvmCacheTruncateAllocSizeEnabled() const {
   return nvmConfig && nvmConfig->truncateItemToOriginalAllocSizeInNvm;
 }
 
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableNvmCacheCompression(
+    ValueCompressor::Config config) {
+  if (!nvmConfig) {
+    throw std::invalid_argument(
+        "NvmCache compression can not be enabled unless nvmcache is used");
+  }
+  config.validate();
+  nvmConfig->compression = std::move(config);
+  return *this;
+}
+
+template <typename T>
+bool CacheAllocatorConfig<T>::isNvmCacheCompressionEnabled() const {
+  return nvmConfig && nvmConfig->compression.hasValue();
+}
+
 template <typename T>
 CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableCompactCache() {
   enableZeroedSlabAllocs = true;
@@ -790,9 +1007,7 @@ CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::configureChainedItems(
 template <typename T>
 CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::configureChainedItems(
     size_t numEntries, uint32_t lockPower) {
-  AccessConfig config{};
-  config.sizeBucketsPowerAndLocksPower(numEntries);
-  chainedItemAccessConfig = std::move(config);
+  chainedItemAccessConfig = T::AccessType::makeConfig(numEntries);
   chainedItemsLockPower = lockPower;
   return *this;
 }
@@ -836,6 +1051,21 @@ CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::setMemoryLocking(
   return *this;
 }
 
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableAllocationMagazines(
+    uint32_t magazineSize) {
+  allocationMagazineSize = magazineSize;
+  return *this;
+}
+
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableHugePages(
+    util::HugePagePolicy policy, bool fallback) {
+  hugePagePolicy = policy;
+  hugePageFallback = fallback;
+  return *this;
+}
+
 template <typename T>
 CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableCachePersistence(
     std::string cacheDirectory, void* baseAddr) {
@@ -862,6 +1092,84 @@ CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableItemReaperInBackground(
   return *this;
 }
 
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableBackgroundEvictor(
+    std::chrono::milliseconds interval,
+    unsigned int freeAllocsPercent,
+    unsigned int maxEvictionBatch) {
+  if (freeAllocsPercent > 100) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid background evictor free allocs percent: {}",
+        freeAllocsPercent));
+  }
+  backgroundEvictorInterval = interval;
+  backgroundEvictorFreeAllocsPercent = freeAllocsPercent;
+  backgroundEvictorBatch = maxEvictionBatch;
+  return *this;
+}
+
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableMemoryTierPromotion(
+    std::chrono::milliseconds interval,
+    uint32_t hitsToPromote,
+    uint32_t maxPromotionsPerRun,
+    uint32_t queueSize) {
+  if (hitsToPromote == 0 || queueSize == 0) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid memory tier promotion config. hitsToPromote: {}, "
+        "queueSize: {}",
+        hitsToPromote, queueSize));
+  }
+  memoryTierPromotionInterval = interval;
+  memoryTierPromotionHits = hitsToPromote;
+  memoryTierPromotionsPerRun = maxPromotionsPerRun;
+  memoryTierPromotionQueueSize = queueSize;
+  return *this;
+}
+
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableSlabCompaction(
+    std::chrono::milliseconds interval,
+    unsigned int slabsPerIteration,
+    unsigned int minFreePercent) {
+  if (minFreePercent > 100) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid slab compaction min free percent: {}", minFreePercent));
+  }
+  slabCompactionInterval = interval;
+  slabCompactionSlabsPerIter = slabsPerIteration;
+  slabCompactionMinFreePercent = minFreePercent;
+  return *this;
+}
+
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableAllocSizeHistogram(
+    uint32_t sampleRate) {
+  if (sampleRate == 0) {
+    throw std::invalid_argument("Invalid alloc size histogram sample rate: 0");
+  }
+  allocSizeHistogramSampleRate = sampleRate;
+  return *this;
+}
+
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableValueCompression(
+    std::string poolName, ValueCompressor::Config config) {
+  config.validate();
+  valueCompressionConfigs[std::move(poolName)] = std::move(config);
+  return *this;
+}
+
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::setMemoryTierAdmissionPolicy(
+    std::shared_ptr<MemoryTierAdmissionPolicy<T>> policy) {
+  if (!policy) {
+    throw std::invalid_argument("Setting a null memory tier admission policy");
+  }
+  memoryTierAP = std::move(policy);
+  return *this;
+}
+
 template <typename T>
 CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::configureMemoryTiers(
     const MemoryTierConfigs& config) {
@@ -1031,6 +1339,12 @@ const CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::validate() const {
         "It's not allowed to enable both RemoveCB and ItemDestructor.");
   }
 
+  // compaction would evict the items of the compacted slabs otherwise
+  if (slabCompactionEnabled() && !moveCb) {
+    throw std::invalid_argument(
+        "Slab compaction requires moving on slab release to be enabled.");
+  }
+
   return validateMemoryTiers();
 }
 
@@ -1127,6 +1441,32 @@ std::map<std::string, std::string> CacheAllocatorConfig<T>::serialize() const {
   configMap["reclaimRateLimitWindowSecs"] =
       std::to_string(memMonitorConfig.reclaimRateLimitWindowSecs.count());
   configMap["reaperInterval"] = util::toString(reaperInterval);
+  configMap["backgroundEvictorInterval"] =
+      util::toString(backgroundEvictorInterval);
+  configMap["backgroundEvictorFreeAllocsPercent"] =
+      std::to_string(backgroundEvictorFreeAllocsPercent);
+  configMap["backgroundEvictorBatch"] = std::to_string(backgroundEvictorBatch);
+  configMap["memoryTierPromotionInterval"] =
+      util::toString(memoryTierPromotionInterval);
+  configMap["memoryTierPromotionHits"] =
+      std::to_string(memoryTierPromotionHits);
+  configMap["memoryTierPromotionsPerRun"] =
+      std::to_string(memoryTierPromotionsPerRun);
+  configMap["slabCompactionInterval"] = util::toString(slabCompactionInterval);
+  configMap["slabCompactionSlabsPerIter"] =
+      std::to_string(slabCompactionSlabsPerIter);
+  configMap["slabCompactionMinFreePercent"] =
+      std::to_string(slabCompactionMinFreePercent);
+  configMap["allocSizeHistogramSampleRate"] =
+      std::to_string(allocSizeHistogramSampleRate);
+  std::string compressedPools;
+  for (const auto& [poolName, compressionConfig] : valueCompressionConfigs) {
+    compressedPools += compressedPools.empty() ? poolName : "," + poolName;
+  }
+  configMap["valueCompressionPools"] = compressedPools;
+  configMap["memoryTierPromotionQueueSize"] =
+      std::to_string(memoryTierPromotionQueueSize);
+  configMap["memoryTierAP"] = memoryTierAP ? "custom" : "empty";
   configMap["mmReconfigureInterval"] = util::toString(mmReconfigureInterval);
   configMap["disableEviction"] = std::to_string(disableEviction);
   configMap["evictionSearchTries"] = std::to_string(evictionSearchTries);
@@ -1140,6 +1480,10 @@ std::map<std::string, std::string> CacheAllocatorConfig<T>::serialize() const {
   configMap["moveCb"] = moveCb ? "set" : "empty";
   configMap["enableZeroedSlabAllocs"] = std::to_string(enableZeroedSlabAllocs);
   configMap["lockMemory"] = std::to_string(lockMemory);
+  configMap["allocationMagazineSize"] = std::to_string(allocationMagazineSize);
+  configMap["hugePagePolicy"] =
+      std::to_string(static_cast<int>(hugePagePolicy));
+  configMap["hugePageFallback"] = std::to_string(hugePageFallback);
   configMap["allocationClassSizeFactor"] =
       std::to_string(allocationClassSizeFactor);
   configMap["maxAllocationClassSize"] = std::to_string(maxAllocationClassSize);
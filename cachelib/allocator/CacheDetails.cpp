@@ -24,6 +24,11 @@ const std::string kShmCacheName = "shm_cache";
 const std::string kShmHashTableName = "shm_hash_table";
 const std::string kShmChainedItemHashTableName = "shm_chained_alloc_hash_table";
 
+std::string getShmHashTableName(uint32_t generation) {
+  return generation == 0 ? kShmHashTableName
+                         : kShmHashTableName + std::to_string(generation);
+}
+
 } // namespace detail
 } // namespace cachelib
 } // namespace facebook
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 // Conatains common symbols shared across different build targets. We provide
@@ -34,6 +35,15 @@ extern const std::string kShmCacheName;
 // identifier for the main hash table if used
 extern const std::string kShmHashTableName;
 
+// the main hash table can be resized online. Every resize puts the buckets
+// in a new segment and adds at least one to the bucket power, which is at
+// most 32.
+constexpr uint32_t kShmHashTableMaxGeneration = 32;
+
+// identifier for the buckets of the main hash table after the given number
+// of resizes. Generation 0 is kShmHashTableName.
+std::string getShmHashTableName(uint32_t generation);
+
 // identifier for the auxilary hash table for chained items
 extern const std::string kShmChainedItemHashTableName;
 
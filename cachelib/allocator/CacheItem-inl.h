@@ -42,11 +42,11 @@ CacheItem<CacheTrait>::CacheItem(Key key,
                                  uint32_t size,
                                  uint32_t creationTime,
                                  uint32_t expiryTime)
-    : creationTime_(creationTime), expiryTime_(expiryTime), alloc_(key, size) {}
+    : times_(creationTime, expiryTime), alloc_(key, size) {}
 
 template <typename CacheTrait>
 CacheItem<CacheTrait>::CacheItem(Key key, uint32_t size, uint32_t creationTime)
-    : CacheItem(key, size, creationTime, 0 /* expiryTime_ */) {}
+    : CacheItem(key, size, creationTime, 0 /* expiryTime */) {}
 
 template <typename CacheTrait>
 const typename CacheItem<CacheTrait>::Key CacheItem<CacheTrait>::getKey()
@@ -100,18 +100,19 @@ uint32_t CacheItem<CacheTrait>::getSize() const noexcept {
 
 template <typename CacheTrait>
 uint32_t CacheItem<CacheTrait>::getExpiryTime() const noexcept {
-  return expiryTime_;
+  return times_.getExpiryTime();
 }
 
 template <typename CacheTrait>
 bool CacheItem<CacheTrait>::isExpired() const noexcept {
   thread_local uint32_t staleTime = 0;
 
-  if (expiryTime_ == 0) {
+  const uint32_t expiryTime = times_.getExpiryTime();
+  if (expiryTime == 0) {
     return false;
   }
 
-  if (expiryTime_ < staleTime) {
+  if (expiryTime < staleTime) {
     return true;
   }
 
@@ -119,23 +120,33 @@ bool CacheItem<CacheTrait>::isExpired() const noexcept {
   if (currentTime != staleTime) {
     staleTime = currentTime;
   }
-  return expiryTime_ < currentTime;
+  return expiryTime < currentTime;
 }
 
 template <typename CacheTrait>
 bool CacheItem<CacheTrait>::isExpired(uint32_t currentTimeSec) const noexcept {
-  return (expiryTime_ > 0 && expiryTime_ < currentTimeSec);
+  const uint32_t expiryTime = times_.getExpiryTime();
+  return (expiryTime > 0 && expiryTime < currentTimeSec);
 }
 
 template <typename CacheTrait>
 uint32_t CacheItem<CacheTrait>::getCreationTime() const noexcept {
-  return creationTime_;
+  if constexpr (Times::kTruncatedCreationTime) {
+    // the last access time is set once the item is in its MMContainer and is
+    // never before the creation time.
+    const uint32_t lastAccessTime = getLastAccessTime();
+    return times_.getCreationTime(
+        lastAccessTime != 0 ? lastAccessTime : util::getCurrentTimeSec());
+  } else {
+    return times_.getCreationTime();
+  }
 }
 
 template <typename CacheTrait>
 std::chrono::seconds CacheItem<CacheTrait>::getConfiguredTTL() const noexcept {
-  return std::chrono::seconds(expiryTime_ > 0 ? expiryTime_ - creationTime_
-                                              : 0);
+  const uint32_t expiryTime = times_.getExpiryTime();
+  return std::chrono::seconds(
+      expiryTime > 0 ? expiryTime - getCreationTime() : 0);
 }
 
 template <typename CacheTrait>
@@ -288,6 +299,16 @@ bool CacheItem<CacheTrait>::isIncomplete() const noexcept {
   return ref_.isIncomplete();
 }
 
+template <typename CacheTrait>
+void CacheItem<CacheTrait>::markValueCompressed() noexcept {
+  ref_.markValueCompressed();
+}
+
+template <typename CacheTrait>
+bool CacheItem<CacheTrait>::isValueCompressed() const noexcept {
+  return ref_.isValueCompressed();
+}
+
 template <typename CacheTrait>
 void CacheItem<CacheTrait>::markIsChainedItem() noexcept {
   XDCHECK(!hasChainedItem());
@@ -352,6 +373,12 @@ bool CacheItem<CacheTrait>::isFlagSet() const noexcept {
   return ref_.template isFlagSet<flagBit>();
 }
 
+template <typename CacheTrait>
+template <typename RefcountWithFlags::Flags flagBit>
+bool CacheItem<CacheTrait>::trySetFlag() noexcept {
+  return ref_.template trySetFlag<flagBit>();
+}
+
 template <typename CacheTrait>
 bool CacheItem<CacheTrait>::updateExpiryTime(uint32_t expiryTimeSecs) noexcept {
   // check for moving to make sure we are not updating the expiry time while at
@@ -361,13 +388,7 @@ bool CacheItem<CacheTrait>::updateExpiryTime(uint32_t expiryTimeSecs) noexcept {
     return false;
   }
   // attempt to atomically update the value of expiryTime
-  while (true) {
-    uint32_t currExpTime = expiryTime_;
-    if (__sync_bool_compare_and_swap(&expiryTime_, currExpTime,
-                                     expiryTimeSecs)) {
-      return true;
-    }
-  }
+  return times_.updateExpiryTime(expiryTimeSecs);
 }
 
 template <typename CacheTrait>
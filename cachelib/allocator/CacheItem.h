@@ -25,6 +25,7 @@
 #include "cachelib/allocator/Cache.h"
 #include "cachelib/allocator/CacheChainedItemIterator.h"
 #include "cachelib/allocator/Handle.h"
+#include "cachelib/allocator/ItemTimes.h"
 #include "cachelib/allocator/KAllocation.h"
 #include "cachelib/allocator/Refcount.h"
 #include "cachelib/allocator/TypedHandle.h"
@@ -34,6 +35,7 @@
 #include "cachelib/common/CompilerUtils.h"
 #include "cachelib/common/Exceptions.h"
 #include "cachelib/common/Mutex.h"
+#include "cachelib/common/Time.h"
 
 namespace facebook {
 
@@ -114,12 +116,16 @@ class CACHELIB_PACKED_ATTR CacheItem {
    * compressed pointers that link an item to said container in addition
    * to other metadata that the container itself deems useful to keep.
    *
+   * Creation and expiry time are kept as the cache trait's ItemTimesType,
+   * ItemTimes by default. See ItemTimes.h
+   *
    * Payload in this case is KAllocation which contains its own metadata
    * that describes the length of the payload, the size of the key in
    * addition to the actual key and the data.
    */
   using AccessHook = typename CacheTrait::AccessType::template Hook<Item>;
   using MMHook = typename CacheTrait::MMType::template Hook<Item>;
+  using Times = typename detail::ItemTimesOf<CacheTrait>::type;
   using Key = KAllocation::Key;
 
   /**
@@ -216,7 +222,7 @@ class CACHELIB_PACKED_ATTR CacheItem {
   uint32_t getExpiryTime() const noexcept;
 
   // check if the item reaches the expiry timestamp
-  // expiryTime_ == 0 means no time limitation for this Item
+  // expiry time 0 means no time limitation for this Item
   bool isExpired() const noexcept;
 
   // Check if the item is expired relative to the provided timestamp.
@@ -259,6 +265,14 @@ class CACHELIB_PACKED_ATTR CacheItem {
   void unmarkIncomplete() noexcept;
   bool isIncomplete() const noexcept;
 
+  /**
+   * Marks that the payload is compressed by the ValueCompressor of the
+   * item's pool. The payload of such an item should be read through
+   * CacheAllocator::convertToIOBuf, which uncompresses it.
+   */
+  void markValueCompressed() noexcept;
+  bool isValueCompressed() const noexcept;
+
   /**
    * Function to set the timestamp for when to expire an item
    *
@@ -405,6 +419,8 @@ class CACHELIB_PACKED_ATTR CacheItem {
   void unSetFlag() noexcept;
   template <RefcountWithFlags::Flags flagBit>
   bool isFlagSet() const noexcept;
+  template <RefcountWithFlags::Flags flagBit>
+  bool trySetFlag() noexcept;
 
   /**
    * The following are the data members of CacheItem
@@ -431,12 +447,8 @@ class CACHELIB_PACKED_ATTR CacheItem {
   // Refcount for the item and also flags on the items state
   RefcountWithFlags ref_;
 
-  // Time when this cache item is created
-  const uint32_t creationTime_{0};
-
-  // Expiry timestamp for the item
-  // 0 means no time limitation
-  uint32_t expiryTime_{0};
+  // Creation and expiry time of the item
+  Times times_;
 
   // The actual allocation.
   KAllocation alloc_;
@@ -464,6 +476,7 @@ class CACHELIB_PACKED_ATTR CacheItem {
   FRIEND_TEST(ItemTest, ToString);
   FRIEND_TEST(ItemTest, CreationTime);
   FRIEND_TEST(ItemTest, ExpiryTime);
+  FRIEND_TEST(ItemTest, CompactItemTimes);
   FRIEND_TEST(ItemTest, ChainedItemConstruction);
   FRIEND_TEST(ItemTest, NonStringKey);
   template <typename AllocatorT>
@@ -479,7 +492,7 @@ class CACHELIB_PACKED_ATTR CacheItem {
 // | AccessHook            |
 // | MMHook                |
 // | RefCountWithFlags     |
-// | creationTime_         |
+// | times_                |
 // | --------------------- |
 // |  K | size_            |
 // |  A | ---------------- |
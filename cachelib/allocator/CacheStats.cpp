@@ -23,16 +23,18 @@ namespace cachelib {
 namespace detail {
 
 void Stats::init() {
-  cacheHits = std::make_unique<PerPoolClassTLCounters>();
-  allocAttempts = std::make_unique<PerPoolClassAtomicCounters>();
-  fragmentationSize = std::make_unique<PerPoolClassAtomicCounters>();
-  allocFailures = std::make_unique<PerPoolClassAtomicCounters>();
-  chainedItemEvictions = std::make_unique<PerPoolClassAtomicCounters>();
-  regularItemEvictions = std::make_unique<PerPoolClassAtomicCounters>();
+  cacheHits = std::make_unique<PerTierPoolClassTLCounters>();
+  allocAttempts = std::make_unique<PerTierPoolClassAtomicCounters>();
+  fragmentationSize = std::make_unique<PerTierPoolClassAtomicCounters>();
+  allocFailures = std::make_unique<PerTierPoolClassAtomicCounters>();
+  chainedItemEvictions = std::make_unique<PerTierPoolClassAtomicCounters>();
+  regularItemEvictions = std::make_unique<PerTierPoolClassAtomicCounters>();
   auto initToZero = [](auto& a) {
-    for (auto& s : a) {
-      for (auto& c : s) {
-        c.set(0);
+    for (auto& t : a) {
+      for (auto& s : t) {
+        for (auto& c : s) {
+          c.set(0);
+        }
       }
     }
   };
@@ -49,7 +51,7 @@ struct SizeVerify {};
 
 void Stats::populateGlobalCacheStats(GlobalCacheStats& ret) const {
 #ifndef SKIP_SIZE_VERIFY
-  SizeVerify<sizeof(Stats)> a = SizeVerify<16144>{};
+  SizeVerify<sizeof(Stats)> a = SizeVerify<16400>{};
   std::ignore = a;
 #endif
   ret.numCacheGets = numCacheGets.get();
@@ -58,6 +60,8 @@ void Stats::populateGlobalCacheStats(GlobalCacheStats& ret) const {
   ret.numCacheRemoves = numCacheRemoves.get();
   ret.numCacheRemoveRamHits = numCacheRemoveRamHits.get();
   ret.numRamDestructorCalls = numRamDestructorCalls.get();
+  ret.numRamRemoteNumaHits = numRamRemoteNumaHits.get();
+  ret.numRamRemoteNumaAllocs = numRamRemoteNumaAllocs.get();
 
   ret.numNvmGets = numNvmGets.get();
   ret.numNvmGetMiss = numNvmGetMiss.get();
@@ -119,10 +123,17 @@ void Stats::populateGlobalCacheStats(GlobalCacheStats& ret) const {
     }
     return sum;
   };
-  ret.allocAttempts = accum(*allocAttempts);
-  ret.allocFailures = accum(*allocFailures);
-  ret.numEvictions = accum(*chainedItemEvictions);
-  ret.numEvictions += accum(*regularItemEvictions);
+  auto accumTiers = [&accum](const PerTierPoolClassAtomicCounters& c) {
+    uint64_t sum = 0;
+    for (const auto& t : c) {
+      sum += accum(t);
+    }
+    return sum;
+  };
+  ret.allocAttempts = accumTiers(*allocAttempts);
+  ret.allocFailures = accumTiers(*allocFailures);
+  ret.numEvictions = accumTiers(*chainedItemEvictions);
+  ret.numEvictions += accumTiers(*regularItemEvictions);
 
   ret.invalidAllocs = invalidAllocs.get();
   ret.numRefcountOverflow = numRefcountOverflow.get();
@@ -133,6 +144,35 @@ void Stats::populateGlobalCacheStats(GlobalCacheStats& ret) const {
   ret.numEvictionFailureFromMoving = evictFailMove.get();
   ret.numEvictionFailureFromParentMoving = evictFailParentMove.get();
   ret.numAbortedSlabReleases = numAbortedSlabReleases.get();
+
+  auto perTier = [](const PerTierAtomicCounters& c) {
+    std::vector<uint64_t> res;
+    res.reserve(c.size());
+    for (const auto& v : c) {
+      res.push_back(v.get());
+    }
+    return res;
+  };
+  ret.numTierPromotions = perTier(numPromotions);
+  ret.numTierPromotionFailures = perTier(numPromotionFailures);
+  ret.numTierDemotions = perTier(numDemotions);
+  ret.numTierDemotionRejectsByAP = perTier(numDemotionRejectsByAP);
+  ret.numTierSlabReleases = perTier(numSlabReleases);
+
+  for (size_t tid = 0; tid < kMaxTiers; tid++) {
+    ret.numTierAllocAttempts.push_back(accum((*allocAttempts)[tid]));
+    ret.numTierAllocFailures.push_back(accum((*allocFailures)[tid]));
+    ret.numTierEvictions.push_back(accum((*chainedItemEvictions)[tid]) +
+                                   accum((*regularItemEvictions)[tid]));
+
+    uint64_t hits = 0;
+    for (const auto& x : (*cacheHits)[tid]) {
+      for (const auto& v : x) {
+        hits += v.get();
+      }
+    }
+    ret.numTierCacheHits.push_back(hits);
+  }
 }
 
 } // namespace detail
@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <numeric>
+#include <vector>
 
 #include "cachelib/allocator/Util.h"
 #include "cachelib/allocator/memory/MemoryAllocator.h"
@@ -285,6 +286,73 @@ struct ReaperStats {
   uint64_t avgTraversalTimeMs{0};
 };
 
+// Stats for background evictor
+struct BackgroundEvictorStats {
+  // the number of items evicted (or demoted to the next memory tier).
+  uint64_t numEvictedItems{0};
+
+  // number of times an allocation class was found below the free watermark
+  uint64_t numClassesBelowWatermark{0};
+
+  // number of times we went through all the allocation classes
+  uint64_t numTraversals{0};
+};
+
+// Stats for slab compactor
+struct SlabCompactorStats {
+  // number of slabs emptied by moving their items and returned to the pool
+  uint64_t numSlabsCompacted{0};
+
+  // memory returned to the pools by the compacted slabs
+  uint64_t numBytesReclaimed{0};
+
+  // number of times we went through all the allocation classes
+  uint64_t numTraversals{0};
+};
+
+// Stats for the compression of the values of a pool. See ValueCompressor.h
+struct ValueCompressionStats {
+  // number of values stored compressed
+  uint64_t numCompressed{0};
+
+  // number of values stored as is because they are too small
+  uint64_t numSkippedSmall{0};
+
+  // number of values stored as is because they did not compress enough
+  uint64_t numSkippedRatio{0};
+
+  // number of values uncompressed on read
+  uint64_t numUncompressed{0};
+
+  // size of the values stored compressed, before and after compression
+  uint64_t uncompressedBytes{0};
+  uint64_t compressedBytes{0};
+
+  // time spent compressing, including the values that did not compress
+  // enough, and uncompressing
+  uint64_t compressNs{0};
+  uint64_t uncompressNs{0};
+
+  // @return how many times smaller the compressed values are
+  double getCompressionRatio() const noexcept {
+    return compressedBytes == 0
+               ? 0
+               : static_cast<double>(uncompressedBytes) / compressedBytes;
+  }
+
+  ValueCompressionStats& operator+=(const ValueCompressionStats& other) {
+    numCompressed += other.numCompressed;
+    numSkippedSmall += other.numSkippedSmall;
+    numSkippedRatio += other.numSkippedRatio;
+    numUncompressed += other.numUncompressed;
+    uncompressedBytes += other.uncompressedBytes;
+    compressedBytes += other.compressedBytes;
+    compressNs += other.compressNs;
+    uncompressNs += other.uncompressNs;
+    return *this;
+  }
+};
+
 // CacheMetadata type to export
 struct CacheMetadata {
   // allocator_version
@@ -325,6 +393,11 @@ struct GlobalCacheStats {
   // number of item destructor calls from ram
   uint64_t numRamDestructorCalls{0};
 
+  // number of ram hits and allocations from threads running on a numa node
+  // that the memory tier of the item is not placed on.
+  uint64_t numRamRemoteNumaHits{0};
+  uint64_t numRamRemoteNumaAllocs{0};
+
   // number of nvm gets
   uint64_t numNvmGets{0};
 
@@ -470,6 +543,15 @@ struct GlobalCacheStats {
   // stats related to the reaper
   ReaperStats reaperStats;
 
+  // stats related to the background evictor
+  BackgroundEvictorStats backgroundEvictorStats;
+
+  // stats related to the slab compactor
+  SlabCompactorStats slabCompactorStats;
+
+  // compression of the values, over all the pools
+  ValueCompressionStats valueCompressionStats;
+
   uint64_t numNvmRejectsByExpiry{};
   uint64_t numNvmRejectsByClean{};
   uint64_t numNvmRejectsByAP{};
@@ -481,6 +563,35 @@ struct GlobalCacheStats {
   // Number of times slab release was aborted due to shutdown
   uint64_t numAbortedSlabReleases{0};
 
+  // number of items moved from each memory tier to the tier above it
+  std::vector<uint64_t> numTierPromotions;
+
+  // number of promotions out of each memory tier that could not complete
+  std::vector<uint64_t> numTierPromotionFailures;
+
+  // number of items moved from each memory tier to the tier below it
+  std::vector<uint64_t> numTierDemotions;
+
+  // number of items evicted out of each memory tier that the memory tier
+  // admission policy did not demote
+  std::vector<uint64_t> numTierDemotionRejectsByAP;
+
+  // number of allocation attempts in each memory tier
+  std::vector<uint64_t> numTierAllocAttempts;
+
+  // number of failed allocation attempts in each memory tier
+  std::vector<uint64_t> numTierAllocFailures;
+
+  // number of evictions out of each memory tier, including the ones that
+  // demoted the item to the tier below
+  std::vector<uint64_t> numTierEvictions;
+
+  // number of cache hits served from each memory tier
+  std::vector<uint64_t> numTierCacheHits;
+
+  // number of slabs released out of each memory tier
+  std::vector<uint64_t> numTierSlabReleases;
+
   // current active handles outstanding. This stat should
   // not go to negative. If it's negative, it means we have
   // leaked handles (or some sort of accounting bug internally)
@@ -54,6 +54,12 @@ struct Stats {
   // number of item destructor calls from ram
   TLCounter numRamDestructorCalls{0};
 
+  // number of ram hits and allocations from threads running on a numa node
+  // that the memory tier of the item is not placed on. Only counted for
+  // tiers with a numa policy.
+  TLCounter numRamRemoteNumaHits{0};
+  TLCounter numRamRemoteNumaAllocs{0};
+
   // number of nvm gets
   TLCounter numNvmGets{0};
 
@@ -204,6 +210,10 @@ struct Stats {
   // we're currently writing into flash.
   mutable util::PercentileStats nvmPutSize_;
 
+  // max number of memory tiers tracked by the per-tier stats. CacheAllocator
+  // checks that it covers CacheAllocatorConfig::kMaxCacheMemoryTiers.
+  static constexpr size_t kMaxTiers = 2;
+
   using PerPoolClassAtomicCounters =
       std::array<std::array<AtomicCounter, MemoryAllocator::kMaxClasses>,
                  MemoryPoolManager::kMaxPools>;
@@ -213,13 +223,19 @@ struct Stats {
       std::array<std::array<TLCounter, MemoryAllocator::kMaxClasses>,
                  MemoryPoolManager::kMaxPools>;
 
-  // hit count for every alloc class in every pool
-  std::unique_ptr<PerPoolClassTLCounters> cacheHits{};
-  std::unique_ptr<PerPoolClassAtomicCounters> allocAttempts{};
-  std::unique_ptr<PerPoolClassAtomicCounters> allocFailures{};
-  std::unique_ptr<PerPoolClassAtomicCounters> fragmentationSize{};
-  std::unique_ptr<PerPoolClassAtomicCounters> chainedItemEvictions{};
-  std::unique_ptr<PerPoolClassAtomicCounters> regularItemEvictions{};
+  // count of a stat for a specific allocation class in every memory tier
+  using PerTierPoolClassAtomicCounters =
+      std::array<PerPoolClassAtomicCounters, kMaxTiers>;
+  using PerTierPoolClassTLCounters =
+      std::array<PerPoolClassTLCounters, kMaxTiers>;
+
+  // hit count for every alloc class in every pool of every tier
+  std::unique_ptr<PerTierPoolClassTLCounters> cacheHits{};
+  std::unique_ptr<PerTierPoolClassAtomicCounters> allocAttempts{};
+  std::unique_ptr<PerTierPoolClassAtomicCounters> allocFailures{};
+  std::unique_ptr<PerTierPoolClassAtomicCounters> fragmentationSize{};
+  std::unique_ptr<PerTierPoolClassAtomicCounters> chainedItemEvictions{};
+  std::unique_ptr<PerTierPoolClassAtomicCounters> regularItemEvictions{};
 
   // Eviction failures due to parent cannot be removed from access container
   AtomicCounter evictFailParentAC{0};
@@ -240,6 +256,28 @@ struct Stats {
   // Eviction failures because this item is being moved
   AtomicCounter evictFailMove{0};
 
+  // count of a stat for a specific memory tier
+  using PerTierAtomicCounters = std::array<AtomicCounter, kMaxTiers>;
+
+  // items moved from a memory tier to the tier above it, indexed by the
+  // tier the item was moved out of
+  PerTierAtomicCounters numPromotions{};
+
+  // promotions out of a memory tier that could not be completed
+  PerTierAtomicCounters numPromotionFailures{};
+
+  // items moved from a memory tier to the tier below it on eviction, indexed
+  // by the tier the item was moved out of
+  PerTierAtomicCounters numDemotions{};
+
+  // evicted items the memory tier admission policy did not demote, indexed
+  // by the tier the item was evicted out of
+  PerTierAtomicCounters numDemotionRejectsByAP{};
+
+  // slabs released out of a memory tier for rebalancing, resizing or
+  // advising
+  PerTierAtomicCounters numSlabReleases{};
+
   void init();
 
   void populateGlobalCacheStats(GlobalCacheStats& ret) const;
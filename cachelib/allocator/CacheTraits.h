@@ -16,9 +16,12 @@
 
 #pragma once
 #include "cachelib/allocator/ChainedHashTable.h"
+#include "cachelib/allocator/ItemTimes.h"
 #include "cachelib/allocator/MM2Q.h"
+#include "cachelib/allocator/MMClock.h"
 #include "cachelib/allocator/MMLru.h"
 #include "cachelib/allocator/MMTinyLFU.h"
+#include "cachelib/allocator/TagHashTable.h"
 #include "cachelib/common/Mutex.h"
 
 namespace facebook {
@@ -31,6 +34,8 @@ namespace cachelib {
 // accessed.
 // AccessTypeLock is the lock type for the access container that supports
 // multiple locking primitives
+// A trait can also pick the layout of the creation and expiry time in the
+// item header with ItemTimesType. See ItemTimes.h
 struct LruCacheTrait {
   using MMType = MMLru;
   using AccessType = ChainedHashTable;
@@ -55,5 +60,24 @@ struct TinyLFUCacheTrait {
   using AccessTypeLocks = SharedMutexBuckets;
 };
 
+struct ClockCacheTrait {
+  using MMType = MMClock;
+  using AccessType = ChainedHashTable;
+  using AccessTypeLocks = SharedMutexBuckets;
+};
+
+struct LruCacheWithTagHashTableTrait {
+  using MMType = MMLru;
+  using AccessType = TagHashTable;
+  using AccessTypeLocks = SharedMutexBuckets;
+};
+
+struct LruCacheWithCompactItemTrait {
+  using MMType = MMLru;
+  using AccessType = ChainedHashTable;
+  using AccessTypeLocks = SharedMutexBuckets;
+  using ItemTimesType = CompactItemTimes;
+};
+
 } // namespace cachelib
 } // namespace facebook
@@ -15,6 +15,10 @@
  */
 
 #pragma once
+#include <folly/synchronization/SanitizeThread.h>
+
+#include <algorithm>
+#include <numeric>
 #include <stdexcept>
 
 #pragma GCC diagnostic push
@@ -84,10 +88,33 @@ ChainedHashTable::Impl<T, HookPtr>::getBucket(
 }
 
 template <typename T, typename ChainedHashTable::Hook<T> T::*HookPtr>
-bool ChainedHashTable::Impl<T, HookPtr>::insertInBucket(
-    T& node, BucketId bucket) noexcept {
+void ChainedHashTable::Impl<T, HookPtr>::prefetchBucketHead(
+    BucketId bucket, Tag tag) const noexcept {
+  XDCHECK_LT(bucket, numBuckets_);
+  // The bucket head is read racily here. Bucket heads are always updated as
+  // a whole, so we either observe the old or the new head and both are valid
+  // to prefetch. The caller looks the key up again under the lock.
+  folly::annotate_ignore_thread_sanitizer_guard g(__FILE__, __LINE__);
+  const auto headPtr = hashTable_[bucket];
+  const T* head = unCompressTagged(headPtr);
+  if (head == nullptr) {
+    return;
+  }
+  // the key is only compared if the tag matches. Otherwise the header is
+  // still needed to follow the chain.
+  if (tagsMayMatch(headPtr, tag)) {
+    prefetchNode(head);
+  } else {
+    __builtin_prefetch(head, 0 /* read */, 3 /* locality */);
+  }
+}
+
+template <typename T, typename ChainedHashTable::Hook<T> T::*HookPtr>
+bool ChainedHashTable::Impl<T, HookPtr>::insertInBucket(T& node,
+                                                        BucketId bucket,
+                                                        Tag tag) noexcept {
   XDCHECK_LT(bucket, numBuckets_);
-  const auto existing = findInBucket(node.getKey(), bucket);
+  const auto existing = findInBucket(node.getKey(), bucket, tag);
   if (existing != nullptr) {
     // already there
     return false;
@@ -95,41 +122,44 @@ bool ChainedHashTable::Impl<T, HookPtr>::insertInBucket(
 
   // insert at the head of the bucket
   const auto head = hashTable_[bucket];
-  hashTable_[bucket] = compressor_.compress(&node);
+  hashTable_[bucket] = compressTagged(node, tag);
   setHashNext(node, head);
   return true;
 }
 
 template <typename T, typename ChainedHashTable::Hook<T> T::*HookPtr>
 T* ChainedHashTable::Impl<T, HookPtr>::insertOrReplaceInBucket(
-    T& node, BucketId bucket) noexcept {
+    T& node, BucketId bucket, Tag tag) noexcept {
   XDCHECK_LT(bucket, numBuckets_);
 
   // See if we can find the key and the previous node
-  T* curr = compressor_.unCompress(hashTable_[bucket]);
+  CompressedPtr currPtr = hashTable_[bucket];
+  T* curr = unCompressTagged(currPtr);
   T* prev = nullptr;
 
   const auto key = node.getKey();
-  while (curr != nullptr && key != curr->getKey()) {
+  while (curr != nullptr &&
+         (!tagsMayMatch(currPtr, tag) || key != curr->getKey())) {
     prev = curr;
-    curr = getHashNext(*curr);
+    currPtr = getHashNextCompressed(*curr);
+    curr = unCompressTagged(currPtr);
   }
 
   // insert if the key doesn't exist
   if (!curr) {
     const auto head = hashTable_[bucket];
-    hashTable_[bucket] = compressor_.compress(&node);
+    hashTable_[bucket] = compressTagged(node, tag);
     setHashNext(node, head);
     return nullptr;
   }
 
   // replace
   if (prev) {
-    setHashNext(*prev, &node);
+    setHashNext(*prev, compressTagged(node, tag));
   } else {
-    hashTable_[bucket] = compressor_.compress(&node);
+    hashTable_[bucket] = compressTagged(node, tag);
   }
-  setHashNext(node, getHashNext(*curr));
+  setHashNext(node, getHashNextCompressed(*curr));
 
   return curr;
 }
@@ -138,41 +168,71 @@ template <typename T, typename ChainedHashTable::Hook<T> T::*HookPtr>
 void ChainedHashTable::Impl<T, HookPtr>::removeFromBucket(
     T& node, BucketId bucket) noexcept {
   // node must be present in hashtable.
-  XDCHECK_EQ(reinterpret_cast<uintptr_t>(findInBucket(node.getKey(), bucket)),
+  XDCHECK_EQ(reinterpret_cast<uintptr_t>(
+                 findInBucket(node.getKey(), bucket, kNoTag)),
              reinterpret_cast<uintptr_t>(&node))
       << node.toString();
 
   T* const prev = findPrevInBucket(node, bucket);
   if (prev != nullptr) {
-    setHashNext(*prev, getHashNext(node));
+    setHashNext(*prev, getHashNextCompressed(node));
   } else {
     XDCHECK_EQ(reinterpret_cast<uintptr_t>(&node),
                reinterpret_cast<uintptr_t>(
-                   compressor_.unCompress(hashTable_[bucket])));
+                   unCompressTagged(hashTable_[bucket])));
     hashTable_[bucket] = getHashNextCompressed(node);
   }
 }
 
+template <typename T, typename ChainedHashTable::Hook<T> T::*HookPtr>
+T* ChainedHashTable::Impl<T, HookPtr>::detachBucket(BucketId bucket) noexcept {
+  XDCHECK_LT(bucket, numBuckets_);
+  T* head = unCompressTagged(hashTable_[bucket]);
+  hashTable_[bucket] = CompressedPtr{};
+  return head;
+}
+
+template <typename T, typename ChainedHashTable::Hook<T> T::*HookPtr>
+void ChainedHashTable::Impl<T, HookPtr>::linkAtBucketHead(T& node,
+                                                          BucketId bucket,
+                                                          Tag tag) noexcept {
+  XDCHECK_LT(bucket, numBuckets_);
+  const auto head = hashTable_[bucket];
+  hashTable_[bucket] = compressTagged(node, tag);
+  setHashNext(node, head);
+}
+
 template <typename T, typename ChainedHashTable::Hook<T> T::*HookPtr>
 T* ChainedHashTable::Impl<T, HookPtr>::findInBucket(
-    Key key, BucketId bucket) const noexcept {
+    Key key, BucketId bucket, Tag tag) const noexcept {
   XDCHECK_LT(bucket, numBuckets_);
-  T* curr = compressor_.unCompress(hashTable_[bucket]);
-  while (curr != nullptr && curr->getKey() != key) {
-    curr = getHashNext(*curr);
+  CompressedPtr currPtr = hashTable_[bucket];
+  T* curr = unCompressTagged(currPtr);
+  while (curr != nullptr) {
+    // the pointer to the node carries its tag, so the key of a node whose
+    // tag does not match is never read. For the others, the header and the
+    // key are loaded together rather than one after the other.
+    if (tagsMayMatch(currPtr, tag)) {
+      prefetchNode(curr);
+      if (curr->getKey() == key) {
+        return curr;
+      }
+    }
+    currPtr = getHashNextCompressed(*curr);
+    curr = unCompressTagged(currPtr);
   }
-  return curr;
+  return nullptr;
 }
 
 template <typename T, typename ChainedHashTable::Hook<T> T::*HookPtr>
 T* ChainedHashTable::Impl<T, HookPtr>::findPrevInBucket(
     const T& node, BucketId bucket) const noexcept {
   XDCHECK_LT(bucket, numBuckets_);
-  T* curr = compressor_.unCompress(hashTable_[bucket]);
+  T* curr = unCompressTagged(hashTable_[bucket]);
   T* prev = nullptr;
 
-  const auto key = node.getKey();
-  while (curr != nullptr && key != curr->getKey()) {
+  // the node is in the bucket, so it can be found by its address.
+  while (curr != nullptr && curr != &node) {
     prev = curr;
     curr = getHashNext(*curr);
   }
@@ -186,7 +246,7 @@ template <typename F>
 void ChainedHashTable::Impl<T, HookPtr>::forEachBucketElem(BucketId bucket,
                                                            F&& func) const {
   XDCHECK_LT(bucket, numBuckets_);
-  T* curr = compressor_.unCompress(hashTable_[bucket]);
+  T* curr = unCompressTagged(hashTable_[bucket]);
 
   while (curr != nullptr) {
     func(curr);
@@ -199,7 +259,7 @@ unsigned int ChainedHashTable::Impl<T, HookPtr>::getBucketNumElems(
     BucketId bucket) const {
   XDCHECK_LT(bucket, numBuckets_);
 
-  T* curr = compressor_.unCompress(hashTable_[bucket]);
+  T* curr = unCompressTagged(hashTable_[bucket]);
 
   unsigned int numElems = 0;
   while (curr != nullptr) {
@@ -236,12 +296,36 @@ ChainedHashTable::Container<T, HookPtr, LockT>::Container(
     size_t nBytes,
     const PtrCompressor& compressor,
     HandleMaker hm)
+    : Container(
+          object,
+          config,
+          [&object, memStart, nBytes](uint32_t generation) {
+            if (generation !=
+                static_cast<uint32_t>(*object.tableGeneration_ref())) {
+              throw std::invalid_argument(
+                  "Hashtable can not be restored in the middle of a resize "
+                  "from a single memory region");
+            }
+            return ShmAddr{memStart, nBytes};
+          },
+          compressor,
+          std::move(hm)) {}
+
+template <typename T,
+          typename ChainedHashTable::Hook<T> T::*HookPtr,
+          typename LockT>
+ChainedHashTable::Container<T, HookPtr, LockT>::Container(
+    const serialization::ChainedHashTableObject& object,
+    const Config& config,
+    const std::function<ShmAddr(uint32_t generation)>& getMemory,
+    const PtrCompressor& compressor,
+    HandleMaker hm)
     : config_{config},
       handleMaker_(std::move(hm)),
-      ht_{config_.getNumBuckets(), memStart, compressor, config_.getHasher(),
-          false /* resetMem */},
+      compressor_(compressor),
       locks_{config_.getLocksPower(), config_.getHasher()},
-      numKeys_(*object.numKeys_ref()) {
+      numKeys_(*object.numKeys_ref()),
+      generation_(static_cast<uint32_t>(*object.tableGeneration_ref())) {
   if (config_.getBucketsPower() !=
       static_cast<uint32_t>(*object.bucketsPower_ref())) {
     throw std::invalid_argument(folly::sformat(
@@ -250,12 +334,36 @@ ChainedHashTable::Container<T, HookPtr, LockT>::Container(
         config.getBucketsPower()));
   }
 
-  if (nBytes != ht_.size()) {
-    throw std::invalid_argument(
-        folly::sformat("Hashtable size not compatible. old = {}, new = {}",
-                       ht_.size(),
-                       nBytes));
+  // the bucket power of the config is the one the hash table was created
+  // with. The table itself might have been grown since.
+  const unsigned int tablePower =
+      *object.tableBucketsPower_ref() != 0
+          ? static_cast<unsigned int>(*object.tableBucketsPower_ref())
+          : config_.getBucketsPower();
+  auto restoreTable = [&](unsigned int bucketsPower, uint32_t generation) {
+    const size_t numBuckets = static_cast<size_t>(1) << bucketsPower;
+    const auto memSegment = getMemory(generation);
+    if (memSegment.size != getRequiredSize(numBuckets)) {
+      throw std::invalid_argument(folly::sformat(
+          "Hashtable size not compatible. old = {}, new = {}",
+          getRequiredSize(numBuckets), memSegment.size));
+    }
+    return std::make_unique<Hashtable>(numBuckets, memSegment.addr,
+                                       compressor_, config_.getHasher(),
+                                       false /* resetMem */);
+  };
+
+  ht_ = restoreTable(tablePower, generation_);
+  if (*object.newBucketsPower_ref() != 0) {
+    newHt_ = restoreTable(
+        static_cast<unsigned int>(*object.newBucketsPower_ref()),
+        generation_ + 1);
+    resizeLockHolders_.reserve(config_.getNumLocks());
+    retiredHts_.reserve(1);
+    rehashIdx_ = static_cast<size_t>(*object.rehashIdx_ref());
+    resizing_ = true;
   }
+  activeHt_ = ht_.get();
 
   // checking hasher magic id not equal to 0 is to ensure it'll be
   // a warm roll going from a cachelib without hasher magic id to
@@ -302,17 +410,20 @@ ChainedHashTable::Container<T, HookPtr, LockT>::getDistributionStats() const {
 
   // compute the distribution
   std::map<unsigned int, uint64_t> distribution;
-  const auto numBuckets = ht_.getNumBuckets();
+  const auto numBuckets = getNumBuckets();
   for (BucketId currBucket = 0; currBucket < numBuckets; ++currBucket) {
     auto l = locks_.lockShared(currBucket);
-    ++distribution[ht_.getBucketNumElems(currBucket)];
+    forEachChainLocked(currBucket, numBuckets,
+                       [&distribution](const Hashtable& ht, BucketId bucket) {
+                         ++distribution[ht.getBucketNumElems(bucket)];
+                       });
   }
 
   // acquire lock
   statsLockGuard.lock();
   cachedStats_.numKeys = numKeys;
   cachedStats_.itemDistribution = std::move(distribution);
-  cachedStats_.numBuckets = ht_.getNumBuckets();
+  cachedStats_.numBuckets = numBuckets;
   cachedStatsUpdateTime_ = now;
   canRecomputeDistributionStats_ = true;
   return cachedStats_;
@@ -327,15 +438,20 @@ bool ChainedHashTable::Container<T, HookPtr, LockT>::insert(T& node) noexcept {
     return false;
   }
 
-  const auto bucket = ht_.getBucket(node.getKey());
-  auto l = locks_.lockExclusive(bucket);
-  const bool res = ht_.insertInBucket(node, bucket);
+  const auto hash = hashKey(node.getKey());
+  bool res;
+  {
+    auto l = locks_.lockExclusive(hash);
+    const auto [ht, bucket] = getBucketLocked(hash);
+    res = ht->insertInBucket(node, bucket, getTagForHash(hash));
 
-  if (res) {
-    node.markAccessible();
-    numKeys_.fetch_add(1, std::memory_order_relaxed);
+    if (res) {
+      node.markAccessible();
+      numKeys_.fetch_add(1, std::memory_order_relaxed);
+    }
   }
 
+  maybeRehash(hash);
   return res;
 }
 
@@ -348,35 +464,40 @@ ChainedHashTable::Container<T, HookPtr, LockT>::insertOrReplace(T& node) {
     return handleMaker_(nullptr);
   }
 
-  const auto bucket = ht_.getBucket(node.getKey());
-  auto l = locks_.lockExclusive(bucket);
-  T* oldNode = ht_.insertOrReplaceInBucket(node, bucket);
-  XDCHECK_NE(reinterpret_cast<uintptr_t>(&node),
-             reinterpret_cast<uintptr_t>(oldNode));
-
-  // grab a handle to the old node before we mark it as not being in the hash
-  // table.
+  const auto hash = hashKey(node.getKey());
   typename T::Handle handle;
-  try {
-    handle = handleMaker_(oldNode);
-  } catch (const std::exception&) {
-    // put the element back since we failed to grab handle.
-    ht_.insertOrReplaceInBucket(*oldNode, bucket);
-    XDCHECK_EQ(
-        reinterpret_cast<uintptr_t>(ht_.findInBucket(node.getKey(), bucket)),
-        reinterpret_cast<uintptr_t>(oldNode))
-        << oldNode->toString();
-    throw;
-  }
-
-  node.markAccessible();
-
-  if (oldNode) {
-    oldNode->unmarkAccessible();
-  } else {
-    numKeys_.fetch_add(1, std::memory_order_relaxed);
+  {
+    auto l = locks_.lockExclusive(hash);
+    const auto [ht, bucket] = getBucketLocked(hash);
+    T* oldNode =
+        ht->insertOrReplaceInBucket(node, bucket, getTagForHash(hash));
+    XDCHECK_NE(reinterpret_cast<uintptr_t>(&node),
+               reinterpret_cast<uintptr_t>(oldNode));
+
+    // grab a handle to the old node before we mark it as not being in the
+    // hash table.
+    try {
+      handle = handleMaker_(oldNode);
+    } catch (const std::exception&) {
+      // put the element back since we failed to grab handle.
+      ht->insertOrReplaceInBucket(*oldNode, bucket, getTagForHash(hash));
+      XDCHECK_EQ(reinterpret_cast<uintptr_t>(ht->findInBucket(
+                     node.getKey(), bucket, getTagForHash(hash))),
+                 reinterpret_cast<uintptr_t>(oldNode))
+          << oldNode->toString();
+      throw;
+    }
+
+    node.markAccessible();
+
+    if (oldNode) {
+      oldNode->unmarkAccessible();
+    } else {
+      numKeys_.fetch_add(1, std::memory_order_relaxed);
+    }
   }
 
+  maybeRehash(hash);
   return handle;
 }
 
@@ -395,12 +516,12 @@ template <typename F>
 bool ChainedHashTable::Container<T, HookPtr, LockT>::replaceIf(T& oldNode,
                                                                T& newNode,
                                                                F&& predicate) {
-  const auto key = newNode.getKey();
-  const auto bucket = ht_.getBucket(key);
-  auto l = locks_.lockExclusive(bucket);
+  const auto hash = hashKey(newNode.getKey());
+  auto l = locks_.lockExclusive(hash);
 
   if (oldNode.isAccessible() && predicate(oldNode)) {
-    ht_.insertOrReplaceInBucket(newNode, bucket);
+    const auto [ht, bucket] = getBucketLocked(hash);
+    ht->insertOrReplaceInBucket(newNode, bucket, getTagForHash(hash));
     oldNode.unmarkAccessible();
     newNode.markAccessible();
     return true;
@@ -412,15 +533,16 @@ template <typename T,
           typename ChainedHashTable::Hook<T> T::*HookPtr,
           typename LockT>
 bool ChainedHashTable::Container<T, HookPtr, LockT>::remove(T& node) noexcept {
-  const auto bucket = ht_.getBucket(node.getKey());
-  auto l = locks_.lockExclusive(bucket);
+  const auto hash = hashKey(node.getKey());
+  auto l = locks_.lockExclusive(hash);
 
   // check inside the lock to prevent from racing removes
   if (!node.isAccessible()) {
     return false;
   }
 
-  ht_.removeFromBucket(node, bucket);
+  const auto [ht, bucket] = getBucketLocked(hash);
+  ht->removeFromBucket(node, bucket);
   node.unmarkAccessible();
 
   numKeys_.fetch_sub(1, std::memory_order_relaxed);
@@ -432,8 +554,8 @@ template <typename T,
           typename LockT>
 typename T::Handle ChainedHashTable::Container<T, HookPtr, LockT>::removeIf(
     T& node, const std::function<bool(const T& node)>& predicate) {
-  const auto bucket = ht_.getBucket(node.getKey());
-  auto l = locks_.lockExclusive(bucket);
+  const auto hash = hashKey(node.getKey());
+  auto l = locks_.lockExclusive(hash);
 
   // check inside the lock to prevent from racing removes
   if (node.isAccessible() && predicate(node)) {
@@ -441,7 +563,8 @@ typename T::Handle ChainedHashTable::Container<T, HookPtr, LockT>::removeIf(
     // if handle maker throws an exception, we leave the item in a consistent
     // state.
     auto handle = handleMaker_(&node);
-    ht_.removeFromBucket(node, bucket);
+    const auto [ht, bucket] = getBucketLocked(hash);
+    ht->removeFromBucket(node, bucket);
     node.unmarkAccessible();
     numKeys_.fetch_sub(1, std::memory_order_relaxed);
     return handle;
@@ -455,9 +578,75 @@ template <typename T,
           typename LockT>
 typename T::Handle ChainedHashTable::Container<T, HookPtr, LockT>::find(
     Key key) const {
-  const auto bucket = ht_.getBucket(key);
-  auto l = locks_.lockShared(bucket);
-  return handleMaker_(ht_.findInBucket(key, bucket));
+  const auto hash = hashKey(key);
+  // load the bucket while the lock is being acquired. Without a resize in
+  // progress, this is the bucket the lookup reads.
+  {
+    folly::rcu_reader guard;
+    const Hashtable& activeHt = *activeHt_.load(std::memory_order_acquire);
+    activeHt.prefetchBucket(activeHt.getBucketForHash(hash));
+  }
+
+  auto l = locks_.lockShared(hash);
+  const auto [ht, bucket] = getBucketLocked(hash);
+  return handleMaker_(ht->findInBucket(key, bucket, getTagForHash(hash)));
+}
+
+template <typename T,
+          typename ChainedHashTable::Hook<T> T::*HookPtr,
+          typename LockT>
+std::vector<typename T::Handle>
+ChainedHashTable::Container<T, HookPtr, LockT>::findBatch(
+    folly::Range<const Key*> keys) const {
+  const size_t numKeys = keys.size();
+  std::vector<Handle> handles(numKeys);
+  if (numKeys == 0) {
+    return handles;
+  }
+
+  // hash all the keys up front and prefetch their buckets so that the loads
+  // of the bucket heads are in flight at the same time. While a resize is
+  // in progress, the prefetches go to the table being migrated from, which
+  // is only a hint for the keys in migrated buckets.
+  std::vector<uint32_t> hashes(numKeys);
+  {
+    folly::rcu_reader guard;
+    const Hashtable& activeHt = *activeHt_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < numKeys; ++i) {
+      hashes[i] = hashKey(keys[i]);
+      activeHt.prefetchBucket(activeHt.getBucketForHash(hashes[i]));
+    }
+
+    // by now the bucket heads are likely in cache. prefetch the header of
+    // the first node in every chain since that is where the key compare
+    // starts.
+    for (size_t i = 0; i < numKeys; ++i) {
+      activeHt.prefetchBucketHead(activeHt.getBucketForHash(hashes[i]),
+                                  getTagForHash(hashes[i]));
+    }
+  }
+
+  // group the keys by the lock stripe protecting their bucket so that each
+  // stripe is locked once for the whole batch.
+  const size_t locksMask = config_.getNumLocks() - 1;
+  std::vector<uint32_t> order(numKeys);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return (hashes[a] & locksMask) < (hashes[b] & locksMask);
+  });
+
+  size_t i = 0;
+  while (i < numKeys) {
+    const auto stripe = hashes[order[i]] & locksMask;
+    auto l = locks_.lockShared(hashes[order[i]]);
+    for (; i < numKeys && (hashes[order[i]] & locksMask) == stripe; ++i) {
+      const auto idx = order[i];
+      const auto [ht, bucket] = getBucketLocked(hashes[idx]);
+      handles[idx] = handleMaker_(
+          ht->findInBucket(keys[idx], bucket, getTagForHash(hashes[idx])));
+    }
+  }
+  return handles;
 }
 
 template <typename T,
@@ -465,7 +654,7 @@ template <typename T,
           typename LockT>
 serialization::ChainedHashTableObject
 ChainedHashTable::Container<T, HookPtr, LockT>::saveState() const {
-  if (!ht_.isRestorable()) {
+  if (!ht_->isRestorable()) {
     throw std::logic_error(
         "hashtable is not restorable since the memory is not managed by user");
   }
@@ -480,25 +669,240 @@ ChainedHashTable::Container<T, HookPtr, LockT>::saveState() const {
   *object.locksPower_ref() = config_.getLocksPower();
   *object.numKeys_ref() = numKeys_;
   *object.hasherMagicId_ref() = config_.getHasher()->getMagicId();
+  *object.tableBucketsPower_ref() = getHashpower();
+  *object.tableGeneration_ref() = generation_.load();
+  if (resizing_) {
+    *object.newBucketsPower_ref() =
+        folly::findLastSet(newHt_->getNumBuckets()) - 1;
+    *object.rehashIdx_ref() = rehashIdx_.load();
+  }
   return object;
 }
 
+template <typename T,
+          typename ChainedHashTable::Hook<T> T::*HookPtr,
+          typename LockT>
+void ChainedHashTable::Container<T, HookPtr, LockT>::startResize(
+    unsigned int bucketsPower,
+    const std::function<void*(uint32_t generation, size_t nBytes)>& getMemory,
+    const std::function<void(uint32_t generation)>& releaseMemory) {
+  std::lock_guard<std::mutex> l(resizeMutex_);
+  if (resizing_) {
+    throw std::invalid_argument("Hashtable is already being resized");
+  }
+
+  const auto currPower = getHashpower();
+  if (bucketsPower <= currPower || bucketsPower > Config::kMaxBucketPower) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid bucket power for resize. current = {}, new = {}", currPower,
+        bucketsPower));
+  }
+
+  if (ht_->isRestorable() != static_cast<bool>(getMemory)) {
+    throw std::invalid_argument(
+        ht_->isRestorable()
+            ? "Restorable hashtable needs user managed memory to resize"
+            : "Hashtable with local-managed memory can not resize into user "
+              "managed memory");
+  }
+
+  // free what the previous resize replaced before taking more memory.
+  freeRetiredTablesLocked(releaseMemory);
+
+  const size_t numBuckets = static_cast<size_t>(1) << bucketsPower;
+  if (getMemory) {
+    void* memStart = getMemory(generation_ + 1, getRequiredSize(numBuckets));
+    newHt_ = std::make_unique<Hashtable>(numBuckets, memStart, compressor_,
+                                         config_.getHasher(),
+                                         true /* resetMem */);
+  } else {
+    newHt_ = std::make_unique<Hashtable>(numBuckets, compressor_,
+                                         config_.getHasher());
+  }
+
+  // finishing the resize happens from inserts, which can not fail.
+  resizeLockHolders_.reserve(config_.getNumLocks());
+  retiredHts_.reserve(retiredHts_.size() + 1);
+
+  rehashIdx_.store(0, std::memory_order_relaxed);
+  // publishes newHt_ to readers that see the resize in progress.
+  resizing_.store(true, std::memory_order_release);
+}
+
+template <typename T,
+          typename ChainedHashTable::Hook<T> T::*HookPtr,
+          typename LockT>
+bool ChainedHashTable::Container<T, HookPtr, LockT>::rehashStep(
+    size_t numBuckets,
+    const std::function<void(uint32_t generation)>& releaseMemory) {
+  std::lock_guard<std::mutex> l(resizeMutex_);
+  if (!rehashLocked(numBuckets)) {
+    return false;
+  }
+  freeRetiredTablesLocked(releaseMemory);
+  return true;
+}
+
+template <typename T,
+          typename ChainedHashTable::Hook<T> T::*HookPtr,
+          typename LockT>
+void ChainedHashTable::Container<T, HookPtr, LockT>::maybeRehash(
+    uint32_t hash) noexcept {
+  if (!resizing_.load(std::memory_order_acquire) ||
+      hash % kRehashInsertSampleRate != 0) {
+    return;
+  }
+  // migrating is best effort from here. If someone else is at it already,
+  // the insert does not wait for them.
+  std::unique_lock<std::mutex> l(resizeMutex_, std::try_to_lock);
+  if (l.owns_lock()) {
+    rehashLocked(kRehashBucketsPerInsert);
+  }
+}
+
+template <typename T,
+          typename ChainedHashTable::Hook<T> T::*HookPtr,
+          typename LockT>
+bool ChainedHashTable::Container<T, HookPtr, LockT>::rehashLocked(
+    size_t numBuckets) noexcept {
+  if (!resizing_.load(std::memory_order_relaxed)) {
+    return true;
+  }
+
+  const size_t oldNumBuckets = ht_->getNumBuckets();
+  size_t idx = rehashIdx_.load(std::memory_order_relaxed);
+  const size_t end = std::min(oldNumBuckets, idx + numBuckets);
+  for (; idx < end; ++idx) {
+    // the keys of the bucket are spread to buckets that are congruent to it
+    // modulo the old number of buckets. They all share its lock.
+    auto l = locks_.lockExclusive(idx);
+    T* curr = ht_->detachBucket(idx);
+    while (curr != nullptr) {
+      T* next = ht_->getHashNext(*curr);
+      // this also tags the nodes of tables written before tags were added
+      const auto hash = hashKey(curr->getKey());
+      newHt_->linkAtBucketHead(*curr, newHt_->getBucketForHash(hash),
+                               getTagForHash(hash));
+      curr = next;
+    }
+    rehashIdx_.store(idx + 1, std::memory_order_release);
+  }
+
+  if (idx < oldNumBuckets) {
+    return false;
+  }
+  finishResizeLocked();
+  return true;
+}
+
+template <typename T,
+          typename ChainedHashTable::Hook<T> T::*HookPtr,
+          typename LockT>
+void ChainedHashTable::Container<T, HookPtr, LockT>::
+    finishResizeLocked() noexcept {
+  XDCHECK_EQ(rehashIdx_.load(), ht_->getNumBuckets());
+
+  // ht_ is read by everyone holding a lock, so swapping it needs all of
+  // them. The holders were reserved when the resize started.
+  const size_t numLocks = config_.getNumLocks();
+  for (size_t i = 0; i < numLocks; ++i) {
+    resizeLockHolders_.push_back(locks_.lockExclusive(i));
+  }
+
+  retiredHts_.push_back(
+      RetiredTable{generation_.load(std::memory_order_relaxed),
+                   std::move(ht_)});
+  ht_ = std::move(newHt_);
+  rehashIdx_.store(0, std::memory_order_relaxed);
+  resizing_.store(false, std::memory_order_release);
+  generation_.fetch_add(1, std::memory_order_release);
+  activeHt_.store(ht_.get(), std::memory_order_release);
+
+  resizeLockHolders_.clear();
+}
+
+template <typename T,
+          typename ChainedHashTable::Hook<T> T::*HookPtr,
+          typename LockT>
+void ChainedHashTable::Container<T, HookPtr, LockT>::freeRetiredTablesLocked(
+    const std::function<void(uint32_t generation)>& releaseMemory) {
+  if (retiredHts_.empty()) {
+    return;
+  }
+
+  // readers load activeHt_ before the table got replaced only from within
+  // an rcu read section. Once those are done, nobody can reach the retired
+  // tables anymore.
+  folly::synchronize_rcu();
+  for (auto& retired : retiredHts_) {
+    retired.table.reset();
+    if (releaseMemory) {
+      releaseMemory(retired.generation);
+    }
+  }
+  retiredHts_.clear();
+}
+
+template <typename T,
+          typename ChainedHashTable::Hook<T> T::*HookPtr,
+          typename LockT>
+std::pair<typename ChainedHashTable::Impl<T, HookPtr>*,
+          typename ChainedHashTable::Container<T, HookPtr, LockT>::BucketId>
+ChainedHashTable::Container<T, HookPtr, LockT>::getBucketLocked(
+    uint32_t hash) const noexcept {
+  // rehashIdx_ does not move past a bucket while its lock is held, so the
+  // key can not be migrated under our feet.
+  if (resizing_.load(std::memory_order_acquire) &&
+      ht_->getBucketForHash(hash) <
+          rehashIdx_.load(std::memory_order_acquire)) {
+    return {newHt_.get(), newHt_->getBucketForHash(hash)};
+  }
+  return {ht_.get(), ht_->getBucketForHash(hash)};
+}
+
+template <typename T,
+          typename ChainedHashTable::Hook<T> T::*HookPtr,
+          typename LockT>
+template <typename F>
+void ChainedHashTable::Container<T, HookPtr, LockT>::forEachChainLocked(
+    BucketId bucket, size_t numBuckets, F&& func) const {
+  // the table only grows, so numBuckets never exceeds its size.
+  const size_t oldNumBuckets = ht_->getNumBuckets();
+  XDCHECK_LE(numBuckets, oldNumBuckets);
+  const size_t migrated = resizing_.load(std::memory_order_acquire)
+                              ? rehashIdx_.load(std::memory_order_acquire)
+                              : 0;
+  for (BucketId b = bucket; b < oldNumBuckets; b += numBuckets) {
+    if (b < migrated) {
+      for (BucketId newBucket = b; newBucket < newHt_->getNumBuckets();
+           newBucket += oldNumBuckets) {
+        func(*newHt_, newBucket);
+      }
+    } else {
+      func(*ht_, b);
+    }
+  }
+}
+
 template <typename T,
           typename ChainedHashTable::Hook<T> T::*HookPtr,
           typename LockT>
 void ChainedHashTable::Container<T, HookPtr, LockT>::getBucketElems(
-    BucketId bucket, std::vector<Handle>& handles) const {
+    BucketId bucket, size_t numBuckets, std::vector<Handle>& handles) const {
   handles.clear();
   auto l = locks_.lockShared(bucket);
 
-  ht_.forEachBucketElem(bucket, [this, &handles](T* e) {
-    try {
-      XDCHECK(e);
-      handles.emplace_back(handleMaker_(e));
-    } catch (const std::exception&) {
-      // if we are not able to acquire a handle, skip over them.
-    }
-  });
+  forEachChainLocked(
+      bucket, numBuckets, [this, &handles](const Hashtable& ht, BucketId b) {
+        ht.forEachBucketElem(b, [this, &handles](T* e) {
+          try {
+            XDCHECK(e);
+            handles.emplace_back(handleMaker_(e));
+          } catch (const std::exception&) {
+            // if we are not able to acquire a handle, skip over them.
+          }
+        });
+      });
 }
 
 // Container's Iterator
@@ -517,9 +921,14 @@ ChainedHashTable::Container<T, HookPtr, LockT>::Iterator::operator++() {
     return *this;
   }
 
+  if (currBucket_ == kEndBucket) {
+    curSor_ = 0;
+    return *this;
+  }
+
   ++currBucket_;
-  for (; currBucket_ < container_->config_.getNumBuckets(); ++currBucket_) {
-    container_->getBucketElems(currBucket_, bucketElems_);
+  for (; currBucket_ < numBuckets_; ++currBucket_) {
+    container_->getBucketElems(currBucket_, numBuckets_, bucketElems_);
     if (!bucketElems_.empty()) {
       curSor_ = 0;
       return *this;
@@ -530,6 +939,7 @@ ChainedHashTable::Container<T, HookPtr, LockT>::Iterator::operator++() {
 
   // reach the end
   bucketElems_.clear();
+  currBucket_ = kEndBucket;
   curSor_ = 0;
   return *this;
 }
@@ -564,6 +974,7 @@ ChainedHashTable::Container<T, HookPtr, LockT>::Iterator::Iterator(
     Iterator&& other) noexcept
     : container_{other.container_},
       currBucket_{other.currBucket_},
+      numBuckets_{other.numBuckets_},
       curSor_{other.curSor_},
       bucketElems_(std::move(other.bucketElems_)) {
   // increment the iterator count when we move.
@@ -588,7 +999,7 @@ template <typename T,
           typename LockT>
 ChainedHashTable::Container<T, HookPtr, LockT>::Iterator::Iterator(
     Container<T, HookPtr, LockT>& container, EndIterT)
-    : container_(&container), currBucket_{container_->config_.getNumBuckets()} {
+    : container_(&container), currBucket_{kEndBucket} {
   // increment the iterator for both the end and begin() types so that the
   // destructor can just blindly decrement.
   ++container_->numIterators_;
@@ -610,13 +1021,16 @@ template <typename T,
 void ChainedHashTable::Container<T, HookPtr, LockT>::Iterator::reset() {
   curSor_ = 0;
   currBucket_ = 0;
-  container_->getBucketElems(currBucket_, bucketElems_);
-  while (bucketElems_.empty() &&
-         ++currBucket_ < container_->config_.getNumBuckets()) {
+  numBuckets_ = container_->getNumBuckets();
+  container_->getBucketElems(currBucket_, numBuckets_, bucketElems_);
+  while (bucketElems_.empty() && ++currBucket_ < numBuckets_) {
     if (throttler_) {
       throttler_->throttle();
     }
-    container_->getBucketElems(currBucket_, bucketElems_);
+    container_->getBucketElems(currBucket_, numBuckets_, bucketElems_);
+  }
+  if (bucketElems_.empty()) {
+    currBucket_ = kEndBucket;
   }
   XDCHECK_EQ(0u, curSor_);
 }
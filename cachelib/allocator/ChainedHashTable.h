@@ -17,10 +17,17 @@
 #pragma once
 
 #include <folly/Optional.h>
+#include <folly/lang/Bits.h>
+#include <folly/synchronization/Rcu.h>
 
+#include <atomic>
 #include <cstdint>
+#include <functional>
+#include <limits>
 #include <map>
+#include <mutex>
 #include <type_traits>
+#include <vector>
 
 #include "cachelib/allocator/Cache.h"
 #include "cachelib/allocator/memory/serialize/gen-cpp2/objects_types.h"
@@ -47,7 +54,88 @@ class ChainedHashTable {
   template <typename T>
   struct Hook;
 
+  // The pointers to a node, in its bucket or in the hook of the previous
+  // node of its chain, carry a compare tag in their top byte. The tag comes
+  // from the bits of the key's hash that do not select the bucket, so a
+  // chain walk only compares the keys of the nodes whose tag matches, and
+  // knows whether a node is a candidate before loading it. Tables written
+  // before tags were added are not restored, which kCacheRamFormatVersion
+  // ensures.
+  using Tag = uint8_t;
+
+  // tag to look up a key without its hash. It matches every node and is
+  // never the tag of a pointer to a node.
+  static constexpr Tag kNoTag = 0;
+
+  // @return the tag of the keys with this hash, never kNoTag
+  static Tag getTagForHash(uint32_t hash) noexcept {
+    const auto tag = static_cast<Tag>(hash >> 24);
+    return tag == kNoTag ? 1 : tag;
+  }
+
+  // @return whether the pointer might point to a node with a key that has
+  //         the tag. Plain pointers carry no tag and always might.
+  template <typename CompressedPtrT>
+  static bool tagsMayMatch(CompressedPtrT ptr, Tag keyTag) noexcept {
+    if constexpr (std::is_pointer_v<CompressedPtrT>) {
+      return true;
+    } else {
+      return keyTag == kNoTag || getTag(ptr) == keyTag;
+    }
+  }
+
+  // Nodes that are linked by plain pointers have no room for a tag and are
+  // always compared.
+  template <typename CompressedPtrT>
+  static CompressedPtrT withTag(CompressedPtrT ptr, Tag tag) noexcept {
+    if constexpr (std::is_pointer_v<CompressedPtrT>) {
+      return ptr;
+    } else {
+      if (ptr.isNull()) {
+        return ptr;
+      }
+      static_assert(std::numeric_limits<Tag>::digits <=
+                        CompressedPtrT::kNumFreeTopBits,
+                    "the tag must not overlap the tier id of the pointer");
+      using Raw = typename CompressedPtrT::PtrType;
+      using Serialized = typename CompressedPtrT::SerializedPtrType;
+      const Raw raw = (ptr.getRaw() & ~kTagMask<CompressedPtrT>) |
+                      (static_cast<Raw>(tag) << kTagShift<CompressedPtrT>);
+      return CompressedPtrT{static_cast<Serialized>(raw)};
+    }
+  }
+
+  template <typename CompressedPtrT>
+  static CompressedPtrT withoutTag(CompressedPtrT ptr) noexcept {
+    if constexpr (std::is_pointer_v<CompressedPtrT>) {
+      return ptr;
+    } else {
+      using Serialized = typename CompressedPtrT::SerializedPtrType;
+      return CompressedPtrT{
+          static_cast<Serialized>(ptr.getRaw() & ~kTagMask<CompressedPtrT>)};
+    }
+  }
+
+  template <typename CompressedPtrT>
+  static Tag getTag(CompressedPtrT ptr) noexcept {
+    if constexpr (std::is_pointer_v<CompressedPtrT>) {
+      return kNoTag;
+    } else {
+      return static_cast<Tag>(ptr.getRaw() >> kTagShift<CompressedPtrT>);
+    }
+  }
+
  private:
+  template <typename CompressedPtrT>
+  static constexpr unsigned int kTagShift =
+      CompressedPtrT::kNumBits - std::numeric_limits<Tag>::digits;
+
+  template <typename CompressedPtrT>
+  static constexpr typename CompressedPtrT::PtrType kTagMask =
+      static_cast<typename CompressedPtrT::PtrType>(
+          std::numeric_limits<Tag>::max())
+      << kTagShift<CompressedPtrT>;
+
   // Implements a hash table with chaining.
   template <typename T, Hook<T> T::*HookPtr>
   class Impl {
@@ -92,6 +180,7 @@ class ChainedHashTable {
       return (node.*HookPtr).getHashNext(compressor_);
     }
 
+    // @return the pointer to the next node, with its tag
     CompressedPtr getHashNextCompressed(const T& node) const noexcept {
       return (node.*HookPtr).getHashNext();
     }
@@ -108,17 +197,19 @@ class ChainedHashTable {
     //
     // @param node    node to be inserted into the hashtable
     // @param bucket  the hashtable bucket that the node belongs to
+    // @param tag     the tag of the node's key
     // @return  True if the insertion was success. False if not. Insertion
     //          fails if there is already a node with similar key in the
     //          hashtable.
-    bool insertInBucket(T& node, BucketId bucket) noexcept;
+    bool insertInBucket(T& node, BucketId bucket, Tag tag) noexcept;
 
     // inserts or replaces the element into the bucket.
     //
     // @param node    node to be inserted into the hashtable
     // @param bucket  the hashtable bucket that the node belongs to
+    // @param tag     the tag of the node's key
     // @return  old node if it exists, nullptr otherwise
-    T* insertOrReplaceInBucket(T& node, BucketId bucket) noexcept;
+    T* insertOrReplaceInBucket(T& node, BucketId bucket, Tag tag) noexcept;
 
     // removes the node from the bucket.
     //
@@ -132,13 +223,46 @@ class ChainedHashTable {
     //
     // @param key     the key for the node we are looking for.
     // @param bucket  the hashtable bucket that the key belongs to
+    // @param tag     the tag of the key. kNoTag compares every key.
     // @return  a T* corresponding to the node or nullptr if there is no such
     //          node with the key in the bucket.
-    T* findInBucket(Key key, BucketId bucket) const noexcept;
+    T* findInBucket(Key key, BucketId bucket, Tag tag) const noexcept;
 
     // gets the bucket for the key by using the corresponding hash function.
     BucketId getBucket(Key k) const noexcept;
 
+    // gets the bucket for a hash value of a key.
+    BucketId getBucketForHash(uint32_t hash) const noexcept {
+      return hash & numBucketsMask_;
+    }
+
+    // empties the bucket and returns the chain that was in it.
+    //
+    // @param bucket  the hashtable bucket to empty
+    // @return  the head of the chain, linked through the hooks of the nodes
+    T* detachBucket(BucketId bucket) noexcept;
+
+    // links the node at the head of the bucket without looking for a node
+    // with the same key.
+    //
+    // precondition:  the key of the node is not in the bucket.
+    // @param node    node to be linked into the hashtable
+    // @param bucket  the hashtable bucket that the node belongs to
+    // @param tag     the tag of the node's key
+    void linkAtBucketHead(T& node, BucketId bucket, Tag tag) noexcept;
+
+    // issue a prefetch for the memory holding the head of the bucket.
+    void prefetchBucket(BucketId bucket) const noexcept {
+      XDCHECK_LT(bucket, numBuckets_);
+      __builtin_prefetch(&hashTable_[bucket], 0 /* read */, 3 /* locality */);
+    }
+
+    // issue a prefetch for the header of the first node in the bucket, and
+    // for its key if the node's tag matches. This reads the bucket head
+    // without holding the bucket lock, so it must only be used as a hint and
+    // the result re-validated under the lock.
+    void prefetchBucketHead(BucketId bucket, Tag tag) const noexcept;
+
     // Call 'func' on each element in the given bucket.
     //
     // @param bucket  the bucket id to fetch.
@@ -160,6 +284,24 @@ class ChainedHashTable {
     size_t getNumBuckets() const noexcept { return numBuckets_; }
 
    private:
+    // @return the node the tagged pointer points to
+    T* unCompressTagged(CompressedPtr ptr) const noexcept {
+      return compressor_.unCompress(withoutTag(ptr));
+    }
+
+    // @return the tagged pointer to the node
+    CompressedPtr compressTagged(T& node, Tag tag) const noexcept {
+      return withTag(compressor_.compress(&node), tag);
+    }
+
+    // prefetch the cache lines of the node that a lookup reads: the header
+    // with the hooks and the start of the key that follows it.
+    static void prefetchNode(const T* node) noexcept {
+      __builtin_prefetch(node, 0 /* read */, 3 /* locality */);
+      __builtin_prefetch(reinterpret_cast<const char*>(node) + sizeof(T),
+                         0 /* read */, 3 /* locality */);
+    }
+
     // finds the previous node in the hash chain for this node if one exists
     // such that prev->next is node.
     //
@@ -207,9 +349,10 @@ class ChainedHashTable {
 
     // gets the next in hash chain for this node.
     T* getHashNext(const PtrCompressor& compressor) const noexcept {
-      return compressor.unCompress(next_);
+      return compressor.unCompress(ChainedHashTable::withoutTag(next_));
     }
 
+    // gets the pointer to the next in hash chain, with its compare tag.
     CompressedPtr getHashNext() const noexcept { return next_; }
 
    private:
@@ -263,6 +406,10 @@ class ChainedHashTable {
     Config(const Config&) = default;
     Config& operator=(const Config&) = default;
 
+    // 4 billion buckets should be good enough for everyone.
+    static constexpr unsigned int kMaxBucketPower = 32;
+    static constexpr unsigned int kMaxLockPower = 32;
+
     size_t getNumBuckets() const noexcept {
       return static_cast<size_t>(1) << bucketsPower_;
     }
@@ -301,10 +448,6 @@ class ChainedHashTable {
     PageSizeT getPageSize() const { return pageSize_; }
 
    private:
-    // 4 billion buckets should be good enough for everyone.
-    static constexpr unsigned int kMaxBucketPower = 32;
-    static constexpr unsigned int kMaxLockPower = 32;
-
     // The following are expressed as powers of two to make the modulo
     // arithmetic simpler.
 
@@ -319,9 +462,23 @@ class ChainedHashTable {
     Hasher hasher_ = std::make_shared<MurmurHash2>();
   };
 
+  // @return  a config with the buckets and locks sized for the number of
+  //          entries.
+  static Config makeConfig(size_t numEntries) {
+    Config config{};
+    config.sizeBucketsPowerAndLocksPower(numEntries);
+    return config;
+  }
+
   // Interface for the Container that implements a hash table. Maintains
   // the node's isInAccessContainer state. T must implement an interface to
   // markAccessible(), unmarkAccessible() and isAccessible().
+  //
+  // The hash table can be grown online. A resize allocates a second bucket
+  // array and moves the chains over one bucket at a time, driven by inserts
+  // and by rehashStep(). A key lives either in its old bucket or, once that
+  // bucket was migrated, in the new one. Both tables cover the same lock
+  // stripes, so a migrated bucket is protected by the same lock as before.
   template <typename T,
             Hook<T> T::*HookPtr,
             typename LockT = facebook::cachelib::SharedMutexBuckets>
@@ -352,8 +509,11 @@ class ChainedHashTable {
               HandleMaker hm = kDefaultHandleMaker)
         : config_(std::move(c)),
           handleMaker_(std::move(hm)),
-          ht_{config_.getNumBuckets(), compressor, config_.getHasher()},
-          locks_{config_.getLocksPower(), config_.getHasher()} {}
+          compressor_(compressor),
+          ht_{std::make_unique<Hashtable>(
+              config_.getNumBuckets(), compressor_, config_.getHasher())},
+          locks_{config_.getLocksPower(), config_.getHasher()},
+          activeHt_{ht_.get()} {}
 
     // create hash table container with user-managed memory
     //
@@ -367,9 +527,14 @@ class ChainedHashTable {
               HandleMaker hm = kDefaultHandleMaker)
         : config_(std::move(c)),
           handleMaker_(std::move(hm)),
-          ht_{config_.getNumBuckets(), memStart, compressor,
-              config_.getHasher(), true /* resetMem */},
-          locks_{config_.getLocksPower(), config_.getHasher()} {}
+          compressor_(compressor),
+          ht_{std::make_unique<Hashtable>(config_.getNumBuckets(),
+                                          memStart,
+                                          compressor_,
+                                          config_.getHasher(),
+                                          true /* resetMem */)},
+          locks_{config_.getLocksPower(), config_.getHasher()},
+          activeHt_{ht_.get()} {}
 
     // restore hash table from serialized data.
     //
@@ -400,7 +565,8 @@ class ChainedHashTable {
     //
     // @throw std::invalid argument if the bucket power in new config does not
     //        match the previous state or the size of the memSegment does not
-    //        match the old state.
+    //        match the old state, or if the hash table was saved in the
+    //        middle of a resize.
     Container(const serialization::ChainedHashTableObject& object,
               const Config& newConfig,
               void* memStart,
@@ -408,6 +574,27 @@ class ChainedHashTable {
               const PtrCompressor& compressor,
               HandleMaker hm = kDefaultHandleMaker);
 
+    // restore hash table from previous state, including a resize that was
+    // in progress when the state was saved. This only works when the hash
+    // table memory is managed by the user.
+    //
+    // @param object      serialized object
+    // @param newConfig   the new set of configurations
+    // @param getMemory   returns the memory of the buckets of the given
+    //                    generation of the hash table. See
+    //                    getTableGeneration().
+    // @param compressor  object used to compress/decompress node pointers
+    // @param hm          the functor that creates a Handle from T*
+    //
+    // @throw std::invalid argument if the bucket power in new config does not
+    //        match the previous state or the size of the memory does not
+    //        match the old state.
+    Container(const serialization::ChainedHashTableObject& object,
+              const Config& newConfig,
+              const std::function<ShmAddr(uint32_t generation)>& getMemory,
+              const PtrCompressor& compressor,
+              HandleMaker hm = kDefaultHandleMaker);
+
     Container(const Container&) = delete;
     Container& operator=(const Container&) = delete;
 
@@ -490,6 +677,22 @@ class ChainedHashTable {
     //        creating this item handle.
     Handle find(Key key) const;
 
+    // finds the nodes corresponding to a batch of keys. All keys are hashed
+    // first and their bucket heads and first nodes are prefetched before any
+    // chain is walked, so that the cache misses for the batch overlap. Keys
+    // are then looked up grouped by lock stripe, taking each stripe's lock
+    // only once.
+    //
+    // @param keys  the lookup keys
+    //
+    // @return  a vector of the same size as keys where the i-th handle
+    //          corresponds to keys[i] and is a Handle with nullptr if the key
+    //          is not present.
+    //
+    // @throw std::overflow_error is the maximum item refcount is execeeded by
+    //        creating one of the item handles.
+    std::vector<Handle> findBatch(folly::Range<const Key*> keys) const;
+
     // for saving the state of the hash table
     //
     // precondition:  serialization must happen without any reader or writer
@@ -507,8 +710,65 @@ class ChainedHashTable {
 
     const Config& getConfig() const noexcept { return config_; }
 
+    // the number of buckets in base 2 logarithm. This is the bucket power
+    // of the config until the hash table is resized.
     unsigned int getHashpower() const noexcept {
-      return config_.getBucketsPower();
+      return folly::findLastSet(getNumBuckets()) - 1;
+    }
+
+    // the number of buckets the keys are spread over. While a resize is in
+    // progress, this is the number of buckets before the resize.
+    size_t getNumBuckets() const noexcept {
+      folly::rcu_reader guard;
+      return activeHt_.load(std::memory_order_acquire)->getNumBuckets();
+    }
+
+    // starts growing the hash table to a larger number of buckets. The
+    // buckets are migrated by subsequent inserts and by rehashStep(). All
+    // keys remain accessible while the resize is in progress.
+    //
+    // @param bucketsPower  the new number of buckets in base 2 logarithm
+    // @param getMemory     if the hash table memory is managed by the user,
+    //                      returns the memory for the new buckets, given the
+    //                      generation of the new table and the required
+    //                      size. Must be empty if the hash table manages its
+    //                      own memory.
+    // @param releaseMemory called with the generation of the buckets
+    //                      replaced by a finished resize once no reader can
+    //                      access them anymore. Until then, their memory
+    //                      must remain valid.
+    //
+    // @throw std::invalid_argument if a resize is already in progress, if
+    //        bucketsPower is not larger than the current one, or if
+    //        getMemory does not match how the memory is managed.
+    void startResize(
+        unsigned int bucketsPower,
+        const std::function<void*(uint32_t generation, size_t nBytes)>&
+            getMemory = nullptr,
+        const std::function<void(uint32_t generation)>& releaseMemory =
+            nullptr);
+
+    // migrates up to numBuckets buckets of the resize in progress and
+    // finishes the resize once all of them are migrated. The buckets that
+    // a finished resize replaced are freed here, waiting for the lock free
+    // readers still accessing them.
+    //
+    // @param releaseMemory  see startResize()
+    // @return  true if there is no resize in progress after this call.
+    bool rehashStep(size_t numBuckets,
+                    const std::function<void(uint32_t generation)>&
+                        releaseMemory = nullptr);
+
+    // true if a resize is in progress
+    bool isResizing() const noexcept {
+      return resizing_.load(std::memory_order_acquire);
+    }
+
+    // the number of resizes the hash table went through, counting the one
+    // in progress as not done yet. The buckets of a resize in progress
+    // belong to the next generation.
+    uint32_t getTableGeneration() const noexcept {
+      return generation_.load(std::memory_order_acquire);
     }
 
     // Iterator interface for the hashtable. Iterates over the hashtable
@@ -560,6 +820,11 @@ class ChainedHashTable {
       // container for the iterator
       using C = Container<T, HookPtr, LockT>;
 
+      // current bucket of an iterator that reached the end. This does not
+      // depend on the number of buckets, which can grow while iterating.
+      static constexpr BucketId kEndBucket =
+          std::numeric_limits<BucketId>::max();
+
       // construct an iterator with the given
       friend C;
       explicit Iterator(C& ht,
@@ -574,6 +839,11 @@ class ChainedHashTable {
       // current bucket that the iterator is pointing to.
       BucketId currBucket_{0};
 
+      // number of buckets when the iteration started. If the hash table is
+      // resized while iterating, each of these covers all the buckets that
+      // its keys were spread to.
+      size_t numBuckets_{0};
+
       // cursor into the current bucket.
       unsigned int curSor_{0};
 
@@ -592,7 +862,7 @@ class ChainedHashTable {
             "Iterator in invalid state with curSor_: " +
             folly::to<std::string>(curSor_) + ", currBucket_: " +
             folly::to<std::string>(currBucket_) + ", total buckets: " +
-            folly::to<std::string>(container_->config_.getNumBuckets()));
+            folly::to<std::string>(numBuckets_));
       }
     };
 
@@ -627,7 +897,7 @@ class ChainedHashTable {
 
     // lightweight stats that give the number of keys and buckets inside the
     // container. This is guaranteed to be fast.
-    Stats getStats() const noexcept { return {numKeys_, ht_.getNumBuckets()}; }
+    Stats getStats() const noexcept { return {numKeys_, getNumBuckets()}; }
 
     // Get the total number of keys inserted into the hash table
     uint64_t getNumKeys() const noexcept { return numKeys_; }
@@ -635,11 +905,67 @@ class ChainedHashTable {
    private:
     using Hashtable = Impl<T, HookPtr>;
 
+    // while a resize is in progress, one in this many inserts migrates
+    // buckets. The inserts are picked by the hash of their key so that they
+    // do not all contend for the resize mutex.
+    static constexpr uint32_t kRehashInsertSampleRate = 16;
+
+    // number of buckets migrated by a picked insert
+    static constexpr size_t kRehashBucketsPerInsert = 64;
+
     // Fetch a vector of handle to the items belonging to a given bucket. This
     // is for use by the iterator. 'handles' will be cleared and then populated
     // with handles for the items in the given bucket. Items will be skipped if
     // the handle cannot be acquired for any reason.
-    void getBucketElems(BucketId bucket, std::vector<Handle>& handles) const;
+    //
+    // @param bucket      the bucket to fetch
+    // @param numBuckets  the number of buckets the iteration is over. All
+    //                    the buckets that the keys of the bucket were spread
+    //                    to by resizing are fetched.
+    void getBucketElems(BucketId bucket,
+                        size_t numBuckets,
+                        std::vector<Handle>& handles) const;
+
+    uint32_t hashKey(Key key) const noexcept {
+      return (*config_.getHasher())(key.data(), key.size());
+    }
+
+    // finds the table and the bucket that hold the chain for the hash.
+    //
+    // precondition:  the lock for the hash is held.
+    std::pair<Hashtable*, BucketId> getBucketLocked(
+        uint32_t hash) const noexcept;
+
+    // calls func(table, bucket) on every chain of the keys that fall into
+    // the given bucket out of numBuckets.
+    //
+    // precondition:  the lock for the bucket is held and numBuckets is at
+    // least the number of locks.
+    template <typename F>
+    void forEachChainLocked(BucketId bucket, size_t numBuckets, F&& func) const;
+
+    // migrates some buckets if a resize is in progress, the insert of the
+    // hash is picked for it and nobody else is migrating already.
+    void maybeRehash(uint32_t hash) noexcept;
+
+    // migrates up to numBuckets buckets and finishes the resize once all of
+    // them are migrated.
+    //
+    // precondition:  resizeMutex_ is held.
+    // @return  true if there is no resize in progress after this call.
+    bool rehashLocked(size_t numBuckets) noexcept;
+
+    // makes the new table the current one while holding all the locks.
+    //
+    // precondition:  resizeMutex_ is held and all buckets are migrated.
+    void finishResizeLocked() noexcept;
+
+    // frees the tables replaced by finished resizes once the lock free
+    // readers that might access them are done.
+    //
+    // precondition:  resizeMutex_ is held.
+    void freeRetiredTablesLocked(
+        const std::function<void(uint32_t generation)>& releaseMemory);
 
     // config for the hash table.
     const Config config_{};
@@ -647,8 +973,13 @@ class ChainedHashTable {
     // handle maker to convert the T* to T::Handle
     HandleMaker handleMaker_;
 
-    // the hashtable buckets
-    Hashtable ht_;
+    // object used to compress/decompress node pointers
+    const PtrCompressor compressor_;
+
+    // the hashtable buckets. While a resize is in progress, these are the
+    // buckets being migrated from. Replaced only while holding all the
+    // locks.
+    std::unique_ptr<Hashtable> ht_;
 
     // locks protecting the hashtable buckets
     mutable LockT locks_;
@@ -670,6 +1001,42 @@ class ChainedHashTable {
 
     // number of the keys stored in this hash table
     std::atomic<uint64_t> numKeys_{0};
+
+    // ht_ published for readers that do not hold a lock. They access it
+    // from within an rcu read section only.
+    std::atomic<Hashtable*> activeHt_{nullptr};
+
+    // the buckets being grown into while a resize is in progress.
+    std::unique_ptr<Hashtable> newHt_;
+
+    // a table replaced by a finished resize along with its generation
+    struct RetiredTable {
+      uint32_t generation;
+      std::unique_ptr<Hashtable> table;
+    };
+
+    // tables replaced by finished resizes. Lock free readers might still
+    // access them, so they are freed by the next rehashStep() or
+    // startResize() after the readers are done.
+    std::vector<RetiredTable> retiredHts_;
+
+    // holders for all the locks, reserved when a resize starts so that
+    // finishing it does not allocate.
+    std::vector<typename LockT::WriteLockHolder> resizeLockHolders_;
+
+    // set once newHt_ is ready and cleared once it replaced ht_.
+    std::atomic<bool> resizing_{false};
+
+    // buckets of ht_ below this one are migrated to newHt_. Only advanced
+    // while holding the lock of the bucket being migrated.
+    std::atomic<size_t> rehashIdx_{0};
+
+    // number of finished resizes
+    std::atomic<uint32_t> generation_{0};
+
+    // serializes starting, migrating and finishing resizes and freeing the
+    // retired tables
+    mutable std::mutex resizeMutex_;
   };
 };
 
@@ -16,8 +16,10 @@
 
 #include "cachelib/allocator/ChainedHashTable.h"
 #include "cachelib/allocator/MM2Q.h"
+#include "cachelib/allocator/MMClock.h"
 #include "cachelib/allocator/MMLru.h"
 #include "cachelib/allocator/MMTinyLFU.h"
+#include "cachelib/allocator/TagHashTable.h"
 namespace facebook {
 namespace cachelib {
 // Types of AccessContainer and MMContainer
@@ -25,8 +27,10 @@ namespace cachelib {
 const int MMLru::kId = 1;
 const int MM2Q::kId = 2;
 const int MMTinyLFU::kId = 3;
+const int MMClock::kId = 4;
 
 // AccessType
 const int ChainedHashTable::kId = 1;
+const int TagHashTable::kId = 2;
 } // namespace cachelib
 } // namespace facebook
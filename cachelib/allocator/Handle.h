@@ -17,6 +17,8 @@
 #pragma once
 
 #include <folly/Function.h>
+#include <folly/Portability.h>
+#include <folly/experimental/coro/Coroutine.h>
 #include <folly/fibers/Baton.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
@@ -191,6 +193,37 @@ struct ReadHandleImpl {
 
   using ReadyCallback = folly::Function<void(ReadHandleImpl)>;
 
+#if FOLLY_HAS_COROUTINES
+  // Awaiter for a handle, returned by `co_await std::move(handle)`. If the
+  // handle is not ready, the coroutine is suspended and resumed by the thread
+  // that fulfills the handle, without blocking a thread or allocating a
+  // promise like toSemiFuture() does. A folly::coro::Task resumes on its own
+  // executor afterwards. The handle is moved back to the coroutine, so there
+  // is no handle count to adjust.
+  template <typename HandleT>
+  class Awaiter {
+   public:
+    explicit Awaiter(HandleT&& hdl) noexcept : hdl_(std::move(hdl)) {}
+
+    bool await_ready() const noexcept { return hdl_.isReady(); }
+
+    // @return false if the handle became ready in the meantime and the
+    //         coroutine should continue without suspending.
+    bool await_suspend(folly::coro::coroutine_handle<> waiter) noexcept {
+      return hdl_.waitContext_->setWaiter(waiter);
+    }
+
+    HandleT await_resume() noexcept { return std::move(hdl_); }
+
+   private:
+    HandleT hdl_;
+  };
+
+  Awaiter<ReadHandleImpl> operator co_await() && noexcept {
+    return Awaiter<ReadHandleImpl>{std::move(*this)};
+  }
+#endif
+
   // Return true iff item handle is ready to use.
   // Empty handles are considered ready with it_ == nullptr.
   FOLLY_ALWAYS_INLINE bool isReady() const noexcept {
@@ -319,8 +352,14 @@ struct ReadHandleImpl {
       if (it) {
         alloc_.adjustHandleCountForThread_private(-1);
       }
+#if FOLLY_HAS_COROUTINES
+      folly::coro::coroutine_handle<> waiter;
+#endif
       {
         std::lock_guard<std::mutex> l(mtx_);
+#if FOLLY_HAS_COROUTINES
+        waiter = std::exchange(waiter_, nullptr);
+#endif
         if (onReadyCallback_) {
           // We will construct another handle that will be transferred to
           // another thread. So we will decrement a count locally to be back
@@ -335,6 +374,12 @@ struct ReadHandleImpl {
         }
       }
       baton_.post();
+#if FOLLY_HAS_COROUTINES
+      // resume last, the coroutine may release its handle right away.
+      if (waiter) {
+        waiter.resume();
+      }
+#endif
     }
 
     // @return      true iff we have the item
@@ -361,6 +406,24 @@ struct ReadHandleImpl {
       return ReadyCallback();
     }
 
+#if FOLLY_HAS_COROUTINES
+    // Set the coroutine to resume once ready. Only one coroutine can wait on
+    // a handle, since awaiting consumes it.
+    //
+    // @return   false if waitContext_ is already ready. The coroutine must
+    //           not be suspended.
+    //           true if the coroutine will be resumed by set()
+    bool setWaiter(folly::coro::coroutine_handle<> waiter) noexcept {
+      std::lock_guard<std::mutex> l(mtx_);
+      if (isReady()) {
+        return false;
+      }
+      XDCHECK(!waiter_);
+      waiter_ = waiter;
+      return true;
+    }
+#endif
+
     void releaseHandle() noexcept {
       // After @wait, callback is invoked. We don't have to worry about mutex.
       wait();
@@ -407,6 +470,9 @@ struct ReadHandleImpl {
                                          // be "ready"
     std::mutex mtx_;                //< mutex to set and get onReadyCallback_
     ReadyCallback onReadyCallback_; //< callback invoked when "ready"
+#if FOLLY_HAS_COROUTINES
+    folly::coro::coroutine_handle<> waiter_; //< coroutine resumed when "ready"
+#endif
     std::atomic<Item*> it_{reinterpret_cast<Item*>(kItemNotReady)}; //< The item
     uint8_t flags_{}; //< flags associated with the handle generated by NvmCache
     CacheT& alloc_;   //< allocator instance
@@ -547,6 +613,8 @@ struct ReadHandleImpl {
   FRIEND_TEST(ItemHandleTest, WaitContext_readycb);
   FRIEND_TEST(ItemHandleTest, WaitContext_ready_immediate);
   FRIEND_TEST(ItemHandleTest, onReadyWithNoWaitContext);
+  FRIEND_TEST(ItemHandleTest, WaitContext_coAwait);
+  FRIEND_TEST(ItemHandleTest, WaitContext_coAwait_ready);
 };
 
 // WriteHandleImpl is a sub class of ReadHandleImpl to function as a mutable
@@ -583,6 +651,15 @@ struct WriteHandleImpl : public ReadHandleImpl<T> {
 
   bool isWriteHandle() const { return true; }
 
+#if FOLLY_HAS_COROUTINES
+  // Suspends the coroutine until the handle is ready, like for a read handle.
+  typename ReadHandle::template Awaiter<WriteHandleImpl>
+  operator co_await() && noexcept {
+    return typename ReadHandle::template Awaiter<WriteHandleImpl>{
+        std::move(*this)};
+  }
+#endif
+
   // Friends
   // Only CacheAllocator and NvmCache can create non-default constructed handles
   friend CacheT;
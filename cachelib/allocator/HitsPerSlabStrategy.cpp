@@ -38,6 +38,7 @@ HitsPerSlabStrategy::HitsPerSlabStrategy(Config config)
 // 2. pick victim from the one that has poorest hitsPerSlab
 ClassId HitsPerSlabStrategy::pickVictim(const Config& config,
                                         const CacheBase& cache,
+                                        TierId tid,
                                         PoolId pid,
                                         const PoolStats& stats) {
   auto victims = stats.getClassIds();
@@ -49,13 +50,13 @@ ClassId HitsPerSlabStrategy::pickVictim(const Config& config,
   // ignore allocation classes that recently gained a slab. These will be
   // growing in their eviction age and we want to let the evicitons stabilize
   // before we consider  them again.
-  victims = filterVictimsByHoldOff(pid, stats, std::move(victims));
+  victims = filterVictimsByHoldOff(tid, pid, stats, std::move(victims));
 
   // filter out alloc classes with less than the minimum tail age
   if (config.minLruTailAge != 0) {
     // we are only concerned about the eviction age and not the projected age.
     const auto poolEvictionAgeStats =
-        cache.getPoolEvictionAgeStats(pid, /* projectionLength */ 0);
+        cache.getPoolEvictionAgeStats(tid, pid, /* projectionLength */ 0);
     victims = filterByMinTailAge(poolEvictionAgeStats, std::move(victims),
                                  config.minLruTailAge);
   }
@@ -64,7 +65,7 @@ ClassId HitsPerSlabStrategy::pickVictim(const Config& config,
     return Slab::kInvalidClassId;
   }
 
-  const auto& poolState = getPoolState(pid);
+  const auto& poolState = getPoolState(tid, pid);
   auto victimClassId = pickVictimByFreeMem(
       victims, stats, config.getFreeMemThreshold(), poolState);
 
@@ -91,13 +92,14 @@ ClassId HitsPerSlabStrategy::pickVictim(const Config& config,
 //
 // 2. pick receiver from the one that has highest hitsPerSlab
 ClassId HitsPerSlabStrategy::pickReceiver(const Config& config,
+                                          TierId tid,
                                           PoolId pid,
                                           const PoolStats& stats,
                                           ClassId victim) const {
   auto receivers = stats.getClassIds();
   receivers.erase(victim);
 
-  const auto& poolState = getPoolState(pid);
+  const auto& poolState = getPoolState(tid, pid);
   // filter out alloc classes that are not evicting
   receivers = filterByNoEvictions(stats, std::move(receivers), poolState);
 
@@ -121,23 +123,24 @@ ClassId HitsPerSlabStrategy::pickReceiver(const Config& config,
 }
 
 RebalanceContext HitsPerSlabStrategy::pickVictimAndReceiverImpl(
-    const CacheBase& cache, PoolId pid) {
-  if (!cache.getPool(pid).allSlabsAllocated()) {
+    const CacheBase& cache, TierId tid, PoolId pid) {
+  if (!cache.getPoolByTid(pid, tid).allSlabsAllocated()) {
     XLOGF(DBG,
-          "Pool Id: {}"
+          "Pool Id: {} in tier {}"
           " does not have all its slabs allocated"
           " and does not need rebalancing.",
-          static_cast<int>(pid));
+          static_cast<int>(pid), static_cast<int>(tid));
     return kNoOpContext;
   }
 
-  const auto poolStats = cache.getPoolStats(pid);
+  const auto poolStats = cache.getPoolStats(tid, pid);
 
   const auto config = getConfigCopy();
 
   RebalanceContext ctx;
-  ctx.victimClassId = pickVictim(config, cache, pid, poolStats);
-  ctx.receiverClassId = pickReceiver(config, pid, poolStats, ctx.victimClassId);
+  ctx.victimClassId = pickVictim(config, cache, tid, pid, poolStats);
+  ctx.receiverClassId =
+      pickReceiver(config, tid, pid, poolStats, ctx.victimClassId);
 
   if (ctx.victimClassId == ctx.receiverClassId ||
       ctx.victimClassId == Slab::kInvalidClassId ||
@@ -145,7 +148,7 @@ RebalanceContext HitsPerSlabStrategy::pickVictimAndReceiverImpl(
     return kNoOpContext;
   }
 
-  auto& poolState = getPoolState(pid);
+  auto& poolState = getPoolState(tid, pid);
   double weightVictim = 1;
   double weightReceiver = 1;
   if (config.getWeight) {
@@ -189,12 +192,13 @@ RebalanceContext HitsPerSlabStrategy::pickVictimAndReceiverImpl(
 }
 
 ClassId HitsPerSlabStrategy::pickVictimImpl(const CacheBase& cache,
+                                            TierId tid,
                                             PoolId pid) {
-  const auto poolStats = cache.getPoolStats(pid);
+  const auto poolStats = cache.getPoolStats(tid, pid);
   const auto config = getConfigCopy();
-  auto victimClassId = pickVictim(config, cache, pid, poolStats);
+  auto victimClassId = pickVictim(config, cache, tid, pid, poolStats);
 
-  auto& poolState = getPoolState(pid);
+  auto& poolState = getPoolState(tid, pid);
   // update all alloc classes' hits state to current hits so that next time we
   // only look at the delta hits sicne the last resize.
   for (const auto i : poolStats.getClassIds()) {
@@ -89,9 +89,12 @@ class HitsPerSlabStrategy : public RebalanceStrategy {
   }
 
   RebalanceContext pickVictimAndReceiverImpl(const CacheBase& cache,
+                                             TierId tid,
                                              PoolId pid) override final;
 
-  ClassId pickVictimImpl(const CacheBase& cache, PoolId pid) override final;
+  ClassId pickVictimImpl(const CacheBase& cache,
+                         TierId tid,
+                         PoolId pid) override final;
 
  private:
   static AllocInfo makeAllocInfo(PoolId pid,
@@ -102,10 +105,12 @@ class HitsPerSlabStrategy : public RebalanceStrategy {
 
   ClassId pickVictim(const Config& config,
                      const CacheBase& cache,
+                     TierId tid,
                      PoolId pid,
                      const PoolStats& stats);
 
   ClassId pickReceiver(const Config& config,
+                       TierId tid,
                        PoolId pid,
                        const PoolStats& stats,
                        ClassId victim) const;
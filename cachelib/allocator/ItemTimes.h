@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "cachelib/common/CompilerUtils.h"
+
+namespace facebook {
+namespace cachelib {
+
+// The creation and expiry time of an item, as kept in the item's header.
+// This is what items of every cache trait use unless the trait picks another
+// layout through ItemTimesType.
+class CACHELIB_PACKED_ATTR ItemTimes {
+ public:
+  // whether items can be given a time to live
+  static constexpr bool kSupportsExpiry = true;
+
+  // whether getCreationTime needs a time after the creation time to resolve
+  // the creation time against
+  static constexpr bool kTruncatedCreationTime = false;
+
+  ItemTimes(uint32_t creationTime, uint32_t expiryTime) noexcept
+      : creationTime_(creationTime), expiryTime_(expiryTime) {}
+
+  uint32_t getCreationTime() const noexcept { return creationTime_; }
+
+  // 0 means no time limitation
+  uint32_t getExpiryTime() const noexcept { return expiryTime_; }
+
+  // atomically update the expiry time
+  //
+  // @return true
+  bool updateExpiryTime(uint32_t expiryTime) noexcept {
+    while (true) {
+      uint32_t currExpTime = expiryTime_;
+      if (__sync_bool_compare_and_swap(&expiryTime_, currExpTime,
+                                       expiryTime)) {
+        return true;
+      }
+    }
+  }
+
+ private:
+  // Time when this cache item is created
+  const uint32_t creationTime_{0};
+
+  // Expiry timestamp for the item
+  // 0 means no time limitation
+  uint32_t expiryTime_{0};
+};
+
+// Item times for pools of small items that never expire. Only the creation
+// time is kept, in 2 bytes, which makes the item header 26 bytes instead of
+// 32. With the 8% allocation classes of CacheAllocatorOpsMicroBench and 10
+// byte keys, that fits 9% more items of 50 bytes and 13% more of 80 bytes,
+// and none more of 30 bytes, whose items stay in the 72 byte class.
+//
+// The MM hook keeps its 4 byte update time. It is read and written by every
+// MMContainer type through DListHook, so a 2 byte one would need new
+// container types rather than a different item header.
+//
+// The creation time is kept in units of kGranularitySecs and modulo 2^16, so
+// it is rounded down to the minute and wraps around after ~45 days: it is
+// read back as the latest matching time that is not after a reference time,
+// the item's last access time. Items not accessed for 45 days after their
+// creation look younger than they are, which is fine for the ages used in
+// stats and eviction decisions.
+class CACHELIB_PACKED_ATTR CompactItemTimes {
+ public:
+  static constexpr bool kSupportsExpiry = false;
+  static constexpr bool kTruncatedCreationTime = true;
+  static constexpr uint32_t kGranularitySecs = 60;
+
+  // the expiry time is dropped. CacheAllocator rejects allocations with a
+  // time to live for these items.
+  CompactItemTimes(uint32_t creationTime, uint32_t /* expiryTime */) noexcept
+      : creationTime_(static_cast<uint16_t>(creationTime / kGranularitySecs)) {}
+
+  // @param refTime   a time that is not before the creation time
+  uint32_t getCreationTime(uint32_t refTime) const noexcept {
+    const auto ref = refTime / kGranularitySecs;
+    const auto age =
+        static_cast<uint16_t>(static_cast<uint16_t>(ref) - creationTime_);
+    return ref < age ? 0 : (ref - age) * kGranularitySecs;
+  }
+
+  uint32_t getExpiryTime() const noexcept { return 0; }
+
+  // @return false, these items never expire
+  bool updateExpiryTime(uint32_t /* expiryTime */) noexcept { return false; }
+
+ private:
+  // creation time in units of kGranularitySecs, modulo 2^16
+  const uint16_t creationTime_{0};
+};
+
+namespace detail {
+// ItemTimesType of the cache trait if it has one, ItemTimes otherwise
+template <typename CacheTrait, typename = void>
+struct ItemTimesOf {
+  using type = ItemTimes;
+};
+
+template <typename CacheTrait>
+struct ItemTimesOf<CacheTrait, std::void_t<typename CacheTrait::ItemTimesType>> {
+  using type = typename CacheTrait::ItemTimesType;
+};
+} // namespace detail
+
+} // namespace cachelib
+} // namespace facebook
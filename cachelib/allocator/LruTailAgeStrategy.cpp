@@ -40,6 +40,7 @@ LruTailAgeStrategy::LruTailAgeStrategy(Config config)
 // 3. Pick an AC with the oldest tail age higher than the weighted average
 ClassId LruTailAgeStrategy::pickVictim(
     const Config& config,
+    TierId tid,
     PoolId pid,
     const PoolStats& poolStats,
     const PoolEvictionAgeStats& poolEvictionAgeStats) {
@@ -52,7 +53,7 @@ ClassId LruTailAgeStrategy::pickVictim(
   // ignore allocation classes that recently gained a slab. These will be
   // growing in their eviction age and we want to let the evicitons stabilize
   // before we consider  them again.
-  victims = filterVictimsByHoldOff(pid, poolStats, std::move(victims));
+  victims = filterVictimsByHoldOff(tid, pid, poolStats, std::move(victims));
 
   if (victims.empty()) {
     XLOG(DBG, "Rebalancing: No victims available");
@@ -60,7 +61,7 @@ ClassId LruTailAgeStrategy::pickVictim(
   }
 
   auto victimClassId = pickVictimByFreeMem(
-      victims, poolStats, config.getFreeMemThreshold(), getPoolState(pid));
+      victims, poolStats, config.getFreeMemThreshold(), getPoolState(tid, pid));
 
   if (victimClassId != Slab::kInvalidClassId) {
     return victimClassId;
@@ -79,6 +80,7 @@ ClassId LruTailAgeStrategy::pickVictim(
 
 ClassId LruTailAgeStrategy::pickReceiver(
     const Config& config,
+    TierId tid,
     PoolId pid,
     const PoolStats& stats,
     ClassId victim,
@@ -86,7 +88,7 @@ ClassId LruTailAgeStrategy::pickReceiver(
   auto receivers = stats.getClassIds();
   receivers.erase(victim);
 
-  receivers = filterByNoEvictions(stats, receivers, getPoolState(pid));
+  receivers = filterByNoEvictions(stats, receivers, getPoolState(tid, pid));
   if (receivers.empty()) {
     return Slab::kInvalidClassId;
   }
@@ -102,27 +104,28 @@ ClassId LruTailAgeStrategy::pickReceiver(
 }
 
 RebalanceContext LruTailAgeStrategy::pickVictimAndReceiverImpl(
-    const CacheBase& cache, PoolId pid) {
-  if (!cache.getPool(pid).allSlabsAllocated()) {
+    const CacheBase& cache, TierId tid, PoolId pid) {
+  if (!cache.getPoolByTid(pid, tid).allSlabsAllocated()) {
     XLOGF(DBG,
-          "Pool Id: {}"
+          "Pool Id: {} in tier {}"
           " does not have all its slabs allocated"
           " and does not need rebalancing.",
-          static_cast<int>(pid));
+          static_cast<int>(pid), static_cast<int>(tid));
 
     return kNoOpContext;
   }
 
   const auto config = getConfigCopy();
 
-  const auto poolStats = cache.getPoolStats(pid);
+  const auto poolStats = cache.getPoolStats(tid, pid);
   const auto poolEvictionAgeStats =
-      cache.getPoolEvictionAgeStats(pid, config.slabProjectionLength);
+      cache.getPoolEvictionAgeStats(tid, pid, config.slabProjectionLength);
 
   RebalanceContext ctx;
-  ctx.victimClassId = pickVictim(config, pid, poolStats, poolEvictionAgeStats);
-  ctx.receiverClassId = pickReceiver(config, pid, poolStats, ctx.victimClassId,
-                                     poolEvictionAgeStats);
+  ctx.victimClassId =
+      pickVictim(config, tid, pid, poolStats, poolEvictionAgeStats);
+  ctx.receiverClassId = pickReceiver(config, tid, pid, poolStats,
+                                     ctx.victimClassId, poolEvictionAgeStats);
   if (ctx.victimClassId == ctx.receiverClassId ||
       ctx.victimClassId == Slab::kInvalidClassId ||
       ctx.receiverClassId == Slab::kInvalidClassId) {
@@ -150,15 +153,18 @@ RebalanceContext LruTailAgeStrategy::pickVictimAndReceiverImpl(
 
   // start a hold off so that the receiver does not become a victim soon
   // enough.
-  getPoolState(pid).at(ctx.receiverClassId).startHoldOff();
+  getPoolState(tid, pid).at(ctx.receiverClassId).startHoldOff();
   return ctx;
 }
 
-ClassId LruTailAgeStrategy::pickVictimImpl(const CacheBase& cache, PoolId pid) {
+ClassId LruTailAgeStrategy::pickVictimImpl(const CacheBase& cache,
+                                           TierId tid,
+                                           PoolId pid) {
   const auto config = getConfigCopy();
   const auto poolEvictionAgeStats =
-      cache.getPoolEvictionAgeStats(pid, config.slabProjectionLength);
-  return pickVictim(config, pid, cache.getPoolStats(pid), poolEvictionAgeStats);
+      cache.getPoolEvictionAgeStats(tid, pid, config.slabProjectionLength);
+  return pickVictim(config, tid, pid, cache.getPoolStats(tid, pid),
+                    poolEvictionAgeStats);
 }
 } // namespace cachelib
 } // namespace facebook
@@ -88,9 +88,12 @@ class LruTailAgeStrategy : public RebalanceStrategy {
   }
 
   RebalanceContext pickVictimAndReceiverImpl(const CacheBase& cache,
+                                             TierId tid,
                                              PoolId pid) override final;
 
-  ClassId pickVictimImpl(const CacheBase& cache, PoolId pid) override final;
+  ClassId pickVictimImpl(const CacheBase& cache,
+                         TierId tid,
+                         PoolId pid) override final;
 
  private:
   static AllocInfo makeAllocInfo(PoolId pid,
@@ -100,11 +103,13 @@ class LruTailAgeStrategy : public RebalanceStrategy {
   }
 
   ClassId pickVictim(const Config& config,
+                     TierId tid,
                      PoolId pid,
                      const PoolStats& stats,
                      const PoolEvictionAgeStats& poolEvictionAgeStats);
 
   ClassId pickReceiver(const Config& config,
+                       TierId tid,
                        PoolId pid,
                        const PoolStats& stats,
                        ClassId victim,
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+namespace facebook {
+namespace cachelib {
+
+/* Container Interface Implementation */
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+MMClock::Container<T, HookPtr>::Container(serialization::MMClockObject object,
+                                          PtrCompressor compressor)
+    : compressor_(std::move(compressor)),
+      list_(*object.list_ref(), compressor_),
+      hand_(compressor_.unCompress(CompressedPtr{*object.compressedHand_ref()})),
+      config_(*object.config_ref()) {}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+bool MMClock::Container<T, HookPtr>::recordAccess(T& node,
+                                                  AccessMode mode) noexcept {
+  if ((mode == AccessMode::kWrite && !config_.updateOnWrite) ||
+      (mode == AccessMode::kRead && !config_.updateOnRead)) {
+    return false;
+  }
+
+  // only the first access after the hand cleared the bit writes to the
+  // node, so hot items do not bounce their cache line between readers.
+  if (!node.isInMMContainer() || isReferenced(node)) {
+    return false;
+  }
+  // the update time stays the insertion time, so the access does not need
+  // the container lock.
+  markReferenced(node);
+  return true;
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+cachelib::EvictionAgeStat MMClock::Container<T, HookPtr>::getEvictionAgeStat(
+    uint64_t projectedLength) const noexcept {
+  return mutex_->lock_combine([this, projectedLength]() {
+    return getEvictionAgeStatLocked(projectedLength);
+  });
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+cachelib::EvictionAgeStat
+MMClock::Container<T, HookPtr>::getEvictionAgeStatLocked(
+    uint64_t projectedLength) const noexcept {
+  EvictionAgeStat stat{};
+  const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
+
+  // the next node to be evicted is the one under the hand
+  const T* node = getHandLocked();
+  stat.warmQueueStat.oldestElementAge =
+      node ? currTime - getUpdateTime(*node) : 0;
+  stat.warmQueueStat.size = list_.size();
+  for (size_t numSeen = 0; numSeen < projectedLength && node != nullptr &&
+                           numSeen < list_.size();
+       numSeen++, node = getNextInSweep(*node)) {
+  }
+  stat.projectedAge = node ? currTime - getUpdateTime(*node)
+                           : stat.warmQueueStat.oldestElementAge;
+  return stat;
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+void MMClock::Container<T, HookPtr>::setConfig(const Config& newConfig) {
+  mutex_->lock_combine([this, newConfig]() { config_ = newConfig; });
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+typename MMClock::Config MMClock::Container<T, HookPtr>::getConfig() const {
+  return mutex_->lock_combine([this]() { return config_; });
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+bool MMClock::Container<T, HookPtr>::add(T& node) noexcept {
+  const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
+
+  return mutex_->lock_combine([this, &node, currTime]() {
+    if (node.isInMMContainer()) {
+      return false;
+    }
+    list_.linkAtHead(node);
+    node.markInMMContainer();
+    setUpdateTime(node, currTime);
+    unmarkReferenced(node);
+    return true;
+  });
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+typename MMClock::Container<T, HookPtr>::Iterator
+MMClock::Container<T, HookPtr>::getEvictionIterator() const noexcept {
+  LockHolder l(*mutex_);
+  return Iterator{std::move(l), *this, false /* sweep */};
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename F>
+void MMClock::Container<T, HookPtr>::withEvictionIterator(F&& fun) {
+  mutex_->lock_combine([this, &fun]() {
+    fun(Iterator{LockHolder{}, *this, true /* sweep */});
+  });
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+void MMClock::Container<T, HookPtr>::removeLocked(T& node) noexcept {
+  if (hand_ == &node) {
+    T* next = getNextInSweep(node);
+    hand_ = next == &node ? nullptr : next;
+  }
+  list_.remove(node);
+  unmarkReferenced(node);
+  node.unmarkInMMContainer();
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+bool MMClock::Container<T, HookPtr>::remove(T& node) noexcept {
+  return mutex_->lock_combine([this, &node]() {
+    if (!node.isInMMContainer()) {
+      return false;
+    }
+    removeLocked(node);
+    return true;
+  });
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+void MMClock::Container<T, HookPtr>::remove(Iterator& it) noexcept {
+  T& node = *it;
+  XDCHECK(node.isInMMContainer());
+  // the iterator moves off of the node on removal. A sweeping one skips the
+  // referenced nodes it lands on, as ++ would.
+  T* next = getNextInSweep(node);
+  removeLocked(node);
+  it.moveTo(next == &node ? nullptr : next);
+  --it.stepsLeft_;
+  it.skipReferenced();
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+bool MMClock::Container<T, HookPtr>::replace(T& oldNode,
+                                             T& newNode) noexcept {
+  return mutex_->lock_combine([this, &oldNode, &newNode]() {
+    if (!oldNode.isInMMContainer() || newNode.isInMMContainer()) {
+      return false;
+    }
+    const auto updateTime = getUpdateTime(oldNode);
+    list_.replace(oldNode, newNode);
+    oldNode.unmarkInMMContainer();
+    newNode.markInMMContainer();
+    setUpdateTime(newNode, updateTime);
+    if (isReferenced(oldNode)) {
+      markReferenced(newNode);
+      unmarkReferenced(oldNode);
+    } else {
+      unmarkReferenced(newNode);
+    }
+    if (hand_ == &oldNode) {
+      hand_ = &newNode;
+    }
+    return true;
+  });
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+serialization::MMClockObject MMClock::Container<T, HookPtr>::saveState()
+    const noexcept {
+  serialization::MMClockConfig configObject;
+  *configObject.updateOnWrite_ref() = config_.updateOnWrite;
+  *configObject.updateOnRead_ref() = config_.updateOnRead;
+
+  serialization::MMClockObject object;
+  *object.config_ref() = configObject;
+  *object.compressedHand_ref() = compressor_.compress(hand_).saveState();
+  *object.list_ref() = list_.saveState();
+  return object;
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+MMContainerStat MMClock::Container<T, HookPtr>::getStats() const noexcept {
+  auto stat = mutex_->lock_combine([this]() {
+    auto* hand = getHandLocked();
+
+    // we return by array here because DistributedMutex is fastest when the
+    // output data fits within 48 bytes.
+    return folly::make_array(list_.size(),
+                             hand == nullptr ? 0 : getUpdateTime(*hand));
+  });
+  return {stat[0] /* list size */,
+          stat[1] /* hand time */,
+          0,
+          0,
+          0,
+          0,
+          0};
+}
+
+// Iterator Context Implementation
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+MMClock::Container<T, HookPtr>::Iterator::Iterator(
+    LockHolder l, const Container<T, HookPtr>& c, bool sweep) noexcept
+    : c_(&c), sweep_(sweep), l_(std::move(l)) {
+  startSweep();
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+void MMClock::Container<T, HookPtr>::Iterator::startSweep() noexcept {
+  moveTo(c_->getHandLocked());
+  // a sweep passes over every node at most twice: once to clear its bit and
+  // once more to offer it for eviction.
+  stepsLeft_ = (sweep_ ? 2 : 1) * c_->list_.size();
+  skipReferenced();
+}
+
+template <typename T, MMClock::Hook<T> T::*HookPtr>
+void MMClock::Container<T, HookPtr>::Iterator::skipReferenced() noexcept {
+  if (!sweep_) {
+    return;
+  }
+  while (*this && c_->isReferenced(*curr_)) {
+    c_->unmarkReferenced(*curr_);
+    moveTo(c_->getNextInSweep(*curr_));
+    --stepsLeft_;
+  }
+}
+} // namespace cachelib
+} // namespace facebook
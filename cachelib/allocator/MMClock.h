@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#include <folly/Format.h>
+#pragma GCC diagnostic pop
+#include <folly/container/Array.h>
+#include <folly/lang/Aligned.h>
+#include <folly/synchronization/DistributedMutex.h>
+
+#include "cachelib/allocator/Cache.h"
+#include "cachelib/allocator/CacheStats.h"
+#include "cachelib/allocator/Util.h"
+#include "cachelib/allocator/datastruct/DList.h"
+#include "cachelib/allocator/memory/serialize/gen-cpp2/objects_types.h"
+#include "cachelib/common/CompilerUtils.h"
+#include "cachelib/common/Mutex.h"
+
+namespace facebook {
+namespace cachelib {
+
+// CLOCK eviction policy in the style of SIEVE.
+// Items are inserted at the head of a list and never move on access. An
+// access only sets a reference bit in the item, so hits do not take the
+// container lock. Eviction sweeps a hand from the tail towards the head,
+// wrapping around to the tail. Items with the reference bit set get their
+// bit cleared and are skipped; the first item without it is the eviction
+// candidate. The hand stays where the last sweep stopped.
+// The update time of an item is the time it was inserted. Accesses do not
+// change it, so eviction ages are measured from insertion.
+class MMClock {
+ public:
+  // unique identifier per MMType
+  static const int kId;
+
+  // forward declaration;
+  template <typename T>
+  using Hook = DListHook<T>;
+  using SerializationType = serialization::MMClockObject;
+  using SerializationConfigType = serialization::MMClockConfig;
+  using SerializationTypeContainer = serialization::MMClockCollection;
+
+  // This is not applicable for MMClock, just for compile of cache allocator
+  enum LruType { NumTypes };
+
+  // Config class for MMClock
+  struct Config {
+    // create from serialized config
+    explicit Config(SerializationConfigType configState)
+        : Config(*configState.updateOnWrite_ref(),
+                 *configState.updateOnRead_ref()) {}
+
+    // @param updateOnW   whether to set the reference bit on write
+    // @param updateOnR   whether to set the reference bit on read
+    Config(bool updateOnW, bool updateOnR)
+        : updateOnWrite(updateOnW), updateOnRead(updateOnR) {}
+
+    Config() = default;
+    Config(const Config& rhs) = default;
+    Config(Config&& rhs) = default;
+
+    Config& operator=(const Config& rhs) = default;
+    Config& operator=(Config&& rhs) = default;
+
+    template <typename... Args>
+    void addExtraConfig(Args...) {}
+
+    // whether accessing the cache for writes gives the item a second chance
+    // in the next sweep.
+    bool updateOnWrite{false};
+
+    // whether accessing the cache for reads gives the item a second chance
+    // in the next sweep.
+    bool updateOnRead{true};
+  };
+
+  // The container object which can be used to keep track of objects of type
+  // T. T must have a public member of type Hook. This object is wrapper
+  // around DList, is thread safe and can be accessed from multiple threads.
+  template <typename T, Hook<T> T::*HookPtr>
+  struct Container {
+   private:
+    using ClockList = DList<T, HookPtr>;
+    using Mutex = folly::DistributedMutex;
+    using LockHolder = std::unique_lock<Mutex>;
+    using PtrCompressor = typename T::PtrCompressor;
+    using Time = typename Hook<T>::Time;
+    using CompressedPtr = typename T::CompressedPtr;
+    using RefFlags = typename T::Flags;
+
+   public:
+    Container() = default;
+    Container(Config c, PtrCompressor compressor)
+        : compressor_(std::move(compressor)),
+          list_(compressor_),
+          config_(std::move(c)) {}
+    Container(serialization::MMClockObject object, PtrCompressor compressor);
+
+    Container(const Container&) = delete;
+    Container& operator=(const Container&) = delete;
+
+    // context for iterating the MM container. A sweeping iterator moves the
+    // hand of the clock: referenced nodes under the hand get their bit
+    // cleared and are skipped. It sweeps at most two laps, so a node that
+    // the caller skips without removing can show up again. Any other
+    // iterator walks one lap from the hand and leaves the hand and the bits
+    // alone. The iterator holds the lock on the container, so only one can
+    // exist at a time.
+    class Iterator {
+     public:
+      // noncopyable but movable.
+      Iterator(const Iterator&) = delete;
+      Iterator& operator=(const Iterator&) = delete;
+      Iterator(Iterator&&) noexcept = default;
+
+      Iterator& operator++() noexcept {
+        if (*this) {
+          moveTo(c_->getNextInSweep(*curr_));
+          --stepsLeft_;
+          skipReferenced();
+        }
+        return *this;
+      }
+
+      Iterator& operator--() {
+        throw std::invalid_argument(
+            "Decrementing eviction iterator is not supported");
+      }
+
+      T* operator->() const noexcept { return get(); }
+      T& operator*() const noexcept { return *get(); }
+
+      explicit operator bool() const noexcept {
+        return c_ != nullptr && stepsLeft_ > 0 && curr_ != nullptr;
+      }
+
+      T* get() const noexcept { return *this ? curr_ : nullptr; }
+
+      // Invalidates this iterator
+      void reset() noexcept { stepsLeft_ = 0; }
+
+      // 1. Invalidate this iterator
+      // 2. Unlock
+      void destroy() {
+        reset();
+        if (l_.owns_lock()) {
+          l_.unlock();
+        }
+      }
+
+      // Reset this iterator to the beginning of a walk from the current
+      // position of the hand
+      void resetToBegin() {
+        if (!l_.owns_lock()) {
+          l_.lock();
+        }
+        startSweep();
+      }
+
+     private:
+      // private because it's easy to misuse and cause deadlock for MMClock
+      Iterator& operator=(Iterator&&) noexcept = default;
+
+      // create an iterator with the lock being held.
+      //
+      // @param sweep  whether the iterator moves the hand and clears the
+      //               reference bits
+      Iterator(LockHolder l,
+               const Container<T, HookPtr>& c,
+               bool sweep) noexcept;
+
+      // position the iterator on the hand to start walking from
+      void startSweep() noexcept;
+
+      // move the iterator, and the hand when sweeping, to the node
+      void moveTo(T* node) noexcept {
+        curr_ = node;
+        if (sweep_) {
+          c_->hand_ = node;
+        }
+      }
+
+      // when sweeping, advance the hand past referenced nodes, clearing
+      // their bit
+      void skipReferenced() noexcept;
+
+      // only the container can create iterators
+      friend Container<T, HookPtr>;
+
+      const Container<T, HookPtr>* c_{nullptr};
+
+      // the node the iterator is on
+      T* curr_{nullptr};
+
+      // whether the iterator moves the hand and clears the reference bits
+      bool sweep_{false};
+
+      // number of nodes the iterator can still move over
+      size_t stepsLeft_{0};
+
+      // lock protecting the validity of the iterator
+      LockHolder l_;
+    };
+
+    // records the information that the node was accessed by setting its
+    // reference bit. It never takes the container lock, and accesses to a
+    // node whose bit is already set do not write to it.
+    //
+    // @param node  node that we want to mark as relevant/accessed
+    // @param mode  the mode for the access operation.
+    //
+    // @return      True if the reference bit was set by this call, false if
+    //              it was already set or the access is not tracked.
+    bool recordAccess(T& node, AccessMode mode) noexcept;
+
+    // adds the given node into the container and marks it as being present in
+    // the container. The node is added to the head of the list.
+    //
+    // @param node  The node to be added to the container.
+    // @return  True if the node was successfully added to the container. False
+    //          if the node was already in the contianer. On error state of node
+    //          is unchanged.
+    bool add(T& node) noexcept;
+
+    // removes the node from the list and sets it previous and next to nullptr.
+    //
+    // @param node  The node to be removed from the container.
+    // @return  True if the node was successfully removed from the container.
+    //          False if the node was not part of the container. On error, the
+    //          state of node is unchanged.
+    bool remove(T& node) noexcept;
+
+    using Iterator = Iterator;
+    // same as the above but uses an iterator context. The iterator is updated
+    // on removal of the corresponding node to point to the next candidate.
+    // The iterator context holds the lock on the container.
+    //
+    // @param it    Iterator that will be removed
+    void remove(Iterator& it) noexcept;
+
+    // replaces one node with another, at the same position
+    //
+    // @param oldNode   node being replaced
+    // @param newNode   node to replace oldNode with
+    //
+    // @return true  If the replace was successful. Returns false if the
+    //               destination node did not exist in the container, or if the
+    //               source node already existed.
+    bool replace(T& oldNode, T& newNode) noexcept;
+
+    // Obtain an iterator that walks the nodes once, starting from the hand,
+    // without moving the hand or clearing reference bits. It is meant for
+    // inspecting the container and removing nodes from it. This iterator
+    // holds a lock to this container and only one such iterator can exist at
+    // a time
+    Iterator getEvictionIterator() const noexcept;
+
+    // Execute provided function under container lock. Function gets
+    // a sweeping iterator, which moves the hand to find eviction
+    // candidates, passed as parameter.
+    template <typename F>
+    void withEvictionIterator(F&& f);
+
+    // get copy of current config
+    Config getConfig() const;
+
+    // override the existing config with the new one.
+    void setConfig(const Config& newConfig);
+
+    bool isEmpty() const noexcept { return size() == 0; }
+
+    // returns the number of elements in the container
+    size_t size() const noexcept {
+      return mutex_->lock_combine([this]() { return list_.size(); });
+    }
+
+    // Returns the eviction age stats. See CacheStats.h for details
+    EvictionAgeStat getEvictionAgeStat(uint64_t projectedLength) const noexcept;
+
+    // for saving the state of the container
+    //
+    // precondition:  serialization must happen without any reader or writer
+    // present. Any modification of this object afterwards will result in an
+    // invalid, inconsistent state for the serialized data.
+    //
+    serialization::MMClockObject saveState() const noexcept;
+
+    // return the stats for this container.
+    MMContainerStat getStats() const noexcept;
+
+    static LruType getLruType(const T& /* node */) noexcept {
+      return LruType{};
+    }
+
+   private:
+    EvictionAgeStat getEvictionAgeStatLocked(
+        uint64_t projectedLength) const noexcept;
+
+    static Time getUpdateTime(const T& node) noexcept {
+      return (node.*HookPtr).getUpdateTime();
+    }
+
+    static void setUpdateTime(T& node, Time time) noexcept {
+      (node.*HookPtr).setUpdateTime(time);
+    }
+
+    // the node the hand moves to after the given one. The hand moves from
+    // the tail towards the head and wraps around to the tail.
+    T* getNextInSweep(const T& node) const noexcept {
+      T* prev = list_.getPrev(node);
+      return prev != nullptr ? prev : list_.getTail();
+    }
+
+    // the node under the hand, starting at the tail
+    T* getHandLocked() const noexcept {
+      return hand_ != nullptr ? hand_ : list_.getTail();
+    }
+
+    // remove node from the list and move the hand off of it
+    // @param node          node to remove
+    void removeLocked(T& node) noexcept;
+
+    // Bit MM_BIT_1 is used as the reference bit of the clock. It is set on
+    // access and cleared when the hand sweeps over the node.
+    void markReferenced(T& node) noexcept {
+      node.template setFlag<RefFlags::kMMFlag1>();
+    }
+
+    void unmarkReferenced(T& node) const noexcept {
+      node.template unSetFlag<RefFlags::kMMFlag1>();
+    }
+
+    bool isReferenced(const T& node) const noexcept {
+      return node.template isFlagSet<RefFlags::kMMFlag1>();
+    }
+
+    // protects all operations on the list, except for setting the reference
+    // bit on access.
+    mutable folly::cacheline_aligned<Mutex> mutex_;
+
+    const PtrCompressor compressor_{};
+
+    // the list of nodes in insertion order
+    ClockList list_{};
+
+    // the hand of the clock. nullptr means the tail. Moved by the sweeping
+    // iterator under the lock.
+    mutable T* hand_{nullptr};
+
+    // Config for this container.
+    // Write access to the MMClock Config is serialized.
+    // Reads may be racy.
+    Config config_{};
+  };
+};
+} // namespace cachelib
+} // namespace facebook
+
+#include "cachelib/allocator/MMClock-inl.h"
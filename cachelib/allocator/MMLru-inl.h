@@ -38,6 +38,24 @@ MMLru::Container<T, HookPtr>::Container(serialization::MMLruObject object,
                              ? std::numeric_limits<Time>::max()
                              : static_cast<Time>(util::getCurrentTimeSec()) +
                                    config_.mmReconfigureIntervalSecs.count();
+  initAccessBuffer();
+}
+
+template <typename T, MMLru::Hook<T> T::*HookPtr>
+void MMLru::Container<T, HookPtr>::initAccessBuffer() {
+  if (config_.accessBufferSize == 0) {
+    return;
+  }
+  const auto numSlots = folly::nextPowTwo(config_.accessBufferSize);
+  accessBufferMask_ = numSlots - 1;
+  accessBuffer_ =
+      std::make_unique<AccessBufferStripe[]>(kNumAccessBufferStripes);
+  for (size_t i = 0; i < kNumAccessBufferStripes; i++) {
+    accessBuffer_[i].slots = std::make_unique<std::atomic<T*>[]>(numSlots);
+    for (size_t j = 0; j < numSlots; j++) {
+      accessBuffer_[i].slots[j].store(nullptr, std::memory_order_relaxed);
+    }
+  }
 }
 
 template <typename T, MMLru::Hook<T> T::*HookPtr>
@@ -58,19 +76,13 @@ bool MMLru::Container<T, HookPtr>::recordAccess(T& node,
       markAccessed(node);
     }
 
+    if (accessBuffer_) {
+      return bufferAccess(node, curr);
+    }
+
     auto func = [this, &node, curr]() {
       reconfigureLocked(curr);
-      ensureNotInsertionPoint(node);
-      if (node.isInMMContainer()) {
-        lru_.moveToHead(node);
-        setUpdateTime(node, curr);
-      }
-      if (isTail(node)) {
-        unmarkTail(node);
-        tailSize_--;
-        XDCHECK_LE(0u, tailSize_);
-        updateLruInsertionPoint();
-      }
+      promoteLocked(node, curr);
     };
 
     // if the tryLockUpdate optimization is on, and we were able to grab the
@@ -93,6 +105,154 @@ bool MMLru::Container<T, HookPtr>::recordAccess(T& node,
   return false;
 }
 
+template <typename T, MMLru::Hook<T> T::*HookPtr>
+void MMLru::Container<T, HookPtr>::promoteLocked(T& node,
+                                                 Time currTime) noexcept {
+  ensureNotInsertionPoint(node);
+  if (node.isInMMContainer()) {
+    lru_.moveToHead(node);
+    setUpdateTime(node, currTime);
+  }
+  if (isTail(node)) {
+    unmarkTail(node);
+    tailSize_--;
+    XDCHECK_LE(0u, tailSize_);
+    updateLruInsertionPoint();
+  }
+}
+
+template <typename T, MMLru::Hook<T> T::*HookPtr>
+bool MMLru::Container<T, HookPtr>::bufferAccess(T& node,
+                                                Time currTime) noexcept {
+  // the node already has an entry that is not applied yet.
+  if (!markBuffered(node)) {
+    return true;
+  }
+
+  auto& stripe =
+      accessBuffer_[folly::AccessSpreader<>::current(kNumAccessBufferStripes)];
+  auto& slot =
+      stripe.slots[stripe.next.fetch_add(1, std::memory_order_relaxed) &
+                   accessBufferMask_];
+
+  stripe.numBuffered.fetch_add(1, std::memory_order_relaxed);
+  T* expected = nullptr;
+  if (!slot.compare_exchange_strong(expected, &node,
+                                    std::memory_order_acq_rel)) {
+    stripe.numBuffered.fetch_sub(1, std::memory_order_relaxed);
+    unmarkBuffered(node);
+
+    // the stripe wrapped around onto an access that was not applied yet.
+    // Apply the whole buffer along with this access in one critical section.
+    auto func = [this, &node, currTime]() {
+      reconfigureLocked(currTime);
+      drainAccessBufferLocked(currTime);
+      promoteLocked(node, currTime);
+    };
+    if (config_.tryLockUpdate) {
+      if (auto lck = LockHolder{*lruMutex_, std::try_to_lock}) {
+        func();
+        return true;
+      }
+      return false;
+    }
+    lruMutex_->lock_combine(func);
+    return true;
+  }
+
+  // pairs with the fence in purgeAccessBufferLocked(). If the node got
+  // removed concurrently, either we see it here and take our entry back, or
+  // the remover sees our entry and drops it.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!node.isInMMContainer()) {
+    expected = &node;
+    if (slot.compare_exchange_strong(expected, nullptr,
+                                     std::memory_order_acq_rel)) {
+      stripe.numBuffered.fetch_sub(1, std::memory_order_relaxed);
+      unmarkBuffered(node);
+    }
+    return false;
+  }
+  return true;
+}
+
+template <typename T, MMLru::Hook<T> T::*HookPtr>
+void MMLru::Container<T, HookPtr>::drainAccessBufferLocked(
+    Time currTime) noexcept {
+  if (!accessBuffer_) {
+    return;
+  }
+  for (size_t i = 0; i < kNumAccessBufferStripes; i++) {
+    auto& stripe = accessBuffer_[i];
+    if (stripe.numBuffered.load(std::memory_order_acquire) == 0) {
+      continue;
+    }
+    for (size_t j = 0; j <= accessBufferMask_; j++) {
+      if (stripe.slots[j].load(std::memory_order_relaxed) == nullptr) {
+        continue;
+      }
+      T* node = stripe.slots[j].exchange(nullptr, std::memory_order_acq_rel);
+      if (node == nullptr) {
+        continue;
+      }
+      stripe.numBuffered.fetch_sub(1, std::memory_order_relaxed);
+      unmarkBuffered(*node);
+      // nodes removed from the container are purged from the buffer under
+      // the lock, so this is only false while the writer is retracting it.
+      if (node->isInMMContainer()) {
+        promoteLocked(*node, currTime);
+      }
+    }
+  }
+}
+
+template <typename T, MMLru::Hook<T> T::*HookPtr>
+void MMLru::Container<T, HookPtr>::purgeAccessBufferLocked(T& node) noexcept {
+  if (!accessBuffer_) {
+    return;
+  }
+  // pairs with the fence in bufferAccess()
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!isBuffered(node)) {
+    return;
+  }
+  for (size_t i = 0; i < kNumAccessBufferStripes; i++) {
+    auto& stripe = accessBuffer_[i];
+    if (stripe.numBuffered.load(std::memory_order_relaxed) == 0) {
+      continue;
+    }
+    for (size_t j = 0; j <= accessBufferMask_; j++) {
+      T* expected = &node;
+      if (stripe.slots[j].load(std::memory_order_relaxed) == expected &&
+          stripe.slots[j].compare_exchange_strong(expected, nullptr,
+                                                  std::memory_order_acq_rel)) {
+        stripe.numBuffered.fetch_sub(1, std::memory_order_relaxed);
+        unmarkBuffered(node);
+        // a node has at most one entry.
+        return;
+      }
+    }
+  }
+  // the writer marked the node but has not published its entry yet. It sees
+  // the node gone and clears the mark itself.
+}
+
+template <typename T, MMLru::Hook<T> T::*HookPtr>
+void MMLru::Container<T, HookPtr>::dropAccessBuffer() const noexcept {
+  if (!accessBuffer_) {
+    return;
+  }
+  for (size_t i = 0; i < kNumAccessBufferStripes; i++) {
+    auto& stripe = accessBuffer_[i];
+    for (size_t j = 0; j <= accessBufferMask_; j++) {
+      if (T* node = stripe.slots[j].exchange(nullptr)) {
+        unmarkBuffered(*node);
+      }
+    }
+    stripe.numBuffered.store(0, std::memory_order_relaxed);
+  }
+}
+
 template <typename T, MMLru::Hook<T> T::*HookPtr>
 cachelib::EvictionAgeStat MMLru::Container<T, HookPtr>::getEvictionAgeStat(
     uint64_t projectedLen) const noexcept {
@@ -131,7 +291,10 @@ MMLru::Container<T, HookPtr>::getEvictionAgeStatLocked(
 template <typename T, MMLru::Hook<T> T::*HookPtr>
 void MMLru::Container<T, HookPtr>::setConfig(const Config& newConfig) {
   lruMutex_->lock_combine([this, newConfig]() {
+    // the access buffer is sized when the container is created
+    const auto accessBufferSize = config_.accessBufferSize;
     config_ = newConfig;
+    config_.accessBufferSize = accessBufferSize;
     if (config_.lruInsertionPointSpec == 0 && insertionPoint_ != nullptr) {
       auto curr = insertionPoint_;
       while (tailSize_ != 0) {
@@ -230,6 +393,7 @@ template <typename F>
 void
 MMLru::Container<T, HookPtr>::withEvictionIterator(F&& fun) {
   lruMutex_->lock_combine([this, &fun]() {
+    drainAccessBufferLocked(static_cast<Time>(util::getCurrentTimeSec()));
     fun(Iterator{LockHolder{}, lru_.rbegin()});
   });
 }
@@ -259,6 +423,7 @@ void MMLru::Container<T, HookPtr>::removeLocked(T& node) {
     tailSize_--;
   }
   node.unmarkInMMContainer();
+  purgeAccessBufferLocked(node);
   updateLruInsertionPoint();
   return;
 }
@@ -291,6 +456,7 @@ bool MMLru::Container<T, HookPtr>::replace(T& oldNode, T& newNode) noexcept {
     const auto updateTime = getUpdateTime(oldNode);
     lru_.replace(oldNode, newNode);
     oldNode.unmarkInMMContainer();
+    purgeAccessBufferLocked(oldNode);
     newNode.markInMMContainer();
     setUpdateTime(newNode, updateTime);
     if (isAccessed(oldNode)) {
@@ -315,6 +481,10 @@ bool MMLru::Container<T, HookPtr>::replace(T& oldNode, T& newNode) noexcept {
 template <typename T, MMLru::Hook<T> T::*HookPtr>
 serialization::MMLruObject MMLru::Container<T, HookPtr>::saveState()
     const noexcept {
+  // buffered accesses are not saved. Their nodes must not stay marked as
+  // buffered once the container is restored.
+  dropAccessBuffer();
+
   serialization::MMLruConfig configObject;
   *configObject.lruRefreshTime_ref() =
       lruRefreshTime_.load(std::memory_order_relaxed);
@@ -323,6 +493,7 @@ serialization::MMLruObject MMLru::Container<T, HookPtr>::saveState()
   *configObject.updateOnRead_ref() = config_.updateOnRead;
   *configObject.tryLockUpdate_ref() = config_.tryLockUpdate;
   *configObject.lruInsertionPointSpec_ref() = config_.lruInsertionPointSpec;
+  *configObject.accessBufferSize_ref() = config_.accessBufferSize;
 
   serialization::MMLruObject object;
   *object.config_ref() = configObject;
@@ -23,8 +23,11 @@
 #pragma GCC diagnostic ignored "-Wconversion"
 #include <folly/Format.h>
 #pragma GCC diagnostic pop
+#include <folly/concurrency/CacheLocality.h>
 #include <folly/container/Array.h>
+#include <folly/lang/Align.h>
 #include <folly/lang/Aligned.h>
+#include <folly/lang/Bits.h>
 #include <folly/synchronization/DistributedMutex.h>
 
 #include "cachelib/allocator/Cache.h"
@@ -73,7 +76,10 @@ class MMLru {
               *configState.updateOnWrite_ref(),
               *configState.updateOnRead_ref(),
               *configState.tryLockUpdate_ref(),
-              static_cast<uint8_t>(*configState.lruInsertionPointSpec_ref())) {}
+              static_cast<uint8_t>(*configState.lruInsertionPointSpec_ref())) {
+      accessBufferSize =
+          static_cast<uint32_t>(*configState.accessBufferSize_ref());
+    }
 
     // @param time        the LRU refresh time in seconds.
     //                    An item will be promoted only once in each lru refresh
@@ -199,6 +205,14 @@ class MMLru {
     // Minimum interval between reconfigurations. If 0, reconfigure is never
     // called.
     std::chrono::seconds mmReconfigureIntervalSecs{};
+
+    // Number of accesses each stripe of the access buffer can hold, rounded
+    // up to a power of two. When non-zero, promotions are appended to the
+    // buffer without taking the lru lock and applied in batches under a
+    // single lock acquisition, either by the thread that finds its stripe
+    // full or by the evicting thread. If 0, every promotion takes the lru
+    // lock. Can only be set when the container is created.
+    uint32_t accessBufferSize{0};
   };
 
   // The container object which can be used to keep track of objects of type
@@ -229,6 +243,7 @@ class MMLru {
               ? std::numeric_limits<Time>::max()
               : static_cast<Time>(util::getCurrentTimeSec()) +
                     config_.mmReconfigureIntervalSecs.count();
+      initAccessBuffer();
     }
     Container(serialization::MMLruObject object, PtrCompressor compressor);
 
@@ -287,8 +302,12 @@ class MMLru {
     // @param node  node that we want to mark as relevant/accessed
     // @param mode  the mode for the access operation.
     //
+    // When the access buffer is enabled, the promotion is only recorded in
+    // the buffer and applied to the lru later.
+    //
     // @return      True if the information is recorded and bumped the node
-    //              to the head of the lru, returns false otherwise
+    //              to the head of the lru (or buffered to be bumped),
+    //              returns false otherwise
     bool recordAccess(T& node, AccessMode mode) noexcept;
 
     // adds the given node into the container and marks it as being present in
@@ -334,7 +353,8 @@ class MMLru {
     Iterator getEvictionIterator() const noexcept;
 
     // Execute provided function under container lock. Function gets
-    // iterator passed as parameter.
+    // iterator passed as parameter. Buffered accesses are applied to the lru
+    // before the iteration starts.
     template <typename F>
     void withEvictionIterator(F&& f);
 
@@ -400,6 +420,34 @@ class MMLru {
     // @param node          node to remove
     void removeLocked(T& node);
 
+    // move the node to the head of the lru and adjust insertion points
+    void promoteLocked(T& node, Time currTime) noexcept;
+
+    // allocate the access buffer if it is enabled in the config
+    void initAccessBuffer();
+
+    // Append the node to the access buffer of the calling thread's stripe.
+    // If the stripe is full, all buffered accesses and this one are applied
+    // under the lru lock.
+    //
+    // @return true if the access was buffered or applied
+    bool bufferAccess(T& node, Time currTime) noexcept;
+
+    // apply all the buffered accesses to the lru.
+    void drainAccessBufferLocked(Time currTime) noexcept;
+
+    // Drop the buffered access to a node that was just unmarked from the
+    // container, so that the buffer never refers to a node once it is out of
+    // this container. Only nodes marked as buffered are looked up. Writers
+    // publish into the buffer before they check isInMMContainer and this
+    // runs after the node is unmarked, so either the writer sees the node
+    // gone and retracts its entry or we see the entry.
+    void purgeAccessBufferLocked(T& node) noexcept;
+
+    // drop all buffered accesses without applying them. Only for saving the
+    // state, so that no node is left marked as buffered.
+    void dropAccessBuffer() const noexcept;
+
     // Bit MM_BIT_0 is used to record if the item is in tail. This
     // is used to implement LRU insertion points
     void markTail(T& node) noexcept {
@@ -429,6 +477,23 @@ class MMLru {
       return node.template isFlagSet<RefFlags::kMMFlag1>();
     }
 
+    // Bit MM_BIT_2 is used to record if the node has an entry in the access
+    // buffer. A node is buffered at most once, so the drainer and removal
+    // know whether there is an entry to look for.
+    //
+    // @return true if the node was not marked before
+    bool markBuffered(T& node) noexcept {
+      return node.template trySetFlag<RefFlags::kMMFlag2>();
+    }
+
+    void unmarkBuffered(T& node) const noexcept {
+      node.template unSetFlag<RefFlags::kMMFlag2>();
+    }
+
+    bool isBuffered(const T& node) const noexcept {
+      return node.template isFlagSet<RefFlags::kMMFlag2>();
+    }
+
     // protects all operations on the lru. We never really just read the state
     // of the LRU. Hence we dont really require a RW mutex at this point of
     // time.
@@ -459,6 +524,25 @@ class MMLru {
     // Max lruFreshTime.
     static constexpr uint32_t kLruRefreshTimeCap{900};
 
+    // Stripe of the access buffer. Threads pick a stripe by the cpu they run
+    // on, so appending an access rarely bounces a cache line between cores.
+    struct alignas(folly::hardware_destructive_interference_size)
+        AccessBufferStripe {
+      std::atomic<size_t> next{0};
+      // upper bound on the number of occupied slots. Incremented before a
+      // slot is taken, so draining and purging skip the stripe when it is 0.
+      std::atomic<size_t> numBuffered{0};
+      std::unique_ptr<std::atomic<T*>[]> slots;
+    };
+
+    static constexpr size_t kNumAccessBufferStripes{16};
+
+    // buffered accesses not applied to the lru yet. nullptr if disabled.
+    std::unique_ptr<AccessBufferStripe[]> accessBuffer_;
+
+    // number of slots per stripe minus one
+    size_t accessBufferMask_{0};
+
     FRIEND_TEST(MMLruTest, Reconfigure);
   };
 };
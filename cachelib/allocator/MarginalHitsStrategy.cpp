@@ -30,17 +30,17 @@ MarginalHitsStrategy::MarginalHitsStrategy(Config config)
     : RebalanceStrategy(MarginalHits), config_(std::move(config)) {}
 
 RebalanceContext MarginalHitsStrategy::pickVictimAndReceiverImpl(
-    const CacheBase& cache, PoolId pid) {
+    const CacheBase& cache, TierId tid, PoolId pid) {
   const auto config = getConfigCopy();
-  if (!cache.getPool(pid).allSlabsAllocated()) {
+  if (!cache.getPoolByTid(pid, tid).allSlabsAllocated()) {
     XLOGF(DBG,
-          "Pool Id: {} does not have all its slabs allocated"
+          "Pool Id: {} in tier {} does not have all its slabs allocated"
           " and does not need rebalancing.",
-          static_cast<int>(pid));
+          static_cast<int>(pid), static_cast<int>(tid));
     return kNoOpContext;
   }
-  auto poolStats = cache.getPoolStats(pid);
-  auto scores = computeClassMarginalHits(pid, poolStats);
+  auto poolStats = cache.getPoolStats(tid, pid);
+  auto scores = computeClassMarginalHits(tid, pid, poolStats);
   auto classesSet = poolStats.getClassIds();
   std::vector<ClassId> classes(classesSet.begin(), classesSet.end());
   std::unordered_map<ClassId, bool> validVictim;
@@ -54,26 +54,30 @@ RebalanceContext MarginalHitsStrategy::pickVictimAndReceiverImpl(
     validReceiver[it] = acStats.at(it).getTotalFreeMemory() <
                         config.maxFreeMemSlabs * Slab::kSize;
   }
-  if (classStates_[pid].entities.empty()) {
+  auto& classState = classStates_[{tid, pid}];
+  if (classState.entities.empty()) {
     // initialization
-    classStates_[pid].entities = classes;
+    classState.entities = classes;
     for (auto cid : classes) {
-      classStates_[pid].smoothedRanks[cid] = 0;
+      classState.smoothedRanks[cid] = 0;
     }
   }
-  classStates_[pid].updateRankings(scores, config.movingAverageParam);
-  return pickVictimAndReceiverFromRankings(pid, validVictim, validReceiver);
+  classState.updateRankings(scores, config.movingAverageParam);
+  return pickVictimAndReceiverFromRankings(tid, pid, validVictim,
+                                           validReceiver);
 }
 
 ClassId MarginalHitsStrategy::pickVictimImpl(const CacheBase& cache,
+                                             TierId tid,
                                              PoolId pid) {
-  return pickVictimAndReceiverImpl(cache, pid).victimClassId;
+  return pickVictimAndReceiverImpl(cache, tid, pid).victimClassId;
 }
 
 std::unordered_map<ClassId, double>
-MarginalHitsStrategy::computeClassMarginalHits(PoolId pid,
+MarginalHitsStrategy::computeClassMarginalHits(TierId tid,
+                                               PoolId pid,
                                                const PoolStats& poolStats) {
-  const auto& poolState = getPoolState(pid);
+  const auto& poolState = getPoolState(tid, pid);
   std::unordered_map<ClassId, double> scores;
   for (auto info : poolState) {
     if (info.id != Slab::kInvalidClassId) {
@@ -84,10 +88,12 @@ MarginalHitsStrategy::computeClassMarginalHits(PoolId pid,
 }
 
 RebalanceContext MarginalHitsStrategy::pickVictimAndReceiverFromRankings(
+    TierId tid,
     PoolId pid,
     const std::unordered_map<ClassId, bool>& validVictim,
     const std::unordered_map<ClassId, bool>& validReceiver) {
-  auto victimAndReceiver = classStates_[pid].pickVictimAndReceiverFromRankings(
+  auto& classState = classStates_[{tid, pid}];
+  auto victimAndReceiver = classState.pickVictimAndReceiverFromRankings(
       validVictim, validReceiver, Slab::kInvalidClassId);
   RebalanceContext ctx{victimAndReceiver.first, victimAndReceiver.second};
   if (ctx.victimClassId == Slab::kInvalidClassId ||
@@ -100,9 +106,9 @@ RebalanceContext MarginalHitsStrategy::pickVictimAndReceiverFromRankings(
         "Rebalancing: receiver = {}, smoothed rank = {}, victim = {}, smoothed "
         "rank = {}",
         static_cast<int>(ctx.receiverClassId),
-        classStates_[pid].smoothedRanks[ctx.receiverClassId],
+        classState.smoothedRanks[ctx.receiverClassId],
         static_cast<int>(ctx.victimClassId),
-        classStates_[pid].smoothedRanks[ctx.victimClassId]);
+        classState.smoothedRanks[ctx.victimClassId]);
   return ctx;
 }
 } // namespace cachelib
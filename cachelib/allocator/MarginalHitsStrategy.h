@@ -67,24 +67,29 @@ class MarginalHitsStrategy : public RebalanceStrategy {
 
   // pick victim and receiver classes from a pool
   RebalanceContext pickVictimAndReceiverImpl(const CacheBase& cache,
+                                             TierId tid,
                                              PoolId pid) override final;
 
   // pick victim class from a pool to shrink
-  ClassId pickVictimImpl(const CacheBase& cache, PoolId pid) override final;
+  ClassId pickVictimImpl(const CacheBase& cache,
+                         TierId tid,
+                         PoolId pid) override final;
 
  private:
   // compute delta of tail hits for every class in this pool
   std::unordered_map<ClassId, double> computeClassMarginalHits(
-      PoolId pid, const PoolStats& poolStats);
+      TierId tid, PoolId pid, const PoolStats& poolStats);
 
   // pick victim and receiver according to smoothed rankings
   RebalanceContext pickVictimAndReceiverFromRankings(
+      TierId tid,
       PoolId pid,
       const std::unordered_map<ClassId, bool>& validVictim,
       const std::unordered_map<ClassId, bool>& validReceiver);
 
-  // marginal hits states for classes in each pools
-  std::unordered_map<PoolId, MarginalHitsState<ClassId>> classStates_;
+  // marginal hits states for classes in each pool of every tier
+  std::map<std::pair<TierId, PoolId>, MarginalHitsState<ClassId>>
+      classStates_;
 
   // Config for this strategy, this can be updated anytime.
   // Do not access this directly, always use `getConfig()` to
@@ -157,19 +157,23 @@ void MemoryMonitor::checkPoolsAndAdviseReclaim() {
 
   // Advise slabs, if marked for advise
   if (results.advise) {
+    // slabs are only advised away from the top memory tier.
+    const TierId tid = 0;
     for (auto& result : results.poolAdviseReclaimMap) {
       uint64_t slabsAdvised = 0;
       PoolId poolId = result.first;
       uint64_t slabsToAdvise = result.second;
       while (slabsAdvised < slabsToAdvise) {
-        const auto classId = strategy_->pickVictimForResizing(cache_, poolId);
+        const auto classId =
+            strategy_->pickVictimForResizing(cache_, tid, poolId);
         if (classId == Slab::kInvalidClassId) {
           break;
         }
         try {
           const auto now = util::getCurrentTimeMs();
-          auto stats = cache_.getPoolStats(poolId);
-          cache_.releaseSlab(poolId, classId, SlabReleaseMode::kAdvise);
+          auto stats = cache_.getPoolStats(tid, poolId);
+          cache_.releaseSlab(tid, poolId, classId, Slab::kInvalidClassId,
+                             SlabReleaseMode::kAdvise);
           ++slabsAdvised;
           const auto elapsed_time =
               static_cast<uint64_t>(util::getCurrentTimeMs() - now);
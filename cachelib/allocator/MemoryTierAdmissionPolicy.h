@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/TokenBucket.h>
+#include <folly/hash/SpookyHashV2.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cachelib/allocator/memory/Slab.h"
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/common/Hash.h"
+#include "cachelib/common/Time.h"
+
+namespace facebook {
+namespace cachelib {
+
+// Base class for admission policy into the memory tiers of a multi-tier
+// cache. It decides
+// 1. which tier a new allocation goes to. By default everything is allocated
+//    in the top tier and only falls through to the tiers below when the
+//    allocation there fails.
+// 2. whether an item evicted from a tier is worth demoting into the tier
+//    below it. A rejected item is evicted out of memory and, if nvmcache is
+//    enabled, goes through the regular nvmcache admission.
+//
+// The base class gathers the stats and delegates the decisions to the
+// *Impl methods.
+template <typename Cache>
+class MemoryTierAdmissionPolicy {
+ public:
+  using Item = typename Cache::Item;
+  using Key = typename Item::Key;
+
+  virtual ~MemoryTierAdmissionPolicy() = default;
+
+  // Pick the tier for a new allocation.
+  //
+  // @param key         key of the item
+  // @param size        size of the item's value
+  // @param expiryTime  expiry time of the item, 0 if it never expires
+  // @param numTiers    number of memory tiers in the cache
+  //
+  // @return  the tier to allocate from, always less than numTiers
+  virtual TierId chooseAllocationTier(Key key,
+                                      uint32_t size,
+                                      uint32_t expiryTime,
+                                      TierId numTiers) final {
+    if (numTiers <= 1) {
+      return 0;
+    }
+    const auto tid = std::min<TierId>(
+        chooseAllocationTierImpl(key, size, expiryTime, numTiers),
+        numTiers - 1);
+    if (tid > 0) {
+      allocsToLowerTier_.inc();
+    }
+    return tid;
+  }
+
+  // Decide whether an item being evicted from fromTier should be demoted
+  // into toTier.
+  virtual bool acceptDemotion(const Item& item,
+                              TierId fromTier,
+                              TierId toTier) final {
+    const bool decision = acceptDemotionImpl(item, fromTier, toTier);
+    if (decision) {
+      demotionsAccepted_.inc();
+    } else {
+      demotionsRejected_.inc();
+    }
+    return decision;
+  }
+
+  // Track access for a key. Called on every cache hit when the policy is
+  // set, for policies that need the access pattern to decide.
+  virtual void trackAccess(Key) {}
+
+  // The method that exposes stats.
+  virtual std::unordered_map<std::string, double> getCounters() final {
+    auto ctrs = getCountersImpl();
+    ctrs["mtap.allocs_to_lower_tier"] = allocsToLowerTier_.get();
+    ctrs["mtap.demotions_accepted"] = demotionsAccepted_.get();
+    ctrs["mtap.demotions_rejected"] = demotionsRejected_.get();
+    return ctrs;
+  }
+
+ protected:
+  // By default every allocation starts at the top tier.
+  virtual TierId chooseAllocationTierImpl(Key, uint32_t, uint32_t, TierId) {
+    return 0;
+  }
+
+  // By default every evicted item is demoted.
+  virtual bool acceptDemotionImpl(const Item&, TierId, TierId) { return true; }
+
+  // Implementation specific statistics.
+  // Please include a prefix with the name of implementation to avoid
+  // collision with base level stats.
+  virtual std::unordered_map<std::string, double> getCountersImpl() {
+    return {};
+  }
+
+ private:
+  AtomicCounter allocsToLowerTier_{0};
+  AtomicCounter demotionsAccepted_{0};
+  AtomicCounter demotionsRejected_{0};
+};
+
+// Places large items directly into the bottom tier, keeping the top tier for
+// the many small items that make up most of the hits per byte.
+template <typename Cache>
+class SizeTierAdmissionPolicy final : public MemoryTierAdmissionPolicy<Cache> {
+ public:
+  using Key = typename MemoryTierAdmissionPolicy<Cache>::Key;
+
+  // @param minLowerTierSize  items with a value of at least this many bytes
+  //                          are allocated in the bottom tier
+  explicit SizeTierAdmissionPolicy(uint32_t minLowerTierSize)
+      : minLowerTierSize_{minLowerTierSize} {
+    if (minLowerTierSize_ == 0) {
+      throw std::invalid_argument(
+          "Size threshold for the lower memory tier must be positive");
+    }
+  }
+
+ protected:
+  TierId chooseAllocationTierImpl(Key,
+                                  uint32_t size,
+                                  uint32_t,
+                                  TierId numTiers) override {
+    return size >= minLowerTierSize_ ? numTiers - 1 : 0;
+  }
+
+ private:
+  const uint32_t minLowerTierSize_;
+};
+
+// Rejects demotion of items that would expire soon after landing in the
+// lower tier. Writing them there costs bandwidth for little chance of a hit.
+template <typename Cache>
+class TtlTierAdmissionPolicy final : public MemoryTierAdmissionPolicy<Cache> {
+ public:
+  using Item = typename MemoryTierAdmissionPolicy<Cache>::Item;
+
+  // @param minRemainingTtlSecs  items with an expiry time closer than this
+  //                             are not demoted
+  explicit TtlTierAdmissionPolicy(uint32_t minRemainingTtlSecs)
+      : minRemainingTtlSecs_{minRemainingTtlSecs} {}
+
+ protected:
+  bool acceptDemotionImpl(const Item& item, TierId, TierId) override {
+    const auto expiryTime = item.getExpiryTime();
+    if (expiryTime == 0) {
+      return true;
+    }
+    const auto now = util::getCurrentTimeSec();
+    return expiryTime > now && expiryTime - now >= minRemainingTtlSecs_;
+  }
+
+ private:
+  const uint32_t minRemainingTtlSecs_;
+};
+
+// Demotes only items that were hit at least a configured number of times
+// recently. Accesses are counted in a sharded count-min sketch that is
+// halved once per window of accesses, so that old popularity fades. The
+// halving of a window is spread over the accesses of the next one, each
+// halving a few counters, so that no hit pays for the whole shard.
+//
+// trackAccess is called on every hit, so the counters are atomics instead
+// of a sketch behind a lock. Increments that race with the halving of their
+// counter may be lost, which only makes the counts a bit lower.
+template <typename Cache>
+class FrequencyTierAdmissionPolicy final
+    : public MemoryTierAdmissionPolicy<Cache> {
+ public:
+  using Item = typename MemoryTierAdmissionPolicy<Cache>::Item;
+  using Key = typename MemoryTierAdmissionPolicy<Cache>::Key;
+
+  struct Config {
+    // minimum number of tracked accesses for an item to be demoted
+    uint32_t minAccesses{1};
+
+    // number of keys the sketch is sized for, across all shards
+    size_t numTrackedKeys{1'000'000};
+
+    // number of accesses per shard after which the counts are halved.
+    // 0 means the size of the shard.
+    size_t decayWindow{0};
+  };
+
+  explicit FrequencyTierAdmissionPolicy(Config config)
+      : config_{config},
+        width_{std::max<size_t>(config_.numTrackedKeys / kNumShards, 1)} {
+    if (config_.minAccesses == 0 || config_.numTrackedKeys == 0) {
+      throw std::invalid_argument(
+          "Frequency admission needs positive minAccesses and numTrackedKeys");
+    }
+    if (config_.decayWindow == 0) {
+      config_.decayWindow = width_;
+    }
+    decayChunk_ =
+        (width_ * kSketchDepth + config_.decayWindow - 1) / config_.decayWindow;
+    for (auto& shard : shards_) {
+      // value initialization zeroes the counters
+      shard.counts.reset(new std::atomic<uint16_t>[width_ * kSketchDepth]());
+    }
+  }
+
+  void trackAccess(Key key) override {
+    const auto hash = hashKey(key);
+    auto& shard = getShard(hash);
+    for (uint32_t row = 0; row < kSketchDepth; row++) {
+      auto& count = shard.counts[getIndex(row, hash)];
+      auto curr = count.load(std::memory_order_relaxed);
+      // counts saturate instead of wrapping around
+      while (curr < std::numeric_limits<uint16_t>::max() &&
+             !count.compare_exchange_weak(curr, curr + 1,
+                                          std::memory_order_relaxed)) {
+      }
+    }
+    const auto numAccesses =
+        shard.numAccesses.fetch_add(1, std::memory_order_relaxed);
+    if ((numAccesses + 1) % config_.decayWindow == 0) {
+      numDecays_.inc();
+    }
+    // after the first window, every access halves its share of the counters
+    if (numAccesses >= config_.decayWindow) {
+      const size_t total = width_ * kSketchDepth;
+      const size_t begin = (numAccesses % config_.decayWindow) * decayChunk_;
+      const size_t end = std::min(begin + decayChunk_, total);
+      for (size_t i = begin; i < end; i++) {
+        shard.counts[i].store(
+            shard.counts[i].load(std::memory_order_relaxed) / 2,
+            std::memory_order_relaxed);
+      }
+    }
+  }
+
+ protected:
+  bool acceptDemotionImpl(const Item& item, TierId, TierId) override {
+    const auto hash = hashKey(item.getKey());
+    const auto& shard = getShard(hash);
+    uint16_t count = std::numeric_limits<uint16_t>::max();
+    for (uint32_t row = 0; row < kSketchDepth; row++) {
+      count = std::min(count, shard.counts[getIndex(row, hash)].load(
+                                  std::memory_order_relaxed));
+    }
+    return count >= config_.minAccesses;
+  }
+
+  std::unordered_map<std::string, double> getCountersImpl() override {
+    return {{"mtap.frequency_decays", static_cast<double>(numDecays_.get())}};
+  }
+
+ private:
+  static constexpr size_t kNumShards = 64;
+  static constexpr uint32_t kSketchDepth = 4;
+
+  // kSketchDepth rows of width_ counters
+  struct Shard {
+    std::unique_ptr<std::atomic<uint16_t>[]> counts;
+    std::atomic<uint64_t> numAccesses{0};
+  };
+
+  static uint64_t hashKey(Key key) {
+    return folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0);
+  }
+
+  Shard& getShard(uint64_t hash) { return shards_[hash % kNumShards]; }
+
+  // index of the counter of the hash in the row
+  size_t getIndex(uint32_t row, uint64_t hash) const {
+    return row * width_ + combineHashes(hashInt(row), hash) % width_;
+  }
+
+  Config config_;
+  // number of counters in a row of a shard's sketch
+  const size_t width_;
+  // number of counters an access halves, so that a window halves them all
+  size_t decayChunk_{0};
+  std::array<Shard, kNumShards> shards_;
+  AtomicCounter numDecays_{0};
+};
+
+// Caps the write bandwidth spent on demotions into each tier. Every demotion
+// consumes the item's size from a token bucket of the receiving tier and is
+// rejected once the bucket is empty.
+template <typename Cache>
+class BandwidthTierAdmissionPolicy final
+    : public MemoryTierAdmissionPolicy<Cache> {
+ public:
+  using Item = typename MemoryTierAdmissionPolicy<Cache>::Item;
+
+  // @param bytesPerSec  write budget for every tier, indexed by tier id.
+  //                     0 leaves the tier unlimited.
+  // @param burstSecs    number of seconds worth of budget that can be
+  //                     spent at once
+  explicit BandwidthTierAdmissionPolicy(std::vector<uint64_t> bytesPerSec,
+                                        double burstSecs = 1.0) {
+    if (burstSecs <= 0) {
+      throw std::invalid_argument("Bandwidth burst must be positive");
+    }
+    for (const auto rate : bytesPerSec) {
+      buckets_.push_back(
+          rate == 0 ? nullptr
+                    : std::make_unique<folly::TokenBucket>(
+                          static_cast<double>(rate), rate * burstSecs));
+    }
+  }
+
+ protected:
+  bool acceptDemotionImpl(const Item& item,
+                          TierId,
+                          TierId toTier) override {
+    if (static_cast<size_t>(toTier) >= buckets_.size() ||
+        !buckets_[toTier]) {
+      return true;
+    }
+    if (buckets_[toTier]->consume(item.getSize())) {
+      return true;
+    }
+    numOverBudget_.inc();
+    return false;
+  }
+
+  std::unordered_map<std::string, double> getCountersImpl() override {
+    return {{"mtap.bandwidth_over_budget",
+             static_cast<double>(numOverBudget_.get())}};
+  }
+
+ private:
+  std::vector<std::unique_ptr<folly::TokenBucket>> buckets_;
+  AtomicCounter numOverBudget_{0};
+};
+} // namespace cachelib
+} // namespace facebook
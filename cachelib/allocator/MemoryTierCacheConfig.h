@@ -16,7 +16,12 @@
 
 #pragma once
 
+#include <folly/Format.h>
+
+#include <optional>
 #include <string>
+#include <variant>
+#include <vector>
 
 #include "cachelib/shm/ShmCommon.h"
 
@@ -51,8 +56,48 @@ public:
     return *this;
   }
 
+  // Allocates the memory of this tier only from the given numa nodes, e.g. to
+  // place a tier on the socket that uses it or on a cpu-less memory node.
+  MemoryTierCacheConfig& setMemBind(const std::vector<size_t>& nodes) {
+    return setNumaPolicy(NumaPolicy::Mode::kBind, nodes);
+  }
+
+  // Spreads the memory of this tier page by page over the given numa nodes,
+  // which evens out the bandwidth of a tier that is shared by all sockets.
+  MemoryTierCacheConfig& setInterleave(const std::vector<size_t>& nodes) {
+    return setNumaPolicy(NumaPolicy::Mode::kInterleave, nodes);
+  }
+
+  // Backs the memory of this tier with huge pages, overriding the policy of
+  // CacheAllocatorConfig::enableHugePages for this tier. A file-backed tier
+  // can only use the hugetlb pool (kTwoMB, kOneGB) if its file is on a
+  // hugetlbfs mount.
+  MemoryTierCacheConfig& setHugePagePolicy(util::HugePagePolicy policy) {
+    hugePagePolicy = policy;
+    return *this;
+  }
+
   size_t getRatio() const noexcept { return ratio; }
 
+  // @param cachePolicy   the huge page policy of the whole cache
+  // @return the huge page policy of this tier. Without one of its own, a
+  //         shared memory tier follows the cache. A file-backed tier only
+  //         follows the transparent huge page advice, since mapping a
+  //         regular file from the hugetlb pool fails.
+  util::HugePagePolicy getHugePagePolicy(
+      util::HugePagePolicy cachePolicy) const noexcept {
+    if (hugePagePolicy) {
+      return *hugePagePolicy;
+    }
+    if (std::holds_alternative<FileShmSegmentOpts>(shmOpts) &&
+        cachePolicy != util::HugePagePolicy::kTransparent) {
+      return util::HugePagePolicy::kNone;
+    }
+    return cachePolicy;
+  }
+
+  const NumaPolicy& getNumaPolicy() const noexcept { return numaPolicy; }
+
   const ShmTypeOpts& getShmTypeOpts() const noexcept { return shmOpts; }
 
   size_t calculateTierSize(size_t totalCacheSize, size_t partitionNum) const {
@@ -70,6 +115,24 @@ public:
   }
 
 private:
+  MemoryTierCacheConfig& setNumaPolicy(NumaPolicy::Mode mode,
+                                       const std::vector<size_t>& nodes) {
+    if (nodes.empty()) {
+      throw std::invalid_argument("At least one numa node must be given.");
+    }
+    NumaBitMask mask;
+    for (auto node : nodes) {
+      if (node >= kMaxNumaNodes) {
+        throw std::invalid_argument(folly::sformat(
+            "Numa node {} is out of range. Max: {}", node, kMaxNumaNodes - 1));
+      }
+      mask.set(node);
+    }
+    numaPolicy.mode = mode;
+    numaPolicy.nodes = mask;
+    return *this;
+  }
+
   // Ratio is a number of parts of the total cache size to be allocated for this
   // tier. E.g. if X is a total cache size, Yi are ratios specified for memory
   // tiers, and Y is the sum of all Yi, then size of the i-th tier
@@ -80,6 +143,14 @@ private:
   // Options specific to shm type
   ShmTypeOpts shmOpts;
 
+  // Numa nodes the memory of this tier is placed on. By default the pages go
+  // to the node of the thread that touches them first.
+  NumaPolicy numaPolicy;
+
+  // Huge pages that back the memory of this tier. Unset to follow the policy
+  // of the cache.
+  std::optional<util::HugePagePolicy> hugePagePolicy;
+
   MemoryTierCacheConfig() = default;
 };
 } // namespace cachelib
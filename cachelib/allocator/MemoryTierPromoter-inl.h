@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+namespace facebook {
+namespace cachelib {
+
+template <typename CacheT>
+MemoryTierPromoter<CacheT>::MemoryTierPromoter(Cache& cache,
+                                               uint32_t hitsToPromote,
+                                               uint32_t maxPromotionsPerRun)
+    : cache_(cache),
+      hitsToPromote_(hitsToPromote),
+      maxPromotionsPerRun_(maxPromotionsPerRun) {}
+
+template <typename CacheT>
+MemoryTierPromoter<CacheT>::~MemoryTierPromoter() {
+  stop(std::chrono::seconds(0));
+}
+
+template <typename CacheT>
+void MemoryTierPromoter<CacheT>::work() {
+  std::string key;
+  size_t numCandidates = 0;
+  uint32_t numPromoted = 0;
+  while (numPromoted < maxPromotionsPerRun_ &&
+         numCandidates < kMaxCandidatesPerRun &&
+         MemoryTierPromoterAPIWrapper<CacheT>::popPromotionCandidate(cache_,
+                                                                     key)) {
+    ++numCandidates;
+    auto it = hits_.find(key);
+    const auto hits = it == hits_.end() ? 1 : it->second + 1;
+    if (hits < hitsToPromote_) {
+      if (it == hits_.end()) {
+        hits_.emplace(key, hits);
+      } else {
+        it->second = hits;
+      }
+      continue;
+    }
+
+    if (it != hits_.end()) {
+      hits_.erase(it);
+    }
+
+    try {
+      if (MemoryTierPromoterAPIWrapper<CacheT>::tryPromoteToUpperMemoryTier(
+              cache_, key)) {
+        ++numPromoted;
+      }
+    } catch (const std::exception& e) {
+      XLOGF(DBG, "Error while promoting key {}. Msg = {}", key, e.what());
+    }
+  }
+
+  if (hits_.size() > kMaxTrackedKeys) {
+    hits_.clear();
+  }
+}
+
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/container/F14Map.h>
+#include <folly/logging/xlog.h>
+
+#include <string>
+
+#include "cachelib/common/PeriodicWorker.h"
+
+namespace facebook {
+namespace cachelib {
+
+// wrapper that exposes the private APIs of CacheType that are specifically
+// needed for the MemoryTierPromoter.
+template <typename C>
+struct MemoryTierPromoterAPIWrapper {
+  static bool popPromotionCandidate(C& cache, std::string& key) {
+    return cache.popPromotionCandidate(key);
+  }
+
+  static bool tryPromoteToUpperMemoryTier(C& cache, folly::StringPiece key) {
+    return cache.tryPromoteToUpperMemoryTier(key);
+  }
+};
+
+// Moves items that are hit repeatedly in a lower memory tier back to the
+// tier above it. The cache queues a candidate for every hit on an item that
+// lives outside of tier 0 and this worker counts the hits per key, promoting
+// the item once it has seen enough of them.
+template <typename CacheT>
+class MemoryTierPromoter : public PeriodicWorker {
+ public:
+  using Cache = CacheT;
+  // @param cache                 instance of the cache
+  // @param hitsToPromote         number of hits after which an item is
+  //                              promoted
+  // @param maxPromotionsPerRun   upper bound on the items promoted in a
+  //                              single run of the worker
+  MemoryTierPromoter(Cache& cache,
+                     uint32_t hitsToPromote,
+                     uint32_t maxPromotionsPerRun);
+
+  ~MemoryTierPromoter();
+
+ private:
+  // implement logic in the virtual function in PeriodicWorker
+  // drain the queued candidates and promote the ones that are hot enough
+  void work() override final;
+
+  // reference to the cache
+  Cache& cache_;
+
+  const uint32_t hitsToPromote_;
+  const uint32_t maxPromotionsPerRun_;
+
+  // hits seen for keys that have not reached hitsToPromote_ yet. Only
+  // accessed from the worker thread.
+  folly::F14FastMap<std::string, uint32_t> hits_;
+
+  // number of candidates to drain in a run before yielding. This bounds a run
+  // when the lower tier sees a steady stream of hits.
+  static constexpr const size_t kMaxCandidatesPerRun = 1 << 16;
+
+  // once we track more keys than this, we forget all of them so that only
+  // recent hits count towards promotion.
+  static constexpr const size_t kMaxTrackedKeys = 1 << 16;
+};
+
+} // namespace cachelib
+} // namespace facebook
+
+#include "cachelib/allocator/MemoryTierPromoter-inl.h"
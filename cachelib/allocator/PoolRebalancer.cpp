@@ -39,28 +39,32 @@ PoolRebalancer::~PoolRebalancer() { stop(std::chrono::seconds(0)); }
 
 void PoolRebalancer::work() {
   try {
-    for (const auto pid : cache_.getRegularPoolIds()) {
-      auto strategy = cache_.getRebalanceStrategy(pid);
-      if (!strategy) {
-        strategy = defaultStrategy_;
+    for (TierId tid = 0; tid < static_cast<TierId>(cache_.getNumTiers());
+         tid++) {
+      for (const auto pid : cache_.getRegularPoolIds()) {
+        auto strategy = cache_.getRebalanceStrategy(pid);
+        if (!strategy) {
+          strategy = defaultStrategy_;
+        }
+        tryRebalancing(tid, pid, *strategy);
       }
-      tryRebalancing(pid, *strategy);
     }
   } catch (const std::exception& ex) {
     XLOGF(ERR, "Rebalancing interrupted due to exception: {}", ex.what());
   }
 }
 
-void PoolRebalancer::releaseSlab(PoolId pid,
+void PoolRebalancer::releaseSlab(TierId tid,
+                                 PoolId pid,
                                  ClassId victimClassId,
                                  ClassId receiverClassId) {
   const auto now = util::getCurrentTimeMs();
 
-  cache_.releaseSlab(pid, victimClassId, receiverClassId,
+  cache_.releaseSlab(tid, pid, victimClassId, receiverClassId,
                      SlabReleaseMode::kRebalance);
   const auto elapsed_time =
       static_cast<uint64_t>(util::getCurrentTimeMs() - now);
-  const PoolStats poolStats = cache_.getPoolStats(pid);
+  const PoolStats poolStats = cache_.getPoolStats(tid, pid);
   unsigned int numSlabsInReceiver = 0;
   uint32_t receiverAllocSize = 0;
   uint64_t receiverEvictionAge = 0;
@@ -76,14 +80,15 @@ void PoolRebalancer::releaseSlab(PoolId pid,
       poolStats.evictionAgeForClass(victimClassId), receiverEvictionAge,
       poolStats.mpStats.acStats.at(victimClassId).freeAllocs);
   XLOGF(DBG,
-        "Moved slab in Pool Id: {}, Victim Class Id: {}, Receiver "
-        "Class Id: {}",
-        static_cast<int>(pid), static_cast<int>(victimClassId),
-        static_cast<int>(receiverClassId));
+        "Moved slab in Tier Id: {}, Pool Id: {}, Victim Class Id: {}, "
+        "Receiver Class Id: {}",
+        static_cast<int>(tid), static_cast<int>(pid),
+        static_cast<int>(victimClassId), static_cast<int>(receiverClassId));
 }
 
-RebalanceContext PoolRebalancer::pickVictimByFreeAlloc(PoolId pid) const {
-  const auto& mpStats = cache_.getPool(pid).getStats();
+RebalanceContext PoolRebalancer::pickVictimByFreeAlloc(TierId tid,
+                                                       PoolId pid) const {
+  const auto& mpStats = cache_.getPoolByTid(pid, tid).getStats();
   uint64_t maxFreeAllocSlabs = 1;
   ClassId retId = Slab::kInvalidClassId;
   for (auto& id : mpStats.classIds) {
@@ -102,26 +107,28 @@ RebalanceContext PoolRebalancer::pickVictimByFreeAlloc(PoolId pid) const {
   return ctx;
 }
 
-bool PoolRebalancer::tryRebalancing(PoolId pid, RebalanceStrategy& strategy) {
+bool PoolRebalancer::tryRebalancing(TierId tid,
+                                    PoolId pid,
+                                    RebalanceStrategy& strategy) {
   if (freeAllocThreshold_ > 0) {
-    auto ctx = pickVictimByFreeAlloc(pid);
+    auto ctx = pickVictimByFreeAlloc(tid, pid);
     if (ctx.victimClassId != Slab::kInvalidClassId) {
-      releaseSlab(pid, ctx.victimClassId, Slab::kInvalidClassId);
+      releaseSlab(tid, pid, ctx.victimClassId, Slab::kInvalidClassId);
     }
   }
 
-  if (!cache_.getPool(pid).allSlabsAllocated()) {
+  if (!cache_.getPoolByTid(pid, tid).allSlabsAllocated()) {
     return false;
   }
 
-  const auto context = strategy.pickVictimAndReceiver(cache_, pid);
+  const auto context = strategy.pickVictimAndReceiver(cache_, tid, pid);
   if (context.victimClassId == Slab::kInvalidClassId) {
     XLOGF(DBG,
-          "Pool Id: {} rebalancing strategy didn't find an victim",
-          static_cast<int>(pid));
+          "Tier Id: {}, Pool Id: {} rebalancing strategy didn't find an victim",
+          static_cast<int>(tid), static_cast<int>(pid));
     return false;
   }
-  releaseSlab(pid, context.victimClassId, context.receiverClassId);
+  releaseSlab(tid, pid, context.victimClassId, context.receiverClassId);
   return true;
 }
 
@@ -28,7 +28,8 @@ namespace facebook {
 namespace cachelib {
 
 // Periodic worker that rebalances slabs within each pool so that new
-// allocations are less likely to fail. For each pool:
+// allocations are less likely to fail. Every memory tier holds its own share
+// of the pool and is rebalanced independently. For each pool in each tier:
 // 1. If there is any allocation class with a high free-alloc-slab (see
 // constructors documentation for definition), release a slab from that class.
 // Else
@@ -59,20 +60,21 @@ class PoolRebalancer : public PeriodicWorker {
   //  2. analyzing the stats by using the rebalance strategy
   //  3. rebalance
   //
+  // @param tid       memory tier of the pool
   // @param pid       pool to rebalance
   // @param strategy  rebalancing strategy to use for this pool
   //
   // @return true   A rebalance operation was applied successfully to the
   //                memory pool
   //         false  There was no need for rebalancing
-  bool tryRebalancing(PoolId pid, RebalanceStrategy& strategy);
+  bool tryRebalancing(TierId tid, PoolId pid, RebalanceStrategy& strategy);
 
   // Pick only the victim which has number of free allocs per number of
   // allocs per slab above the 'freeAllocThreshold_' ratio. If there are
   // multiple such slab classes, the slab class with highest ratio is picked
-  RebalanceContext pickVictimByFreeAlloc(PoolId pid) const;
+  RebalanceContext pickVictimByFreeAlloc(TierId tid, PoolId pid) const;
 
-  void releaseSlab(PoolId pid, ClassId victim, ClassId receiver);
+  void releaseSlab(TierId tid, PoolId pid, ClassId victim, ClassId receiver);
   // cache allocator's interface for rebalancing
   CacheBase& cache_;
 
@@ -37,10 +37,12 @@ class PoolResizeStrategy : public RebalanceStrategy {
       : RebalanceStrategy(PoolResize), minSlabsPerAllocClass_(minSlabs) {}
 
   // implementation that picks a victim
-  ClassId pickVictimImpl(const CacheBase& cache, PoolId poolId) final {
+  ClassId pickVictimImpl(const CacheBase& cache,
+                         TierId tid,
+                         PoolId poolId) final {
     // pick the class with maximum eviction age. also, ensure that the class
     // does not drop below threshold of slabs.
-    const auto stats = cache.getPoolStats(poolId);
+    const auto stats = cache.getPoolStats(tid, poolId);
 
     auto victims = filterByNumEvictableSlabs(
         stats, stats.getClassIds(), minSlabsPerAllocClass_);
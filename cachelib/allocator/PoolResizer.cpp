@@ -38,63 +38,79 @@ PoolResizer::PoolResizer(CacheBase& cache,
 PoolResizer::~PoolResizer() { stop(std::chrono::seconds(0)); }
 
 void PoolResizer::work() {
-  const auto pools = cache_.getRegularPoolIdsForResize();
-  for (auto poolId : pools) {
-    const PoolStats poolStats = cache_.getPoolStats(poolId);
-    for (unsigned int i = 0; i < numSlabsPerIteration_; i++) {
-      // check if the pool still needs resizing after each iteration.
-      if (!cache_.getPool(poolId).overLimit()) {
-        continue;
-      }
-      // if user had supplied a rebalance stategy for the pool,
-      // use that to downsize it
-      auto strategy = cache_.getResizeStrategy(poolId);
-      if (!strategy) {
-        strategy = strategy_;
-      }
-
-      // use the rebalance strategy and see if there is some allocation class
-      // that is over provisioned.
-      const auto classId = strategy->pickVictimForResizing(cache_, poolId);
-
-      try {
-        const auto now = util::getCurrentTimeMs();
-        // Throws excption if the strategy did not pick a valid victim classId.
-        cache_.releaseSlab(poolId, classId, SlabReleaseMode::kResize);
-        XLOGF(DBG, "Moved a slab from classId {} for poolid: {}",
-              static_cast<int>(classId), static_cast<int>(poolId));
-        ++slabsReleased_;
-        const auto elapsed_time =
-            static_cast<uint64_t>(util::getCurrentTimeMs() - now);
-        // Log the event about the Pool which released the Slab along with
-        // the number of slabs. Only Victim Pool class information is
-        // relevant here.
-        stats_.addSlabReleaseEvent(
-            classId, Slab::kInvalidClassId, /* No receiver Class info */
-            elapsed_time, poolId, 1, 1,     /* One Slab moved */
-            poolStats.allocSizeForClass(classId), 0,
-            poolStats.evictionAgeForClass(classId), 0,
-            poolStats.mpStats.acStats.at(classId).freeAllocs);
-      } catch (const exception::SlabReleaseAborted& e) {
-        XLOGF(WARN,
-              "Aborted trying to resize pool {} for allocation class {}. "
-              "Error: {}",
-              static_cast<int>(poolId), static_cast<int>(classId), e.what());
+  bool anyPoolResized = false;
+  for (TierId tid = 0; tid < static_cast<TierId>(cache_.getNumTiers());
+       tid++) {
+    const auto pools = cache_.getRegularPoolIdsForResize(tid);
+    anyPoolResized |= !pools.empty();
+    for (auto poolId : pools) {
+      if (!resizePool(tid, poolId)) {
         return;
-      } catch (const std::exception& e) {
-        XLOGF(
-            CRITICAL,
-            "Error trying to resize pool {} for allocation class {}. Error: {}",
-            static_cast<int>(poolId), static_cast<int>(classId), e.what());
       }
     }
   }
 
   // compact cache resizing is heavy weight and involves resharding. do that
   // only when all the item pools are resized
-  if (pools.empty()) {
+  if (!anyPoolResized) {
     cache_.resizeCompactCaches();
   }
 }
+
+bool PoolResizer::resizePool(TierId tid, PoolId poolId) {
+  const PoolStats poolStats = cache_.getPoolStats(tid, poolId);
+  for (unsigned int i = 0; i < numSlabsPerIteration_; i++) {
+    // check if the pool still needs resizing after each iteration.
+    if (!cache_.getPoolByTid(poolId, tid).overLimit()) {
+      continue;
+    }
+    // if user had supplied a rebalance stategy for the pool,
+    // use that to downsize it
+    auto strategy = cache_.getResizeStrategy(poolId);
+    if (!strategy) {
+      strategy = strategy_;
+    }
+
+    // use the rebalance strategy and see if there is some allocation class
+    // that is over provisioned.
+    const auto classId = strategy->pickVictimForResizing(cache_, tid, poolId);
+
+    try {
+      const auto now = util::getCurrentTimeMs();
+      // Throws excption if the strategy did not pick a valid victim classId.
+      cache_.releaseSlab(tid, poolId, classId, Slab::kInvalidClassId,
+                         SlabReleaseMode::kResize);
+      XLOGF(DBG, "Moved a slab from classId {} for poolid: {} in tier: {}",
+            static_cast<int>(classId), static_cast<int>(poolId),
+            static_cast<int>(tid));
+      ++slabsReleased_;
+      const auto elapsed_time =
+          static_cast<uint64_t>(util::getCurrentTimeMs() - now);
+      // Log the event about the Pool which released the Slab along with
+      // the number of slabs. Only Victim Pool class information is
+      // relevant here.
+      stats_.addSlabReleaseEvent(
+          classId, Slab::kInvalidClassId, /* No receiver Class info */
+          elapsed_time, poolId, 1, 1,     /* One Slab moved */
+          poolStats.allocSizeForClass(classId), 0,
+          poolStats.evictionAgeForClass(classId), 0,
+          poolStats.mpStats.acStats.at(classId).freeAllocs);
+    } catch (const exception::SlabReleaseAborted& e) {
+      XLOGF(WARN,
+            "Aborted trying to resize pool {} in tier {} for allocation class "
+            "{}. Error: {}",
+            static_cast<int>(poolId), static_cast<int>(tid),
+            static_cast<int>(classId), e.what());
+      return false;
+    } catch (const std::exception& e) {
+      XLOGF(CRITICAL,
+            "Error trying to resize pool {} in tier {} for allocation class "
+            "{}. Error: {}",
+            static_cast<int>(poolId), static_cast<int>(tid),
+            static_cast<int>(classId), e.what());
+    }
+  }
+  return true;
+}
 } // namespace cachelib
 } // namespace facebook
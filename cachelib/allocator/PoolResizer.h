@@ -27,8 +27,8 @@ namespace facebook {
 namespace cachelib {
 
 // Periodic worker that resizes pools.
-// For each pool that is over the limit, the worker attempts to release up to a
-// certain number of slabs.
+// For each pool that is over the limit in any memory tier, the worker attempts
+// to release up to a certain number of slabs from that tier.
 class PoolResizer : public PeriodicWorker {
  public:
   // @param cache                 the cache interace
@@ -59,6 +59,13 @@ class PoolResizer : public PeriodicWorker {
   //          Slab::kInvalidClassId if all the allocation classes are exhausted
   ClassId pickVictim(PoolId poolId);
 
+  // release up to numSlabsPerIteration_ slabs from the pool's share of the
+  // given tier while it is over its limit.
+  //
+  // @return false if a slab release was aborted and resizing should stop for
+  //         this round.
+  bool resizePool(TierId tid, PoolId poolId);
+
   // cache's interface for rebalancing
   CacheBase& cache_;
 
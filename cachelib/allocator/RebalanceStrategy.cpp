@@ -26,16 +26,19 @@ using detail::Info;
 const RebalanceContext RebalanceStrategy::kNoOpContext = {
     Slab::kInvalidClassId, Slab::kInvalidClassId};
 
-void RebalanceStrategy::recordCurrentState(PoolId pid, const PoolStats& stats) {
-  auto& currRecord = poolState_[pid];
+void RebalanceStrategy::recordCurrentState(TierId tid,
+                                           PoolId pid,
+                                           const PoolStats& stats) {
+  auto& currRecord = poolState_[{tid, pid}];
   for (const auto i : stats.getClassIds()) {
     currRecord[i].updateRecord(stats);
   }
 }
 
 ClassId RebalanceStrategy::pickAnyClassIdForResizing(const CacheBase& cache,
+                                                     TierId tid,
                                                      PoolId pid) {
-  const auto stats = cache.getPoolStats(pid);
+  const auto stats = cache.getPoolStats(tid, pid);
   const auto& candidates = stats.mpStats.classIds;
   // pick victim by maximum number of slabs.
   const auto ret = *std::max_element(
@@ -53,9 +56,11 @@ ClassId RebalanceStrategy::pickAnyClassIdForResizing(const CacheBase& cache,
   return ret;
 }
 
-void RebalanceStrategy::initPoolState(PoolId pid, const PoolStats& stats) {
+void RebalanceStrategy::initPoolState(TierId tid,
+                                      PoolId pid,
+                                      const PoolStats& stats) {
   // default initialize
-  auto& curr = poolState_[pid];
+  auto& curr = poolState_[{tid, pid}];
   for (auto id : stats.getClassIds()) {
     curr[id] =
         Info{id, stats.mpStats.acStats.at(id).totalSlabs(),
@@ -176,9 +181,12 @@ std::set<ClassId> RebalanceStrategy::filter(
 }
 
 std::set<ClassId> RebalanceStrategy::filterVictimsByHoldOff(
-    PoolId pid, const PoolStats& stats, std::set<ClassId> victims) {
-  auto condition = [this, &stats, pid](const ClassId& id) {
-    auto& currRecord = poolState_.at(pid).at(id);
+    TierId tid,
+    PoolId pid,
+    const PoolStats& stats,
+    std::set<ClassId> victims) {
+  auto condition = [this, &stats, tid, pid](const ClassId& id) {
+    auto& currRecord = poolState_.at({tid, pid}).at(id);
     if (!currRecord.isOnHoldOff()) {
       return false;
     }
@@ -196,63 +204,67 @@ std::set<ClassId> RebalanceStrategy::filterVictimsByHoldOff(
 }
 
 RebalanceContext RebalanceStrategy::pickVictimAndReceiver(
-    const CacheBase& cache, PoolId pid) {
+    const CacheBase& cache, TierId tid, PoolId pid) {
   return executeAndRecordCurrentState<RebalanceContext>(
       cache,
+      tid,
       pid,
       [&]() {
         // Pick receiver based on allocation failures. If nothing found,
         // fall back to strategy specific Impl
         RebalanceContext ctx;
-        ctx.receiverClassId = pickReceiverWithAllocFailures(cache, pid);
+        ctx.receiverClassId = pickReceiverWithAllocFailures(cache, tid, pid);
         if (ctx.receiverClassId != Slab::kInvalidClassId) {
-          ctx.victimClassId = pickVictimImpl(cache, pid);
+          ctx.victimClassId = pickVictimImpl(cache, tid, pid);
           if (ctx.victimClassId == cachelib::Slab::kInvalidClassId) {
-            ctx.victimClassId = pickAnyClassIdForResizing(cache, pid);
+            ctx.victimClassId = pickAnyClassIdForResizing(cache, tid, pid);
           }
           if (ctx.victimClassId != Slab::kInvalidClassId &&
               ctx.victimClassId != ctx.receiverClassId &&
-              getPoolState(pid).at(ctx.victimClassId).nSlabs > 1) {
+              getPoolState(tid, pid).at(ctx.victimClassId).nSlabs > 1) {
             // start a hold off so that the receiver does not become a victim
             // soon enough.
-            getPoolState(pid).at(ctx.receiverClassId).startHoldOff();
+            getPoolState(tid, pid).at(ctx.receiverClassId).startHoldOff();
             return ctx;
           }
         }
-        return pickVictimAndReceiverImpl(cache, pid);
+        return pickVictimAndReceiverImpl(cache, tid, pid);
       },
       kNoOpContext);
 }
 
 ClassId RebalanceStrategy::pickVictimForResizing(const CacheBase& cache,
+                                                 TierId tid,
                                                  PoolId pid) {
   // Pick only the victim irrespective of who is receiving the slab. This is
   // used mostly for pool resizing.
   auto victimClassId = executeAndRecordCurrentState<ClassId>(
       cache,
+      tid,
       pid,
-      [&]() { return pickVictimImpl(cache, pid); },
+      [&]() { return pickVictimImpl(cache, tid, pid); },
       Slab::kInvalidClassId);
 
   if (victimClassId == cachelib::Slab::kInvalidClassId) {
-    victimClassId = pickAnyClassIdForResizing(cache, pid);
+    victimClassId = pickAnyClassIdForResizing(cache, tid, pid);
   }
 
   return victimClassId;
 }
 
 ClassId RebalanceStrategy::pickReceiverWithAllocFailures(const CacheBase& cache,
+                                                         TierId tid,
                                                          PoolId pid) {
-  const auto stats = cache.getPoolStats(pid);
+  const auto stats = cache.getPoolStats(tid, pid);
   auto receivers = stats.getClassIds();
 
-  const auto receiverWithAllocFailures =
-      filterByAllocFailure(stats, std::move(receivers), getPoolState(pid));
+  const auto receiverWithAllocFailures = filterByAllocFailure(
+      stats, std::move(receivers), getPoolState(tid, pid));
   if (receiverWithAllocFailures.empty()) {
     return Slab::kInvalidClassId;
   }
 
-  const auto& poolState = getPoolState(pid);
+  const auto& poolState = getPoolState(tid, pid);
   // pick the receiver with the most allocation failures
   return *std::max_element(receiverWithAllocFailures.begin(),
                            receiverWithAllocFailures.end(),
@@ -265,21 +277,22 @@ ClassId RebalanceStrategy::pickReceiverWithAllocFailures(const CacheBase& cache,
 template <typename T>
 T RebalanceStrategy::executeAndRecordCurrentState(
     const CacheBase& cache,
+    TierId tid,
     PoolId pid,
     const std::function<T()>& impl,
     T noOp) {
-  const auto poolStats = cache.getPoolStats(pid);
+  const auto poolStats = cache.getPoolStats(tid, pid);
 
   // if this is the first time we are encountering this pool, initialize
   // the state and not do anything at the moment.
-  if (!poolStatePresent(pid)) {
-    initPoolState(pid, poolStats);
+  if (!poolStatePresent(tid, pid)) {
+    initPoolState(tid, pid, poolStats);
     return noOp;
   }
 
   auto rv = impl();
 
-  recordCurrentState(pid, poolStats);
+  recordCurrentState(tid, pid, poolStats);
 
   return rv;
 }
@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <map>
+#include <utility>
+
 #include "cachelib/allocator/Cache.h"
 #include "cachelib/allocator/RebalanceInfo.h"
 #include "cachelib/allocator/memory/Slab.h"
@@ -63,17 +66,31 @@ class RebalanceStrategy {
 
   virtual ~RebalanceStrategy() = default;
 
-  // Pick an victim and receiver from the same pool
+  // Pick an victim and receiver from the same pool, in the top memory tier
   //
   // @param allocator   Cache allocator that implements CacheBase @param pid
   // Pool to rebalance
   //
   // @return RebalanceContext   contains victim and receiver
-  RebalanceContext pickVictimAndReceiver(const CacheBase& cache, PoolId pid);
+  RebalanceContext pickVictimAndReceiver(const CacheBase& cache, PoolId pid) {
+    return pickVictimAndReceiver(cache, 0, pid);
+  }
+
+  // Same as above, for the pool's share of memory in the given tier. The
+  // state used to compute deltas is kept separately for every tier.
+  RebalanceContext pickVictimAndReceiver(const CacheBase& cache,
+                                         TierId tid,
+                                         PoolId pid);
 
   // Pick only the victim irrespective of who is receiving the slab. This is
-  // used mostly for pool resizing.
-  ClassId pickVictimForResizing(const CacheBase& cache, PoolId pid);
+  // used mostly for pool resizing. Picks from the top memory tier.
+  ClassId pickVictimForResizing(const CacheBase& cache, PoolId pid) {
+    return pickVictimForResizing(cache, 0, pid);
+  }
+
+  ClassId pickVictimForResizing(const CacheBase& cache,
+                                TierId tid,
+                                PoolId pid);
 
   virtual void updateConfig(const BaseConfig&) {}
 
@@ -83,7 +100,26 @@ class RebalanceStrategy {
   using PoolState = std::array<detail::Info, MemoryAllocator::kMaxClasses>;
   static const RebalanceContext kNoOpContext;
 
-  virtual RebalanceContext pickVictimAndReceiverImpl(const CacheBase&, PoolId) {
+  // Strategies override these to pick from the pool's share of memory in
+  // the given tier. By default the top tier is handed to the overloads
+  // without a tier below, and the other tiers are left alone.
+  virtual RebalanceContext pickVictimAndReceiverImpl(const CacheBase& cache,
+                                                     TierId tid,
+                                                     PoolId pid) {
+    return tid == 0 ? pickVictimAndReceiverImpl(cache, pid) : kNoOpContext;
+  }
+
+  virtual ClassId pickVictimImpl(const CacheBase& cache,
+                                 TierId tid,
+                                 PoolId pid) {
+    return tid == 0 ? pickVictimImpl(cache, pid) : Slab::kInvalidClassId;
+  }
+
+  // Deprecated. Strategies written before memory tiers override these, and
+  // keep working for the top tier. New strategies override the overloads
+  // that take a tier.
+  virtual RebalanceContext pickVictimAndReceiverImpl(const CacheBase&,
+                                                     PoolId) {
     return {};
   }
 
@@ -93,12 +129,16 @@ class RebalanceStrategy {
 
   // Returns true if the state was already initialized and set up. False if we
   // state was not present.
-  bool poolStatePresent(PoolId pid) const {
-    return poolState_.find(pid) != poolState_.end();
+  bool poolStatePresent(TierId tid, PoolId pid) const {
+    return poolState_.find({tid, pid}) != poolState_.end();
   }
 
-  PoolState& getPoolState(PoolId pid) { return poolState_.at(pid); }
-  const PoolState& getPoolState(PoolId pid) const { return poolState_.at(pid); }
+  PoolState& getPoolState(TierId tid, PoolId pid) {
+    return poolState_.at({tid, pid});
+  }
+  const PoolState& getPoolState(TierId tid, PoolId pid) const {
+    return poolState_.at({tid, pid});
+  }
 
   // filter the candidates based on whether they have enough slabs to be a
   // victim. This is based on config_.minSlabs
@@ -137,7 +177,8 @@ class RebalanceStrategy {
 
   // filter the candidates based on whether they recently gained a slab and
   // are in hold off period.
-  std::set<ClassId> filterVictimsByHoldOff(PoolId pid,
+  std::set<ClassId> filterVictimsByHoldOff(TierId tid,
+                                           PoolId pid,
                                            const PoolStats& stats,
                                            std::set<ClassId> victims);
 
@@ -148,18 +189,22 @@ class RebalanceStrategy {
 
  private:
   // picks any of the class id ordered by the total slabs.
-  ClassId pickAnyClassIdForResizing(const CacheBase& cache, PoolId pid);
+  ClassId pickAnyClassIdForResizing(const CacheBase& cache,
+                                    TierId tid,
+                                    PoolId pid);
 
   // initialize the pool's state to the current stats.
-  void initPoolState(PoolId pid, const PoolStats& stats);
+  void initPoolState(TierId tid, PoolId pid, const PoolStats& stats);
 
   // process the stats for this pool and apply them to the previous state.
   // Get deltas for evictions and hits and determine if a slab got added.
-  void recordCurrentState(PoolId pid, const PoolStats& stats);
+  void recordCurrentState(TierId tid, PoolId pid, const PoolStats& stats);
 
   // Pick a receiver with max alloc failures. If no alloc failures, return
   // invalid classid.
-  ClassId pickReceiverWithAllocFailures(const CacheBase& cache, PoolId pid);
+  ClassId pickReceiverWithAllocFailures(const CacheBase& cache,
+                                        TierId tid,
+                                        PoolId pid);
 
   // Ensure pool state is initialized before calling impl, and update pool
   // state after calling impl.
@@ -170,17 +215,20 @@ class RebalanceStrategy {
   // first time encountering a pool
   template <typename T>
   T executeAndRecordCurrentState(const CacheBase& cache,
+                                 TierId tid,
                                  PoolId pid,
                                  const std::function<T()>& impl,
                                  T noOp);
 
   Type type_{NumTypes};
 
-  // maintain the state of the previous snapshot of pool for every pool.  We
-  // ll use this for processing and getting the deltas for some of these.
-  std::unordered_map<PoolId, PoolState> poolState_;
+  // maintain the state of the previous snapshot of pool for every pool in
+  // every tier.  We ll use this for processing and getting the deltas for
+  // some of these.
+  std::map<std::pair<TierId, PoolId>, PoolState> poolState_;
 
   FRIEND_TEST(RebalanceStrategy, Basic);
+  FRIEND_TEST(RebalanceStrategy, PreTierOverrides);
 };
 
 } // namespace cachelib
@@ -120,6 +120,11 @@ class FOLLY_PACK_ATTR RefcountWithFlags {
     // when Item is moved between memory tiers.
     kIncomplete,
 
+    // The payload of the item is compressed by the ValueCompressor of its
+    // pool. Binaries that do not know the flag would read the compressed
+    // payload as the value, so it came with a kCacheRamFormatVersion bump.
+    kValueCompressed,
+
     // Unused. This is just to indciate the maximum number of flags
     kFlagMax,
   };
@@ -342,6 +347,14 @@ class FOLLY_PACK_ATTR RefcountWithFlags {
   void unmarkIncomplete() noexcept { return unSetFlag<kIncomplete>(); }
   bool isIncomplete() const noexcept { return isFlagSet<kIncomplete>(); }
 
+  /**
+   * Marks that the payload of the item is compressed
+   */
+  void markValueCompressed() noexcept { return setFlag<kValueCompressed>(); }
+  bool isValueCompressed() const noexcept {
+    return isFlagSet<kValueCompressed>();
+  }
+
   // Whether or not an item is completely drained of access
   // Refcount is 0 and the item is not linked, accessible, nor moving
   bool isDrained() const noexcept { return getRefWithAccessAndAdmin() == 0; }
@@ -378,6 +391,17 @@ class FOLLY_PACK_ATTR RefcountWithFlags {
   bool isFlagSet() const noexcept {
     return getRaw() & getFlag<flagBit>();
   }
+  // set the flag and return true if it was not set before. Of several
+  // callers racing to set it, exactly one gets true.
+  template <Flags flagBit>
+  bool trySetFlag() noexcept {
+    static_assert(flagBit >= kNumAccessRefBits + kNumAdminRefBits,
+                  "incorrect flag");
+    static_assert(flagBit < NumBits<Value>::value, "incorrect flag");
+    constexpr Value bitMask = (static_cast<Value>(1) << flagBit);
+    return !(__atomic_fetch_or(&refCount_, bitMask, __ATOMIC_ACQ_REL) &
+             bitMask);
+  }
 
  private:
   template <Flags flagBit>
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/logging/xlog.h>
+
+#include "cachelib/common/Exceptions.h"
+
+namespace facebook {
+namespace cachelib {
+
+template <typename CacheT>
+SlabCompactor<CacheT>::SlabCompactor(Cache& cache,
+                                     unsigned int slabsPerIteration,
+                                     unsigned int minFreePercent)
+    : cache_(cache),
+      slabsPerIteration_(slabsPerIteration),
+      minFreePercent_(minFreePercent) {}
+
+template <typename CacheT>
+SlabCompactor<CacheT>::~SlabCompactor() {
+  stop(std::chrono::seconds(0));
+}
+
+template <typename CacheT>
+void SlabCompactor<CacheT>::work() {
+  using Wrapper = SlabCompactorAPIWrapper<CacheT>;
+
+  slabsLeft_ = slabsPerIteration_;
+  const auto numTiers = Wrapper::getNumTiers(cache_);
+  for (TierId tid = 0; tid < static_cast<TierId>(numTiers); tid++) {
+    for (const auto pid : Wrapper::getRegularPoolIds(cache_)) {
+      const auto& pool = Wrapper::getPool(cache_, tid, pid);
+      for (ClassId cid = 0; cid < static_cast<ClassId>(pool.getNumClassId());
+           cid++) {
+        if (slabsLeft_ == 0 || shouldStopWork()) {
+          return;
+        }
+        if (!compactClass(tid, pid, cid,
+                          pool.getAllocationClass(cid).getStats())) {
+          return;
+        }
+      }
+    }
+  }
+}
+
+template <typename CacheT>
+bool SlabCompactor<CacheT>::compactClass(TierId tid,
+                                         PoolId pid,
+                                         ClassId cid,
+                                         const ACStats& stats) {
+  using Wrapper = SlabCompactorAPIWrapper<CacheT>;
+
+  // the items of a slab fit in the other slabs of the class only if the free
+  // allocations of the class add up to at least a slab.
+  if (stats.freeSlabs == 0 && stats.freeAllocs < stats.allocsPerSlab) {
+    return true;
+  }
+
+  const auto [slab, numFree] = Wrapper::getSparsestSlab(cache_, tid, pid, cid);
+  if (slab == nullptr ||
+      numFree * 100ULL < stats.allocsPerSlab * uint64_t{minFreePercent_}) {
+    return true;
+  }
+
+  try {
+    Wrapper::compactSlab(cache_, tid, pid, cid, slab);
+    XLOGF(DBG,
+          "Compacted a slab with {} free allocations from classId {} for "
+          "poolid: {} in tier: {}",
+          numFree, static_cast<int>(cid), static_cast<int>(pid),
+          static_cast<int>(tid));
+    numSlabsCompacted_.fetch_add(1, std::memory_order_relaxed);
+    --slabsLeft_;
+  } catch (const exception::SlabReleaseAborted& e) {
+    XLOGF(WARN,
+          "Aborted trying to compact pool {} in tier {} for allocation class "
+          "{}. Error: {}",
+          static_cast<int>(pid), static_cast<int>(tid), static_cast<int>(cid),
+          e.what());
+    return false;
+  } catch (const std::exception& e) {
+    // the slab could have been picked for release by someone else since we
+    // found it.
+    XLOGF(ERR,
+          "Error trying to compact pool {} in tier {} for allocation class "
+          "{}. Error: {}",
+          static_cast<int>(pid), static_cast<int>(tid), static_cast<int>(cid),
+          e.what());
+  }
+  return true;
+}
+
+template <typename CacheT>
+SlabCompactorStats SlabCompactor<CacheT>::getStats() const noexcept {
+  SlabCompactorStats stats;
+  stats.numSlabsCompacted = numSlabsCompacted_.load(std::memory_order_relaxed);
+  stats.numBytesReclaimed = stats.numSlabsCompacted * Slab::kSize;
+  stats.numTraversals = getRunCount();
+  return stats;
+}
+
+} // namespace cachelib
+} // namespace facebook
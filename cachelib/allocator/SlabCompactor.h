@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <set>
+#include <utility>
+
+#include "cachelib/allocator/CacheStats.h"
+#include "cachelib/allocator/memory/MemoryPool.h"
+#include "cachelib/common/PeriodicWorker.h"
+
+namespace facebook {
+namespace cachelib {
+
+// wrapper that exposes the private APIs of CacheType that are specifically
+// needed for the SlabCompactor.
+template <typename C>
+struct SlabCompactorAPIWrapper {
+  static unsigned int getNumTiers(C& cache) { return cache.getNumTiers(); }
+
+  static std::set<PoolId> getRegularPoolIds(C& cache) {
+    return cache.getRegularPoolIds();
+  }
+
+  static const MemoryPool& getPool(C& cache, TierId tid, PoolId pid) {
+    return cache.getPoolByTid(pid, tid);
+  }
+
+  static std::pair<const Slab*, uint32_t> getSparsestSlab(C& cache,
+                                                          TierId tid,
+                                                          PoolId pid,
+                                                          ClassId cid) {
+    return cache.getSparsestSlab(tid, pid, cid);
+  }
+
+  // moves the items of the slab into the other slabs of the class and gives
+  // the slab back to the pool.
+  static void compactSlab(
+      C& cache, TierId tid, PoolId pid, ClassId cid, const Slab* slab) {
+    cache.releaseSlab(tid, pid, cid, Slab::kInvalidClassId,
+                      SlabReleaseMode::kRebalance, slab->memoryAtOffset(0));
+  }
+};
+
+// Compacts sparsely used slabs. Items come and go at different rates across
+// the slabs of an allocation class, which leaves many slabs partially used
+// and their free memory unusable by the other classes of the pool. For
+// every (tier, pool, class) whose free allocations add up to at least a
+// slab, the worker picks the slab with the most free allocations, moves its
+// items into the free allocations of the other slabs and gives the slab back
+// to the pool. Slabs are only compacted when a given percentage of their
+// allocations is free, and at most a given number of slabs is compacted per
+// run.
+template <typename CacheT>
+class SlabCompactor : public PeriodicWorker {
+ public:
+  using Cache = CacheT;
+  // @param cache               instance of the cache
+  // @param slabsPerIteration   max number of slabs compacted in a single run
+  // @param minFreePercent      percentage of a slab's allocations that must
+  //                            be free for it to be compacted
+  SlabCompactor(Cache& cache,
+                unsigned int slabsPerIteration,
+                unsigned int minFreePercent);
+
+  ~SlabCompactor();
+
+  SlabCompactorStats getStats() const noexcept;
+
+ private:
+  // implement logic in the virtual function in PeriodicWorker
+  // compact up to slabsPerIteration_ slabs across all the classes
+  void work() override final;
+
+  // compact the sparsest slab of the class if it is sparse enough.
+  //
+  // @return false if a slab release was aborted and compaction should stop
+  //         for this round.
+  bool compactClass(TierId tid, PoolId pid, ClassId cid, const ACStats& stats);
+
+  // reference to the cache
+  Cache& cache_;
+
+  const unsigned int slabsPerIteration_;
+  const unsigned int minFreePercent_;
+
+  // slabs left to compact in the current run
+  unsigned int slabsLeft_{0};
+
+  // stats on compacted slabs
+  std::atomic<uint64_t> numSlabsCompacted_{0};
+};
+
+} // namespace cachelib
+} // namespace facebook
+
+#include "cachelib/allocator/SlabCompactor-inl.h"
@@ -0,0 +1,743 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <folly/synchronization/SanitizeThread.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#include <folly/Format.h>
+#include <folly/Range.h>
+#pragma GCC diagnostic pop
+
+namespace facebook {
+namespace cachelib {
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+TagHashTable::Impl<T, HookPtr>::Impl(size_t numBuckets,
+                                     const PtrCompressor& compressor,
+                                     const Hasher& hasher)
+    : numBuckets_(numBuckets),
+      numBucketsMask_(numBuckets - 1),
+      compressor_(compressor),
+      hasher_(hasher) {
+  if (numBuckets == 0) {
+    throw std::invalid_argument("Can not have 0 buckets");
+  }
+  if (numBuckets & (numBuckets - 1)) {
+    throw std::invalid_argument("Number of buckets must be a power of two");
+  }
+  // buckets are aligned to cache lines so that a lookup reads just one.
+  buckets_.reset(static_cast<Bucket*>(::operator new(
+      numBuckets_ * sizeof(Bucket), std::align_val_t{kBucketSize})));
+  std::memset(static_cast<void*>(buckets_.get()), 0,
+              numBuckets_ * sizeof(Bucket));
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+TagHashTable::Impl<T, HookPtr>::Impl(size_t numBuckets,
+                                     void* memStart,
+                                     const PtrCompressor& compressor,
+                                     const Hasher& hasher,
+                                     bool resetMem)
+    : numBuckets_(numBuckets),
+      numBucketsMask_(numBuckets - 1),
+      buckets_(static_cast<Bucket*>(memStart)),
+      restorable_(true),
+      compressor_(compressor),
+      hasher_(hasher) {
+  if (numBuckets == 0) {
+    throw std::invalid_argument("Can not have 0 buckets");
+  }
+  if (numBuckets & (numBuckets - 1)) {
+    throw std::invalid_argument("Number of buckets must be a power of two");
+  }
+  if (resetMem) {
+    std::memset(memStart, 0, numBuckets_ * sizeof(Bucket));
+  }
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+TagHashTable::Impl<T, HookPtr>::~Impl() {
+  if (restorable_) {
+    buckets_.release();
+  }
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+uint64_t TagHashTable::Impl<T, HookPtr>::matchTags(const Bucket& b,
+                                                   uint8_t tag) noexcept {
+  constexpr uint64_t kLowBits = 0x0101010101010101ULL;
+  constexpr uint64_t kHighBits = 0x8080808080808080ULL;
+  // high bits of the bytes holding slot tags. The remaining bytes are the
+  // overflow filter and padding.
+  constexpr uint64_t kSlotBits = kHighBits >> (8 * (8 - kNumSlots));
+
+  uint64_t tags;
+  std::memcpy(&tags, b.tags, sizeof(tags));
+  // bytes equal to the tag become 0 and get their high bit set below.
+  const uint64_t x = tags ^ (kLowBits * tag);
+  return (x - kLowBits) & ~x & kHighBits & kSlotBits;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+size_t TagHashTable::Impl<T, HookPtr>::findSlot(const Bucket& b,
+                                                Key key,
+                                                uint8_t tag) const noexcept {
+  for (uint64_t mask = matchTags(b, tag); mask != 0; mask &= mask - 1) {
+    const auto slot = firstSlot(mask);
+    // a false positive might point at an empty slot or another tag
+    if (b.tags[slot] != tag) {
+      continue;
+    }
+    const T* node = compressor_.unCompress(b.slots[slot]);
+    if (node->getKey() == key) {
+      return slot;
+    }
+  }
+  return kNumSlots;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+T* TagHashTable::Impl<T, HookPtr>::findInOverflow(const Bucket& b,
+                                                  Key key,
+                                                  T*& prev) const noexcept {
+  prev = nullptr;
+  T* curr = compressor_.unCompress(b.overflow);
+  while (curr != nullptr && curr->getKey() != key) {
+    prev = curr;
+    curr = getHashNext(*curr);
+  }
+  return curr;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+void TagHashTable::Impl<T, HookPtr>::link(Bucket& b,
+                                          T& node,
+                                          uint8_t tag) noexcept {
+  const uint64_t empty = matchTags(b, 0);
+  if (empty != 0) {
+    // the first match for 0 is always exact.
+    const auto slot = firstSlot(empty);
+    XDCHECK_EQ(0u, b.tags[slot]);
+    b.slots[slot] = compressor_.compress(&node);
+    b.tags[slot] = tag;
+    return;
+  }
+
+  setHashNext(node, b.overflow);
+  b.overflow = compressor_.compress(&node);
+  b.overflowTags |= static_cast<uint8_t>(1u << (tag & 7));
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+void TagHashTable::Impl<T, HookPtr>::rebuildOverflowTags(Bucket& b) noexcept {
+  uint8_t overflowTags = 0;
+  for (T* curr = compressor_.unCompress(b.overflow); curr != nullptr;
+       curr = getHashNext(*curr)) {
+    overflowTags |=
+        static_cast<uint8_t>(1u << (getTag(getHash(curr->getKey())) & 7));
+  }
+  b.overflowTags = overflowTags;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+bool TagHashTable::Impl<T, HookPtr>::insertInBucket(T& node,
+                                                    BucketId bucket,
+                                                    uint8_t tag) noexcept {
+  if (findInBucket(node.getKey(), bucket, tag) != nullptr) {
+    // already there
+    return false;
+  }
+  link(buckets_[bucket], node, tag);
+  return true;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+T* TagHashTable::Impl<T, HookPtr>::insertOrReplaceInBucket(
+    T& node, BucketId bucket, uint8_t tag) noexcept {
+  XDCHECK_LT(bucket, numBuckets_);
+  auto& b = buckets_[bucket];
+  const auto key = node.getKey();
+
+  const auto slot = findSlot(b, key, tag);
+  if (slot != kNumSlots) {
+    T* old = compressor_.unCompress(b.slots[slot]);
+    b.slots[slot] = compressor_.compress(&node);
+    return old;
+  }
+
+  if (b.overflowTags & (1u << (tag & 7))) {
+    T* prev = nullptr;
+    T* old = findInOverflow(b, key, prev);
+    if (old != nullptr) {
+      if (prev) {
+        setHashNext(*prev, &node);
+      } else {
+        b.overflow = compressor_.compress(&node);
+      }
+      setHashNext(node, getHashNext(*old));
+      return old;
+    }
+  }
+
+  link(b, node, tag);
+  return nullptr;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+void TagHashTable::Impl<T, HookPtr>::removeFromBucket(T& node,
+                                                      BucketId bucket,
+                                                      uint8_t tag) noexcept {
+  XDCHECK_LT(bucket, numBuckets_);
+  auto& b = buckets_[bucket];
+  const auto key = node.getKey();
+
+  const auto slot = findSlot(b, key, tag);
+  if (slot != kNumSlots) {
+    XDCHECK_EQ(reinterpret_cast<uintptr_t>(&node),
+               reinterpret_cast<uintptr_t>(
+                   compressor_.unCompress(b.slots[slot])));
+    T* head = compressor_.unCompress(b.overflow);
+    if (head == nullptr) {
+      b.tags[slot] = 0;
+      b.slots[slot] = CompressedPtr{};
+      return;
+    }
+
+    // pull the head of the overflow chain into the slot to keep the chain
+    // short.
+    b.overflow = (head->*HookPtr).getHashNext();
+    b.slots[slot] = compressor_.compress(head);
+    b.tags[slot] = getTag(getHash(head->getKey()));
+    rebuildOverflowTags(b);
+    return;
+  }
+
+  T* prev = nullptr;
+  T* const curr = findInOverflow(b, key, prev);
+  // node must be present in hashtable.
+  XDCHECK_EQ(reinterpret_cast<uintptr_t>(&node),
+             reinterpret_cast<uintptr_t>(curr))
+      << node.toString();
+  if (prev != nullptr) {
+    setHashNext(*prev, (node.*HookPtr).getHashNext());
+  } else {
+    b.overflow = (node.*HookPtr).getHashNext();
+  }
+  rebuildOverflowTags(b);
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+T* TagHashTable::Impl<T, HookPtr>::findInBucket(Key key,
+                                                BucketId bucket,
+                                                uint8_t tag) const noexcept {
+  XDCHECK_LT(bucket, numBuckets_);
+  const auto& b = buckets_[bucket];
+  const auto slot = findSlot(b, key, tag);
+  if (slot != kNumSlots) {
+    return compressor_.unCompress(b.slots[slot]);
+  }
+  if ((b.overflowTags & (1u << (tag & 7))) == 0) {
+    return nullptr;
+  }
+  T* prev = nullptr;
+  return findInOverflow(b, key, prev);
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+void TagHashTable::Impl<T, HookPtr>::prefetchCandidates(
+    BucketId bucket, uint8_t tag) const noexcept {
+  XDCHECK_LT(bucket, numBuckets_);
+  // The bucket is read racily here. Slots are always updated as a whole, so
+  // we either observe the old or the new node and both are valid to
+  // prefetch. The caller looks the key up again under the lock.
+  folly::annotate_ignore_thread_sanitizer_guard g(__FILE__, __LINE__);
+  const auto& b = buckets_[bucket];
+  for (uint64_t mask = matchTags(b, tag); mask != 0; mask &= mask - 1) {
+    const T* node = compressor_.unCompress(b.slots[firstSlot(mask)]);
+    if (node != nullptr) {
+      __builtin_prefetch(node, 0 /* read */, 3 /* locality */);
+    }
+  }
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+template <typename F>
+void TagHashTable::Impl<T, HookPtr>::forEachBucketElem(BucketId bucket,
+                                                       F&& func) const {
+  XDCHECK_LT(bucket, numBuckets_);
+  const auto& b = buckets_[bucket];
+  for (size_t slot = 0; slot < kNumSlots; ++slot) {
+    if (b.tags[slot] != 0) {
+      func(compressor_.unCompress(b.slots[slot]));
+    }
+  }
+
+  T* curr = compressor_.unCompress(b.overflow);
+  while (curr != nullptr) {
+    func(curr);
+    curr = getHashNext(*curr);
+  }
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr>
+unsigned int TagHashTable::Impl<T, HookPtr>::getBucketNumElems(
+    BucketId bucket) const {
+  unsigned int numElems = 0;
+  forEachBucketElem(bucket, [&numElems](T*) { ++numElems; });
+  return numElems;
+}
+
+// AccessContainer interface
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+TagHashTable::Container<T, HookPtr, LockT>::Container(
+    const serialization::TagHashTableObject& object,
+    const Config& config,
+    ShmAddr memSegment,
+    const PtrCompressor& compressor,
+    HandleMaker hm)
+    : Container(object,
+                config,
+                memSegment.addr,
+                memSegment.size,
+                compressor,
+                std::move(hm)) {}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+TagHashTable::Container<T, HookPtr, LockT>::Container(
+    const serialization::TagHashTableObject& object,
+    const Config& config,
+    void* memStart,
+    size_t nBytes,
+    const PtrCompressor& compressor,
+    HandleMaker hm)
+    : config_{config},
+      handleMaker_(std::move(hm)),
+      ht_{getNumBucketsFor(config_.getNumBuckets()), memStart, compressor,
+          config_.getHasher(), false /* resetMem */},
+      locks_{config_.getLocksPower(), config_.getHasher()},
+      numKeys_(*object.numKeys_ref()) {
+  if (config_.getBucketsPower() !=
+      static_cast<uint32_t>(*object.bucketsPower_ref())) {
+    throw std::invalid_argument(folly::sformat(
+        "Hashtable bucket power not compatible. old = {}, new = {}",
+        *object.bucketsPower_ref(),
+        config.getBucketsPower()));
+  }
+
+  if (nBytes != ht_.size()) {
+    throw std::invalid_argument(
+        folly::sformat("Hashtable size not compatible. old = {}, new = {}",
+                       ht_.size(),
+                       nBytes));
+  }
+
+  if (*object.hasherMagicId_ref() != config_.getHasher()->getMagicId()) {
+    throw std::invalid_argument(folly::sformat(
+        "Hash object's ID mismatch. expected = {}, actual = {}",
+        *object.hasherMagicId_ref(), config_.getHasher()->getMagicId()));
+  }
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+typename TagHashTable::Container<T, HookPtr, LockT>::DistributionStats
+TagHashTable::Container<T, HookPtr, LockT>::getDistributionStats() const {
+  const auto now = util::getCurrentTimeSec();
+  const uint64_t numKeys = numKeys_;
+
+  std::unique_lock<std::mutex> statsLockGuard(cachedStatsLock_);
+  const auto numKeysDifference = numKeys > cachedStats_.numKeys
+                                     ? numKeys - cachedStats_.numKeys
+                                     : cachedStats_.numKeys - numKeys;
+
+  const bool needToRecompute =
+      (now - cachedStatsUpdateTime_ > 10 * 60 /* seconds */) ||
+      (cachedStats_.numKeys > 0 &&
+       (static_cast<double>(numKeysDifference) /
+            static_cast<double>(cachedStats_.numKeys) >
+        0.05));
+
+  // return the cached value or if someone else is already computing.
+  if (!needToRecompute || !canRecomputeDistributionStats_) {
+    return cachedStats_;
+  }
+
+  // record that we are iterating so that we dont cause everyone who
+  // observes this to recompute
+  canRecomputeDistributionStats_ = false;
+
+  // release the lock.
+  statsLockGuard.unlock();
+
+  // compute the distribution
+  std::map<unsigned int, uint64_t> distribution;
+  const auto numBuckets = ht_.getNumBuckets();
+  for (BucketId currBucket = 0; currBucket < numBuckets; ++currBucket) {
+    auto l = locks_.lockShared(currBucket);
+    ++distribution[ht_.getBucketNumElems(currBucket)];
+  }
+
+  // acquire lock
+  statsLockGuard.lock();
+  cachedStats_.numKeys = numKeys;
+  cachedStats_.itemDistribution = std::move(distribution);
+  cachedStats_.numBuckets = numBuckets;
+  cachedStatsUpdateTime_ = now;
+  canRecomputeDistributionStats_ = true;
+  return cachedStats_;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+bool TagHashTable::Container<T, HookPtr, LockT>::insert(T& node) noexcept {
+  if (node.isAccessible()) {
+    // already in hash table.
+    return false;
+  }
+
+  const auto hash = ht_.getHash(node.getKey());
+  const auto bucket = ht_.getBucket(hash);
+  auto l = locks_.lockExclusive(bucket);
+  const bool res = ht_.insertInBucket(node, bucket, Hashtable::getTag(hash));
+
+  if (res) {
+    node.markAccessible();
+    numKeys_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  return res;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+typename T::Handle TagHashTable::Container<T, HookPtr, LockT>::insertOrReplace(
+    T& node) {
+  if (node.isAccessible()) {
+    return handleMaker_(nullptr);
+  }
+
+  const auto hash = ht_.getHash(node.getKey());
+  const auto bucket = ht_.getBucket(hash);
+  const auto tag = Hashtable::getTag(hash);
+  auto l = locks_.lockExclusive(bucket);
+  T* oldNode = ht_.insertOrReplaceInBucket(node, bucket, tag);
+  XDCHECK_NE(reinterpret_cast<uintptr_t>(&node),
+             reinterpret_cast<uintptr_t>(oldNode));
+
+  // grab a handle to the old node before we mark it as not being in the hash
+  // table.
+  typename T::Handle handle;
+  try {
+    handle = handleMaker_(oldNode);
+  } catch (const std::exception&) {
+    // put the element back since we failed to grab handle.
+    ht_.insertOrReplaceInBucket(*oldNode, bucket, tag);
+    XDCHECK_EQ(reinterpret_cast<uintptr_t>(
+                   ht_.findInBucket(node.getKey(), bucket, tag)),
+               reinterpret_cast<uintptr_t>(oldNode))
+        << oldNode->toString();
+    throw;
+  }
+
+  node.markAccessible();
+
+  if (oldNode) {
+    oldNode->unmarkAccessible();
+  } else {
+    numKeys_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  return handle;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+bool TagHashTable::Container<T, HookPtr, LockT>::replaceIfAccessible(
+    T& oldNode, T& newNode) noexcept {
+  return replaceIf(oldNode, newNode, [](T&) { return true; });
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+template <typename F>
+bool TagHashTable::Container<T, HookPtr, LockT>::replaceIf(T& oldNode,
+                                                           T& newNode,
+                                                           F&& predicate) {
+  const auto hash = ht_.getHash(newNode.getKey());
+  const auto bucket = ht_.getBucket(hash);
+  auto l = locks_.lockExclusive(bucket);
+
+  if (oldNode.isAccessible() && predicate(oldNode)) {
+    ht_.insertOrReplaceInBucket(newNode, bucket, Hashtable::getTag(hash));
+    oldNode.unmarkAccessible();
+    newNode.markAccessible();
+    return true;
+  }
+  return false;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+bool TagHashTable::Container<T, HookPtr, LockT>::remove(T& node) noexcept {
+  const auto hash = ht_.getHash(node.getKey());
+  const auto bucket = ht_.getBucket(hash);
+  auto l = locks_.lockExclusive(bucket);
+
+  // check inside the lock to prevent from racing removes
+  if (!node.isAccessible()) {
+    return false;
+  }
+
+  ht_.removeFromBucket(node, bucket, Hashtable::getTag(hash));
+  node.unmarkAccessible();
+
+  numKeys_.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+typename T::Handle TagHashTable::Container<T, HookPtr, LockT>::removeIf(
+    T& node, const std::function<bool(const T& node)>& predicate) {
+  const auto hash = ht_.getHash(node.getKey());
+  const auto bucket = ht_.getBucket(hash);
+  auto l = locks_.lockExclusive(bucket);
+
+  // check inside the lock to prevent from racing removes
+  if (node.isAccessible() && predicate(node)) {
+    // grab the handle before we do any other state change. this ensures that
+    // if handle maker throws an exception, we leave the item in a consistent
+    // state.
+    auto handle = handleMaker_(&node);
+    ht_.removeFromBucket(node, bucket, Hashtable::getTag(hash));
+    node.unmarkAccessible();
+    numKeys_.fetch_sub(1, std::memory_order_relaxed);
+    return handle;
+  } else {
+    return handleMaker_(nullptr);
+  }
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+typename T::Handle TagHashTable::Container<T, HookPtr, LockT>::find(
+    Key key) const {
+  const auto hash = ht_.getHash(key);
+  const auto bucket = ht_.getBucket(hash);
+  auto l = locks_.lockShared(bucket);
+  return handleMaker_(ht_.findInBucket(key, bucket, Hashtable::getTag(hash)));
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+std::vector<typename T::Handle>
+TagHashTable::Container<T, HookPtr, LockT>::findBatch(
+    folly::Range<const Key*> keys) const {
+  const size_t numKeys = keys.size();
+  std::vector<Handle> handles(numKeys);
+  if (numKeys == 0) {
+    return handles;
+  }
+
+  // hash all the keys up front and prefetch their buckets so that the loads
+  // of the buckets are in flight at the same time.
+  std::vector<uint32_t> hashes(numKeys);
+  for (size_t i = 0; i < numKeys; ++i) {
+    hashes[i] = ht_.getHash(keys[i]);
+    ht_.prefetchBucket(ht_.getBucket(hashes[i]));
+  }
+
+  // by now the buckets are likely in cache. prefetch the headers of the
+  // nodes whose tag matches since that is where the key compare happens.
+  for (size_t i = 0; i < numKeys; ++i) {
+    ht_.prefetchCandidates(ht_.getBucket(hashes[i]),
+                           Hashtable::getTag(hashes[i]));
+  }
+
+  // group the keys by the lock stripe protecting their bucket so that each
+  // stripe is locked once for the whole batch.
+  const size_t locksMask = config_.getNumLocks() - 1;
+  std::vector<uint32_t> order(numKeys);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return (ht_.getBucket(hashes[a]) & locksMask) <
+           (ht_.getBucket(hashes[b]) & locksMask);
+  });
+
+  size_t i = 0;
+  while (i < numKeys) {
+    const auto firstBucket = ht_.getBucket(hashes[order[i]]);
+    const auto stripe = firstBucket & locksMask;
+    auto l = locks_.lockShared(firstBucket);
+    for (; i < numKeys && (ht_.getBucket(hashes[order[i]]) & locksMask) == stripe;
+         ++i) {
+      const auto idx = order[i];
+      handles[idx] = handleMaker_(ht_.findInBucket(
+          keys[idx], ht_.getBucket(hashes[idx]), Hashtable::getTag(hashes[idx])));
+    }
+  }
+  return handles;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+serialization::TagHashTableObject
+TagHashTable::Container<T, HookPtr, LockT>::saveState() const {
+  if (!ht_.isRestorable()) {
+    throw std::logic_error(
+        "hashtable is not restorable since the memory is not managed by user");
+  }
+
+  if (numIterators_ != 0) {
+    throw std::logic_error(
+        folly::sformat("There are {} pending iterators", numIterators_.load()));
+  }
+
+  serialization::TagHashTableObject object;
+  *object.bucketsPower_ref() = config_.getBucketsPower();
+  *object.locksPower_ref() = config_.getLocksPower();
+  *object.numKeys_ref() = numKeys_;
+  *object.hasherMagicId_ref() = config_.getHasher()->getMagicId();
+  return object;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+void TagHashTable::Container<T, HookPtr, LockT>::startResize(
+    unsigned int bucketsPower,
+    const std::function<void*(uint32_t, size_t)>&,
+    const std::function<void(uint32_t)>&) {
+  throw std::invalid_argument(folly::sformat(
+      "TagHashTable can not be resized. current bucket power = {}, new = {}",
+      getHashpower(), bucketsPower));
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+void TagHashTable::Container<T, HookPtr, LockT>::getBucketElems(
+    BucketId bucket, std::vector<Handle>& handles) const {
+  handles.clear();
+  auto l = locks_.lockShared(bucket);
+
+  ht_.forEachBucketElem(bucket, [this, &handles](T* e) {
+    try {
+      XDCHECK(e);
+      handles.emplace_back(handleMaker_(e));
+    } catch (const std::exception&) {
+      // if we are not able to acquire a handle, skip over them.
+    }
+  });
+}
+
+// Container's Iterator
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+typename TagHashTable::Container<T, HookPtr, LockT>::Iterator&
+TagHashTable::Container<T, HookPtr, LockT>::Iterator::operator++() {
+  if (throttler_) {
+    throttler_->throttle();
+  }
+
+  ++curSor_;
+  if (curSor_ < bucketElems_.size()) {
+    return *this;
+  }
+
+  ++currBucket_;
+  for (; currBucket_ < container_->getNumBuckets(); ++currBucket_) {
+    container_->getBucketElems(currBucket_, bucketElems_);
+    if (!bucketElems_.empty()) {
+      curSor_ = 0;
+      return *this;
+    } else if (throttler_) {
+      throttler_->throttle();
+    }
+  }
+
+  // reach the end
+  bucketElems_.clear();
+  curSor_ = 0;
+  return *this;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+T& TagHashTable::Container<T, HookPtr, LockT>::Iterator::operator*() {
+  return *curr();
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+TagHashTable::Container<T, HookPtr, LockT>::Iterator::Iterator(
+    Container<T, HookPtr, LockT>& container,
+    folly::Optional<util::Throttler::Config> throttlerConfig)
+    : container_(&container) {
+  if (throttlerConfig) {
+    throttler_.assign(util::Throttler(*throttlerConfig));
+  }
+
+  ++container_->numIterators_;
+
+  reset();
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+TagHashTable::Container<T, HookPtr, LockT>::Iterator::Iterator(
+    Iterator&& other) noexcept
+    : container_{other.container_},
+      currBucket_{other.currBucket_},
+      curSor_{other.curSor_},
+      bucketElems_(std::move(other.bucketElems_)) {
+  // increment the iterator count when we move.
+  ++container_->numIterators_;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+typename TagHashTable::Container<T, HookPtr, LockT>::Iterator&
+TagHashTable::Container<T, HookPtr, LockT>::Iterator::operator=(
+    Iterator&& other) noexcept {
+  if (this != &other) {
+    this->~Iterator();
+    new (this) Iterator(std::move(other));
+  }
+  return *this;
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+TagHashTable::Container<T, HookPtr, LockT>::Iterator::Iterator(
+    Container<T, HookPtr, LockT>& container, EndIterT)
+    : container_(&container), currBucket_{container_->getNumBuckets()} {
+  // increment the iterator for both the end and begin() types so that the
+  // destructor can just blindly decrement.
+  ++container_->numIterators_;
+  XDCHECK_EQ(0u, curSor_);
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+typename TagHashTable::Container<T, HookPtr, LockT>::Iterator
+TagHashTable::Container<T, HookPtr, LockT>::begin(
+    folly::Optional<util::Throttler::Config> throttlerConfig) {
+  return Iterator(*this, throttlerConfig);
+}
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+void TagHashTable::Container<T, HookPtr, LockT>::Iterator::reset() {
+  curSor_ = 0;
+  currBucket_ = 0;
+  container_->getBucketElems(currBucket_, bucketElems_);
+  while (bucketElems_.empty() &&
+         ++currBucket_ < container_->getNumBuckets()) {
+    if (throttler_) {
+      throttler_->throttle();
+    }
+    container_->getBucketElems(currBucket_, bucketElems_);
+  }
+  XDCHECK_EQ(0u, curSor_);
+}
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,624 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Optional.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "cachelib/allocator/Cache.h"
+#include "cachelib/allocator/ChainedHashTable.h"
+#include "cachelib/allocator/memory/serialize/gen-cpp2/objects_types.h"
+#include "cachelib/common/CompilerUtils.h"
+#include "cachelib/common/Mutex.h"
+#include "cachelib/common/Throttler.h"
+#include "cachelib/shm/Shm.h"
+
+namespace facebook {
+namespace cachelib {
+
+/**
+ * Implementation of a bucketized hash table with tag filtering. Every bucket
+ * is one cache line holding a few slots. Each slot has a compressed pointer
+ * to a node and a one byte tag computed from the hash of the node's key. A
+ * lookup matches the tags of the bucket all at once and only compares the
+ * keys of the nodes whose tag matches, so most misses and most hits read one
+ * cache line of the table before touching a node. The tags are matched as a
+ * single 64 bit word (SIMD within a register), which works the same on all
+ * platforms.
+ *
+ * When all the slots of a bucket are taken, nodes are chained off the bucket
+ * through their Hook like in ChainedHashTable. The bucket keeps a small
+ * filter of the tags in its overflow chain so that misses rarely walk it.
+ *
+ * The buckets take the same memory as the buckets of a ChainedHashTable with
+ * the same config, so the two are interchangeable in a cache. A config made
+ * for a number of entries gets more buckets though, see makeConfig. The
+ * interface is the one of ChainedHashTable, except that the table can not
+ * be resized.
+ */
+class TagHashTable {
+ public:
+  // unique identifier per AccessType
+  static const int kId;
+
+  // nodes in the overflow chain of a bucket are linked like the ones of a
+  // ChainedHashTable.
+  template <typename T>
+  using Hook = ChainedHashTable::Hook<T>;
+
+  using Config = ChainedHashTable::Config;
+
+  using SerializationType = serialization::TagHashTableObject;
+
+  // @return  a config sized for the number of entries. A bucket has 6 slots
+  //          in the memory of 8 ChainedHashTable buckets. With the buckets
+  //          of a ChainedHashTable sized for the same entries, a bucket holds
+  //          up to 5 entries on average and about 10% of the entries end up
+  //          in the overflow chains. The table is sized for twice the
+  //          entries instead, which keeps that under 1% for twice the memory.
+  static Config makeConfig(size_t numEntries) {
+    Config config{};
+    config.sizeBucketsPowerAndLocksPower(2 * numEntries);
+    return config;
+  }
+
+ private:
+  // size of a bucket in bytes.
+  static constexpr size_t kBucketSize = 64;
+
+  // a bucket takes the memory of this many ChainedHashTable buckets.
+  static constexpr unsigned int kBucketsPowerShift = 3;
+
+  // Implements the buckets of the hash table.
+  template <typename T, Hook<T> T::*HookPtr>
+  class Impl {
+   public:
+    using Key = typename T::Key;
+    using BucketId = size_t;
+    using CompressedPtr = typename T::CompressedPtr;
+    using PtrCompressor = typename T::PtrCompressor;
+
+    // the tags of a bucket and the filter of its overflow chain share one
+    // 64 bit word. With 8 byte pointers, 6 slots and the overflow chain fill
+    // the rest of the cache line.
+    static constexpr size_t kNumSlots = 6;
+
+    struct CACHELIB_PACKED_ATTR Bucket {
+      // tag of the node in each slot, 0 if the slot is empty
+      uint8_t tags[kNumSlots];
+
+      // bit (tag % 8) is set for the tags of the nodes in the overflow
+      // chain. Rebuilt when nodes leave the chain.
+      uint8_t overflowTags;
+
+      uint8_t pad;
+
+      CompressedPtr slots[kNumSlots];
+
+      // head of the chain of nodes that did not fit into the slots
+      CompressedPtr overflow;
+    };
+    static_assert(kNumSlots + 2 == sizeof(uint64_t),
+                  "tags do not fill the tag word");
+    static_assert(sizeof(Bucket) <= kBucketSize, "bucket spans cache lines");
+
+    // allocate memory for hash table; the memory is managed by Impl.
+    //
+    // @param numBuckets    the number of buckets to be allocated, power of two
+    // @param compressor    object used to compress/decompress node pointers
+    // @param hasher        object used to hash the key for its bucket id
+    Impl(size_t numBuckets,
+         const PtrCompressor& compressor,
+         const Hasher& hasher);
+
+    // allocate memory for hash table; the memory is managed by the user.
+    //
+    // @param numBuckets    the number of buckets to be allocated, power of two
+    // @param memStart      user managed memory. The size must be enough to
+    //                      accommodate the number of the buckets
+    // @param compressor    object used to compress/decompress node pointers
+    // @param hasher        object used to hash the key for its bucket id
+    // @param resetMem      fill memory with empty buckets
+    Impl(size_t numBuckets,
+         void* memStart,
+         const PtrCompressor& compressor,
+         const Hasher& hasher,
+         bool resetMem = false);
+
+    // hash table memory is not released if managed by user.
+    // i.e. Impl::isRestorable() == true
+    ~Impl();
+
+    // prohibit copying
+    Impl(const Impl&) = delete;
+    Impl& operator=(const Impl&) = delete;
+
+    // hash of the key
+    uint32_t getHash(Key k) const noexcept {
+      return (*hasher_)(k.data(), k.size());
+    }
+
+    // gets the bucket for a hash
+    BucketId getBucket(uint32_t hash) const noexcept {
+      return hash & numBucketsMask_;
+    }
+
+    // gets the tag for a hash. Tags always have the high bit set, so that
+    // they are never 0. The tag is taken from a remix of the hash since its
+    // low bits are already the same for every key in the bucket.
+    static uint8_t getTag(uint32_t hash) noexcept {
+      return static_cast<uint8_t>((hash * 0x9E3779B1u) >> 25) | 0x80;
+    }
+
+    // inserts the element into the bucket.
+    //
+    // @return  True if the insertion was success. False if there is already
+    //          a node with the same key in the hashtable.
+    bool insertInBucket(T& node, BucketId bucket, uint8_t tag) noexcept;
+
+    // inserts or replaces the element into the bucket.
+    //
+    // @return  old node if it exists, nullptr otherwise
+    T* insertOrReplaceInBucket(T& node, BucketId bucket, uint8_t tag) noexcept;
+
+    // removes the node from the bucket.
+    //
+    // precondition:  node must be in the bucket.
+    void removeFromBucket(T& node, BucketId bucket, uint8_t tag) noexcept;
+
+    // finds the node corresponding to the key from the bucket and returns it
+    // if found, nullptr otherwise.
+    T* findInBucket(Key key, BucketId bucket, uint8_t tag) const noexcept;
+
+    // issue a prefetch for the bucket.
+    void prefetchBucket(BucketId bucket) const noexcept {
+      XDCHECK_LT(bucket, numBuckets_);
+      __builtin_prefetch(&buckets_[bucket], 0 /* read */, 3 /* locality */);
+    }
+
+    // issue a prefetch for the nodes in the bucket whose tag matches. This
+    // reads the bucket without holding the bucket lock, so it must only be
+    // used as a hint and the result re-validated under the lock.
+    void prefetchCandidates(BucketId bucket, uint8_t tag) const noexcept;
+
+    // Call 'func' on each element in the given bucket.
+    template <typename F>
+    void forEachBucketElem(BucketId bucket, F&& func) const;
+
+    // fetch the number of elements of a given bucket
+    unsigned int getBucketNumElems(BucketId bucket) const;
+
+    // true if the hash table can be restored
+    bool isRestorable() const noexcept { return restorable_; }
+
+    // return the hashtable size in bytes
+    size_t size() const noexcept { return numBuckets_ * sizeof(Bucket); }
+
+    // return the number of buckets in hash table
+    size_t getNumBuckets() const noexcept { return numBuckets_; }
+
+   private:
+    // releases heap memory allocated with the alignment of a cache line
+    struct AlignedDeleter {
+      void operator()(Bucket* buckets) const noexcept {
+        if (buckets != nullptr) {
+          ::operator delete(buckets, std::align_val_t{kBucketSize});
+        }
+      }
+    };
+
+    // bit mask with the high bit of every tag in the bucket that is equal
+    // to the given one. The bits of bytes after an equal one can be false
+    // positives, so every match must be confirmed by a key compare.
+    static uint64_t matchTags(const Bucket& b, uint8_t tag) noexcept;
+
+    // index of the first slot set in the mask returned by matchTags()
+    static size_t firstSlot(uint64_t mask) noexcept {
+      return static_cast<size_t>(__builtin_ctzll(mask)) / 8;
+    }
+
+    // finds the slot holding the key. Returns kNumSlots if it is not in a
+    // slot.
+    size_t findSlot(const Bucket& b, Key key, uint8_t tag) const noexcept;
+
+    // finds the node with the key in the overflow chain along with the one
+    // before it in the chain.
+    T* findInOverflow(const Bucket& b, Key key, T*& prev) const noexcept;
+
+    // puts the node into an empty slot or at the head of the overflow chain
+    void link(Bucket& b, T& node, uint8_t tag) noexcept;
+
+    // recompute the filter of the overflow chain
+    void rebuildOverflowTags(Bucket& b) noexcept;
+
+    T* getHashNext(const T& node) const noexcept {
+      return (node.*HookPtr).getHashNext(compressor_);
+    }
+
+    void setHashNext(T& node, T* next) const noexcept {
+      (node.*HookPtr).setHashNext(next, compressor_);
+    }
+
+    void setHashNext(T& node, CompressedPtr next) const noexcept {
+      (node.*HookPtr).setHashNext(next);
+    }
+
+    // number of buckets we have in the hashtable, must be power of two
+    const size_t numBuckets_{0};
+
+    // materialized value of numBuckets_ - 1
+    const size_t numBucketsMask_{0};
+
+    // actual buckets.
+    std::unique_ptr<Bucket[], AlignedDeleter> buckets_;
+
+    // indicate whether or not the hash table uses user-managed memory and
+    // is thus restorable from serialized state
+    const bool restorable_{false};
+
+    // object used to compress/decompress node pointers
+    const PtrCompressor compressor_;
+
+    // Hash the key
+    const Hasher hasher_;
+  };
+
+  // number of buckets for a config with the given number of ChainedHashTable
+  // buckets
+  static size_t getNumBucketsFor(size_t numChainedBuckets) noexcept {
+    return std::max<size_t>(1, numChainedBuckets >> kBucketsPowerShift);
+  }
+
+ public:
+  // Interface for the Container that implements a hash table. Maintains
+  // the node's isInAccessContainer state. T must implement an interface to
+  // markAccessible(), unmarkAccessible() and isAccessible().
+  template <typename T,
+            Hook<T> T::*HookPtr,
+            typename LockT = facebook::cachelib::SharedMutexBuckets>
+  struct Container {
+   private:
+    using Hashtable = Impl<T, HookPtr>;
+    using BucketId = typename Hashtable::BucketId;
+
+   public:
+    using Key = typename T::Key;
+    using Handle = typename T::Handle;
+    using HandleMaker = typename T::HandleMaker;
+    using CompressedPtr = typename T::CompressedPtr;
+    using PtrCompressor = typename T::PtrCompressor;
+
+    // default handle maker that calls incRef
+    static const HandleMaker kDefaultHandleMaker;
+
+    // container with default config.
+    Container() noexcept
+        : Container(Config{}, PtrCompressor(), kDefaultHandleMaker) {}
+
+    // create hash table container with local-managed memory
+    // @param config      the config for the hashtable
+    // @param compressor  object used to compress/decompress node pointers
+    // @param hm          the functor that creates a Handle from T*
+    Container(Config c,
+              const PtrCompressor& compressor,
+              HandleMaker hm = kDefaultHandleMaker)
+        : config_(std::move(c)),
+          handleMaker_(std::move(hm)),
+          ht_{getNumBucketsFor(config_.getNumBuckets()), compressor,
+              config_.getHasher()},
+          locks_{config_.getLocksPower(), config_.getHasher()} {}
+
+    // create hash table container with user-managed memory
+    //
+    // @param c           config for hash table
+    // @param memStart    hash table memory managed by the user. Must be at
+    //                    least getRequiredSize(c.getNumBuckets()) bytes.
+    // @param compressor  object used to compress/decompress node pointers
+    // @param hm          the functor that creates a Handle from T*
+    Container(Config c,
+              void* memStart,
+              const PtrCompressor& compressor,
+              HandleMaker hm = kDefaultHandleMaker)
+        : config_(std::move(c)),
+          handleMaker_(std::move(hm)),
+          ht_{getNumBucketsFor(config_.getNumBuckets()), memStart, compressor,
+              config_.getHasher(), true /* resetMem */},
+          locks_{config_.getLocksPower(), config_.getHasher()} {}
+
+    // restore hash table from serialized data.
+    //
+    // @throw std::invalid argument if the bucket power in new config does not
+    //        match the previous state or the size of the memSegment does not
+    //        match the old state.
+    Container(const serialization::TagHashTableObject& object,
+              const Config& newConfig,
+              ShmAddr memSegment,
+              const PtrCompressor& compressor,
+              HandleMaker hm = kDefaultHandleMaker);
+
+    // restore hash table from previous state. This only works when the
+    // hash table memory is managed by the user.
+    //
+    // @throw std::invalid argument if the bucket power in new config does not
+    //        match the previous state or the size of the memory does not
+    //        match the old state.
+    Container(const serialization::TagHashTableObject& object,
+              const Config& newConfig,
+              void* memStart,
+              size_t nBytes,
+              const PtrCompressor& compressor,
+              HandleMaker hm = kDefaultHandleMaker);
+
+    // same as above, with the memory returned by getMemory(0). The table is
+    // never resized, so it only has the one generation.
+    Container(const serialization::TagHashTableObject& object,
+              const Config& newConfig,
+              const std::function<ShmAddr(uint32_t generation)>& getMemory,
+              const PtrCompressor& compressor,
+              HandleMaker hm = kDefaultHandleMaker)
+        : Container(object,
+                    newConfig,
+                    getMemory(0),
+                    compressor,
+                    std::move(hm)) {}
+
+    Container(const Container&) = delete;
+    Container& operator=(const Container&) = delete;
+
+    // inserts the node into the hash table and marks it as being in the
+    // hashtable upon success. If another node exists with the same key, the
+    // insert fails. On failure the state of the node is unchanged.
+    bool insert(T& node) noexcept;
+
+    // inserts or replaces the node into the hash table and marks it being in
+    // the hashtable upon success. If the node replaced an existing node, a
+    // handle to the old node is returned, otherwise a null handle.
+    //
+    // @throw std::overflow_error is the maximum item refcount is execeeded by
+    //        creating this item handle.
+    Handle insertOrReplace(T& node);
+
+    // replaces a node into the hash table, only if another node exists with
+    // the same key and is marked accessible.
+    bool replaceIfAccessible(T& oldNode, T& newNode) noexcept;
+
+    // replaces a node if predicate returns true on the existing node
+    template <typename F>
+    bool replaceIf(T& oldNode, T& newNode, F&& predicate);
+
+    // removes the node from the hashtable and unmarks it as accessible. If
+    // the node does not exists, returns False.
+    bool remove(T& node) noexcept;
+
+    // remove a node from the container if it exists for the key and the
+    // predicate returns true for the node. Returns a handle to the node if
+    // it was removed, a null handle otherwise.
+    Handle removeIf(T& node,
+                    const std::function<bool(const T& node)>& predicate);
+
+    // finds the node corresponding to the key in the hashtable and returns a
+    // handle to that node, or a null handle if there is none.
+    //
+    // @throw std::overflow_error is the maximum item refcount is execeeded by
+    //        creating this item handle.
+    Handle find(Key key) const;
+
+    // finds the nodes corresponding to a batch of keys. The buckets of all
+    // the keys are prefetched first, then the nodes with a matching tag,
+    // before any key is compared. Keys are looked up grouped by lock stripe.
+    //
+    // @return  a vector of the same size as keys where the i-th handle
+    //          corresponds to keys[i].
+    std::vector<Handle> findBatch(folly::Range<const Key*> keys) const;
+
+    // for saving the state of the hash table
+    //
+    // precondition:  serialization must happen without any reader or writer
+    // present.
+    //
+    // @throw std::logic_error if the container has any pending iterators that
+    // need to be destroyed or if the container can not be restored.
+    serialization::TagHashTableObject saveState() const;
+
+    // get the required size for a config with the given number of buckets.
+    static size_t getRequiredSize(size_t numBuckets) noexcept {
+      return sizeof(typename Hashtable::Bucket) * getNumBucketsFor(numBuckets);
+    }
+
+    const Config& getConfig() const noexcept { return config_; }
+
+    unsigned int getHashpower() const noexcept {
+      return config_.getBucketsPower();
+    }
+
+    // the number of buckets the keys are spread over
+    size_t getNumBuckets() const noexcept { return ht_.getNumBuckets(); }
+
+    // the table can not be resized.
+    //
+    // @throw std::invalid_argument always
+    void startResize(unsigned int bucketsPower,
+                     const std::function<void*(uint32_t, size_t)>& = nullptr,
+                     const std::function<void(uint32_t)>& = nullptr);
+
+    bool rehashStep(size_t /* numBuckets */,
+                    const std::function<void(uint32_t)>& = nullptr) {
+      return true;
+    }
+
+    bool isResizing() const noexcept { return false; }
+
+    uint32_t getTableGeneration() const noexcept { return 0; }
+
+    // Iterator interface for the hashtable. Iterates over the hashtable
+    // bucket by bucket and takes a snapshot of the bucket to iterate over. It
+    // guarantees that all keys that were present when the iteration started
+    // will be accessible unless they are removed. Keys that are
+    // removed/inserted during the lifetime of an iterator are not guaranteed
+    // to be either visited or not-visited. The iterator internally holds a
+    // Handle to the item.
+    class Iterator {
+     public:
+      ~Iterator() {
+        XDCHECK_GT(container_->numIterators_.load(), 0u);
+        --container_->numIterators_;
+      }
+      Iterator(const Iterator&) = delete;
+      Iterator& operator=(const Iterator&) = delete;
+
+      Iterator(Iterator&&) noexcept;
+      Iterator& operator=(Iterator&&) noexcept;
+      enum EndIterT { EndIter };
+
+      // increment the iterator to the next element.
+      Iterator& operator++();
+
+      // dereference the current element that the iterator is pointing to.
+      T& operator*();
+      T* operator->() { return &(*(*this)); }
+
+      bool operator==(const Iterator& other) const noexcept {
+        return container_ == other.container_ &&
+               currBucket_ == other.currBucket_ && curSor_ == other.curSor_;
+      }
+
+      bool operator!=(const Iterator& other) const noexcept {
+        return !(*this == other);
+      }
+
+      const Handle& asHandle() { return curr(); }
+
+      // reset the Iterator to begin of container
+      void reset();
+
+     private:
+      using C = Container<T, HookPtr, LockT>;
+
+      friend C;
+      explicit Iterator(C& ht,
+                        folly::Optional<util::Throttler::Config>
+                            throttlerConfig = folly::none);
+
+      Iterator(C& ht, EndIterT);
+
+      // the container over which we are iterating
+      C* container_;
+
+      // current bucket that the iterator is pointing to.
+      BucketId currBucket_{0};
+
+      // cursor into the current bucket.
+      unsigned int curSor_{0};
+
+      // current bucket.
+      std::vector<Handle> bucketElems_;
+
+      // optional throttler
+      folly::Optional<util::Throttler> throttler_ = folly::none;
+
+      // returns the handle for current item in the iterator.
+      Handle& curr() {
+        if (curSor_ < bucketElems_.size()) {
+          return bucketElems_[curSor_];
+        }
+        throw std::logic_error(
+            "Iterator in invalid state with curSor_: " +
+            folly::to<std::string>(curSor_) + ", currBucket_: " +
+            folly::to<std::string>(currBucket_) + ", total buckets: " +
+            folly::to<std::string>(container_->getNumBuckets()));
+      }
+    };
+
+    Iterator begin(folly::Optional<util::Throttler::Config> throttlerConfig);
+
+    Iterator begin() { return Iterator(*this); }
+    Iterator end() { return Iterator(*this, Iterator::EndIter); }
+
+    // Stats describing the distribution of items (keys) in the hash table
+    struct DistributionStats {
+      uint64_t numKeys{0};
+      uint64_t numBuckets{0};
+      // map from bucket id to number of items in the bucket.
+      std::map<unsigned int, uint64_t> itemDistribution{};
+    };
+
+    struct Stats {
+      uint64_t numKeys;
+      uint64_t numBuckets;
+    };
+
+    // Get the distribution stats. Cached like the ones of ChainedHashTable.
+    // This is expensive. Call at your discretion.
+    DistributionStats getDistributionStats() const;
+
+    // lightweight stats that give the number of keys and buckets inside the
+    // container. This is guaranteed to be fast.
+    Stats getStats() const noexcept { return {numKeys_, ht_.getNumBuckets()}; }
+
+    // Get the total number of keys inserted into the hash table
+    uint64_t getNumKeys() const noexcept { return numKeys_; }
+
+   private:
+    // Fetch a vector of handle to the items belonging to a given bucket.
+    // Items will be skipped if the handle cannot be acquired for any reason.
+    void getBucketElems(BucketId bucket, std::vector<Handle>& handles) const;
+
+    // config for the hash table.
+    const Config config_{};
+
+    // handle maker to convert the T* to T::Handle
+    HandleMaker handleMaker_;
+
+    // the hashtable buckets
+    Hashtable ht_;
+
+    // locks protecting the hashtable buckets
+    mutable LockT locks_;
+
+    std::atomic<unsigned int> numIterators_{0};
+
+    // Cached stats for distribution
+    mutable std::mutex cachedStatsLock_;
+    mutable DistributionStats cachedStats_{};
+    mutable bool canRecomputeDistributionStats_{true};
+    mutable time_t cachedStatsUpdateTime_{0};
+
+    // number of the keys stored in this hash table
+    std::atomic<uint64_t> numKeys_{0};
+  };
+};
+
+template <typename T, typename TagHashTable::Hook<T> T::*HookPtr, typename LockT>
+const typename T::HandleMaker
+    TagHashTable::Container<T, HookPtr, LockT>::kDefaultHandleMaker =
+        [](T* t) -> typename T::Handle {
+  if (t) {
+    t->incRef();
+  }
+  return typename T::Handle{t};
+};
+} // namespace cachelib
+} // namespace facebook
+
+#include "cachelib/allocator/TagHashTable-inl.h"
@@ -25,11 +25,17 @@
 namespace facebook {
 namespace cachelib {
 
-TempShmMapping::TempShmMapping(size_t size)
+TempShmMapping::TempShmMapping(size_t size,
+                               util::HugePagePolicy hugePages,
+                               bool hugePageFallback)
     : size_(size),
       tempCacheDir_(util::getUniqueTempDir("cachedir")),
       shmManager_(createShmManager(tempCacheDir_)),
-      addr_(createShmMapping(*shmManager_.get(), size, tempCacheDir_)) {}
+      addr_(createShmMapping(*shmManager_.get(),
+                             size,
+                             tempCacheDir_,
+                             hugePages,
+                             hugePageFallback)) {}
 
 TempShmMapping::~TempShmMapping() {
   try {
@@ -63,14 +69,49 @@ std::unique_ptr<ShmManager> TempShmMapping::createShmManager(
 
 void* TempShmMapping::createShmMapping(ShmManager& shmManager,
                                        size_t size,
-                                       const std::string& cacheDir) {
+                                       const std::string& cacheDir,
+                                       util::HugePagePolicy hugePages,
+                                       bool hugePageFallback) {
+  const bool hugeTlb = hugePages == util::HugePagePolicy::kTwoMB ||
+                       hugePages == util::HugePagePolicy::kOneGB;
+  if (hugeTlb && hugePageFallback) {
+    try {
+      return mapShm(shmManager, size, hugePages);
+    } catch (const std::exception& e) {
+      XLOGF(WARN,
+            "Cannot create temporary shared memory with huge pages: {}. "
+            "Falling back to transparent huge pages",
+            e.what());
+      hugePages = util::HugePagePolicy::kTransparent;
+    }
+  }
+
+  try {
+    return mapShm(shmManager, size, hugePages);
+  } catch (...) {
+    util::removePath(cacheDir);
+    throw;
+  }
+}
+
+void* TempShmMapping::mapShm(ShmManager& shmManager,
+                             size_t size,
+                             util::HugePagePolicy hugePages) {
+  ShmSegmentOpts opts(PageSizeT::NORMAL, false /* readOnly */,
+                      false /* posix */);
+  opts.alignment = sizeof(Slab);
+  opts.setHugePagePolicy(hugePages);
+  // the segment is rounded up to its page size. Reserve the whole of it.
+  const size_t mapSize = detail::getPageAlignedSize(size, opts.pageSize);
+
   void* addr = nullptr;
   void* shmAddr = nullptr;
   try {
-    addr =
-        util::mmapAlignedZeroedMemory(sizeof(Slab), size, true /* readOnly */);
+    addr = util::mmapAlignedZeroedMemory(opts.alignment, mapSize,
+                                         true /* readOnly */);
     shmAddr =
-        shmManager.createShm(detail::kTempShmCacheName.str(), size, addr).addr;
+        shmManager.createShm(detail::kTempShmCacheName.str(), size, addr, opts)
+            .addr;
     // Mark the shared memory segment to be removed on exit. This will ensure
     // that the segment is dropped on exit.
     auto& shm = shmManager.getShmByName(detail::kTempShmCacheName.str());
@@ -80,10 +121,9 @@ void* TempShmMapping::createShmMapping(ShmManager& shmManager,
     if (shmAddr) {
       shmManager.removeShm(detail::kTempShmCacheName.str(),
         PosixSysVSegmentOpts(false /* posix */));
-    } else {
-      munmap(addr, size);
+    } else if (addr) {
+      munmap(addr, mapSize);
     }
-    util::removePath(cacheDir);
     throw;
   }
 }
@@ -41,7 +41,14 @@ constexpr folly::StringPiece kTempShmCacheName = "temp_shm_cache";
 // the cache is on a shared memory segment.
 class TempShmMapping {
  public:
-  explicit TempShmMapping(size_t size);
+  // @param size              size of the mapping
+  // @param hugePages         huge pages to back the segment with
+  // @param hugePageFallback  use transparent huge pages if the hugetlb pool
+  //                          can not back the segment
+  explicit TempShmMapping(
+      size_t size,
+      util::HugePagePolicy hugePages = util::HugePagePolicy::kNone,
+      bool hugePageFallback = true);
   ~TempShmMapping();
   // get the start of addrress.
   void* getAddr() const { return addr_; }
@@ -51,7 +58,12 @@ class TempShmMapping {
       const std::string& cacheDir);
   static void* createShmMapping(ShmManager& shmManager,
                                 size_t size,
-                                const std::string& cacheDir);
+                                const std::string& cacheDir,
+                                util::HugePagePolicy hugePages,
+                                bool hugePageFallback);
+  static void* mapShm(ShmManager& shmManager,
+                      size_t size,
+                      util::HugePagePolicy hugePages);
 
   size_t size_{0};
   std::string tempCacheDir_;
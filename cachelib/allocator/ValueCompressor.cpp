@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/allocator/ValueCompressor.h"
+
+#include <folly/Format.h>
+#include <folly/compression/Compression.h>
+#include <zdict.h>
+#include <zstd.h>
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace facebook {
+namespace cachelib {
+
+namespace {
+// contexts are expensive to create and can be reused for any dictionary, so
+// every thread keeps one of each.
+struct ZstdContexts {
+  ZstdContexts() : cctx(ZSTD_createCCtx()), dctx(ZSTD_createDCtx()) {
+    if (cctx == nullptr || dctx == nullptr) {
+      ZSTD_freeCCtx(cctx);
+      ZSTD_freeDCtx(dctx);
+      throw std::bad_alloc();
+    }
+  }
+  ~ZstdContexts() {
+    ZSTD_freeCCtx(cctx);
+    ZSTD_freeDCtx(dctx);
+  }
+
+  ZSTD_CCtx* const cctx;
+  ZSTD_DCtx* const dctx;
+};
+
+ZstdContexts& getZstdContexts() {
+  static thread_local ZstdContexts contexts;
+  return contexts;
+}
+
+folly::io::Codec& getLz4Codec() {
+  static thread_local std::unique_ptr<folly::io::Codec> codec =
+      folly::io::getCodec(folly::io::CodecType::LZ4);
+  return *codec;
+}
+
+uint64_t getElapsedNs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+} // namespace
+
+void ValueCompressor::Config::validate() const {
+  if (maxCompressedPercent == 0 || maxCompressedPercent > 100) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid max compressed percent: {}", maxCompressedPercent));
+  }
+  if (codec == Codec::kZstd &&
+      (zstdLevel < ZSTD_minCLevel() || zstdLevel > ZSTD_maxCLevel())) {
+    throw std::invalid_argument(
+        folly::sformat("Invalid zstd level: {}", zstdLevel));
+  }
+  if (codec == Codec::kLz4 &&
+      !folly::io::hasCodec(folly::io::CodecType::LZ4)) {
+    throw std::invalid_argument("lz4 is not available");
+  }
+  if (codec != Codec::kZstd && !dictionary.empty()) {
+    throw std::invalid_argument("Only zstd supports a dictionary");
+  }
+}
+
+std::string ValueCompressor::trainDictionary(
+    const std::vector<std::string>& samples, size_t maxSize) {
+  std::string samplesBuffer;
+  std::vector<size_t> samplesSizes;
+  samplesSizes.reserve(samples.size());
+  for (const auto& sample : samples) {
+    samplesBuffer.append(sample);
+    samplesSizes.push_back(sample.size());
+  }
+
+  std::string dictionary(maxSize, '\0');
+  const auto size = ZDICT_trainFromBuffer(
+      dictionary.data(), dictionary.size(), samplesBuffer.data(),
+      samplesSizes.data(), static_cast<unsigned int>(samplesSizes.size()));
+  if (ZDICT_isError(size)) {
+    throw std::invalid_argument(
+        folly::sformat("Failed to train a dictionary from {} samples: {}",
+                       samples.size(), ZDICT_getErrorName(size)));
+  }
+  dictionary.resize(size);
+  return dictionary;
+}
+
+ValueCompressor::ValueCompressor(Config config) : config_(std::move(config)) {
+  config_.validate();
+  if (!config_.dictionary.empty()) {
+    cdict_ = ZSTD_createCDict(config_.dictionary.data(),
+                              config_.dictionary.size(), config_.zstdLevel);
+    ddict_ = ZSTD_createDDict(config_.dictionary.data(),
+                              config_.dictionary.size());
+    if (cdict_ == nullptr || ddict_ == nullptr) {
+      ZSTD_freeCDict(cdict_);
+      ZSTD_freeDDict(ddict_);
+      throw std::invalid_argument("Invalid zstd dictionary");
+    }
+  }
+}
+
+ValueCompressor::~ValueCompressor() {
+  ZSTD_freeCDict(cdict_);
+  ZSTD_freeDDict(ddict_);
+}
+
+std::unique_ptr<folly::IOBuf> ValueCompressor::compress(
+    folly::ByteRange value) {
+  if (value.size() < config_.minSize) {
+    numSkippedSmall_.inc();
+    return nullptr;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const size_t bound = config_.codec == Codec::kZstd
+                           ? ZSTD_compressBound(value.size())
+                           : getLz4Codec().maxCompressedLength(value.size());
+  auto buf = folly::IOBuf::create(kHeaderSize + bound);
+  const auto uncompressedSize = static_cast<uint32_t>(value.size());
+  std::memcpy(buf->writableData(), &uncompressedSize, kHeaderSize);
+  uint8_t* out = buf->writableData() + kHeaderSize;
+  const size_t size = config_.codec == Codec::kZstd
+                          ? compressZstd(value, out, bound)
+                          : compressLz4(value, out, bound);
+  compressNs_.add(getElapsedNs(start));
+
+  if ((kHeaderSize + size) * 100 >
+      value.size() * config_.maxCompressedPercent) {
+    numSkippedRatio_.inc();
+    return nullptr;
+  }
+  buf->append(kHeaderSize + size);
+
+  numCompressed_.inc();
+  uncompressedBytes_.add(value.size());
+  compressedBytes_.add(buf->length());
+  return buf;
+}
+
+size_t ValueCompressor::compressZstd(folly::ByteRange value,
+                                     uint8_t* out,
+                                     size_t outSize) {
+  auto* cctx = getZstdContexts().cctx;
+  const auto size =
+      cdict_ ? ZSTD_compress_usingCDict(cctx, out, outSize, value.data(),
+                                        value.size(), cdict_)
+             : ZSTD_compressCCtx(cctx, out, outSize, value.data(),
+                                 value.size(), config_.zstdLevel);
+  if (ZSTD_isError(size)) {
+    // the output has room for the bound, so this is not expected.
+    throw std::runtime_error(folly::sformat("Failed to compress a value: {}",
+                                            ZSTD_getErrorName(size)));
+  }
+  return size;
+}
+
+size_t ValueCompressor::compressLz4(folly::ByteRange value,
+                                    uint8_t* out,
+                                    size_t outSize) {
+  const auto compressed = getLz4Codec().compress(folly::StringPiece(value));
+  if (compressed.size() > outSize) {
+    throw std::runtime_error(
+        folly::sformat("Compressed value of {} bytes is larger than the {} "
+                       "bytes bound",
+                       compressed.size(), outSize));
+  }
+  std::memcpy(out, compressed.data(), compressed.size());
+  return compressed.size();
+}
+
+uint32_t ValueCompressor::getUncompressedSize(folly::ByteRange compressed) {
+  if (compressed.size() < kHeaderSize) {
+    throw std::invalid_argument(folly::sformat(
+        "Compressed value of {} bytes is too short", compressed.size()));
+  }
+  uint32_t size;
+  std::memcpy(&size, compressed.data(), kHeaderSize);
+  return size;
+}
+
+std::unique_ptr<folly::IOBuf> ValueCompressor::uncompress(
+    folly::ByteRange compressed) {
+  const auto start = std::chrono::steady_clock::now();
+  const uint32_t size = getUncompressedSize(compressed);
+  compressed.advance(kHeaderSize);
+
+  auto buf = folly::IOBuf::create(size);
+  if (config_.codec == Codec::kZstd) {
+    uncompressZstd(compressed, buf->writableData(), size);
+  } else {
+    uncompressLz4(compressed, buf->writableData(), size);
+  }
+  buf->append(size);
+
+  uncompressNs_.add(getElapsedNs(start));
+  numUncompressed_.inc();
+  return buf;
+}
+
+void ValueCompressor::uncompressZstd(folly::ByteRange compressed,
+                                     uint8_t* out,
+                                     size_t size) {
+  auto* dctx = getZstdContexts().dctx;
+  const auto res =
+      ddict_ ? ZSTD_decompress_usingDDict(dctx, out, size, compressed.data(),
+                                          compressed.size(), ddict_)
+             : ZSTD_decompressDCtx(dctx, out, size, compressed.data(),
+                                   compressed.size());
+  if (ZSTD_isError(res) || res != size) {
+    throw std::invalid_argument(folly::sformat(
+        "Corrupted compressed value. Expected {} bytes, got {}: {}", size,
+        ZSTD_isError(res) ? 0 : res,
+        ZSTD_isError(res) ? ZSTD_getErrorName(res) : ""));
+  }
+}
+
+void ValueCompressor::uncompressLz4(folly::ByteRange compressed,
+                                    uint8_t* out,
+                                    size_t size) {
+  std::string value;
+  try {
+    value = getLz4Codec().uncompress(folly::StringPiece(compressed),
+                                     uint64_t{size});
+  } catch (const std::exception& e) {
+    throw std::invalid_argument(
+        folly::sformat("Corrupted compressed value: {}", e.what()));
+  }
+  if (value.size() != size) {
+    throw std::invalid_argument(folly::sformat(
+        "Corrupted compressed value. Expected {} bytes, got {}", size,
+        value.size()));
+  }
+  std::memcpy(out, value.data(), size);
+}
+
+ValueCompressionStats ValueCompressor::getStats() const {
+  ValueCompressionStats stats;
+  stats.numCompressed = numCompressed_.get();
+  stats.numSkippedSmall = numSkippedSmall_.get();
+  stats.numSkippedRatio = numSkippedRatio_.get();
+  stats.numUncompressed = numUncompressed_.get();
+  stats.uncompressedBytes = uncompressedBytes_.get();
+  stats.compressedBytes = compressedBytes_.get();
+  stats.compressNs = compressNs_.get();
+  stats.uncompressNs = uncompressNs_.get();
+  return stats;
+}
+
+} // namespace cachelib
+} // namespace facebook
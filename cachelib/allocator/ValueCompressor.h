@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cachelib/allocator/CacheStats.h"
+#include "cachelib/common/AtomicCounter.h"
+
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
+namespace facebook {
+namespace cachelib {
+
+// Compresses the values of the items of a pool, so that compressible values
+// take a smaller allocation class. See CacheAllocator::allocateCompressed.
+//
+// A compressed value is stored with a small header that has its
+// uncompressed size, so it can be uncompressed into a buffer of the right
+// size. Values that are too small or do not compress well enough are stored
+// as is, since uncompressing them on every read would cost more than the
+// memory saved.
+//
+// All the methods are thread safe.
+class ValueCompressor {
+ public:
+  enum class Codec {
+    // zstd, optionally with a dictionary
+    kZstd,
+
+    // lz4. Faster but compresses less than zstd.
+    kLz4,
+  };
+
+  struct Config {
+    Codec codec{Codec::kZstd};
+
+    // zstd compression level. Ignored for lz4.
+    int zstdLevel{1};
+
+    // values smaller than this are stored as is
+    uint32_t minSize{4096};
+
+    // values whose compressed size is more than this percentage of their
+    // size are stored as is
+    uint32_t maxCompressedPercent{80};
+
+    // zstd dictionary, see trainDictionary. Empty to not use one. A
+    // dictionary trained on samples of the values makes small values
+    // compress much better.
+    std::string dictionary;
+
+    // @throw std::invalid_argument if the config is invalid
+    void validate() const;
+  };
+
+  // train a zstd dictionary on samples of the values of a pool.
+  //
+  // @param samples   sample values
+  // @param maxSize   maximum size of the dictionary
+  //
+  // @return the dictionary
+  // @throw std::invalid_argument if the dictionary can not be trained, for
+  //        example because there are too few samples.
+  static std::string trainDictionary(const std::vector<std::string>& samples,
+                                     size_t maxSize = 64 * 1024);
+
+  // @throw std::invalid_argument if the config is invalid
+  explicit ValueCompressor(Config config);
+  ~ValueCompressor();
+
+  ValueCompressor(const ValueCompressor&) = delete;
+  ValueCompressor& operator=(const ValueCompressor&) = delete;
+
+  // compress a value
+  //
+  // @return the compressed value with its header, or nullptr if the value
+  //         should be stored as is.
+  std::unique_ptr<folly::IOBuf> compress(folly::ByteRange value);
+
+  // uncompress a value returned by compress
+  //
+  // @return the value
+  // @throw std::invalid_argument if the compressed value is corrupted
+  std::unique_ptr<folly::IOBuf> uncompress(folly::ByteRange compressed);
+
+  // @return the size the compressed value uncompresses to
+  // @throw std::invalid_argument if the compressed value is too short
+  static uint32_t getUncompressedSize(folly::ByteRange compressed);
+
+  ValueCompressionStats getStats() const;
+
+  const Config& getConfig() const noexcept { return config_; }
+
+ private:
+  // size of the header of compressed values
+  static constexpr size_t kHeaderSize = sizeof(uint32_t);
+
+  // compress into out, which has room for the bound of the codec.
+  //
+  // @return the compressed size
+  size_t compressZstd(folly::ByteRange value, uint8_t* out, size_t outSize);
+  size_t compressLz4(folly::ByteRange value, uint8_t* out, size_t outSize);
+
+  void uncompressZstd(folly::ByteRange compressed, uint8_t* out, size_t size);
+  void uncompressLz4(folly::ByteRange compressed, uint8_t* out, size_t size);
+
+  const Config config_;
+
+  // digested dictionary, created once since creating it is much more
+  // expensive than compressing a value. nullptr without a dictionary.
+  ZSTD_CDict_s* cdict_{nullptr};
+  ZSTD_DDict_s* ddict_{nullptr};
+
+  AtomicCounter numCompressed_;
+  AtomicCounter numSkippedSmall_;
+  AtomicCounter numSkippedRatio_;
+  AtomicCounter numUncompressed_;
+  AtomicCounter uncompressedBytes_;
+  AtomicCounter compressedBytes_;
+  AtomicCounter compressNs_;
+  AtomicCounter uncompressNs_;
+};
+} // namespace cachelib
+} // namespace facebook
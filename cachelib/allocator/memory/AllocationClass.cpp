@@ -31,6 +31,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <mutex>
 #include <stdexcept>
 #include <thread>
 
@@ -41,17 +42,45 @@ using namespace facebook::cachelib;
 constexpr unsigned int AllocationClass::kFreeAllocsPruneLimit;
 constexpr unsigned int AllocationClass::kFreeAllocsPruneSleepMicroSecs;
 constexpr unsigned int AllocationClass::kForEachAllocPrefetchOffset;
+constexpr size_t AllocationClass::kNumMagazines;
+constexpr size_t AllocationClass::kMaxMagazineBytes;
 
 AllocationClass::AllocationClass(ClassId classId,
                                  PoolId poolId,
                                  uint32_t allocSize,
-                                 const SlabAllocator& s)
+                                 const SlabAllocator& s,
+                                 uint32_t magazineSize)
     : classId_(classId),
       poolId_(poolId),
       allocationSize_(allocSize),
+      magazineCapacity_(getMagazineCapacity(magazineSize, allocSize)),
       slabAlloc_(s),
       freedAllocations_{slabAlloc_.createSingleTierPtrCompressor<FreeAlloc>()} {
   checkState();
+  initMagazines();
+}
+
+uint32_t AllocationClass::getMagazineCapacity(uint32_t magazineSize,
+                                              uint32_t allocSize) noexcept {
+  if (allocSize == 0) {
+    return 0;
+  }
+  const auto byBytes = kMaxMagazineBytes / allocSize;
+  const auto capacity =
+      static_cast<uint32_t>(std::min<size_t>(magazineSize, byBytes));
+  // a magazine moves half of its capacity at a time. Anything smaller than
+  // that is not worth the extra lock.
+  return capacity < 2 ? 0 : capacity;
+}
+
+void AllocationClass::initMagazines() {
+  if (magazineCapacity_ == 0) {
+    return;
+  }
+  magazines_ = std::make_unique<Magazine[]>(kNumMagazines);
+  for (size_t i = 0; i < kNumMagazines; i++) {
+    magazines_[i].allocs = std::make_unique<void*[]>(magazineCapacity_);
+  }
 }
 
 void AllocationClass::checkState() const {
@@ -94,10 +123,13 @@ void AllocationClass::checkState() const {
 AllocationClass::AllocationClass(
     const serialization::AllocationClassObject& object,
     PoolId poolId,
-    const SlabAllocator& s)
+    const SlabAllocator& s,
+    uint32_t magazineSize)
     : classId_(*object.classId_ref()),
       poolId_(poolId),
       allocationSize_(static_cast<uint32_t>(*object.allocationSize_ref())),
+      magazineCapacity_(getMagazineCapacity(
+          magazineSize, static_cast<uint32_t>(*object.allocationSize_ref()))),
       currOffset_(static_cast<uint32_t>(*object.currOffset_ref())),
       currSlab_(s.getSlabForIdx(*object.currSlabIdx_ref())),
       slabAlloc_(s),
@@ -117,6 +149,7 @@ AllocationClass::AllocationClass(
   }
 
   checkState();
+  initMagazines();
 }
 
 void AllocationClass::addSlabLocked(Slab* slab) {
@@ -124,6 +157,7 @@ void AllocationClass::addSlabLocked(Slab* slab) {
   auto header = slabAlloc_.getSlabHeader(slab);
   header->classId = classId_;
   header->allocSize = allocationSize_;
+  header->numFreeAllocs = 0;
   freeSlabs_.push_back(slab);
 }
 
@@ -153,12 +187,99 @@ bool AllocationClass::canAllocateFromCurrentSlabLocked() const noexcept {
 }
 
 void* AllocationClass::allocate() {
+  if (magazines_) {
+    return allocateFromMagazine();
+  }
   if (!canAllocate_) {
     return nullptr;
   }
   return lock_->lock_combine([this]() -> void* { return allocateLocked(); });
 }
 
+void* AllocationClass::allocateFromMagazine() {
+  auto& magazine = getMagazine();
+  std::lock_guard<folly::SpinLock> g(magazine.lock);
+  if (magazine.size > 0) {
+    ++magazine.numHits;
+    return magazine.allocs[--magazine.size];
+  }
+
+  if (!canAllocate_) {
+    return nullptr;
+  }
+
+  // refill half of the magazine in one critical section, leaving room for
+  // the frees that follow.
+  const uint32_t batch = magazineCapacity_ / 2;
+  magazine.size = lock_->lock_combine([this, &magazine, batch]() {
+    uint32_t n = 0;
+    while (n < batch) {
+      void* alloc = allocateLocked();
+      if (alloc == nullptr) {
+        break;
+      }
+      const auto* header = slabAlloc_.getSlabHeader(alloc);
+      if (header->isMarkedForRelease()) {
+        // the slab release that marked this slab has not pruned the free
+        // list yet. Hand the alloc to the release instead of caching it.
+        const auto* slab = slabAlloc_.getSlabForMemory(alloc);
+        getSlabReleaseAllocMapLocked(slab)[getAllocIdx(slab, alloc)] = true;
+        continue;
+      }
+      magazine.allocs[n++] = alloc;
+    }
+    return n;
+  });
+
+  if (magazine.size == 0) {
+    return nullptr;
+  }
+  ++magazine.numRefills;
+  return magazine.allocs[--magazine.size];
+}
+
+bool AllocationClass::freeToMagazine(void* memory, const SlabHeader* header) {
+  auto& magazine = getMagazine();
+  std::lock_guard<folly::SpinLock> g(magazine.lock);
+  // checked under the magazine lock. startSlabRelease marks the slab before
+  // draining the magazines, so either the drain finds this alloc or we see
+  // the mark here.
+  if (header->isMarkedForRelease()) {
+    return false;
+  }
+
+  if (magazine.size == magazineCapacity_) {
+    flushMagazineLocked(magazine, magazineCapacity_ / 2);
+    ++magazine.numFlushes;
+  }
+  magazine.allocs[magazine.size++] = memory;
+  return true;
+}
+
+void AllocationClass::flushMagazineLocked(Magazine& magazine, uint32_t n) {
+  n = std::min(n, magazine.size);
+  if (n == 0) {
+    return;
+  }
+  lock_->lock_combine([this, &magazine, n]() {
+    for (uint32_t i = 0; i < n; i++) {
+      insertFreeAllocLocked(magazine.allocs[--magazine.size]);
+    }
+    canAllocate_ = true;
+  });
+}
+
+void AllocationClass::drainMagazines() {
+  if (!magazines_) {
+    return;
+  }
+  for (size_t i = 0; i < kNumMagazines; i++) {
+    auto& magazine = magazines_[i];
+    std::lock_guard<folly::SpinLock> g(magazine.lock);
+    flushMagazineLocked(magazine, magazine.size);
+  }
+}
+
 void* AllocationClass::allocateLocked() {
   // fast path for case when the cache is mostly full.
   if (freedAllocations_.empty() && freeSlabs_.empty() &&
@@ -174,6 +295,9 @@ void* AllocationClass::allocateLocked() {
     FreeAlloc* ret = freedAllocations_.getHead();
     XDCHECK(ret != nullptr);
     freedAllocations_.pop();
+    auto* header = slabAlloc_.getSlabHeader(ret);
+    XDCHECK(header->numFreeAllocs > 0);
+    --header->numFreeAllocs;
     return reinterpret_cast<void*>(ret);
   }
 
@@ -190,6 +314,11 @@ void* AllocationClass::allocateLocked() {
   return allocateFromCurrentSlabLocked();
 }
 
+void AllocationClass::insertFreeAllocLocked(void* memory) {
+  freedAllocations_.insert(*reinterpret_cast<FreeAlloc*>(memory));
+  ++slabAlloc_.getSlabHeader(memory)->numFreeAllocs;
+}
+
 void AllocationClass::setupCurrentSlabLocked() {
   XDCHECK(!freeSlabs_.empty());
   auto slab = freeSlabs_.back();
@@ -252,7 +381,8 @@ SlabReleaseContext AllocationClass::startSlabRelease(
     }
 
     // The slab is actively used, so we create a new release alloc map
-    // and mark the slab for release
+    // and mark the slab for release. Once marked, frees into this slab
+    // bypass the magazines.
     header->setMarkedForRelease(true);
     createSlabReleaseAllocMapLocked(slab);
 
@@ -288,6 +418,10 @@ SlabReleaseContext AllocationClass::startSlabRelease(
     }
   } // alloc lock scope
 
+  // the magazines might hold free allocs of the slab. Move them to the free
+  // list so the pruning below accounts for them.
+  drainMagazines();
+
   auto results = pruneFreeAllocs(slab, shouldAbortFn);
   if (results.first) {
     lock_->lock_combine([&]() {
@@ -386,6 +520,7 @@ std::pair<bool, std::vector<void*>> AllocationClass::pruneFreeAllocs(
       }
 
       auto& allocState = getSlabReleaseAllocMapLocked(slab);
+      auto* header = slabAlloc_.getSlabHeader(slab);
       // Mark allocs we found while not holding the lock as freed.
       while (!inSlab.empty()) {
         auto alloc = inSlab.getHead();
@@ -395,6 +530,8 @@ std::pair<bool, std::vector<void*>> AllocationClass::pruneFreeAllocs(
         const auto idx = getAllocIdx(slab, reinterpret_cast<void*>(alloc));
         XDCHECK_LT(idx, allocState.size());
         allocState[idx] = true;
+        XDCHECK(header->numFreeAllocs > 0);
+        --header->numFreeAllocs;
       }
     }); // alloc lock scope
 
@@ -472,6 +609,26 @@ bool AllocationClass::allFreed(const Slab* slab) const {
   });
 }
 
+std::pair<const Slab*, uint32_t> AllocationClass::getSparsestSlab() {
+  return lock_->lock_combine([this]() -> std::pair<const Slab*, uint32_t> {
+    if (!freeSlabs_.empty()) {
+      return {freeSlabs_.front(), getAllocsPerSlab()};
+    }
+
+    // slabs being released are not in allocatedSlabs_.
+    const Slab* sparsest = nullptr;
+    uint32_t maxFreeAllocs = 0;
+    for (const auto* slab : allocatedSlabs_) {
+      const auto numFreeAllocs = slabAlloc_.getSlabHeader(slab)->numFreeAllocs;
+      if (slab != currSlab_ && numFreeAllocs > maxFreeAllocs) {
+        sparsest = slab;
+        maxFreeAllocs = numFreeAllocs;
+      }
+    }
+    return {sparsest, maxFreeAllocs};
+  });
+}
+
 void AllocationClass::waitUntilAllFreed(const Slab* slab) {
   util::Throttler t{util::Throttler::Config{
       1000, /* sleepTime. milliseconds */
@@ -499,8 +656,7 @@ void AllocationClass::abortSlabRelease(const SlabReleaseContext& context) {
       const auto& allocState = it->second;
       for (size_t idx = 0; idx < allocState.size(); idx++) {
         if (allocState[idx]) {
-          auto alloc = getAllocForIdx(slab, idx);
-          freedAllocations_.insert(*reinterpret_cast<FreeAlloc*>(alloc));
+          insertFreeAllocLocked(getAllocForIdx(slab, idx));
           inserted = true;
         }
       }
@@ -632,6 +788,10 @@ void AllocationClass::free(void* memory) {
         memory, header ? header->classId : Slab::kInvalidClassId, classId_));
   }
 
+  if (magazines_ && freeToMagazine(memory, header)) {
+    return;
+  }
+
   const auto slabPtrVal = getSlabPtrValue(slab);
   lock_->lock_combine([this, header, slab, memory, slabPtrVal]() {
     // check under the lock we actually add the allocation back to the free list
@@ -657,12 +817,12 @@ void AllocationClass::free(void* memory) {
     }
 
     // TODO add checks here to ensure that we dont double free in debug mode.
-    freedAllocations_.insert(*reinterpret_cast<FreeAlloc*>(memory));
+    insertFreeAllocLocked(memory);
     canAllocate_ = true;
   });
 }
 
-serialization::AllocationClassObject AllocationClass::saveState() const {
+serialization::AllocationClassObject AllocationClass::saveState() {
   if (!slabAlloc_.isRestorable()) {
     throw std::logic_error("The allocation class cannot be restored.");
   }
@@ -671,6 +831,9 @@ serialization::AllocationClassObject AllocationClass::saveState() const {
         "Can not save state when there are active slab releases happening");
   }
 
+  // the magazines are not persisted.
+  drainMagazines();
+
   serialization::AllocationClassObject object;
   *object.classId_ref() = classId_;
   *object.allocationSize_ref() = allocationSize_;
@@ -688,19 +851,43 @@ serialization::AllocationClassObject AllocationClass::saveState() const {
 }
 
 ACStats AllocationClass::getStats() const {
-  return lock_->lock_combine([this]() -> ACStats {
+  // the magazines are read before lock_ since their locks are ordered
+  // before it. The counts can be off by a few in flight allocations.
+  unsigned long long nMagazineAllocs = 0;
+  uint64_t numHits = 0;
+  uint64_t numRefills = 0;
+  uint64_t numFlushes = 0;
+  if (magazines_) {
+    for (size_t i = 0; i < kNumMagazines; i++) {
+      auto& magazine = magazines_[i];
+      std::lock_guard<folly::SpinLock> g(magazine.lock);
+      nMagazineAllocs += magazine.size;
+      numHits += magazine.numHits;
+      numRefills += magazine.numRefills;
+      numFlushes += magazine.numFlushes;
+    }
+  }
+
+  auto stats = lock_->lock_combine([this, nMagazineAllocs]() -> ACStats {
     const auto freeAllocsInCurrSlab =
         canAllocateFromCurrentSlabLocked()
             ? (Slab::kSize - currOffset_) / allocationSize_
             : 0;
     const unsigned long long perSlab = getAllocsPerSlab();
     const unsigned long long nSlabsAllocated = allocatedSlabs_.size();
-    const unsigned long long nFreedAllocs = freedAllocations_.size();
+    const unsigned long long totalAllocs = nSlabsAllocated * perSlab;
+    const unsigned long long nFreedAllocs = std::min<unsigned long long>(
+        freedAllocations_.size() + nMagazineAllocs,
+        totalAllocs - freeAllocsInCurrSlab);
     const unsigned long long nActiveAllocs =
-        nSlabsAllocated * perSlab - nFreedAllocs - freeAllocsInCurrSlab;
+        totalAllocs - nFreedAllocs - freeAllocsInCurrSlab;
     return {allocationSize_, perSlab,       nSlabsAllocated, freeSlabs_.size(),
             nFreedAllocs,    nActiveAllocs, isFull()};
   });
+  stats.magazineHits = numHits;
+  stats.magazineRefills = numRefills;
+  stats.magazineFlushes = numFlushes;
+  return stats;
 }
 
 void AllocationClass::createSlabReleaseAllocMapLocked(const Slab* slab) {
@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <folly/SpinLock.h>
+#include <folly/concurrency/CacheLocality.h>
+#include <folly/lang/Align.h>
 #include <folly/lang/Aligned.h>
 #include <folly/synchronization/DistributedMutex.h>
 
@@ -48,13 +51,16 @@ class AllocationClass {
   // @param allocSize the size of allocations that this allocation class
   //                  handles.
   // @param s         the slab allocator for fetching the header info.
+  // @param magazineSize  max number of free allocations cached per
+  //                      magazine. 0 disables the magazines.
   //
   // @throw std::invalid_argument if the classId is invalid or the allocSize
   //        is invalid.
   AllocationClass(ClassId classId,
                   PoolId poolId,
                   uint32_t allocSize,
-                  const SlabAllocator& s);
+                  const SlabAllocator& s,
+                  uint32_t magazineSize = 0);
 
   // restore this AllocationClass from the serialized data.
   // @param object  Object that contains the data to restore AllocationClass
@@ -62,6 +68,8 @@ class AllocationClass {
   // @param s       the slab allocator for fetching the header info. s must be
   //                a restorable slab allocator which was previously used with
   //                the same allocation class object.
+  // @param magazineSize  max number of free allocations cached per
+  //                      magazine. 0 disables the magazines.
   //
   // @throw std::invalid_argument if the classId is invalid or the allocSize
   //        is invalid.
@@ -69,7 +77,8 @@ class AllocationClass {
   //        this allocator
   AllocationClass(const serialization::AllocationClassObject& object,
                   PoolId poolId,
-                  const SlabAllocator& s);
+                  const SlabAllocator& s,
+                  uint32_t magazineSize = 0);
 
   AllocationClass(const AllocationClass&) = delete;
   AllocationClass& operator=(const AllocationClass&) = delete;
@@ -88,6 +97,10 @@ class AllocationClass {
     return static_cast<unsigned int>(Slab::kSize / allocationSize_);
   }
 
+  // returns the max number of free allocations a magazine of this class
+  // holds. 0 if the class does not use magazines.
+  uint32_t getMagazineCapacity() const noexcept { return magazineCapacity_; }
+
   // total number of slabs under this AllocationClass.
   unsigned int getNumSlabs() const {
     return lock_->lock_combine([this]() {
@@ -105,7 +118,8 @@ class AllocationClass {
   bool isFull() const noexcept { return !canAllocate_; }
 
   // allocate memory corresponding to the allocation size of this
-  // AllocationClass.
+  // AllocationClass. With magazines enabled, this is served from the
+  // magazine of the current cpu, which is refilled in batches.
   //
   // @return  ptr to the memory of allocationSize_ chunk or nullptr if we
   //          don't have any free memory. The caller will have to add a slab
@@ -206,7 +220,9 @@ class AllocationClass {
     return true;
   }
 
-  // release the memory back to the slab class.
+  // release the memory back to the slab class. With magazines enabled, the
+  // memory goes to the magazine of the current cpu, which is flushed to the
+  // free list in batches.
   //
   // @param memory  memory to be released.
   // @throws std::invalid_argument if the memory does not belong to a slab of
@@ -229,6 +245,9 @@ class AllocationClass {
   //    In some scenario (i.e. when the slab is already released in step 1),
   //    there is no need to do step 2.
   //
+  // Allocations held by the magazines are moved back to the free list before
+  // the free list is pruned, so they are never reported as active.
+  //
   // In between the two steps, the user must ensure any active allocation
   // from the slab is freed by calling ac->free(alloc). completeSlabRelease
   // will block until all the active allocations for the slab are freed back.
@@ -298,6 +317,19 @@ class AllocationClass {
   //          entry.
   bool allFreed(const Slab* slab) const;
 
+  // find the slab with the most free allocations. This is the cheapest slab
+  // to empty by moving its active allocations into the free allocations of
+  // the other slabs. A free slab of this class is returned first. The
+  // current slab and slabs being released are never picked.
+  //
+  // The free allocations are counted per slab in the slab headers as they
+  // go in and out of the free list, so this only goes over the slabs of the
+  // class. Free allocations held by the magazines are not counted.
+  //
+  // @return  the slab and its number of free allocations. The slab is
+  //          nullptr if there is no slab that could be compacted.
+  std::pair<const Slab*, uint32_t> getSparsestSlab();
+
   // for saving and restoring the state of the allocation class
   //
   // precondition:  The object must have been instantiated with a restorable
@@ -306,8 +338,10 @@ class AllocationClass {
   // completed.  Any modification of this object afterwards
   // will result in an invalid, inconsistent state for the serialized data.
   //
+  // The allocations held by the magazines are moved to the free list first.
+  //
   // @throw std::logic_error if the object state can not be serialized
-  serialization::AllocationClassObject saveState() const;
+  serialization::AllocationClassObject saveState();
 
  private:
   // check if the state of the AllocationClass is valid and if not, throws an
@@ -319,6 +353,10 @@ class AllocationClass {
   // precondition: freeSlabs_ must not be empty.
   void setupCurrentSlabLocked();
 
+  // puts the allocation in freedAllocations_ and counts it in its slab
+  // header.
+  void insertFreeAllocLocked(void* memory);
+
   // returns true if the allocation can be satisfied from the current slab.
   bool canAllocateFromCurrentSlabLocked() const noexcept;
 
@@ -400,6 +438,56 @@ class AllocationClass {
   // acquires a new slab for this allocation class.
   void addSlabLocked(Slab* slab);
 
+  // A magazine caches free allocations of this class for the threads
+  // running on one cpu, so they allocate and free without taking lock_.
+  struct alignas(folly::hardware_destructive_interference_size) Magazine {
+    // protects the members below. Ordered before lock_.
+    folly::SpinLock lock;
+
+    // number of free allocations in allocs
+    uint32_t size{0};
+
+    // free allocations, the last one is handed out first
+    std::unique_ptr<void*[]> allocs;
+
+    // allocations served from the magazine
+    uint64_t numHits{0};
+
+    // times the magazine was refilled from the free list
+    uint64_t numRefills{0};
+
+    // times the magazine was flushed to the free list
+    uint64_t numFlushes{0};
+  };
+
+  // max number of allocations a magazine holds for the given alloc size.
+  static uint32_t getMagazineCapacity(uint32_t magazineSize,
+                                      uint32_t allocSize) noexcept;
+
+  // create the magazines if they are enabled
+  void initMagazines();
+
+  // the magazine of the cpu we are running on
+  Magazine& getMagazine() const noexcept {
+    return magazines_[folly::AccessSpreader<>::current(kNumMagazines)];
+  }
+
+  // allocate from the magazine, refilling it if it is empty.
+  void* allocateFromMagazine();
+
+  // put the memory into the magazine, flushing it if it is full.
+  //
+  // @return  false if the memory belongs to a slab being released. Such
+  //          allocations have to be freed through lock_.
+  bool freeToMagazine(void* memory, const SlabHeader* header);
+
+  // move all allocations held by the magazines back to freedAllocations_
+  void drainMagazines();
+
+  // move up to n allocations from the magazine to freedAllocations_.
+  // Magazine lock must be held.
+  void flushMagazineLocked(Magazine& magazine, uint32_t n);
+
   // allocate memory corresponding to the allocation size of this
   // AllocationClass.
   //
@@ -421,6 +509,9 @@ class AllocationClass {
   // the chunk size for the allocations of this allocation class.
   const uint32_t allocationSize_{0};
 
+  // max number of allocations in a magazine. 0 if magazines are disabled.
+  const uint32_t magazineCapacity_{0};
+
   // the offset of the next available allocation.
   uint32_t currOffset_{0};
 
@@ -490,6 +581,15 @@ class AllocationClass {
   // in a slab.
   static constexpr unsigned int kForEachAllocPrefetchOffset = 16;
 
+  static constexpr size_t kNumMagazines = 16;
+
+  // upper bound on the memory cached by a magazine. Keeps the magazines of
+  // large allocation classes from hiding many slabs worth of free memory.
+  static constexpr size_t kMaxMagazineBytes = 256 * 1024;
+
+  // per cpu caches of free allocations. nullptr if disabled.
+  std::unique_ptr<Magazine[]> magazines_;
+
   // Allow access to private members by unit tests
   friend class facebook::cachelib::tests::AllocTestBase;
   FRIEND_TEST(AllocationClassTest, ReleaseSlabMultithread);
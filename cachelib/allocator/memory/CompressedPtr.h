@@ -18,6 +18,7 @@
 
 #include <folly/logging/xlog.h>
 
+#include <limits>
 #include <memory>
 
 #include "cachelib/allocator/memory/Slab.h"
@@ -51,6 +52,11 @@ class CACHELIB_PACKED_ATTR CompressedPtr {
   // Total number of bits to represent a CompressPtr.
   static constexpr size_t kNumBits = NumBits<PtrType>::value;
 
+  // Number of top bits that are always zero in a compressed pointer. Users
+  // of the pointer can keep their own data there, like the compare tag of
+  // the ChainedHashTable, and must clear it before decompressing.
+  static constexpr unsigned int kNumFreeTopBits = 8;
+
   // true if the compressed ptr expands to nullptr.
   bool isNull() const noexcept { return ptr_ == kNull; }
 
@@ -107,6 +113,12 @@ class CACHELIB_PACKED_ATTR CompressedPtr {
   // XXX: optimize
   static constexpr unsigned int kNumTierIdxOffset = 32;
 
+  // the tier id must not reach the free top bits, i.e. stay below 2^24
+  static_assert(static_cast<uint64_t>(std::numeric_limits<TierId>::max()) <
+                    (uint64_t{1} << (NumBits<PtrType>::value -
+                                     kNumTierIdxOffset - kNumFreeTopBits)),
+                "tier ids must stay below 2^24");
+
   static constexpr PtrType kAllocIdxMask = ((PtrType)1 << kNumAllocIdxBits) - 1;
 
   // kNumTierIdxBits most significant bits
@@ -27,6 +27,15 @@ void checkConfig(const MemoryAllocator::Config& config) {
     throw std::invalid_argument("Too many allocation classes");
   }
 }
+
+SlabAllocator::Config getSlabAllocatorConfig(
+    const MemoryAllocator::Config& config) {
+  SlabAllocator::Config slabConfig{config.disableFullCoredump,
+                                   config.lockMemory};
+  slabConfig.hugePages = config.hugePages;
+  slabConfig.hugePageFallback = config.hugePageFallback;
+  return slabConfig;
+}
 } // namespace
 
 MemoryAllocator::MemoryAllocator(Config config,
@@ -36,15 +45,14 @@ MemoryAllocator::MemoryAllocator(Config config,
       slabAllocator_(memoryStart,
                      memSize,
                      {config_.disableFullCoredump, config_.lockMemory}),
-      memoryPoolManager_(slabAllocator_) {
+      memoryPoolManager_(slabAllocator_, config_.magazineSize) {
   checkConfig(config_);
 }
 
 MemoryAllocator::MemoryAllocator(Config config, size_t memSize)
     : config_(std::move(config)),
-      slabAllocator_(memSize,
-                     {config_.disableFullCoredump, config_.lockMemory}),
-      memoryPoolManager_(slabAllocator_) {
+      slabAllocator_(memSize, getSlabAllocatorConfig(config_)),
+      memoryPoolManager_(slabAllocator_, config_.magazineSize) {
   checkConfig(config_);
 }
 
@@ -52,17 +60,21 @@ MemoryAllocator::MemoryAllocator(
     const serialization::MemoryAllocatorObject& object,
     void* memoryStart,
     size_t memSize,
-    bool disableCoredump)
+    bool disableCoredump,
+    uint32_t magazineSize)
     : config_(std::set<uint32_t>{object.allocSizes_ref()->begin(),
                                  object.allocSizes_ref()->end()},
               *object.enableZeroedSlabAllocs_ref(),
               disableCoredump,
-              *object.lockMemory_ref()),
+              *object.lockMemory_ref(),
+              magazineSize),
       slabAllocator_(*object.slabAllocator_ref(),
                      memoryStart,
                      memSize,
                      {config_.disableFullCoredump, config_.lockMemory}),
-      memoryPoolManager_(*object.memoryPoolManager_ref(), slabAllocator_) {
+      memoryPoolManager_(*object.memoryPoolManager_ref(),
+                         slabAllocator_,
+                         config_.magazineSize) {
   checkConfig(config_);
 }
 
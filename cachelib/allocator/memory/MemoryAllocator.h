@@ -72,7 +72,7 @@ class MemoryAllocator {
   using SerializationType = serialization::MemoryAllocatorObject;
 
   // maximum number of allocation classes that we support.
-  static constexpr unsigned int kMaxClasses = 1 << 7;
+  static constexpr unsigned int kMaxClasses = MemoryPool::kMaxClasses;
   static constexpr ClassId kMaxClassId = kMaxClasses - 1;
 
   // maximum number of memory pools that we support.
@@ -87,11 +87,13 @@ class MemoryAllocator {
     Config(std::set<uint32_t> sizes,
            bool zeroOnRelease,
            bool disableCoredump,
-           bool _lockMemory)
+           bool _lockMemory,
+           uint32_t _magazineSize = 0)
         : allocSizes(std::move(sizes)),
           enableZeroedSlabAllocs(zeroOnRelease),
           disableFullCoredump(disableCoredump),
-          lockMemory(_lockMemory) {}
+          lockMemory(_lockMemory),
+          magazineSize(_magazineSize) {}
 
     // Hint to determine the allocation class sizes
     std::set<uint32_t> allocSizes;
@@ -109,6 +111,20 @@ class MemoryAllocator {
     // allocator is not shared, user needs to ensure there are appropriate
     // rlimits setup to lock the memory.
     bool lockMemory{false};
+
+    // Max number of free allocations each allocation class caches per cpu,
+    // so that allocations and frees mostly avoid the lock of the allocation
+    // class. The magazines of large allocation classes hold fewer. 0
+    // disables them. This is not persisted across saved state.
+    uint32_t magazineSize{0};
+
+    // Huge pages backing the memory when the allocator maps it itself.
+    // Memory provided by the caller is mapped by the caller.
+    util::HugePagePolicy hugePages{util::HugePagePolicy::kNone};
+
+    // Fall back to transparent huge pages if the hugetlb pool can not back
+    // the memory.
+    bool hugePageFallback{true};
   };
 
   // Creates a memory allocator out of the caller allocated memory region. The
@@ -146,10 +162,12 @@ class MemoryAllocator {
   // @param memSize         the size of the memory region that was originally
   //                        used to create this memory allocator
   // @param disableCoredump exclude mapped region from core dumps
+  // @param magazineSize    see Config::magazineSize
   MemoryAllocator(const serialization::MemoryAllocatorObject& object,
                   void* memoryStart,
                   size_t memSize,
-                  bool disableCoredump);
+                  bool disableCoredump,
+                  uint32_t magazineSize = 0);
 
   MemoryAllocator(const MemoryAllocator&) = delete;
   MemoryAllocator& operator=(const MemoryAllocator&) = delete;
@@ -304,6 +322,13 @@ class MemoryAllocator {
   //        does not have the allocStateMap entry.
   bool allAllocsFreed(const SlabReleaseContext& ctx) const;
 
+  // See AllocationClass::getSparsestSlab
+  //
+  // @throw std::invalid_argument if the pool id or class id is invalid.
+  std::pair<const Slab*, uint32_t> getSparsestSlab(PoolId pid, ClassId cid) {
+    return memoryPoolManager_.getPoolById(pid).getSparsestSlab(cid);
+  }
+
   // See AllocationClass::processAllocForRelease
   void processAllocForRelease(const SlabReleaseContext& ctx,
                               void* memory,
@@ -411,6 +436,13 @@ class MemoryAllocator {
     return memoryPoolManager_.getAdvisedMemorySize();
   }
 
+  // return the memory the slabs of this allocator are carved from.
+  folly::ByteRange getSlabMemoryRange() const noexcept {
+    return folly::ByteRange{
+        reinterpret_cast<const uint8_t*>(slabAllocator_.getSlabMemoryBegin()),
+        reinterpret_cast<const uint8_t*>(slabAllocator_.getSlabMemoryEnd())};
+  }
+
   // return the list of pool ids for this allocator.
   std::set<PoolId> getPoolIds() const {
     return memoryPoolManager_.getPoolIds();
@@ -502,6 +534,18 @@ class MemoryAllocator {
   //          outside of the allocation sizes for the memory pool.
   ClassId getAllocationClassId(PoolId poolId, uint32_t nBytes) const;
 
+  // See MemoryPool::addAllocationClasses
+  //
+  // @throw std::invalid_argument if the pool id or any of the sizes is
+  //        invalid.
+  std::vector<ClassId> addAllocationClasses(
+      PoolId pid,
+      const std::set<uint32_t>& allocSizes,
+      const std::function<void(const AllocationClass&)>& beforePublish = {}) {
+    return memoryPoolManager_.getPoolById(pid).addAllocationClasses(
+        allocSizes, beforePublish);
+  }
+
   // for saving the state of the memory allocator
   //
   // precondition:  The object must have been instantiated with a restorable
@@ -47,6 +47,16 @@ struct ACStats {
   // true if the allocation class is full.
   bool full;
 
+  // allocations served from the per cpu magazines without taking the lock
+  // of the allocation class.
+  uint64_t magazineHits{0};
+
+  // number of times a magazine was refilled from the free list.
+  uint64_t magazineRefills{0};
+
+  // number of times a full magazine was flushed to the free list.
+  uint64_t magazineFlushes{0};
+
   constexpr unsigned long long totalSlabs() const noexcept {
     return freeSlabs + usedSlabs;
   }
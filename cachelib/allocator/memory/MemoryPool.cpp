@@ -44,10 +44,13 @@ std::vector<uint32_t> MemoryPool::createMcSizesFromSerialized(
 MemoryPool::ACVector MemoryPool::createMcFromSerialized(
     const serialization::MemoryPoolObject& object,
     PoolId poolId,
-    SlabAllocator& alloc) {
+    SlabAllocator& alloc,
+    uint32_t magazineSize) {
   MemoryPool::ACVector ac;
+  ac.reserve(kMaxClasses);
   for (const auto& allocClassObject : *object.ac_ref()) {
-    ac.emplace_back(new AllocationClass(allocClassObject, poolId, alloc));
+    ac.emplace_back(
+        new AllocationClass(allocClassObject, poolId, alloc, magazineSize));
   }
   return ac;
 }
@@ -55,24 +58,30 @@ MemoryPool::ACVector MemoryPool::createMcFromSerialized(
 MemoryPool::MemoryPool(PoolId id,
                        size_t poolSize,
                        SlabAllocator& alloc,
-                       const std::set<uint32_t>& allocSizes)
+                       const std::set<uint32_t>& allocSizes,
+                       uint32_t magazineSize)
     : id_(id),
       maxSize_{poolSize},
       slabAllocator_(alloc),
       acSizes_(allocSizes.begin(), allocSizes.end()),
+      magazineSize_(magazineSize),
       ac_(createAllocationClasses()) {
   checkState();
+  LockHolder l(lock_);
+  publishSizeIndexLocked();
 }
 
 MemoryPool::MemoryPool(const serialization::MemoryPoolObject& object,
-                       SlabAllocator& alloc)
+                       SlabAllocator& alloc,
+                       uint32_t magazineSize)
     : id_(*object.id_ref()),
       maxSize_(*object.maxSize_ref()),
       currSlabAllocSize_(*object.currSlabAllocSize_ref()),
       currAllocSize_(*object.currAllocSize_ref()),
       slabAllocator_(alloc),
       acSizes_(createMcSizesFromSerialized(object)),
-      ac_(createMcFromSerialized(object, getId(), alloc)),
+      magazineSize_(magazineSize),
+      ac_(createMcFromSerialized(object, getId(), alloc, magazineSize_)),
       curSlabsAdvised_{static_cast<uint64_t>(*object.numSlabsAdvised_ref())},
       nSlabResize_{static_cast<unsigned int>(*object.numSlabResize_ref())},
       nSlabRebalance_{
@@ -86,6 +95,8 @@ MemoryPool::MemoryPool(const serialization::MemoryPoolObject& object,
     freeSlabs_.push_back(slabAllocator_.getSlabForIdx(freeSlabIdx));
   }
   checkState();
+  LockHolder l(lock_);
+  publishSizeIndexLocked();
 }
 
 void MemoryPool::checkState() const {
@@ -114,13 +125,18 @@ void MemoryPool::checkState() const {
         acSizes_.size(), ac_.size()));
   }
 
-  if (!std::is_sorted(acSizes_.begin(), acSizes_.end())) {
-    throw std::invalid_argument("Allocation sizes are not sorted.");
+  if (acSizes_.size() > kMaxClasses) {
+    throw std::invalid_argument(
+        folly::sformat("Too many allocation classes: {}", acSizes_.size()));
   }
 
+  // classes added to a live pool come after the ones it was created with, so
+  // only the original ones are sorted.
+  auto sortedSizes = acSizes_;
+  std::sort(sortedSizes.begin(), sortedSizes.end());
   const auto firstDuplicate =
-      std::adjacent_find(acSizes_.begin(), acSizes_.end());
-  if (firstDuplicate != acSizes_.end()) {
+      std::adjacent_find(sortedSizes.begin(), sortedSizes.end());
+  if (firstDuplicate != sortedSizes.end()) {
     throw std::invalid_argument(
         folly::sformat("Duplicate allocation size: {}", *firstDuplicate));
   }
@@ -144,13 +160,15 @@ void MemoryPool::checkState() const {
 
 MemoryPool::ACVector MemoryPool::createAllocationClasses() const {
   ACVector ac;
+  ac.reserve(kMaxClasses);
   ClassId id = 0;
   for (const auto size : acSizes_) {
     if (size < Slab::kMinAllocSize || size > Slab::kSize) {
       throw std::invalid_argument(
           folly::sformat("Invalid allocation class size {}", size));
     }
-    ac.emplace_back(new AllocationClass(id++, getId(), size, slabAllocator_));
+    ac.emplace_back(new AllocationClass(id++, getId(), size, slabAllocator_,
+                                        magazineSize_));
   }
   XDCHECK(std::is_sorted(ac.begin(),
                          ac.end(),
@@ -162,6 +180,75 @@ MemoryPool::ACVector MemoryPool::createAllocationClasses() const {
   return ac;
 }
 
+void MemoryPool::publishSizeIndexLocked() {
+  auto index = std::make_unique<SizeIndex>();
+  std::vector<ClassId> ids(acSizes_.size());
+  for (size_t i = 0; i < ids.size(); i++) {
+    ids[i] = static_cast<ClassId>(i);
+  }
+  std::sort(ids.begin(), ids.end(), [this](ClassId a, ClassId b) {
+    return acSizes_[a] < acSizes_[b];
+  });
+  for (const auto cid : ids) {
+    index->sizes.push_back(acSizes_[cid]);
+    index->classIds.push_back(cid);
+  }
+
+  // the classes must be visible before the index can hand them out.
+  numClasses_.store(static_cast<unsigned int>(ac_.size()),
+                    std::memory_order_release);
+  sizeIndexes_.push_back(std::move(index));
+  sizeIndex_.store(sizeIndexes_.back().get(), std::memory_order_release);
+}
+
+std::vector<ClassId> MemoryPool::addAllocationClasses(
+    const std::set<uint32_t>& allocSizes,
+    const std::function<void(const AllocationClass&)>& beforePublish) {
+  LockHolder l(lock_);
+  std::vector<uint32_t> newSizes;
+  for (const auto size : allocSizes) {
+    if (size < Slab::kMinAllocSize || size > Slab::kSize) {
+      throw std::invalid_argument(
+          folly::sformat("Invalid allocation class size {}", size));
+    }
+    if (std::find(acSizes_.begin(), acSizes_.end(), size) == acSizes_.end()) {
+      newSizes.push_back(size);
+    }
+  }
+
+  if (ac_.size() + newSizes.size() > kMaxClasses) {
+    throw std::invalid_argument(folly::sformat(
+        "Can not add {} allocation classes to pool {} with {} classes. At "
+        "most {} are supported.",
+        newSizes.size(), getId(), ac_.size(), kMaxClasses));
+  }
+
+  std::vector<ClassId> classIds;
+  for (const auto size : newSizes) {
+    const auto cid = static_cast<ClassId>(ac_.size());
+    // capacity is reserved, so the readers of the existing classes are not
+    // affected.
+    XDCHECK_LT(ac_.size(), ac_.capacity());
+    ac_.emplace_back(new AllocationClass(cid, getId(), size, slabAllocator_,
+                                         magazineSize_));
+    acSizes_.push_back(size);
+    classIds.push_back(cid);
+    if (beforePublish) {
+      beforePublish(*ac_.back());
+    }
+  }
+
+  if (!classIds.empty()) {
+    publishSizeIndexLocked();
+  }
+  return classIds;
+}
+
+std::vector<uint32_t> MemoryPool::getAllocSizes() const {
+  LockHolder l(lock_);
+  return acSizes_;
+}
+
 size_t MemoryPool::getCurrentUsedSize() const noexcept {
   LockHolder l(lock_);
   return currSlabAllocSize_ + freeSlabs_.size() * Slab::kSize;
@@ -178,7 +265,7 @@ AllocationClass& MemoryPool::getAllocationClassFor(void* memory) const {
 }
 
 AllocationClass& MemoryPool::getAllocationClassFor(ClassId cid) const {
-  if (cid < static_cast<ClassId>(ac_.size())) {
+  if (cid >= 0 && cid < static_cast<ClassId>(getNumClassId())) {
     XDCHECK(ac_[cid] != nullptr);
     return *ac_[cid];
   }
@@ -190,20 +277,22 @@ const AllocationClass& MemoryPool::getAllocationClass(ClassId cid) const {
 }
 
 ClassId MemoryPool::getAllocationClassId(uint32_t size) const {
-  if (size > acSizes_.back() || size == 0) {
+  // can operate without holding the mutex since a published index does not
+  // change.
+  const auto& index = *sizeIndex_.load(std::memory_order_acquire);
+  if (size > index.sizes.back() || size == 0) {
     throw std::invalid_argument(
         folly::sformat("Invalid size for alloc {} ", size));
   }
 
-  // can operate without holding the mutex since the vector does not change.
-  const auto it = std::lower_bound(acSizes_.begin(), acSizes_.end(), size);
+  const auto it = std::lower_bound(index.sizes.begin(), index.sizes.end(), size);
 
   // we already checked for the bounds.
-  XDCHECK(it != acSizes_.end());
+  XDCHECK(it != index.sizes.end());
 
-  const auto idx = std::distance(acSizes_.begin(), it);
-  XDCHECK_LT(static_cast<size_t>(idx), ac_.size());
-  return static_cast<ClassId>(idx);
+  const auto idx = std::distance(index.sizes.begin(), it);
+  XDCHECK_LT(static_cast<size_t>(index.classIds[idx]), ac_.size());
+  return index.classIds[idx];
 }
 
 ClassId MemoryPool::getAllocationClassId(const void* memory) const {
@@ -224,7 +313,7 @@ ClassId MemoryPool::getAllocationClassId(const void* memory) const {
   }
 
   const auto classId = header->classId;
-  if (classId >= static_cast<ClassId>(ac_.size()) || classId < 0) {
+  if (classId >= static_cast<ClassId>(getNumClassId()) || classId < 0) {
     // at this point, the slab indicates that it belongs to a bogus classId and
     // things are corrupt and the caller cant do anything about it. so throw an
     // exception to abort.
@@ -18,8 +18,10 @@
 
 #include <atomic>
 #include <cstddef>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <vector>
 
 #include "cachelib/allocator/memory/AllocationClass.h"
@@ -49,6 +51,9 @@ class SlabAllocator;
 // of this memory pool from the slab allocator's perspective.
 class MemoryPool {
  public:
+  // maximum number of allocation classes in a pool.
+  static constexpr unsigned int kMaxClasses = 1 << 7;
+
   // creates a pool with the id and size.
   //
   // @param  id         the unique pool id.
@@ -57,20 +62,26 @@ class MemoryPool {
   // @param  allocSizes the set of allocation class sizes for this pool,
   //                    sorted in increasing order. The largest size should be
   //                    less than Slab::kSize.
+  // @param  magazineSize  size of the per cpu magazines of the allocation
+  //                       classes. 0 disables them.
   // @throw std::invalid_argument if allocSizes is invalid
   MemoryPool(PoolId id,
              size_t poolSize,
              SlabAllocator& alloc,
-             const std::set<uint32_t>& allocSizes);
+             const std::set<uint32_t>& allocSizes,
+             uint32_t magazineSize = 0);
 
   // creates a pool by restoring it from a serialized buffer.
   // @param object  Object that contains the data to restore MemoryPool
   // @param alloc   the slab allocator for fetching the header info.
+  // @param magazineSize  size of the per cpu magazines of the allocation
+  //                      classes. 0 disables them.
   // @throw   std::invalid_argument if the object state is invalid.
   //          std::logic_error if the Memory pool is not compatible for
   //          restoration with the slab allocator.
   MemoryPool(const serialization::MemoryPoolObject& object,
-             SlabAllocator& alloc);
+             SlabAllocator& alloc,
+             uint32_t magazineSize = 0);
 
   MemoryPool(const MemoryPool&) = delete;
   MemoryPool& operator=(const MemoryPool&) = delete;
@@ -95,10 +106,10 @@ class MemoryPool {
     return maxSize_ <= advisedSize ? 0 : maxSize_ - advisedSize;
   }
 
-  // returns the allocation class sizes as configured in this pool
-  const std::vector<uint32_t>& getAllocSizes() const noexcept {
-    return acSizes_;
-  }
+  // returns the allocation class sizes of this pool, indexed by class id.
+  // The sizes the pool was created with are sorted. Sizes added with
+  // addAllocationClasses come after them, in the order they were added.
+  std::vector<uint32_t> getAllocSizes() const;
 
   // returns true if the memory pools has more memory allocated than the
   // current size. This is possible because we allow resizing the pool
@@ -280,9 +291,28 @@ class MemoryPool {
   // allocation sizes that it was configured with. All allocations from this
   // pool will have ClassId from [0 .. numClassId - 1] (inclusive).
   unsigned int getNumClassId() const noexcept {
-    return static_cast<unsigned int>(acSizes_.size());
+    return numClasses_.load(std::memory_order_acquire);
   }
 
+  // adds allocation classes to the pool while it is in use. The new classes
+  // get the next class ids and start without any slab. Once added, each
+  // allocation goes to the smallest class that fits it, so the allocations
+  // that fit a new class better move over to it as it acquires slabs.
+  // Sizes the pool already has are skipped.
+  //
+  // @param allocSizes      the allocation sizes of the new classes
+  // @param beforePublish   called with each new class after it is created and
+  //                        before any allocation can be served from it, with
+  //                        the pool lock held.
+  // @return  the class ids of the added classes, in the order of their sizes
+  //
+  // @throw std::invalid_argument if a size is invalid or the pool would end
+  //        up with more than kMaxClasses allocation classes. No class is
+  //        added then.
+  std::vector<ClassId> addAllocationClasses(
+      const std::set<uint32_t>& allocSizes,
+      const std::function<void(const AllocationClass&)>& beforePublish = {});
+
   // Gets allocation class for a given class id and calls forEachAllocation on
   // that allocation class.
   //
@@ -298,6 +328,13 @@ class MemoryPool {
         slab, std::forward<AllocTraversalFn>(callback));
   }
 
+  // See AllocationClass::getSparsestSlab
+  //
+  // @throw std::invalid_argument if the class id is invalid.
+  std::pair<const Slab*, uint32_t> getSparsestSlab(ClassId cid) {
+    return getAllocationClassFor(cid).getSparsestSlab();
+  }
+
   // returns the number of slabs currently advised away
   uint64_t getNumSlabsAdvised() const { return curSlabsAdvised_; }
 
@@ -324,6 +361,10 @@ class MemoryPool {
   // create allocation classes corresponding to the pool's configuration.
   ACVector createAllocationClasses() const;
 
+  // build the index from allocation sizes to classes for the current classes
+  // and make it visible to the allocating threads.
+  void publishSizeIndexLocked();
+
   // @return  AllocationClass corresponding to the memory, if it
   //          belongs to an AllocationClass
   //
@@ -386,14 +427,35 @@ class MemoryPool {
   // not currently in use.
   std::vector<Slab*> freeSlabs_;
 
-  // sorted vector of allocation class sizes
-  const std::vector<uint32_t> acSizes_;
+  // vector of allocation class sizes, indexed by class id. Changes under the
+  // mutex when classes are added.
+  std::vector<uint32_t> acSizes_;
+
+  // size of the per cpu magazines of the allocation classes
+  const uint32_t magazineSize_{0};
+
+  // vector of allocation classes for this pool, indexed by their class id.
+  // Classes are only ever appended, under the mutex, and capacity for
+  // kMaxClasses is reserved. So the classes below numClasses_ can be accessed
+  // without grabbing the mutex.
+  ACVector ac_;
+
+  // number of allocation classes visible to the readers of ac_.
+  std::atomic<unsigned int> numClasses_{0};
+
+  // the allocation sizes in increasing order and the id of the class of each
+  struct SizeIndex {
+    std::vector<uint32_t> sizes;
+    std::vector<ClassId> classIds;
+  };
+
+  // index used to find the class for an allocation size without the mutex.
+  // Adding classes publishes a new index.
+  std::atomic<const SizeIndex*> sizeIndex_{nullptr};
 
-  // vector of allocation classes for this pool, sorted by their allocation
-  // sizes and indexed by their class id. This vector does not change once it
-  // is initialized inside the constructor. so this can be accessed without
-  // grabbing the mutex.
-  const ACVector ac_;
+  // every index published so far. Allocating threads might still be using an
+  // older one, so they are only released with the pool.
+  std::vector<std::unique_ptr<const SizeIndex>> sizeIndexes_;
 
   // Current configuration of advised away Slabs in the pool
   std::atomic<uint64_t> curSlabsAdvised_{0};
@@ -409,7 +471,8 @@ class MemoryPool {
   static ACVector createMcFromSerialized(
       const serialization::MemoryPoolObject& object,
       PoolId poolId,
-      SlabAllocator& alloc);
+      SlabAllocator& alloc,
+      uint32_t magazineSize);
 
   // Allow access to private members by unit tests
   friend class facebook::cachelib::tests::AllocTestBase;
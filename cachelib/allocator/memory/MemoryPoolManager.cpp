@@ -25,13 +25,17 @@ using namespace facebook::cachelib;
 
 constexpr unsigned int MemoryPoolManager::kMaxPools;
 
-MemoryPoolManager::MemoryPoolManager(SlabAllocator& slabAlloc)
-    : slabAlloc_(slabAlloc) {}
+MemoryPoolManager::MemoryPoolManager(SlabAllocator& slabAlloc,
+                                     uint32_t magazineSize)
+    : slabAlloc_(slabAlloc), magazineSize_(magazineSize) {}
 
 MemoryPoolManager::MemoryPoolManager(
     const serialization::MemoryPoolManagerObject& object,
-    SlabAllocator& slabAlloc)
-    : nextPoolId_(*object.nextPoolId_ref()), slabAlloc_(slabAlloc) {
+    SlabAllocator& slabAlloc,
+    uint32_t magazineSize)
+    : nextPoolId_(*object.nextPoolId_ref()),
+      slabAlloc_(slabAlloc),
+      magazineSize_(magazineSize) {
   if (!slabAlloc_.isRestorable()) {
     throw std::logic_error(
         "Memory Pool Manager can not be restored,"
@@ -53,7 +57,8 @@ MemoryPoolManager::MemoryPoolManager(
   }
   size_t slabsAdvised = 0;
   for (size_t i = 0; i < object.pools_ref()->size(); ++i) {
-    pools_[i].reset(new MemoryPool(object.pools_ref()[i], slabAlloc_));
+    pools_[i].reset(
+        new MemoryPool(object.pools_ref()[i], slabAlloc_, magazineSize_));
     slabsAdvised += pools_[i]->getNumSlabsAdvised();
   }
   for (const auto& kv : *object.poolsByName_ref()) {
@@ -110,7 +115,8 @@ PoolId MemoryPoolManager::createNewPool(folly::StringPiece name,
   }
 
   const PoolId id = nextPoolId_;
-  pools_[id].reset(new MemoryPool(id, poolSize, slabAlloc_, allocSizes));
+  pools_[id].reset(
+      new MemoryPool(id, poolSize, slabAlloc_, allocSizes, magazineSize_));
   poolsByName_.insert({name.str(), id});
   nextPoolId_++;
   return id;
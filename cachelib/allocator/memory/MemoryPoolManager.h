@@ -48,17 +48,23 @@ class MemoryPoolManager {
   static constexpr unsigned int kMaxPools = 64;
 
   // creates a memory pool manager for this slabAllocator.
-  // @param slabAlloc  the slab allocator to be used for the memory pools.
-  explicit MemoryPoolManager(SlabAllocator& slabAlloc);
+  // @param slabAlloc     the slab allocator to be used for the memory pools.
+  // @param magazineSize  size of the per cpu magazines of the allocation
+  //                      classes. 0 disables them.
+  explicit MemoryPoolManager(SlabAllocator& slabAlloc,
+                             uint32_t magazineSize = 0);
 
   // creates a memory pool manager by restoring it from a serialized buffer.
   //
   // @param object    Object that contains the data to restore MemoryPoolManger
   // @param slabAlloc the slab allocator for fetching the header info.
+  // @param magazineSize  size of the per cpu magazines of the allocation
+  //                      classes. 0 disables them.
   //
   // @throw  std::logic_error if the slab allocator is not restorable.
   MemoryPoolManager(const serialization::MemoryPoolManagerObject& object,
-                    SlabAllocator& slabAlloc);
+                    SlabAllocator& slabAlloc,
+                    uint32_t magazineSize = 0);
 
   MemoryPoolManager(const MemoryPoolManager&) = delete;
   MemoryPoolManager& operator=(const MemoryPoolManager&) = delete;
@@ -223,6 +229,9 @@ class MemoryPoolManager {
   // slab allocator for the pools
   SlabAllocator& slabAlloc_;
 
+  // size of the per cpu magazines of the allocation classes
+  const uint32_t magazineSize_{0};
+
   // Number of slabs to advise away
   // This is target number of slabs to be advised across all pools.
   // This would be same as sum of current number of advised away slabs in
@@ -127,6 +127,7 @@ struct CACHELIB_PACKED_ATTR SlabHeader {
     poolId = Slab::kInvalidPoolId;
     classId = Slab::kInvalidClassId;
     allocSize = 0;
+    numFreeAllocs = 0;
   }
 
   bool isAdvised() const noexcept {
@@ -157,12 +158,16 @@ struct CACHELIB_PACKED_ATTR SlabHeader {
   uint8_t flags{0};
 
   // the allocation size of the allocation class. Useful for pointer
-  // compression. the current size of this struct is 1 + 1 + 1 + 4 = 7 bytes.
-  // This allocSize is accessed on every decompression of the
+  // compression. the current size of this struct is 1 + 1 + 1 + 4 + 4 = 11
+  // bytes. This allocSize is accessed on every decompression of the
   // compressed pointer. If the offset of this changes, use the benchmark to
   // figure out if it moves the needle by a big margin.
   uint32_t allocSize{0};
 
+  // number of allocations of this slab in the free list of its allocation
+  // class. Only accessed while holding the allocation class lock.
+  uint32_t numFreeAllocs{0};
+
  private:
   void setFlag(SlabHeaderFlag flag) noexcept {
     const uint8_t bitmask =
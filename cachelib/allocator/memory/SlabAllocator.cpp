@@ -86,8 +86,9 @@ void SlabAllocator::checkState() const {
 SlabAllocator::~SlabAllocator() {
   stopMemoryLocker();
 
-  if (ownsMemory_) {
-    munmap(memoryStart_, memorySize_);
+  if (ownsMemory_ && munmap(mapStart_, mapSize_) != 0) {
+    XLOGF(ERR, "Failed to unmap {} bytes at {}, errno = {}", mapSize_,
+          mapStart_, errno);
   }
 }
 
@@ -99,13 +100,24 @@ void SlabAllocator::stopMemoryLocker() {
 }
 
 SlabAllocator::SlabAllocator(size_t size, const Config& config)
-    : SlabAllocator(util::mmapAlignedZeroedMemory(sizeof(Slab), size),
+    : SlabAllocator(util::mmapAlignedZeroedMapping(sizeof(Slab),
+                                                   size,
+                                                   false /* noAccess */,
+                                                   config.hugePages,
+                                                   config.hugePageFallback),
                     size,
-                    true,
                     config) {
   XDCHECK(!isRestorable());
 }
 
+SlabAllocator::SlabAllocator(const util::AlignedMapping& mapping,
+                             size_t memorySize,
+                             const Config& config)
+    : SlabAllocator(mapping.memory, memorySize, true, config) {
+  mapStart_ = mapping.mapStart;
+  mapSize_ = mapping.mapSize;
+}
+
 SlabAllocator::SlabAllocator(void* memoryStart,
                              size_t memorySize,
                              const Config& config)
@@ -59,6 +59,14 @@ class SlabAllocator {
     // lock the pages in memory, forcing to allocate them and retaining them in
     // memory even when untouched.
     bool lockMemory{false};
+
+    // huge pages backing the memory when the slab allocator maps it itself.
+    // Has no effect on caller provided memory.
+    util::HugePagePolicy hugePages{util::HugePagePolicy::kNone};
+
+    // fall back to transparent huge pages if the hugetlb pool can not back
+    // the memory.
+    bool hugePageFallback{true};
   };
 
   // initialize the slab allocator for the range of memory starting from
@@ -79,6 +87,9 @@ class SlabAllocator {
   // on destruction. Instantiating through this means you cannot save the
   // state and restore the slab allocator since the memory is destroyed once
   // the object is destroyed.
+  //
+  // @throw std::system_error if the memory can not be mapped with the huge
+  //        pages of the config.
   SlabAllocator(size_t memorySize, const Config& config);
 
   // free up and unmap the mmaped memory if the allocator was created with
@@ -334,6 +345,12 @@ class SlabAllocator {
                 bool ownsMemory,
                 const Config& config);
 
+  // used by the constructor that maps its own memory. Remembers the whole
+  // mapping so that the destructor can unmap it.
+  SlabAllocator(const util::AlignedMapping& mapping,
+                size_t memorySize,
+                const Config& config);
+
   // intended for the constructor to ensure we are in a valid state after
   // constructing from a deserialized object.
   //
@@ -414,6 +431,11 @@ class SlabAllocator {
   // whether the memory this slab allocator manages is mmaped by the caller.
   const bool ownsMemory_{true};
 
+  // the mapping that backs the memory when we own it. This is larger than
+  // memorySize_ due to the alignment and the huge page size rounding.
+  void* mapStart_{nullptr};
+  size_t mapSize_{0};
+
   // thread that does back-ground job of paging in and locking the memory if
   // enabled.
   std::thread memoryLocker_;
@@ -18,8 +18,12 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <atomic>
+#include <map>
 #include <memory>
 #include <random>
+#include <set>
+#include <thread>
 #include <vector>
 
 #include "cachelib/allocator/memory/AllocationClass.h"
@@ -1125,6 +1129,258 @@ TEST_F(AllocationClassTest, Stats) {
   }
 }
 
+TEST_F(AllocationClassTest, Magazines) {
+  auto slabAlloc = createSlabAllocator(10);
+  const PoolId pid = 0;
+  const ClassId cid = 0;
+  const uint32_t allocSize = 1 << 10;
+  AllocationClass ac(cid, pid, allocSize, *slabAlloc, 64 /* magazineSize */);
+  ASSERT_EQ(64, ac.getMagazineCapacity());
+
+  // larger allocations get smaller magazines, slab sized ones none at all.
+  AllocationClass largeAc(cid, pid, 64 * 1024, *slabAlloc, 64);
+  ASSERT_EQ(4, largeAc.getMagazineCapacity());
+  AllocationClass hugeAc(cid, pid, Slab::kSize, *slabAlloc, 64);
+  ASSERT_EQ(0, hugeAc.getMagazineCapacity());
+
+  // two slabs, so that allocations held by the magazine of another cpu after
+  // a migration do not run us out of memory.
+  ac.addSlab(slabAlloc->makeNewSlab(pid));
+  ac.addSlab(slabAlloc->makeNewSlab(pid));
+  std::vector<void*> allocs;
+  for (unsigned int i = 0; i < ac.getAllocsPerSlab(); i++) {
+    auto alloc = ac.allocate();
+    ASSERT_NE(nullptr, alloc);
+    allocs.push_back(alloc);
+    // allocations held by the magazines count as free.
+    ASSERT_EQ(allocs.size(), ac.getStats().activeAllocs);
+  }
+
+  auto stat = ac.getStats();
+  ASSERT_EQ(allocs.size(), stat.magazineHits + stat.magazineRefills);
+  ASSERT_GT(stat.magazineHits, stat.magazineRefills);
+
+  for (size_t i = 0; i < allocs.size(); i++) {
+    ac.free(allocs[i]);
+    ASSERT_EQ(allocs.size() - i - 1, ac.getStats().activeAllocs);
+  }
+  stat = ac.getStats();
+  ASSERT_EQ(0, stat.activeAllocs);
+  ASSERT_GT(stat.magazineFlushes, 0);
+
+  // freed allocations are handed out again.
+  std::set<void*> allocated;
+  for (size_t i = 0; i < allocs.size(); i++) {
+    auto alloc = ac.allocate();
+    ASSERT_NE(nullptr, alloc);
+    ASSERT_TRUE(allocated.insert(alloc).second);
+  }
+}
+
+// allocations freed into the magazines must not be reported as active when
+// their slab is released.
+TEST_F(AllocationClassTest, MagazinesSlabRelease) {
+  auto slabAlloc = createSlabAllocator(10);
+  const PoolId pid = 0;
+  const ClassId cid = 0;
+  AllocationClass ac(cid, pid, 1 << 10, *slabAlloc, 64 /* magazineSize */);
+
+  auto slab = slabAlloc->makeNewSlab(pid);
+  ac.addSlab(slab);
+  std::vector<void*> allocs;
+  while (auto alloc = ac.allocate()) {
+    allocs.push_back(alloc);
+  }
+
+  // free every third alloc. Most of them stay in the magazines.
+  std::vector<void*> active;
+  for (size_t i = 0; i < allocs.size(); i++) {
+    if (i % 3 == 0) {
+      ac.free(allocs[i]);
+    } else {
+      active.push_back(allocs[i]);
+    }
+  }
+
+  auto ctx = ac.startSlabRelease(SlabReleaseMode::kResize, slab);
+  ASSERT_FALSE(ctx.isReleased());
+  const auto& releaseActive = ctx.getActiveAllocations();
+  ASSERT_EQ(active.size(), releaseActive.size());
+  ASSERT_TRUE(std::is_permutation(
+      releaseActive.begin(), releaseActive.end(), active.begin()));
+
+  // the allocs of the slab are not handed out again while it is released.
+  ASSERT_EQ(nullptr, ac.allocate());
+
+  for (auto alloc : releaseActive) {
+    ac.free(alloc);
+  }
+  ASSERT_NO_THROW(ac.completeSlabRelease(ctx));
+  ASSERT_EQ(0, ac.getStats().usedSlabs);
+}
+
+// frees racing with the release of their slab either go into the magazines
+// before the release drains them, or are recorded as freed for the release.
+TEST_F(AllocationClassTest, MagazinesSlabReleaseMultithread) {
+  auto slabAlloc = createSlabAllocator(10);
+  const PoolId pid = 0;
+  const ClassId cid = 0;
+  AllocationClass ac(cid, pid, 1 << 10, *slabAlloc, 64 /* magazineSize */);
+
+  auto releasedSlab = slabAlloc->makeNewSlab(pid);
+  ac.addSlab(releasedSlab);
+  std::vector<void*> releasedAllocs;
+  for (unsigned int i = 0; i < ac.getAllocsPerSlab(); i++) {
+    auto alloc = ac.allocate();
+    ASSERT_NE(nullptr, alloc);
+    ASSERT_TRUE(slabAlloc->isMemoryInSlab(alloc, releasedSlab));
+    releasedAllocs.push_back(alloc);
+  }
+
+  auto otherSlab = slabAlloc->makeNewSlab(pid);
+  ac.addSlab(otherSlab);
+  std::vector<void*> otherAllocs;
+  for (unsigned int i = 0; i < ac.getAllocsPerSlab(); i++) {
+    auto alloc = ac.allocate();
+    ASSERT_NE(nullptr, alloc);
+    ASSERT_TRUE(slabAlloc->isMemoryInSlab(alloc, otherSlab));
+    otherAllocs.push_back(alloc);
+  }
+
+  // each thread owns a slice of the allocs of both slabs. It frees half of
+  // its allocs of the other slab so that there is memory to churn through
+  // the magazines, and then frees all of its allocs of the released slab
+  // while allocating and freeing in between.
+  const unsigned int numThreads = 4;
+  const size_t perThread = releasedAllocs.size() / numThreads;
+  const size_t otherPerThread = otherAllocs.size() / numThreads;
+  std::atomic<bool> releaseStarted{false};
+  std::atomic<size_t> numFreed{0};
+  auto doFrees = [&](unsigned int t) {
+    for (size_t i = 0; i < otherPerThread / 2; i++) {
+      ac.free(otherAllocs[t * otherPerThread + i]);
+    }
+
+    std::vector<void*> held;
+    for (size_t i = 0; i < perThread; i++) {
+      ac.free(releasedAllocs[t * perThread + i]);
+      ++numFreed;
+
+      const bool started = releaseStarted;
+      auto alloc = ac.allocate();
+      if (alloc == nullptr) {
+        continue;
+      }
+      // once the release has started, its slab is not handed out again.
+      if (started) {
+        EXPECT_FALSE(slabAlloc->isMemoryInSlab(alloc, releasedSlab));
+      }
+      held.push_back(alloc);
+      if (held.size() == 16) {
+        for (auto h : held) {
+          ac.free(h);
+        }
+        held.clear();
+      }
+    }
+    for (auto h : held) {
+      ac.free(h);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < numThreads; t++) {
+    threads.emplace_back(doFrees, t);
+  }
+
+  // start the release while the threads are half way through their frees.
+  while (numFreed < releasedAllocs.size() / 2) {
+    std::this_thread::yield();
+  }
+  auto ctx = ac.startSlabRelease(SlabReleaseMode::kResize, releasedSlab);
+  releaseStarted = true;
+
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  // every active alloc reported by the release is freed by its thread.
+  if (!ctx.isReleased()) {
+    ASSERT_TRUE(ac.allFreed(releasedSlab));
+    ASSERT_NO_THROW(ac.completeSlabRelease(ctx));
+  }
+  const auto stats = ac.getStats();
+  ASSERT_EQ(1, stats.usedSlabs);
+  ASSERT_EQ(otherAllocs.size() - numThreads * (otherPerThread / 2),
+            stats.activeAllocs);
+}
+
+TEST_F(AllocationClassTest, SparsestSlab) {
+  auto slabAlloc = createSlabAllocator(10);
+  const PoolId pid = 0;
+  const ClassId cid = 0;
+  AllocationClass ac(cid, pid, 1 << 10, *slabAlloc);
+  ASSERT_EQ(nullptr, ac.getSparsestSlab().first);
+
+  for (int i = 0; i < 3; i++) {
+    ac.addSlab(slabAlloc->makeNewSlab(pid));
+  }
+  std::map<const Slab*, std::vector<void*>> allocsBySlab;
+  const Slab* currSlab = nullptr;
+  while (auto alloc = ac.allocate()) {
+    currSlab = slabAlloc->getSlabForMemory(alloc);
+    allocsBySlab[currSlab].push_back(alloc);
+  }
+  ASSERT_EQ(3, allocsBySlab.size());
+
+  // free 90% of the current slab and 10% and 60% of the other two.
+  const auto perSlab = ac.getAllocsPerSlab();
+  std::vector<const Slab*> others;
+  for (auto& [slab, allocs] : allocsBySlab) {
+    if (slab != currSlab) {
+      others.push_back(slab);
+    }
+  }
+  std::map<const Slab*, uint32_t> numToFree{{currSlab, perSlab * 9 / 10},
+                                            {others[0], perSlab / 10},
+                                            {others[1], perSlab * 6 / 10}};
+  uint32_t numFreed = 0;
+  for (auto& [slab, allocs] : allocsBySlab) {
+    for (uint32_t i = 0; i < numToFree[slab]; i++) {
+      ac.free(allocs.back());
+      allocs.pop_back();
+      numFreed++;
+    }
+  }
+
+  // the current slab is not picked even though it has the most free allocs.
+  auto sparsest = ac.getSparsestSlab();
+  ASSERT_EQ(others[1], sparsest.first);
+  ASSERT_EQ(numToFree[others[1]], sparsest.second);
+
+  // the free allocations are all still there to be handed out.
+  ASSERT_EQ(numFreed, ac.getStats().freeAllocs);
+
+  // a slab being released is not picked either.
+  auto ctx = ac.startSlabRelease(SlabReleaseMode::kRebalance,
+                                 others[1]->memoryAtOffset(0));
+  sparsest = ac.getSparsestSlab();
+  ASSERT_EQ(others[0], sparsest.first);
+  ASSERT_EQ(numToFree[others[0]], sparsest.second);
+
+  for (auto alloc : ctx.getActiveAllocations()) {
+    ac.free(alloc);
+  }
+  ASSERT_NO_THROW(ac.completeSlabRelease(ctx));
+
+  // a free slab of the class goes first.
+  auto freeSlab = slabAlloc->makeNewSlab(pid);
+  ac.addSlab(freeSlab);
+  sparsest = ac.getSparsestSlab();
+  ASSERT_EQ(freeSlab, sparsest.first);
+  ASSERT_EQ(perSlab, sparsest.second);
+}
+
 // Test alloc processing during slab release
 TEST_F(AllocationClassTest, ProcessAllocForRelease) {
   auto slabAlloc = createSlabAllocator(1);
@@ -517,6 +517,57 @@ TEST_F(MemoryPoolTest, Serialization) {
   }
 }
 
+TEST_F(MemoryPoolTest, AddAllocationClasses) {
+  auto slabAlloc = createSlabAllocator(20);
+  auto usable = slabAlloc->getNumUsableSlabs();
+  size_t poolSize = usable * Slab::kSize;
+
+  PoolId id = 5;
+  MemoryPool mp(id, poolSize, *slabAlloc, {128, 1024, 8192});
+  ASSERT_EQ(1, mp.getAllocationClassId(300));
+
+  // sizes the pool already has are skipped and the new ones get the next
+  // class ids in increasing order of their sizes.
+  const auto cids = mp.addAllocationClasses({128, 512, 16384});
+  ASSERT_EQ((std::vector<ClassId>{3, 4}), cids);
+  ASSERT_EQ(5, mp.getNumClassId());
+  ASSERT_EQ((std::vector<uint32_t>{128, 1024, 8192, 512, 16384}),
+            mp.getAllocSizes());
+
+  // sizes go to the smallest class that fits them, old or new.
+  ASSERT_EQ(0, mp.getAllocationClassId(100));
+  ASSERT_EQ(3, mp.getAllocationClassId(300));
+  ASSERT_EQ(1, mp.getAllocationClassId(600));
+  ASSERT_EQ(2, mp.getAllocationClassId(5000));
+  ASSERT_EQ(4, mp.getAllocationClassId(10000));
+  ASSERT_THROW(mp.getAllocationClassId(20000), std::invalid_argument);
+
+  void* memory = mp.allocate(300);
+  ASSERT_NE(nullptr, memory);
+  ASSERT_EQ(3, mp.getAllocationClassId(memory));
+  ASSERT_EQ(512, mp.getAllocationClass(3).getAllocSize());
+
+  ASSERT_TRUE(mp.addAllocationClasses({512}).empty());
+  ASSERT_THROW(mp.addAllocationClasses({Slab::kMinAllocSize - 1}),
+               std::invalid_argument);
+  ASSERT_THROW(mp.addAllocationClasses({Slab::kSize + 1}),
+               std::invalid_argument);
+
+  // the classes added to the pool survive a restore.
+  uint8_t buffer[SerializationBufferSize];
+  uint8_t* begin = buffer;
+  uint8_t* end = buffer + SerializationBufferSize;
+  Serializer serializer(begin, end);
+  serializer.serialize(mp.saveState());
+  Deserializer deserializer(begin, end);
+  MemoryPool mp2(deserializer.deserialize<serialization::MemoryPoolObject>(),
+                 *slabAlloc);
+  ASSERT_TRUE(isSameMemoryPool(mp, mp2));
+  ASSERT_EQ(3, mp2.getAllocationClassId(300));
+  ASSERT_EQ(4, mp2.getAllocationClassId(10000));
+  mp2.free(memory);
+}
+
 TEST_F(MemoryPoolTest, InvalidDeSerialization) {
   auto slabAlloc = createSlabAllocator(20);
   auto usable = slabAlloc->getNumUsableSlabs();
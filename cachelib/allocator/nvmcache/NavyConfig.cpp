@@ -227,6 +227,24 @@ void NavyConfig::setBigHash(unsigned int bigHashSizePct,
       .setBucketSize(bigHashBucketSize)
       .setBucketBfSize(bigHashBucketBfSize);
 }
+
+// Kangaroo settings
+KangarooConfig& KangarooConfig::setSizePctAndMaxItemSize(
+    unsigned int sizePct, uint64_t smallItemMaxSize) {
+  if (sizePct > 100) {
+    throw std::invalid_argument(folly::sformat(
+        "to enable Kangaroo, Kangaroo size pct should be in the range of "
+        "[0, 100], but {} is set",
+        sizePct));
+  }
+  if (sizePct == 0) {
+    XLOG(INFO) << "Kangaroo is not configured";
+  }
+  sizePct_ = sizePct;
+  smallItemMaxSize_ = smallItemMaxSize;
+  return *this;
+}
+
 // job scheduler settings
 void NavyConfig::setNavyReqOrderingShards(uint64_t navyReqOrderingShards) {
   if (navyReqOrderingShards == 0) {
@@ -266,6 +284,9 @@ std::map<std::string, std::string> NavyConfig::serialize() const {
   configMap["navyConfig::truncateFile"] = truncateFile_ ? "true" : "false";
   configMap["navyConfig::deviceMaxWriteSize"] =
       folly::to<std::string>(deviceMaxWriteSize_);
+  configMap["navyConfig::ioUringQueueDepth"] =
+      folly::to<std::string>(ioUringQueueDepth_);
+  configMap["navyConfig::ioUringSqPoll"] = ioUringSqPoll_ ? "true" : "false";
 
   // BlockCache settings
   configMap["navyConfig::blockCacheLru"] =
@@ -286,6 +307,8 @@ std::map<std::string, std::string> NavyConfig::serialize() const {
       folly::to<std::string>(blockCacheConfig_.getNumInMemBuffers());
   configMap["navyConfig::blockCacheDataChecksum"] =
       blockCacheConfig_.getDataChecksum() ? "true" : "false";
+  configMap["navyConfig::blockCacheFixedSizeIndexNumEntries"] =
+      folly::to<std::string>(blockCacheConfig_.getFixedSizeIndexNumEntries());
   configMap["navyConfig::blockCacheSegmentedFifoSegmentRatio"] =
       folly::join(",", blockCacheConfig_.getSFifoSegmentRatio());
 
@@ -298,6 +321,26 @@ std::map<std::string, std::string> NavyConfig::serialize() const {
       folly::to<std::string>(bigHashConfig_.getBucketBfSize());
   configMap["navyConfig::bigHashSmallItemMaxSize"] =
       folly::to<std::string>(bigHashConfig_.getSmallItemMaxSize());
+  configMap["navyConfig::bigHashBucketCacheSize"] =
+      folly::to<std::string>(bigHashConfig_.getBucketCacheSize());
+
+  // Kangaroo settings
+  configMap["navyConfig::kangarooSizePct"] =
+      folly::to<std::string>(kangarooConfig_.getSizePct());
+  configMap["navyConfig::kangarooBucketSize"] =
+      folly::to<std::string>(kangarooConfig_.getBucketSize());
+  configMap["navyConfig::kangarooBucketBfSize"] =
+      folly::to<std::string>(kangarooConfig_.getBucketBfSize());
+  configMap["navyConfig::kangarooSmallItemMaxSize"] =
+      folly::to<std::string>(kangarooConfig_.getSmallItemMaxSize());
+  configMap["navyConfig::kangarooLogSizePct"] =
+      folly::to<std::string>(kangarooConfig_.getLogSizePct());
+  configMap["navyConfig::kangarooNumLogPartitions"] =
+      folly::to<std::string>(kangarooConfig_.getNumLogPartitions());
+  configMap["navyConfig::kangarooLogSegmentPages"] =
+      folly::to<std::string>(kangarooConfig_.getLogSegmentPages());
+  configMap["navyConfig::kangarooSetAdmissionThreshold"] =
+      folly::to<std::string>(kangarooConfig_.getSetAdmissionThreshold());
 
   // Job scheduler settings
   configMap["navyConfig::readerThreads"] =
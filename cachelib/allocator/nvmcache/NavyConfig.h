@@ -300,6 +300,16 @@ class BlockCacheConfig {
     return *this;
   }
 
+  // Use an index with room for a fixed number of items instead of one that
+  // grows with the number of items. It takes less than 11 bytes of DRAM per
+  // entry. Items spread unevenly over its buckets, and a new item whose
+  // bucket is full replaces the item with the fewest hits, so
+  // @numEntries should be larger than the expected number of items.
+  BlockCacheConfig& useFixedSizeIndex(uint64_t numEntries) noexcept {
+    fixedSizeIndexNumEntries_ = numEntries;
+    return *this;
+  }
+
   bool isLruEnabled() const { return lru_; }
 
   const std::vector<unsigned int>& getSFifoSegmentRatio() const {
@@ -316,6 +326,10 @@ class BlockCacheConfig {
 
   bool getDataChecksum() const { return dataChecksum_; }
 
+  uint64_t getFixedSizeIndexNumEntries() const {
+    return fixedSizeIndexNumEntries_;
+  }
+
   const BlockCacheReinsertionConfig& getReinsertionConfig() const {
     return reinsertionConfig_;
   }
@@ -340,6 +354,8 @@ class BlockCacheConfig {
   uint32_t regionSize_{16 * 1024 * 1024};
   // Whether enabling data checksum for Navy BlockCache.
   bool dataChecksum_{true};
+  // Number of entries of the fixed size index. 0 to use the default index.
+  uint64_t fixedSizeIndexNumEntries_{0};
 
   friend class NavyConfig;
 };
@@ -379,6 +395,16 @@ class BigHashConfig {
     return *this;
   }
 
+  // Set how many bytes of DRAM to cache written buckets in. Inserts and
+  // removes to a cached bucket are coalesced into one bucket write when the
+  // bucket is evicted from this cache or the cache is flushed or persisted.
+  // Changes not written yet are lost on a crash. 0 means every change is
+  // written right away. Default value is 0.
+  BigHashConfig& setBucketCacheSize(uint64_t bucketCacheSize) noexcept {
+    bucketCacheSize_ = bucketCacheSize;
+    return *this;
+  }
+
   bool isBloomFilterEnabled() const { return bucketBfSize_ > 0; }
 
   unsigned int getSizePct() const { return sizePct_; }
@@ -389,6 +415,8 @@ class BigHashConfig {
 
   uint64_t getSmallItemMaxSize() const { return smallItemMaxSize_; }
 
+  uint64_t getBucketCacheSize() const { return bucketCacheSize_; }
+
  private:
   // Percentage of how much of the device out of all is given to BigHash
   // engine in Navy, e.g. 50.
@@ -402,6 +430,118 @@ class BigHashConfig {
   uint64_t bucketBfSize_{8};
   // The maximum item size to put into Navy BigHash engine.
   uint64_t smallItemMaxSize_{};
+  // Bytes of DRAM to cache written buckets in. 0 disables the bucket cache.
+  uint64_t bucketCacheSize_{0};
+};
+
+/**
+ * KangarooConfig provides APIs for users to configure Kangaroo engine, which
+ * is one part of NavyConfig. Kangaroo caches small items like BigHash, and
+ * can be used instead of it. It stores them in buckets too, called sets, but
+ * appends inserts to a log first and moves them to the sets in batches, which
+ * writes less to the device.
+ *
+ * By this class, users can:
+ * - enable Kangaroo by setting sizePct > 0
+ * - set maximum item size
+ * - set bucket size
+ * - set bloom filter size (0 to disable bloom filter)
+ * - set the log size, partitions and segment size
+ * - set the set admission threshold
+ * - get the values of all the above parameters
+ */
+class KangarooConfig {
+ public:
+  // Set Kangaroo device percentage and maximum item size(in bytes) to enable
+  // Kangaroo engine. Default value of sizePct and smallItemMaxSize is 0,
+  // meaning Kangaroo is not enabled.
+  // @throw std::invalid_argument if sizePct is not in the range of
+  //        [0, 100].
+  KangarooConfig& setSizePctAndMaxItemSize(unsigned int sizePct,
+                                           uint64_t smallItemMaxSize);
+
+  // Set the size in bytes of a set and of a log page for Kangaroo engine.
+  // Default value is 4096.
+  KangarooConfig& setBucketSize(uint32_t bucketSize) noexcept {
+    bucketSize_ = bucketSize;
+    return *this;
+  }
+
+  // Set bloom filter size per set in bytes for Kangaroo engine.
+  // 0 means bloom filter will not be applied. Default value is 8.
+  KangarooConfig& setBucketBfSize(uint64_t bucketBfSize) noexcept {
+    bucketBfSize_ = bucketBfSize;
+    return *this;
+  }
+
+  // Set the percentage of the Kangaroo space used for the log.
+  // Default value is 5.
+  KangarooConfig& setLogSizePct(unsigned int logSizePct) noexcept {
+    logSizePct_ = logSizePct;
+    return *this;
+  }
+
+  // Set the number of partitions of the log. Inserts to different
+  // partitions run in parallel. Default value is 16.
+  KangarooConfig& setNumLogPartitions(uint32_t numLogPartitions) noexcept {
+    numLogPartitions_ = numLogPartitions;
+    return *this;
+  }
+
+  // Set how many pages of a log partition are moved to the sets at once.
+  // A move reads and writes up to a set per item of these pages. It doesn't
+  // block the lookups and inserts of the partition, but the removes of the
+  // partition wait for it. Default value is 4.
+  KangarooConfig& setLogSegmentPages(uint32_t logSegmentPages) noexcept {
+    logSegmentPages_ = logSegmentPages;
+    return *this;
+  }
+
+  // Set the minimum number of items of a set in the log to move them to
+  // the set. Fewer items are dropped instead. Default value is 1, which
+  // moves all items.
+  KangarooConfig& setSetAdmissionThreshold(uint32_t threshold) noexcept {
+    setAdmissionThreshold_ = threshold;
+    return *this;
+  }
+
+  bool isBloomFilterEnabled() const { return bucketBfSize_ > 0; }
+
+  unsigned int getSizePct() const { return sizePct_; }
+
+  uint32_t getBucketSize() const { return bucketSize_; }
+
+  uint64_t getBucketBfSize() const { return bucketBfSize_; }
+
+  uint64_t getSmallItemMaxSize() const { return smallItemMaxSize_; }
+
+  unsigned int getLogSizePct() const { return logSizePct_; }
+
+  uint32_t getNumLogPartitions() const { return numLogPartitions_; }
+
+  uint32_t getLogSegmentPages() const { return logSegmentPages_; }
+
+  uint32_t getSetAdmissionThreshold() const { return setAdmissionThreshold_; }
+
+ private:
+  // Percentage of how much of the device out of all is given to Kangaroo
+  // engine in Navy, e.g. 50.
+  unsigned int sizePct_{0};
+  // Size of a set and of a log page (must be multiple of the minimum device
+  // io block size).
+  uint32_t bucketSize_{4096};
+  // The bloom filter size per set in bytes
+  uint64_t bucketBfSize_{8};
+  // The maximum item size to put into Navy Kangaroo engine.
+  uint64_t smallItemMaxSize_{};
+  // Percentage of the Kangaroo space used for the log.
+  unsigned int logSizePct_{5};
+  // Number of partitions of the log.
+  uint32_t numLogPartitions_{16};
+  // Number of pages of a partition moved to the sets at once.
+  uint32_t logSegmentPages_{4};
+  // Minimum number of items of a set in the log to move them to the set.
+  uint32_t setAdmissionThreshold_{1};
 };
 
 /**
@@ -424,6 +564,7 @@ class NavyConfig {
   bool usesSimpleFile() const noexcept { return !fileName_.empty(); }
   bool usesRaidFiles() const noexcept { return raidPaths_.size() > 0; }
   bool isBigHashEnabled() const { return bigHashConfig_.getSizePct() > 0; }
+  bool isKangarooEnabled() const { return kangarooConfig_.getSizePct() > 0; }
   std::map<std::string, std::string> serialize() const;
 
   // Getters:
@@ -446,6 +587,8 @@ class NavyConfig {
   uint64_t getFileSize() const { return fileSize_; }
   bool getTruncateFile() const { return truncateFile_; }
   uint32_t getDeviceMaxWriteSize() const { return deviceMaxWriteSize_; }
+  uint32_t getIoUringQueueDepth() const { return ioUringQueueDepth_; }
+  bool getIoUringSqPoll() const { return ioUringSqPoll_; }
   uint32_t getRaidStripeSize() const {
     return blockCacheConfig_.getRegionSize();
   }
@@ -454,6 +597,9 @@ class NavyConfig {
   // Returns the threshold of classifying an item as small item or large item
   // for Navy engine.
   uint64_t getSmallItemThreshold() const {
+    if (isKangarooEnabled()) {
+      return kangarooConfig_.getSmallItemMaxSize();
+    }
     if (!isBigHashEnabled()) {
       return 0;
     }
@@ -463,6 +609,9 @@ class NavyConfig {
   // Return a const BlockCacheConfig to read values of its parameters.
   const BigHashConfig& bigHash() const { return bigHashConfig_; }
 
+  // Return a const KangarooConfig to read values of its parameters.
+  const KangarooConfig& kangaroo() const { return kangarooConfig_; }
+
   // Return a const BlockCacheConfig to read values of its parameters.
   const BlockCacheConfig& blockCache() const { return blockCacheConfig_; }
 
@@ -534,6 +683,14 @@ class NavyConfig {
   void setDeviceMaxWriteSize(uint32_t deviceMaxWriteSize) noexcept {
     deviceMaxWriteSize_ = deviceMaxWriteSize;
   }
+  // Do the IO of the simple or RAID files through io_uring, with up to
+  // queueDepth IOs in flight. With sqPoll, a kernel thread polls for new IOs
+  // so that they are submitted without a system call.
+  // 0 means synchronous IO from the reader and writer threads.
+  void setIoUring(uint32_t queueDepth, bool sqPoll = false) noexcept {
+    ioUringQueueDepth_ = queueDepth;
+    ioUringSqPoll_ = sqPoll;
+  }
 
   // ============ BlockCache settings =============
   // Set whether LRU policy will be used.
@@ -593,6 +750,11 @@ class NavyConfig {
   // Return BigHashConfig for configuration.
   BigHashConfig& bigHash() noexcept { return bigHashConfig_; }
 
+  // ============ Kangaroo settings =============
+  // Return KangarooConfig for configuration. Kangaroo can't be enabled
+  // along with BigHash.
+  KangarooConfig& kangaroo() noexcept { return kangarooConfig_; }
+
   // ============ Job scheduler settings =============
   void setReaderAndWriterThreads(unsigned int readerThreads,
                                  unsigned int writerThreads) noexcept {
@@ -636,6 +798,11 @@ class NavyConfig {
   // This controls granularity of the writes when we flush the region.
   // This is only used when in-mem buffer is enabled.
   uint32_t deviceMaxWriteSize_{};
+  // Max number of IOs in flight through io_uring. 0 means to not use
+  // io_uring.
+  uint32_t ioUringQueueDepth_{};
+  // Whether io_uring uses a kernel thread to poll for submissions.
+  bool ioUringSqPoll_{false};
 
   // ============ BlockCache settings =============
   BlockCacheConfig blockCacheConfig_{};
@@ -643,6 +810,9 @@ class NavyConfig {
   // ============ BigHash settings =============
   BigHashConfig bigHashConfig_{};
 
+  // ============ Kangaroo settings =============
+  KangarooConfig kangarooConfig_{};
+
   // ============ Job scheduler settings =============
   // Number of asynchronous worker thread for read operation.
   unsigned int readerThreads_{32};
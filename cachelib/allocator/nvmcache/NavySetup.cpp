@@ -81,6 +81,10 @@ uint64_t setupBigHash(const navy::BigHashConfig& bigHashConfig,
     bigHash->setBloomFilter(kNumHashes, bitsPerHash);
   }
 
+  if (bigHashConfig.getBucketCacheSize() > 0) {
+    bigHash->setBucketCache(bigHashConfig.getBucketCacheSize());
+  }
+
   proto.setBigHash(std::move(bigHash), bigHashConfig.getSmallItemMaxSize());
 
   if (bigHashCacheOffset <= metadataSize) {
@@ -92,6 +96,55 @@ uint64_t setupBigHash(const navy::BigHashConfig& bigHashConfig,
   return bigHashCacheOffset;
 }
 
+uint64_t setupKangaroo(const navy::KangarooConfig& kangarooConfig,
+                       uint32_t ioAlignSize,
+                       uint64_t totalCacheSize,
+                       uint64_t metadataSize,
+                       cachelib::navy::CacheProto& proto) {
+  auto bucketSize = kangarooConfig.getBucketSize();
+  if (bucketSize != alignUp(bucketSize, ioAlignSize)) {
+    throw std::invalid_argument(
+        folly::sformat("Bucket size: {} is not aligned to ioAlignSize: {}",
+                       bucketSize, ioAlignSize));
+  }
+
+  // Like BigHash, Kangaroo's storage starts after BlockCache's.
+  const auto sizeReservedForKangaroo =
+      totalCacheSize * kangarooConfig.getSizePct() / 100ul;
+
+  const uint64_t kangarooCacheOffset =
+      alignUp(totalCacheSize - sizeReservedForKangaroo, bucketSize);
+  const uint64_t kangarooCacheSize =
+      alignDown(totalCacheSize - kangarooCacheOffset, bucketSize);
+
+  auto kangaroo = cachelib::navy::createKangarooProto();
+  kangaroo->setLayout(kangarooCacheOffset, kangarooCacheSize, bucketSize);
+  kangaroo->setLog(kangarooConfig.getLogSizePct(),
+                   kangarooConfig.getNumLogPartitions(),
+                   kangarooConfig.getLogSegmentPages());
+  kangaroo->setSetAdmissionThreshold(
+      kangarooConfig.getSetAdmissionThreshold());
+
+  // Same bloom filter setup as BigHash, one filter per set
+  if (kangarooConfig.isBloomFilterEnabled()) {
+    constexpr uint32_t kNumHashes = 4;
+    const uint32_t bitsPerHash =
+        kangarooConfig.getBucketBfSize() * 8 / kNumHashes;
+    kangaroo->setBloomFilter(kNumHashes, bitsPerHash);
+  }
+
+  proto.setKangaroo(std::move(kangaroo),
+                    kangarooConfig.getSmallItemMaxSize());
+
+  if (kangarooCacheOffset <= metadataSize) {
+    throw std::invalid_argument("NVM cache size is not big enough!");
+  }
+  XLOG(INFO) << "metadataSize: " << metadataSize
+             << " kangarooCacheOffset: " << kangarooCacheOffset
+             << " kangarooCacheSize: " << kangarooCacheSize;
+  return kangarooCacheOffset;
+}
+
 void setupBlockCache(const navy::BlockCacheConfig& blockCacheConfig,
                      uint64_t blockCacheSize,
                      uint32_t ioAlignSize,
@@ -145,13 +198,17 @@ void setupBlockCache(const navy::BlockCacheConfig& blockCacheConfig,
 
   blockCache->setNumInMemBuffers(blockCacheConfig.getNumInMemBuffers());
   blockCache->setItemDestructorEnabled(itemDestructorEnabled);
+  if (blockCacheConfig.getFixedSizeIndexNumEntries() > 0) {
+    blockCache->setFixedSizeIndex(
+        blockCacheConfig.getFixedSizeIndexNumEntries());
+  }
 
   proto.setBlockCache(std::move(blockCache));
 }
 
-// Setup the CacheProto, includes BigHashProto and BlockCacheProto,
-// which is the configuration interface from Navy engine, and can be used to
-// create BigHash and BlockCache engines.
+// Setup the CacheProto, includes BigHashProto or KangarooProto and
+// BlockCacheProto, which is the configuration interface from Navy engine, and
+// can be used to create BigHash or Kangaroo and BlockCache engines.
 //
 // @param config            the configured NavyConfig
 // @param device            the flash device
@@ -186,11 +243,20 @@ void setupCacheProtos(const navy::NavyConfig& config,
 
   uint64_t blockCacheSize = 0;
 
-  // Set up BigHash if enabled
+  if (config.isBigHashEnabled() && config.isKangarooEnabled()) {
+    throw std::invalid_argument("BigHash and Kangaroo can't both be enabled");
+  }
+
+  // Set up BigHash or Kangaroo if enabled
   if (config.isBigHashEnabled()) {
     auto bigHashCacheOffset = setupBigHash(config.bigHash(), ioAlignSize,
                                            totalCacheSize, metadataSize, proto);
     blockCacheSize = bigHashCacheOffset - metadataSize;
+  } else if (config.isKangarooEnabled()) {
+    auto kangarooCacheOffset =
+        setupKangaroo(config.kangaroo(), ioAlignSize, totalCacheSize,
+                      metadataSize, proto);
+    blockCacheSize = kangarooCacheOffset - metadataSize;
   } else {
     XLOG(INFO) << "metadataSize: " << metadataSize << ". No bighash.";
     blockCacheSize = totalCacheSize - metadataSize;
@@ -235,6 +301,9 @@ std::unique_ptr<cachelib::navy::Device> createDevice(
     std::shared_ptr<navy::DeviceEncryptor> encryptor) {
   auto blockSize = config.getBlockSize();
   auto maxDeviceWriteSize = config.getDeviceMaxWriteSize();
+  navy::IoUringOptions ioUringOptions;
+  ioUringOptions.queueDepth = config.getIoUringQueueDepth();
+  ioUringOptions.sqPoll = config.getIoUringSqPoll();
 
   if (config.usesRaidFiles()) {
     auto stripeSize = config.getRaidStripeSize();
@@ -245,7 +314,8 @@ std::unique_ptr<cachelib::navy::Device> createDevice(
         blockSize,
         stripeSize,
         std::move(encryptor),
-        maxDeviceWriteSize > 0 ? alignDown(maxDeviceWriteSize, blockSize) : 0);
+        maxDeviceWriteSize > 0 ? alignDown(maxDeviceWriteSize, blockSize) : 0,
+        ioUringOptions);
   } else if (config.usesSimpleFile()) {
     return cachelib::navy::createFileDevice(
         config.getFileName(),
@@ -253,7 +323,8 @@ std::unique_ptr<cachelib::navy::Device> createDevice(
         config.getTruncateFile(),
         blockSize,
         std::move(encryptor),
-        maxDeviceWriteSize > 0 ? alignDown(maxDeviceWriteSize, blockSize) : 0);
+        maxDeviceWriteSize > 0 ? alignDown(maxDeviceWriteSize, blockSize) : 0,
+        ioUringOptions);
   } else {
     return cachelib::navy::createMemoryDevice(config.getFileSize(),
                                               std::move(encryptor), blockSize);
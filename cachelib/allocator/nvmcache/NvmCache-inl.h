@@ -27,6 +27,12 @@ std::map<std::string, std::string> NvmCache<C>::Config::serialize() const {
   configMap["encryption"] = deviceEncryptor ? "set" : "empty";
   configMap["truncateItemToOriginalAllocSizeInNvm"] =
       truncateItemToOriginalAllocSizeInNvm ? "true" : "false";
+  if (!compression) {
+    configMap["compression"] = "none";
+  } else {
+    configMap["compression"] =
+        compression->codec == ValueCompressor::Codec::kZstd ? "zstd" : "lz4";
+  }
   return configMap;
 }
 
@@ -39,6 +45,18 @@ typename NvmCache<C>::Config NvmCache<C>::Config::validateAndSetDefaults() {
         "Encode and Decode CBs must be both specified or both empty.");
   }
 
+  if (compression) {
+    compression->validate();
+    const auto smallItemThreshold = navyConfig.getSmallItemThreshold();
+    if (compression->minSize > smallItemThreshold && smallItemThreshold > 0) {
+      XLOGF(WARN,
+            "NvmCache compression minSize {} is larger than the small item "
+            "threshold {}. Items in the small item engine are never "
+            "compressed.",
+            compression->minSize, smallItemThreshold);
+    }
+  }
+
   if (deviceEncryptor) {
     auto encryptionBlockSize = deviceEncryptor->encryptionBlockSize();
     auto blockSize = navyConfig.getBlockSize();
@@ -63,6 +81,19 @@ typename NvmCache<C>::Config NvmCache<C>::Config::validateAndSetDefaults() {
                            bucketSize));
       }
     }
+
+    if (navyConfig.isKangarooEnabled()) {
+      auto bucketSize = navyConfig.kangaroo().getBucketSize();
+      if (bucketSize % encryptionBlockSize != 0) {
+        throw std::invalid_argument(
+            folly::sformat("Encryption enabled but the encryption block "
+                           "granularity is not aligned to the navy "
+                           "kangaroo bucket size. ecryption block "
+                           "size: {}, bucket size: {}",
+                           encryptionBlockSize,
+                           bucketSize));
+      }
+    }
   }
 
   return *this;
@@ -377,6 +408,9 @@ NvmCache<C>::NvmCache(C& c,
                       const ItemDestructor& itemDestructor)
     : config_(config.validateAndSetDefaults()),
       cache_(c),
+      compressor_(config_.compression
+                      ? std::make_unique<ValueCompressor>(*config_.compression)
+                      : nullptr),
       itemDestructor_(itemDestructor) {
   navyCache_ = createNavyCache(
       config_.navyConfig,
@@ -422,6 +456,18 @@ std::unique_ptr<NvmItem> NvmCache<C>::makeNvmItem(const ItemHandle& hdl) {
     return nullptr;
   }
 
+  // values compressed in ram would not compress again
+  if (compressor_ && !item.isValueCompressed()) {
+    std::vector<Blob> blobs;
+    blobs.push_back(makeBlob(item));
+    for (auto& chainedItem : chainedItemRange) {
+      blobs.push_back(makeBlob(chainedItem));
+    }
+    if (auto nvmItem = makeCompressedNvmItem(item, poolId, blobs)) {
+      return nvmItem;
+    }
+  }
+
   if (item.hasChainedItem()) {
     std::vector<Blob> blobs;
     blobs.push_back(makeBlob(item));
@@ -436,9 +482,89 @@ std::unique_ptr<NvmItem> NvmCache<C>::makeNvmItem(const ItemHandle& hdl) {
   } else {
     Blob blob = makeBlob(item);
     const size_t bufSize = NvmItem::estimateVariableSize(blob);
-    return std::unique_ptr<NvmItem>(new (bufSize) NvmItem(
+    auto nvmItem = std::unique_ptr<NvmItem>(new (bufSize) NvmItem(
         poolId, item.getCreationTime(), item.getExpiryTime(), blob));
+    if (item.isValueCompressed()) {
+      nvmItem->markValueCompressed();
+    }
+    return nvmItem;
+  }
+}
+
+template <typename C>
+std::unique_ptr<NvmItem> NvmCache<C>::makeCompressedNvmItem(
+    const Item& item, PoolId poolId, const std::vector<Blob>& blobs) {
+  XDCHECK(compressor_);
+  bool compressedAny = false;
+  std::vector<std::unique_ptr<folly::IOBuf>> bufs;
+  std::vector<Blob> compressedBlobs;
+  bufs.reserve(blobs.size());
+  compressedBlobs.reserve(blobs.size());
+  for (const auto& blob : blobs) {
+    auto compressed = compressor_->compress(folly::ByteRange(blob.data));
+    const auto data =
+        compressed ? compressed->coalesce() : folly::ByteRange(blob.data);
+    auto buf = folly::IOBuf::create(data.size() + 1);
+    buf->writableData()[0] =
+        compressed ? NvmItem::kBlobCompressed : NvmItem::kBlobRaw;
+    std::memcpy(buf->writableData() + 1, data.data(), data.size());
+    buf->append(data.size() + 1);
+
+    compressedAny |= compressed != nullptr;
+    compressedBlobs.push_back(Blob{
+        blob.origAllocSize,
+        {reinterpret_cast<const char*>(buf->data()), buf->length()}});
+    bufs.push_back(std::move(buf));
+  }
+  if (!compressedAny) {
+    return nullptr;
   }
+  numCompressedItems_.inc();
+
+  const size_t bufSize = NvmItem::estimateVariableSize(compressedBlobs);
+  auto nvmItem = std::unique_ptr<NvmItem>(new (bufSize) NvmItem(
+      poolId, item.getCreationTime(), item.getExpiryTime(), compressedBlobs));
+  nvmItem->markBlobsCompressed();
+  return nvmItem;
+}
+
+template <typename C>
+std::unique_ptr<NvmItem> NvmCache<C>::uncompressNvmItem(
+    const NvmItem& nvmItem) {
+  XDCHECK(nvmItem.areBlobsCompressed());
+  if (!compressor_) {
+    throw std::invalid_argument(
+        "Item was compressed, but nvmcache compression is not enabled");
+  }
+  std::vector<std::unique_ptr<folly::IOBuf>> bufs;
+  std::vector<Blob> blobs;
+  for (size_t i = 0; i < nvmItem.getNumBlobs(); i++) {
+    auto blob = nvmItem.getBlob(i);
+    if (blob.data.empty()) {
+      throw std::invalid_argument(
+          folly::sformat("Empty compressed blob at index {}", i));
+    }
+    const auto marker = static_cast<uint8_t>(blob.data.front());
+    blob.data.advance(1);
+    if (marker == NvmItem::kBlobCompressed) {
+      bufs.push_back(compressor_->uncompress(folly::ByteRange(blob.data)));
+      blob.data = folly::StringPiece(bufs.back()->coalesce());
+    } else if (marker != NvmItem::kBlobRaw) {
+      throw std::invalid_argument(folly::sformat(
+          "Invalid compressed blob marker {} at index {}", marker, i));
+    }
+    blobs.push_back(blob);
+  }
+
+  const size_t bufSize = NvmItem::estimateVariableSize(blobs);
+  auto uncompressed = std::unique_ptr<NvmItem>(
+      new (bufSize) NvmItem(nvmItem.poolId(), nvmItem.getCreationTime(),
+                            nvmItem.getExpiryTime(), blobs));
+  if (nvmItem.isValueCompressed()) {
+    uncompressed->markValueCompressed();
+  }
+  numUncompressedItems_.inc();
+  return uncompressed;
 }
 
 template <typename C>
@@ -641,6 +767,19 @@ void NvmCache<C>::onGetComplete(GetCtx& ctx,
 template <typename C>
 typename NvmCache<C>::ItemHandle NvmCache<C>::createItem(
     folly::StringPiece key, const NvmItem& nvmItem) {
+  if (nvmItem.areBlobsCompressed()) {
+    std::unique_ptr<NvmItem> uncompressed;
+    try {
+      uncompressed = uncompressNvmItem(nvmItem);
+    } catch (const std::exception& e) {
+      numUncompressErrors_.inc();
+      XLOG_EVERY_N(ERR, 1000)
+          << "Failed to uncompress item from nvmcache: " << e.what();
+      return nullptr;
+    }
+    return createItem(key, *uncompressed);
+  }
+
   const size_t numBufs = nvmItem.getNumBlobs();
   // parent item
   XDCHECK_GE(numBufs, 1u);
@@ -660,6 +799,9 @@ typename NvmCache<C>::ItemHandle NvmCache<C>::createItem(
   XDCHECK_LE(pBlob.origAllocSize, pBlob.data.size());
   ::memcpy(it->getMemory(), pBlob.data.data(), pBlob.data.size());
   it->markNvmClean();
+  if (nvmItem.isValueCompressed()) {
+    it->markValueCompressed();
+  }
 
   // if we have more, then we need to allocate them as chained items and add
   // them in the same order. To do that, we need to add them from the inverse
@@ -695,6 +837,19 @@ typename NvmCache<C>::ItemHandle NvmCache<C>::createItem(
 template <typename C>
 std::unique_ptr<folly::IOBuf> NvmCache<C>::createItemAsIOBuf(
     folly::StringPiece key, const NvmItem& nvmItem) {
+  if (nvmItem.areBlobsCompressed()) {
+    std::unique_ptr<NvmItem> uncompressed;
+    try {
+      uncompressed = uncompressNvmItem(nvmItem);
+    } catch (const std::exception& e) {
+      numUncompressErrors_.inc();
+      XLOG_EVERY_N(ERR, 1000)
+          << "Failed to uncompress item from nvmcache: " << e.what();
+      return nullptr;
+    }
+    return createItemAsIOBuf(key, *uncompressed);
+  }
+
   const size_t numBufs = nvmItem.getNumBlobs();
   // parent item
   XDCHECK_GE(numBufs, 1u);
@@ -721,6 +876,9 @@ std::unique_ptr<folly::IOBuf> NvmCache<C>::createItemAsIOBuf(
   ::memcpy(item->getMemory(), pBlob.data.data(), pBlob.origAllocSize);
   item->markNvmClean();
   item->markNvmEvicted();
+  if (nvmItem.isValueCompressed()) {
+    item->markValueCompressed();
+  }
 
   // if we have more, then we need to allocate them as chained items and add
   // them in the same order. To do that, we need to add them from the inverse
@@ -850,6 +1008,21 @@ std::unordered_map<std::string, double> NvmCache<C>::getStatsMap() const {
     statsMap.insert({std::move(keyStr), value});
   });
   statsMap["items_tracked_for_destructor"] = getNvmItemRemovedSize();
+  if (compressor_) {
+    const auto stats = compressor_->getStats();
+    // an item and its chained items are compressed as one blob each
+    statsMap["navy_compression_items"] = numCompressedItems_.get();
+    statsMap["navy_compression_blobs"] = stats.numCompressed;
+    statsMap["navy_compression_skipped_small"] = stats.numSkippedSmall;
+    statsMap["navy_compression_skipped_ratio"] = stats.numSkippedRatio;
+    statsMap["navy_compression_uncompressed_items"] =
+        numUncompressedItems_.get();
+    statsMap["navy_compression_uncompressed_blobs"] = stats.numUncompressed;
+    statsMap["navy_compression_uncompress_errors"] = numUncompressErrors_.get();
+    statsMap["navy_compression_raw_bytes"] = stats.uncompressedBytes;
+    statsMap["navy_compression_compressed_bytes"] = stats.compressedBytes;
+    statsMap["navy_compression_ratio"] = stats.getCompressionRatio();
+  }
   return statsMap;
 }
 
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <folly/Optional.h>
 #include <folly/container/F14Map.h>
 #include <folly/container/F14Set.h>
 #include <folly/dynamic.h>
@@ -32,6 +33,7 @@
 #include "cachelib/allocator/nvmcache/InFlightPuts.h"
 #include "cachelib/allocator/nvmcache/NavyConfig.h"
 #include "cachelib/allocator/nvmcache/NavySetup.h"
+#include "cachelib/allocator/ValueCompressor.h"
 #include "cachelib/allocator/nvmcache/NvmItem.h"
 #include "cachelib/allocator/nvmcache/ReqContexts.h"
 #include "cachelib/allocator/nvmcache/TombStones.h"
@@ -119,6 +121,15 @@ class NvmCache {
     // thread hops by using synchronous methods.
     bool enableFastNegativeLookups{false};
 
+    // (Optional) compress the item and its chained items before writing them
+    // to navy. Compression happens after encoding and before encryption.
+    // Items written with compression can only be read back with the same
+    // config, other items are read as misses.
+    // The default minSize of ValueCompressor::Config is meant for values in
+    // ram and is larger than the items of the small item engine (BigHash or
+    // Kangaroo), so lower it to compress those items.
+    folly::Optional<ValueCompressor::Config> compression{};
+
     // serialize the config for debugging purposes
     std::map<std::string, std::string> serialize() const;
 
@@ -278,6 +289,20 @@ class NvmCache {
 
   std::unique_ptr<NvmItem> makeNvmItem(const ItemHandle& handle);
 
+  // makes an NvmItem with the blobs compressed, see
+  // NvmItem::areBlobsCompressed.
+  //
+  // @return the NvmItem, or nullptr if none of the blobs compress well
+  //         enough, in which case they should be written as is.
+  std::unique_ptr<NvmItem> makeCompressedNvmItem(
+      const Item& item, PoolId poolId, const std::vector<Blob>& blobs);
+
+  // @return a copy of an NvmItem with compressed blobs, with the blobs
+  //         uncompressed
+  // @throw std::invalid_argument if the blobs are corrupted or compression
+  //        is not enabled
+  std::unique_ptr<NvmItem> uncompressNvmItem(const NvmItem& nvmItem);
+
   // wrap an item into a blob for writing into navy.
   Blob makeBlob(const Item& it);
   uint32_t getStorageSizeInNvm(const Item& it);
@@ -423,6 +448,17 @@ class NvmCache {
   C& cache_;                            //< cache allocator
   std::atomic<bool> navyEnabled_{true}; //< switch to turn off/on navy
 
+  // compresses the blobs of the items. nullptr if compression is disabled.
+  const std::unique_ptr<ValueCompressor> compressor_;
+
+  // items written with at least one compressed blob, and such items read
+  // back. The compressor counts blobs.
+  AtomicCounter numCompressedItems_;
+  AtomicCounter numUncompressedItems_;
+
+  // items that could not be uncompressed and were read as misses
+  AtomicCounter numUncompressErrors_;
+
   static constexpr size_t kShards = 8192;
 
   // a map of all pending fills to prevent thundering herds
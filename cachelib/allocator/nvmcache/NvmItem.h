@@ -94,6 +94,24 @@ class FOLLY_PACK_ATTR NvmItem {
   // return true if the item is expired
   bool isExpired() const noexcept;
 
+  // the value of the cache item was compressed by its pool's value compressor
+  // and has to be restored as such.
+  void markValueCompressed() noexcept { flags_ |= kFlagValueCompressed; }
+  bool isValueCompressed() const noexcept {
+    return flags_ & kFlagValueCompressed;
+  }
+
+  // the data of every blob starts with a byte that is kBlobCompressed if
+  // the rest of it was compressed by NvmCache, or kBlobRaw if it was not.
+  // Blobs of items without this flag have no such byte.
+  void markBlobsCompressed() noexcept { flags_ |= kFlagBlobsCompressed; }
+  bool areBlobsCompressed() const noexcept {
+    return flags_ & kFlagBlobsCompressed;
+  }
+
+  static constexpr uint8_t kBlobRaw = 0;
+  static constexpr uint8_t kBlobCompressed = 1;
+
   // @return    total size of this item including data for all the blobs. This
   // should be alteast  estimateVariableSize() + sizeof(NvmItem)
   size_t totalSize() const noexcept;
@@ -144,15 +162,17 @@ class FOLLY_PACK_ATTR NvmItem {
    * Blobs[numBlobs_ - 1]
    */
 
-  const PoolId id_; // pool id of the cache item
-#if defined(__clang__)
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wunused-private-field"
-#endif
-  const uint8_t flags_ = 0; // flags for the item. Currently unused.
-#if defined(__clang__)
-#pragma clang diagnostic pop
-#endif
+  // flags for the item
+  enum Flags : uint8_t {
+    // the value of the item is compressed, see CacheItem::isValueCompressed
+    kFlagValueCompressed = 1 << 0,
+
+    // the blobs were compressed by NvmCache, see areBlobsCompressed
+    kFlagBlobsCompressed = 1 << 1,
+  };
+
+  const PoolId id_;   // pool id of the cache item
+  uint8_t flags_ = 0; // flags for the item, see Flags
   const uint32_t creationTime_; // creation time in seconds since epoch
   const uint32_t expTime_;      // seconds since epoch when the item expires
   const size_t numBlobs_;       // total number of blobs
@@ -43,6 +43,7 @@ const uint64_t deviceMetadataSize = 1024 * 1024 * 1024;
 const uint64_t fileSize = 10 * 1024 * 1024;
 const bool truncateFile = false;
 const uint32_t deviceMaxWriteSize = 4 * 1024 * 1024;
+const uint32_t ioUringQueueDepth = 128;
 
 // BlockCache settings
 const uint32_t blockCacheRegionSize = 16 * 1024 * 1024;
@@ -88,6 +89,7 @@ void setDeviceTestSettings(NavyConfig& config) {
   config.setRaidFiles(raidPaths, fileSize, truncateFile);
   config.setDeviceMetadataSize(deviceMetadataSize);
   config.setDeviceMaxWriteSize(deviceMaxWriteSize);
+  config.setIoUring(ioUringQueueDepth);
 }
 
 void setBlockCacheTestSettings(NavyConfig& config) {
@@ -146,6 +148,18 @@ TEST(NavyConfigTest, DefaultVal) {
   EXPECT_EQ(bigHashConfig.getBucketSize(), 4096);
   EXPECT_EQ(bigHashConfig.getBucketBfSize(), 8);
   EXPECT_EQ(bigHashConfig.getSmallItemMaxSize(), 0);
+  EXPECT_EQ(bigHashConfig.getBucketCacheSize(), 0);
+
+  const auto& kangarooConfig = config.kangaroo();
+  EXPECT_EQ(kangarooConfig.getSizePct(), 0);
+  EXPECT_EQ(kangarooConfig.getBucketSize(), 4096);
+  EXPECT_EQ(kangarooConfig.getBucketBfSize(), 8);
+  EXPECT_EQ(kangarooConfig.getSmallItemMaxSize(), 0);
+  EXPECT_EQ(kangarooConfig.getLogSizePct(), 5);
+  EXPECT_EQ(kangarooConfig.getNumLogPartitions(), 16);
+  EXPECT_EQ(kangarooConfig.getLogSegmentPages(), 4);
+  EXPECT_EQ(kangarooConfig.getSetAdmissionThreshold(), 1);
+  EXPECT_FALSE(config.isKangarooEnabled());
 
   EXPECT_EQ(config.getMaxConcurrentInserts(), 1'000'000);
   EXPECT_EQ(config.getMaxParcelMemoryMB(), 256);
@@ -159,6 +173,8 @@ TEST(NavyConfigTest, DefaultVal) {
   EXPECT_EQ(config.getDeviceMetadataSize(), 0);
   EXPECT_EQ(config.getFileSize(), 0);
   EXPECT_EQ(config.getDeviceMaxWriteSize(), 0);
+  EXPECT_EQ(config.getIoUringQueueDepth(), 0);
+  EXPECT_FALSE(config.getIoUringSqPoll());
 
   EXPECT_EQ(config.usesSimpleFile(), false);
   EXPECT_EQ(config.usesRaidFiles(), false);
@@ -186,6 +202,8 @@ TEST(NavyConfigTest, Serialization) {
   expectedConfigMap["navyConfig::fileSize"] = "10485760";
   expectedConfigMap["navyConfig::truncateFile"] = "false";
   expectedConfigMap["navyConfig::deviceMaxWriteSize"] = "4194304";
+  expectedConfigMap["navyConfig::ioUringQueueDepth"] = "128";
+  expectedConfigMap["navyConfig::ioUringSqPoll"] = "false";
 
   expectedConfigMap["navyConfig::blockCacheLru"] = "false";
   expectedConfigMap["navyConfig::blockCacheRegionSize"] = "16777216";
@@ -195,6 +213,7 @@ TEST(NavyConfigTest, Serialization) {
   expectedConfigMap["navyConfig::blockCacheReinsertionPctThreshold"] = "0";
   expectedConfigMap["navyConfig::blockCacheNumInMemBuffers"] = "8";
   expectedConfigMap["navyConfig::blockCacheDataChecksum"] = "true";
+  expectedConfigMap["navyConfig::blockCacheFixedSizeIndexNumEntries"] = "0";
   expectedConfigMap["navyConfig::blockCacheSegmentedFifoSegmentRatio"] =
       "111,222,333";
 
@@ -202,6 +221,16 @@ TEST(NavyConfigTest, Serialization) {
   expectedConfigMap["navyConfig::bigHashBucketSize"] = "1024";
   expectedConfigMap["navyConfig::bigHashBucketBfSize"] = "4";
   expectedConfigMap["navyConfig::bigHashSmallItemMaxSize"] = "512";
+  expectedConfigMap["navyConfig::bigHashBucketCacheSize"] = "0";
+
+  expectedConfigMap["navyConfig::kangarooSizePct"] = "0";
+  expectedConfigMap["navyConfig::kangarooBucketSize"] = "4096";
+  expectedConfigMap["navyConfig::kangarooBucketBfSize"] = "8";
+  expectedConfigMap["navyConfig::kangarooSmallItemMaxSize"] = "0";
+  expectedConfigMap["navyConfig::kangarooLogSizePct"] = "5";
+  expectedConfigMap["navyConfig::kangarooNumLogPartitions"] = "16";
+  expectedConfigMap["navyConfig::kangarooLogSegmentPages"] = "4";
+  expectedConfigMap["navyConfig::kangarooSetAdmissionThreshold"] = "1";
 
   expectedConfigMap["navyConfig::maxConcurrentInserts"] = "50000";
   expectedConfigMap["navyConfig::maxParcelMemoryMB"] = "512";
@@ -286,6 +315,9 @@ TEST(NavyConfigTest, BlockCache) {
   EXPECT_EQ(blockCacheConfig.getNumInMemBuffers(), blockCacheCleanRegions * 2);
   EXPECT_EQ(blockCacheConfig.getDataChecksum(), blockCacheDataChecksum);
   EXPECT_EQ(blockCacheConfig.getSizeClasses(), blockCacheSizeClasses);
+  EXPECT_EQ(blockCacheConfig.getFixedSizeIndexNumEntries(), 0);
+  config.blockCache().useFixedSizeIndex(1000);
+  EXPECT_EQ(blockCacheConfig.getFixedSizeIndexNumEntries(), 1000);
 
   // test FIFO eviction policy
   config.blockCache().enableFifo();
@@ -358,6 +390,33 @@ TEST(NavyConfigTest, BigHash) {
   EXPECT_EQ(bigHashConfig.getBucketSize(), bigHashBucketSize);
   EXPECT_EQ(bigHashConfig.getBucketBfSize(), bigHashBucketBfSize);
   EXPECT_EQ(bigHashConfig.getSmallItemMaxSize(), bigHashSmallItemMaxSize);
+  config.bigHash().setBucketCacheSize(1024 * 1024);
+  EXPECT_EQ(bigHashConfig.getBucketCacheSize(), 1024 * 1024);
+}
+
+TEST(NavyConfigTest, Kangaroo) {
+  NavyConfig config{};
+  EXPECT_THROW(config.kangaroo().setSizePctAndMaxItemSize(200, 512),
+               std::invalid_argument);
+  config.kangaroo()
+      .setSizePctAndMaxItemSize(50, 512)
+      .setBucketSize(1024)
+      .setBucketBfSize(4)
+      .setLogSizePct(10)
+      .setNumLogPartitions(8)
+      .setLogSegmentPages(2)
+      .setSetAdmissionThreshold(3);
+  const auto& kangarooConfig = config.kangaroo();
+  EXPECT_EQ(kangarooConfig.getSizePct(), 50);
+  EXPECT_EQ(kangarooConfig.getBucketSize(), 1024);
+  EXPECT_EQ(kangarooConfig.getBucketBfSize(), 4);
+  EXPECT_EQ(kangarooConfig.getSmallItemMaxSize(), 512);
+  EXPECT_EQ(kangarooConfig.getLogSizePct(), 10);
+  EXPECT_EQ(kangarooConfig.getNumLogPartitions(), 8);
+  EXPECT_EQ(kangarooConfig.getLogSegmentPages(), 2);
+  EXPECT_EQ(kangarooConfig.getSetAdmissionThreshold(), 3);
+  EXPECT_TRUE(config.isKangarooEnabled());
+  EXPECT_EQ(config.getSmallItemThreshold(), 512);
 }
 
 TEST(NavyConfigTest, JobScheduler) {
@@ -1437,6 +1437,112 @@ TEST_F(NvmCacheTest, TruncatedAllocSize) {
   }
 }
 
+TEST_F(NvmCacheTest, Compression) {
+  auto& config = this->getConfig();
+  config.configureChainedItems();
+  // the unused end of the allocations would make any value compressible
+  config.nvmConfig->truncateItemToOriginalAllocSizeInNvm = true;
+  ValueCompressor::Config compression;
+  compression.minSize = 512;
+  config.enableNvmCacheCompression(compression);
+  auto& cache = this->makeCache();
+  auto pid = this->poolId();
+
+  // compressible parent and chained items, and an incompressible item that
+  // is written as is.
+  const std::string value(8 * 1024, 'a');
+  const std::string chainedValue(2 * 1024, 'b');
+  const std::string randomValue = genRandomStr(8 * 1024);
+  {
+    auto it = cache.allocate(pid, "compressible", value.size());
+    ASSERT_NE(nullptr, it);
+    std::memcpy(it->getMemory(), value.data(), value.size());
+    for (int i = 0; i < 3; i++) {
+      auto chainedIt = cache.allocateChainedItem(it, chainedValue.size());
+      ASSERT_NE(nullptr, chainedIt);
+      std::memcpy(chainedIt->getMemory(), chainedValue.data(),
+                  chainedValue.size());
+      cache.addChainedItem(it, std::move(chainedIt));
+    }
+    cache.insertOrReplace(it);
+
+    auto randomIt = cache.allocate(pid, "random", randomValue.size());
+    ASSERT_NE(nullptr, randomIt);
+    std::memcpy(randomIt->getMemory(), randomValue.data(), randomValue.size());
+    cache.insertOrReplace(randomIt);
+  }
+
+  for (const auto key : {"compressible", "random"}) {
+    this->pushToNvmCacheFromRamForTesting(key);
+    this->removeFromRamForTesting(key);
+  }
+
+  {
+    auto it = this->fetch("compressible", false /* ramOnly */);
+    it.wait();
+    ASSERT_NE(nullptr, it);
+    ASSERT_EQ(value.size(), it->getSize());
+    ASSERT_EQ(0, std::memcmp(it->getMemory(), value.data(), value.size()));
+    auto chained = cache.viewAsChainedAllocs(it);
+    ASSERT_EQ(3, chained.computeChainLength());
+    for (const auto& c : chained.getChain()) {
+      ASSERT_EQ(0, std::memcmp(c.getMemory(), chainedValue.data(),
+                               chainedValue.size()));
+    }
+  }
+  {
+    auto it = this->fetch("random", false /* ramOnly */);
+    it.wait();
+    ASSERT_NE(nullptr, it);
+    ASSERT_EQ(0, std::memcmp(it->getMemory(), randomValue.data(),
+                             randomValue.size()));
+  }
+
+  auto stats = cache.getNvmCacheStatsMap();
+  EXPECT_EQ(1, stats["navy_compression_items"]);
+  EXPECT_EQ(4, stats["navy_compression_blobs"]);
+  EXPECT_EQ(1, stats["navy_compression_skipped_ratio"]);
+  EXPECT_EQ(1, stats["navy_compression_uncompressed_items"]);
+  EXPECT_EQ(4, stats["navy_compression_uncompressed_blobs"]);
+  EXPECT_EQ(0, stats["navy_compression_uncompress_errors"]);
+  EXPECT_LT(stats["navy_compression_compressed_bytes"],
+            stats["navy_compression_raw_bytes"]);
+
+  // compression needs nvmcache
+  AllocatorT::Config noNvmConfig;
+  ASSERT_THROW(noNvmConfig.enableNvmCacheCompression(compression),
+               std::invalid_argument);
+}
+
+TEST_F(NvmCacheTest, ValueCompressionRoundTrip) {
+  auto& config = this->getConfig();
+  ValueCompressor::Config compression;
+  compression.minSize = 512;
+  config.enableValueCompression("default", compression);
+  auto& cache = this->makeCache();
+  auto pid = this->poolId();
+
+  // an item compressed in ram is written to nvmcache as is and comes back
+  // compressed.
+  const std::string value(8 * 1024, 'a');
+  {
+    auto it = cache.allocateCompressed(pid, "key", folly::StringPiece(value));
+    ASSERT_NE(nullptr, it);
+    ASSERT_TRUE(it->isValueCompressed());
+    cache.insertOrReplace(it);
+  }
+  this->pushToNvmCacheFromRamForTesting("key");
+  this->removeFromRamForTesting("key");
+  ASSERT_EQ(nullptr, cache.peek("key"));
+
+  auto it = this->fetch("key", false /* ramOnly */);
+  it.wait();
+  ASSERT_NE(nullptr, it);
+  ASSERT_TRUE(it->isValueCompressed());
+  auto ioBuf = cache.convertToIOBuf(std::move(it));
+  ASSERT_EQ(value, ioBuf.moveToFbString().toStdString());
+}
+
 TEST_F(NvmCacheTest, NavyStats) {
   // Ensure we export all the stats we expect
   // Everytime we add a new stat, make sure to update this test accordingly
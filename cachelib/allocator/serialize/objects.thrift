@@ -65,6 +65,7 @@ struct MMLruConfig {
   4: bool updateOnRead = true,
   5: bool tryLockUpdate = false,
   6: double lruRefreshRatio = 0.0,
+  7: i32 accessBufferSize = 0,
 }
 
 struct MMLruObject {
@@ -133,6 +134,21 @@ struct MMTinyLFUCollection {
   1: required map<i32, map<i32, MMTinyLFUObject>> pools,
 }
 
+struct MMClockConfig {
+  1: bool updateOnWrite = false,
+  2: bool updateOnRead = true,
+}
+
+struct MMClockObject {
+  1: required MMClockConfig config,
+  2: required DListObject list,
+  3: required i64 compressedHand,
+}
+
+struct MMClockCollection {
+  1: required map<i32, map<i32, MMClockObject>> pools,
+}
+
 struct ChainedHashTableObject {
   // fields in ChainedHashTable::Config
   1: required i32 bucketsPower,
@@ -142,6 +158,27 @@ struct ChainedHashTableObject {
   // this magic id ensures on a warm roll, user cannot
   // start the cache with a different hash function
   4: i32 hasherMagicId = 0,
+
+  // bucket power of the buckets in use. Differs from bucketsPower once the
+  // table was grown online. 0 means same as bucketsPower.
+  5: i32 tableBucketsPower = 0,
+  // number of resizes the table went through
+  6: i32 tableGeneration = 0,
+  // bucket power of the table being grown into, 0 if not resizing
+  7: i32 newBucketsPower = 0,
+  // number of buckets migrated to the new table
+  8: i64 rehashIdx = 0,
+}
+
+struct TagHashTableObject {
+  // fields in ChainedHashTable::Config that TagHashTable shares
+  1: required i32 bucketsPower,
+  2: required i32 locksPower,
+  3: i64 numKeys,
+
+  // this magic id ensures on a warm roll, user cannot
+  // start the cache with a different hash function
+  4: i32 hasherMagicId = 0,
 }
 
 struct MMTTLBucketObject {
@@ -140,6 +140,7 @@ struct AccessTypeTest : public SlabAllocatorTestBase {
   void testReplace();
   void testRemove();
   void testFind();
+  void testFindBatch();
   void testSerialization();
   void testHandleContexts();
   void testRemoveIf();
@@ -272,6 +273,47 @@ void AccessTypeTest<AccessType>::testRemove() {
   }
 }
 
+template <typename AccessType>
+void AccessTypeTest<AccessType>::testFindBatch() {
+  Container c;
+  auto nodes = createSimpleContainer(c);
+
+  // mix the existing keys with keys that are not in the container and a
+  // duplicate so that the batch covers hits, misses and repeated lookups.
+  std::vector<std::string> missingKeys;
+  for (int i = 0; i < 100; i++) {
+    missingKeys.push_back(getRandomNewKey(c));
+  }
+
+  std::vector<typename Node::Key> keys;
+  for (const auto& node : nodes) {
+    keys.push_back(node->getKey());
+  }
+  for (const auto& key : missingKeys) {
+    keys.push_back(folly::StringPiece{key});
+  }
+  keys.push_back(nodes[0]->getKey());
+
+  const auto oldCount = nodes[0]->getRefCount();
+  {
+    auto handles = c.findBatch({keys.data(), keys.size()});
+    ASSERT_EQ(keys.size(), handles.size());
+    for (size_t i = 0; i < nodes.size(); i++) {
+      ASSERT_EQ(handles[i], nodes[i]);
+    }
+    for (size_t i = nodes.size(); i < nodes.size() + missingKeys.size(); i++) {
+      ASSERT_EQ(nullptr, handles[i]);
+    }
+    ASSERT_EQ(handles.back(), nodes[0]);
+    ASSERT_EQ(nodes[0]->getRefCount(), oldCount + 2);
+  }
+  // once the handles are released, the count should go back.
+  ASSERT_EQ(nodes[0]->getRefCount(), oldCount);
+
+  // an empty batch is a no-op
+  ASSERT_TRUE(c.findBatch({}).empty());
+}
+
 template <typename AccessType>
 void AccessTypeTest<AccessType>::testFind() {
   Container c;
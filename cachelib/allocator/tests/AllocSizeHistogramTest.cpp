@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+
+#include "cachelib/allocator/AllocSizeHistogram.h"
+#include "cachelib/allocator/tests/TestBase.h"
+
+namespace facebook {
+namespace cachelib {
+
+namespace tests {
+class AllocSizeHistogramTest : public testing::Test {};
+
+TEST_F(AllocSizeHistogramTest, Buckets) {
+  // every size falls in the first bucket whose max size is not below it.
+  for (uint32_t size = 1; size <= Slab::kSize; size++) {
+    const auto idx = AllocSizeHistogram::getBucketIdx(size);
+    ASSERT_LT(idx, AllocSizeHistogram::kNumBuckets);
+    ASSERT_GE(AllocSizeHistogram::getBucketMaxSize(idx), size);
+    if (idx > 0) {
+      ASSERT_LT(AllocSizeHistogram::getBucketMaxSize(idx - 1), size);
+    }
+  }
+  ASSERT_EQ(Slab::kSize, AllocSizeHistogram::getBucketMaxSize(
+                             AllocSizeHistogram::kNumBuckets - 1));
+
+  AllocSizeHistogram histogram;
+  histogram.record(100);
+  histogram.record(101);
+  histogram.record(5000);
+  ASSERT_EQ(3, histogram.getNumSamples());
+  const auto buckets = histogram.getBuckets();
+  ASSERT_EQ(2, buckets.size());
+  ASSERT_EQ(104, buckets[0].maxSize);
+  ASSERT_EQ(2, buckets[0].count);
+  ASSERT_EQ(201, buckets[0].sizeSum);
+  ASSERT_EQ(1, buckets[1].count);
+
+  histogram.reset();
+  ASSERT_EQ(0, histogram.getNumSamples());
+  ASSERT_TRUE(histogram.proposeAllocSizes(10).empty());
+}
+
+TEST_F(AllocSizeHistogramTest, Sampling) {
+  ASSERT_THROW(AllocSizeHistogram(0), std::invalid_argument);
+
+  // sizes are sampled at random, about one out of ten
+  AllocSizeHistogram histogram(10);
+  for (int i = 0; i < 10000; i++) {
+    histogram.record(1000);
+  }
+  ASSERT_LT(800, histogram.getNumSamples());
+  ASSERT_GT(1200, histogram.getNumSamples());
+
+  // histograms sample independently of each other
+  AllocSizeHistogram first(10);
+  AllocSizeHistogram second(10);
+  for (int i = 0; i < 10000; i++) {
+    first.record(1000);
+    second.record(1000);
+  }
+  ASSERT_LT(800, first.getNumSamples());
+  ASSERT_GT(1200, first.getNumSamples());
+  ASSERT_LT(800, second.getNumSamples());
+  ASSERT_GT(1200, second.getNumSamples());
+}
+
+TEST_F(AllocSizeHistogramTest, ProposeAllocSizes) {
+  AllocSizeHistogram histogram;
+  ASSERT_THROW(histogram.proposeAllocSizes(0), std::invalid_argument);
+  ASSERT_THROW(
+      histogram.proposeAllocSizes(MemoryAllocator::kMaxClasses + 1),
+      std::invalid_argument);
+
+  // two sizes need exactly two classes to waste nothing but the ends of the
+  // slabs.
+  for (int i = 0; i < 1000; i++) {
+    histogram.record(200);
+    histogram.record(3008);
+  }
+  ASSERT_EQ((std::set<uint32_t>{200, 3008}), histogram.proposeAllocSizes(2));
+  ASSERT_EQ((std::set<uint32_t>{200, 3008}), histogram.proposeAllocSizes(10));
+  ASSERT_EQ((std::set<uint32_t>{3008}), histogram.proposeAllocSizes(1));
+
+  // on a spread out distribution, the proposed classes waste less than the
+  // same number of classes spaced by a factor.
+  histogram.reset();
+  std::mt19937 gen(1);
+  std::normal_distribution<double> small(300, 20);
+  std::normal_distribution<double> large(1500, 50);
+  for (int i = 0; i < 100000; i++) {
+    histogram.record(static_cast<uint32_t>(small(gen)));
+    histogram.record(static_cast<uint32_t>(large(gen)));
+  }
+  std::set<uint32_t> factorSizes;
+  for (double size = 64; size < 4000; size *= 1.25) {
+    factorSizes.insert(static_cast<uint32_t>(size) / 8 * 8);
+  }
+  const auto proposed =
+      histogram.proposeAllocSizes(static_cast<unsigned int>(factorSizes.size()));
+  ASSERT_LE(proposed.size(), factorSizes.size());
+  ASSERT_LT(histogram.getWastedFraction(proposed),
+            histogram.getWastedFraction(factorSizes) / 2);
+
+  // more classes never waste more.
+  ASSERT_LE(histogram.getWastedFraction(histogram.proposeAllocSizes(8)),
+            histogram.getWastedFraction(histogram.proposeAllocSizes(4)));
+}
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
@@ -26,6 +26,12 @@ using LruAllocatorMemoryTiersTest = AllocatorMemoryTiersTest<LruAllocator>;
 TEST_F(LruAllocatorMemoryTiersTest, MultiTiersInvalid) { this->testMultiTiersInvalid(); }
 TEST_F(LruAllocatorMemoryTiersTest, MultiTiersValid) { this->testMultiTiersValid(); }
 TEST_F(LruAllocatorMemoryTiersTest, MultiTiersValidMixed) { this->testMultiTiersValidMixed(); }
+TEST_F(LruAllocatorMemoryTiersTest, MultiTiersPromotion) { this->testMultiTiersPromotion(); }
+TEST_F(LruAllocatorMemoryTiersTest, MultiTiersChainedItems) { this->testMultiTiersChainedItems(); }
+TEST_F(LruAllocatorMemoryTiersTest, MultiTiersValueCompression) { this->testMultiTiersValueCompression(); }
+TEST_F(LruAllocatorMemoryTiersTest, MultiTiersBackgroundEviction) { this->testMultiTiersBackgroundEviction(); }
+TEST_F(LruAllocatorMemoryTiersTest, MultiTiersPerTierStats) { this->testMultiTiersPerTierStats(); }
+TEST_F(LruAllocatorMemoryTiersTest, MultiTiersAdmissionPolicy) { this->testMultiTiersAdmissionPolicy(); }
 
 } // end of namespace tests
 } // end of namespace cachelib
@@ -16,9 +16,14 @@
 
 #pragma once
 
+#include <folly/Random.h>
+
+#include <algorithm>
+
 #include "cachelib/allocator/CacheAllocatorConfig.h"
 #include "cachelib/allocator/MemoryTierCacheConfig.h"
 #include "cachelib/allocator/tests/TestBase.h"
+#include "cachelib/common/TestUtils.h"
 
 namespace facebook {
 namespace cachelib {
@@ -27,6 +32,39 @@ namespace tests {
 template <typename AllocatorT>
 class AllocatorMemoryTiersTest : public AllocatorTest<AllocatorT> {
  public:
+  // config of a cache split evenly between a shm tier on top and a file
+  // tier below it
+  static typename AllocatorT::Config makeTwoTierConfig() {
+    typename AllocatorT::Config config;
+    config.setCacheSize(100 * Slab::kSize);
+    config.enableCachePersistence("/tmp");
+    config.usePosixForShm();
+    config.configureMemoryTiers({
+        MemoryTierCacheConfig::fromShm()
+            .setRatio(1),
+        MemoryTierCacheConfig::fromFile("/tmp/b" + std::to_string(::getpid()))
+            .setRatio(1)
+    });
+    return config;
+  }
+
+  // insert items named key0, key1, ... with insertFn(key, i) until the first
+  // item is demoted from tier 0 to tier 1. Stops on a fatal failure in
+  // insertFn, so call it in ASSERT_NO_FATAL_FAILURE.
+  //
+  // @return the number of items inserted
+  template <typename InsertFn>
+  static unsigned int fillUntilDemotion(AllocatorT& alloc,
+                                        InsertFn&& insertFn) {
+    unsigned int numKeys = 0;
+    while (alloc.getGlobalCacheStats().numTierDemotions[0] == 0 &&
+           !::testing::Test::HasFatalFailure()) {
+      insertFn(folly::sformat("key{}", numKeys), numKeys);
+      ++numKeys;
+    }
+    return numKeys;
+  }
+
   void testMultiTiersInvalid() {
     typename AllocatorT::Config config;
     config.setCacheSize(100 * Slab::kSize);
@@ -64,16 +102,7 @@ class AllocatorMemoryTiersTest : public AllocatorTest<AllocatorT> {
   }
 
   void testMultiTiersValidMixed() {
-    typename AllocatorT::Config config;
-    config.setCacheSize(100 * Slab::kSize);
-    config.enableCachePersistence("/tmp");
-    config.usePosixForShm();
-    config.configureMemoryTiers({
-        MemoryTierCacheConfig::fromShm()
-            .setRatio(1),
-        MemoryTierCacheConfig::fromFile("/tmp/b" + std::to_string(::getpid()))
-            .setRatio(1)
-    });
+    auto config = makeTwoTierConfig();
 
     auto alloc = std::make_unique<AllocatorT>(AllocatorT::SharedMemNew, config);
     ASSERT(alloc != nullptr);
@@ -83,6 +112,288 @@ class AllocatorMemoryTiersTest : public AllocatorTest<AllocatorT> {
     ASSERT(handle != nullptr);
     ASSERT_NO_THROW(alloc->insertOrReplace(handle));
   }
+
+  void testMultiTiersPromotion() {
+    auto config = makeTwoTierConfig();
+    config.enableMemoryTierPromotion(std::chrono::milliseconds{10},
+                                     2 /* hitsToPromote */);
+
+    auto alloc = std::make_unique<AllocatorT>(AllocatorT::SharedMemNew, config);
+    ASSERT(alloc != nullptr);
+    auto pool = alloc->addPool("default", alloc->getCacheMemoryStats().cacheSize);
+
+    // fill tier 0 until the oldest items start getting demoted to tier 1
+    const uint32_t valSize = 100 * 1024;
+    unsigned int numKeys = 0;
+    ASSERT_NO_FATAL_FAILURE(
+        numKeys = fillUntilDemotion(*alloc, [&](const std::string& key,
+                                                unsigned int) {
+          ASSERT_NE(nullptr,
+                    util::allocateAccessible(*alloc, pool, key, valSize));
+        }));
+
+    std::string key;
+    for (unsigned int i = 0; i < numKeys && key.empty(); i++) {
+      auto handle = alloc->peek(folly::sformat("key{}", i));
+      if (handle && alloc->getTierId(*handle) == 1) {
+        key = handle->getKey().str();
+      }
+    }
+    ASSERT_FALSE(key.empty());
+
+    // repeated hits on the item move it back up to tier 0
+    ASSERT_EVENTUALLY_TRUE(
+        [&]() {
+          { auto handle = alloc->find(key); }
+          auto handle = alloc->peek(key);
+          return handle && alloc->getTierId(*handle) == 0;
+        },
+        10);
+
+    auto stats = alloc->getGlobalCacheStats();
+    EXPECT_LE(1u, stats.numTierPromotions[1]);
+    EXPECT_EQ(0u, stats.numTierPromotions[0]);
+  }
+
+  void testMultiTiersChainedItems() {
+    auto config = makeTwoTierConfig();
+
+    auto alloc = std::make_unique<AllocatorT>(AllocatorT::SharedMemNew, config);
+    ASSERT(alloc != nullptr);
+    auto pool = alloc->addPool("default", alloc->getCacheMemoryStats().cacheSize);
+
+    // fill tier 0 with chains until the oldest ones get demoted to tier 1
+    const uint32_t valSize = 100 * 1024;
+    const uint32_t chainedValSize = 10 * 1024;
+    const unsigned int chainLength = 3;
+    unsigned int numKeys = 0;
+    ASSERT_NO_FATAL_FAILURE(
+        numKeys = fillUntilDemotion(*alloc, [&](const std::string& key,
+                                                unsigned int) {
+          auto parent = alloc->allocate(pool, key, valSize);
+          ASSERT_NE(nullptr, parent);
+          for (unsigned int i = 0; i < chainLength; i++) {
+            auto child = alloc->allocateChainedItem(parent, chainedValSize);
+            ASSERT_NE(nullptr, child);
+            std::memset(child->getWritableMemory(), 'a' + i, chainedValSize);
+            alloc->addChainedItem(parent, std::move(child));
+          }
+          alloc->insertOrReplace(parent);
+        }));
+
+    unsigned int numDemoted = 0;
+    for (unsigned int i = 0; i < numKeys; i++) {
+      auto handle = alloc->peek(folly::sformat("key{}", i));
+      if (!handle || alloc->getTierId(*handle) != 1) {
+        continue;
+      }
+      ++numDemoted;
+
+      // the whole chain moved along with its parent and kept its order
+      auto chainedAllocs = alloc->viewAsChainedAllocs(handle);
+      ASSERT_EQ(chainLength, chainedAllocs.computeChainLength());
+      for (unsigned int j = 0; j < chainLength; j++) {
+        const auto* child = chainedAllocs.getNthInChain(j);
+        ASSERT_NE(nullptr, child);
+        EXPECT_EQ(1, alloc->getTierId(*child));
+        const auto* data = reinterpret_cast<const char*>(child->getMemory());
+        const char expected = 'a' + (chainLength - 1 - j);
+        EXPECT_EQ(chainedValSize,
+                  static_cast<uint32_t>(
+                      std::count(data, data + chainedValSize, expected)));
+      }
+    }
+    EXPECT_LT(0u, numDemoted);
+  }
+
+  void testMultiTiersValueCompression() {
+    auto config = makeTwoTierConfig();
+    ValueCompressor::Config compression;
+    compression.minSize = 512;
+    config.enableValueCompression("default", compression);
+
+    auto alloc = std::make_unique<AllocatorT>(AllocatorT::SharedMemNew, config);
+    ASSERT(alloc != nullptr);
+    auto pool = alloc->addPool("default", alloc->getCacheMemoryStats().cacheSize);
+
+    // values that compress to about half of their size
+    const uint32_t valSize = 100 * 1024;
+    std::string randomHalf(valSize / 2, 0);
+    for (auto& c : randomHalf) {
+      c = static_cast<char>(folly::Random::rand32());
+    }
+    const auto makeValue = [&](unsigned int i) {
+      auto value = folly::sformat("{:08}", i) + randomHalf;
+      value.resize(valSize, 'a');
+      return value;
+    };
+
+    // fill tier 0 until the oldest items start getting demoted to tier 1
+    unsigned int numKeys = 0;
+    ASSERT_NO_FATAL_FAILURE(
+        numKeys = fillUntilDemotion(*alloc, [&](const std::string& key,
+                                                unsigned int i) {
+          const auto value = makeValue(i);
+          auto handle = alloc->allocateCompressed(pool, key,
+                                                  folly::StringPiece(value));
+          ASSERT_NE(nullptr, handle);
+          ASSERT_TRUE(handle->isValueCompressed());
+          alloc->insertOrReplace(handle);
+        }));
+
+    // demoted items are still compressed and read back uncompressed
+    unsigned int numDemoted = 0;
+    for (unsigned int i = 0; i < numKeys; i++) {
+      auto handle = alloc->peek(folly::sformat("key{}", i));
+      if (!handle || alloc->getTierId(*handle) != 1) {
+        continue;
+      }
+      ++numDemoted;
+      ASSERT_TRUE(handle->isValueCompressed());
+      auto ioBuf = alloc->convertToIOBuf(std::move(handle));
+      ASSERT_EQ(makeValue(i), ioBuf.moveToFbString().toStdString());
+    }
+    EXPECT_LT(0u, numDemoted);
+  }
+
+  void testMultiTiersBackgroundEviction() {
+    auto config = makeTwoTierConfig();
+    config.enableBackgroundEvictor(std::chrono::milliseconds{10},
+                                   10 /* freeAllocsPercent */,
+                                   100 /* maxEvictionBatch */);
+
+    auto alloc = std::make_unique<AllocatorT>(AllocatorT::SharedMemNew, config);
+    ASSERT(alloc != nullptr);
+    auto pool = alloc->addPool("default", alloc->getCacheMemoryStats().cacheSize);
+
+    // fill tier 0 until items start getting demoted to tier 1
+    const uint32_t valSize = 100 * 1024;
+    unsigned int numKeys = 0;
+    ClassId cid = -1;
+    ASSERT_NO_FATAL_FAILURE(
+        numKeys = fillUntilDemotion(*alloc, [&](const std::string& key,
+                                                unsigned int) {
+          auto handle = util::allocateAccessible(*alloc, pool, key, valSize);
+          ASSERT_NE(nullptr, handle);
+          cid = alloc->getAllocInfo(handle->getMemory()).classId;
+        }));
+
+    // the evictor demotes items until 10% of the class in tier 0 is free
+    ASSERT_EVENTUALLY_TRUE(
+        [&]() {
+          const auto acStats =
+              alloc->getPoolByTid(pool, 0).getAllocationClass(cid).getStats();
+          const auto capacity = acStats.usedSlabs * acStats.allocsPerSlab;
+          return (capacity - acStats.activeAllocs) * 100 >= capacity * 10;
+        },
+        10);
+
+    EXPECT_LT(0u, alloc->getBackgroundEvictorStats().numEvictedItems);
+
+    // new items are allocated out of the freed memory in tier 0
+    auto handle = util::allocateAccessible(
+        *alloc, pool, folly::sformat("key{}", numKeys++), valSize);
+    ASSERT_NE(nullptr, handle);
+    EXPECT_EQ(0, alloc->getTierId(*handle));
+  }
+
+  void testMultiTiersPerTierStats() {
+    auto config = makeTwoTierConfig();
+
+    auto alloc = std::make_unique<AllocatorT>(AllocatorT::SharedMemNew, config);
+    ASSERT(alloc != nullptr);
+    auto pool = alloc->addPool("default", alloc->getCacheMemoryStats().cacheSize);
+
+    // the pool is split between the tiers by their ratio
+    const auto tier0Stats = alloc->getPoolStats(0, pool);
+    const auto tier1Stats = alloc->getPoolStats(1, pool);
+    EXPECT_EQ(tier0Stats.poolSize, tier1Stats.poolSize);
+    EXPECT_EQ(tier0Stats.poolSize + tier1Stats.poolSize,
+              alloc->getPoolStats(pool).poolSize);
+
+    // write enough to evict out of both tiers
+    const uint32_t valSize = 100 * 1024;
+    const unsigned int numKeys = 4 * 100 * Slab::kSize / valSize;
+    for (unsigned int i = 0; i < numKeys; i++) {
+      auto handle = util::allocateAccessible(
+          *alloc, pool, folly::sformat("key{}", i), valSize);
+      ASSERT_NE(nullptr, handle);
+    }
+
+    // the most recent item lives in tier 0
+    ASSERT_NE(nullptr, alloc->find(folly::sformat("key{}", numKeys - 1)));
+
+    const auto stats = alloc->getGlobalCacheStats();
+    ASSERT_EQ(2u, stats.numTierAllocAttempts.size());
+    // tier 1 only receives allocations for demoted items
+    EXPECT_LT(0u, stats.numTierAllocAttempts[0]);
+    EXPECT_LT(0u, stats.numTierAllocAttempts[1]);
+    EXPECT_LE(stats.numTierDemotions[0], stats.numTierAllocAttempts[1]);
+    EXPECT_LT(0u, stats.numTierEvictions[0]);
+    EXPECT_LT(0u, stats.numTierEvictions[1]);
+    EXPECT_EQ(stats.numTierEvictions[0] + stats.numTierEvictions[1],
+              stats.numEvictions);
+    EXPECT_LE(1u, stats.numTierCacheHits[0]);
+  }
+
+  void testMultiTiersAdmissionPolicy() {
+    auto config = makeTwoTierConfig();
+    // large items go straight to tier 1 and nothing that was never read is
+    // demoted.
+    const uint32_t largeSize = 512 * 1024;
+    auto sizePolicy =
+        std::make_shared<SizeTierAdmissionPolicy<AllocatorT>>(largeSize);
+    typename FrequencyTierAdmissionPolicy<AllocatorT>::Config freqConfig;
+    freqConfig.minAccesses = 1;
+    auto freqPolicy =
+        std::make_shared<FrequencyTierAdmissionPolicy<AllocatorT>>(freqConfig);
+
+    config.setMemoryTierAdmissionPolicy(sizePolicy);
+    {
+      auto alloc =
+          std::make_unique<AllocatorT>(AllocatorT::SharedMemNew, config);
+      ASSERT(alloc != nullptr);
+      auto pool =
+          alloc->addPool("default", alloc->getCacheMemoryStats().cacheSize);
+
+      auto small = util::allocateAccessible(*alloc, pool, "small", 1024);
+      ASSERT_NE(nullptr, small);
+      EXPECT_EQ(0, alloc->getTierId(*small));
+
+      auto large = util::allocateAccessible(*alloc, pool, "large", largeSize);
+      ASSERT_NE(nullptr, large);
+      EXPECT_EQ(1, alloc->getTierId(*large));
+    }
+
+    config.setMemoryTierAdmissionPolicy(freqPolicy);
+    auto alloc = std::make_unique<AllocatorT>(AllocatorT::SharedMemNew, config);
+    ASSERT(alloc != nullptr);
+    auto pool = alloc->addPool("default", alloc->getCacheMemoryStats().cacheSize);
+
+    // one item is read on every round, the rest are written once
+    const uint32_t valSize = 100 * 1024;
+    const unsigned int numKeys = 2 * 100 * Slab::kSize / valSize;
+    ASSERT_NE(nullptr, util::allocateAccessible(*alloc, pool, "hot", valSize));
+    for (unsigned int i = 0; i < numKeys; i++) {
+      auto handle = util::allocateAccessible(
+          *alloc, pool, folly::sformat("key{}", i), valSize);
+      ASSERT_NE(nullptr, handle);
+      ASSERT_NE(nullptr, alloc->find("hot"));
+    }
+
+    const auto stats = alloc->getGlobalCacheStats();
+    EXPECT_LT(0u, stats.numTierDemotionRejectsByAP[0]);
+    EXPECT_EQ(stats.numTierDemotionRejectsByAP[0],
+              static_cast<uint64_t>(
+                  freqPolicy->getCounters()["mtap.demotions_rejected"]));
+    // none of the cold items made it to tier 1
+    for (unsigned int i = 0; i < numKeys; i++) {
+      auto handle = alloc->peek(folly::sformat("key{}", i));
+      if (handle) {
+        EXPECT_EQ(0, alloc->getTierId(*handle));
+      }
+    }
+  }
 };
 } // namespace tests
 } // namespace cachelib
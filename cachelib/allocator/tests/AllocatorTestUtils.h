@@ -31,15 +31,18 @@ struct AlwaysPickOneRebalanceStrategy : public RebalanceStrategy {
         receiver(receiver) {}
 
  private:
-  ClassId pickVictim(const CacheBase&, PoolId) { return victim; }
+  ClassId pickVictim(const CacheBase&, TierId, PoolId) { return victim; }
 
-  ClassId pickVictimImpl(const CacheBase& allocator, PoolId pid) override {
-    return pickVictim(allocator, pid);
+  ClassId pickVictimImpl(const CacheBase& allocator,
+                         TierId tid,
+                         PoolId pid) override {
+    return pickVictim(allocator, tid, pid);
   }
 
   RebalanceContext pickVictimAndReceiverImpl(const CacheBase& allocator,
+                                             TierId tid,
                                              PoolId pid) override {
-    return {pickVictim(allocator, pid), receiver};
+    return {pickVictim(allocator, tid, pid), receiver};
   }
 };
 } // namespace tests
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <type_traits>
+
 #include "cachelib/allocator/tests/BaseAllocatorTest.h"
 #include "cachelib/allocator/tests/TestBase.h"
 #include "cachelib/allocator/MemoryTierCacheConfig.h"
@@ -24,6 +26,12 @@ namespace tests {
 
 TYPED_TEST_CASE(BaseAllocatorTest, AllocatorTypes);
 
+// MMClock has no refresh time and does not order items by their access
+// time, so the tests of those skip ClockAllocator.
+template <typename AllocatorT>
+constexpr bool kIsClock =
+    std::is_same_v<typename AllocatorT::MMType, MMClock>;
+
 // test all the error scenarios with respect to allocating a new key.
 TYPED_TEST(BaseAllocatorTest, AllocateAccessible) {
   this->testAllocateAccessible();
@@ -55,6 +63,9 @@ TYPED_TEST(BaseAllocatorTest, ReadWriteHandle) { this->testReadWriteHandle(); }
 // fetch them.
 TYPED_TEST(BaseAllocatorTest, Find) { this->testFind(); }
 
+// batched lookups return the same handles as individual finds.
+TYPED_TEST(BaseAllocatorTest, FindBatch) { this->testFindBatch(); }
+
 // make some allocations without evictions, remove them and ensure that they
 // cannot be accessed through find.
 TYPED_TEST(BaseAllocatorTest, Remove) { this->testRemove(); }
@@ -119,7 +130,9 @@ TYPED_TEST(BaseAllocatorTest, ShmTemporary) { this->testShmTemporary(); }
 TYPED_TEST(BaseAllocatorTest, Serialization) { this->testSerialization(); }
 
 TYPED_TEST(BaseAllocatorTest, SerializationMMConfig) {
-  this->testSerializationMMConfig();
+  if constexpr (!kIsClock<TypeParam>) {
+    this->testSerializationMMConfig();
+  }
 }
 
 TYPED_TEST(BaseAllocatorTest, testSerializationWithFragmentation) {
@@ -129,7 +142,11 @@ TYPED_TEST(BaseAllocatorTest, testSerializationWithFragmentation) {
 // make some allocations and access them and record explicitly the time it was
 // accessed. Ensure that the items that are evicted are descending in order of
 // time. To ensure the lru property, lets only allocate objects of fixed size.
-TYPED_TEST(BaseAllocatorTest, LruRecordAccess) { this->testLruRecordAccess(); }
+TYPED_TEST(BaseAllocatorTest, LruRecordAccess) {
+  if constexpr (!kIsClock<TypeParam>) {
+    this->testLruRecordAccess();
+  }
+}
 
 TYPED_TEST(BaseAllocatorTest, ApplyAll) { this->testApplyAll(); }
 
@@ -147,6 +164,10 @@ TYPED_TEST(BaseAllocatorTest, IterateWithEvictions) {
 
 TYPED_TEST(BaseAllocatorTest, IOBufItemHandle) { this->testIOBufItemHandle(); }
 
+TYPED_TEST(BaseAllocatorTest, ValueCompression) {
+  this->testValueCompression();
+}
+
 TYPED_TEST(BaseAllocatorTest, IOBufSharedItemHandle) {
   this->testIOBufSharedItemHandleWithChainedItems();
 }
@@ -240,6 +261,10 @@ TYPED_TEST(BaseAllocatorTest, BasicFreeMemStrategy) {
 
 TYPED_TEST(BaseAllocatorTest, AllocSizes) { this->testAllocSizes(); }
 
+TYPED_TEST(BaseAllocatorTest, AddAllocationClasses) {
+  this->testAddAllocationClasses();
+}
+
 TYPED_TEST(BaseAllocatorTest, CacheCreationTime) {
   this->testCacheCreationTime();
 }
@@ -339,7 +364,9 @@ TYPED_TEST(BaseAllocatorTest, StatsChainCountRestore) {
 }
 
 TYPED_TEST(BaseAllocatorTest, EvictionAgeStats) {
-  this->testEvictionAgeStats();
+  if constexpr (!kIsClock<TypeParam>) {
+    this->testEvictionAgeStats();
+  }
 }
 
 TYPED_TEST(BaseAllocatorTest, ReplaceInMMContainer) {
@@ -406,6 +433,9 @@ namespace { // the tests that cannot be done by TYPED_TEST.
 using LruAllocatorTest = BaseAllocatorTest<LruAllocator>;
 using Lru2QAllocatorTest = BaseAllocatorTest<Lru2QAllocator>;
 using TinyLFUAllocatorTest = BaseAllocatorTest<TinyLFUAllocator>;
+using ClockAllocatorTest = BaseAllocatorTest<ClockAllocator>;
+using LruAllocatorTagHashTableTest =
+    BaseAllocatorTest<LruAllocatorTagHashTable>;
 
 // test all the error scenarios with respect to allocating a new key where it
 // is not accessible right away.
@@ -425,6 +455,10 @@ TEST_F(TinyLFUAllocatorTest, AllocateInAccessible) {
   TinyLFUAllocator::MMConfig config;
   testAllocateInAccessible(config);
 }
+TEST_F(ClockAllocatorTest, AllocateInAccessible) {
+  ClockAllocator::MMConfig config;
+  testAllocateInAccessible(config);
+}
 
 TEST_F(LruAllocatorTest, EvictionSearchLimit) {
   LruAllocator::MMConfig config;
@@ -441,6 +475,10 @@ TEST_F(TinyLFUAllocatorTest, EvictionSearchLimit) {
   config.tinySizePercent = 0;
   testEvictionSearchLimit(config);
 }
+TEST_F(ClockAllocatorTest, EvictionSearchLimit) {
+  ClockAllocator::MMConfig config;
+  testEvictionSearchLimit(config);
+}
 
 // create some allocation and hold the references to them. These allocations
 // should not be ever evicted. removing the keys while we have handle should
@@ -462,6 +500,10 @@ TEST_F(TinyLFUAllocatorTest, RefCountEvictCB) {
   TinyLFUAllocator::MMConfig config;
   testRefCountEvictCB(config);
 }
+TEST_F(ClockAllocatorTest, RefCountEvictCB) {
+  ClockAllocator::MMConfig config;
+  testRefCountEvictCB(config);
+}
 
 TEST_F(Lru2QAllocatorTest, SerializationMMConfigExtra) {
   testSerializationMMConfigExtra();
@@ -477,6 +519,7 @@ TEST_F(TinyLFUAllocatorTest, Stats) { this->testStats(false); }
 TEST_F(LruAllocatorTest, MoveItem) { this->testMoveItem(true); }
 TEST_F(Lru2QAllocatorTest, MoveItem) { this->testMoveItem(true); }
 TEST_F(TinyLFUAllocatorTest, MoveItem) { this->testMoveItem(false); }
+TEST_F(ClockAllocatorTest, MoveItem) { this->testMoveItem(false); }
 
 // Try moving a single item from one slab to another while a separate thread
 // has a ref count to the slab to be released for some time. This tests the
@@ -490,6 +533,9 @@ TEST_F(Lru2QAllocatorTest, MoveItemWithRetry) {
 TEST_F(TinyLFUAllocatorTest, MoveItemWithRetry) {
   this->testMoveItemRetryWithRefCount(false);
 }
+TEST_F(ClockAllocatorTest, MoveItemWithRetry) {
+  this->testMoveItemRetryWithRefCount(false);
+}
 
 // Test fragmentation size stats
 TEST_F(LruAllocatorTest, FragmentationSizeStat) {
@@ -501,6 +547,15 @@ TEST_F(Lru2QAllocatorTest, FragmentationSizeStat) {
 TEST_F(TinyLFUAllocatorTest, FragmentationSizeStat) {
   this->testFragmentationSize();
 }
+TEST_F(ClockAllocatorTest, FragmentationSizeStat) {
+  this->testFragmentationSize();
+}
+
+// Compact a sparsely used slab by moving its items
+TEST_F(LruAllocatorTest, SlabCompaction) { this->testSlabCompaction(); }
+TEST_F(Lru2QAllocatorTest, SlabCompaction) { this->testSlabCompaction(); }
+TEST_F(TinyLFUAllocatorTest, SlabCompaction) { this->testSlabCompaction(); }
+TEST_F(ClockAllocatorTest, SlabCompaction) { this->testSlabCompaction(); }
 
 // test automatic MMReconfigure behavior: lru refresh time update
 TEST_F(LruAllocatorTest, MMReconfigure) { this->testMMReconfigure(); }
@@ -512,6 +567,25 @@ TEST_F(Lru2QAllocatorTest, MMReconfigure) {
   this->testMM2QReconfigure(mmConfig);
 }
 
+// the allocator works the same with a TagHashTable as its access container,
+// including across a warm roll.
+TEST_F(LruAllocatorTagHashTableTest, AllocateAccessible) {
+  this->testAllocateAccessible();
+}
+TEST_F(LruAllocatorTagHashTableTest, Find) { this->testFind(); }
+TEST_F(LruAllocatorTagHashTableTest, FindBatch) { this->testFindBatch(); }
+TEST_F(LruAllocatorTagHashTableTest, Remove) { this->testRemove(); }
+TEST_F(LruAllocatorTagHashTableTest, Evictions) { this->testEvictions(); }
+TEST_F(LruAllocatorTagHashTableTest, Serialization) {
+  this->testSerialization();
+}
+TEST_F(LruAllocatorTagHashTableTest, AccessContainerOverflowWarmRoll) {
+  this->testAccessContainerOverflowWarmRoll();
+}
+TEST_F(LruAllocatorTest, AccessContainerOverflowWarmRoll) {
+  this->testAccessContainerOverflowWarmRoll();
+}
+
 } // namespace
 
 } // end of namespace tests
@@ -793,6 +793,105 @@ class BaseAllocatorTest : public AllocatorTest<AllocatorT> {
     }
   }
 
+  // batched lookups should return the same result as individual finds and
+  // account for hits and misses the same way.
+  void testFindBatch() {
+    typename AllocatorT::Config config;
+    config.setCacheSize(100 * Slab::kSize);
+
+    AllocatorT alloc(config);
+    const size_t numBytes = alloc.getCacheMemoryStats().cacheSize;
+    auto poolId = alloc.addPool("foobar", numBytes);
+
+    std::vector<std::string> keyStrs;
+    for (unsigned int i = 0; i < 200; i++) {
+      auto key = folly::sformat("key_{}", i);
+      // only insert every other key so that half of the batch misses.
+      if (i % 2 == 0) {
+        auto handle = util::allocateAccessible(alloc, poolId, key, 100);
+        ASSERT_NE(handle, nullptr);
+      }
+      keyStrs.push_back(std::move(key));
+    }
+
+    std::vector<typename AllocatorT::Key> keys;
+    for (const auto& key : keyStrs) {
+      keys.push_back(folly::StringPiece{key});
+    }
+
+    const auto statsBefore = alloc.getGlobalCacheStats();
+    auto handles = alloc.findBatch({keys.data(), keys.size()});
+    const auto statsAfter = alloc.getGlobalCacheStats();
+
+    ASSERT_EQ(keys.size(), handles.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (i % 2 == 0) {
+        ASSERT_NE(handles[i], nullptr);
+        ASSERT_EQ(handles[i]->getKey(), keys[i]);
+      } else {
+        ASSERT_EQ(handles[i], nullptr);
+      }
+    }
+    ASSERT_EQ(statsBefore.numCacheGets + keys.size(), statsAfter.numCacheGets);
+    ASSERT_EQ(statsBefore.numCacheGetMiss + keys.size() / 2,
+              statsAfter.numCacheGetMiss);
+  }
+
+  // insert far more items than the access container has buckets for, so
+  // that most lookups go through the chains of the buckets, and make sure
+  // that the items are found before and after a warm roll.
+  void testAccessContainerOverflowWarmRoll() {
+    typename AllocatorT::Config config;
+    config.setCacheSize(20 * Slab::kSize);
+    config.setAccessConfig(typename AllocatorT::AccessConfig{
+        8 /* bucketsPower */, 4 /* locksPower */});
+    config.enableCachePersistence(this->cacheDir_);
+
+    const unsigned int numItems = 10000;
+    std::vector<std::string> keyStrs;
+    auto checkItems = [&](AllocatorT& alloc) {
+      std::vector<typename AllocatorT::Key> keys;
+      for (unsigned int i = 0; i < numItems; i++) {
+        auto handle = alloc.find(keyStrs[i]);
+        // every third item was removed
+        if (i % 3 == 0) {
+          ASSERT_EQ(nullptr, handle);
+        } else {
+          ASSERT_NE(nullptr, handle);
+          ASSERT_EQ(keyStrs[i], handle->getKey());
+        }
+        keys.push_back(folly::StringPiece{keyStrs[i]});
+      }
+
+      auto handles = alloc.findBatch({keys.data(), keys.size()});
+      ASSERT_EQ(keys.size(), handles.size());
+      for (unsigned int i = 0; i < numItems; i++) {
+        ASSERT_EQ(i % 3 != 0, handles[i] != nullptr);
+      }
+    };
+
+    {
+      AllocatorT alloc(AllocatorT::SharedMemNew, config);
+      const size_t numBytes = alloc.getCacheMemoryStats().cacheSize;
+      auto poolId = alloc.addPool("foobar", numBytes);
+      for (unsigned int i = 0; i < numItems; i++) {
+        keyStrs.push_back(folly::sformat("key_{}", i));
+        ASSERT_NE(nullptr,
+                  util::allocateAccessible(alloc, poolId, keyStrs[i], 100));
+      }
+      for (unsigned int i = 0; i < numItems; i += 3) {
+        ASSERT_EQ(AllocatorT::RemoveRes::kSuccess, alloc.remove(keyStrs[i]));
+      }
+      checkItems(alloc);
+      ASSERT_EQ(AllocatorT::ShutDownStatus::kSuccess, alloc.shutDown());
+    }
+
+    {
+      AllocatorT alloc(AllocatorT::SharedMemAttach, config);
+      checkItems(alloc);
+    }
+  }
+
   // make some allocations without evictions, remove them and ensure that they
   // cannot be accessed through find.
   void testRemove() {
@@ -2119,6 +2218,93 @@ class BaseAllocatorTest : public AllocatorTest<AllocatorT> {
     }
   }
 
+  // Values allocated with allocateCompressed are stored compressed in a
+  // pool with value compression, keep the flag when a slab release moves
+  // them, and read back uncompressed through convertToIOBuf.
+  void testValueCompression() {
+    typename AllocatorT::Config config;
+    config.enableMovingOnSlabRelease(
+        [](typename AllocatorT::Item& oldItem,
+           typename AllocatorT::Item& newItem,
+           typename AllocatorT::Item* /* parentPtr */) {
+          memcpy(newItem.getMemory(), oldItem.getMemory(), oldItem.getSize());
+        });
+    ValueCompressor::Config compression;
+    compression.minSize = 512;
+    config.enableValueCompression("compressed", compression);
+    config.setCacheSize(10 * Slab::kSize);
+    AllocatorT alloc(config);
+    const size_t numBytes = alloc.getCacheMemoryStats().cacheSize;
+    auto poolId = alloc.addPool("compressed", numBytes / 2);
+    auto plainPoolId = alloc.addPool("plain", numBytes / 2);
+
+    const std::string value(8 * 1024, 'a');
+    std::string randomValue(8 * 1024, 0);
+    for (auto& c : randomValue) {
+      c = static_cast<char>(folly::Random::rand32());
+    }
+    const auto readValue = [&alloc](const std::string& key) {
+      auto handle = alloc.find(key);
+      EXPECT_NE(nullptr, handle);
+      auto ioBuf = alloc.convertToIOBuf(std::move(handle));
+      return ioBuf.moveToFbString().toStdString();
+    };
+
+    {
+      auto handle =
+          alloc.allocateCompressed(poolId, "key", folly::StringPiece(value));
+      ASSERT_NE(nullptr, handle);
+      ASSERT_TRUE(handle->isValueCompressed());
+      ASSERT_LT(handle->getSize(), value.size());
+      alloc.insertOrReplace(handle);
+
+      // a chained item can not be added to a compressed item
+      auto chained = alloc.allocateChainedItem(handle, 100);
+      ASSERT_NE(nullptr, chained);
+      ASSERT_THROW(alloc.addChainedItem(handle, std::move(chained)),
+                   std::invalid_argument);
+    }
+    {
+      // incompressible values and pools without compression store the
+      // value as is
+      auto randomHandle = alloc.allocateCompressed(
+          poolId, "random", folly::StringPiece(randomValue));
+      ASSERT_NE(nullptr, randomHandle);
+      ASSERT_FALSE(randomHandle->isValueCompressed());
+      alloc.insertOrReplace(randomHandle);
+
+      auto plainHandle = alloc.allocateCompressed(plainPoolId, "plain",
+                                                  folly::StringPiece(value));
+      ASSERT_NE(nullptr, plainHandle);
+      ASSERT_FALSE(plainHandle->isValueCompressed());
+      ASSERT_EQ(value.size(), plainHandle->getSize());
+      alloc.insertOrReplace(plainHandle);
+    }
+
+    ASSERT_EQ(value, readValue("key"));
+    ASSERT_EQ(randomValue, readValue("random"));
+    ASSERT_EQ(value, readValue("plain"));
+
+    const auto stats = alloc.getValueCompressionStats(poolId);
+    ASSERT_EQ(1, stats.numCompressed);
+    ASSERT_EQ(1, stats.numSkippedRatio);
+    ASSERT_EQ(1, stats.numUncompressed);
+    ASSERT_EQ(0, alloc.getValueCompressionStats(plainPoolId).numCompressed);
+
+    // release the slab of the compressed item, which moves it
+    void* oldMemory = alloc.findInternal("key").get();
+    const auto allocInfo = alloc.getAllocInfo(oldMemory);
+    alloc.releaseSlab(allocInfo.poolId, allocInfo.classId,
+                      SlabReleaseMode::kRebalance, oldMemory);
+    {
+      auto handle = alloc.find("key");
+      ASSERT_NE(nullptr, handle);
+      ASSERT_NE(oldMemory, handle.get());
+      ASSERT_TRUE(handle->isValueCompressed());
+    }
+    ASSERT_EQ(value, readValue("key"));
+  }
+
   void testIOBufSharedItemHandleWithChainedItems() {
     std::atomic<int> itemsRemoved{0};
     auto removeCb = [&itemsRemoved](const typename AllocatorT::RemoveCbData&) {
@@ -3497,6 +3683,103 @@ class BaseAllocatorTest : public AllocatorTest<AllocatorT> {
     ASSERT_EQ(current, fragmentationForOneSmallItem + fragmentationForOneItem);
   }
 
+  // The slab compactor empties a sparsely used slab by moving its items into
+  // the free allocations of the other slabs of the class. Nothing is
+  // evicted and the slab goes back to the pool.
+  void testSlabCompaction() {
+    const int numSlabs = 4;
+    typename AllocatorT::Config config;
+    config.enableMovingOnSlabRelease(
+        [](typename AllocatorT::Item& oldItem,
+           typename AllocatorT::Item& newItem,
+           typename AllocatorT::Item* /* parentPtr */) {
+          memcpy(newItem.getMemory(), oldItem.getMemory(), oldItem.getSize());
+        });
+    config.enableSlabCompaction(std::chrono::milliseconds{10},
+                                1 /* slabsPerIteration */,
+                                50 /* minFreePercent */);
+    config.setCacheSize((numSlabs + 1) * Slab::kSize);
+    AllocatorT allocator(config);
+    const size_t numBytes = allocator.getCacheMemoryStats().cacheSize;
+    const size_t kAllocSize = 16 * 1024, kItemSize = 1024;
+    auto poolId = allocator.addPool("default", numBytes, {kAllocSize});
+    const size_t itemsPerSlab = Slab::kSize / kAllocSize;
+
+    // fill three slabs. The content of an item is derived from its key.
+    const size_t numItems = 3 * itemsPerSlab;
+    auto getKey = [](size_t i) { return folly::sformat("key_{}", i); };
+    auto getSlab = [](const void* item) {
+      return reinterpret_cast<uintptr_t>(item) / Slab::kSize;
+    };
+    std::map<uintptr_t, std::vector<size_t>> itemsBySlab;
+    uintptr_t currSlab = 0;
+    for (size_t i = 0; i < numItems; i++) {
+      auto handle =
+          util::allocateAccessible(allocator, poolId, getKey(i), kItemSize);
+      ASSERT_NE(nullptr, handle);
+      std::memset(handle->getMemory(), static_cast<int>(i % 256), kItemSize);
+      currSlab = getSlab(handle.get());
+      itemsBySlab[currSlab].push_back(i);
+    }
+    ASSERT_EQ(3, itemsBySlab.size());
+
+    // free 3/4 of one slab, then half of another one. Neither is the current
+    // slab of the class. Together that is more than a slab. The first one
+    // is the sparsest whenever the compactor gets to run.
+    std::vector<uintptr_t> slabs;
+    for (const auto& [slab, items] : itemsBySlab) {
+      if (slab != currSlab) {
+        slabs.push_back(slab);
+      }
+    }
+    const uintptr_t sparsest = slabs[0];
+    std::set<size_t> removed;
+    auto removeItems = [&](uintptr_t slab, size_t num) {
+      for (size_t j = 0; j < num; j++) {
+        const auto i = itemsBySlab[slab][j];
+        ASSERT_EQ(AllocatorT::RemoveRes::kSuccess,
+                  allocator.remove(getKey(i)));
+        removed.insert(i);
+      }
+    };
+    removeItems(slabs[0], itemsPerSlab * 3 / 4);
+    removeItems(slabs[1], itemsPerSlab / 2);
+
+    for (int i = 0;
+         i < 500 && allocator.getSlabCompactorStats().numSlabsCompacted == 0;
+         i++) {
+      /* sleep override */
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(allocator.stopSlabCompactor());
+    ASSERT_EQ(1, allocator.getSlabCompactorStats().numSlabsCompacted);
+
+    // the items of the sparsest slab were moved, not evicted.
+    const auto releaseStats = allocator.getSlabReleaseStats();
+    ASSERT_EQ(0, releaseStats.numEvictionSuccesses);
+    ASSERT_EQ(itemsPerSlab - itemsPerSlab * 3 / 4,
+              releaseStats.numMoveSuccesses);
+    for (size_t i = 0; i < numItems; i++) {
+      auto handle = allocator.find(getKey(i));
+      if (removed.count(i)) {
+        ASSERT_EQ(nullptr, handle);
+        continue;
+      }
+      ASSERT_NE(nullptr, handle);
+      ASSERT_NE(sparsest, getSlab(handle.get()));
+      const auto* data = reinterpret_cast<const uint8_t*>(handle->getMemory());
+      for (size_t j = 0; j < kItemSize; j++) {
+        ASSERT_EQ(i % 256, data[j]);
+      }
+    }
+
+    // the class is down to two slabs and the emptied one is back in the pool.
+    const auto poolStats = allocator.getPoolStats(poolId);
+    ASSERT_EQ(1, poolStats.mpStats.acStats.size());
+    ASSERT_EQ(2, poolStats.mpStats.acStats.begin()->second.totalSlabs());
+    ASSERT_EQ(numItems - removed.size(), poolStats.numItems());
+  }
+
   using ReleaseSlabFunc =
       std::function<void(AllocatorT&, const AllocInfo&, void*)>;
   void testMoveItemHelper(bool testEviction, ReleaseSlabFunc releaseSlabFunc) {
@@ -4026,6 +4309,87 @@ class BaseAllocatorTest : public AllocatorTest<AllocatorT> {
     ASSERT_NO_THROW(allocator.addPool("default", numBytes, goodAllocSizes));
   }
 
+  // add an allocation class that fits the allocated sizes to a full pool,
+  // give it a slab through the rebalancer and make sure it survives a warm
+  // roll.
+  void testAddAllocationClasses() {
+    typename AllocatorT::Config config;
+    config.setCacheSize(10 * Slab::kSize);
+    config.enableAllocSizeHistogram(1);
+    config.enableCachePersistence(this->cacheDir_);
+
+    const unsigned int keyLen = 100;
+    const uint32_t valLen = 1000;
+    PoolId pid;
+    ClassId oldCid;
+    ClassId newCid;
+    uint32_t newSize;
+    std::vector<std::string> keys;
+    {
+      AllocatorT alloc(AllocatorT::SharedMemNew, config);
+      const size_t numBytes = alloc.getCacheMemoryStats().cacheSize;
+      pid = alloc.addPool("foobar", numBytes, {2048, Slab::kSize});
+      this->fillUpPoolUntilEvictions(alloc, pid, {valLen}, keyLen);
+      oldCid = alloc.getPool(pid).getAllocationClassId(2048);
+
+      const auto wasted = alloc.getAllocSizeWastedFraction(pid);
+      const auto allocSizes = alloc.proposeAllocSizes(pid, 1);
+      ASSERT_EQ(1, allocSizes.size());
+      newSize = *allocSizes.begin();
+      ASSERT_LT(newSize, 2048);
+
+      const auto cids = alloc.addAllocationClasses(pid, allocSizes);
+      ASSERT_EQ(std::vector<ClassId>{2}, cids);
+      newCid = cids[0];
+      ASSERT_EQ(newSize, alloc.getPool(pid).getAllocationClass(newCid)
+                             .getAllocSize());
+      ASSERT_LT(alloc.getAllocSizeWastedFraction(pid), wasted);
+
+      // sizes the pool has are skipped and invalid ones add nothing
+      ASSERT_TRUE(alloc.addAllocationClasses(pid, allocSizes).empty());
+      ASSERT_THROW(alloc.addAllocationClasses(pid, {1024, Slab::kSize + 1}),
+                   std::invalid_argument);
+      ASSERT_EQ(3, alloc.getPool(pid).getNumClassId());
+
+      // the new class starts without slabs and gets one from the old class
+      ASSERT_EQ(0, alloc.getPoolStats(pid).mpStats.acStats.at(newCid)
+                       .totalSlabs());
+      alloc.releaseSlab(pid, oldCid, newCid, SlabReleaseMode::kRebalance);
+      ASSERT_EQ(1, alloc.getPoolStats(pid).mpStats.acStats.at(newCid)
+                       .totalSlabs());
+
+      for (unsigned int i = 0; i < Slab::kSize / newSize; i++) {
+        const auto key = this->getRandomNewKey(alloc, keyLen);
+        auto handle = util::allocateAccessible(alloc, pid, key, valLen);
+        ASSERT_NE(nullptr, handle);
+        ASSERT_EQ(newCid, alloc.getAllocInfo(handle->getMemory()).classId);
+        keys.push_back(key);
+      }
+      ASSERT_EQ(AllocatorT::ShutDownStatus::kSuccess, alloc.shutDown());
+    }
+
+    // the classes and the items in them are restored
+    {
+      AllocatorT alloc(AllocatorT::SharedMemAttach, config);
+      const auto& pool = alloc.getPool(pid);
+      ASSERT_EQ(3, pool.getNumClassId());
+      ASSERT_EQ(newSize, pool.getAllocationClass(newCid).getAllocSize());
+      ASSERT_EQ(newCid, pool.getAllocationClassId(newSize));
+      for (const auto& key : keys) {
+        auto handle = alloc.find(key);
+        ASSERT_NE(nullptr, handle);
+        ASSERT_EQ(newCid, alloc.getAllocInfo(handle->getMemory()).classId);
+      }
+
+      // a full class evicts from its own restored MMContainer
+      const auto key = this->getRandomNewKey(alloc, keyLen);
+      auto handle = util::allocateAccessible(alloc, pid, key, valLen);
+      ASSERT_NE(nullptr, handle);
+      ASSERT_EQ(newCid, alloc.getAllocInfo(handle->getMemory()).classId);
+      ASSERT_EQ(1, alloc.getPoolStats(pid).cacheStats.at(newCid).numEvictions());
+    }
+  }
+
   // Check that item is in the expected container.
   bool findItem(AllocatorT& allocator, typename AllocatorT::Item* item) {
     auto& container = allocator.getMMContainer(*item);
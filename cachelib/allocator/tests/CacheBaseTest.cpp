@@ -32,7 +32,11 @@ class CacheBaseTest : public CacheBase, public SlabAllocatorTestBase {
         memoryPool_(0, 1024, *slabAllocator_, {64}) {}
   const std::string getCacheName() const override { return cacheName; }
   const MemoryPool& getPool(PoolId) const override { return memoryPool_; }
+  const MemoryPool& getPoolByTid(PoolId, TierId) const override {
+    return memoryPool_;
+  }
   PoolStats getPoolStats(PoolId) const override { return PoolStats(); }
+  PoolStats getPoolStats(TierId, PoolId) const override { return PoolStats(); }
   AllSlabReleaseEvents getAllSlabReleaseEvents(PoolId) const override {
     return AllSlabReleaseEvents{};
   }
@@ -40,6 +44,11 @@ class CacheBaseTest : public CacheBase, public SlabAllocatorTestBase {
                                                unsigned int) const override {
     return PoolEvictionAgeStats();
   }
+  PoolEvictionAgeStats getPoolEvictionAgeStats(TierId,
+                                               PoolId,
+                                               unsigned int) const override {
+    return PoolEvictionAgeStats();
+  }
   std::unordered_map<std::string, uint64_t> getEventTrackerStatsMap()
       const override {
     return {};
@@ -49,6 +58,9 @@ class CacheBaseTest : public CacheBase, public SlabAllocatorTestBase {
   SlabReleaseStats getSlabReleaseStats() const override { return {}; }
   CacheMemoryStats getCacheMemoryStats() const override { return {}; }
   std::set<PoolId> getRegularPoolIdsForResize() const override { return {}; }
+  std::set<PoolId> getRegularPoolIdsForResize(TierId) const override {
+    return {};
+  }
   std::set<PoolId> getRegularPoolIds() const override { return {}; }
   std::set<PoolId> getCCachePoolIds() const override { return {}; }
   std::set<PoolId> getPoolIds() const override { return {}; }
@@ -60,6 +72,12 @@ class CacheBaseTest : public CacheBase, public SlabAllocatorTestBase {
   void releaseSlab(PoolId, ClassId, SlabReleaseMode, const void*) override {}
   void releaseSlab(
       PoolId, ClassId, ClassId, SlabReleaseMode, const void*) override {}
+  void releaseSlab(TierId,
+                   PoolId,
+                   ClassId,
+                   ClassId,
+                   SlabReleaseMode,
+                   const void*) override {}
   unsigned int reclaimSlabs(PoolId, size_t) override { return 0; }
   bool autoResizeEnabledForPool(PoolId) const override { return false; }
 
@@ -14,7 +14,15 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "cachelib/allocator/ChainedHashTable.h"
+#include "cachelib/allocator/memory/CompressedPtr.h"
 #include "cachelib/allocator/tests/AccessTypeTest.h"
 
 namespace facebook {
@@ -32,6 +40,127 @@ TEST(ChainedHashTableConfigTest, Size) {
   EXPECT_EQ(config.getLocksPower(), 11);
 }
 
+TEST(ChainedHashTableTagTest, CompressedPtr) {
+  for (uint32_t hash : {0u, 1u, 0x00ffffffu, 0x01000000u, 0xffffffffu}) {
+    EXPECT_NE(ChainedHashTable::kNoTag, ChainedHashTable::getTagForHash(hash));
+  }
+  EXPECT_EQ(0xab, ChainedHashTable::getTagForHash(0xab123456));
+
+  // the tag does not change where the pointer points to
+  const CompressedPtr ptr{CompressedPtr::SerializedPtrType{0x100001234}};
+  const auto tagged = ChainedHashTable::withTag(ptr, 0xab);
+  EXPECT_FALSE(ptr == tagged);
+  EXPECT_EQ(0xab, ChainedHashTable::getTag(tagged));
+  EXPECT_TRUE(ptr == ChainedHashTable::withoutTag(tagged));
+  EXPECT_EQ(ChainedHashTable::kNoTag, ChainedHashTable::getTag(ptr));
+  EXPECT_TRUE(ptr == ChainedHashTable::withoutTag(ptr));
+
+  // null pointers are never tagged
+  const auto null = ChainedHashTable::withTag(CompressedPtr{}, 0xab);
+  EXPECT_TRUE(null.isNull());
+  EXPECT_EQ(ChainedHashTable::kNoTag, ChainedHashTable::getTag(null));
+
+  // only the pointers with the key's tag match, unless the lookup has none
+  EXPECT_TRUE(ChainedHashTable::tagsMayMatch(tagged, 0xab));
+  EXPECT_FALSE(ChainedHashTable::tagsMayMatch(tagged, 0xac));
+  EXPECT_TRUE(
+      ChainedHashTable::tagsMayMatch(tagged, ChainedHashTable::kNoTag));
+
+  // plain pointers carry no tag and match every key
+  int node = 0;
+  EXPECT_TRUE(ChainedHashTable::tagsMayMatch(&node, 0xab));
+}
+
+namespace {
+// A node linked by compressed pointers, which carry tags. The pointers hold
+// the index of the node in a vector.
+struct TaggedNode {
+  using Key = KAllocation::Key;
+  using Handle = TaggedNode*;
+  using HandleMaker = std::function<Handle(TaggedNode*)>;
+  using CompressedPtr = facebook::cachelib::CompressedPtr;
+
+  struct PtrCompressor {
+    CompressedPtr compress(const TaggedNode* node) const {
+      if (node == nullptr) {
+        return CompressedPtr{};
+      }
+      return CompressedPtr{
+          static_cast<CompressedPtr::SerializedPtrType>(node - nodes->data())};
+    }
+
+    TaggedNode* unCompress(CompressedPtr ptr) const {
+      return ptr.isNull() ? nullptr : &(*nodes)[ptr.getRaw()];
+    }
+
+    std::vector<TaggedNode>* nodes{nullptr};
+  };
+
+  explicit TaggedNode(std::string key) : key_(std::move(key)) {}
+
+  Key getKey() const { return {key_.data(), key_.length()}; }
+  bool isAccessible() const noexcept { return accessible_; }
+  void markAccessible() noexcept { accessible_ = true; }
+  void unmarkAccessible() noexcept { accessible_ = false; }
+  std::string toString() const { return key_; }
+
+  ChainedHashTable::Hook<TaggedNode> hook_;
+  std::string key_;
+  bool accessible_{false};
+};
+
+using TaggedContainer =
+    ChainedHashTable::Container<TaggedNode, &TaggedNode::hook_>;
+} // namespace
+
+// Tagged pointers survive a save and restore of the table.
+TEST(ChainedHashTableTagTest, RestoreTaggedTable) {
+  const ChainedHashTable::Config config{4 /* bucketsPower */,
+                                        2 /* locksPower */};
+  const auto numBuckets = config.getNumBuckets();
+  std::vector<CompressedPtr> buckets(numBuckets);
+  const auto handleMaker = [](TaggedNode* node) { return node; };
+
+  constexpr int kNumNodes = 200;
+  std::vector<TaggedNode> nodes;
+  // the pointers are indexes in the vector, so it must not move
+  nodes.reserve(2 * kNumNodes);
+  TaggedNode::PtrCompressor compressor{&nodes};
+  for (int i = 0; i < kNumNodes; i++) {
+    nodes.emplace_back(folly::sformat("key {}", i));
+  }
+
+  serialization::ChainedHashTableObject state;
+  {
+    TaggedContainer c{config, buckets.data(), compressor, handleMaker};
+    for (auto& node : nodes) {
+      ASSERT_TRUE(c.insert(node));
+    }
+    state = c.saveState();
+  }
+
+  TaggedContainer c{state, config, buckets.data(),
+                    numBuckets * sizeof(CompressedPtr), compressor,
+                    handleMaker};
+  for (auto& node : nodes) {
+    EXPECT_EQ(&node, c.find(node.getKey()));
+  }
+  EXPECT_EQ(nullptr, c.find(folly::StringPiece{"missing key"}));
+
+  // new nodes are chained in front of the restored ones
+  for (int i = kNumNodes; i < 2 * kNumNodes; i++) {
+    nodes.emplace_back(folly::sformat("key {}", i));
+    ASSERT_TRUE(c.insert(nodes.back()));
+  }
+  for (int i = 0; i < 2 * kNumNodes; i += 2) {
+    ASSERT_TRUE(c.remove(nodes[i]));
+  }
+  for (int i = 0; i < 2 * kNumNodes; i++) {
+    EXPECT_EQ(i % 2 == 0 ? nullptr : &nodes[i], c.find(nodes[i].getKey()));
+  }
+  EXPECT_EQ(kNumNodes, c.getNumKeys());
+}
+
 TEST_F(ChainedHashTest, Insert) { testInsert(); }
 
 TEST_F(ChainedHashTest, Replace) { testReplace(); }
@@ -40,6 +169,8 @@ TEST_F(ChainedHashTest, Remove) { testRemove(); }
 
 TEST_F(ChainedHashTest, Find) { testFind(); }
 
+TEST_F(ChainedHashTest, FindBatch) { testFindBatch(); }
+
 TEST_F(ChainedHashTest, HandleIteration) {
   testHandleIterationWithExceptions();
 }
@@ -261,6 +392,223 @@ TEST_F(ChainedHashTest, IteratorWithThrottler) {
   ASSERT_EQ(existingKeys, visitedKeys);
   ASSERT_TRUE((time1 > time2 * 5));
 }
+
+TEST_F(ChainedHashTest, Resize) {
+  using HashConfig = ChainedHashTable::Config;
+  HashConfig config{5, 3};
+  Container c{config, typename Node::PtrCompressor()};
+
+  std::vector<std::unique_ptr<Node>> nodes;
+  std::set<std::string> existingKeys;
+  auto insertNodes = [&](unsigned int numNodes) {
+    for (unsigned int i = 0; i < numNodes; i++) {
+      auto key = getRandomNewKey(c);
+      nodes.emplace_back(new Node(key));
+      ASSERT_TRUE(c.insert(*nodes.back()));
+      existingKeys.insert(key);
+    }
+  };
+  auto checkNodes = [&]() {
+    for (const auto& node : nodes) {
+      ASSERT_EQ(node.get(), c.find(node->getKey()).get());
+    }
+    ASSERT_EQ(existingKeys, iterateAndGetKeys(c));
+    ASSERT_EQ(nodes.size(), c.getNumKeys());
+  };
+  insertNodes(1000);
+
+  ASSERT_THROW(c.startResize(5), std::invalid_argument);
+  ASSERT_THROW(c.startResize(33), std::invalid_argument);
+  // user managed memory for a hash table that manages its own
+  ASSERT_THROW(c.startResize(8, [](uint32_t, size_t) { return nullptr; }),
+               std::invalid_argument);
+
+  c.startResize(8);
+  ASSERT_TRUE(c.isResizing());
+  ASSERT_THROW(c.startResize(9), std::invalid_argument);
+  ASSERT_EQ(5u, c.getHashpower());
+  checkNodes();
+
+  // half way through the buckets, keys are split between both tables.
+  ASSERT_FALSE(c.rehashStep(16));
+  checkNodes();
+
+  // an iterator started before the resize finishes still visits every key.
+  const auto keysBefore = existingKeys;
+  std::set<std::string> visitedKeys;
+  auto it = c.begin();
+  // some of the inserts migrate buckets, finishing the resize.
+  for (int i = 0; i < 1000 && c.isResizing(); ++i) {
+    insertNodes(1);
+  }
+  ASSERT_FALSE(c.isResizing());
+  for (; it != c.end(); ++it) {
+    visitedKeys.insert(it->getKey().str());
+  }
+  ASSERT_TRUE(std::includes(visitedKeys.begin(), visitedKeys.end(),
+                            keysBefore.begin(), keysBefore.end()));
+  ASSERT_TRUE(std::includes(existingKeys.begin(), existingKeys.end(),
+                            visitedKeys.begin(), visitedKeys.end()));
+
+  ASSERT_EQ(8u, c.getHashpower());
+  ASSERT_EQ(1 << 8, c.getStats().numBuckets);
+  ASSERT_EQ(1u, c.getTableGeneration());
+  ASSERT_TRUE(c.rehashStep(1));
+  checkNodes();
+
+  for (auto& node : nodes) {
+    ASSERT_TRUE(c.remove(*node));
+  }
+  ASSERT_EQ(0, c.getNumKeys());
+}
+
+// Inserts and lookups racing with two resizes, the second of which frees
+// the table replaced by the first one.
+TEST_F(ChainedHashTest, ConcurrentResize) {
+  using HashConfig = ChainedHashTable::Config;
+  Container c{HashConfig{5, 3}, typename Node::PtrCompressor()};
+
+  constexpr int kNumThreads = 4;
+  constexpr int kNodesPerThread = 5000;
+  std::vector<std::unique_ptr<Node>> existing;
+  for (int i = 0; i < 2000; ++i) {
+    existing.emplace_back(new Node(folly::sformat("existing_{}", i)));
+    ASSERT_TRUE(c.insert(*existing.back()));
+  }
+  std::vector<std::vector<std::unique_ptr<Node>>> inserted(kNumThreads);
+  for (int t = 0; t < kNumThreads; ++t) {
+    for (int i = 0; i < kNodesPerThread; ++i) {
+      inserted[t].emplace_back(new Node(folly::sformat("new_{}_{}", t, i)));
+    }
+  }
+
+  std::atomic<bool> done{false};
+  std::atomic<uint64_t> numMisses{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    // inserts and finds back its own keys.
+    threads.emplace_back([&, t]() {
+      for (auto& node : inserted[t]) {
+        if (!c.insert(*node) || c.find(node->getKey()).get() != node.get()) {
+          ++numMisses;
+        }
+      }
+    });
+    // looks up the keys that were there before the resizes.
+    threads.emplace_back([&, t]() {
+      std::vector<Node::Key> keys;
+      while (!done) {
+        for (size_t i = t; i < existing.size(); i += kNumThreads) {
+          if (c.find(existing[i]->getKey()).get() != existing[i].get()) {
+            ++numMisses;
+          }
+          keys.push_back(existing[i]->getKey());
+          if (keys.size() == 16) {
+            const auto handles = c.findBatch({keys.data(), keys.size()});
+            for (const auto& handle : handles) {
+              if (handle == nullptr) {
+                ++numMisses;
+              }
+            }
+            keys.clear();
+          }
+        }
+      }
+    });
+  }
+
+  std::vector<uint32_t> released;
+  const auto releaseMemory = [&](uint32_t generation) {
+    released.push_back(generation);
+  };
+  for (unsigned int bucketsPower : {8u, 11u}) {
+    c.startResize(bucketsPower, nullptr, releaseMemory);
+    while (!c.rehashStep(4, releaseMemory)) {
+    }
+  }
+  done = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(0, numMisses.load());
+  ASSERT_EQ(11u, c.getHashpower());
+  ASSERT_EQ(2u, c.getTableGeneration());
+  ASSERT_EQ((std::vector<uint32_t>{0, 1}), released);
+  ASSERT_EQ(existing.size() + kNumThreads * kNodesPerThread, c.getNumKeys());
+  for (const auto& node : existing) {
+    ASSERT_EQ(node.get(), c.find(node->getKey()).get());
+  }
+  for (const auto& nodes : inserted) {
+    for (const auto& node : nodes) {
+      ASSERT_EQ(node.get(), c.find(node->getKey()).get());
+    }
+  }
+}
+
+TEST_F(ChainedHashTest, ResizeSerialization) {
+  using HashConfig = ChainedHashTable::Config;
+  HashConfig config{5, 3};
+  const unsigned int newBucketsPower = 7;
+
+  // memory of the buckets per generation of the table
+  std::vector<std::vector<CompressedPtr>> memory;
+  memory.emplace_back(config.getNumBuckets());
+  memory.emplace_back(static_cast<size_t>(1) << newBucketsPower);
+  auto getMemory = [&](uint32_t generation) {
+    auto& mem = memory.at(generation);
+    return ShmAddr{mem.data(), mem.size() * sizeof(CompressedPtr)};
+  };
+
+  auto c1 = std::make_unique<Container>(config, memory[0].data(),
+                                        typename Node::PtrCompressor());
+  auto nodes = createSimpleContainer(*c1);
+  ASSERT_THROW(c1->startResize(newBucketsPower), std::invalid_argument);
+  c1->startResize(newBucketsPower,
+                  [&](uint32_t generation, size_t nBytes) -> void* {
+                    EXPECT_EQ(1u, generation);
+                    EXPECT_EQ(getMemory(generation).size, nBytes);
+                    return getMemory(generation).addr;
+                  });
+  ASSERT_FALSE(c1->rehashStep(10));
+  auto state = c1->saveState();
+  c1.reset();
+
+  // a resize in progress needs the memory of both tables.
+  ASSERT_THROW(Container(state, config, memory[0].data(),
+                         memory[0].size() * sizeof(CompressedPtr),
+                         typename Node::PtrCompressor()),
+               std::invalid_argument);
+  // the bucket power of the config stays the one the table was created with
+  ASSERT_THROW(Container(state, HashConfig{newBucketsPower, 3}, getMemory,
+                         typename Node::PtrCompressor()),
+               std::invalid_argument);
+
+  auto c2 = std::make_unique<Container>(state, config, getMemory,
+                                        typename Node::PtrCompressor());
+  ASSERT_TRUE(c2->isResizing());
+  ASSERT_EQ(nodes.size(), c2->getNumKeys());
+  testSimpleInsertAndRemove(*c2, nodes);
+
+  ASSERT_TRUE(c2->rehashStep(config.getNumBuckets()));
+  ASSERT_EQ(newBucketsPower, c2->getHashpower());
+  state = c2->saveState();
+  c2.reset();
+
+  // once finished, only the memory of the new generation is used.
+  auto c3 = std::make_unique<Container>(
+      state, config,
+      [&](uint32_t generation) {
+        EXPECT_EQ(1u, generation);
+        return getMemory(generation);
+      },
+      typename Node::PtrCompressor());
+  ASSERT_FALSE(c3->isResizing());
+  ASSERT_EQ(newBucketsPower, c3->getHashpower());
+  for (const auto& node : nodes) {
+    ASSERT_EQ(node.get(), c3->find(node->getKey()).get());
+  }
+}
 } // namespace tests
 } // namespace cachelib
 } // namespace facebook
@@ -14,9 +14,15 @@
  * limitations under the License.
  */
 
+#include <folly/Portability.h>
+#include <folly/experimental/coro/Coroutine.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/synchronization/Baton.h>
 #include <gmock/gmock.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/BlockingWait.h>
+#include <folly/experimental/coro/Task.h>
+#endif
 
 #include <algorithm>
 #include <future>
@@ -248,6 +254,55 @@ TEST(ItemHandleTest, WaitContext_ready_immediate) {
   retCallback(std::move(hdl));
   EXPECT_TRUE(cbFired);
 }
+
+#if FOLLY_HAS_COROUTINES
+TEST(ItemHandleTest, WaitContext_coAwait) {
+  testing::NiceMock<TestAllocator> t;
+  TestItem k;
+  TestReadHandle hdl = t.getHandle();
+  auto waitContext = hdl.getItemWaitContext();
+
+  folly::Baton<> run;
+  auto thr = std::thread([&]() {
+    run.wait();
+    waitContext->set(t.acquire(&k));
+  });
+
+  auto task = [&]() -> folly::coro::Task<TestReadHandle> {
+    EXPECT_FALSE(hdl.isReady());
+    run.post();
+    co_return co_await std::move(hdl);
+  };
+  hdl = folly::coro::blockingWait(task());
+  thr.join();
+  EXPECT_TRUE(hdl.isReady());
+  EXPECT_EQ(&k, hdl.get());
+  hdl.reset();
+  waitContext.reset();
+
+  EXPECT_EQ(0, t.tlRef_.getSnapshot());
+}
+
+TEST(ItemHandleTest, WaitContext_coAwait_ready) {
+  testing::NiceMock<TestAllocator> t;
+  TestItem k;
+  auto hdl = t.getHandle();
+  t.setHandle(hdl, &k);
+  EXPECT_TRUE(hdl.isReady());
+
+  // awaiting a ready handle does not suspend, and a write handle is awaited
+  // as a write handle.
+  auto task = [&]() -> folly::coro::Task<TestItemHandle> {
+    co_return co_await std::move(hdl);
+  };
+  auto writeHandle = folly::coro::blockingWait(task());
+  EXPECT_EQ(&k, writeHandle.get());
+  EXPECT_EQ(nullptr, hdl.getItemWaitContext());
+  writeHandle.reset();
+
+  EXPECT_EQ(0, t.tlRef_.getSnapshot());
+}
+#endif
 } // namespace detail
 
 TEST(ItemHandleTest, Release) {
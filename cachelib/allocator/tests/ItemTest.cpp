@@ -61,6 +61,48 @@ TEST(ItemTest, CreationTime) {
   ASSERT_EQ(now, item->getCreationTime());
 }
 
+TEST(ItemTest, CompactItemTimes) {
+  using CompactItem = LruAllocatorCompactItem::Item;
+  static_assert(sizeof(Item) - sizeof(CompactItem) == 6,
+                "compact items keep 2 bytes of times instead of 8");
+
+  constexpr uint32_t bufferSize = 100;
+  char buffer[bufferSize];
+
+  const uint32_t valueSize = bufferSize / 2;
+
+  const folly::StringPiece key = "helloworld";
+  const uint32_t now = util::getCurrentTimeSec();
+  const auto granularity = CompactItemTimes::kGranularitySecs;
+
+  // the creation time is rounded down to the granularity and the expiry time
+  // is dropped.
+  auto item = new (buffer) CompactItem(key, valueSize, now, now + 600);
+  ASSERT_EQ(key, item->getKey());
+  ASSERT_EQ(now - now % granularity, item->getCreationTime());
+  ASSERT_EQ(0, item->getExpiryTime());
+  ASSERT_EQ(0, item->getConfiguredTTL().count());
+  ASSERT_FALSE(item->isExpired(now + 1200));
+
+  item->markInMMContainer();
+  ASSERT_FALSE(item->updateExpiryTime(now + 600));
+  ASSERT_EQ(0, item->getExpiryTime());
+  item->unmarkInMMContainer();
+
+  // older items are still read back as long as they are not older than the
+  // range of the creation time.
+  const uint32_t dayAgo = now - 24 * 3600;
+  item = new (buffer) CompactItem(key, valueSize, dayAgo, 0);
+  ASSERT_EQ(dayAgo - dayAgo % granularity, item->getCreationTime());
+
+  // once the item has a last access time, the creation time is read back
+  // relative to it, however long ago it was.
+  const uint32_t longAgo = now - 100 * 24 * 3600;
+  item = new (buffer) CompactItem(key, valueSize, longAgo, 0);
+  item->mmHook_.setUpdateTime(longAgo + 3600);
+  ASSERT_EQ(longAgo - longAgo % granularity, item->getCreationTime());
+}
+
 TEST(ItemTest, ExpiryTime) {
   constexpr uint32_t bufferSize = 100;
   char buffer[bufferSize];
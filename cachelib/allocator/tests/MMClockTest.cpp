@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Random.h>
+
+#include "cachelib/allocator/MMClock.h"
+#include "cachelib/allocator/tests/MMTypeTest.h"
+
+namespace facebook {
+namespace cachelib {
+using MMClockTest = MMTypeTest<MMClock>;
+
+TEST_F(MMClockTest, AddBasic) { testAddBasic(MMClock::Config{}); }
+
+TEST_F(MMClockTest, RemoveBasic) { testRemoveBasic(MMClock::Config{}); }
+
+// accesses only set the reference bit. The update time stays the time the
+// node was inserted.
+TEST_F(MMClockTest, RecordAccessBasic) {
+  Container c{MMClock::Config{}, {}};
+  std::vector<std::unique_ptr<Node>> nodes;
+  createSimpleContainer(c, nodes);
+
+  const uint32_t insertionTime = 100;
+  for (auto& node : nodes) {
+    node->setUpdateTime(insertionTime);
+  }
+  for (auto& node : nodes) {
+    ASSERT_TRUE(c.recordAccess(*node, AccessMode::kRead));
+    ASSERT_FALSE(c.recordAccess(*node, AccessMode::kRead));
+    ASSERT_TRUE(node->isInMMContainer());
+    ASSERT_EQ(insertionTime, node->getUpdateTime());
+  }
+}
+
+TEST_F(MMClockTest, Serialization) {
+  testSerializationBasic(MMClock::Config{});
+}
+
+TEST_F(MMClockTest, RecordAccessModes) {
+  Container c{MMClock::Config{/* updateOnWrite */ false,
+                              /* updateOnRead */ true},
+              {}};
+  std::vector<std::unique_ptr<Node>> nodes;
+  createSimpleContainer(c, nodes);
+
+  // writes are not tracked
+  ASSERT_FALSE(c.recordAccess(*nodes[0], AccessMode::kWrite));
+  ASSERT_FALSE(nodes[0]->isFlagSet<Node::kMMFlag1>());
+
+  ASSERT_TRUE(c.recordAccess(*nodes[0], AccessMode::kRead));
+  ASSERT_TRUE(nodes[0]->isFlagSet<Node::kMMFlag1>());
+  ASSERT_FALSE(c.recordAccess(*nodes[0], AccessMode::kRead));
+
+  // nodes outside of the container are not tracked
+  ASSERT_TRUE(c.remove(*nodes[1]));
+  ASSERT_FALSE(c.recordAccess(*nodes[1], AccessMode::kRead));
+}
+
+TEST_F(MMClockTest, ClockBasic) {
+  Container c{MMClock::Config{}, {}};
+  std::vector<std::unique_ptr<Node>> nodes;
+  // nodes are inserted at the head, so node 0 is at the tail
+  createSimpleContainer(c, nodes);
+
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(c.recordAccess(*nodes[i], AccessMode::kRead));
+  }
+
+  // the hand clears the referenced nodes and stops at the first one that
+  // was not accessed
+  c.withEvictionIterator([&c, &nodes](auto&& it) {
+    ASSERT_TRUE(it);
+    ASSERT_EQ(3, it->getId());
+    for (int i = 0; i < 3; i++) {
+      ASSERT_FALSE(nodes[i]->isFlagSet<Node::kMMFlag1>());
+    }
+    c.remove(it);
+    ASSERT_TRUE(it);
+    ASSERT_EQ(4, it->getId());
+  });
+
+  // an access after the sweep gives the node another chance
+  ASSERT_TRUE(c.recordAccess(*nodes[5], AccessMode::kRead));
+
+  // the next sweep continues from where the hand stopped and wraps around
+  std::vector<int> order;
+  c.withEvictionIterator([&order](auto&& it) {
+    for (; it && order.size() < 8; ++it) {
+      order.push_back(it->getId());
+    }
+  });
+  std::vector<int> expected{4, 6, 7, 8, 9, 0, 1, 2};
+  ASSERT_EQ(expected, order);
+  ASSERT_FALSE(nodes[5]->isFlagSet<Node::kMMFlag1>());
+}
+
+TEST_F(MMClockTest, SweepEnds) {
+  Container c{MMClock::Config{}, {}};
+  std::vector<std::unique_ptr<Node>> nodes;
+  createSimpleContainer(c, nodes);
+  for (auto& node : nodes) {
+    c.recordAccess(*node, AccessMode::kRead);
+  }
+
+  // with every node referenced, one lap clears the bits and the second lap
+  // offers every node once before the iterator ends.
+  size_t numSeen = 0;
+  c.withEvictionIterator([&numSeen](auto&& it) {
+    for (; it; ++it) {
+      numSeen++;
+    }
+  });
+  ASSERT_EQ(nodes.size(), numSeen);
+}
+
+TEST_F(MMClockTest, InspectWithoutSweeping) {
+  Container c{MMClock::Config{}, {}};
+  std::vector<std::unique_ptr<Node>> nodes;
+  createSimpleContainer(c, nodes);
+  ASSERT_TRUE(c.recordAccess(*nodes[0], AccessMode::kRead));
+
+  // walking the container once offers every node, referenced or not, and
+  // leaves the reference bits alone
+  std::vector<int> order;
+  for (auto it = c.getEvictionIterator(); it; ++it) {
+    order.push_back(it->getId());
+  }
+  std::vector<int> expected{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  ASSERT_EQ(expected, order);
+  ASSERT_TRUE(nodes[0]->isFlagSet<Node::kMMFlag1>());
+
+  // nodes can be removed while walking
+  {
+    auto it = c.getEvictionIterator();
+    c.remove(it);
+    ASSERT_TRUE(it);
+    ASSERT_EQ(1, it->getId());
+  }
+  ASSERT_FALSE(nodes[0]->isInMMContainer());
+
+  // the hand did not move, so a sweep still starts at the tail
+  c.withEvictionIterator([](auto&& it) {
+    ASSERT_TRUE(it);
+    ASSERT_EQ(1, it->getId());
+  });
+}
+
+TEST_F(MMClockTest, Replace) {
+  Container c{MMClock::Config{}, {}};
+  std::vector<std::unique_ptr<Node>> nodes;
+  createSimpleContainer(c, nodes);
+
+  // leave the hand on node 0
+  c.withEvictionIterator([](auto&& it) { ASSERT_EQ(0, it->getId()); });
+
+  ASSERT_TRUE(c.recordAccess(*nodes[0], AccessMode::kRead));
+  Node newNode{100};
+  ASSERT_TRUE(c.replace(*nodes[0], newNode));
+  ASSERT_FALSE(nodes[0]->isInMMContainer());
+  ASSERT_TRUE(newNode.isInMMContainer());
+  ASSERT_TRUE(newNode.isFlagSet<Node::kMMFlag1>());
+
+  // the hand moved over to the new node, which keeps its reference bit
+  c.withEvictionIterator([&c](auto&& it) {
+    ASSERT_EQ(1, it->getId());
+    c.remove(it);
+  });
+  ASSERT_TRUE(c.remove(newNode));
+}
+} // namespace cachelib
+} // namespace facebook
@@ -17,6 +17,8 @@
 #include <folly/Random.h>
 #include <folly/logging/xlog.h>
 
+#include <thread>
+
 #include "cachelib/allocator/MMLru.h"
 #include "cachelib/allocator/tests/MMTypeTest.h"
 
@@ -541,5 +543,132 @@ TEST_F(MMLruTest, Reconfigure) {
   // node 0 (age 2) does not get promoted
   EXPECT_FALSE(container.recordAccess(*nodes[0], AccessMode::kRead));
 }
+
+TEST_F(MMLruTest, AccessBuffer) {
+  MMLru::Config config{/* lruRefreshTime */ 0,
+                       /* lruRefreshRatio */ 0.,
+                       /* updateOnWrite */ false,
+                       /* updateOnRead */ true,
+                       /* tryLockUpdate */ false,
+                       /* lruInsertionPointSpec */ 0};
+  config.accessBufferSize = 64;
+  Container c{config, {}};
+
+  std::vector<std::unique_ptr<Node>> nodes;
+  for (int i = 0; i < 10; i++) {
+    nodes.emplace_back(new Node{i});
+    ASSERT_TRUE(c.add(*nodes.back()));
+  }
+
+  auto getOrder = [&c]() {
+    std::vector<int> order;
+    c.withEvictionIterator([&order](auto&& itr) {
+      for (; itr; ++itr) {
+        order.push_back(itr->getId());
+      }
+    });
+    return order;
+  };
+
+  // accesses are buffered and applied before the eviction iteration
+  ASSERT_TRUE(c.recordAccess(*nodes[0], AccessMode::kRead));
+  ASSERT_TRUE(c.recordAccess(*nodes[1], AccessMode::kRead));
+  ASSERT_TRUE(c.recordAccess(*nodes[2], AccessMode::kRead));
+  // buffered nodes are marked, and a second access is not buffered again
+  ASSERT_TRUE(nodes[0]->isFlagSet<Node::kMMFlag2>());
+  ASSERT_TRUE(c.recordAccess(*nodes[0], AccessMode::kRead));
+  std::vector<int> expected{3, 4, 5, 6, 7, 8, 9, 0, 1, 2};
+  ASSERT_EQ(expected, getOrder());
+  for (int i = 0; i < 3; i++) {
+    ASSERT_FALSE(nodes[i]->isFlagSet<Node::kMMFlag2>());
+  }
+
+  // removing a node drops its buffered accesses
+  ASSERT_TRUE(c.recordAccess(*nodes[3], AccessMode::kRead));
+  ASSERT_TRUE(c.recordAccess(*nodes[4], AccessMode::kRead));
+  ASSERT_TRUE(c.remove(*nodes[3]));
+  ASSERT_FALSE(nodes[3]->isFlagSet<Node::kMMFlag2>());
+  expected = {5, 6, 7, 8, 9, 0, 1, 2, 4};
+  ASSERT_EQ(expected, getOrder());
+
+  // accessing more than the buffer holds applies the accesses in batches
+  for (int i = 0; i < 10000; i++) {
+    auto& node = nodes[folly::Random::rand32() % nodes.size()];
+    if (node->getId() != 3) {
+      ASSERT_TRUE(c.recordAccess(*node, AccessMode::kRead));
+    }
+  }
+  ASSERT_EQ(9, getOrder().size());
+
+  // the buffer size is kept across setConfig and serialization
+  auto newConfig = c.getConfig();
+  newConfig.accessBufferSize = 0;
+  c.setConfig(newConfig);
+  ASSERT_EQ(64, c.getConfig().accessBufferSize);
+
+  // buffered accesses are dropped when saving, along with their marks
+  ASSERT_TRUE(c.recordAccess(*nodes[6], AccessMode::kRead));
+  ASSERT_TRUE(nodes[6]->isFlagSet<Node::kMMFlag2>());
+  Container c2{c.saveState(), {}};
+  ASSERT_FALSE(nodes[6]->isFlagSet<Node::kMMFlag2>());
+  ASSERT_EQ(64, c2.getConfig().accessBufferSize);
+  ASSERT_TRUE(c2.recordAccess(*nodes[5], AccessMode::kRead));
+}
+
+TEST_F(MMLruTest, AccessBufferStress) {
+  MMLru::Config config{/* lruRefreshTime */ 0,
+                       /* lruRefreshRatio */ 0.,
+                       /* updateOnWrite */ false,
+                       /* updateOnRead */ true,
+                       /* tryLockUpdate */ false,
+                       /* lruInsertionPointSpec */ 1};
+  config.accessBufferSize = 8;
+  Container c{config, {}};
+
+  const int numNodes = 1000;
+  std::vector<std::unique_ptr<Node>> nodes;
+  for (int i = 0; i < numNodes; i++) {
+    nodes.emplace_back(new Node{i});
+    c.add(*nodes.back());
+  }
+
+  // readers record accesses while a writer keeps removing and adding nodes
+  // back. The buffer must never hand a node that left the container back to
+  // the lru.
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&]() {
+      while (!stop) {
+        auto& node = nodes[folly::Random::rand32() % numNodes];
+        c.recordAccess(*node, AccessMode::kRead);
+      }
+    });
+  }
+
+  for (int i = 0; i < 10000; i++) {
+    auto& node = nodes[folly::Random::rand32() % numNodes];
+    if (c.remove(*node)) {
+      c.add(*node);
+    }
+  }
+  stop = true;
+  for (auto& t : readers) {
+    t.join();
+  }
+
+  size_t numSeen = 0;
+  c.withEvictionIterator([&numSeen](auto&& itr) {
+    for (; itr; ++itr) {
+      ASSERT_TRUE(itr->isInMMContainer());
+      numSeen++;
+    }
+  });
+  ASSERT_EQ(numNodes, numSeen);
+  ASSERT_EQ(numNodes, c.size());
+  for (auto& node : nodes) {
+    ASSERT_FALSE(node->isFlagSet<Node::kMMFlag2>());
+  }
+}
 } // namespace cachelib
 } // namespace facebook
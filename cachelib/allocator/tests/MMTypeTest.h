@@ -81,6 +81,13 @@ class MMTypeTest : public testing::Test {
              (static_cast<uint8_t>(1) << static_cast<uint8_t>(flagBit));
     }
 
+    template <Flags flagBit>
+    bool trySetFlag() {
+      const auto mask = static_cast<uint8_t>(1)
+                        << static_cast<uint8_t>(flagBit);
+      return !(__sync_fetch_and_or(&flags_, mask) & mask);
+    }
+
     bool isTail() { return isFlagSet<kMMFlag0>(); }
 
     bool isInMMContainer() const noexcept { return inContainer_; }
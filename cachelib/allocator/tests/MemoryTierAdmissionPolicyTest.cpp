@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "cachelib/allocator/CacheAllocator.h"
+#include "cachelib/allocator/MemoryTierAdmissionPolicy.h"
+#include "cachelib/allocator/Util.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+
+class MemoryTierAdmissionPolicyTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    LruAllocator::Config config;
+    config.setCacheSize(10 * Slab::kSize);
+    cache_ = std::make_unique<LruAllocator>(config);
+    pid_ = cache_->addPool("default",
+                           cache_->getCacheMemoryStats().cacheSize);
+  }
+
+  LruAllocator::WriteHandle allocate(const std::string& key,
+                                     uint32_t size = 100,
+                                     uint32_t ttlSecs = 0) {
+    auto handle = util::allocateAccessible(*cache_, pid_, key, size, ttlSecs);
+    EXPECT_NE(nullptr, handle);
+    return handle;
+  }
+
+  std::unique_ptr<LruAllocator> cache_;
+  PoolId pid_;
+};
+
+TEST_F(MemoryTierAdmissionPolicyTest, Default) {
+  MemoryTierAdmissionPolicy<LruAllocator> policy;
+  auto handle = allocate("key");
+
+  EXPECT_EQ(0, policy.chooseAllocationTier("key", 100, 0, 2));
+  EXPECT_TRUE(policy.acceptDemotion(*handle, 0, 1));
+
+  auto ctrs = policy.getCounters();
+  EXPECT_EQ(0, ctrs["mtap.allocs_to_lower_tier"]);
+  EXPECT_EQ(1, ctrs["mtap.demotions_accepted"]);
+  EXPECT_EQ(0, ctrs["mtap.demotions_rejected"]);
+}
+
+TEST_F(MemoryTierAdmissionPolicyTest, Size) {
+  EXPECT_THROW(SizeTierAdmissionPolicy<LruAllocator>{0},
+               std::invalid_argument);
+
+  SizeTierAdmissionPolicy<LruAllocator> policy{1024};
+  EXPECT_EQ(0, policy.chooseAllocationTier("key", 1023, 0, 2));
+  EXPECT_EQ(1, policy.chooseAllocationTier("key", 1024, 0, 2));
+  // with a single tier everything goes to the top tier
+  EXPECT_EQ(0, policy.chooseAllocationTier("key", 4096, 0, 1));
+  EXPECT_EQ(1, policy.getCounters()["mtap.allocs_to_lower_tier"]);
+}
+
+TEST_F(MemoryTierAdmissionPolicyTest, Ttl) {
+  TtlTierAdmissionPolicy<LruAllocator> policy{60};
+  auto noTtl = allocate("noTtl");
+  auto shortTtl = allocate("shortTtl", 100, 10);
+  auto longTtl = allocate("longTtl", 100, 3600);
+
+  EXPECT_TRUE(policy.acceptDemotion(*noTtl, 0, 1));
+  EXPECT_FALSE(policy.acceptDemotion(*shortTtl, 0, 1));
+  EXPECT_TRUE(policy.acceptDemotion(*longTtl, 0, 1));
+}
+
+TEST_F(MemoryTierAdmissionPolicyTest, Frequency) {
+  FrequencyTierAdmissionPolicy<LruAllocator>::Config config;
+  config.minAccesses = 2;
+  config.numTrackedKeys = 64 * 1024;
+  config.decayWindow = 4;
+  FrequencyTierAdmissionPolicy<LruAllocator> policy{config};
+  auto handle = allocate("key");
+
+  EXPECT_FALSE(policy.acceptDemotion(*handle, 0, 1));
+  policy.trackAccess("key");
+  EXPECT_FALSE(policy.acceptDemotion(*handle, 0, 1));
+  policy.trackAccess("key");
+  EXPECT_TRUE(policy.acceptDemotion(*handle, 0, 1));
+
+  // counts are halved once per full window of accesses, over the accesses
+  // of the next window
+  policy.trackAccess("key");
+  policy.trackAccess("key");
+  EXPECT_EQ(1, policy.getCounters()["mtap.frequency_decays"]);
+  EXPECT_TRUE(policy.acceptDemotion(*handle, 0, 1));
+  for (int i = 0; i < 4; i++) {
+    policy.trackAccess("key");
+  }
+  EXPECT_EQ(2, policy.getCounters()["mtap.frequency_decays"]);
+  EXPECT_TRUE(policy.acceptDemotion(*handle, 0, 1));
+
+  FrequencyTierAdmissionPolicy<LruAllocator>::Config invalid;
+  invalid.minAccesses = 0;
+  EXPECT_THROW(FrequencyTierAdmissionPolicy<LruAllocator>{invalid},
+               std::invalid_argument);
+}
+
+TEST_F(MemoryTierAdmissionPolicyTest, FrequencyConcurrentAccesses) {
+  const uint32_t numThreads = 4;
+  const uint32_t numAccesses = 1000;
+  FrequencyTierAdmissionPolicy<LruAllocator>::Config config;
+  config.minAccesses = numThreads * numAccesses;
+  config.numTrackedKeys = 64 * 1024;
+  config.decayWindow = 1'000'000;
+  FrequencyTierAdmissionPolicy<LruAllocator> policy{config};
+  auto hot = allocate("hot");
+  auto cold = allocate("cold");
+
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < numThreads; i++) {
+    threads.emplace_back([&]() {
+      for (uint32_t j = 0; j < numAccesses; j++) {
+        policy.trackAccess("hot");
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  // no increment is lost without a decay
+  EXPECT_TRUE(policy.acceptDemotion(*hot, 0, 1));
+  EXPECT_FALSE(policy.acceptDemotion(*cold, 0, 1));
+  EXPECT_EQ(0, policy.getCounters()["mtap.frequency_decays"]);
+}
+
+TEST_F(MemoryTierAdmissionPolicyTest, Bandwidth) {
+  // tier 1 gets 1000 bytes per second with no burst beyond that
+  BandwidthTierAdmissionPolicy<LruAllocator> policy{{0, 1000}};
+  auto handle = allocate("key", 400);
+
+  EXPECT_TRUE(policy.acceptDemotion(*handle, 0, 1));
+  EXPECT_TRUE(policy.acceptDemotion(*handle, 0, 1));
+  EXPECT_FALSE(policy.acceptDemotion(*handle, 0, 1));
+  EXPECT_EQ(1, policy.getCounters()["mtap.bandwidth_over_budget"]);
+
+  // tiers without a budget are unlimited
+  for (int i = 0; i < 10; i++) {
+    EXPECT_TRUE(policy.acceptDemotion(*handle, 1, 0));
+  }
+
+  EXPECT_THROW((BandwidthTierAdmissionPolicy<LruAllocator>{{1000}, 0}),
+               std::invalid_argument);
+}
+
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
@@ -198,6 +198,48 @@ TEST_F(LruMemoryTiersTest, TestInvalid2TierConfigSizesNeCacheSize) {
                std::invalid_argument);
 }
 
+TEST_F(LruMemoryTiersTest, TestNumaPolicyConfig) {
+  auto tier = MemoryTierCacheConfig::fromShm();
+  EXPECT_TRUE(tier.getNumaPolicy().isDefault());
+
+  tier.setMemBind({0, 2});
+  EXPECT_EQ(NumaPolicy::Mode::kBind, tier.getNumaPolicy().mode);
+  EXPECT_EQ(NumaBitMask{0b101}, tier.getNumaPolicy().nodes);
+
+  tier.setInterleave({1});
+  EXPECT_EQ(NumaPolicy::Mode::kInterleave, tier.getNumaPolicy().mode);
+  EXPECT_EQ(NumaBitMask{0b10}, tier.getNumaPolicy().nodes);
+
+  EXPECT_THROW(tier.setMemBind({}), std::invalid_argument);
+  EXPECT_THROW(tier.setInterleave({kMaxNumaNodes}), std::invalid_argument);
+}
+
+TEST_F(LruMemoryTiersTest, TestHugePagePolicyConfig) {
+  using util::HugePagePolicy;
+  auto shmTier = MemoryTierCacheConfig::fromShm();
+  auto fileTier = MemoryTierCacheConfig::fromFile(defaultPmemPath);
+  for (auto policy : {HugePagePolicy::kNone, HugePagePolicy::kTransparent,
+                      HugePagePolicy::kTwoMB, HugePagePolicy::kOneGB}) {
+    EXPECT_EQ(policy, shmTier.getHugePagePolicy(policy));
+  }
+
+  // a regular file can not be mapped from the hugetlb pool.
+  EXPECT_EQ(HugePagePolicy::kNone,
+            fileTier.getHugePagePolicy(HugePagePolicy::kTwoMB));
+  EXPECT_EQ(HugePagePolicy::kNone,
+            fileTier.getHugePagePolicy(HugePagePolicy::kOneGB));
+  EXPECT_EQ(HugePagePolicy::kTransparent,
+            fileTier.getHugePagePolicy(HugePagePolicy::kTransparent));
+
+  // the policy of the tier wins over the one of the cache.
+  fileTier.setHugePagePolicy(HugePagePolicy::kTwoMB);
+  EXPECT_EQ(HugePagePolicy::kTwoMB,
+            fileTier.getHugePagePolicy(HugePagePolicy::kNone));
+  shmTier.setHugePagePolicy(HugePagePolicy::kNone);
+  EXPECT_EQ(HugePagePolicy::kNone,
+            shmTier.getHugePagePolicy(HugePagePolicy::kOneGB));
+}
+
 TEST_F(LruMemoryTiersTest, TestPoolAllocations) {
   std::vector<size_t> totalCacheSizes = {2 * GB};
 
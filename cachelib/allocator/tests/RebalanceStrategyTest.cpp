@@ -29,14 +29,50 @@ namespace facebook {
 namespace cachelib {
 TEST(RebalanceStrategy, Basic) {
   PoolId pid = 1;
+  TierId tid = 0;
   RebalanceStrategy r;
-  ASSERT_FALSE(r.poolStatePresent(pid));
+  ASSERT_FALSE(r.poolStatePresent(tid, pid));
   PoolStats stats{};
-  r.initPoolState(pid, stats);
-  ASSERT_TRUE(r.poolStatePresent(pid));
+  r.initPoolState(tid, pid, stats);
+  ASSERT_TRUE(r.poolStatePresent(tid, pid));
+  // state is kept separately for every tier
+  ASSERT_FALSE(r.poolStatePresent(1, pid));
 
   std::set<ClassId> victims = {MemoryAllocator::kMaxClassId};
-  r.filterVictimsByHoldOff(1, PoolStats{}, victims);
+  r.filterVictimsByHoldOff(tid, 1, PoolStats{}, victims);
+}
+
+namespace {
+// a strategy written before memory tiers, overriding only the overloads
+// without a tier.
+class PreTierStrategy : public RebalanceStrategy {
+ protected:
+  RebalanceContext pickVictimAndReceiverImpl(const CacheBase&,
+                                             PoolId) override {
+    return {1, 2};
+  }
+
+  ClassId pickVictimImpl(const CacheBase&, PoolId) override { return 1; }
+};
+} // namespace
+
+TEST(RebalanceStrategy, PreTierOverrides) {
+  LruAllocator::Config config;
+  config.setCacheSize(100 * Slab::kSize);
+  LruAllocator cache(config);
+
+  PreTierStrategy s;
+  RebalanceStrategy& r = s;
+  // the top tier goes to the old overloads, the other tiers are left alone.
+  auto ctx = r.pickVictimAndReceiverImpl(cache, 0, 0);
+  ASSERT_EQ(1, ctx.victimClassId);
+  ASSERT_EQ(2, ctx.receiverClassId);
+  ASSERT_EQ(1, r.pickVictimImpl(cache, 0, 0));
+
+  ctx = r.pickVictimAndReceiverImpl(cache, 1, 0);
+  ASSERT_EQ(Slab::kInvalidClassId, ctx.victimClassId);
+  ASSERT_EQ(Slab::kInvalidClassId, ctx.receiverClassId);
+  ASSERT_EQ(Slab::kInvalidClassId, r.pickVictimImpl(cache, 1, 0));
 }
 
 namespace tests {
@@ -34,8 +34,8 @@ struct SimpleRebalanceStrategy : public RebalanceStrategy {
   SimpleRebalanceStrategy() : RebalanceStrategy(PickNothingOrTest) {}
 
  private:
-  ClassId pickVictim(const CacheBase& allocator, PoolId pid) {
-    auto poolStats = allocator.getPoolStats(pid);
+  ClassId pickVictim(const CacheBase& allocator, TierId tid, PoolId pid) {
+    auto poolStats = allocator.getPoolStats(tid, pid);
     ClassId cid = Slab::kInvalidClassId;
     uint64_t maxActiveAllocs = 0;
     for (size_t i = 0; i < poolStats.mpStats.acStats.size(); ++i) {
@@ -48,13 +48,16 @@ struct SimpleRebalanceStrategy : public RebalanceStrategy {
     return cid;
   }
 
-  ClassId pickVictimImpl(const CacheBase& allocator, PoolId pid) override {
-    return pickVictim(allocator, pid);
+  ClassId pickVictimImpl(const CacheBase& allocator,
+                         TierId tid,
+                         PoolId pid) override {
+    return pickVictim(allocator, tid, pid);
   }
 
   RebalanceContext pickVictimAndReceiverImpl(const CacheBase& allocator,
+                                             TierId tid,
                                              PoolId pid) override {
-    return {pickVictim(allocator, pid), Slab::kInvalidClassId};
+    return {pickVictim(allocator, tid, pid), Slab::kInvalidClassId};
   }
 };
 
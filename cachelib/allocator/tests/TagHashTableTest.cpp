@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/allocator/TagHashTable.h"
+#include "cachelib/allocator/tests/AccessTypeTest.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+
+using facebook::cachelib::TagHashTable;
+using TagHashTest = AccessTypeTest<TagHashTable>;
+
+TEST_F(TagHashTest, Insert) { testInsert(); }
+
+TEST_F(TagHashTest, Replace) { testReplace(); }
+
+TEST_F(TagHashTest, Remove) { testRemove(); }
+
+TEST_F(TagHashTest, Find) { testFind(); }
+
+TEST_F(TagHashTest, FindBatch) { testFindBatch(); }
+
+TEST_F(TagHashTest, HandleIteration) { testHandleIterationWithExceptions(); }
+
+TEST_F(TagHashTest, RemoveIf) { testRemoveIf(); }
+
+TEST_F(TagHashTest, Serialization) { testSerialization(); }
+
+TEST_F(TagHashTest, IteratorBasic) { testIteratorBasic(); }
+
+TEST_F(TagHashTest, IteratorWithInserts) { testIteratorWithInserts(); }
+
+TEST_F(TagHashTest, IteratorWithSerialization) {
+  testIteratorWithSerialization();
+}
+
+// with far more nodes than slots, most of them end up in the overflow chains.
+// Removing them in any order must keep the rest of the nodes reachable.
+TEST_F(TagHashTest, Overflow) {
+  using HashConfig = TagHashTable::Config;
+  const unsigned int bucketsPower = 5;
+  const unsigned int locksPower = 3;
+  HashConfig config{bucketsPower, locksPower};
+
+  Container c{std::move(config), typename Node::PtrCompressor()};
+  std::vector<std::unique_ptr<Node>> nodes;
+
+  const unsigned int numNodes = 10000;
+  for (unsigned int i = 0; i < numNodes; i++) {
+    auto key = getRandomNewKey(c);
+    nodes.emplace_back(new Node(key));
+    ASSERT_TRUE(c.insert(*nodes.back()));
+    ASSERT_EQ(nodes.size(), c.getNumKeys());
+  }
+
+  for (const auto& node : nodes) {
+    auto handle = c.find(node->getKey());
+    ASSERT_EQ(node.get(), handle.get());
+  }
+
+  // remove every other node. This empties slots that get refilled from the
+  // overflow chains and removes nodes from the middle of the chains.
+  for (unsigned int i = 0; i < numNodes; i += 2) {
+    ASSERT_TRUE(c.remove(*nodes[i]));
+  }
+  ASSERT_EQ(numNodes / 2, c.getNumKeys());
+
+  for (unsigned int i = 0; i < numNodes; i++) {
+    auto handle = c.find(nodes[i]->getKey());
+    if (i % 2 == 0) {
+      ASSERT_EQ(nullptr, handle);
+    } else {
+      ASSERT_EQ(nodes[i].get(), handle.get());
+    }
+  }
+
+  // replacing nodes in slots and in the chains returns the old ones.
+  for (unsigned int i = 1; i < numNodes; i += 2) {
+    auto newNode = std::make_unique<Node>(nodes[i]->getKey());
+    auto old = c.insertOrReplace(*newNode);
+    ASSERT_EQ(nodes[i].get(), old.get());
+    ASSERT_FALSE(nodes[i]->isAccessible());
+    old.reset();
+    nodes[i] = std::move(newNode);
+  }
+  ASSERT_EQ(numNodes / 2, c.getNumKeys());
+
+  for (unsigned int i = 1; i < numNodes; i += 2) {
+    auto handle = c.find(nodes[i]->getKey());
+    ASSERT_EQ(nodes[i].get(), handle.get());
+    ASSERT_TRUE(c.remove(*nodes[i]));
+  }
+  ASSERT_EQ(0, c.getNumKeys());
+}
+
+TEST_F(TagHashTest, Resize) {
+  Container c;
+  ASSERT_FALSE(c.isResizing());
+  ASSERT_THROW(c.startResize(c.getHashpower() + 1), std::invalid_argument);
+  ASSERT_TRUE(c.rehashStep(1));
+  ASSERT_EQ(0, c.getTableGeneration());
+}
+
+TEST_F(TagHashTest, RequiredSize) {
+  // the buckets take the same memory as the ones of a ChainedHashTable with
+  // the same config.
+  for (unsigned int bucketsPower = 3; bucketsPower < 20; bucketsPower++) {
+    const size_t numBuckets = size_t{1} << bucketsPower;
+    ASSERT_EQ(sizeof(CompressedPtr) * numBuckets,
+              Container::getRequiredSize(numBuckets));
+  }
+}
+
+TEST_F(TagHashTest, MakeConfig) {
+  // tables made for a number of entries get twice the buckets of a
+  // ChainedHashTable, to keep the overflow chains short.
+  for (size_t numEntries : {1000, 1'000'000, 100'000'000}) {
+    ASSERT_EQ(
+        facebook::cachelib::ChainedHashTable::makeConfig(numEntries)
+                .getBucketsPower() +
+            1,
+        TagHashTable::makeConfig(numEntries).getBucketsPower());
+  }
+}
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
@@ -37,11 +37,12 @@ namespace tests {
 
 // type for TYPED_TEST_CASE
 // in tests, 0 means LruAllocator, 1 means Lru2QAllocator, 2 means
-// TinyLFUAllocator, 4 is LruAllocatorSpinBuckets
+// TinyLFUAllocator, 4 is LruAllocatorSpinBuckets, 5 is ClockAllocator
 typedef ::testing::Types<LruAllocator,
                          Lru2QAllocator,
                          TinyLFUAllocator,
-                         LruAllocatorSpinBuckets>
+                         LruAllocatorSpinBuckets,
+                         ClockAllocator>
     AllocatorTypes;
 
 template <typename AllocatorT>
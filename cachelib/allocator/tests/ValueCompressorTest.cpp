@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Format.h>
+
+#include <random>
+
+#include "cachelib/allocator/ValueCompressor.h"
+#include "cachelib/allocator/tests/TestBase.h"
+
+namespace facebook {
+namespace cachelib {
+
+namespace tests {
+class ValueCompressorTest : public testing::Test {
+ protected:
+  static folly::ByteRange toRange(const std::string& s) {
+    return folly::ByteRange(folly::StringPiece(s));
+  }
+
+  static std::string toString(const folly::IOBuf& buf) {
+    return std::string(reinterpret_cast<const char*>(buf.data()),
+                       buf.length());
+  }
+
+  // a json like value that shares most of its bytes with the other values
+  static std::string makeRecord(int i) {
+    return folly::sformat(
+        R"({{"id":{},"name":"user-{}","country":"{}","active":{},)"
+        R"("score":{},"tags":["cache","memory","flash"]}})",
+        i, i * 7, i % 2 ? "US" : "IE", i % 3 ? "true" : "false", i % 100);
+  }
+
+  static std::string makeRandom(size_t size) {
+    std::mt19937 gen(size);
+    std::string value(size, '\0');
+    for (auto& c : value) {
+      c = static_cast<char>(gen());
+    }
+    return value;
+  }
+
+  void testRoundTrip(ValueCompressor::Codec codec) {
+    ValueCompressor::Config config;
+    config.codec = codec;
+    config.minSize = 64;
+    ValueCompressor compressor(config);
+
+    std::string value;
+    for (int i = 0; value.size() < 8192; i++) {
+      value += makeRecord(i);
+    }
+    auto compressed = compressor.compress(toRange(value));
+    ASSERT_NE(nullptr, compressed);
+    ASSERT_LT(compressed->length(), value.size());
+    ASSERT_EQ(value.size(),
+              ValueCompressor::getUncompressedSize(compressed->coalesce()));
+
+    auto uncompressed = compressor.uncompress(compressed->coalesce());
+    ASSERT_EQ(value, toString(*uncompressed));
+
+    const auto stats = compressor.getStats();
+    ASSERT_EQ(1, stats.numCompressed);
+    ASSERT_EQ(1, stats.numUncompressed);
+    ASSERT_EQ(value.size(), stats.uncompressedBytes);
+    ASSERT_EQ(compressed->length(), stats.compressedBytes);
+    ASSERT_GT(stats.getCompressionRatio(), 1.0);
+  }
+};
+
+TEST_F(ValueCompressorTest, RoundTripZstd) {
+  testRoundTrip(ValueCompressor::Codec::kZstd);
+}
+
+TEST_F(ValueCompressorTest, RoundTripLz4) {
+  testRoundTrip(ValueCompressor::Codec::kLz4);
+}
+
+TEST_F(ValueCompressorTest, SmallValuesAreNotCompressed) {
+  ValueCompressor::Config config;
+  config.minSize = 1024;
+  ValueCompressor compressor(config);
+
+  const std::string value(1023, 'a');
+  ASSERT_EQ(nullptr, compressor.compress(toRange(value)));
+  ASSERT_EQ(1, compressor.getStats().numSkippedSmall);
+  ASSERT_EQ(0, compressor.getStats().numCompressed);
+
+  const std::string larger(1024, 'a');
+  ASSERT_NE(nullptr, compressor.compress(toRange(larger)));
+  ASSERT_EQ(1, compressor.getStats().numCompressed);
+}
+
+TEST_F(ValueCompressorTest, IncompressibleValues) {
+  ValueCompressor::Config config;
+  config.minSize = 0;
+  ValueCompressor compressor(config);
+
+  const auto value = makeRandom(16 * 1024);
+  ASSERT_EQ(nullptr, compressor.compress(toRange(value)));
+  ASSERT_EQ(1, compressor.getStats().numSkippedRatio);
+
+  // any saving is enough at 100%
+  config.maxCompressedPercent = 100;
+  ValueCompressor lenient(config);
+  const auto halfRandom = makeRandom(8 * 1024) + std::string(8 * 1024, 'a');
+  ASSERT_NE(nullptr, lenient.compress(toRange(halfRandom)));
+}
+
+TEST_F(ValueCompressorTest, Dictionary) {
+  std::vector<std::string> samples;
+  for (int i = 0; i < 2000; i++) {
+    samples.push_back(makeRecord(i));
+  }
+  ValueCompressor::Config config;
+  config.minSize = 0;
+  config.maxCompressedPercent = 100;
+  ValueCompressor plain(config);
+
+  config.dictionary = ValueCompressor::trainDictionary(samples, 4096);
+  ASSERT_FALSE(config.dictionary.empty());
+  ASSERT_LE(config.dictionary.size(), 4096);
+  ValueCompressor withDict(config);
+
+  // small values barely compress on their own, but do with a dictionary
+  // trained on similar values.
+  const auto value = makeRecord(123456);
+  auto compressed = withDict.compress(toRange(value));
+  ASSERT_NE(nullptr, compressed);
+  ASSERT_LT(compressed->length() * 2, value.size());
+  ASSERT_EQ(value, toString(*withDict.uncompress(compressed->coalesce())));
+
+  auto plainCompressed = plain.compress(toRange(value));
+  if (plainCompressed) {
+    ASSERT_LT(compressed->length(), plainCompressed->length());
+  }
+
+  // not enough samples to train on
+  ASSERT_THROW(ValueCompressor::trainDictionary({"a", "b"}),
+               std::invalid_argument);
+}
+
+TEST_F(ValueCompressorTest, Corrupted) {
+  ValueCompressor::Config config;
+  config.minSize = 0;
+  ValueCompressor compressor(config);
+
+  const std::string value(4096, 'a');
+  auto compressed = compressor.compress(toRange(value));
+  ASSERT_NE(nullptr, compressed);
+  auto range = compressed->coalesce();
+  ASSERT_THROW(compressor.uncompress(range.subpiece(0, 2)),
+               std::invalid_argument);
+  ASSERT_THROW(compressor.uncompress(range.subpiece(0, range.size() - 1)),
+               std::invalid_argument);
+}
+
+TEST_F(ValueCompressorTest, InvalidConfig) {
+  ValueCompressor::Config config;
+  config.maxCompressedPercent = 0;
+  ASSERT_THROW(ValueCompressor{config}, std::invalid_argument);
+  config.maxCompressedPercent = 101;
+  ASSERT_THROW(ValueCompressor{config}, std::invalid_argument);
+
+  config = ValueCompressor::Config{};
+  config.zstdLevel = 1000;
+  ASSERT_THROW(ValueCompressor{config}, std::invalid_argument);
+
+  config = ValueCompressor::Config{};
+  config.codec = ValueCompressor::Codec::kLz4;
+  config.dictionary = "dictionary";
+  ASSERT_THROW(ValueCompressor{config}, std::invalid_argument);
+}
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
@@ -56,11 +56,13 @@ clang-format on
 namespace facebook {
 namespace cachelib {
 namespace {
-std::unique_ptr<LruAllocator> getCache(unsigned int htPower = 20) {
-  LruAllocator::Config config;
+template <typename AllocatorT = LruAllocator>
+std::unique_ptr<AllocatorT> getCache(unsigned int htPower = 20,
+                                     bool evictionEnabled = true) {
+  typename AllocatorT::Config config;
   config.setCacheSize(1024 * 1024 * 1024);
   // Hashtable: 1024 ht locks, 1M buckets
-  config.setAccessConfig(LruAllocator::AccessConfig{htPower, 10});
+  config.setAccessConfig(typename AllocatorT::AccessConfig{htPower, 10});
   // Allocation Sizes: Min: 64 bytes. Max: 1 MB. Growth factor 108%.
   config.setDefaultAllocSizes(1.08, 1024 * 1024, 64, false);
 
@@ -68,7 +70,11 @@ std::unique_ptr<LruAllocator> getCache(unsigned int htPower = 20) {
   config.enablePoolRebalancing({}, std::chrono::seconds{0});
   config.enableItemReaperInBackground(std::chrono::seconds{0});
 
-  auto cache = std::make_unique<LruAllocator>(config);
+  if (!evictionEnabled) {
+    config.disableCacheEviction();
+  }
+
+  auto cache = std::make_unique<AllocatorT>(config);
   cache->addPool("default", cache->getCacheMemoryStats().cacheSize);
   return cache;
 }
@@ -313,6 +319,34 @@ void runAllocateMultiThreads(int numThreads,
     }
   }
 }
+
+// Fill the cache with items of one size until it is full and report how
+// much of the cache each item takes, including its header and key.
+template <typename AllocatorT>
+void runMemoryPerItem(folly::StringPiece name, uint32_t valueSize) {
+  // Hashtable: 16M buckets, as it ends up with a bit more items than that
+  auto cache = getCache<AllocatorT>(24, false /* evictionEnabled */);
+  uint64_t numItems = 0;
+  while (true) {
+    // Length of key should be 10 bytes
+    auto key = folly::sformat("k_{: <8}", numItems);
+    auto hdl = cache->allocate(0, key, valueSize);
+    if (!hdl) {
+      // Cache is full.
+      break;
+    }
+    cache->insertOrReplace(hdl);
+    numItems++;
+  }
+
+  const auto cacheSize = cache->getCacheMemoryStats().cacheSize;
+  std::cout << folly::sformat(
+                   "[{: <60}] Items: {: <9} Bytes/Item: {:.1f}",
+                   folly::sformat("Memory Per Item - {: <12} {: <3} Bytes",
+                                  name, valueSize),
+                   numItems, static_cast<double>(cacheSize) / numItems)
+            << std::endl;
+}
 } // namespace cachelib
 } // namespace facebook
 
@@ -372,6 +406,14 @@ int main(int argc, char** argv) {
       }
     }
   }
+
+  printMsg("Becnhmarks (Memory Per Item)");
+  std::set<uint32_t> smallValueSizes{30, 50, 80};
+  for (auto v : smallValueSizes) {
+    std::cout << "---------\n";
+    runMemoryPerItem<LruAllocator>("Default Item", v);
+    runMemoryPerItem<LruAllocatorCompactItem>("Compact Item", v);
+  }
   printMsg("Becnhmarks have completed");
 }
 
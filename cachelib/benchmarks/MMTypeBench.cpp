@@ -27,6 +27,7 @@
 #include <vector>
 
 #include "cachelib/allocator/MM2Q.h"
+#include "cachelib/allocator/MMClock.h"
 #include "cachelib/allocator/MMLru.h"
 #include "cachelib/common/Mutex.h"
 
@@ -149,12 +150,20 @@ BENCHMARK(MMLruAdd) { runBench<MMLru>(MMLru::Config{}, BenchType::tAdd); }
 
 BENCHMARK_RELATIVE(MM2QAdd) { runBench<MM2Q>(MM2Q::Config{}, BenchType::tAdd); }
 
+BENCHMARK_RELATIVE(MMClockAdd) {
+  runBench<MMClock>(MMClock::Config{}, BenchType::tAdd);
+}
+
 BENCHMARK(MMLruRemove) { runBench<MMLru>(MMLru::Config{}, BenchType::tRemove); }
 
 BENCHMARK_RELATIVE(MM2QRemove) {
   runBench<MM2Q>(MM2Q::Config{}, BenchType::tRemove);
 }
 
+BENCHMARK_RELATIVE(MMClockRemove) {
+  runBench<MMClock>(MMClock::Config{}, BenchType::tRemove);
+}
+
 BENCHMARK(MMLruRemoveIterator) {
   runBench<MMLru>(MMLru::Config{}, BenchType::tRemoveIterator);
 }
@@ -163,6 +172,10 @@ BENCHMARK_RELATIVE(MM2QRemoveIterator) {
   runBench<MM2Q>(MM2Q::Config{}, BenchType::tRemoveIterator);
 }
 
+BENCHMARK_RELATIVE(MMClockRemoveIterator) {
+  runBench<MMClock>(MMClock::Config{}, BenchType::tRemoveIterator);
+}
+
 BENCHMARK(MMLruRecordAccessRead) {
   runBench<MMLru>(MMLru::Config{}, BenchType::tRecordAccessRead);
 }
@@ -171,6 +184,10 @@ BENCHMARK_RELATIVE(MM2QRecordAccessRead) {
   runBench<MM2Q>(MM2Q::Config{}, BenchType::tRecordAccessRead);
 }
 
+BENCHMARK_RELATIVE(MMClockRecordAccessRead) {
+  runBench<MMClock>(MMClock::Config{}, BenchType::tRecordAccessRead);
+}
+
 BENCHMARK(MMLruRecordAccessWriteUpdateNone) {
   MMLru::Config config{/* lruRefreshTime */ 0,
                        /* updateOnWrite */ false,
@@ -250,6 +267,12 @@ BENCHMARK_RELATIVE(MM2QRecordAccessWriteUpdateRdWr) {
                       /* coldSizePercent */ 30};
   runBench<MM2Q>(config, BenchType::tRecordAccessWrite);
 }
+
+BENCHMARK_RELATIVE(MMClockRecordAccessWriteUpdateRdWr) {
+  MMClock::Config config{/* updateOnWrite */ true,
+                         /* updateOnRead */ true};
+  runBench<MMClock>(config, BenchType::tRecordAccessWrite);
+}
 } // namespace benchmarks
 } // namespace cachelib
 } // namespace facebook
@@ -59,6 +59,15 @@ struct MMTypeBench {
              (static_cast<uint8_t>(1) << static_cast<uint8_t>(flagBit));
     }
 
+    template <Flags flagBit>
+    bool trySetFlag() {
+      const auto mask = static_cast<uint8_t>(1)
+                        << static_cast<uint8_t>(flagBit);
+      const bool wasSet = flags_ & mask;
+      flags_ |= mask;
+      return !wasSet;
+    }
+
    protected:
     bool isInMMContainer() const noexcept { return inContainer_; }
 
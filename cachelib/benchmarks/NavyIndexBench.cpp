@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the lookup throughput and the memory footprint of the navy
+// BlockCache indexes.
+
+#include <folly/Benchmark.h>
+#include <folly/Random.h>
+#include <folly/init/Init.h>
+#include <sys/resource.h>
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "cachelib/navy/block_cache/FixedSizeIndex.h"
+#include "cachelib/navy/block_cache/SparseMapIndex.h"
+
+using namespace facebook::cachelib::navy;
+
+DEFINE_uint64(num_keys, 10 * 1000 * 1000, "number of keys in the indexes");
+
+namespace {
+std::vector<uint64_t> keys;
+std::unique_ptr<SparseMapIndex> sparseMapIndex;
+std::unique_ptr<FixedSizeIndex> fixedSizeIndex;
+
+// peak resident memory in bytes
+uint64_t getMaxRss() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+}
+
+void fill(Index& index) {
+  for (size_t i = 0; i < keys.size(); i++) {
+    index.insert(keys[i], static_cast<uint32_t>(i), 1);
+  }
+}
+
+void lookupAll(Index& index) {
+  for (auto key : keys) {
+    auto lr = index.lookup(key);
+    folly::doNotOptimizeAway(lr);
+  }
+}
+} // namespace
+
+BENCHMARK(SparseMapIndexLookup) { lookupAll(*sparseMapIndex); }
+
+BENCHMARK_RELATIVE(FixedSizeIndexLookup) { lookupAll(*fixedSizeIndex); }
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+
+  keys.reserve(FLAGS_num_keys);
+  for (uint64_t i = 0; i < FLAGS_num_keys; i++) {
+    keys.push_back(folly::Random::rand64());
+  }
+
+  // the fixed size index is sized with 25% headroom, as it would be in a
+  // cache, since keys spread unevenly over its buckets.
+  auto rss = getMaxRss();
+  fixedSizeIndex = std::make_unique<FixedSizeIndex>(FLAGS_num_keys * 5 / 4);
+  fill(*fixedSizeIndex);
+  const auto fixedSizeBytes = getMaxRss() - rss;
+
+  rss = getMaxRss();
+  sparseMapIndex = std::make_unique<SparseMapIndex>();
+  fill(*sparseMapIndex);
+  const auto sparseMapBytes = getMaxRss() - rss;
+
+  std::cout << "SparseMapIndex: " << sparseMapBytes / FLAGS_num_keys
+            << " bytes/entry" << std::endl;
+  std::cout << "FixedSizeIndex: " << fixedSizeBytes / FLAGS_num_keys
+            << " bytes/entry, " << fixedSizeIndex->computeSize()
+            << " of the keys kept" << std::endl;
+
+  folly::runBenchmarks();
+  return 0;
+}
@@ -48,6 +48,7 @@ clang-format on
 #include <iostream>
 #include <random>
 
+#include "cachelib/allocator/CacheAllocator.h"
 #include "cachelib/benchmarks/BenchmarkUtils.h"
 #include "cachelib/common/AtomicCounter.h"
 #include "cachelib/common/BytesEqual.h"
@@ -205,6 +206,57 @@ void compareString(int len) {
   }
 }
 
+// Lookups in a cache with more keys than hash table buckets, so that chains
+// have more than one item and the items are not in the cpu caches. Misses
+// walk whole chains, which is where the compare tags save the key compares.
+void cacheLookup(unsigned int htPower, bool hit, size_t batchSize) {
+  constexpr uint64_t kOps = 10'000'000;
+  constexpr uint64_t kObjects = 4'000'000;
+
+  LruAllocator::Config config;
+  config.setCacheSize(1024 * 1024 * 1024);
+  config.setAccessConfig(LruAllocator::AccessConfig{htPower, 10});
+  config.enablePoolRebalancing({}, std::chrono::seconds{0});
+  config.enableItemReaperInBackground(std::chrono::seconds{0});
+  LruAllocator cache(config);
+  const auto pid =
+      cache.addPool("default", cache.getCacheMemoryStats().cacheSize);
+
+  // the keys looked up for misses have the same length as the ones in the
+  // cache, so a key compare without tags has to read the key bytes.
+  std::vector<std::string> keys;
+  for (uint64_t i = 0; i < kObjects; i++) {
+    auto hdl = cache.allocate(pid, folly::sformat("key_{: <12}", i), 100);
+    XCHECK(hdl);
+    cache.insertOrReplace(hdl);
+    keys.push_back(folly::sformat(hit ? "key_{: <12}" : "KEY_{: <12}", i));
+  }
+
+  std::mt19937 gen;
+  std::uniform_int_distribution<uint64_t> dist(0, kObjects - 1);
+  const auto name =
+      folly::sformat("Lookup {} - {: <2} HT Power, batch {: <2}",
+                     hit ? "Hit " : "Miss", htPower, batchSize);
+  if (batchSize <= 1) {
+    Timer t{name, kOps};
+    for (uint64_t i = 0; i < kOps; i++) {
+      auto hdl = cache.findFast(keys[dist(gen)]);
+      folly::doNotOptimizeAway(hdl);
+    }
+    return;
+  }
+
+  std::vector<LruAllocator::Key> batch(batchSize);
+  Timer t{name, kOps};
+  for (uint64_t i = 0; i < kOps; i += batchSize) {
+    for (auto& key : batch) {
+      key = keys[dist(gen)];
+    }
+    auto hdls = cache.findBatch(batch);
+    folly::doNotOptimizeAway(hdls);
+  }
+}
+
 void callMallctl() {
   constexpr uint64_t kOps = 10'000'000;
   {
@@ -236,6 +288,12 @@ int main(int argc, char** argv) {
   compareString(1);
   compareString(10);
   compareString(100);
+  for (const bool hit : {true, false}) {
+    for (const unsigned int htPower : {20, 22}) {
+      cacheLookup(htPower, hit, 1 /* batchSize */);
+      cacheLookup(htPower, hit, 16 /* batchSize */);
+    }
+  }
   callMallctl();
   printMsg("Benchmarks have completed");
 }
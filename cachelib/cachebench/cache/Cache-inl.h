@@ -70,6 +70,13 @@ Cache<Allocator>::Cache(const CacheConfig& config,
                       oldItem.getSize());
         },
         movingSync);
+
+    if (config_.slabCompactionIntervalMs > 0) {
+      allocatorConfig_.enableSlabCompaction(
+          std::chrono::milliseconds(config_.slabCompactionIntervalMs),
+          1 /* slabsPerIteration */,
+          static_cast<unsigned int>(config_.slabCompactionMinFreePercent));
+    }
   }
 
   if (config_.allocSizes.empty()) {
@@ -106,6 +113,9 @@ Cache<Allocator>::Cache(const CacheConfig& config,
     allocatorConfig_.usePosixForShm();
   }
 
+  allocatorConfig_.enableHugePages(config_.getHugePagePolicy(),
+                                   config_.hugePageFallback);
+
   if (config_.memoryTierConfigs.size()) {
     allocatorConfig_.configureMemoryTiers(config_.memoryTierConfigs);
   }
@@ -208,8 +218,16 @@ Cache<Allocator>::Cache(const CacheConfig& config,
           config_.navyProbabilityReinsertionThreshold);
     }
 
-    // configure BigHash if enabled
-    if (config_.navyBigHashSizePct > 0) {
+    // configure Kangaroo or BigHash if enabled
+    if (config_.navyKangarooSizePct > 0) {
+      nvmConfig.navyConfig.kangaroo()
+          .setSizePctAndMaxItemSize(config_.navyKangarooSizePct,
+                                    config_.navySmallItemMaxSize)
+          .setBucketSize(config_.navyBigHashBucketSize)
+          .setBucketBfSize(config_.navyBloomFilterPerBucketSize)
+          .setLogSizePct(config_.navyKangarooLogSizePct)
+          .setSetAdmissionThreshold(config_.navyKangarooSetAdmissionThreshold);
+    } else if (config_.navyBigHashSizePct > 0) {
       nvmConfig.navyConfig.bigHash()
           .setSizePctAndMaxItemSize(config_.navyBigHashSizePct,
                                     config_.navySmallItemMaxSize)
@@ -233,6 +251,8 @@ Cache<Allocator>::Cache(const CacheConfig& config,
         config_.truncateItemToOriginalAllocSizeInNvm;
 
     nvmConfig.navyConfig.setDeviceMaxWriteSize(config_.deviceMaxWriteSize);
+    nvmConfig.navyConfig.setIoUring(config_.navyIoUringQueueDepth,
+                                    config_.navyIoUringSqPoll);
 
     XLOG(INFO) << "Using the following nvm config"
                << folly::toPrettyJson(
@@ -511,6 +531,9 @@ Stats Cache<Allocator>::getStats() const {
   ret.numCacheGets = cacheStats.numCacheGets;
   ret.numCacheGetMiss = cacheStats.numCacheGetMiss;
   ret.numRamDestructorCalls = cacheStats.numRamDestructorCalls;
+  ret.numRamRemoteNumaHits = cacheStats.numRamRemoteNumaHits;
+  ret.numRamRemoteNumaAllocs = cacheStats.numRamRemoteNumaAllocs;
+  ret.hugePageBackedBytes = cache_->getHugePageBackedSize();
   ret.numNvmGets = cacheStats.numNvmGets;
   ret.numNvmGetMiss = cacheStats.numNvmGetMiss;
   ret.numNvmGetCoalesced = cacheStats.numNvmGetCoalesced;
@@ -533,6 +556,9 @@ Stats Cache<Allocator>::getStats() const {
 
   ret.slabsReleased = rebalanceStats.numSlabReleaseForRebalance;
   ret.numAbortedSlabReleases = cacheStats.numAbortedSlabReleases;
+  ret.slabsCompacted = cacheStats.slabCompactorStats.numSlabsCompacted;
+  ret.compactionBytesReclaimed =
+      cacheStats.slabCompactorStats.numBytesReclaimed;
   ret.moveAttemptsForSlabRelease = rebalanceStats.numMoveAttempts;
   ret.moveSuccessesForSlabRelease = rebalanceStats.numMoveSuccesses;
   ret.evictionAttemptsForSlabRelease = rebalanceStats.numEvictionAttempts;
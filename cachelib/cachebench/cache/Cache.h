@@ -386,12 +386,15 @@ MMConfigType makeMMConfig(CacheConfig const&);
 // LRU
 template <>
 inline typename LruAllocator::MMConfig makeMMConfig(CacheConfig const& config) {
-  return LruAllocator::MMConfig(config.lruRefreshSec,
-                                config.lruRefreshRatio,
-                                config.lruUpdateOnWrite,
-                                config.lruUpdateOnRead,
-                                config.tryLockUpdate,
-                                static_cast<uint8_t>(config.lruIpSpec));
+  LruAllocator::MMConfig mmConfig(config.lruRefreshSec,
+                                  config.lruRefreshRatio,
+                                  config.lruUpdateOnWrite,
+                                  config.lruUpdateOnRead,
+                                  config.tryLockUpdate,
+                                  static_cast<uint8_t>(config.lruIpSpec));
+  mmConfig.accessBufferSize =
+      static_cast<uint32_t>(config.lruAccessBufferSize);
+  return mmConfig;
 }
 
 // LRU
@@ -408,6 +411,14 @@ inline typename Lru2QAllocator::MMConfig makeMMConfig(
                                   config.lru2qColdPct);
 }
 
+// CLOCK
+template <>
+inline typename ClockAllocator::MMConfig makeMMConfig(
+    CacheConfig const& config) {
+  return ClockAllocator::MMConfig(config.lruUpdateOnWrite,
+                                  config.lruUpdateOnRead);
+}
+
 } // namespace cachebench
 } // namespace cachelib
 } // namespace facebook
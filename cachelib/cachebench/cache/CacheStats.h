@@ -35,6 +35,9 @@ struct Stats {
   uint64_t numCacheGets{0};
   uint64_t numCacheGetMiss{0};
   uint64_t numRamDestructorCalls{0};
+  uint64_t numRamRemoteNumaHits{0};
+  uint64_t numRamRemoteNumaAllocs{0};
+  uint64_t hugePageBackedBytes{0};
   uint64_t numNvmGets{0};
   uint64_t numNvmGetMiss{0};
   uint64_t numNvmGetCoalesced{0};
@@ -83,6 +86,8 @@ struct Stats {
 
   uint64_t slabsReleased{0};
   uint64_t numAbortedSlabReleases{0};
+  uint64_t slabsCompacted{0};
+  uint64_t compactionBytesReclaimed{0};
   uint64_t moveAttemptsForSlabRelease{0};
   uint64_t moveSuccessesForSlabRelease{0};
   uint64_t evictionAttemptsForSlabRelease{0};
@@ -114,6 +119,11 @@ struct Stats {
                           invertPctFn(allocFailures, allocAttempts))
         << std::endl;
     out << folly::sformat("RAM Evictions : {:,}", numEvictions) << std::endl;
+    if (hugePageBackedBytes > 0) {
+      out << folly::sformat("RAM in Huge Pages: {:,} MB",
+                            hugePageBackedBytes / (1024 * 1024))
+          << std::endl;
+    }
 
     if (numCacheGets > 0) {
       out << folly::sformat("Cache Gets    : {:,}", numCacheGets) << std::endl;
@@ -266,6 +276,13 @@ struct Stats {
           << std::endl;
     }
 
+    if (slabsCompacted > 0) {
+      out << folly::sformat("Compacted {:,} slabs, reclaimed {:,} MB",
+                            slabsCompacted,
+                            compactionBytesReclaimed / (1024 * 1024))
+          << std::endl;
+    }
+
     if (!nvmCounters.empty()) {
       out << "== NVM Counters Map ==" << std::endl;
       for (const auto& it : nvmCounters) {
@@ -273,6 +290,16 @@ struct Stats {
       }
     }
 
+    if (numRamRemoteNumaHits > 0 || numRamRemoteNumaAllocs > 0) {
+      const uint64_t ramHits = numCacheGets - numCacheGetMiss;
+      out << folly::sformat(
+                 "RAM Remote Numa Hits: {:,} ({:6.2f}%), Allocs: {:,}",
+                 numRamRemoteNumaHits,
+                 pctFn(numRamRemoteNumaHits, ramHits),
+                 numRamRemoteNumaAllocs)
+          << std::endl;
+    }
+
     if (numRamDestructorCalls > 0 || numNvmDestructorCalls > 0) {
       out << folly::sformat("Destructor executed from RAM {}, from NVM {}",
                             numRamDestructorCalls, numNvmDestructorCalls)
@@ -28,6 +28,8 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
   JSONSetVal(configJson, cacheSizeMB);
   JSONSetVal(configJson, poolRebalanceIntervalSec);
   JSONSetVal(configJson, moveOnSlabRelease);
+  JSONSetVal(configJson, slabCompactionIntervalMs);
+  JSONSetVal(configJson, slabCompactionMinFreePercent);
   JSONSetVal(configJson, rebalanceStrategy);
   JSONSetVal(configJson, rebalanceMinSlabs);
   JSONSetVal(configJson, rebalanceDiffRatio);
@@ -42,6 +44,7 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
   JSONSetVal(configJson, lruUpdateOnRead);
   JSONSetVal(configJson, tryLockUpdate);
   JSONSetVal(configJson, lruIpSpec);
+  JSONSetVal(configJson, lruAccessBufferSize);
 
   JSONSetVal(configJson, lru2qHotPct);
   JSONSetVal(configJson, lru2qColdPct);
@@ -67,6 +70,9 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
   JSONSetVal(configJson, navyBigHashBucketSize);
   JSONSetVal(configJson, navyBloomFilterPerBucketSize);
   JSONSetVal(configJson, navySmallItemMaxSize);
+  JSONSetVal(configJson, navyKangarooSizePct);
+  JSONSetVal(configJson, navyKangarooLogSizePct);
+  JSONSetVal(configJson, navyKangarooSetAdmissionThreshold);
   JSONSetVal(configJson, navyParcelMemoryMB);
   JSONSetVal(configJson, navyHitsReinsertionThreshold);
   JSONSetVal(configJson, navyProbabilityReinsertionThreshold);
@@ -80,6 +86,8 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
   JSONSetVal(configJson, truncateItemToOriginalAllocSizeInNvm);
   JSONSetVal(configJson, navyEncryption);
   JSONSetVal(configJson, deviceMaxWriteSize);
+  JSONSetVal(configJson, navyIoUringQueueDepth);
+  JSONSetVal(configJson, navyIoUringSqPoll);
 
   JSONSetVal(configJson, memoryOnlyTTL);
 
@@ -95,6 +103,8 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
 
   JSONSetVal(configJson, persistedCacheDir);
   JSONSetVal(configJson, usePosixShm);
+  JSONSetVal(configJson, hugePageFallback);
+  JSONSetVal(configJson, hugePages);
   if (configJson.count("memoryTiers")) {
     for (auto& it : configJson["memoryTiers"]) {
       memoryTierConfigs.push_back(MemoryTierConfig(it).getMemoryTierCacheConfig());
@@ -104,7 +114,7 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
   // if you added new fields to the configuration, update the JSONSetVal
   // to make them available for the json configs and increment the size
   // below
-  checkCorrectSize<CacheConfig, 752>();
+  checkCorrectSize<CacheConfig, 840>();
 
   if (numPools != poolSizes.size()) {
     throw std::invalid_argument(folly::sformat(
@@ -114,6 +124,22 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
   }
 }
 
+util::HugePagePolicy CacheConfig::getHugePagePolicy() const {
+  if (hugePages == "none") {
+    return util::HugePagePolicy::kNone;
+  } else if (hugePages == "thp") {
+    return util::HugePagePolicy::kTransparent;
+  } else if (hugePages == "2mb") {
+    return util::HugePagePolicy::kTwoMB;
+  } else if (hugePages == "1gb") {
+    return util::HugePagePolicy::kOneGB;
+  }
+  throw std::invalid_argument(
+      folly::sformat("Invalid hugePages: {}. Expected one of none, thp, 2mb, "
+                     "1gb",
+                     hugePages));
+}
+
 std::shared_ptr<RebalanceStrategy> CacheConfig::getRebalanceStrategy() const {
   if (poolRebalanceIntervalSec == 0) {
     return nullptr;
@@ -39,6 +39,7 @@ class CacheMonitorFactory {
   virtual ~CacheMonitorFactory() = default;
   virtual std::unique_ptr<CacheMonitor> create(LruAllocator& cache) = 0;
   virtual std::unique_ptr<CacheMonitor> create(Lru2QAllocator& cache) = 0;
+  virtual std::unique_ptr<CacheMonitor> create(ClockAllocator& cache) = 0;
 };
 
 struct MemoryTierConfig : public JSONConfig {
@@ -65,7 +66,7 @@ private:
 };
 
 struct CacheConfig : public JSONConfig {
-  // by defaullt, lru allocator. can be set to LRU-2Q.
+  // by defaullt, lru allocator. can be set to LRU2Q or CLOCK.
   std::string allocator{"LRU"};
 
   uint64_t cacheSizeMB{0};
@@ -75,6 +76,13 @@ struct CacheConfig : public JSONConfig {
   double rebalanceDiffRatio{0.25};
   bool moveOnSlabRelease{false};
 
+  // compact sparsely used slabs in the background. Needs moveOnSlabRelease.
+  // 0 disables compaction.
+  uint64_t slabCompactionIntervalMs{0};
+  // percentage of a slab's allocations that must be free for it to be
+  // compacted
+  uint64_t slabCompactionMinFreePercent{50};
+
   uint64_t htBucketPower{22}; // buckets in hash table
   uint64_t htLockPower{20};   // locks in hash table
 
@@ -95,6 +103,10 @@ struct CacheConfig : public JSONConfig {
   // LRU param
   uint64_t lruIpSpec{0};
 
+  // LRU param: number of buffered accesses per stripe before they are
+  // applied to the lru. 0 disables buffering.
+  uint64_t lruAccessBufferSize{0};
+
   // 2Q params
   size_t lru2qHotPct{20};
   size_t lru2qColdPct{20};
@@ -169,6 +181,18 @@ struct CacheConfig : public JSONConfig {
   // can be admitted into Big Hash engine.
   uint64_t navySmallItemMaxSize = 2048;
 
+  // percentage of the nvm cache size that is dedicated for objects that are
+  // smaller than @navySmallItemMaxSize in Kangaroo engine. If set, Kangaroo
+  // is used instead of BigHash, with the same bucket and bloom filter size.
+  uint64_t navyKangarooSizePct = 0;
+
+  // percentage of the Kangaroo space used for its log.
+  uint64_t navyKangarooLogSizePct = 5;
+
+  // Kangaroo drops the items moved out of the log to a set that has fewer
+  // items in the log than this threshold.
+  uint64_t navyKangarooSetAdmissionThreshold = 1;
+
   // total memory limit for in-flight insertion operations for NVM. Once this is
   // reached, requests will be rejected until the memory usage gets under
   // the limit.
@@ -213,6 +237,11 @@ struct CacheConfig : public JSONConfig {
   // Navy will split it into multiple IOs.
   uint32_t deviceMaxWriteSize{1024 * 1024};
 
+  // If not 0, Navy does the device IO through io_uring with up to this many
+  // IOs in flight. navyIoUringSqPoll makes a kernel thread poll for new IOs.
+  uint32_t navyIoUringQueueDepth{0};
+  bool navyIoUringSqPoll{false};
+
   // Don't write to flash if cache TTL is smaller than this value.
   // Not used when its value is 0.  In seconds.
   uint32_t memoryOnlyTTL{0};
@@ -222,6 +251,15 @@ struct CacheConfig : public JSONConfig {
 
   bool usePosixShm{false};
 
+  // fall back to transparent huge pages when the hugetlb pool can not back
+  // the cache.
+  bool hugePageFallback{true};
+
+  // huge pages backing the cache memory: "none", "thp", "2mb" or "1gb".
+  // Comparing runs that only differ in this shows how much of the throughput
+  // is lost to TLB misses.
+  std::string hugePages{"none"};
+
   std::vector<MemoryTierCacheConfig> memoryTierConfigs{};
 
   // If enabled, we will use nvm admission policy tuned for ML use cases
@@ -287,6 +325,9 @@ struct CacheConfig : public JSONConfig {
   CacheConfig() {}
 
   std::shared_ptr<RebalanceStrategy> getRebalanceStrategy() const;
+
+  // @throw std::invalid_argument if hugePages is not a known policy
+  util::HugePagePolicy getHugePagePolicy() const;
 };
 } // namespace cachebench
 } // namespace cachelib
@@ -0,0 +1,44 @@
+# Copyright (c) Facebook, Inc. and its affiliates.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+#
+# - Try to find liburing
+# This will define
+# URING_FOUND
+# URING_INCLUDE_DIRS
+# URING_LIBRARIES
+#
+
+find_path(
+  URING_INCLUDE_DIRS liburing.h
+  HINTS
+      $ENV{URING_ROOT}/include
+      ${URING_ROOT}/include
+)
+
+find_library(
+    URING_LIBRARIES uring
+    HINTS
+        $ENV{URING_ROOT}/lib
+        ${URING_ROOT}/lib
+)
+
+mark_as_advanced(URING_INCLUDE_DIRS URING_LIBRARIES)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Uring URING_INCLUDE_DIRS URING_LIBRARIES)
+
+if(URING_FOUND AND NOT URING_FIND_QUIETLY)
+    message(STATUS "URING: ${URING_INCLUDE_DIRS}")
+endif()
@@ -22,8 +22,10 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 
 #pragma GCC diagnostic push
@@ -31,10 +33,16 @@
 #include <folly/Format.h>
 #pragma GCC diagnostic pop
 #include <folly/Random.h>
+#include <folly/concurrency/CacheLocality.h>
 #include <folly/logging/xlog.h>
 
 #include "cachelib/common/Utils.h"
 
+/* On Mac OS / FreeBSD, madvise(2) does not support this flag */
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE 0
+#endif
+
 namespace facebook {
 namespace cachelib {
 namespace util {
@@ -164,23 +172,96 @@ void* align(size_t alignment, size_t size, void*& ptr, size_t& space) {
   return nullptr;
 }
 
-void* mmapAlignedZeroedMemory(size_t alignment,
-                              size_t numBytes,
-                              bool noAccess) {
+namespace {
+// maps numBytes aligned to alignment from the hugetlb pool. Returns an empty
+// mapping with errno set if the pool can not back the mapping.
+AlignedMapping mmapHugeTlbMemory(size_t alignment,
+                                 size_t numBytes,
+                                 int protFlag,
+                                 HugePagePolicy hugePages) {
+#if !defined(MAP_HUGETLB) || !defined(MAP_HUGE_SHIFT)
+  (void)alignment;
+  (void)numBytes;
+  (void)protFlag;
+  (void)hugePages;
+  errno = ENOTSUP;
+  return {};
+#else
+  const bool oneGB = hugePages == HugePagePolicy::kOneGB;
+  const size_t pageSize = oneGB ? 1024 * 1024 * 1024 : 2 * 1024 * 1024;
+  // huge page mappings are aligned to the page size by the kernel. Only a
+  // larger alignment needs extra room.
+  size_t newBytes = numBytes + (alignment > pageSize ? alignment : 0);
+  newBytes = (newBytes + pageSize - 1) / pageSize * pageSize;
+  // no MAP_NORESERVE so that an empty pool fails here instead of with a
+  // SIGBUS when the memory is touched.
+  const auto mapFlag = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                       ((oneGB ? 30 : 21) << MAP_HUGE_SHIFT);
+  void* memory = mmap(nullptr, newBytes, protFlag, mapFlag, -1, 0);
+  if (memory == MAP_FAILED) {
+    return {};
+  }
+  AlignedMapping mapping{nullptr, memory, newBytes};
+  mapping.memory = align(alignment, numBytes, memory, newBytes);
+  XDCHECK_NE(mapping.memory, nullptr);
+  return mapping;
+#endif
+}
+} // namespace
+
+AlignedMapping mmapAlignedZeroedMapping(size_t alignment,
+                                        size_t numBytes,
+                                        bool noAccess,
+                                        HugePagePolicy hugePages,
+                                        bool hugePageFallback) {
+  const auto protFlag = noAccess ? PROT_NONE : PROT_READ | PROT_WRITE;
+  if (hugePages == HugePagePolicy::kTwoMB ||
+      hugePages == HugePagePolicy::kOneGB) {
+    auto mapping = mmapHugeTlbMemory(alignment, numBytes, protFlag, hugePages);
+    if (mapping.memory != nullptr) {
+      return mapping;
+    }
+    if (!hugePageFallback) {
+      throw std::system_error(errno, std::system_category(),
+                              "Cannot mmap huge pages");
+    }
+    XLOGF(WARN,
+          "Cannot mmap {} bytes of huge pages, errno = {}. Falling back to "
+          "transparent huge pages",
+          numBytes, errno);
+    hugePages = HugePagePolicy::kTransparent;
+  }
+
   // to enforce alignment, we try to make sure that the address we return is
   // aligned to slab size.
   size_t newBytes = numBytes + alignment;
-  const auto protFlag = noAccess ? PROT_NONE : PROT_READ | PROT_WRITE;
   const auto mapFlag = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
   void* memory = mmap(nullptr, newBytes, protFlag, mapFlag, -1, 0);
   if (memory != MAP_FAILED) {
-    auto alignedMemory = align(alignment, numBytes, memory, newBytes);
-    XDCHECK_NE(alignedMemory, nullptr);
-    return alignedMemory;
+    AlignedMapping mapping{nullptr, memory, newBytes};
+    mapping.memory = align(alignment, numBytes, memory, newBytes);
+    XDCHECK_NE(mapping.memory, nullptr);
+    if (hugePages == HugePagePolicy::kTransparent &&
+        madvise(mapping.memory, numBytes, MADV_HUGEPAGE) != 0) {
+      // the memory works the same without them.
+      XLOGF(WARN, "Transparent huge pages are not available, errno = {}",
+            errno);
+    }
+    return mapping;
   }
   throw std::system_error(errno, std::system_category(), "Cannot mmap");
 }
 
+void* mmapAlignedZeroedMemory(size_t alignment,
+                              size_t numBytes,
+                              bool noAccess,
+                              HugePagePolicy hugePages,
+                              bool hugePageFallback) {
+  return mmapAlignedZeroedMapping(alignment, numBytes, noAccess, hugePages,
+                                  hugePageFallback)
+      .memory;
+}
+
 void setMaxLockMemory(uint64_t bytes) {
   struct rlimit rlim {
     bytes, bytes
@@ -419,6 +500,91 @@ size_t getMemAvailable() {
   return 0;
 }
 
+size_t getHugePageBackedBytes(const void* mem, size_t len) {
+  const auto* begin = reinterpret_cast<const uint8_t*>(mem);
+  return getHugePageBackedBytes({folly::ByteRange{begin, len}}).front();
+}
+
+std::vector<size_t> getHugePageBackedBytes(
+    const std::vector<folly::ByteRange>& ranges) {
+  std::vector<size_t> result(ranges.size(), 0);
+  std::string smaps;
+  if (ranges.empty() || !folly::readFile("/proc/self/smaps", smaps)) {
+    return result;
+  }
+
+  // the mapping the current lines belong to and the part of it that is in
+  // each range.
+  uintptr_t vmaSize = 0;
+  std::vector<uintptr_t> overlaps(ranges.size(), 0);
+  bool anyOverlap = false;
+  std::vector<double> hugeBytes(ranges.size(), 0);
+
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', smaps, lines, /* ignore empty */ true);
+  for (auto l : lines) {
+    // mappings start with a line of form
+    // 7f1c2a000000-7f1c2c000000 rw-s 00000000 00:05 1234  /SYSV00000000
+    // followed by lines of form
+    // AnonHugePages:      2048 kB
+    if (std::isdigit(l.front()) || std::islower(l.front())) {
+      const auto dash = l.find('-');
+      const auto space = l.find(' ');
+      if (dash == folly::StringPiece::npos || space < dash) {
+        return std::vector<size_t>(ranges.size(), 0);
+      }
+      const uintptr_t vmaStart =
+          strtoull(l.subpiece(0, dash).str().c_str(), nullptr, 16);
+      const uintptr_t vmaEnd = strtoull(
+          l.subpiece(dash + 1, space - dash - 1).str().c_str(), nullptr, 16);
+      vmaSize = vmaEnd - vmaStart;
+      anyOverlap = false;
+      for (size_t i = 0; i < ranges.size(); i++) {
+        const auto start = reinterpret_cast<uintptr_t>(ranges[i].begin());
+        const auto end = reinterpret_cast<uintptr_t>(ranges[i].end());
+        overlaps[i] = std::min(end, vmaEnd) > std::max(start, vmaStart)
+                          ? std::min(end, vmaEnd) - std::max(start, vmaStart)
+                          : 0;
+        anyOverlap |= overlaps[i] != 0;
+      }
+      continue;
+    }
+
+    if (!anyOverlap ||
+        !(l.startsWith("AnonHugePages:") || l.startsWith("ShmemPmdMapped:") ||
+          l.startsWith("FilePmdMapped:") || l.startsWith("Shared_Hugetlb:") ||
+          l.startsWith("Private_Hugetlb:"))) {
+      continue;
+    }
+    auto numStart = std::find_if(l.begin(), l.end(), isDigit);
+    auto numEnd = std::find_if_not(numStart, l.end(), isDigit);
+    if (numStart == numEnd) {
+      continue;
+    }
+    const auto kb = folly::to<size_t>(folly::StringPiece{numStart, numEnd});
+    // the counts are for the whole mapping. Attribute them evenly when only
+    // part of it is in a range.
+    for (size_t i = 0; i < ranges.size(); i++) {
+      hugeBytes[i] += static_cast<double>(kb) * 1024 * overlaps[i] / vmaSize;
+    }
+  }
+  for (size_t i = 0; i < ranges.size(); i++) {
+    result[i] = static_cast<size_t>(hugeBytes[i]);
+  }
+  return result;
+}
+
+unsigned getCurrentNumaNode() noexcept {
+  // resolving the vdso entry is expensive, calling it is not.
+  static const folly::Getcpu::Func getcpu = folly::Getcpu::resolveVdsoFunc();
+  unsigned cpu = 0;
+  unsigned node = 0;
+  if (getcpu == nullptr || getcpu(&cpu, &node, nullptr) != 0) {
+    return std::numeric_limits<unsigned>::max();
+  }
+  return node;
+}
+
 void printExceptionStackTraces() {
   auto exceptions = folly::exception_tracer::getCurrentExceptions();
   for (auto& exc : exceptions) {
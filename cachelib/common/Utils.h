@@ -24,6 +24,8 @@
 #include <folly/FileUtil.h>
 #include <folly/chrono/Hardware.h>
 
+#include <vector>
+
 namespace facebook {
 namespace cachelib {
 namespace util {
@@ -132,18 +134,71 @@ std::enable_if_t<std::is_arithmetic<T>::value, T> getAlignedSize(
   const T rem = size % alignment;
   return rem == 0 ? size : size + alignment - rem;
 }
+
+// How memory mapped for the cache is backed by huge pages.
+enum class HugePagePolicy {
+  // regular pages.
+  kNone,
+  // regular pages that the kernel may back by transparent huge pages,
+  // requested with madvise(MADV_HUGEPAGE). This is best effort.
+  kTransparent,
+  // 2MB pages from the hugetlb pool.
+  kTwoMB,
+  // 1GB pages from the hugetlb pool.
+  kOneGB,
+};
+
+// An aligned region of memory inside a mapping made for it. The mapping
+// is larger than the region because of the alignment and, for the hugetlb
+// pool, rounded up to the huge page size. munmap must be given the mapping,
+// not the region.
+struct AlignedMapping {
+  // the aligned memory
+  void* memory{nullptr};
+  // start and length of the whole mapping
+  void* mapStart{nullptr};
+  size_t mapSize{0};
+};
+
+// same as mmapAlignedZeroedMemory, but also returns the mapping so that the
+// caller can unmap all of it.
+//
+// @throw std::system_error if unable to create mapping
+AlignedMapping mmapAlignedZeroedMapping(
+    size_t alignment,
+    size_t numBytes,
+    bool noAccess = false,
+    HugePagePolicy hugePages = HugePagePolicy::kNone,
+    bool hugePageFallback = true);
+
 // creates a new mapping in the virtual address space of the calling process
 // aligned by the size of Slab.
 //
-// @param alignment   the desired alignment
-// @param numBytes    the length of the mapping
-// @param noAccess    whether or not this mapping is going to be accessed
+// @param alignment         the desired alignment
+// @param numBytes          the length of the mapping
+// @param noAccess          whether or not this mapping is going to be accessed
+// @param hugePages         the huge pages to back the mapping with
+// @param hugePageFallback  if the hugetlb pool can not back the mapping, use
+//                          transparent huge pages instead of failing
 // @return    pointer to aligned memory or nullptr on error
 //
 // @throw std::system_error if unable to create mapping
 void* mmapAlignedZeroedMemory(size_t alignment,
                               size_t numBytes,
-                              bool noAccess = false);
+                              bool noAccess = false,
+                              HugePagePolicy hugePages = HugePagePolicy::kNone,
+                              bool hugePageFallback = true);
+
+// returns the number of bytes in the range that are currently backed by huge
+// pages, either transparent or from the hugetlb pool. Returns 0 upon any
+// error. This reads /proc/self/smaps and is not meant for hot paths.
+size_t getHugePageBackedBytes(const void* mem, size_t len);
+
+// same as above for several ranges, reading /proc/self/smaps only once.
+//
+// @return  the huge page backed bytes of each range, in the same order.
+std::vector<size_t> getHugePageBackedBytes(
+    const std::vector<folly::ByteRange>& ranges);
 
 // get the number of pages in the range which are resident in the process.
 //
@@ -208,6 +263,11 @@ size_t getRSSBytes();
 // returns the current mem-available reported by the kernel. 0 means an error.
 size_t getMemAvailable();
 
+// returns the numa node of the cpu the calling thread runs on, or
+// std::numeric_limits<unsigned>::max() if it can not be determined. The thread
+// can migrate at any time, so the result is only a hint.
+unsigned getCurrentNumaNode() noexcept;
+
 // Print stack trace for the current exception thrown
 void printExceptionStackTraces();
 
@@ -19,6 +19,7 @@
 #include <sys/mman.h>
 
 #include <atomic>
+#include <cstring>
 
 #include "cachelib/common/FastStats.h"
 #include "cachelib/common/Utils.h"
@@ -171,6 +172,42 @@ TEST(Util, SysctlTests) {
 }
 
 TEST(Util, MemAvailable) { EXPECT_GT(util::getMemAvailable(), 0); }
+
+TEST(Util, HugePageMemory) {
+  const size_t alignment = 4 * 1024 * 1024;
+  const size_t size = 64 * 1024 * 1024;
+  for (auto policy :
+       {util::HugePagePolicy::kNone, util::HugePagePolicy::kTransparent,
+        util::HugePagePolicy::kTwoMB}) {
+    // an empty hugetlb pool falls back to transparent huge pages.
+    auto mapping = util::mmapAlignedZeroedMapping(
+        alignment, size, false /* noAccess */, policy,
+        true /* hugePageFallback */);
+    void* mem = mapping.memory;
+    ASSERT_NE(nullptr, mem);
+    EXPECT_LE(mapping.mapStart, mem);
+    EXPECT_LE(reinterpret_cast<uint8_t*>(mem) + size,
+              reinterpret_cast<uint8_t*>(mapping.mapStart) + mapping.mapSize);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(mem) % alignment);
+    std::memset(mem, 'a', size);
+    // only the part of the mapping in the range is counted.
+    EXPECT_LE(util::getHugePageBackedBytes(mem, size), size);
+    EXPECT_LE(util::getHugePageBackedBytes(mem, size / 2), size / 2);
+    // several ranges are counted in one pass over the mappings.
+    const auto* bytes = reinterpret_cast<const uint8_t*>(mem);
+    const auto perRange = util::getHugePageBackedBytes(
+        {folly::ByteRange{bytes, size / 2},
+         folly::ByteRange{bytes + size / 2, size / 2}});
+    ASSERT_EQ(2, perRange.size());
+    EXPECT_LE(perRange[0], size / 2);
+    EXPECT_LE(perRange[1], size / 2);
+    EXPECT_EQ(0, munmap(mapping.mapStart, mapping.mapSize));
+  }
+
+  // nothing is mapped at the start of the address space.
+  EXPECT_EQ(0, util::getHugePageBackedBytes(nullptr, 4096));
+  EXPECT_TRUE(util::getHugePageBackedBytes({}).empty());
+}
 } // namespace tests
 } // namespace cachelib
 } // namespace facebook
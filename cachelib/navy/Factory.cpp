@@ -28,6 +28,7 @@
 #include "cachelib/navy/block_cache/FifoPolicy.h"
 #include "cachelib/navy/block_cache/LruPolicy.h"
 #include "cachelib/navy/driver/Driver.h"
+#include "cachelib/navy/kangaroo/Kangaroo.h"
 #include "cachelib/navy/serialization/RecordIO.h"
 
 /* O_DIRECT not available on Mac OS */
@@ -113,6 +114,10 @@ class BlockCacheProtoImpl final : public BlockCacheProto {
     config_.itemDestructorEnabled = itemDestructorEnabled;
   }
 
+  void setFixedSizeIndex(uint64_t numEntries) override {
+    config_.fixedSizeIndexNumEntries = numEntries;
+  }
+
   std::unique_ptr<Engine> create(JobScheduler& scheduler,
                                  DestructorCallback cb) && {
     config_.scheduler = &scheduler;
@@ -148,6 +153,10 @@ class BigHashProtoImpl final : public BigHashProto {
     hashTableBitSize_ = hashTableBitSize;
   }
 
+  void setBucketCache(uint64_t size) override {
+    config_.bucketCacheSize = size;
+  }
+
   void setDevice(Device* device) { config_.device = device; }
 
   void setDestructorCb(DestructorCallback cb) {
@@ -172,6 +181,62 @@ class BigHashProtoImpl final : public BigHashProto {
   uint32_t hashTableBitSize_{};
 };
 
+class KangarooProtoImpl final : public KangarooProto {
+ public:
+  KangarooProtoImpl() = default;
+  ~KangarooProtoImpl() override = default;
+
+  void setLayout(uint64_t baseOffset,
+                 uint64_t size,
+                 uint32_t bucketSize) override {
+    config_.cacheBaseOffset = baseOffset;
+    config_.cacheSize = size;
+    config_.bucketSize = bucketSize;
+  }
+
+  void setLog(uint32_t logSizePct,
+              uint32_t numPartitions,
+              uint32_t segmentPages) override {
+    config_.logSizePct = logSizePct;
+    config_.numLogPartitions = numPartitions;
+    config_.logSegmentPages = segmentPages;
+  }
+
+  // As in BigHash, there is a bloom filter for every set
+  void setBloomFilter(uint32_t numHashes, uint32_t hashTableBitSize) override {
+    bloomFilterEnabled_ = true;
+    numHashes_ = numHashes;
+    hashTableBitSize_ = hashTableBitSize;
+  }
+
+  void setSetAdmissionThreshold(uint32_t threshold) override {
+    config_.setAdmissionThreshold = threshold;
+  }
+
+  void setDevice(Device* device) { config_.device = device; }
+
+  void setDestructorCb(DestructorCallback cb) {
+    config_.destructorCb = std::move(cb);
+  }
+
+  std::unique_ptr<Engine> create() && {
+    if (bloomFilterEnabled_) {
+      if (config_.bucketSize == 0) {
+        throw std::invalid_argument{"invalid bucket size"};
+      }
+      config_.bloomFilter = std::make_unique<BloomFilter>(
+          config_.numSets(), numHashes_, hashTableBitSize_);
+    }
+    return std::make_unique<Kangaroo>(std::move(config_));
+  }
+
+ private:
+  Kangaroo::Config config_;
+  bool bloomFilterEnabled_{false};
+  uint32_t numHashes_{};
+  uint32_t hashTableBitSize_{};
+};
+
 class CacheProtoImpl final : public CacheProto {
  public:
   CacheProtoImpl() = default;
@@ -201,6 +266,12 @@ class CacheProtoImpl final : public CacheProto {
     config_.smallItemMaxSize = smallItemMaxSize;
   }
 
+  void setKangaroo(std::unique_ptr<KangarooProto> proto,
+                   uint32_t smallItemMaxSize) override {
+    kangarooProto_ = std::move(proto);
+    config_.smallItemMaxSize = smallItemMaxSize;
+  }
+
   void setDestructorCallback(DestructorCallback cb) override {
     destructorCb_ = std::move(cb);
   }
@@ -258,6 +329,10 @@ class CacheProtoImpl final : public CacheProto {
       }
     }
 
+    if (bigHashProto_ && kangarooProto_) {
+      throw std::invalid_argument("big hash and kangaroo are both set");
+    }
+
     if (bigHashProto_) {
       auto bhProto = dynamic_cast<BigHashProtoImpl*>(bigHashProto_.get());
       if (bhProto != nullptr) {
@@ -267,6 +342,15 @@ class CacheProtoImpl final : public CacheProto {
       }
     }
 
+    if (kangarooProto_) {
+      auto kProto = dynamic_cast<KangarooProtoImpl*>(kangarooProto_.get());
+      if (kProto != nullptr) {
+        kProto->setDevice(config_.device.get());
+        kProto->setDestructorCb(destructorCb_);
+        config_.smallItemCache = std::move(*kProto).create();
+      }
+    }
+
     return std::make_unique<Driver>(std::move(config_));
   }
 
@@ -274,6 +358,7 @@ class CacheProtoImpl final : public CacheProto {
   DestructorCallback destructorCb_;
   std::unique_ptr<BlockCacheProto> blockCacheProto_;
   std::unique_ptr<BigHashProto> bigHashProto_;
+  std::unique_ptr<KangarooProto> kangarooProto_;
   Driver::Config config_;
 };
 // Open cache file @fileName and set it size to @size.
@@ -336,6 +421,10 @@ std::unique_ptr<BigHashProto> createBigHashProto() {
   return std::make_unique<BigHashProtoImpl>();
 }
 
+std::unique_ptr<KangarooProto> createKangarooProto() {
+  return std::make_unique<KangarooProtoImpl>();
+}
+
 std::unique_ptr<CacheProto> createCacheProto() {
   return std::make_unique<CacheProtoImpl>();
 }
@@ -351,7 +440,8 @@ std::unique_ptr<Device> createRAIDDevice(
     uint32_t blockSize,
     uint32_t stripeSize,
     std::shared_ptr<navy::DeviceEncryptor> encryptor,
-    uint32_t maxDeviceWriteSize) {
+    uint32_t maxDeviceWriteSize,
+    const IoUringOptions& ioUringOptions) {
   // File paths are opened in the increasing order of the
   // path string. This ensures that RAID0 stripes aren't
   // out of order even if the caller changes the order of
@@ -372,6 +462,11 @@ std::unique_ptr<Device> createRAIDDevice(
     fileVec.push_back(std::move(f));
   }
 
+  if (ioUringOptions.queueDepth > 0) {
+    return createIoUringDevice(std::move(fileVec), fdSize, blockSize,
+                               stripeSize, std::move(encryptor),
+                               maxDeviceWriteSize, ioUringOptions);
+  }
   return createDirectIoRAID0Device(std::move(fileVec),
                                    fdSize,
                                    blockSize,
@@ -386,7 +481,8 @@ std::unique_ptr<Device> createFileDevice(
     bool truncateFile,
     uint32_t blockSize,
     std::shared_ptr<navy::DeviceEncryptor> encryptor,
-    uint32_t maxDeviceWriteSize) {
+    uint32_t maxDeviceWriteSize,
+    const IoUringOptions& ioUringOptions) {
   folly::File f;
   try {
     f = openCacheFile(fileName, singleFileSize, truncateFile);
@@ -394,6 +490,13 @@ std::unique_ptr<Device> createFileDevice(
     XLOG(ERR) << "Exception in openCacheFile: " << e.what();
     throw;
   }
+  if (ioUringOptions.queueDepth > 0) {
+    std::vector<folly::File> fileVec;
+    fileVec.push_back(std::move(f));
+    return createIoUringDevice(std::move(fileVec), singleFileSize, blockSize,
+                               0 /* stripe size */, std::move(encryptor),
+                               maxDeviceWriteSize, ioUringOptions);
+  }
   return createDirectIoFileDevice(std::move(f), singleFileSize, blockSize,
                                   std::move(encryptor), maxDeviceWriteSize);
 }
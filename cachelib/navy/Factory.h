@@ -82,6 +82,10 @@ class BlockCacheProto {
 
   // (Optional) Set if the item destructor feature is enabled.
   virtual void setItemDestructorEnabled(bool itemDestructorEnabled) = 0;
+
+  // (Optional) Use a fixed size index with room for @numEntries entries
+  // instead of one that grows with the number of items.
+  virtual void setFixedSizeIndex(uint64_t numEntries) = 0;
 };
 
 // BigHash engine proto. BigHash is used to cache small objects (under 2KB)
@@ -102,6 +106,41 @@ class BigHashProto {
   // bit array of @hashTableBitSize bits.
   virtual void setBloomFilter(uint32_t numHashes,
                               uint32_t hashTableBitSize) = 0;
+
+  // (Optional) Cache up to @size bytes of written buckets in memory, so that
+  // writes to the same bucket are coalesced into one device write.
+  virtual void setBucketCache(uint64_t size) = 0;
+};
+
+// Kangaroo engine proto. Kangaroo caches small objects like BigHash, with a
+// log in front of its sets to write less. User sets up this proto object and
+// passes it to CacheProto::setKangaroo.
+class KangarooProto {
+ public:
+  virtual ~KangarooProto() = default;
+
+  // Set cache layout. Cache will start at @baseOffset and will be @size bytes
+  // on the device. Kangaroo divides its device space into log pages and sets
+  // of @bucketSize bytes.
+  virtual void setLayout(uint64_t baseOffset,
+                         uint64_t size,
+                         uint32_t bucketSize) = 0;
+
+  // Set the log to @logSizePct percent of the cache size, split in
+  // @numPartitions partitions that move @segmentPages pages at a time to the
+  // sets.
+  virtual void setLog(uint32_t logSizePct,
+                      uint32_t numPartitions,
+                      uint32_t segmentPages) = 0;
+
+  // Enable Bloom filter with @numHashes hash functions, each mapped into an
+  // bit array of @hashTableBitSize bits.
+  virtual void setBloomFilter(uint32_t numHashes,
+                              uint32_t hashTableBitSize) = 0;
+
+  // (Optional) Drop the items moved out of the log to a set that has fewer
+  // than @threshold items in the log. Default: 1
+  virtual void setSetAdmissionThreshold(uint32_t threshold) = 0;
 };
 
 // Cache object prototype. Setup cache desired parameters and pass proto to
@@ -130,6 +169,10 @@ class CacheProto {
   virtual void setBigHash(std::unique_ptr<BigHashProto> proto,
                           uint32_t smallItemMaxSize) = 0;
 
+  // Set up kangaroo engine. Can't be used along with big hash.
+  virtual void setKangaroo(std::unique_ptr<KangarooProto> proto,
+                           uint32_t smallItemMaxSize) = 0;
+
   // Set JobScheduler for async function calls.
   virtual void setJobScheduler(std::unique_ptr<JobScheduler> ex) = 0;
 
@@ -166,6 +209,9 @@ std::unique_ptr<BlockCacheProto> createBlockCacheProto();
 // Creates BigHash engine prototype.
 std::unique_ptr<BigHashProto> createBigHashProto();
 
+// Creates Kangaroo engine prototype.
+std::unique_ptr<KangarooProto> createKangarooProto();
+
 // Creates Cache object prototype.
 std::unique_ptr<CacheProto> createCacheProto();
 
@@ -182,6 +228,8 @@ std::unique_ptr<AbstractCache> createCache(std::unique_ptr<CacheProto> proto);
 // @param stripeSize            RAID stripe size
 // @param encryptor             encryption object
 // @param maxDeviceWriteSize    device maximum granularity of writes
+// @param ioUringOptions        io_uring options. The device does IO through
+//                              io_uring if the queue depth is not 0.
 std::unique_ptr<Device> createRAIDDevice(
     std::vector<std::string> raidPaths,
     uint64_t fdsize,
@@ -189,7 +237,8 @@ std::unique_ptr<Device> createRAIDDevice(
     uint32_t blockSize,
     uint32_t stripeSize,
     std::shared_ptr<DeviceEncryptor> encryptor,
-    uint32_t maxDeviceWriteSize);
+    uint32_t maxDeviceWriteSize,
+    const IoUringOptions& ioUringOptions = {});
 
 // Creates a direct IO single file device.
 //
@@ -199,13 +248,16 @@ std::unique_ptr<Device> createRAIDDevice(
 // @param blockSize             device block size
 // @param encryptor             encryption object
 // @param maxDeviceWriteSize    device maximum granularity of writes
+// @param ioUringOptions        io_uring options. The device does IO through
+//                              io_uring if the queue depth is not 0.
 std::unique_ptr<Device> createFileDevice(
     std::string fileName,
     uint64_t singleFileSize,
     bool truncateFile,
     uint32_t blockSize,
     std::shared_ptr<DeviceEncryptor> encryptor,
-    uint32_t maxDeviceWriteSize);
+    uint32_t maxDeviceWriteSize,
+    const IoUringOptions& ioUringOptions = {});
 
 } // namespace navy
 } // namespace cachelib
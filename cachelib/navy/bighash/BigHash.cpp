@@ -75,6 +75,13 @@ BigHash::Config& BigHash::Config::validate() {
                        bloomFilter->numFilters(),
                        numBuckets()));
   }
+
+  if (bucketCacheSize > 0 && bucketCacheSize < bucketSize) {
+    throw std::invalid_argument(folly::sformat(
+        "bucket cache size: {} cannot be smaller than bucket size: {}",
+        bucketCacheSize,
+        bucketSize));
+  }
   return *this;
 }
 
@@ -96,13 +103,19 @@ BigHash::BigHash(Config&& config, ValidConfigTag)
       numBuckets_{config.numBuckets()},
       bloomFilter_{std::move(config.bloomFilter)},
       device_{*config.device},
+      bucketCache_{config.bucketCacheSize > 0
+                       ? std::make_unique<BucketCache>(config.bucketCacheSize,
+                                                       config.bucketSize)
+                       : nullptr},
       sizeDist_{kMinSizeDistribution, bucketSize_,
                 kSizeDistributionGranularityFactor} {
   XLOGF(INFO,
-        "BigHash created: buckets: {}, bucket size: {}, base offset: {}",
+        "BigHash created: buckets: {}, bucket size: {}, base offset: {}, "
+        "cached buckets: {}",
         numBuckets_,
         bucketSize_,
-        cacheBaseOffset_);
+        cacheBaseOffset_,
+        bucketCache_ ? bucketCache_->getMaxNumBuckets() : 0);
   reset();
 }
 
@@ -113,6 +126,10 @@ void BigHash::reset() {
   if (bloomFilter_) {
     bloomFilter_->reset();
   }
+  // the cached buckets belong to the previous generation
+  if (bucketCache_) {
+    bucketCache_->reset();
+  }
 
   itemCount_.set(0);
   insertCount_.set(0);
@@ -130,6 +147,9 @@ void BigHash::reset() {
   checksumErrorCount_.set(0);
   sizeDist_.reset();
   usedSizeBytes_.set(0);
+  bucketCacheHitCount_.set(0);
+  bucketCacheCoalescedCount_.set(0);
+  bucketCacheWriteBackCount_.set(0);
 }
 
 double BigHash::bfFalsePositivePct() const {
@@ -163,6 +183,14 @@ void BigHash::getCounters(const CounterVisitor& visitor) const {
   visitor("navy_bh_bf_rebuilds", bfRebuildCount_.get());
   visitor("navy_bh_checksum_errors", checksumErrorCount_.get());
   visitor("navy_bh_used_size_bytes", usedSizeBytes_.get());
+  if (bucketCache_) {
+    visitor("navy_bh_bucket_cache_buckets", bucketCache_->getNumBuckets());
+    visitor("navy_bh_bucket_cache_hits", bucketCacheHitCount_.get());
+    visitor("navy_bh_bucket_cache_coalesced_writes",
+            bucketCacheCoalescedCount_.get());
+    visitor("navy_bh_bucket_cache_write_backs",
+            bucketCacheWriteBackCount_.get());
+  }
   auto snapshot = sizeDist_.getSnapshot();
   for (auto& kv : snapshot) {
     auto statName = folly::sformat("navy_bh_approx_bytes_in_size_{}", kv.first);
@@ -172,6 +200,7 @@ void BigHash::getCounters(const CounterVisitor& visitor) const {
 
 void BigHash::persist(RecordWriter& rw) {
   XLOG(INFO, "Starting bighash persist");
+  writeBackBuckets();
   serialization::BigHashPersistentData pd;
   *pd.version_ref() = kFormatVersion;
   *pd.generationTime_ref() = generationTime_.count();
@@ -249,13 +278,18 @@ Status BigHash::insert(HashedKey hk, BufferView value) {
 
   {
     std::unique_lock<folly::SharedMutex> lock{getMutex(bid)};
-    auto buffer = readBucket(bid);
-    if (buffer.isNull()) {
-      ioErrorCount_.inc();
-      return Status::DeviceError;
+    auto* cached = bucketCache_ ? bucketCache_->find(bid.index()) : nullptr;
+    Buffer buffer;
+    if (!cached) {
+      buffer = readBucket(bid);
+      if (buffer.isNull()) {
+        ioErrorCount_.inc();
+        return Status::DeviceError;
+      }
     }
 
-    auto* bucket = reinterpret_cast<Bucket*>(buffer.data());
+    auto* bucket =
+        reinterpret_cast<Bucket*>(cached ? cached->data() : buffer.data());
     oldRemainingBytes = bucket->remainingBytes();
     removed = bucket->remove(hk, cb);
     evicted = bucket->insert(hk, value, cb);
@@ -272,12 +306,9 @@ Status BigHash::insert(HashedKey hk, BufferView value) {
       }
     }
 
-    const auto res = writeBucket(bid, std::move(buffer));
-    if (!res) {
-      if (bloomFilter_) {
-        bloomFilter_->clear(bid.index());
-      }
-      ioErrorCount_.inc();
+    if (cached) {
+      bucketCacheCoalescedCount_.inc();
+    } else if (!commitBucket(bid, std::move(buffer))) {
       return Status::DeviceError;
     }
   }
@@ -298,7 +329,6 @@ Status BigHash::insert(HashedKey hk, BufferView value) {
   itemCount_.sub(evicted + removed);
   evictionCount_.add(evicted);
   logicalWrittenCount_.add(hk.key().size() + value.size());
-  physicalWrittenCount_.add(bucketSize_);
   succInsertCount_.inc();
   return Status::Ok;
 }
@@ -336,6 +366,16 @@ Status BigHash::lookup(HashedKey hk, Buffer& value) {
       return Status::NotFound;
     }
 
+    // a cached bucket can change once the lock is released, so the value is
+    // copied under the lock
+    if (bucketCache_) {
+      if (auto* cached = bucketCache_->find(bid.index())) {
+        bucketCacheHitCount_.inc();
+        return lookupInBucket(
+            *reinterpret_cast<const Bucket*>(cached->data()), hk, value);
+      }
+    }
+
     buffer = readBucket(bid);
     if (buffer.isNull()) {
       ioErrorCount_.inc();
@@ -345,7 +385,13 @@ Status BigHash::lookup(HashedKey hk, Buffer& value) {
     bucket = reinterpret_cast<Bucket*>(buffer.data());
   }
 
-  auto valueView = bucket->find(hk);
+  return lookupInBucket(*bucket, hk, value);
+}
+
+Status BigHash::lookupInBucket(const Bucket& bucket,
+                               HashedKey hk,
+                               Buffer& value) {
+  auto valueView = bucket.find(hk);
   if (valueView.isNull()) {
     bfFalsePositiveCount_.inc();
     return Status::NotFound;
@@ -376,13 +422,18 @@ Status BigHash::remove(HashedKey hk) {
       return Status::NotFound;
     }
 
-    auto buffer = readBucket(bid);
-    if (buffer.isNull()) {
-      ioErrorCount_.inc();
-      return Status::DeviceError;
+    auto* cached = bucketCache_ ? bucketCache_->find(bid.index()) : nullptr;
+    Buffer buffer;
+    if (!cached) {
+      buffer = readBucket(bid);
+      if (buffer.isNull()) {
+        ioErrorCount_.inc();
+        return Status::DeviceError;
+      }
     }
 
-    auto* bucket = reinterpret_cast<Bucket*>(buffer.data());
+    auto* bucket =
+        reinterpret_cast<Bucket*>(cached ? cached->data() : buffer.data());
     oldRemainingBytes = bucket->remainingBytes();
     if (!bucket->remove(hk, cb)) {
       bfFalsePositiveCount_.inc();
@@ -396,12 +447,9 @@ Status BigHash::remove(HashedKey hk) {
       bfRebuild(bid, bucket);
     }
 
-    const auto res = writeBucket(bid, std::move(buffer));
-    if (!res) {
-      if (bloomFilter_) {
-        bloomFilter_->clear(bid.index());
-      }
-      ioErrorCount_.inc();
+    if (cached) {
+      bucketCacheCoalescedCount_.inc();
+    } else if (!commitBucket(bid, std::move(buffer))) {
       return Status::DeviceError;
     }
   }
@@ -416,8 +464,7 @@ Status BigHash::remove(HashedKey hk) {
 
   // We do not bump logicalWrittenCount_ because logically a
   // remove operation does not write, but for BigHash, it does
-  // incur physical writes.
-  physicalWrittenCount_.add(bucketSize_);
+  // incur physical writes, counted once the bucket is written.
   succRemoveCount_.inc();
   return Status::Ok;
 }
@@ -446,6 +493,7 @@ void BigHash::bfRebuild(BucketId bid, const Bucket* bucket) {
 
 void BigHash::flush() {
   XLOG(INFO, "Flush big hash");
+  writeBackBuckets();
   device_.flush();
 }
 
@@ -485,7 +533,67 @@ Buffer BigHash::readBucket(BucketId bid) {
 bool BigHash::writeBucket(BucketId bid, Buffer buffer) {
   auto* bucket = reinterpret_cast<Bucket*>(buffer.data());
   bucket->setChecksum(Bucket::computeChecksum(buffer.view()));
-  return device_.write(getBucketOffset(bid), std::move(buffer));
+  if (!device_.write(getBucketOffset(bid), std::move(buffer))) {
+    return false;
+  }
+  physicalWrittenCount_.add(bucketSize_);
+  return true;
+}
+
+bool BigHash::storeBucket(BucketId bid, Buffer buffer) {
+  if (!writeBucket(bid, std::move(buffer))) {
+    if (bloomFilter_) {
+      bloomFilter_->clear(bid.index());
+    }
+    ioErrorCount_.inc();
+    return false;
+  }
+  return true;
+}
+
+bool BigHash::commitBucket(BucketId bid, Buffer buffer) {
+  if (!bucketCache_) {
+    return storeBucket(bid, std::move(buffer));
+  }
+
+  // We hold the lock of @bid, which may also be the lock of some of the
+  // buckets to evict. Other buckets are only evicted if their lock is free,
+  // so this never waits for another thread.
+  auto& lockedMutex = getMutex(bid);
+  auto evicted = bucketCache_->insert(
+      bid.index(), std::move(buffer), [this, &lockedMutex](uint32_t index) {
+        auto& mutex = getMutex(BucketId{index});
+        return &mutex == &lockedMutex || mutex.try_lock();
+      });
+
+  bool res = true;
+  for (auto& [index, evictedBuffer] : evicted) {
+    const BucketId evictedBid{index};
+    bucketCacheWriteBackCount_.inc();
+    const bool stored = storeBucket(evictedBid, std::move(evictedBuffer));
+    auto& mutex = getMutex(evictedBid);
+    if (&mutex != &lockedMutex) {
+      mutex.unlock();
+    } else if (evictedBid == bid) {
+      res = stored;
+    }
+  }
+  return res;
+}
+
+void BigHash::writeBackBuckets() {
+  if (!bucketCache_) {
+    return;
+  }
+  for (auto index : bucketCache_->getBucketIds()) {
+    const BucketId bid{index};
+    std::unique_lock<folly::SharedMutex> lock{getMutex(bid)};
+    auto buffer = bucketCache_->remove(index);
+    if (buffer) {
+      bucketCacheWriteBackCount_.inc();
+      storeBucket(bid, std::move(*buffer));
+    }
+  }
 }
 } // namespace navy
 } // namespace cachelib
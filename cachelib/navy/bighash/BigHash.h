@@ -24,6 +24,7 @@
 #include "cachelib/common/AtomicCounter.h"
 #include "cachelib/common/BloomFilter.h"
 #include "cachelib/navy/bighash/Bucket.h"
+#include "cachelib/navy/bighash/BucketCache.h"
 #include "cachelib/navy/common/Buffer.h"
 #include "cachelib/navy/common/Device.h"
 #include "cachelib/navy/common/Hash.h"
@@ -51,6 +52,15 @@ namespace navy {
 // However, this design gives us the ability to forgo an in-memory index and
 // instead look up our items directly from disk. In practice, this means BigHash
 // is a flash engine optimized for small items.
+//
+// Optionally, written buckets are kept in a DRAM bucket cache (see
+// BucketCache), so that several inserts and removes to a hot bucket cost a
+// single bucket write. A cached bucket is written to the device when it is
+// evicted from the bucket cache, or on flush() and persist(). Changes to
+// cached buckets that are not written back yet are lost on destruction
+// without flush() or persist(). They are lost on a crash too, which never
+// exposes a stale value: the cache is only recovered after persist(), and
+// its persisted state is invalidated once recovered.
 class BigHash final : public Engine {
  public:
   struct Config {
@@ -67,6 +77,10 @@ class BigHash final : public Engine {
     // Optional bloom filter to reduce IO
     std::unique_ptr<BloomFilter> bloomFilter;
 
+    // Optional bytes of DRAM to cache written buckets in. 0 to write every
+    // change of a bucket to the device right away.
+    uint64_t bucketCacheSize{0};
+
     uint64_t numBuckets() const { return cacheSize / bucketSize; }
 
     Config& validate();
@@ -106,14 +120,15 @@ class BigHash final : public Engine {
   // and DeviceError on error.
   Status remove(HashedKey hk) override;
 
-  // flush the device file
+  // write the cached buckets back and flush the device file
   void flush() override;
 
   // reset BigHash, this clears the bloom filter and all stats
   // data is invalidated even it is not physically removed.
   void reset() override;
 
-  // serialize BigHash state to a RecordWriter
+  // write the cached buckets back and serialize BigHash state to a
+  // RecordWriter
   void persist(RecordWriter& rw) override;
 
   // deserialize BigHash state from a RecordReader
@@ -153,6 +168,26 @@ class BigHash final : public Engine {
   Buffer readBucket(BucketId bid);
   bool writeBucket(BucketId bid, Buffer buffer);
 
+  // Writes a changed bucket to the device. On error, clears the bucket's
+  // bloom filter, since the bucket's content on the device is unknown.
+  // The bucket's write lock must be held.
+  //
+  // @return false on error
+  bool storeBucket(BucketId bid, Buffer buffer);
+
+  // Keeps a changed bucket that was read from the device in the bucket
+  // cache, and writes back the buckets this evicts. Without a bucket cache,
+  // writes the bucket to the device. The bucket's write lock must be held.
+  //
+  // @return false if the bucket had to be written and failed to
+  bool commitBucket(BucketId bid, Buffer buffer);
+
+  // Writes all the cached buckets back and drops them from the bucket cache
+  void writeBackBuckets();
+
+  // Finds the key in the bucket and copies its value
+  Status lookupInBucket(const Bucket& bucket, HashedKey hk, Buffer& value);
+
   // The corresponding r/w bucket lock must be held during the entire
   // duration of the read and write operations. For example, during write,
   // if write lock is dropped after a bucket is read from device, user
@@ -193,6 +228,8 @@ class BigHash final : public Engine {
   Device& device_;
   std::unique_ptr<folly::SharedMutex[]> mutex_{
       new folly::SharedMutex[kNumMutexes]};
+  // nullptr when the bucket cache is disabled
+  std::unique_ptr<BucketCache> bucketCache_;
 
   // thread local counters in synchronized path
   mutable TLCounter lookupCount_;
@@ -215,6 +252,9 @@ class BigHash final : public Engine {
   mutable AtomicCounter checksumErrorCount_;
   mutable SizeDistribution sizeDist_;
   mutable AtomicCounter usedSizeBytes_;
+  mutable AtomicCounter bucketCacheHitCount_;
+  mutable AtomicCounter bucketCacheCoalescedCount_;
+  mutable AtomicCounter bucketCacheWriteBackCount_;
 
   static_assert((kNumMutexes & (kNumMutexes - 1)) == 0,
                 "number of mutexes must be power of two");
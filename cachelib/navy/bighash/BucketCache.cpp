@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/navy/bighash/BucketCache.h"
+
+#include <folly/Format.h>
+#include <folly/logging/xlog.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+namespace {
+uint64_t computeNumBuckets(uint64_t maxSize, uint32_t bucketSize) {
+  const uint64_t numBuckets = bucketSize == 0 ? 0 : maxSize / bucketSize;
+  if (numBuckets == 0) {
+    throw std::invalid_argument(
+        folly::sformat("bucket cache size: {} is smaller than bucket size: {}",
+                       maxSize,
+                       bucketSize));
+  }
+  return numBuckets;
+}
+} // namespace
+
+constexpr uint32_t BucketCache::kMaxNumPartitions;
+
+BucketCache::BucketCache(uint64_t maxSize, uint32_t bucketSize)
+    : numPartitions_{static_cast<uint32_t>(std::min<uint64_t>(
+          kMaxNumPartitions, computeNumBuckets(maxSize, bucketSize)))},
+      maxBucketsPerPartition_{static_cast<uint32_t>(
+          computeNumBuckets(maxSize, bucketSize) / numPartitions_)},
+      partitions_{new Partition[numPartitions_]} {}
+
+Buffer* BucketCache::find(uint32_t bid) {
+  auto& partition = getPartition(bid);
+  std::lock_guard<std::mutex> lock{partition.mutex};
+  auto it = partition.nodes.find(bid);
+  if (it == partition.nodes.end()) {
+    return nullptr;
+  }
+  partition.lru.splice(partition.lru.begin(), partition.lru, it->second);
+  return &it->second->buffer;
+}
+
+std::vector<std::pair<uint32_t, Buffer>> BucketCache::insert(
+    uint32_t bid, Buffer buffer, TryLockBucket tryLock) {
+  std::vector<std::pair<uint32_t, Buffer>> evicted;
+  auto& partition = getPartition(bid);
+  std::lock_guard<std::mutex> lock{partition.mutex};
+  XDCHECK(partition.nodes.find(bid) == partition.nodes.end());
+  partition.lru.emplace_front(bid, std::move(buffer));
+  partition.nodes.emplace(bid, partition.lru.begin());
+
+  // Buckets locked by other threads are skipped. The bucket just added is
+  // the last candidate, and the caller holds its lock, so this always
+  // brings the partition back to its budget.
+  auto it = partition.lru.end();
+  while (partition.lru.size() > maxBucketsPerPartition_ &&
+         it != partition.lru.begin()) {
+    --it;
+    if (!tryLock(it->bid)) {
+      continue;
+    }
+    partition.nodes.erase(it->bid);
+    evicted.emplace_back(it->bid, std::move(it->buffer));
+    it = partition.lru.erase(it);
+  }
+  XDCHECK_LE(partition.lru.size(), maxBucketsPerPartition_);
+  return evicted;
+}
+
+folly::Optional<Buffer> BucketCache::remove(uint32_t bid) {
+  auto& partition = getPartition(bid);
+  std::lock_guard<std::mutex> lock{partition.mutex};
+  auto it = partition.nodes.find(bid);
+  if (it == partition.nodes.end()) {
+    return folly::none;
+  }
+  auto buffer = std::move(it->second->buffer);
+  partition.lru.erase(it->second);
+  partition.nodes.erase(it);
+  return buffer;
+}
+
+std::vector<uint32_t> BucketCache::getBucketIds() const {
+  std::vector<uint32_t> bids;
+  for (uint32_t i = 0; i < numPartitions_; i++) {
+    std::lock_guard<std::mutex> lock{partitions_[i].mutex};
+    for (const auto& node : partitions_[i].lru) {
+      bids.push_back(node.bid);
+    }
+  }
+  return bids;
+}
+
+void BucketCache::reset() {
+  for (uint32_t i = 0; i < numPartitions_; i++) {
+    std::lock_guard<std::mutex> lock{partitions_[i].mutex};
+    partitions_[i].nodes.clear();
+    partitions_[i].lru.clear();
+  }
+}
+
+uint64_t BucketCache::getNumBuckets() const {
+  uint64_t numBuckets = 0;
+  for (uint32_t i = 0; i < numPartitions_; i++) {
+    std::lock_guard<std::mutex> lock{partitions_[i].mutex};
+    numBuckets += partitions_[i].lru.size();
+  }
+  return numBuckets;
+}
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
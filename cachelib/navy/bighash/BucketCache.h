@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Function.h>
+#include <folly/Optional.h>
+#include <folly/container/F14Map.h>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "cachelib/navy/common/Buffer.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+// A DRAM write-back cache of BigHash buckets. A bucket that is written
+// stays in memory, so that following writes to the bucket only change the
+// memory copy and reads of the bucket don't go to the device. The bucket is
+// written to the device once it is evicted from the cache.
+//
+// The cache is split in partitions, each with its own budget of buckets and
+// its own LRU order. A bucket is only evicted to make room in its partition.
+//
+// The cache only synchronizes its own structure. The caller must hold the
+// lock of a bucket while it uses the bucket's buffer, and evicts a bucket
+// only after it locked the bucket too. This keeps a bucket from being read
+// from the device while its latest content is still in memory.
+class BucketCache {
+ public:
+  // Tries to lock the bucket with the given id for writing
+  //
+  // @return true if the bucket is locked
+  using TryLockBucket = folly::FunctionRef<bool(uint32_t)>;
+
+  // @param maxSize     bytes of memory for the buckets
+  // @param bucketSize  size of a bucket
+  //
+  // @throw std::invalid_argument if @maxSize can not hold a bucket
+  BucketCache(uint64_t maxSize, uint32_t bucketSize);
+  BucketCache(const BucketCache&) = delete;
+  BucketCache& operator=(const BucketCache&) = delete;
+
+  // Returns the buffer of bucket @bid and marks it most recently used, or
+  // nullptr if the bucket isn't cached.
+  Buffer* find(uint32_t bid);
+
+  // Adds @buffer as the content of bucket @bid, which must not be cached.
+  // Then evicts the least recently used buckets of the partition until it
+  // fits its budget. A bucket is evicted only if @tryLock locks it. If no
+  // other bucket can be evicted, @bid itself is.
+  //
+  // @return  the evicted buckets, locked. The caller writes them to the
+  //          device, then unlocks them.
+  std::vector<std::pair<uint32_t, Buffer>> insert(uint32_t bid,
+                                                  Buffer buffer,
+                                                  TryLockBucket tryLock);
+
+  // Removes bucket @bid from the cache
+  //
+  // @return the buffer of the bucket, or none if it wasn't cached
+  folly::Optional<Buffer> remove(uint32_t bid);
+
+  // Returns the ids of the cached buckets
+  std::vector<uint32_t> getBucketIds() const;
+
+  // Drops all the buckets without writing them
+  void reset();
+
+  // Returns the number of cached buckets
+  uint64_t getNumBuckets() const;
+
+  // Returns the maximum number of cached buckets
+  uint64_t getMaxNumBuckets() const {
+    return uint64_t{maxBucketsPerPartition_} * numPartitions_;
+  }
+
+ private:
+  static constexpr uint32_t kMaxNumPartitions{64};
+
+  struct Node {
+    Node(uint32_t b, Buffer buf) : bid{b}, buffer{std::move(buf)} {}
+
+    const uint32_t bid;
+    Buffer buffer;
+  };
+
+  struct Partition {
+    mutable std::mutex mutex;
+    // the most recently used bucket is at the front
+    std::list<Node> lru;
+    folly::F14FastMap<uint32_t, std::list<Node>::iterator> nodes;
+  };
+
+  Partition& getPartition(uint32_t bid) const {
+    return partitions_[bid % numPartitions_];
+  }
+
+  const uint32_t numPartitions_{};
+  const uint32_t maxBucketsPerPartition_{};
+  std::unique_ptr<Partition[]> partitions_;
+};
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -14,10 +14,12 @@
  * limitations under the License.
  */
 
+#include <folly/Format.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include <map>
+#include <thread>
 
 #include "cachelib/navy/bighash/BigHash.h"
 #include "cachelib/navy/driver/Driver.h"
@@ -42,6 +44,14 @@ void setLayout(BigHash::Config& config, uint32_t bs, uint32_t numBuckets) {
   config.bucketSize = bs;
   config.cacheSize = uint64_t{bs} * numBuckets;
 }
+
+std::map<std::string, double> getCounters(const BigHash& bh) {
+  std::map<std::string, double> counters;
+  bh.getCounters([&counters](folly::StringPiece name, double count) {
+    counters[name.str()] = count;
+  });
+  return counters;
+}
 } // namespace
 
 TEST(BigHash, InsertAndRemove) {
@@ -707,6 +717,177 @@ TEST(BigHash, DestructorCallbackOutsideLock) {
   done = true;
   t.join();
 }
+
+TEST(BigHash, BucketCacheCoalescesWrites) {
+  BigHash::Config config;
+  setLayout(config, 256, 1);
+  config.bucketCacheSize = 256;
+  auto device = std::make_unique<NiceMock<MockDevice>>(config.cacheSize, 256);
+  config.device = device.get();
+
+  BigHash bh(std::move(config));
+
+  // The bucket is read once, then changed and read in memory only
+  EXPECT_CALL(*device, readImpl(0, 256, _)).Times(1);
+  EXPECT_CALL(*device, writeImpl(_, _, _)).Times(0);
+  EXPECT_EQ(Status::Ok, bh.insert(makeHK("key 1"), makeView("1")));
+  EXPECT_EQ(Status::Ok, bh.insert(makeHK("key 2"), makeView("2")));
+  EXPECT_EQ(Status::Ok, bh.insert(makeHK("key 3"), makeView("3")));
+  EXPECT_EQ(Status::Ok, bh.remove(makeHK("key 1")));
+
+  Buffer value;
+  EXPECT_EQ(Status::NotFound, bh.lookup(makeHK("key 1"), value));
+  EXPECT_EQ(Status::Ok, bh.lookup(makeHK("key 3"), value));
+  EXPECT_EQ(makeView("3"), value.view());
+  testing::Mock::VerifyAndClearExpectations(device.get());
+
+  // All the changes take a single write
+  EXPECT_CALL(*device, writeImpl(0, 256, _)).Times(1);
+  bh.flush();
+  testing::Mock::VerifyAndClearExpectations(device.get());
+
+  auto counters = getCounters(bh);
+  EXPECT_EQ(2, counters["navy_bh_items"]);
+  EXPECT_EQ(256, counters["navy_bh_physical_written"]);
+  EXPECT_EQ(3, counters["navy_bh_bucket_cache_coalesced_writes"]);
+  EXPECT_EQ(2, counters["navy_bh_bucket_cache_hits"]);
+  EXPECT_EQ(1, counters["navy_bh_bucket_cache_write_backs"]);
+  EXPECT_EQ(0, counters["navy_bh_bucket_cache_buckets"]);
+
+  // Flushed buckets are read from the device again
+  EXPECT_CALL(*device, readImpl(0, 256, _)).Times(1);
+  EXPECT_EQ(Status::Ok, bh.lookup(makeHK("key 2"), value));
+  EXPECT_EQ(makeView("2"), value.view());
+}
+
+TEST(BigHash, BucketCacheEviction) {
+  BigHash::Config config;
+  setLayout(config, 256, 16);
+  config.bucketCacheSize = 2 * 256;
+  auto device = std::make_unique<NiceMock<MockDevice>>(config.cacheSize, 256);
+  config.device = device.get();
+
+  BigHash bh(std::move(config));
+
+  for (int i = 0; i < 32; i++) {
+    const auto key = folly::sformat("key {}", i);
+    EXPECT_EQ(Status::Ok, bh.insert(makeHK(key.c_str()), makeView("v")));
+    // The cache never holds more buckets than its budget
+    EXPECT_GE(2, getCounters(bh)["navy_bh_bucket_cache_buckets"]);
+  }
+
+  // Items of evicted buckets are read back from the device
+  for (int i = 0; i < 32; i++) {
+    const auto key = folly::sformat("key {}", i);
+    Buffer value;
+    EXPECT_EQ(Status::Ok, bh.lookup(makeHK(key.c_str()), value));
+    EXPECT_EQ(makeView("v"), value.view());
+  }
+
+  auto counters = getCounters(bh);
+  EXPECT_LT(0, counters["navy_bh_bucket_cache_write_backs"]);
+  EXPECT_EQ(counters["navy_bh_bucket_cache_write_backs"] * 256,
+            counters["navy_bh_physical_written"]);
+}
+
+TEST(BigHash, BucketCacheDeviceError) {
+  BigHash::Config config;
+  setLayout(config, 256, 1);
+  config.bucketCacheSize = 256;
+  auto device = std::make_unique<NiceMock<MockDevice>>(config.cacheSize, 256);
+  config.device = device.get();
+
+  BigHash bh(std::move(config));
+  EXPECT_EQ(Status::Ok, bh.insert(makeHK("key"), makeView("1")));
+
+  // The write error is only seen once the bucket is written back, and the
+  // changes to the bucket are lost
+  EXPECT_CALL(*device, writeImpl(0, 256, _)).WillOnce(Return(false));
+  bh.flush();
+  EXPECT_EQ(1, getCounters(bh)["navy_bh_io_errors"]);
+  EXPECT_EQ(0, getCounters(bh)["navy_bh_physical_written"]);
+
+  Buffer value;
+  EXPECT_EQ(Status::NotFound, bh.lookup(makeHK("key"), value));
+}
+
+TEST(BigHash, BucketCacheRecovery) {
+  auto device = createMemoryDevice(16 * 1024, nullptr /* encryption */);
+  auto makeConfig = [&device] {
+    BigHash::Config config;
+    config.cacheSize = 16 * 1024;
+    config.bucketCacheSize = 16 * 1024;
+    config.device = device.get();
+    return config;
+  };
+
+  BigHash bh(makeConfig());
+  EXPECT_EQ(Status::Ok, bh.insert(makeHK("key 1"), makeView("1")));
+
+  // persist writes the cached buckets back
+  folly::IOBufQueue queue;
+  auto rw = createMemoryRecordWriter(queue);
+  bh.persist(*rw);
+
+  // Changes after persist stay in memory. A cache recovered from the
+  // persisted state, as it would be after a crash, doesn't see them.
+  EXPECT_EQ(Status::Ok, bh.insert(makeHK("key 2"), makeView("2")));
+  EXPECT_EQ(Status::Ok, bh.remove(makeHK("key 1")));
+
+  BigHash recovered(makeConfig());
+  auto rr = createMemoryRecordReader(queue);
+  ASSERT_TRUE(recovered.recover(*rr));
+
+  Buffer value;
+  EXPECT_EQ(Status::Ok, recovered.lookup(makeHK("key 1"), value));
+  EXPECT_EQ(makeView("1"), value.view());
+  EXPECT_EQ(Status::NotFound, recovered.lookup(makeHK("key 2"), value));
+
+  // Once flushed, the changes are on the device
+  bh.flush();
+  EXPECT_EQ(Status::NotFound, recovered.lookup(makeHK("key 1"), value));
+  EXPECT_EQ(Status::Ok, recovered.lookup(makeHK("key 2"), value));
+  EXPECT_EQ(makeView("2"), value.view());
+}
+
+TEST(BigHash, BucketCacheConcurrentInserts) {
+  BigHash::Config config;
+  setLayout(config, 4096, 64);
+  config.bucketCacheSize = 4 * 4096;
+  auto device = createMemoryDevice(config.cacheSize, nullptr /* encryption */);
+  config.device = device.get();
+
+  BigHash bh(std::move(config));
+
+  constexpr int kNumThreads = 4;
+  constexpr int kNumKeys = 200;
+  auto makeKey = [](int t, int i) { return folly::sformat("key {} {}", t, i); };
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&bh, &makeKey, t] {
+      for (int i = 0; i < kNumKeys; i++) {
+        const auto key = makeKey(t, i);
+        EXPECT_EQ(Status::Ok, bh.insert(makeHK(key.c_str()), makeView("v")));
+        Buffer value;
+        EXPECT_EQ(Status::Ok, bh.lookup(makeHK(key.c_str()), value));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_GE(4, getCounters(bh)["navy_bh_bucket_cache_buckets"]);
+
+  bh.flush();
+  for (int t = 0; t < kNumThreads; t++) {
+    for (int i = 0; i < kNumKeys; i++) {
+      const auto key = makeKey(t, i);
+      Buffer value;
+      EXPECT_EQ(Status::Ok, bh.lookup(makeHK(key.c_str()), value));
+    }
+  }
+  EXPECT_EQ(kNumThreads * kNumKeys, getCounters(bh)["navy_bh_items"]);
+}
 } // namespace tests
 } // namespace navy
 } // namespace cachelib
@@ -24,6 +24,8 @@
 #include <numeric>
 #include <utility>
 
+#include "cachelib/navy/block_cache/FixedSizeIndex.h"
+#include "cachelib/navy/block_cache/SparseMapIndex.h"
 #include "cachelib/navy/common/Hash.h"
 #include "cachelib/navy/common/Types.h"
 
@@ -129,6 +131,7 @@ BlockCache::BlockCache(Config&& config, ValidConfigTag)
                           : config.readBufferSize},
       regionSize_{config.regionSize},
       itemDestructorEnabled_{config.itemDestructorEnabled},
+      index_{makeIndex(config)},
       regionManager_{config.getNumRegions(),
                      config.regionSize,
                      config.cacheBaseOffset,
@@ -149,11 +152,18 @@ BlockCache::BlockCache(Config&& config, ValidConfigTag)
   XLOG(INFO, "Block cache created");
   XDCHECK_NE(readBufferSize_, 0u);
 }
+std::unique_ptr<Index> BlockCache::makeIndex(const Config& config) {
+  if (config.fixedSizeIndexNumEntries > 0) {
+    return std::make_unique<FixedSizeIndex>(config.fixedSizeIndexNumEntries);
+  }
+  return std::make_unique<SparseMapIndex>();
+}
+
 std::shared_ptr<BlockCacheReinsertionPolicy> BlockCache::makeReinsertionPolicy(
     const BlockCacheReinsertionConfig& reinsertionConfig) {
   auto hitsThreshold = reinsertionConfig.getHitsThreshold();
   if (hitsThreshold) {
-    return std::make_shared<HitsReinsertionPolicy>(hitsThreshold, index_);
+    return std::make_shared<HitsReinsertionPolicy>(hitsThreshold, *index_);
   }
 
   auto pctThreshold = reinsertionConfig.getPctThreshold();
@@ -165,7 +175,7 @@ std::shared_ptr<BlockCacheReinsertionPolicy> BlockCache::makeReinsertionPolicy(
 
 uint32_t BlockCache::serializedSize(uint32_t keySize,
                                     uint32_t valueSize,
-                                    bool ioAligned) {
+                                    bool ioAligned) const {
   uint32_t size = sizeof(EntryDesc) + keySize + valueSize;
   return ioAligned ? getAlignedSize(size) : size;
 }
@@ -197,9 +207,9 @@ Status BlockCache::insert(HashedKey hk, BufferView value) {
   // region would not be reclaimed and index never gets an invalid entry.
   const auto status = writeEntry(addr, slotSize, hk, value);
   if (status == Status::Ok) {
-    const auto lr = index_.insert(hk.keyHash(),
-                                  encodeRelAddress(addr.add(slotSize)),
-                                  encodeSizeHint(slotSize));
+    const auto lr = index_->insert(hk.keyHash(),
+                                   encodeRelAddress(addr.add(slotSize)),
+                                   encodeSizeHint(slotSize));
     // We replaced an existing key in the index
     if (lr.found()) {
       holeSizeTotal_.add(regionManager_.getRegionSlotSize(
@@ -215,7 +225,7 @@ Status BlockCache::insert(HashedKey hk, BufferView value) {
 }
 
 bool BlockCache::couldExist(HashedKey hk) {
-  const auto lr = index_.lookup(hk.keyHash());
+  const auto lr = index_->lookup(hk.keyHash());
   if (!lr.found()) {
     lookupCount_.inc();
     return false;
@@ -225,7 +235,7 @@ bool BlockCache::couldExist(HashedKey hk) {
 
 Status BlockCache::lookup(HashedKey hk, Buffer& value) {
   const auto seqNumber = regionManager_.getSeqNumber();
-  const auto lr = index_.lookup(hk.keyHash());
+  const auto lr = index_->lookup(hk.keyHash());
   if (!lr.found()) {
     lookupCount_.inc();
     return Status::NotFound;
@@ -263,6 +273,82 @@ Status BlockCache::lookup(HashedKey hk, Buffer& value) {
   }
 }
 
+void BlockCache::lookupAsync(HashedKey hk, LookupDoneCallback cb) {
+  const auto seqNumber = regionManager_.getSeqNumber();
+  const auto lr = index_->lookup(hk.keyHash());
+  if (!lr.found()) {
+    lookupCount_.inc();
+    cb(Status::NotFound, Buffer{});
+    return;
+  }
+  // See lookup for the address and sequence number handling
+  auto addrEnd = decodeRelAddress(lr.address());
+  RegionDescriptor desc = regionManager_.openForRead(addrEnd.rid(), seqNumber);
+  switch (desc.status()) {
+  case OpenStatus::Ready: {
+    auto size = getEntryReadSize(addrEnd, decodeSizeHint(lr.sizeHint()));
+    readEntryAsync(std::make_unique<AsyncLookup>(std::move(desc), addrEnd, hk,
+                                                 std::move(cb)),
+                   size);
+    return;
+  }
+  case OpenStatus::Retry:
+    cb(Status::Retry, Buffer{});
+    return;
+  default:
+    // Open region never returns other statuses than above
+    XDCHECK(false) << "unreachable";
+    cb(Status::DeviceError, Buffer{});
+  }
+}
+
+void BlockCache::readEntryAsync(std::unique_ptr<AsyncLookup> lookup,
+                                uint32_t size) {
+  auto& desc = lookup->desc;
+  const auto addr = lookup->addrEnd.sub(size);
+  regionManager_.readAsync(
+      desc, addr, size,
+      [this, lookup = std::move(lookup)](Buffer buffer) mutable {
+        onEntryRead(std::move(lookup), std::move(buffer));
+      });
+}
+
+void BlockCache::onEntryRead(std::unique_ptr<AsyncLookup> lookup,
+                             Buffer buffer) {
+  if (buffer.isNull()) {
+    completeLookup(std::move(lookup), Status::DeviceError, Buffer{});
+    return;
+  }
+  uint32_t entrySize = 0;
+  auto status = checkEntryDesc(buffer, lookup->hk, entrySize);
+  if (status != Status::Ok) {
+    completeLookup(std::move(lookup), status, Buffer{});
+    return;
+  }
+  if (buffer.size() < entrySize) {
+    // Read less than actual size. Read again with proper buffer.
+    readEntryAsync(std::move(lookup), entrySize);
+    return;
+  }
+  Buffer value;
+  status = extractValue(std::move(buffer), value);
+  completeLookup(std::move(lookup), status, std::move(value));
+}
+
+void BlockCache::completeLookup(std::unique_ptr<AsyncLookup> lookup,
+                                Status status,
+                                Buffer value) {
+  if (status == Status::Ok) {
+    regionManager_.touch(lookup->addrEnd.rid());
+    succLookupCount_.inc();
+  }
+  regionManager_.close(std::move(lookup->desc));
+  lookupCount_.inc();
+  auto cb = std::move(lookup->cb);
+  lookup.reset();
+  cb(status, std::move(value));
+}
+
 Status BlockCache::remove(HashedKey hk) {
   removeCount_.inc();
 
@@ -283,7 +369,7 @@ Status BlockCache::remove(HashedKey hk) {
     }
   }
 
-  auto lr = index_.remove(hk.keyHash());
+  auto lr = index_->remove(hk.keyHash());
   if (lr.found()) {
     auto addr = decodeRelAddress(lr.address());
     holeSizeTotal_.add(regionManager_.getRegionSlotSize(addr.rid()));
@@ -447,7 +533,7 @@ bool BlockCache::removeItem(HashedKey hk,
                             uint32_t entrySize,
                             RelAddress currAddr) {
   sizeDist_.removeSize(entrySize);
-  if (index_.removeIfMatch(hk.keyHash(), encodeRelAddress(currAddr))) {
+  if (index_->removeIfMatch(hk.keyHash(), encodeRelAddress(currAddr))) {
     return true;
   }
   evictionLookupMissCounter_.inc();
@@ -458,13 +544,13 @@ BlockCache::ReinsertionRes BlockCache::reinsertOrRemoveItem(
     HashedKey hk, BufferView value, uint32_t entrySize, RelAddress currAddr) {
   auto removeItem = [this, hk, entrySize, currAddr] {
     sizeDist_.removeSize(entrySize);
-    if (index_.removeIfMatch(hk.keyHash(), encodeRelAddress(currAddr))) {
+    if (index_->removeIfMatch(hk.keyHash(), encodeRelAddress(currAddr))) {
       return ReinsertionRes::kEvicted;
     }
     return ReinsertionRes::kRemoved;
   };
 
-  const auto lr = index_.peek(hk.keyHash());
+  const auto lr = index_->peek(hk.keyHash());
   if (!lr.found() || decodeRelAddress(lr.address()) != currAddr) {
     evictionLookupMissCounter_.inc();
     sizeDist_.removeSize(entrySize);
@@ -517,9 +603,9 @@ BlockCache::ReinsertionRes BlockCache::reinsertOrRemoveItem(
   }
 
   const auto replaced =
-      index_.replaceIfMatch(hk.keyHash(),
-                            encodeRelAddress(addr.add(slotSize)),
-                            encodeRelAddress(currAddr));
+      index_->replaceIfMatch(hk.keyHash(),
+                             encodeRelAddress(addr.add(slotSize)),
+                             encodeRelAddress(currAddr));
   if (!replaced) {
     reinsertionErrorCount_.inc();
     return removeItem();
@@ -564,6 +650,29 @@ Status BlockCache::readEntry(const RegionDescriptor& readDesc,
                              Buffer& value) {
   // Because region opened for read, nobody will reclaim it or modify. Safe
   // without locks.
+  approxSize = getEntryReadSize(addr, approxSize);
+  auto buffer = regionManager_.read(readDesc, addr.sub(approxSize), approxSize);
+  if (buffer.isNull()) {
+    return Status::DeviceError;
+  }
+
+  uint32_t entrySize = 0;
+  auto status = checkEntryDesc(buffer, expected, entrySize);
+  if (status != Status::Ok) {
+    return status;
+  }
+  if (buffer.size() < entrySize) {
+    // Read less than actual size. Read again with proper buffer.
+    buffer = regionManager_.read(readDesc, addr.sub(entrySize), entrySize);
+    if (buffer.isNull()) {
+      return Status::DeviceError;
+    }
+  }
+  return extractValue(std::move(buffer), value);
+}
+
+uint32_t BlockCache::getEntryReadSize(RelAddress addr,
+                                      uint32_t approxSize) const {
   if (allocator_.isSizeClassAllocator()) {
     // For size class, we always use slot size because the item layout is:
     // | --- value --- | --- empty --- | --- header --- |
@@ -587,14 +696,14 @@ Status BlockCache::readEntry(const RegionDescriptor& readDesc,
   // Because we are going to look for EntryDesc in the buffer read, the buffer
   // must be atleast as big as EntryDesc aligned to next 2 power
   XDCHECK_GE(approxSize, folly::nextPowTwo(sizeof(EntryDesc)));
+  return approxSize;
+}
 
-  auto buffer = regionManager_.read(readDesc, addr.sub(approxSize), approxSize);
-  if (buffer.isNull()) {
-    return Status::DeviceError;
-  }
-
+Status BlockCache::checkEntryDesc(const Buffer& buffer,
+                                  HashedKey expected,
+                                  uint32_t& entrySize) const {
   auto entryEnd = buffer.data() + buffer.size();
-  auto desc = *reinterpret_cast<EntryDesc*>(entryEnd - sizeof(EntryDesc));
+  auto desc = *reinterpret_cast<const EntryDesc*>(entryEnd - sizeof(EntryDesc));
   if (desc.csSelf != desc.computeChecksum()) {
     lookupEntryHeaderChecksumErrorCount_.inc();
     return Status::DeviceError;
@@ -606,19 +715,25 @@ Status BlockCache::readEntry(const RegionDescriptor& readDesc,
     return Status::NotFound;
   }
 
+  // For size class, the whole slot was read. Otherwise the actual size is
+  // defined by key and value size.
+  entrySize = allocator_.isSizeClassAllocator()
+                  ? buffer.size()
+                  : serializedSize(desc.keySize, desc.valueSize,
+                                   true /* aligned */);
+  return Status::Ok;
+}
+
+Status BlockCache::extractValue(Buffer buffer, Buffer& value) const {
+  auto entryEnd = buffer.data() + buffer.size();
+  auto desc = *reinterpret_cast<const EntryDesc*>(entryEnd - sizeof(EntryDesc));
   if (!allocator_.isSizeClassAllocator()) {
-    // Update slot size to actual, defined by key and value size
     uint32_t size =
         serializedSize(desc.keySize, desc.valueSize, true /* aligned */);
+    XDCHECK_GE(buffer.size(), size);
     if (buffer.size() > size) {
       // Read more than actual size. Trim the invalid data in the beginning
       buffer.trimStart(buffer.size() - size);
-    } else if (buffer.size() < size) {
-      // Read less than actual size. Read again with proper buffer.
-      buffer = regionManager_.read(readDesc, addr.sub(size), size);
-      if (buffer.isNull()) {
-        return Status::DeviceError;
-      }
     }
   }
   value = std::move(buffer);
@@ -639,7 +754,7 @@ void BlockCache::flush() {
 
 void BlockCache::reset() {
   XLOG(INFO, "Reset block cache");
-  index_.reset();
+  index_->reset();
   // Allocator resets region manager
   allocator_.reset();
 
@@ -655,7 +770,7 @@ void BlockCache::reset() {
 }
 
 void BlockCache::getCounters(const CounterVisitor& visitor) const {
-  visitor("navy_bc_items", index_.computeSize());
+  visitor("navy_bc_items", index_->computeSize());
   visitor("navy_bc_inserts", insertCount_.get());
   visitor("navy_bc_insert_hash_collisions", insertHashCollisionCount_.get());
   visitor("navy_bc_succ_inserts", succInsertCount_.get());
@@ -695,7 +810,7 @@ void BlockCache::getCounters(const CounterVisitor& visitor) const {
 
   // Allocator visits region manager
   allocator_.getCounters(visitor);
-  index_.getCounters(visitor);
+  index_->getCounters(visitor);
 
   if (reinsertionPolicy_) {
     reinsertionPolicy_->getCounters(visitor);
@@ -712,7 +827,7 @@ void BlockCache::persist(RecordWriter& rw) {
   *config.reinsertionPolicyEnabled_ref() = (reinsertionPolicy_ != nullptr);
   serializeProto(config, rw);
   regionManager_.persist(rw);
-  index_.persist(rw);
+  index_->persist(rw);
 
   XLOG(INFO, "Finished block cache persist");
 }
@@ -743,7 +858,7 @@ void BlockCache::tryRecover(RecordReader& rr) {
   holeCount_.set(*config.holeCount_ref());
   holeSizeTotal_.set(*config.holeSizeTotal_ref());
   regionManager_.recover(rr);
-  index_.recover(rr);
+  index_->recover(rr);
 }
 
 bool BlockCache::isValidRecoveryData(
@@ -753,7 +868,9 @@ bool BlockCache::isValidRecoveryData(
         static_cast<int32_t>(allocAlignSize_) ==
             *recoveredConfig.allocAlignSize_ref() &&
         *config_.sizeClasses_ref() == *recoveredConfig.sizeClasses_ref() &&
-        *config_.checksum_ref() == *recoveredConfig.checksum_ref())) {
+        *config_.checksum_ref() == *recoveredConfig.checksum_ref() &&
+        *config_.indexNumBuckets_ref() ==
+            *recoveredConfig.indexNumBuckets_ref())) {
     return false;
   }
   // TOOD: this is to handle alignment change on cache size from v11 to v12 and
@@ -795,6 +912,10 @@ serialization::BlockCacheConfig BlockCache::serializeConfig(
   for (auto sc : config.sizeClasses) {
     serializedConfig.sizeClasses_ref()->insert(sc);
   }
+  *serializedConfig.indexNumBuckets_ref() =
+      config.fixedSizeIndexNumEntries > 0
+          ? FixedSizeIndex::computeNumBuckets(config.fixedSizeIndexNumEntries)
+          : 0;
   return serializedConfig;
 }
 } // namespace navy
@@ -83,6 +83,10 @@ class BlockCache final : public Engine {
     // eviction policy. There must be at least one priority.
     uint16_t numPriorities{1};
 
+    // If not 0, use a FixedSizeIndex with room for this many entries instead
+    // of a SparseMapIndex
+    uint64_t fixedSizeIndexNumEntries{0};
+
     // Calculates the total region number.
     uint32_t getNumRegions() const { return cacheSize / regionSize; }
 
@@ -130,6 +134,15 @@ class BlockCache final : public Engine {
   //          Status::DeviceError otherwise.
   Status lookup(HashedKey hk, Buffer& value) override;
 
+  // Asynchronous version of lookup. The region stays open for read while the
+  // entry is read from the device, and the entry is validated when the read
+  // completes, in the device's completion thread if the device supports
+  // asynchronous IO.
+  //
+  // @param hk      key to be looked up
+  // @param cb      called with the same statuses as lookup and the value
+  void lookupAsync(HashedKey hk, LookupDoneCallback cb) override;
+
   // Removes a key from BlockCache.
   //
   // @param hk           key to be removed
@@ -221,7 +234,9 @@ class BlockCache final : public Engine {
   BlockCache(Config&& config, ValidConfigTag);
 
   // Entry disk size (with aux data and aligned)
-  uint32_t serializedSize(uint32_t keySize, uint32_t valueSize, bool aligned);
+  uint32_t serializedSize(uint32_t keySize,
+                          uint32_t valueSize,
+                          bool aligned) const;
 
   // Read and write are time consuming. It doesn't worth inlining them from
   // the performance point of view, but makes sense to track them for perf:
@@ -245,6 +260,42 @@ class BlockCache final : public Engine {
                    HashedKey expected,
                    Buffer& value);
 
+  // An asynchronous lookup that found its entry in the index
+  struct AsyncLookup {
+    AsyncLookup(RegionDescriptor d,
+                RelAddress a,
+                HashedKey k,
+                LookupDoneCallback c)
+        : desc{std::move(d)}, addrEnd{a}, hk{k}, cb{std::move(c)} {}
+
+    RegionDescriptor desc;
+    const RelAddress addrEnd;
+    const HashedKey hk;
+    LookupDoneCallback cb;
+  };
+
+  // Asynchronous version of readEntry. Reads @size bytes that end at the
+  // end of the entry and completes the lookup.
+  void readEntryAsync(std::unique_ptr<AsyncLookup> lookup, uint32_t size);
+  void onEntryRead(std::unique_ptr<AsyncLookup> lookup, Buffer buffer);
+  void completeLookup(std::unique_ptr<AsyncLookup> lookup,
+                      Status status,
+                      Buffer value);
+
+  // Returns the number of bytes to read for an entry that ends at @addrEnd,
+  // given the size hint from the index
+  uint32_t getEntryReadSize(RelAddress addrEnd, uint32_t approxSize) const;
+
+  // Validates the entry descriptor at the end of @buffer. On success,
+  // @entrySize is set to the number of bytes to read for the whole entry.
+  Status checkEntryDesc(const Buffer& buffer,
+                        HashedKey expected,
+                        uint32_t& entrySize) const;
+
+  // Extracts the value from @buffer, which ends with a valid entry
+  // descriptor and holds at least the whole entry
+  Status extractValue(Buffer buffer, Buffer& value) const;
+
   // Allocator reclaim callback
   // Returns number of slots that were successfully evicted
   uint32_t onRegionReclaim(RegionId rid, uint32_t slotSize, BufferView buffer);
@@ -319,6 +370,8 @@ class BlockCache final : public Engine {
 
   void validate(Config& config) const;
 
+  static std::unique_ptr<Index> makeIndex(const Config& config);
+
   // Create the reinsertion policy from config.
   // This function may need a reference to index and should be called the last
   // in the initialization order.
@@ -355,7 +408,7 @@ class BlockCache final : public Engine {
   // ^                                         ^
   // |                                         |
   // Buffer*                          Index points here
-  Index index_;
+  std::unique_ptr<Index> index_;
   RegionManager regionManager_;
   Allocator allocator_;
   // It is vital that the reinsertion policy is initialized after index_.
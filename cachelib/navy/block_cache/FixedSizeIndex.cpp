@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/navy/block_cache/FixedSizeIndex.h"
+
+#include <folly/Format.h>
+#include <folly/portability/Asm.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "cachelib/navy/serialization/Serialization.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+constexpr uint32_t FixedSizeIndex::kEntriesPerBucket;
+constexpr uint32_t FixedSizeIndex::kPersistBucketsPerRecord;
+
+namespace {
+// bucket ids are persisted as i32
+constexpr uint64_t kMaxNumBuckets{1ull << 31};
+
+// increase val if no overflow, otherwise do nothing
+void safeInc(std::atomic<uint8_t>& val) {
+  auto curr = val.load(std::memory_order_relaxed);
+  while (curr < std::numeric_limits<uint8_t>::max() &&
+         !val.compare_exchange_weak(curr, curr + 1,
+                                    std::memory_order_relaxed)) {
+  }
+}
+} // namespace
+
+FixedSizeIndex::FixedSizeIndex(uint64_t numEntries)
+    : numBuckets_{computeNumBuckets(numEntries)} {
+  if (numBuckets_ == 0 || numBuckets_ > kMaxNumBuckets) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid number of index entries: {}. Max: {}", numEntries,
+        kMaxNumBuckets * kEntriesPerBucket));
+  }
+  // value initialization zeroes the buckets, which makes them empty
+  buckets_.reset(new Bucket[numBuckets_]());
+}
+
+FixedSizeIndex::WriteLock::WriteLock(Bucket& bucket)
+    : bucket_{bucket},
+      version_{[&bucket] {
+        auto version = bucket.version.load(std::memory_order_relaxed);
+        while (true) {
+          if (version % 2 == 0 &&
+              bucket.version.compare_exchange_weak(
+                  version, version + 1, std::memory_order_acquire)) {
+            // readers that see a change must also see the odd version
+            std::atomic_thread_fence(std::memory_order_release);
+            return version;
+          }
+          folly::asm_volatile_pause();
+          version = bucket.version.load(std::memory_order_relaxed);
+        }
+      }()} {}
+
+FixedSizeIndex::WriteLock::~WriteLock() {
+  bucket_.version.store(version_ + 2, std::memory_order_release);
+}
+
+Index::ItemRecord FixedSizeIndex::getRecord(const Bucket& bucket,
+                                            uint32_t slot) {
+  const auto entry = bucket.entries[slot].load(std::memory_order_relaxed);
+  return ItemRecord{static_cast<uint32_t>(entry),
+                    static_cast<uint16_t>(entry >> 32),
+                    bucket.totalHits[slot].load(std::memory_order_relaxed),
+                    bucket.currentHits[slot].load(std::memory_order_relaxed)};
+}
+
+uint32_t FixedSizeIndex::findSlot(const Bucket& bucket, uint16_t tag) {
+  for (uint32_t i = 0; i < kEntriesPerBucket; i++) {
+    if (getEntryTag(bucket.entries[i].load(std::memory_order_relaxed)) ==
+        tag) {
+      return i;
+    }
+  }
+  return kNoSlot;
+}
+
+uint32_t FixedSizeIndex::readRecord(const Bucket& bucket,
+                                    uint16_t tag,
+                                    ItemRecord& record) {
+  while (true) {
+    const auto version = bucket.version.load(std::memory_order_acquire);
+    if (version % 2 != 0) {
+      folly::asm_volatile_pause();
+      continue;
+    }
+    const auto slot = findSlot(bucket, tag);
+    if (slot != kNoSlot) {
+      record = getRecord(bucket, slot);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (bucket.version.load(std::memory_order_relaxed) == version) {
+      return slot;
+    }
+  }
+}
+
+void FixedSizeIndex::setEntry(Bucket& bucket,
+                              uint32_t slot,
+                              uint16_t tag,
+                              uint32_t address,
+                              uint16_t sizeHint) {
+  bucket.entries[slot].store(makeEntry(tag, address, sizeHint),
+                             std::memory_order_relaxed);
+  bucket.currentHits[slot].store(0, std::memory_order_relaxed);
+  bucket.totalHits[slot].store(0, std::memory_order_relaxed);
+}
+
+void FixedSizeIndex::clearEntry(Bucket& bucket, uint32_t slot) {
+  bucket.entries[slot].store(0, std::memory_order_relaxed);
+  bucket.currentHits[slot].store(0, std::memory_order_relaxed);
+  bucket.totalHits[slot].store(0, std::memory_order_relaxed);
+}
+
+Index::LookupResult FixedSizeIndex::lookup(uint64_t key) {
+  auto& bucket = getBucket(key);
+  ItemRecord record;
+  const auto slot = readRecord(bucket, getTag(key), record);
+  if (slot == kNoSlot) {
+    return {};
+  }
+  safeInc(bucket.totalHits[slot]);
+  safeInc(bucket.currentHits[slot]);
+  return makeLookupResult(record);
+}
+
+Index::LookupResult FixedSizeIndex::peek(uint64_t key) const {
+  ItemRecord record;
+  if (readRecord(getBucket(key), getTag(key), record) == kNoSlot) {
+    return {};
+  }
+  return makeLookupResult(record);
+}
+
+Index::LookupResult FixedSizeIndex::insert(uint64_t key,
+                                           uint32_t address,
+                                           uint16_t sizeHint) {
+  LookupResult lr;
+  auto& bucket = getBucket(key);
+  const auto tag = getTag(key);
+  WriteLock lock{bucket};
+  auto slot = findSlot(bucket, tag);
+  if (slot == kNoSlot) {
+    slot = findSlot(bucket, 0 /* empty */);
+  }
+  if (slot == kNoSlot) {
+    // replace the entry with the fewest hits, like a collision
+    slot = 0;
+    for (uint32_t i = 1; i < kEntriesPerBucket; i++) {
+      if (bucket.totalHits[i].load(std::memory_order_relaxed) <
+          bucket.totalHits[slot].load(std::memory_order_relaxed)) {
+        slot = i;
+      }
+    }
+    fullBucketReplaces_.inc();
+  }
+  if (getEntryTag(bucket.entries[slot].load(std::memory_order_relaxed)) != 0) {
+    lr = makeLookupResult(getRecord(bucket, slot));
+    trackRemove(lr.totalHits());
+  } else {
+    numEntries_.inc();
+  }
+  setEntry(bucket, slot, tag, address, sizeHint);
+  return lr;
+}
+
+bool FixedSizeIndex::replaceIfMatch(uint64_t key,
+                                    uint32_t newAddress,
+                                    uint32_t oldAddress) {
+  auto& bucket = getBucket(key);
+  WriteLock lock{bucket};
+  const auto slot = findSlot(bucket, getTag(key));
+  if (slot == kNoSlot || getRecord(bucket, slot).address != oldAddress) {
+    return false;
+  }
+  const auto entry = bucket.entries[slot].load(std::memory_order_relaxed);
+  bucket.entries[slot].store((entry & ~0xffffffffull) | newAddress,
+                             std::memory_order_relaxed);
+  bucket.currentHits[slot].store(0, std::memory_order_relaxed);
+  return true;
+}
+
+Index::LookupResult FixedSizeIndex::remove(uint64_t key) {
+  LookupResult lr;
+  auto& bucket = getBucket(key);
+  WriteLock lock{bucket};
+  const auto slot = findSlot(bucket, getTag(key));
+  if (slot != kNoSlot) {
+    lr = makeLookupResult(getRecord(bucket, slot));
+    trackRemove(lr.totalHits());
+    clearEntry(bucket, slot);
+    numEntries_.dec();
+  }
+  return lr;
+}
+
+bool FixedSizeIndex::removeIfMatch(uint64_t key, uint32_t address) {
+  auto& bucket = getBucket(key);
+  WriteLock lock{bucket};
+  const auto slot = findSlot(bucket, getTag(key));
+  if (slot == kNoSlot) {
+    return false;
+  }
+  const auto record = getRecord(bucket, slot);
+  if (record.address != address) {
+    return false;
+  }
+  trackRemove(record.totalHits);
+  clearEntry(bucket, slot);
+  numEntries_.dec();
+  return true;
+}
+
+void FixedSizeIndex::setHits(uint64_t key,
+                             uint8_t currentHits,
+                             uint8_t totalHits) {
+  auto& bucket = getBucket(key);
+  WriteLock lock{bucket};
+  const auto slot = findSlot(bucket, getTag(key));
+  if (slot != kNoSlot) {
+    bucket.currentHits[slot].store(currentHits, std::memory_order_relaxed);
+    bucket.totalHits[slot].store(totalHits, std::memory_order_relaxed);
+  }
+}
+
+void FixedSizeIndex::reset() {
+  for (uint64_t i = 0; i < numBuckets_; i++) {
+    WriteLock lock{buckets_[i]};
+    for (uint32_t slot = 0; slot < kEntriesPerBucket; slot++) {
+      if (getEntryTag(buckets_[i].entries[slot].load(
+              std::memory_order_relaxed)) != 0) {
+        clearEntry(buckets_[i], slot);
+        numEntries_.dec();
+      }
+    }
+  }
+}
+
+size_t FixedSizeIndex::computeSize() const { return numEntries_.get(); }
+
+void FixedSizeIndex::persist(RecordWriter& rw) const {
+  serialization::IndexBucket record;
+  for (uint64_t first = 0; first < numBuckets_;
+       first += kPersistBucketsPerRecord) {
+    *record.bucketId_ref() = static_cast<int32_t>(first);
+    const auto last =
+        std::min<uint64_t>(first + kPersistBucketsPerRecord, numBuckets_);
+    for (uint64_t i = first; i < last; i++) {
+      for (uint32_t slot = 0; slot < kEntriesPerBucket; slot++) {
+        const auto tag = getEntryTag(
+            buckets_[i].entries[slot].load(std::memory_order_relaxed));
+        if (tag == 0) {
+          continue;
+        }
+        const auto itemRecord = getRecord(buckets_[i], slot);
+        serialization::IndexEntry entry;
+        entry.key_ref() = static_cast<int32_t>((i - first) << 16 | tag);
+        entry.address_ref() = itemRecord.address;
+        entry.sizeHint_ref() = itemRecord.sizeHint;
+        entry.totalHits_ref() = itemRecord.totalHits;
+        entry.currentHits_ref() = itemRecord.currentHits;
+        record.entries_ref()->push_back(entry);
+      }
+    }
+    // Serialize the record then clear contents to reuse memory.
+    serializeProto(record, rw);
+    record.entries_ref()->clear();
+  }
+}
+
+void FixedSizeIndex::recover(RecordReader& rr) {
+  reset();
+  for (uint64_t first = 0; first < numBuckets_;
+       first += kPersistBucketsPerRecord) {
+    auto record = deserializeProto<serialization::IndexBucket>(rr);
+    const auto id = static_cast<uint32_t>(*record.bucketId_ref());
+    if (id != first) {
+      throw std::invalid_argument{folly::sformat(
+          "Invalid bucket id. Expected: {}, bucket id: {}", first, id)};
+    }
+    for (auto& entry : *record.entries_ref()) {
+      const auto key = static_cast<uint32_t>(*entry.key_ref());
+      const uint64_t i = first + (key >> 16);
+      const auto tag = static_cast<uint16_t>(key);
+      if (i >= numBuckets_ || (key >> 16) >= kPersistBucketsPerRecord ||
+          tag == 0) {
+        throw std::invalid_argument{
+            folly::sformat("Invalid index entry key: {}", key)};
+      }
+      auto& bucket = buckets_[i];
+      const auto slot = findSlot(bucket, 0 /* empty */);
+      if (slot == kNoSlot) {
+        throw std::invalid_argument{
+            folly::sformat("Too many index entries in bucket: {}", i)};
+      }
+      bucket.entries[slot].store(
+          makeEntry(tag, static_cast<uint32_t>(*entry.address_ref()),
+                    static_cast<uint16_t>(*entry.sizeHint_ref())),
+          std::memory_order_relaxed);
+      bucket.totalHits[slot].store(
+          static_cast<uint8_t>(*entry.totalHits_ref()),
+          std::memory_order_relaxed);
+      bucket.currentHits[slot].store(
+          static_cast<uint8_t>(*entry.currentHits_ref()),
+          std::memory_order_relaxed);
+      numEntries_.inc();
+    }
+  }
+}
+
+void FixedSizeIndex::getCounters(const CounterVisitor& visitor) const {
+  Index::getCounters(visitor);
+  visitor("navy_bc_index_full_bucket_replaces", fullBucketReplaces_.get());
+}
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "cachelib/navy/block_cache/Index.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+// Index with a fixed number of buckets of a cache line each, for caches of
+// many small items where the DRAM taken by the index limits the cache size.
+// A bucket has room for kEntriesPerBucket entries of 8 bytes and their
+// hits, which is under 11 bytes per entry. SparseMapIndex stores 12 bytes
+// of key and record per entry, before the overhead of its maps.
+//
+// A key maps to a single bucket, where it is identified by a 16 bit tag from
+// the top of its hash. Two keys with the same bucket and tag collide. A new
+// key inserted into a full bucket replaces the entry with the fewest hits.
+//
+// Lookups do not take a lock. Every bucket has a version that a writer makes
+// odd while it changes the bucket. Readers retry until they read the bucket
+// with the same even version before and after (a seqlock). Writers of the
+// same bucket spin on the version. Hits are counted without the lock, so a
+// hit that races with a change of its bucket may go to the wrong entry.
+class FixedSizeIndex final : public Index {
+ public:
+  static constexpr uint32_t kEntriesPerBucket{6};
+
+  // @param numEntries  number of entries to make room for. Keys spread
+  //                    unevenly over the buckets, so it should be larger
+  //                    than the expected number of items.
+  //
+  // @throw std::invalid_argument if the number of entries is 0 or too large
+  explicit FixedSizeIndex(uint64_t numEntries);
+
+  // Returns the number of buckets for @numEntries entries
+  static uint64_t computeNumBuckets(uint64_t numEntries) {
+    return (numEntries + kEntriesPerBucket - 1) / kEntriesPerBucket;
+  }
+
+  // Writes the buckets in groups of kPersistBucketsPerRecord, one record per
+  // group. The key of an entry is its bucket's offset in the group and its
+  // tag.
+  void persist(RecordWriter& rw) const override;
+  void recover(RecordReader& rr) override;
+
+  LookupResult lookup(uint64_t key) override;
+  LookupResult peek(uint64_t key) const override;
+  LookupResult insert(uint64_t key,
+                      uint32_t address,
+                      uint16_t sizeHint) override;
+  bool replaceIfMatch(uint64_t key,
+                      uint32_t newAddress,
+                      uint32_t oldAddress) override;
+  LookupResult remove(uint64_t key) override;
+  bool removeIfMatch(uint64_t key, uint32_t address) override;
+  void setHits(uint64_t key, uint8_t currentHits, uint8_t totalHits) override;
+  void reset() override;
+  size_t computeSize() const override;
+  void getCounters(const CounterVisitor& visitor) const override;
+
+  uint64_t getNumBuckets() const { return numBuckets_; }
+
+  // Returns the bytes of memory taken by the buckets
+  uint64_t getMemorySize() const { return numBuckets_ * sizeof(Bucket); }
+
+ private:
+  static constexpr uint32_t kPersistBucketsPerRecord{4096};
+  static constexpr uint32_t kNoSlot{kEntriesPerBucket};
+
+  // An entry packs the address, the size hint and the tag. A tag of 0 marks
+  // an empty entry.
+  struct alignas(64) Bucket {
+    std::atomic<uint32_t> version;
+    std::atomic<uint8_t> currentHits[kEntriesPerBucket];
+    std::atomic<uint8_t> totalHits[kEntriesPerBucket];
+    std::atomic<uint64_t> entries[kEntriesPerBucket];
+  };
+  static_assert(sizeof(Bucket) == 64, "Bucket must take a cache line");
+
+  // Holds the bucket's version odd, which keeps readers and other writers
+  // out of the bucket
+  class WriteLock {
+   public:
+    explicit WriteLock(Bucket& bucket);
+    ~WriteLock();
+
+    WriteLock(const WriteLock&) = delete;
+    WriteLock& operator=(const WriteLock&) = delete;
+
+   private:
+    Bucket& bucket_;
+    const uint32_t version_;
+  };
+
+  static uint16_t getTag(uint64_t key) {
+    const auto tag = static_cast<uint16_t>(key >> 48);
+    return tag == 0 ? 1 : tag;
+  }
+
+  static uint64_t makeEntry(uint16_t tag, uint32_t address, uint16_t sizeHint) {
+    return static_cast<uint64_t>(tag) << 48 |
+           static_cast<uint64_t>(sizeHint) << 32 | address;
+  }
+
+  static uint16_t getEntryTag(uint64_t entry) {
+    return static_cast<uint16_t>(entry >> 48);
+  }
+
+  // Returns the record of the entry in @slot. Relaxed reads: the caller
+  // validates the bucket's version or holds its write lock.
+  static ItemRecord getRecord(const Bucket& bucket, uint32_t slot);
+
+  // Returns the slot of the entry with @tag, or kNoSlot
+  static uint32_t findSlot(const Bucket& bucket, uint16_t tag);
+
+  // Reads the record of @tag with the seqlock
+  //
+  // @return the slot of the entry, or kNoSlot
+  static uint32_t readRecord(const Bucket& bucket,
+                             uint16_t tag,
+                             ItemRecord& record);
+
+  // Writes the entry into @slot and resets its hits. Must hold the write lock.
+  static void setEntry(Bucket& bucket,
+                       uint32_t slot,
+                       uint16_t tag,
+                       uint32_t address,
+                       uint16_t sizeHint);
+
+  // Empties @slot. Must hold the write lock.
+  static void clearEntry(Bucket& bucket, uint32_t slot);
+
+  Bucket& getBucket(uint64_t key) const {
+    return buckets_[(key & ((1ull << 48) - 1)) % numBuckets_];
+  }
+
+  const uint64_t numBuckets_{};
+  std::unique_ptr<Bucket[]> buckets_;
+
+  // entries in the buckets, so that computeSize does not scan the buckets
+  AtomicCounter numEntries_;
+
+  // new keys that replaced another key's entry in a full bucket
+  mutable AtomicCounter fullBucketReplaces_;
+};
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -17,16 +17,10 @@
 #pragma once
 
 #include <folly/Portability.h>
-#include <folly/SharedMutex.h>
-#include <folly/stats/QuantileEstimator.h>
-#include <tsl/sparse_map.h>
+#include <folly/logging/xlog.h>
 
-#include <cassert>
 #include <chrono>
-#include <functional>
-#include <memory>
-#include <shared_mutex>
-#include <utility>
+#include <cstdint>
 
 #include "cachelib/common/AtomicCounter.h"
 #include "cachelib/common/PercentileStats.h"
@@ -38,23 +32,26 @@ namespace navy {
 // NVM index: map from key to value. Under the hood, stores key hash to value
 // map. If collision happened, returns undefined value (last inserted actually,
 // but we do not want people to rely on that).
+//
+// SparseMapIndex grows with the number of items. FixedSizeIndex takes less
+// memory per item, for caches of many small items.
 class Index {
  public:
   // Specify 1 second window size for quantile estimator.
   static constexpr std::chrono::seconds kQuantileWindowSize{1};
 
-  Index() = default;
+  virtual ~Index() = default;
   Index(const Index&) = delete;
   Index& operator=(const Index&) = delete;
 
   // Writes index to a Thrift object one bucket at a time and passes each bucket
   // to @persistCb. The reason for this is because the index can be very large
   // and serializing everything at once uses a lot of RAM.
-  void persist(RecordWriter& rw) const;
+  virtual void persist(RecordWriter& rw) const = 0;
 
   // Resets index then inserts entries read from @deserializer. Throws
   // std::exception on failure.
-  void recover(RecordReader& rr);
+  virtual void recover(RecordReader& rr) = 0;
 
   struct FOLLY_PACK_ATTR ItemRecord {
     // encoded address
@@ -114,86 +111,70 @@ class Index {
   };
 
   // Gets value and update tracking counters
-  LookupResult lookup(uint64_t key);
+  virtual LookupResult lookup(uint64_t key) = 0;
 
   // Gets value without updating tracking counters
-  LookupResult peek(uint64_t key) const;
+  virtual LookupResult peek(uint64_t key) const = 0;
 
   // Overwrites existing key if exists with new address and size, and it also
   // will reset hits counting. If the entry was successfully overwritten,
   // LookupResult.found() returns true and LookupResult.record() returns the old
-  // record.
-  LookupResult insert(uint64_t key, uint32_t address, uint16_t sizeHint);
+  // record. An index that has no room for a new key may drop the entry of
+  // another key to make room, which is returned the same way, as if the keys
+  // collided.
+  virtual LookupResult insert(uint64_t key,
+                              uint32_t address,
+                              uint16_t sizeHint) = 0;
 
   // Replaces old address with new address if there exists the key with the
   // identical old address. Current hits will be reset after successful replace.
   // All other fields in the record is retained.
   //
   // @return true if replaced.
-  bool replaceIfMatch(uint64_t key, uint32_t newAddress, uint32_t oldAddress);
+  virtual bool replaceIfMatch(uint64_t key,
+                              uint32_t newAddress,
+                              uint32_t oldAddress) = 0;
 
   // If the entry was successfully removed, LookupResult.found() returns true
   // and LookupResult.record() returns the record that was just found.
   // If the entry wasn't found, then LookupResult.found() returns false.
-  LookupResult remove(uint64_t key);
+  virtual LookupResult remove(uint64_t key) = 0;
 
   // Removes only if both key and address match.
   //
   // @return true if removed successfully, false otherwise.
-  bool removeIfMatch(uint64_t key, uint32_t address);
+  virtual bool removeIfMatch(uint64_t key, uint32_t address) = 0;
 
   // Updates hits information of a key.
-  void setHits(uint64_t key, uint8_t currentHits, uint8_t totalHits);
+  virtual void setHits(uint64_t key,
+                       uint8_t currentHits,
+                       uint8_t totalHits) = 0;
 
   // Resets all the buckets to the initial state.
-  void reset();
+  virtual void reset() = 0;
 
   // Walks buckets and computes total index entry count
-  size_t computeSize() const;
+  virtual size_t computeSize() const = 0;
 
   // Exports index stats via CounterVisitor.
-  void getCounters(const CounterVisitor& visitor) const;
-
- private:
-  static constexpr uint32_t kNumBuckets{64 * 1024};
-  static constexpr uint32_t kNumMutexes{1024};
-
-  using Map = tsl::sparse_map<uint32_t, ItemRecord>;
-
-  static uint32_t bucket(uint64_t hash) {
-    return (hash >> 32) & (kNumBuckets - 1);
-  }
-
-  static uint32_t subkey(uint64_t hash) { return hash & 0xffffffffu; }
+  virtual void getCounters(const CounterVisitor& visitor) const;
 
-  folly::SharedMutex& getMutexOfBucket(uint32_t bucket) const {
-    XDCHECK(folly::isPowTwo(kNumMutexes));
-    return mutex_[bucket & (kNumMutexes - 1)];
-  }
-
-  folly::SharedMutex& getMutex(uint64_t hash) const {
-    auto b = bucket(hash);
-    return getMutexOfBucket(b);
-  }
+ protected:
+  Index() = default;
 
-  Map& getMap(uint64_t hash) const {
-    auto b = bucket(hash);
-    return buckets_[b];
+  static LookupResult makeLookupResult(const ItemRecord& record) {
+    LookupResult lr;
+    lr.found_ = true;
+    lr.record_ = record;
+    return lr;
   }
 
+  // Tracks the hits of an entry that is removed or overwritten
   void trackRemove(uint8_t totalHits);
 
-  // Experiments with 64 byte alignment didn't show any throughput test
-  // performance improvement.
-  std::unique_ptr<folly::SharedMutex[]> mutex_{
-      new folly::SharedMutex[kNumMutexes]};
-  std::unique_ptr<Map[]> buckets_{new Map[kNumBuckets]};
-
+ private:
   mutable util::PercentileStats hitsEstimator_{kQuantileWindowSize};
   mutable AtomicCounter unAccessedItems_;
-
-  static_assert((kNumMutexes & (kNumMutexes - 1)) == 0,
-                "number of mutexes must be power of two");
 };
 } // namespace navy
 } // namespace cachelib
@@ -533,6 +533,25 @@ Buffer RegionManager::read(const RegionDescriptor& desc,
   return device_.read(physicalOffset(addr), size);
 }
 
+void RegionManager::readAsync(const RegionDescriptor& desc,
+                              RelAddress addr,
+                              size_t size,
+                              Device::ReadCallback cb) const {
+  auto rid = addr.rid();
+  auto& region = getRegion(rid);
+  XDCHECK_LE(addr.offset() + size, region.getLastEntryEndOffset());
+  if (doesBufferingWrites() && !desc.isPhysReadMode()) {
+    auto buffer = Buffer(size);
+    XDCHECK(region.hasBuffer());
+    region.readFromBuffer(addr.offset(), buffer.mutableView());
+    cb(std::move(buffer));
+    return;
+  }
+  XDCHECK(isValidIORange(addr.offset(), size));
+
+  device_.readAsync(physicalOffset(addr), size, std::move(cb));
+}
+
 void RegionManager::flush() { device_.flush(); }
 
 void RegionManager::getCounters(const CounterVisitor& visitor) const {
@@ -175,6 +175,15 @@ class RegionManager {
   // succeeded or not.
   Buffer read(const RegionDescriptor& desc, RelAddress addr, size_t size) const;
 
+  // Asynchronous version of read. @cb is called with the buffer, or with an
+  // empty buffer on error. It is called inline if the data is still in the
+  // region's in-memory buffer, otherwise possibly from the device's
+  // completion thread. @desc must stay open until @cb is called.
+  void readAsync(const RegionDescriptor& desc,
+                 RelAddress addr,
+                 size_t size,
+                 Device::ReadCallback cb) const;
+
   // Flushes all in memory buffers to the device and then issues device flush.
   void flush();
 
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/SharedMutex.h>
+#include <tsl/sparse_map.h>
+
+#include <memory>
+#include <shared_mutex>
+#include <utility>
+
+#include "cachelib/navy/block_cache/Index.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+// Index that keeps the entries in 64K sparse maps from the lower 32 bits of
+// the key hash to the record, behind 1024 shared mutexes. It grows with the
+// number of entries.
+class SparseMapIndex final : public Index {
+ public:
+  SparseMapIndex() = default;
+
+  void persist(RecordWriter& rw) const override;
+  void recover(RecordReader& rr) override;
+
+  LookupResult lookup(uint64_t key) override;
+  LookupResult peek(uint64_t key) const override;
+  LookupResult insert(uint64_t key,
+                      uint32_t address,
+                      uint16_t sizeHint) override;
+  bool replaceIfMatch(uint64_t key,
+                      uint32_t newAddress,
+                      uint32_t oldAddress) override;
+  LookupResult remove(uint64_t key) override;
+  bool removeIfMatch(uint64_t key, uint32_t address) override;
+  void setHits(uint64_t key, uint8_t currentHits, uint8_t totalHits) override;
+  void reset() override;
+  size_t computeSize() const override;
+
+ private:
+  static constexpr uint32_t kNumBuckets{64 * 1024};
+  static constexpr uint32_t kNumMutexes{1024};
+
+  using Map = tsl::sparse_map<uint32_t, ItemRecord>;
+
+  static uint32_t bucket(uint64_t hash) {
+    return (hash >> 32) & (kNumBuckets - 1);
+  }
+
+  static uint32_t subkey(uint64_t hash) { return hash & 0xffffffffu; }
+
+  folly::SharedMutex& getMutexOfBucket(uint32_t bucket) const {
+    XDCHECK(folly::isPowTwo(kNumMutexes));
+    return mutex_[bucket & (kNumMutexes - 1)];
+  }
+
+  folly::SharedMutex& getMutex(uint64_t hash) const {
+    auto b = bucket(hash);
+    return getMutexOfBucket(b);
+  }
+
+  Map& getMap(uint64_t hash) const {
+    auto b = bucket(hash);
+    return buckets_[b];
+  }
+
+  // Experiments with 64 byte alignment didn't show any throughput test
+  // performance improvement.
+  std::unique_ptr<folly::SharedMutex[]> mutex_{
+      new folly::SharedMutex[kNumMutexes]};
+  std::unique_ptr<Map[]> buckets_{new Map[kNumBuckets]};
+
+  static_assert((kNumMutexes & (kNumMutexes - 1)) == 0,
+                "number of mutexes must be power of two");
+};
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
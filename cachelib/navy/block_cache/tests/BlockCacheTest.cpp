@@ -125,6 +125,54 @@ void finishAllJobs(MockJobScheduler& ex) {
     ex.runFirst();
   }
 }
+
+// Memory device that completes reads only when asked to, like a device with
+// asynchronous IO
+class DeferredReadDevice : public Device {
+ public:
+  explicit DeferredReadDevice(uint64_t size)
+      : Device{size},
+        device_{createMemoryDevice(size, nullptr /* encryption */)} {}
+
+  bool supportsAsyncIO() const override { return true; }
+
+  size_t getNumPendingReads() const { return pendingReads_.size(); }
+
+  void completeReads() {
+    auto reads = std::move(pendingReads_);
+    pendingReads_.clear();
+    for (auto& read : reads) {
+      read();
+    }
+  }
+
+ protected:
+  bool writeImpl(uint64_t offset, uint32_t size, const void* value) override {
+    return device_->write(
+        offset,
+        Buffer{BufferView{size, reinterpret_cast<const uint8_t*>(value)}});
+  }
+
+  bool readImpl(uint64_t offset, uint32_t size, void* value) override {
+    return device_->read(offset, size, value);
+  }
+
+  void flushImpl() override { device_->flush(); }
+
+  void readAsyncImpl(uint64_t offset,
+                     uint32_t size,
+                     void* value,
+                     IOCallback cb) override {
+    pendingReads_.push_back(
+        [this, offset, size, value, cb = std::move(cb)]() mutable {
+          cb(readImpl(offset, size, value));
+        });
+  }
+
+ private:
+  std::unique_ptr<Device> device_;
+  std::vector<folly::Function<void()>> pendingReads_;
+};
 } // namespace
 
 TEST(BlockCache, InsertLookup) {
@@ -773,6 +821,48 @@ TEST(BlockCache, StackAlloc) {
   EXPECT_EQ(0, exPtr->getQueueSize());
 }
 
+TEST(BlockCache, LookupAsync) {
+  std::vector<uint32_t> hits(4);
+  auto policy = std::make_unique<NiceMock<MockPolicy>>(&hits);
+  auto device = std::make_unique<DeferredReadDevice>(kDeviceSize);
+  auto ex = std::make_unique<MockSingleThreadJobScheduler>();
+  auto exPtr = ex.get();
+  auto config = makeConfig(*ex, std::move(policy), *device, {});
+  config.numInMemBuffers = 0;
+  auto engine = makeEngine(std::move(config));
+  auto driver = makeDriver(std::move(engine), std::move(ex));
+
+  BufferGen bg;
+  CacheEntry e1{bg.gen(8), bg.gen(1800)};
+  CacheEntry e2{bg.gen(8), bg.gen(3000)};
+  EXPECT_EQ(Status::Ok, driver->insertAsync(e1.key(), e1.value(), nullptr));
+  EXPECT_EQ(Status::Ok, driver->insertAsync(e2.key(), e2.value(), nullptr));
+  driver->flush();
+
+  MockLookupCB cbLookup;
+  EXPECT_CALL(cbLookup, call(Status::NotFound, makeView("cat"), BufferView{}));
+  for (auto key : {e1.key(), e2.key(), makeView("cat")}) {
+    EXPECT_EQ(Status::Ok,
+              driver->lookupAsync(
+                  key, [&cbLookup](Status status, BufferView k, Buffer value) {
+                    cbLookup.call(status, k, value.view());
+                  }));
+  }
+  // The jobs do not wait for the reads. The miss completes in its job.
+  exPtr->finish();
+  EXPECT_EQ(0, exPtr->getQueueSize());
+  EXPECT_EQ(2, device->getNumPendingReads());
+  testing::Mock::VerifyAndClearExpectations(&cbLookup);
+
+  EXPECT_CALL(cbLookup, call(Status::Ok, e1.key(), e1.value()));
+  EXPECT_CALL(cbLookup, call(Status::Ok, e2.key(), e2.value()));
+  // Completions schedule jobs that call back
+  device->completeReads();
+  exPtr->finish();
+  EXPECT_EQ(0, device->getNumPendingReads());
+  EXPECT_EQ(0, exPtr->getQueueSize());
+}
+
 TEST(BlockCache, RegionUnderflow) {
   std::vector<uint32_t> hits(4);
   auto policy = std::make_unique<NiceMock<MockPolicy>>(&hits);
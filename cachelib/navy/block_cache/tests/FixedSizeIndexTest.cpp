@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "cachelib/navy/block_cache/FixedSizeIndex.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+namespace tests {
+namespace {
+// key with the tag in the top 16 bits and the bucket in the rest
+uint64_t makeKey(uint16_t tag, uint64_t bucket) {
+  return static_cast<uint64_t>(tag) << 48 | bucket;
+}
+} // namespace
+
+TEST(FixedSizeIndex, InvalidSize) {
+  EXPECT_THROW(FixedSizeIndex{0}, std::invalid_argument);
+  EXPECT_THROW(FixedSizeIndex{FixedSizeIndex::kEntriesPerBucket * (1ull << 32)},
+               std::invalid_argument);
+
+  FixedSizeIndex index{1000};
+  EXPECT_EQ(167, index.getNumBuckets());
+  EXPECT_EQ(167 * 64, index.getMemorySize());
+}
+
+TEST(FixedSizeIndex, InsertLookupRemove) {
+  FixedSizeIndex index{1000};
+  EXPECT_FALSE(index.lookup(111).found());
+
+  EXPECT_FALSE(index.insert(111, 4444, 11).found());
+  EXPECT_EQ(4444, index.lookup(111).address());
+  EXPECT_EQ(11, index.lookup(111).sizeHint());
+  EXPECT_EQ(1, index.computeSize());
+
+  // overwrite returns the old record
+  auto lr = index.insert(111, 5555, 22);
+  EXPECT_TRUE(lr.found());
+  EXPECT_EQ(4444, lr.address());
+  EXPECT_EQ(5555, index.peek(111).address());
+  EXPECT_EQ(22, index.peek(111).sizeHint());
+
+  EXPECT_FALSE(index.replaceIfMatch(111, 3333, 4444));
+  EXPECT_TRUE(index.replaceIfMatch(111, 3333, 5555));
+  EXPECT_EQ(3333, index.peek(111).address());
+  EXPECT_EQ(22, index.peek(111).sizeHint());
+
+  EXPECT_FALSE(index.removeIfMatch(111, 5555));
+  EXPECT_TRUE(index.removeIfMatch(111, 3333));
+  EXPECT_FALSE(index.lookup(111).found());
+
+  index.insert(222, 0, 0);
+  EXPECT_TRUE(index.remove(222).found());
+  EXPECT_FALSE(index.remove(222).found());
+  EXPECT_EQ(0, index.computeSize());
+}
+
+TEST(FixedSizeIndex, Hits) {
+  FixedSizeIndex index{1000};
+  const uint64_t key = 9527;
+
+  index.insert(key, 3, 0);
+  index.lookup(key);
+  EXPECT_EQ(1, index.peek(key).totalHits());
+  EXPECT_EQ(1, index.peek(key).currentHits());
+
+  index.setHits(key, 2, 5);
+  EXPECT_EQ(5, index.peek(key).totalHits());
+  EXPECT_EQ(2, index.peek(key).currentHits());
+
+  EXPECT_TRUE(index.replaceIfMatch(key, 100, 3));
+  EXPECT_EQ(5, index.peek(key).totalHits());
+  EXPECT_EQ(0, index.peek(key).currentHits());
+
+  for (int i = 0; i < 1000; i++) {
+    index.lookup(key);
+  }
+  EXPECT_EQ(255, index.peek(key).totalHits());
+  EXPECT_EQ(255, index.peek(key).currentHits());
+
+  // re-insert clears the hits
+  index.insert(key, 3, 0);
+  EXPECT_EQ(0, index.peek(key).totalHits());
+  EXPECT_EQ(0, index.peek(key).currentHits());
+}
+
+TEST(FixedSizeIndex, FullBucket) {
+  FixedSizeIndex index{1000};
+  const uint64_t bucket = 17;
+  for (uint16_t tag = 1; tag <= FixedSizeIndex::kEntriesPerBucket; tag++) {
+    EXPECT_FALSE(index.insert(makeKey(tag, bucket), tag, 0).found());
+    for (uint16_t i = 0; i < tag; i++) {
+      index.lookup(makeKey(tag, bucket));
+    }
+  }
+
+  // the entry with the fewest hits makes room for the new key
+  auto lr = index.insert(makeKey(100, bucket), 100, 0);
+  EXPECT_TRUE(lr.found());
+  EXPECT_EQ(1, lr.address());
+  EXPECT_FALSE(index.lookup(makeKey(1, bucket)).found());
+  EXPECT_EQ(100, index.lookup(makeKey(100, bucket)).address());
+  for (uint16_t tag = 2; tag <= FixedSizeIndex::kEntriesPerBucket; tag++) {
+    EXPECT_EQ(tag, index.lookup(makeKey(tag, bucket)).address());
+  }
+  // other buckets are not affected
+  index.insert(makeKey(1, bucket + 1), 1, 0);
+  EXPECT_EQ(1, index.lookup(makeKey(1, bucket + 1)).address());
+
+  // a key collides with a key of the same bucket and tag
+  EXPECT_EQ(100, index.lookup(makeKey(100, bucket + 167)).address());
+
+  // replacing an entry does not change the number of entries
+  EXPECT_EQ(FixedSizeIndex::kEntriesPerBucket + 1, index.computeSize());
+  index.reset();
+  EXPECT_EQ(0, index.computeSize());
+}
+
+TEST(FixedSizeIndex, Recovery) {
+  FixedSizeIndex index{100'000};
+  std::vector<std::pair<uint64_t, uint32_t>> log;
+  for (uint64_t i = 0; i < 50'000; i++) {
+    const uint64_t key = makeKey(i % 1000 + 1, i * 7919);
+    index.insert(key, i, i % 100);
+    log.emplace_back(key, i);
+  }
+  index.setHits(log.back().first, 3, 7);
+
+  folly::IOBufQueue ioq;
+  auto rw = createMemoryRecordWriter(ioq);
+  index.persist(*rw);
+
+  auto rr = createMemoryRecordReader(ioq);
+  FixedSizeIndex newIndex{100'000};
+  newIndex.recover(*rr);
+  EXPECT_EQ(index.computeSize(), newIndex.computeSize());
+  for (auto& [key, address] : log) {
+    auto lr = index.peek(key);
+    auto newLr = newIndex.peek(key);
+    ASSERT_EQ(lr.found(), newLr.found());
+    if (lr.found()) {
+      EXPECT_EQ(lr.address(), newLr.address());
+      EXPECT_EQ(lr.sizeHint(), newLr.sizeHint());
+    }
+  }
+  EXPECT_EQ(7, newIndex.peek(log.back().first).totalHits());
+  EXPECT_EQ(3, newIndex.peek(log.back().first).currentHits());
+
+  // a different number of buckets can not recover
+  auto rr2 = createMemoryRecordReader(ioq);
+  FixedSizeIndex smallIndex{1000};
+  EXPECT_THROW(smallIndex.recover(*rr2), std::exception);
+}
+
+TEST(FixedSizeIndex, ThreadSafe) {
+  FixedSizeIndex index{1000};
+  const uint64_t bucket = 5;
+  const uint64_t readKey = makeKey(1, bucket);
+  index.insert(readKey, 1, 1);
+
+  // writers keep changing the other entries of the bucket while readers
+  // look up the key, which must never be torn or missing
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> writers;
+  for (uint16_t w = 0; w < 4; w++) {
+    writers.emplace_back([&index, &stop, w] {
+      uint32_t i = 0;
+      while (!stop) {
+        const auto key = makeKey(2 + w, bucket);
+        index.insert(key, i, static_cast<uint16_t>(i));
+        auto lr = index.peek(key);
+        EXPECT_EQ(static_cast<uint16_t>(lr.address()), lr.sizeHint());
+        index.remove(key);
+        i++;
+      }
+    });
+  }
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 4; r++) {
+    readers.emplace_back([&index, readKey] {
+      for (int i = 0; i < 50; i++) {
+        auto lr = index.lookup(readKey);
+        ASSERT_TRUE(lr.found());
+        EXPECT_EQ(1, lr.address());
+        EXPECT_EQ(1, lr.sizeHint());
+      }
+    });
+  }
+  for (auto& t : readers) {
+    t.join();
+  }
+  stop = true;
+  for (auto& t : writers) {
+    t.join();
+  }
+
+  EXPECT_EQ(200, index.peek(readKey).totalHits());
+  EXPECT_EQ(200, index.peek(readKey).currentHits());
+}
+} // namespace tests
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -19,6 +19,7 @@
 #include <thread>
 
 #include "cachelib/navy/block_cache/HitsReinsertionPolicy.h"
+#include "cachelib/navy/block_cache/SparseMapIndex.h"
 #include "cachelib/navy/common/Hash.h"
 #include "cachelib/navy/serialization/RecordIO.h"
 
@@ -28,7 +29,7 @@ namespace navy {
 namespace tests {
 
 TEST(HitsReinsertionPolicy, Simple) {
-  Index index;
+  SparseMapIndex index;
   HitsReinsertionPolicy tracker{1, index};
 
   auto hk1 = makeHK("test_key_1");
@@ -82,7 +83,7 @@ TEST(HitsReinsertionPolicy, Simple) {
 }
 
 TEST(HitsReinsertionPolicy, UpperBound) {
-  Index index;
+  SparseMapIndex index;
   auto hk1 = makeHK("test_key_1");
 
   index.insert(hk1.keyHash(), 0, 0);
@@ -97,7 +98,7 @@ TEST(HitsReinsertionPolicy, UpperBound) {
 }
 
 TEST(HitsReinsertionPolicy, ThreadSafe) {
-  Index index;
+  SparseMapIndex index;
 
   auto hk1 = makeHK("test_key_1");
 
@@ -123,7 +124,7 @@ TEST(HitsReinsertionPolicy, ThreadSafe) {
 }
 
 TEST(HitsReinsertionPolicy, Recovery) {
-  Index index;
+  SparseMapIndex index;
   auto hk1 = makeHK("test_key_1");
 
   index.insert(hk1.keyHash(), 0, 0);
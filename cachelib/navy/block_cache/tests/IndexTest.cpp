@@ -18,14 +18,14 @@
 
 #include <thread>
 
-#include "cachelib/navy/block_cache/Index.h"
+#include "cachelib/navy/block_cache/SparseMapIndex.h"
 
 namespace facebook {
 namespace cachelib {
 namespace navy {
 namespace tests {
 TEST(Index, Recovery) {
-  Index index;
+  SparseMapIndex index;
   std::vector<std::pair<uint64_t, uint32_t>> log;
   // Write to 16 buckets
   for (uint64_t i = 0; i < 16; i++) {
@@ -43,7 +43,7 @@ TEST(Index, Recovery) {
   index.persist(*rw);
 
   auto rr = createMemoryRecordReader(ioq);
-  Index newIndex;
+  SparseMapIndex newIndex;
   newIndex.recover(*rr);
   for (auto& entry : log) {
     auto lookupResult = newIndex.lookup(entry.first);
@@ -52,7 +52,7 @@ TEST(Index, Recovery) {
 }
 
 TEST(Index, EntrySize) {
-  Index index;
+  SparseMapIndex index;
   index.insert(111, 0, 11);
   EXPECT_EQ(11, index.lookup(111).sizeHint());
   index.insert(222, 0, 150);
@@ -62,7 +62,7 @@ TEST(Index, EntrySize) {
 }
 
 TEST(Index, ReplaceExact) {
-  Index index;
+  SparseMapIndex index;
   // Empty value should fail in replace
   EXPECT_FALSE(index.replaceIfMatch(111, 3333, 2222));
   EXPECT_FALSE(index.lookup(111).found());
@@ -82,7 +82,7 @@ TEST(Index, ReplaceExact) {
 }
 
 TEST(Index, RemoveExact) {
-  Index index;
+  SparseMapIndex index;
   // Empty value should fail in replace
   EXPECT_FALSE(index.removeIfMatch(111, 4444));
 
@@ -99,7 +99,7 @@ TEST(Index, RemoveExact) {
 }
 
 TEST(Index, Hits) {
-  Index index;
+  SparseMapIndex index;
   const uint64_t key = 9527;
 
   // Hits after inserting should be 0
@@ -129,7 +129,7 @@ TEST(Index, Hits) {
 }
 
 TEST(Index, HitsAfterUpdate) {
-  Index index;
+  SparseMapIndex index;
   const uint64_t key = 9527;
 
   // Hits after inserting should be 0
@@ -165,7 +165,7 @@ TEST(Index, HitsAfterUpdate) {
 }
 
 TEST(Index, HitsUpperBound) {
-  Index index;
+  SparseMapIndex index;
   const uint64_t key = 8341;
 
   index.insert(key, 0, 0);
@@ -178,7 +178,7 @@ TEST(Index, HitsUpperBound) {
 }
 
 TEST(Index, ThreadSafe) {
-  Index index;
+  SparseMapIndex index;
   const uint64_t key = 1314;
   index.insert(key, 0, 0);
 
@@ -18,7 +18,9 @@
 
 #include <folly/File.h>
 #include <folly/Format.h>
+#include <folly/synchronization/Baton.h>
 
+#include <atomic>
 #include <cstring>
 #include <numeric>
 
@@ -212,18 +214,38 @@ class MemoryDevice final : public Device {
 };
 } // namespace
 
+bool Device::encryptForWrite(uint64_t offset, Buffer& buffer) {
+  if (!encryptor_) {
+    return true;
+  }
+  XCHECK_EQ(offset % encryptor_->encryptionBlockSize(), 0ul);
+  auto res = encryptor_->encrypt(
+      folly::MutableByteRange{buffer.data(), buffer.size()}, offset);
+  if (!res) {
+    encryptionErrors_.inc();
+  }
+  return res;
+}
+
 bool Device::write(uint64_t offset, Buffer buffer) {
+  if (supportsAsyncIO()) {
+    // all the writes are in flight together
+    folly::Baton<> done;
+    bool result = false;
+    writeAsync(offset, std::move(buffer), [&done, &result](bool res) {
+      result = res;
+      done.post();
+    });
+    done.wait();
+    return result;
+  }
+
   const auto size = buffer.size();
   XDCHECK_LE(offset + buffer.size(), size_);
   uint8_t* data = reinterpret_cast<uint8_t*>(buffer.data());
   XDCHECK_EQ(reinterpret_cast<uint64_t>(data) % ioAlignmentSize_, 0ul);
-  if (encryptor_) {
-    XCHECK_EQ(offset % encryptor_->encryptionBlockSize(), 0ul);
-    auto res = encryptor_->encrypt(folly::MutableByteRange{data, size}, offset);
-    if (!res) {
-      encryptionErrors_.inc();
-      return false;
-    }
+  if (!encryptForWrite(offset, buffer)) {
+    return false;
   }
 
   auto remainingSize = size;
@@ -255,6 +277,66 @@ bool Device::write(uint64_t offset, Buffer buffer) {
   return result;
 }
 
+void Device::writeAsync(uint64_t offset, Buffer buffer, IOCallback cb) {
+  const auto size = buffer.size();
+  XDCHECK_LE(offset + size, size_);
+  XDCHECK_EQ(reinterpret_cast<uint64_t>(buffer.data()) % ioAlignmentSize_,
+             0ul);
+  if (!encryptForWrite(offset, buffer)) {
+    cb(false);
+    return;
+  }
+  if (size == 0) {
+    cb(true);
+    return;
+  }
+
+  // The writes of the buffer share it. The last one to complete invokes the
+  // callback.
+  struct WriteState {
+    WriteState(Buffer b, IOCallback c, size_t n)
+        : buffer{std::move(b)}, cb{std::move(c)}, pending{n} {}
+
+    Buffer buffer;
+    IOCallback cb;
+    std::atomic<size_t> pending;
+    std::atomic<bool> result{true};
+  };
+  const size_t maxWriteSize = (maxWriteSize_ == 0) ? size : maxWriteSize_;
+  const size_t numWrites = (size + maxWriteSize - 1) / maxWriteSize;
+  auto state =
+      std::make_shared<WriteState>(std::move(buffer), std::move(cb), numWrites);
+  const uint8_t* data = state->buffer.data();
+
+  for (size_t done = 0; done < size; done += maxWriteSize) {
+    const auto writeSize = std::min<size_t>(maxWriteSize, size - done);
+    XDCHECK_EQ((offset + done) % ioAlignmentSize_, 0ul);
+    XDCHECK_EQ(writeSize % ioAlignmentSize_, 0ul);
+
+    auto timeBegin = getSteadyClock();
+    writeAsyncImpl(
+        offset + done, writeSize, data + done,
+        [this, state, writeSize, timeBegin](bool res) {
+          writeLatencyEstimator_.trackValue(
+              toMicros((getSteadyClock() - timeBegin)).count());
+          if (res) {
+            bytesWritten_.add(writeSize);
+          } else {
+            state->result = false;
+          }
+          if (state->pending.fetch_sub(1) == 1) {
+            const bool result = state->result;
+            if (!result) {
+              writeIOErrors_.inc();
+            }
+            state->buffer = Buffer{};
+            auto stateCb = std::move(state->cb);
+            stateCb(result);
+          }
+        });
+  }
+}
+
 // reads size number of bytes from the device from the offset into value.
 // Both offset and size are expected to be aligned for device IO operations.
 // If successful and encryptor_ is defined, size bytes from
@@ -270,6 +352,13 @@ bool Device::readInternal(uint64_t offset, uint32_t size, void* value) {
   bool result = readImpl(offset, size, value);
   readLatencyEstimator_.trackValue(
       toMicros(getSteadyClock() - timeBegin).count());
+  return completeRead(offset, size, value, result);
+}
+
+bool Device::completeRead(uint64_t offset,
+                          uint32_t size,
+                          void* value,
+                          bool result) {
   if (!result) {
     readIOErrors_.inc();
     return result;
@@ -319,6 +408,47 @@ bool Device::read(uint64_t offset, uint32_t size, void* value) {
   return readInternal(offset, size, value);
 }
 
+void Device::readAsync(uint64_t offset,
+                       uint32_t size,
+                       void* value,
+                       IOCallback cb) {
+  XDCHECK_EQ(reinterpret_cast<uint64_t>(value) % ioAlignmentSize_, 0ul);
+  XDCHECK_EQ(offset % ioAlignmentSize_, 0ul);
+  XDCHECK_EQ(size % ioAlignmentSize_, 0ul);
+  XDCHECK_LE(offset + size, size_);
+  auto timeBegin = getSteadyClock();
+  readAsyncImpl(offset, size, value,
+                [this, offset, size, value, timeBegin,
+                 cb = std::move(cb)](bool result) mutable {
+                  readLatencyEstimator_.trackValue(
+                      toMicros(getSteadyClock() - timeBegin).count());
+                  cb(completeRead(offset, size, value, result));
+                });
+}
+
+void Device::readAsync(uint64_t offset, uint32_t size, ReadCallback cb) {
+  XDCHECK_LE(offset + size, size_);
+  uint64_t readOffset =
+      offset & ~(static_cast<uint64_t>(ioAlignmentSize_) - 1ul);
+  uint64_t readPrefixSize =
+      offset & (static_cast<uint64_t>(ioAlignmentSize_) - 1ul);
+  auto readSize = getIOAlignedSize(readPrefixSize + size);
+  auto buffer = makeIOBuffer(readSize);
+  // the data does not move with the buffer
+  auto* data = buffer.data();
+  readAsync(readOffset, readSize, data,
+            [readPrefixSize, size, buffer = std::move(buffer),
+             cb = std::move(cb)](bool result) mutable {
+              if (!result) {
+                cb(Buffer{});
+                return;
+              }
+              buffer.trimStart(readPrefixSize);
+              buffer.shrink(size);
+              cb(std::move(buffer));
+            });
+}
+
 void Device::getCounters(const CounterVisitor& visitor) const {
   visitor("navy_device_bytes_written", getBytesWritten());
   visitor("navy_device_bytes_read", getBytesRead());
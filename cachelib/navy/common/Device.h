@@ -17,6 +17,7 @@
 #pragma once
 
 #include <folly/File.h>
+#include <folly/Function.h>
 #include <folly/io/IOBuf.h>
 
 #include "cachelib/common/AtomicCounter.h"
@@ -55,8 +56,22 @@ class DeviceEncryptor {
 //
 // Read/write returns true if @value written/read entirely (all @size bytes).
 // Pointer ownership is not passed.
+//
+// Devices that support asynchronous IO (see supportsAsyncIO) complete
+// readAsync/writeAsync from their own completion thread, so a few threads
+// can keep many IOs in flight. Other devices do the IO in the calling thread
+// and invoke the callback before returning.
 class Device {
  public:
+  // Callback for asynchronous IO. Called with true if all the bytes were
+  // read/written. It may be called from the device's completion thread, so
+  // it must not block. It may start another asynchronous IO.
+  using IOCallback = folly::Function<void(bool)>;
+
+  // Callback for asynchronous reads into a Buffer. Called with an empty
+  // buffer on error, like read(offset, size).
+  using ReadCallback = folly::Function<void(Buffer)>;
+
   // @param size    total size of the device
   explicit Device(uint64_t size)
       : Device{size, nullptr /* encryptor */, 0 /* max device write size */} {}
@@ -130,6 +145,24 @@ class Device {
   // bytes from offset.
   Buffer read(uint64_t offset, uint32_t size);
 
+  // Asynchronous version of write(offset, buffer). The buffer is released
+  // after the IO completes. A write larger than the max device write size is
+  // split into several IOs that are all in flight together if the device
+  // supports asynchronous IO.
+  void writeAsync(uint64_t offset, Buffer buffer, IOCallback cb);
+
+  // Asynchronous version of read(offset, size, value). @value must stay
+  // valid until the callback is invoked.
+  void readAsync(uint64_t offset, uint32_t size, void* value, IOCallback cb);
+
+  // Asynchronous version of read(offset, size). @offset and @size do not
+  // need to be aligned.
+  void readAsync(uint64_t offset, uint32_t size, ReadCallback cb);
+
+  // Return true if the asynchronous IO calls do not block the calling thread
+  // until the IO completes.
+  virtual bool supportsAsyncIO() const { return false; }
+
   // Everything should be on device after this call returns.
   void flush() { flushImpl(); }
 
@@ -153,6 +186,21 @@ class Device {
   virtual bool readImpl(uint64_t offset, uint32_t size, void* value) = 0;
   virtual void flushImpl() = 0;
 
+  // Start an IO and invoke the callback once it completes. The default does
+  // the IO synchronously with readImpl/writeImpl.
+  virtual void writeAsyncImpl(uint64_t offset,
+                              uint32_t size,
+                              const void* value,
+                              IOCallback cb) {
+    cb(writeImpl(offset, size, value));
+  }
+  virtual void readAsyncImpl(uint64_t offset,
+                             uint32_t size,
+                             void* value,
+                             IOCallback cb) {
+    cb(readImpl(offset, size, value));
+  }
+
  private:
   mutable AtomicCounter bytesWritten_;
   mutable AtomicCounter bytesRead_;
@@ -166,6 +214,15 @@ class Device {
 
   bool readInternal(uint64_t offset, uint32_t size, void* value);
 
+  // encrypt the buffer before it is written
+  bool encryptForWrite(uint64_t offset, Buffer& buffer);
+
+  // account for a completed read and decrypt the value
+  //
+  // @param result  result of readImpl
+  // @return true if the read succeeded
+  bool completeRead(uint64_t offset, uint32_t size, void* value, bool result);
+
   // size of the device. All offsets for write/read should be contained
   // below this.
   const uint64_t size_{0};
@@ -198,6 +255,42 @@ std::unique_ptr<Device> createDirectIoRAID0Device(
     uint32_t stripeSize,
     std::shared_ptr<DeviceEncryptor> encryptor,
     uint32_t maxDeviceWriteSize);
+
+// Options for a device doing IO through io_uring
+struct IoUringOptions {
+  // max number of IOs in flight. 0 means to not use io_uring.
+  uint32_t queueDepth{0};
+
+  // if true, a kernel thread polls the submission queue, so that submitting
+  // an IO does not need a system call. The thread takes a cpu while IOs are
+  // submitted and goes to sleep after sqPollIdleMs without any.
+  bool sqPoll{false};
+  uint32_t sqPollIdleMs{1000};
+};
+
+// @return true if the kernel and the build support io_uring
+bool isIoUringSupported();
+
+// Create a device doing asynchronous IO through io_uring over one or more
+// files, striped like createDirectIoRAID0Device if there are several. The
+// files are registered with the ring.
+//
+// @param fVec          files of the device
+// @param size          size of each file
+// @param stripeSize    stripe size when there are several files
+// @param options       io_uring options
+//
+// @throw std::invalid_argument if the options are invalid or cachelib is
+//        built without io_uring
+// @throw std::system_error if the ring can not be created
+std::unique_ptr<Device> createIoUringDevice(
+    std::vector<folly::File> fVec,
+    uint64_t size,
+    uint32_t ioAlignSize,
+    uint32_t stripeSize,
+    std::shared_ptr<DeviceEncryptor> encryptor,
+    uint32_t maxDeviceWriteSize,
+    const IoUringOptions& options);
 // Default ioAlignSize size for Memory Device is 1. In our tests, we create
 // Devices with different ioAlignSize sizes using memory device. So we need
 // a way to set a different ioAlignSize size for memory devices.
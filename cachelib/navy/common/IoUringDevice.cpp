@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/File.h>
+#include <folly/Format.h>
+#include <folly/synchronization/Baton.h>
+
+#include <stdexcept>
+
+#include "cachelib/navy/common/Device.h"
+
+#ifdef CACHELIB_IO_URING
+#include <liburing.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#endif
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+#ifdef CACHELIB_IO_URING
+namespace {
+// Device doing IO through an io_uring.
+//
+// IOs are submitted by the calling threads under a lock and completed by a
+// single thread that reaps the completion queue and invokes the callbacks.
+// An IO that spans several stripes of the files is submitted as one request
+// per stripe, and completes when all of them do.
+class IoUringDevice final : public Device {
+ public:
+  IoUringDevice(std::vector<folly::File> fvec,
+                uint64_t fdSize,
+                uint32_t ioAlignSize,
+                uint32_t stripeSize,
+                std::shared_ptr<DeviceEncryptor> encryptor,
+                uint32_t maxDeviceWriteSize,
+                const IoUringOptions& options)
+      : Device{fdSize * fvec.size(), std::move(encryptor), ioAlignSize,
+               maxDeviceWriteSize},
+        fvec_{std::move(fvec)},
+        stripeSize_(fvec_.size() > 1 ? stripeSize : fdSize),
+        queueDepth_{options.queueDepth},
+        sqPoll_{options.sqPoll} {
+    if (fvec_.empty()) {
+      throw std::invalid_argument("io_uring device needs at least one file");
+    }
+    if (queueDepth_ == 0) {
+      throw std::invalid_argument("io_uring queue depth must be positive");
+    }
+    if (stripeSize_ == 0 || fdSize % stripeSize_ != 0 ||
+        stripeSize_ % ioAlignSize != 0) {
+      throw std::invalid_argument(
+          folly::sformat("Invalid stripe size {} for device size {} and io "
+                         "alignment {}",
+                         stripeSize_, fdSize, ioAlignSize));
+    }
+
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    if (options.sqPoll) {
+      params.flags |= IORING_SETUP_SQPOLL;
+      params.sq_thread_idle = options.sqPollIdleMs;
+    }
+    int ret = io_uring_queue_init_params(queueDepth_, &ring_, &params);
+    if (ret < 0) {
+      throw std::system_error(-ret, std::system_category(),
+                              "Failed to create io_uring");
+    }
+
+    std::vector<int> fds;
+    for (const auto& f : fvec_) {
+      fds.push_back(f.fd());
+    }
+    ret = io_uring_register_files(&ring_, fds.data(), fds.size());
+    if (ret < 0) {
+      io_uring_queue_exit(&ring_);
+      throw std::system_error(-ret, std::system_category(),
+                              "Failed to register files with io_uring");
+    }
+
+    completionThread_ = std::thread([this] { reapCompletions(); });
+  }
+
+  IoUringDevice(const IoUringDevice&) = delete;
+  IoUringDevice& operator=(const IoUringDevice&) = delete;
+
+  ~IoUringDevice() override {
+    {
+      std::unique_lock<std::mutex> l{mutex_};
+      slotAvailable_.wait(l, [this] { return inFlight_ == 0; });
+      // a request without a context stops the completion thread
+      auto* sqe = io_uring_get_sqe(&ring_);
+      XDCHECK(sqe != nullptr);
+      io_uring_prep_nop(sqe);
+      io_uring_sqe_set_data(sqe, nullptr);
+      unsubmitted_.emplace_back(sqe, nullptr);
+      inFlight_++;
+      std::vector<IOContext*> failed;
+      submitLocked(failed);
+      XDCHECK(failed.empty());
+    }
+    completionThread_.join();
+    io_uring_queue_exit(&ring_);
+  }
+
+  bool supportsAsyncIO() const override { return true; }
+
+ private:
+  // state of an IO, shared by its requests
+  struct IOContext {
+    IOContext(uint32_t s, IOCallback c) : size{s}, cb{std::move(c)} {}
+
+    const uint32_t size;
+    IOCallback cb;
+    std::atomic<uint32_t> pending{0};
+    std::atomic<uint32_t> bytesDone{0};
+    std::atomic<bool> failed{false};
+  };
+
+  bool writeImpl(uint64_t offset, uint32_t size, const void* value) override {
+    return doSync([&](IOCallback cb) {
+      submit(true, offset, size, const_cast<void*>(value), std::move(cb));
+    });
+  }
+
+  bool readImpl(uint64_t offset, uint32_t size, void* value) override {
+    return doSync([&](IOCallback cb) {
+      submit(false, offset, size, value, std::move(cb));
+    });
+  }
+
+  void writeAsyncImpl(uint64_t offset,
+                      uint32_t size,
+                      const void* value,
+                      IOCallback cb) override {
+    submit(true, offset, size, const_cast<void*>(value), std::move(cb));
+  }
+
+  void readAsyncImpl(uint64_t offset,
+                     uint32_t size,
+                     void* value,
+                     IOCallback cb) override {
+    submit(false, offset, size, value, std::move(cb));
+  }
+
+  void flushImpl() override {
+    for (const auto& f : fvec_) {
+      ::fsync(f.fd());
+    }
+  }
+
+  template <typename SubmitFn>
+  static bool doSync(SubmitFn&& submitFn) {
+    folly::Baton<> done;
+    bool result = false;
+    submitFn([&done, &result](bool res) {
+      result = res;
+      done.post();
+    });
+    done.wait();
+    return result;
+  }
+
+  void submit(bool isWrite,
+              uint64_t offset,
+              uint32_t size,
+              void* value,
+              IOCallback cb) {
+    if (size == 0) {
+      cb(true);
+      return;
+    }
+    auto* ctx = new IOContext{size, std::move(cb)};
+    uint8_t* buf = reinterpret_cast<uint8_t*>(value);
+
+    // a callback that starts another IO must not wait for a slot, since
+    // only the completion thread frees them. It goes over the queue depth
+    // instead.
+    const bool onCompletionThread =
+        std::this_thread::get_id() == completionThread_.get_id();
+    std::vector<IOContext*> failed;
+    std::unique_lock<std::mutex> l{mutex_};
+    // count every request before submitting any, so that the context is not
+    // completed by a request that finishes before the last one is submitted.
+    ctx->pending = getNumStripes(offset, size);
+    while (size > 0) {
+      const uint64_t stripe = offset / stripeSize_;
+      const uint32_t fdIdx = stripe % fvec_.size();
+      const uint64_t stripeStartOffset = (stripe / fvec_.size()) * stripeSize_;
+      const uint64_t ioOffsetInStripe = offset % stripeSize_;
+      const uint32_t ioSize =
+          std::min<uint64_t>(size, stripeSize_ - ioOffsetInStripe);
+
+      if (inFlight_ >= queueDepth_ && !onCompletionThread) {
+        submitLocked(failed);
+        slotAvailable_.wait(l, [this] { return inFlight_ < queueDepth_; });
+      }
+      auto* sqe = io_uring_get_sqe(&ring_);
+      while (sqe == nullptr) {
+        // the submission queue is full of requests over the queue depth
+        submitLocked(failed);
+        sqe = io_uring_get_sqe(&ring_);
+      }
+      const uint64_t fileOffset = stripeStartOffset + ioOffsetInStripe;
+      if (isWrite) {
+        io_uring_prep_write(sqe, fdIdx, buf, ioSize, fileOffset);
+      } else {
+        io_uring_prep_read(sqe, fdIdx, buf, ioSize, fileOffset);
+      }
+      sqe->flags |= IOSQE_FIXED_FILE;
+      io_uring_sqe_set_data(sqe, ctx);
+      unsubmitted_.emplace_back(sqe, ctx);
+      inFlight_++;
+
+      size -= ioSize;
+      offset += ioSize;
+      buf += ioSize;
+    }
+    submitLocked(failed);
+    l.unlock();
+    // the callbacks may start other IOs
+    for (auto* failedCtx : failed) {
+      failedCtx->cb(false);
+      delete failedCtx;
+    }
+  }
+
+  uint32_t getNumStripes(uint64_t offset, uint32_t size) const {
+    return (offset + size - 1) / stripeSize_ - offset / stripeSize_ + 1;
+  }
+
+  // submit the queued requests. Must hold mutex_.
+  //
+  // If the ring rejects them, their IOs fail. The contexts of the IOs that
+  // have no other request left are added to @failed, for the caller to
+  // complete once it releases mutex_.
+  void submitLocked(std::vector<IOContext*>& failed) {
+    while (true) {
+      int ret = io_uring_submit(&ring_);
+      if (ret >= 0) {
+        // requests the kernel did not consume yet go with the next
+        // submission
+        unsubmitted_.erase(
+            unsubmitted_.begin(),
+            unsubmitted_.begin() +
+                std::min<size_t>(static_cast<size_t>(ret),
+                                 unsubmitted_.size()));
+        return;
+      }
+      if (ret != -EINTR && ret != -EAGAIN && ret != -EBUSY) {
+        XLOG_EVERY_N_THREAD(
+            ERR, 1000,
+            folly::sformat("io_uring submit error: {}", std::strerror(-ret)));
+        failUnsubmittedLocked(failed);
+        return;
+      }
+    }
+  }
+
+  // fail the IOs of the requests left in the submission queue. Must hold
+  // mutex_.
+  void failUnsubmittedLocked(std::vector<IOContext*>& failed) {
+    if (sqPoll_) {
+      // the polling thread picks them up from the submission queue on its
+      // own, so they complete as usual.
+      unsubmitted_.clear();
+      return;
+    }
+    // the kernel has not read them, so they can still be rewritten. They
+    // become no-ops whose completions are ignored, and stay queued and keep
+    // their slot in inFlight_ until then.
+    for (auto& [sqe, ctx] : unsubmitted_) {
+      if (ctx == nullptr) {
+        continue;
+      }
+      io_uring_prep_nop(sqe);
+      io_uring_sqe_set_data(sqe, &kDroppedRequest);
+      ctx->failed = true;
+      if (ctx->pending.fetch_sub(1) == 1) {
+        failed.push_back(ctx);
+      }
+      ctx = nullptr;
+    }
+  }
+
+  void reapCompletions() {
+    while (true) {
+      struct io_uring_cqe* cqe = nullptr;
+      int ret = io_uring_wait_cqe(&ring_, &cqe);
+      if (ret < 0) {
+        if (ret != -EINTR && ret != -EAGAIN) {
+          XLOG_EVERY_N_THREAD(ERR, 1000,
+                              folly::sformat("io_uring wait error: {}",
+                                             std::strerror(-ret)));
+        }
+        continue;
+      }
+      void* data = io_uring_cqe_get_data(cqe);
+      const int res = cqe->res;
+      io_uring_cqe_seen(&ring_, cqe);
+      {
+        std::lock_guard<std::mutex> l{mutex_};
+        inFlight_--;
+      }
+      slotAvailable_.notify_all();
+      if (data == nullptr) {
+        return;
+      }
+      if (data == &kDroppedRequest) {
+        continue;
+      }
+      auto* ctx = reinterpret_cast<IOContext*>(data);
+
+      if (res < 0) {
+        XLOG_EVERY_N_THREAD(
+            ERR, 1000,
+            folly::sformat("IO error: io_uring size={} ret={} ({})",
+                           ctx->size, res, std::strerror(-res)));
+        ctx->failed = true;
+      } else {
+        ctx->bytesDone.fetch_add(res);
+      }
+      if (ctx->pending.fetch_sub(1) == 1) {
+        const bool result = !ctx->failed && ctx->bytesDone == ctx->size;
+        if (!ctx->failed && !result) {
+          XLOG_EVERY_N_THREAD(
+              ERR, 1000,
+              folly::sformat("IO error: io_uring short io size={} done={}",
+                             ctx->size, ctx->bytesDone.load()));
+        }
+        ctx->cb(result);
+        delete ctx;
+      }
+    }
+  }
+
+  const std::vector<folly::File> fvec_{};
+  // the file size if there is a single file
+  const uint64_t stripeSize_{};
+  const uint32_t queueDepth_{};
+  const bool sqPoll_{};
+
+  // data of the requests turned into no-ops by failUnsubmittedLocked
+  static char kDroppedRequest;
+
+  struct io_uring ring_;
+
+  // protects the submission queue and inFlight_. Completions are reaped
+  // without it.
+  std::mutex mutex_;
+  std::condition_variable slotAvailable_;
+  uint32_t inFlight_{0};
+
+  // requests the kernel has not consumed yet, in the order of the
+  // submission queue. The context is nullptr for the requests that are not
+  // part of an IO.
+  std::vector<std::pair<struct io_uring_sqe*, IOContext*>> unsubmitted_;
+
+  std::thread completionThread_;
+};
+
+char IoUringDevice::kDroppedRequest;
+} // namespace
+
+bool isIoUringSupported() {
+  struct io_uring ring;
+  if (io_uring_queue_init(1, &ring, 0) < 0) {
+    return false;
+  }
+  io_uring_queue_exit(&ring);
+  return true;
+}
+
+std::unique_ptr<Device> createIoUringDevice(
+    std::vector<folly::File> fvec,
+    uint64_t size,
+    uint32_t ioAlignSize,
+    uint32_t stripeSize,
+    std::shared_ptr<DeviceEncryptor> encryptor,
+    uint32_t maxDeviceWriteSize,
+    const IoUringOptions& options) {
+  XDCHECK(folly::isPowTwo(ioAlignSize));
+  return std::make_unique<IoUringDevice>(std::move(fvec), size, ioAlignSize,
+                                         stripeSize, std::move(encryptor),
+                                         maxDeviceWriteSize, options);
+}
+#else
+bool isIoUringSupported() { return false; }
+
+std::unique_ptr<Device> createIoUringDevice(
+    std::vector<folly::File> /* fvec */,
+    uint64_t /* size */,
+    uint32_t /* ioAlignSize */,
+    uint32_t /* stripeSize */,
+    std::shared_ptr<DeviceEncryptor> /* encryptor */,
+    uint32_t /* maxDeviceWriteSize */,
+    const IoUringOptions& /* options */) {
+  throw std::invalid_argument("cachelib is built without io_uring support");
+}
+#endif
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
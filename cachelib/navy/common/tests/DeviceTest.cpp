@@ -20,6 +20,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <thread>
 
 #include "cachelib/common/Utils.h"
@@ -348,6 +349,148 @@ TEST(Device, RAID0IOAlignment) {
                                          0 /* max device write size */),
                std::invalid_argument);
 }
+
+TEST(Device, IoUringIO) {
+  if (!isIoUringSupported()) {
+    GTEST_SKIP() << "io_uring is not supported";
+  }
+  auto filePath = folly::sformat("/tmp/DEVICE_IOURING_TEST-{}", ::getpid());
+  SCOPE_EXIT { util::removePath(filePath); };
+
+  int size = 4 * 1024 * 1024;
+  int ioAlignSize = 4096;
+  auto f = folly::File(filePath.c_str(), O_RDWR | O_CREAT);
+  ASSERT_EQ(0, ::fallocate(f.fd(), 0, 0, size));
+  std::vector<folly::File> fvec;
+  fvec.push_back(std::move(f));
+
+  IoUringOptions options;
+  options.queueDepth = 8;
+  auto device = createIoUringDevice(
+      std::move(fvec), size, ioAlignSize, 0 /* stripe size */,
+      nullptr /* encryption */, 64 * 1024 /* max device write size */, options);
+  EXPECT_TRUE(device->supportsAsyncIO());
+  EXPECT_EQ(size, device->getSize());
+
+  // the write is split into 16 writes that are in flight together
+  uint32_t ioSize = 1024 * 1024;
+  Buffer wbuf = device->makeIOBuffer(ioSize);
+  for (uint32_t i = 0; i < ioSize; i++) {
+    wbuf.data()[i] = folly::Random::rand32() % 64;
+  }
+  EXPECT_TRUE(device->write(ioAlignSize, wbuf.copy(ioAlignSize)));
+  Buffer rbuf = device->makeIOBuffer(ioSize);
+  EXPECT_TRUE(device->read(ioAlignSize, ioSize, rbuf.data()));
+  EXPECT_EQ(0, std::memcmp(wbuf.data(), rbuf.data(), ioSize));
+
+  // more reads in flight than the queue depth
+  const uint32_t numReads = 64;
+  std::vector<Buffer> rbufs;
+  for (uint32_t i = 0; i < numReads; i++) {
+    rbufs.push_back(device->makeIOBuffer(ioAlignSize));
+  }
+  std::atomic<uint32_t> numDone{0};
+  std::atomic<uint32_t> numFailed{0};
+  for (uint32_t i = 0; i < numReads; i++) {
+    device->readAsync(ioAlignSize * (i + 1), ioAlignSize, rbufs[i].data(),
+                      [&](bool res) {
+                        if (!res) {
+                          numFailed++;
+                        }
+                        numDone++;
+                      });
+  }
+  while (numDone < numReads) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(0, numFailed);
+  for (uint32_t i = 0; i < numReads; i++) {
+    EXPECT_EQ(0, std::memcmp(wbuf.data() + ioAlignSize * i, rbufs[i].data(),
+                             ioAlignSize));
+  }
+
+  // reading past the end of the file is a short read
+  auto shortFile = folly::File(filePath.c_str(), O_RDWR);
+  ASSERT_EQ(0, ::ftruncate(shortFile.fd(), size / 2));
+  EXPECT_FALSE(device->read(size - ioAlignSize, ioAlignSize, rbuf.data()));
+
+  MockCounterVisitor visitor;
+  EXPECT_CALL(visitor, call(_, _)).WillRepeatedly(testing::Return());
+  EXPECT_CALL(visitor, call(strPiece("navy_device_bytes_written"), ioSize));
+  EXPECT_CALL(visitor, call(strPiece("navy_device_read_errors"), 1));
+  device->getCounters(toCallback(visitor));
+}
+
+TEST(Device, IoUringRAID0IO) {
+  if (!isIoUringSupported()) {
+    GTEST_SKIP() << "io_uring is not supported";
+  }
+  auto filePath =
+      folly::sformat("/tmp/DEVICE_IOURING_RAID0IO_TEST-{}", ::getpid());
+  util::makeDir(filePath);
+  SCOPE_EXIT { util::removePath(filePath); };
+
+  std::vector<std::string> files = {filePath + "/CACHE0", filePath + "/CACHE1",
+                                    filePath + "/CACHE2", filePath + "/CACHE3"};
+
+  int size = 4 * 1024 * 1024;
+  int ioAlignSize = 4096;
+  int stripeSize = 8192;
+
+  std::vector<folly::File> fvec;
+  for (const auto& file : files) {
+    auto f = folly::File(file.c_str(), O_RDWR | O_CREAT);
+    ASSERT_EQ(0, ::fallocate(f.fd(), 0, 0, size));
+    fvec.push_back(std::move(f));
+  }
+  IoUringOptions options;
+  options.queueDepth = 4;
+  auto device = createIoUringDevice(std::move(fvec), size, ioAlignSize,
+                                    stripeSize, nullptr /* encryption */,
+                                    0 /* max device write size */, options);
+  EXPECT_EQ(files.size() * size, device->getSize());
+
+  // IO spans more stripes than the queue depth
+  auto ioSize = 10 * stripeSize;
+  auto offset = stripeSize * 7 + ioAlignSize;
+  Buffer wbuf = device->makeIOBuffer(ioSize);
+  Buffer rbuf = device->makeIOBuffer(ioSize);
+  for (int i = 0; i < ioSize; i++) {
+    wbuf.data()[i] = folly::Random::rand32() % 64;
+  }
+  EXPECT_TRUE(device->write(offset, wbuf.copy(ioAlignSize)));
+  EXPECT_TRUE(device->read(offset, ioSize, rbuf.data()));
+  EXPECT_EQ(0, std::memcmp(wbuf.data(), rbuf.data(), ioSize));
+
+  // the stripes are laid out like the RAID0 device's
+  fvec.clear();
+  for (const auto& file : files) {
+    fvec.push_back(folly::File(file.c_str(), O_RDWR));
+  }
+  auto raid0Device = createDirectIoRAID0Device(
+      std::move(fvec), size, ioAlignSize, stripeSize, nullptr /* encryption */,
+      0 /* max device write size */);
+  std::memset(rbuf.data(), 0, ioSize);
+  EXPECT_TRUE(raid0Device->read(offset, ioSize, rbuf.data()));
+  EXPECT_EQ(0, std::memcmp(wbuf.data(), rbuf.data(), ioSize));
+}
+
+TEST(Device, IoUringInvalidOptions) {
+  if (!isIoUringSupported()) {
+    GTEST_SKIP() << "io_uring is not supported";
+  }
+  auto filePath =
+      folly::sformat("/tmp/DEVICE_IOURING_OPTIONS_TEST-{}", ::getpid());
+  SCOPE_EXIT { util::removePath(filePath); };
+
+  std::vector<folly::File> fvec;
+  fvec.push_back(folly::File(filePath.c_str(), O_RDWR | O_CREAT));
+  ASSERT_THROW(
+      createIoUringDevice(std::move(fvec), 1024 * 1024, 4096,
+                          0 /* stripe size */, nullptr /* encryption */,
+                          0 /* max device write size */, IoUringOptions{}),
+      std::invalid_argument);
+}
 } // namespace tests
 } // namespace navy
 } // namespace cachelib
@@ -18,6 +18,8 @@
 
 #include <folly/synchronization/Baton.h>
 
+#include <thread>
+
 #include "cachelib/navy/admission_policy/DynamicRandomAP.h"
 #include "cachelib/navy/common/Hash.h"
 #include "cachelib/navy/driver/NoopEngine.h"
@@ -67,7 +69,7 @@ Driver::Driver(Config&& config, ValidConfigTag)
 
 Driver::~Driver() {
   XLOG(INFO, "Driver: finish scheduler");
-  scheduler_->finish();
+  finishJobs();
   XLOG(INFO, "Driver: finish scheduler successful");
   // Destroy this for safety first
   scheduler_.reset();
@@ -239,35 +241,88 @@ Status Driver::lookupAsync(BufferView key, LookupCallback cb) {
   const HashedKey hk{key};
   XDCHECK(cb);
 
+  pendingLookups_.inc();
+  lookupLargeItemAsync(hk, std::move(cb));
+  return Status::Ok;
+}
+
+void Driver::lookupLargeItemAsync(HashedKey hk, LookupCallback cb) {
   scheduler_->enqueueWithKey(
-      [this, cb = std::move(cb), hk, skipLargeItemCache = false]() mutable {
-        Buffer value;
-        Status status{Status::NotFound};
-        if (!skipLargeItemCache) {
-          status = largeItemCache_->lookup(hk, value);
-          if (status == Status::Retry) {
-            return JobExitCode::Reschedule;
-          }
-          skipLargeItemCache = true;
-        }
+      [this, hk, cb = std::move(cb)]() mutable {
+        const auto jobThread = std::this_thread::get_id();
+        largeItemCache_->lookupAsync(
+            hk, [this, hk, jobThread, cb = std::move(cb)](
+                    Status status, Buffer value) mutable {
+              if (status == Status::Retry) {
+                lookupLargeItemAsync(hk, std::move(cb));
+                return;
+              }
+              // The rest of the lookup and the callback run in a job if the
+              // read completed in the device's completion thread, which
+              // must not block and is shared by all the IOs.
+              if (std::this_thread::get_id() != jobThread) {
+                continueLookupAsync(hk, std::move(cb), status,
+                                    std::move(value));
+                return;
+              }
+              // Most misses are answered from the index, inline
+              if (status == Status::NotFound) {
+                status = smallItemCache_->lookup(hk, value);
+                if (status == Status::Retry) {
+                  continueLookupAsync(hk, std::move(cb), Status::NotFound,
+                                      Buffer{});
+                  return;
+                }
+              }
+              completeLookup(hk, cb, status, std::move(value));
+            });
+        return JobExitCode::Done;
+      },
+      "lookup",
+      JobType::Read,
+      hk.keyHash());
+}
+
+void Driver::continueLookupAsync(HashedKey hk,
+                                 LookupCallback cb,
+                                 Status status,
+                                 Buffer value) {
+  scheduler_->enqueueWithKey(
+      [this, hk, cb = std::move(cb), status,
+       value = std::move(value)]() mutable {
         if (status == Status::NotFound) {
-          status = smallItemCache_->lookup(hk, value);
-          if (status == Status::Retry) {
+          auto smallStatus = smallItemCache_->lookup(hk, value);
+          if (smallStatus == Status::Retry) {
             return JobExitCode::Reschedule;
           }
+          status = smallStatus;
         }
-
-        if (cb) {
-          cb(status, hk.key(), std::move(value));
-        }
-
-        updateLookupStats(status);
+        completeLookup(hk, cb, status, std::move(value));
         return JobExitCode::Done;
       },
       "lookup",
       JobType::Read,
       hk.keyHash());
-  return Status::Ok;
+}
+
+void Driver::completeLookup(HashedKey hk,
+                            LookupCallback& cb,
+                            Status status,
+                            Buffer value) {
+  if (cb) {
+    cb(status, hk.key(), std::move(value));
+  }
+  updateLookupStats(status);
+  pendingLookups_.dec();
+}
+
+void Driver::finishJobs() {
+  // a lookup waiting for the device schedules another job when it completes
+  scheduler_->finish();
+  while (pendingLookups_.get() > 0) {
+    std::this_thread::yield();
+    scheduler_->finish();
+  }
 }
 
 Status Driver::removeHashedKey(HashedKey hk, bool& skipSmallItemCache) {
@@ -323,14 +378,14 @@ Status Driver::removeAsync(BufferView key, RemoveCallback cb) {
 }
 
 void Driver::flush() {
-  scheduler_->finish();
+  finishJobs();
   smallItemCache_->flush();
   largeItemCache_->flush();
 }
 
 void Driver::reset() {
   XLOG(INFO, "Reset Navy");
-  scheduler_->finish();
+  finishJobs();
   smallItemCache_->reset();
   largeItemCache_->reset();
   if (admissionPolicy_) {
@@ -151,6 +151,22 @@ class Driver final : public AbstractCache {
   //   - second: the other engine to remove key
   std::pair<Engine&, Engine&> select(BufferView key, BufferView value) const;
   void updateLookupStats(Status status) const;
+
+  // Looks up the large item cache in a job that does not wait for the device
+  // read, then the small item cache if the key is not found.
+  void lookupLargeItemAsync(HashedKey hk, LookupCallback cb);
+  // Schedules the rest of a lookup, given the large item cache's @status
+  void continueLookupAsync(HashedKey hk,
+                           LookupCallback cb,
+                           Status status,
+                           Buffer value);
+  void completeLookup(HashedKey hk,
+                      LookupCallback& cb,
+                      Status status,
+                      Buffer value);
+
+  // Waits for the scheduled jobs and the asynchronous lookups to finish
+  void finishJobs();
   Status removeHashedKey(HashedKey hk, bool& skipSmallItemCache);
   bool admissionTest(HashedKey hk, BufferView value) const;
 
@@ -186,6 +202,8 @@ class Driver final : public AbstractCache {
   mutable AtomicCounter ioErrorCount_;
   mutable AtomicCounter parcelMemory_; // In bytes
   mutable AtomicCounter concurrentInserts_;
+  // lookups that have not called back yet
+  mutable AtomicCounter pendingLookups_;
 };
 } // namespace navy
 } // namespace cachelib
@@ -35,9 +35,24 @@ class Engine {
   // remains available via lookup.
   virtual Status insert(HashedKey hk, BufferView value) = 0;
 
+  // Called when an asynchronous lookup completes, with the value if the
+  // status is Status::Ok.
+  using LookupDoneCallback = folly::Function<void(Status, Buffer)>;
+
   // Looks up a key in the engine.
   virtual Status lookup(HashedKey hk, Buffer& value) = 0;
 
+  // Asynchronous version of lookup. Engines that read from the device
+  // without blocking call @cb from the device's completion thread, so it
+  // must not block. @cb may be called with Status::Retry like lookup.
+  // The key must stay valid until @cb is called. By default, looks up
+  // synchronously and calls @cb inline.
+  virtual void lookupAsync(HashedKey hk, LookupDoneCallback cb) {
+    Buffer value;
+    auto status = lookup(hk, value);
+    cb(status, std::move(value));
+  }
+
   // Remove must not return Status::Retry.
   virtual Status remove(HashedKey hk) = 0;
 
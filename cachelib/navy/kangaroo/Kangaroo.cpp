@@ -0,0 +1,1133 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/navy/kangaroo/Kangaroo.h"
+
+#include <folly/Format.h>
+#include <folly/logging/xlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "cachelib/navy/common/Utils.h"
+#include "cachelib/navy/serialization/Serialization.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+namespace {
+// Items whose destructor callback is invoked once the partition lock is
+// released, to avoid possible heavy operations or locks in the callback.
+using RemovedItems = std::vector<std::tuple<Buffer, Buffer, DestructorEvent>>;
+
+DestructorCallback makeCollector(RemovedItems& removedItems) {
+  return [&removedItems](BufferView key, BufferView val, DestructorEvent e) {
+    removedItems.emplace_back(key, val, e);
+  };
+}
+
+// Returns the item of the page with the given key hash
+Bucket::Iterator findByHash(const Bucket& page, uint64_t keyHash) {
+  auto itr = page.getFirst();
+  while (!itr.done() && itr.keyHash() != keyHash) {
+    itr = page.getNext(itr);
+  }
+  return itr;
+}
+
+// Returns whether the bucket has any of the keys
+bool hasAnyKey(const Bucket& bucket, const std::vector<HashedKey>& keys) {
+  return std::any_of(keys.begin(), keys.end(), [&bucket](HashedKey hk) {
+    return !bucket.find(hk).isNull();
+  });
+}
+
+// Removes the items with any of the key hashes from the bucket, without a
+// destructor call.
+//
+// @return the number of items removed
+uint32_t removeByHash(Bucket& bucket, const std::vector<uint64_t>& keyHashes) {
+  // the keys are copied since removing moves the other items
+  std::vector<std::pair<std::string, uint64_t>> keys;
+  for (auto itr = bucket.getFirst(); !itr.done(); itr = bucket.getNext(itr)) {
+    if (std::find(keyHashes.begin(), keyHashes.end(), itr.keyHash()) !=
+        keyHashes.end()) {
+      keys.emplace_back(
+          std::string{reinterpret_cast<const char*>(itr.key().data()),
+                      itr.key().size()},
+          itr.keyHash());
+    }
+  }
+  uint32_t removed = 0;
+  for (const auto& [key, keyHash] : keys) {
+    removed += bucket.remove(HashedKey::precomputed(key, keyHash),
+                             DestructorCallback{});
+  }
+  return removed;
+}
+} // namespace
+
+constexpr uint32_t Kangaroo::kFormatVersion;
+
+Kangaroo::Config& Kangaroo::Config::validate() {
+  if (!folly::isPowTwo(bucketSize)) {
+    throw std::invalid_argument(
+        folly::sformat("invalid bucket size: {}", bucketSize));
+  }
+
+  if (cacheBaseOffset % bucketSize != 0 || cacheSize % bucketSize != 0) {
+    throw std::invalid_argument(folly::sformat(
+        "cacheBaseOffset and cacheSize need to be a multiple of bucketSize. "
+        "cacheBaseOffset: {}, cacheSize:{}, bucketSize: {}.",
+        cacheBaseOffset,
+        cacheSize,
+        bucketSize));
+  }
+
+  if (logSizePct == 0 || logSizePct >= 100) {
+    throw std::invalid_argument(
+        folly::sformat("invalid log size pct: {}", logSizePct));
+  }
+
+  if (numLogPartitions == 0 || logSegmentPages == 0) {
+    throw std::invalid_argument(folly::sformat(
+        "invalid log partitions: {} or log segment pages: {}",
+        numLogPartitions,
+        logSegmentPages));
+  }
+
+  if (numLogPagesPerPartition() == 0) {
+    throw std::invalid_argument(folly::sformat(
+        "log of {}% of cache size: {} is too small for {} partitions of {} "
+        "pages of {} bytes",
+        logSizePct,
+        cacheSize,
+        numLogPartitions,
+        logSegmentPages,
+        bucketSize));
+  }
+
+  if (numSets() == 0 || numSets() > (uint64_t{1} << 32)) {
+    throw std::invalid_argument(folly::sformat(
+        "invalid number of sets: {}. Cache size: {}, bucket size: {}",
+        numSets(),
+        cacheSize,
+        bucketSize));
+  }
+
+  if (device == nullptr) {
+    throw std::invalid_argument("device cannot be null");
+  }
+
+  if (bloomFilter && bloomFilter->numFilters() != numSets()) {
+    throw std::invalid_argument(
+        folly::sformat("bloom filter #filters mismatch #sets: {} vs {}",
+                       bloomFilter->numFilters(),
+                       numSets()));
+  }
+  return *this;
+}
+
+Kangaroo::Kangaroo(Config&& config)
+    : Kangaroo{std::move(config.validate()), ValidConfigTag{}} {}
+
+Kangaroo::Kangaroo(Config&& config, ValidConfigTag)
+    : destructorCb_{[cb = std::move(config.destructorCb)](
+                        BufferView key,
+                        BufferView value,
+                        DestructorEvent event) {
+        if (cb) {
+          cb(key, value, event);
+        }
+      }},
+      bucketSize_{config.bucketSize},
+      cacheBaseOffset_{config.cacheBaseOffset},
+      numLogPartitions_{config.numLogPartitions},
+      numLogPagesPerPartition_{config.numLogPagesPerPartition()},
+      logSegmentPages_{config.logSegmentPages},
+      logSize_{config.logSize()},
+      numSets_{config.numSets()},
+      setAdmissionThreshold_{config.setAdmissionThreshold},
+      bloomFilter_{std::move(config.bloomFilter)},
+      device_{*config.device},
+      partitions_{new LogPartition[config.numLogPartitions]} {
+  XLOGF(INFO,
+        "Kangaroo created: sets: {}, bucket size: {}, base offset: {}, "
+        "log size: {}, log partitions: {}",
+        numSets_,
+        bucketSize_,
+        cacheBaseOffset_,
+        logSize_,
+        numLogPartitions_);
+  reset();
+}
+
+void Kangaroo::reset() {
+  XLOG(INFO, "Reset Kangaroo");
+  generationTime_ = getSteadyClock();
+
+  if (bloomFilter_) {
+    bloomFilter_->reset();
+  }
+
+  for (uint32_t i = 0; i < numLogPartitions_; i++) {
+    auto& partition = partitions_[i];
+    std::lock_guard<std::mutex> reclaimLock{partition.reclaimMutex};
+    std::unique_lock<folly::SharedMutex> lock{partition.mutex};
+    partition.nextPageId = 0;
+    partition.oldestPageId = 0;
+    partition.index.clear();
+    partition.entriesCapacity = 0;
+    partition.buffer = device_.makeIOBuffer(bucketSize_);
+    initLogPage(partition.buffer);
+  }
+
+  itemCount_.set(0);
+  logItemCount_.set(0);
+  insertCount_.set(0);
+  succInsertCount_.set(0);
+  lookupCount_.set(0);
+  succLookupCount_.set(0);
+  logHitCount_.set(0);
+  removeCount_.set(0);
+  succRemoveCount_.set(0);
+  evictionCount_.set(0);
+  logDropCount_.set(0);
+  movedItemCount_.set(0);
+  logPageWriteCount_.set(0);
+  setWriteCount_.set(0);
+  logicalWrittenCount_.set(0);
+  physicalWrittenCount_.set(0);
+  ioErrorCount_.set(0);
+  bfRejectCount_.set(0);
+}
+
+uint64_t Kangaroo::getMaxItemSize() const {
+  auto itemOverhead = BucketStorage::slotSize(sizeof(details::BucketEntry));
+  return bucketSize_ - sizeof(Bucket) - itemOverhead;
+}
+
+void Kangaroo::getCounters(const CounterVisitor& visitor) const {
+  visitor("navy_kangaroo_items", itemCount_.get());
+  visitor("navy_kangaroo_log_items", logItemCount_.get());
+  visitor("navy_kangaroo_inserts", insertCount_.get());
+  visitor("navy_kangaroo_succ_inserts", succInsertCount_.get());
+  visitor("navy_kangaroo_lookups", lookupCount_.get());
+  visitor("navy_kangaroo_succ_lookups", succLookupCount_.get());
+  visitor("navy_kangaroo_log_hits", logHitCount_.get());
+  visitor("navy_kangaroo_removes", removeCount_.get());
+  visitor("navy_kangaroo_succ_removes", succRemoveCount_.get());
+  visitor("navy_kangaroo_evictions", evictionCount_.get());
+  visitor("navy_kangaroo_log_drops", logDropCount_.get());
+  visitor("navy_kangaroo_moved_items", movedItemCount_.get());
+  visitor("navy_kangaroo_log_page_writes", logPageWriteCount_.get());
+  visitor("navy_kangaroo_set_writes", setWriteCount_.get());
+  visitor("navy_kangaroo_logical_written", logicalWrittenCount_.get());
+  visitor("navy_kangaroo_physical_written", physicalWrittenCount_.get());
+  visitor("navy_kangaroo_io_errors", ioErrorCount_.get());
+  visitor("navy_kangaroo_bf_rejects", bfRejectCount_.get());
+
+  uint64_t indexBytes = 0;
+  for (uint32_t i = 0; i < numLogPartitions_; i++) {
+    const auto& partition = partitions_[i];
+    std::shared_lock<folly::SharedMutex> lock{partition.mutex};
+    indexBytes += partition.index.getAllocatedMemorySize() +
+                  partition.entriesCapacity * sizeof(LogEntry);
+  }
+  visitor("navy_kangaroo_log_index_bytes", indexBytes);
+}
+
+void Kangaroo::persist(RecordWriter& rw) {
+  XLOG(INFO, "Starting kangaroo persist");
+  // The pages being filled are written to their slots, which are free, and
+  // read back on recovery. This can reclaim segments, so the counters are
+  // saved after it.
+  flush();
+
+  serialization::KangarooPersistentData pd;
+  *pd.version_ref() = kFormatVersion;
+  *pd.generationTime_ref() = generationTime_.count();
+  *pd.itemCount_ref() = itemCount_.get();
+  *pd.logItemCount_ref() = logItemCount_.get();
+  *pd.bucketSize_ref() = bucketSize_;
+  *pd.cacheBaseOffset_ref() = cacheBaseOffset_;
+  *pd.numSets_ref() = numSets_;
+  *pd.logSize_ref() = logSize_;
+  *pd.numLogPartitions_ref() = numLogPartitions_;
+  serializeProto(pd, rw);
+
+  for (uint32_t i = 0; i < numLogPartitions_; i++) {
+    auto& partition = partitions_[i];
+    std::lock_guard<std::mutex> reclaimLock{partition.reclaimMutex};
+    std::shared_lock<folly::SharedMutex> lock{partition.mutex};
+    serialization::KangarooLogPartition lp;
+    *lp.nextPageId_ref() = partition.nextPageId;
+    *lp.oldestPageId_ref() = partition.oldestPageId;
+    for (const auto& kv : partition.index) {
+      for (const auto& entry : kv.second) {
+        serialization::KangarooLogEntry e;
+        *e.keyHash_ref() = static_cast<int64_t>(entry.keyHash);
+        *e.pageId_ref() = static_cast<int64_t>(entry.pageId);
+        lp.entries_ref()->push_back(e);
+      }
+    }
+    serializeProto(lp, rw);
+  }
+
+  if (bloomFilter_) {
+    bloomFilter_->persist<ProtoSerializer>(rw);
+    XLOG(INFO, "bloom filter persist done");
+  }
+
+  XLOG(INFO, "Finished kangaroo persist");
+}
+
+bool Kangaroo::recover(RecordReader& rr) {
+  XLOG(INFO, "Starting kangaroo recovery");
+  try {
+    auto pd = deserializeProto<serialization::KangarooPersistentData>(rr);
+    if (*pd.version_ref() != kFormatVersion) {
+      throw std::logic_error{
+          folly::sformat("invalid format version {}, expected {}",
+                         *pd.version_ref(),
+                         kFormatVersion)};
+    }
+
+    auto configEquals =
+        static_cast<uint64_t>(*pd.bucketSize_ref()) == bucketSize_ &&
+        static_cast<uint64_t>(*pd.cacheBaseOffset_ref()) == cacheBaseOffset_ &&
+        static_cast<uint64_t>(*pd.numSets_ref()) == numSets_ &&
+        static_cast<uint64_t>(*pd.logSize_ref()) == logSize_ &&
+        static_cast<uint32_t>(*pd.numLogPartitions_ref()) == numLogPartitions_;
+    if (!configEquals) {
+      auto configStr = serializeToJson(pd);
+      XLOGF(ERR, "Recovery config: {}", configStr.c_str());
+      throw std::logic_error{"config mismatch"};
+    }
+
+    generationTime_ = std::chrono::nanoseconds{*pd.generationTime_ref()};
+    itemCount_.set(*pd.itemCount_ref());
+    logItemCount_.set(*pd.logItemCount_ref());
+
+    for (uint32_t i = 0; i < numLogPartitions_; i++) {
+      auto lp = deserializeProto<serialization::KangarooLogPartition>(rr);
+      auto& partition = partitions_[i];
+      std::lock_guard<std::mutex> reclaimLock{partition.reclaimMutex};
+      std::unique_lock<folly::SharedMutex> lock{partition.mutex};
+      partition.nextPageId = static_cast<uint64_t>(*lp.nextPageId_ref());
+      partition.oldestPageId = static_cast<uint64_t>(*lp.oldestPageId_ref());
+      if (partition.nextPageId < partition.oldestPageId ||
+          partition.nextPageId - partition.oldestPageId >=
+              numLogPagesPerPartition_) {
+        throw std::logic_error{folly::sformat(
+            "invalid log pages [{}, {}] of partition {}",
+            partition.oldestPageId,
+            partition.nextPageId,
+            i)};
+      }
+
+      partition.index.clear();
+      partition.entriesCapacity = 0;
+      for (const auto& e : *lp.entries_ref()) {
+        const LogEntry entry{static_cast<uint64_t>(*e.keyHash_ref()),
+                             static_cast<uint64_t>(*e.pageId_ref())};
+        const auto setId = getSetId(entry.keyHash);
+        if (&getPartition(setId) != &partition ||
+            entry.pageId < partition.oldestPageId ||
+            entry.pageId > partition.nextPageId) {
+          throw std::logic_error{
+              folly::sformat("invalid log entry of partition {}", i)};
+        }
+        addLogEntry(partition, setId, entry);
+      }
+
+      partition.buffer = readLogPage(partition, partition.nextPageId);
+      if (partition.buffer.isNull()) {
+        throw std::logic_error{
+            folly::sformat("failed to read the log page of partition {}", i)};
+      }
+    }
+
+    if (bloomFilter_) {
+      bloomFilter_->recover<ProtoSerializer>(rr);
+      XLOG(INFO, "Recovered bloom filter");
+    }
+  } catch (const std::exception& e) {
+    XLOGF(ERR, "Exception: {}", e.what());
+    XLOG(ERR, "Failed to recover kangaroo. Resetting cache.");
+
+    reset();
+    return false;
+  }
+  XLOG(INFO, "Finished kangaroo recovery");
+  return true;
+}
+
+const Kangaroo::LogEntry* Kangaroo::findLogEntry(const LogPartition& partition,
+                                                 uint32_t setId,
+                                                 uint64_t keyHash) {
+  auto it = partition.index.find(setId);
+  if (it == partition.index.end()) {
+    return nullptr;
+  }
+  for (const auto& entry : it->second) {
+    if (entry.keyHash == keyHash) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+void Kangaroo::addLogEntry(LogPartition& partition,
+                           uint32_t setId,
+                           const LogEntry& entry) {
+  auto& entries = partition.index[setId];
+  const auto capacity = entries.capacity();
+  entries.push_back(entry);
+  partition.entriesCapacity += entries.capacity() - capacity;
+}
+
+bool Kangaroo::removeLogEntry(LogPartition& partition,
+                              uint32_t setId,
+                              uint64_t keyHash) {
+  auto it = partition.index.find(setId);
+  if (it == partition.index.end()) {
+    return false;
+  }
+  auto& entries = it->second;
+  auto entry =
+      std::find_if(entries.begin(), entries.end(), [keyHash](const auto& e) {
+        return e.keyHash == keyHash;
+      });
+  if (entry == entries.end()) {
+    return false;
+  }
+  entries.erase(entry);
+  if (entries.empty()) {
+    partition.entriesCapacity -= entries.capacity();
+    partition.index.erase(it);
+  }
+  return true;
+}
+
+bool Kangaroo::removeLogEntry(LogPartition& partition,
+                              uint32_t setId,
+                              const LogEntry& entry) {
+  const auto* current = findLogEntry(partition, setId, entry.keyHash);
+  if (current == nullptr || current->pageId != entry.pageId) {
+    return false;
+  }
+  return removeLogEntry(partition, setId, entry.keyHash);
+}
+
+Status Kangaroo::insert(HashedKey hk, BufferView value) {
+  const auto setId = getSetId(hk.keyHash());
+  auto& partition = getPartition(setId);
+  insertCount_.inc();
+
+  const auto slotSize = BucketStorage::slotSize(
+      details::BucketEntry::computeSize(hk.key().size(), value.size()));
+
+  RemovedItems removedItems;
+  const auto cb = makeCollector(removedItems);
+  bool logFull = false;
+  bool flushed = true;
+  {
+    std::unique_lock<folly::SharedMutex> lock{partition.mutex};
+    auto* page = reinterpret_cast<Bucket*>(partition.buffer.data());
+    while (page->remainingBytes() < slotSize && isLogFull(partition)) {
+      // the oldest segment is still being moved to the sets. Wait for it,
+      // or move it if the insert that filled the log has not started yet.
+      lock.unlock();
+      {
+        std::lock_guard<std::mutex> reclaimLock{partition.reclaimMutex};
+        reclaimLogSegment(partition, cb);
+      }
+      lock.lock();
+      page = reinterpret_cast<Bucket*>(partition.buffer.data());
+    }
+    if (page->remainingBytes() < slotSize) {
+      flushed = flushLogPage(partition);
+      logFull = isLogFull(partition);
+      page = reinterpret_cast<Bucket*>(partition.buffer.data());
+    }
+
+    if (flushed) {
+      // A replaced value in a written page stays there until the page is
+      // reclaimed, and an older value in the set until the new one is moved
+      // there.
+      if (removeLogEntry(partition, setId, hk.keyHash())) {
+        itemCount_.dec();
+        logItemCount_.dec();
+        page->remove(hk, DestructorCallback{});
+      }
+      const auto evicted = page->insert(hk, value, cb);
+      XDCHECK_EQ(0u, evicted);
+      addLogEntry(partition, setId,
+                  LogEntry{hk.keyHash(), partition.nextPageId});
+    }
+  }
+
+  // the page just written needs the slot of the oldest segment
+  if (logFull) {
+    std::lock_guard<std::mutex> reclaimLock{partition.reclaimMutex};
+    reclaimLogSegment(partition, cb);
+  }
+
+  for (const auto& item : removedItems) {
+    destructorCb_(std::get<0>(item).view() /* key */,
+                  std::get<1>(item).view() /* value */,
+                  std::get<2>(item) /* event */);
+  }
+  if (!flushed) {
+    return Status::DeviceError;
+  }
+
+  itemCount_.inc();
+  logItemCount_.inc();
+  logicalWrittenCount_.add(hk.key().size() + value.size());
+  succInsertCount_.inc();
+  return Status::Ok;
+}
+
+bool Kangaroo::couldExist(HashedKey hk) {
+  const auto setId = getSetId(hk.keyHash());
+  auto& partition = getPartition(setId);
+  bool canExist;
+  {
+    std::shared_lock<folly::SharedMutex> lock{partition.mutex};
+    canExist = findLogEntry(partition, setId, hk.keyHash()) != nullptr;
+    if (!canExist) {
+      std::shared_lock<folly::SharedMutex> setLock{getSetMutex(setId)};
+      canExist = !bfReject(setId, hk.keyHash());
+    }
+  }
+
+  // the caller is not likely to issue a subsequent lookup when we return
+  // false. hence tag this as a lookup.
+  if (!canExist) {
+    lookupCount_.inc();
+  }
+  return canExist;
+}
+
+Status Kangaroo::lookup(HashedKey hk, Buffer& value) {
+  const auto setId = getSetId(hk.keyHash());
+  auto& partition = getPartition(setId);
+  lookupCount_.inc();
+
+  Buffer set;
+  {
+    std::shared_lock<folly::SharedMutex> lock{partition.mutex};
+    if (const auto* entry = findLogEntry(partition, setId, hk.keyHash())) {
+      Status status;
+      if (entry->pageId == partition.nextPageId) {
+        status = findInPage(partition.buffer, hk, value);
+      } else {
+        auto page = readLogPage(partition, entry->pageId);
+        if (page.isNull()) {
+          ioErrorCount_.inc();
+          return Status::DeviceError;
+        }
+        status = findInPage(page, hk, value);
+      }
+      if (status == Status::Ok) {
+        logHitCount_.inc();
+        succLookupCount_.inc();
+        return status;
+      }
+      // another key with the same hash is in the log
+    }
+
+    std::shared_lock<folly::SharedMutex> setLock{getSetMutex(setId)};
+    if (bfReject(setId, hk.keyHash())) {
+      return Status::NotFound;
+    }
+
+    set = readSet(setId);
+    if (set.isNull()) {
+      ioErrorCount_.inc();
+      return Status::DeviceError;
+    }
+  }
+
+  const auto status = findInPage(set, hk, value);
+  if (status == Status::Ok) {
+    succLookupCount_.inc();
+  }
+  return status;
+}
+
+Status Kangaroo::remove(HashedKey hk) {
+  const auto setId = getSetId(hk.keyHash());
+  auto& partition = getPartition(setId);
+  removeCount_.inc();
+
+  // Both the value in the log and an older value in the set are removed.
+  // Only the newest of them gets a destructor call.
+  RemovedItems removedItems;
+  const auto cb = makeCollector(removedItems);
+  bool foundInLog = false;
+  {
+    // no move to the sets writes the set meanwhile
+    std::lock_guard<std::mutex> reclaimLock{partition.reclaimMutex};
+    std::unique_lock<folly::SharedMutex> lock{partition.mutex};
+    if (const auto* entry = findLogEntry(partition, setId, hk.keyHash())) {
+      const bool inBuffer = entry->pageId == partition.nextPageId;
+      auto page = inBuffer ? Buffer{} : readLogPage(partition, entry->pageId);
+      if (!inBuffer && page.isNull()) {
+        ioErrorCount_.inc();
+        return Status::DeviceError;
+      }
+      const auto* bucket = reinterpret_cast<const Bucket*>(
+          inBuffer ? partition.buffer.data() : page.data());
+      auto valueView = bucket->find(hk);
+      if (!valueView.isNull()) {
+        cb(hk.key(), valueView, DestructorEvent::Removed);
+        foundInLog = true;
+        removeLogEntry(partition, setId, hk.keyHash());
+        itemCount_.dec();
+        logItemCount_.dec();
+      }
+    }
+
+    if (!bfReject(setId, hk.keyHash())) {
+      auto set = readSet(setId);
+      if (set.isNull()) {
+        ioErrorCount_.inc();
+        return Status::DeviceError;
+      }
+      auto* bucket = reinterpret_cast<Bucket*>(set.data());
+      if (bucket->remove(hk, foundInLog ? DestructorCallback{} : cb)) {
+        itemCount_.dec();
+        bfRebuild(setId, bucket);
+        if (!writePage(getSetOffset(setId), std::move(set))) {
+          if (bloomFilter_) {
+            bloomFilter_->clear(setId);
+          }
+          ioErrorCount_.inc();
+          return Status::DeviceError;
+        }
+        setWriteCount_.inc();
+      }
+    }
+  }
+
+  if (removedItems.empty()) {
+    return Status::NotFound;
+  }
+  for (const auto& item : removedItems) {
+    destructorCb_(std::get<0>(item).view() /* key */,
+                  std::get<1>(item).view() /* value */,
+                  std::get<2>(item) /* event */);
+  }
+  succRemoveCount_.inc();
+  return Status::Ok;
+}
+
+bool Kangaroo::bfReject(uint32_t setId, uint64_t keyHash) const {
+  if (bloomFilter_ && !bloomFilter_->couldExist(setId, keyHash)) {
+    bfRejectCount_.inc();
+    return true;
+  }
+  return false;
+}
+
+void Kangaroo::bfRebuild(uint32_t setId, const Bucket* bucket) {
+  if (!bloomFilter_) {
+    return;
+  }
+  bloomFilter_->clear(setId);
+  auto itr = bucket->getFirst();
+  while (!itr.done()) {
+    bloomFilter_->set(setId, itr.keyHash());
+    itr = bucket->getNext(itr);
+  }
+}
+
+void Kangaroo::flush() {
+  XLOG(INFO, "Flush kangaroo");
+  // write the pages being filled to their slots, without moving to the
+  // next pages, so that the log is complete on the device
+  RemovedItems removedItems;
+  const auto cb = makeCollector(removedItems);
+  for (uint32_t i = 0; i < numLogPartitions_; i++) {
+    auto& partition = partitions_[i];
+    std::lock_guard<std::mutex> reclaimLock{partition.reclaimMutex};
+    while (true) {
+      {
+        std::shared_lock<folly::SharedMutex> lock{partition.mutex};
+        // the slot of the page being filled is free once the log is not full
+        if (!isLogFull(partition)) {
+          auto copy = device_.makeIOBuffer(bucketSize_);
+          std::memcpy(copy.data(), partition.buffer.data(), bucketSize_);
+          if (!writePage(getLogPageOffset(partition, partition.nextPageId),
+                         std::move(copy))) {
+            XLOGF(ERR, "Failed to write the log page of partition {}", i);
+            ioErrorCount_.inc();
+          }
+          break;
+        }
+      }
+      reclaimLogSegment(partition, cb);
+    }
+  }
+  device_.flush();
+
+  for (const auto& item : removedItems) {
+    destructorCb_(std::get<0>(item).view() /* key */,
+                  std::get<1>(item).view() /* value */,
+                  std::get<2>(item) /* event */);
+  }
+}
+
+void Kangaroo::initLogPage(Buffer& buffer) const {
+  Bucket::initNew(buffer.mutableView(), generationTime_.count());
+}
+
+Status Kangaroo::findInPage(const Buffer& page, HashedKey hk, Buffer& value) {
+  auto valueView = reinterpret_cast<const Bucket*>(page.data())->find(hk);
+  if (valueView.isNull()) {
+    return Status::NotFound;
+  }
+  value = Buffer{valueView};
+  return Status::Ok;
+}
+
+Buffer Kangaroo::readLogPage(const LogPartition& partition, uint64_t pageId) {
+  auto buffer = device_.makeIOBuffer(bucketSize_);
+  XDCHECK(!buffer.isNull());
+  if (!device_.read(getLogPageOffset(partition, pageId), buffer.size(),
+                    buffer.data())) {
+    return {};
+  }
+
+  // Unlike a set, a log page the index points to must be valid
+  auto* page = reinterpret_cast<Bucket*>(buffer.data());
+  if (Bucket::computeChecksum(buffer.view()) != page->getChecksum() ||
+      static_cast<uint64_t>(generationTime_.count()) !=
+          page->generationTime()) {
+    return {};
+  }
+  return buffer;
+}
+
+Buffer Kangaroo::readSet(uint32_t setId) {
+  auto buffer = device_.makeIOBuffer(bucketSize_);
+  XDCHECK(!buffer.isNull());
+  if (!device_.read(getSetOffset(setId), buffer.size(), buffer.data())) {
+    return {};
+  }
+
+  // sets that were never written or belong to an older generation are empty
+  auto* set = reinterpret_cast<Bucket*>(buffer.data());
+  if (Bucket::computeChecksum(buffer.view()) != set->getChecksum() ||
+      static_cast<uint64_t>(generationTime_.count()) != set->generationTime()) {
+    Bucket::initNew(buffer.mutableView(), generationTime_.count());
+  }
+  return buffer;
+}
+
+bool Kangaroo::writePage(uint64_t offset, Buffer buffer) {
+  auto* page = reinterpret_cast<Bucket*>(buffer.data());
+  page->setChecksum(Bucket::computeChecksum(buffer.view()));
+  if (!device_.write(offset, std::move(buffer))) {
+    return false;
+  }
+  physicalWrittenCount_.add(bucketSize_);
+  return true;
+}
+
+bool Kangaroo::flushLogPage(LogPartition& partition) {
+  XDCHECK(!isLogFull(partition));
+  auto buffer = std::exchange(partition.buffer,
+                              device_.makeIOBuffer(bucketSize_));
+  initLogPage(partition.buffer);
+  if (!writePage(getLogPageOffset(partition, partition.nextPageId),
+                 std::move(buffer))) {
+    // the items of the page are lost. The page id is reused for the next
+    // page.
+    ioErrorCount_.inc();
+    dropLogEntries(partition, partition.nextPageId, partition.nextPageId + 1);
+    return false;
+  }
+  logPageWriteCount_.inc();
+  partition.nextPageId++;
+  return true;
+}
+
+void Kangaroo::dropLogEntries(LogPartition& partition,
+                              uint64_t beginPageId,
+                              uint64_t endPageId) {
+  uint64_t dropped = 0;
+  for (auto it = partition.index.begin(); it != partition.index.end();) {
+    auto& entries = it->second;
+    const auto numEntries = entries.size();
+    auto lost = std::stable_partition(
+        entries.begin(), entries.end(), [=](const LogEntry& e) {
+          return e.pageId < beginPageId || e.pageId >= endPageId;
+        });
+    if (lost != entries.end()) {
+      // older values of the keys in the set must not be found once their
+      // newest values are gone.
+      std::vector<uint64_t> keyHashes;
+      for (auto e = lost; e != entries.end(); ++e) {
+        keyHashes.push_back(e->keyHash);
+      }
+      removeFromSet(it->first, keyHashes);
+    }
+    entries.erase(lost, entries.end());
+    dropped += numEntries - entries.size();
+    if (entries.empty()) {
+      partition.entriesCapacity -= entries.capacity();
+      it = partition.index.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  itemCount_.sub(dropped);
+  logItemCount_.sub(dropped);
+}
+
+void Kangaroo::reclaimLogSegment(LogPartition& partition,
+                                 const DestructorCallback& cb) {
+  uint64_t beginPageId = 0;
+  {
+    std::shared_lock<folly::SharedMutex> lock{partition.mutex};
+    if (!isLogFull(partition)) {
+      // already reclaimed
+      return;
+    }
+    beginPageId = partition.oldestPageId;
+  }
+  const uint64_t endPageId = beginPageId + logSegmentPages_;
+
+  // Log pages read by this reclaim. A null buffer marks a failed read. The
+  // pages on the device are not written until the segment is freed, which
+  // only a reclaim does, so they are read without the lock.
+  folly::F14FastMap<uint64_t, Buffer> pages;
+  // copy of the page being filled
+  Buffer lastPage;
+  uint64_t lastPageId = 0;
+  auto getPage = [&](uint64_t pageId) -> const Bucket* {
+    if (!lastPage.isNull() && pageId == lastPageId) {
+      return reinterpret_cast<const Bucket*>(lastPage.data());
+    }
+    auto it = pages.find(pageId);
+    if (it == pages.end()) {
+      it = pages.emplace(pageId, readLogPage(partition, pageId)).first;
+      if (it->second.isNull()) {
+        ioErrorCount_.inc();
+      }
+    }
+    return it->second.isNull()
+               ? nullptr
+               : reinterpret_cast<const Bucket*>(it->second.data());
+  };
+  for (uint64_t pageId = beginPageId; pageId < endPageId; pageId++) {
+    getPage(pageId);
+  }
+
+  // The items of a set in the log, and what becomes of them
+  struct SetMove {
+    uint32_t setId{};
+    std::vector<LogEntry> entries;
+    // items that are found in the log, with their entries
+    std::vector<HashedKey> keys;
+    std::vector<BufferView> values;
+    std::vector<LogEntry> itemEntries;
+    // entries of pages that failed to be read
+    std::vector<LogEntry> lostEntries;
+    // too few items for a set write
+    bool drop{false};
+    // the set failed to be read or written
+    bool lost{false};
+    // items evicted from the set
+    RemovedItems evicted;
+  };
+
+  // Snapshot of the index for the sets that have items in the segment,
+  // in device order
+  std::vector<SetMove> moves;
+  {
+    std::shared_lock<folly::SharedMutex> lock{partition.mutex};
+    std::vector<uint32_t> setIds;
+    for (uint64_t pageId = beginPageId; pageId < endPageId; pageId++) {
+      const auto* page = getPage(pageId);
+      if (page == nullptr) {
+        continue;
+      }
+      for (auto itr = page->getFirst(); !itr.done();
+           itr = page->getNext(itr)) {
+        const auto setId = getSetId(itr.keyHash());
+        const auto* entry = findLogEntry(partition, setId, itr.keyHash());
+        if (entry != nullptr && entry->pageId == pageId) {
+          setIds.push_back(setId);
+        }
+      }
+    }
+    // the sets with items on pages that failed to be read get their older
+    // values removed along with the move.
+    const bool anyLost =
+        std::any_of(pages.begin(), pages.end(), [=](const auto& kv) {
+          return kv.first >= beginPageId && kv.first < endPageId &&
+                 kv.second.isNull();
+        });
+    if (anyLost) {
+      for (const auto& kv : partition.index) {
+        for (const auto& entry : kv.second) {
+          if (entry.pageId >= beginPageId && entry.pageId < endPageId &&
+              getPage(entry.pageId) == nullptr) {
+            setIds.push_back(kv.first);
+            break;
+          }
+        }
+      }
+    }
+    std::sort(setIds.begin(), setIds.end());
+    setIds.erase(std::unique(setIds.begin(), setIds.end()), setIds.end());
+
+    for (const auto setId : setIds) {
+      auto it = partition.index.find(setId);
+      XDCHECK(it != partition.index.end());
+      moves.emplace_back();
+      moves.back().setId = setId;
+      moves.back().entries = it->second;
+    }
+
+    lastPageId = partition.nextPageId;
+    lastPage = device_.makeIOBuffer(bucketSize_);
+    std::memcpy(lastPage.data(), partition.buffer.data(), bucketSize_);
+  }
+
+  // All the items of a set in the log, including the ones of newer pages,
+  // share the set write.
+  for (auto& setMove : moves) {
+    for (const auto& entry : setMove.entries) {
+      const auto* page = getPage(entry.pageId);
+      if (page == nullptr) {
+        setMove.lostEntries.push_back(entry);
+        continue;
+      }
+      auto itr = findByHash(*page, entry.keyHash);
+      XDCHECK(!itr.done());
+      setMove.keys.push_back(HashedKey::precomputed(itr.key(), entry.keyHash));
+      setMove.values.push_back(itr.value());
+      setMove.itemEntries.push_back(entry);
+    }
+
+    std::unique_lock<folly::SharedMutex> setLock{getSetMutex(setMove.setId)};
+    auto set = readSet(setMove.setId);
+    if (set.isNull()) {
+      ioErrorCount_.inc();
+      setMove.lost = true;
+      continue;
+    }
+
+    // The items of pages that failed to be read are lost. Their older
+    // values in the set are removed, so that lookups miss instead of finding
+    // them.
+    auto* bucket = reinterpret_cast<Bucket*>(set.data());
+    std::vector<uint64_t> lostHashes;
+    for (const auto& entry : setMove.lostEntries) {
+      lostHashes.push_back(entry.keyHash);
+    }
+    const auto numLostRemoved = removeByHash(*bucket, lostHashes);
+    itemCount_.sub(numLostRemoved);
+
+    // Too few items to pay for a set write. The items of the segment are
+    // dropped, and the newer ones stay in the log. If an older value of
+    // one of them is in the set, the set is written anyway to remove it.
+    if (setMove.keys.size() < setAdmissionThreshold_ && numLostRemoved == 0 &&
+        !hasAnyKey(*bucket, setMove.keys)) {
+      setMove.drop = true;
+      continue;
+    }
+
+    setMove.lost = !writeItemsToSet(setMove.setId,
+                                    set,
+                                    setMove.keys,
+                                    setMove.values,
+                                    makeCollector(setMove.evicted));
+  }
+
+  // Commit the moves to the index. Items that were replaced or removed
+  // meanwhile are not in the index anymore: they get no destructor call,
+  // and their values written to the sets are removed again.
+  std::vector<std::pair<uint32_t, std::vector<HashedKey>>> staleKeys;
+  {
+    std::unique_lock<folly::SharedMutex> lock{partition.mutex};
+    for (auto& setMove : moves) {
+      for (const auto& entry : setMove.lostEntries) {
+        if (removeLogEntry(partition, setMove.setId, entry)) {
+          itemCount_.dec();
+          logItemCount_.dec();
+        }
+      }
+
+      if (setMove.drop) {
+        uint64_t numDropped = 0;
+        for (size_t i = 0; i < setMove.keys.size(); i++) {
+          const auto& entry = setMove.itemEntries[i];
+          if (entry.pageId < endPageId &&
+              removeLogEntry(partition, setMove.setId, entry)) {
+            cb(setMove.keys[i].key(),
+               setMove.values[i],
+               DestructorEvent::Recycled);
+            numDropped++;
+          }
+        }
+        itemCount_.sub(numDropped);
+        logItemCount_.sub(numDropped);
+        logDropCount_.add(numDropped);
+        continue;
+      }
+
+      std::vector<HashedKey> stale;
+      for (size_t i = 0; i < setMove.keys.size(); i++) {
+        if (!removeLogEntry(partition, setMove.setId, setMove.itemEntries[i])) {
+          stale.push_back(setMove.keys[i]);
+          continue;
+        }
+        logItemCount_.dec();
+        if (setMove.lost) {
+          itemCount_.dec();
+        } else {
+          movedItemCount_.inc();
+        }
+      }
+
+      for (const auto& item : setMove.evicted) {
+        const auto key = std::get<0>(item).view();
+        const bool isStale =
+            std::any_of(stale.begin(), stale.end(),
+                        [key](HashedKey hk) { return hk.key() == key; });
+        if (isStale) {
+          // an item that was not counted anymore
+          itemCount_.inc();
+          evictionCount_.dec();
+          continue;
+        }
+        cb(key, std::get<1>(item).view(), std::get<2>(item));
+      }
+
+      if (!setMove.lost && !stale.empty()) {
+        staleKeys.emplace_back(setMove.setId, std::move(stale));
+      }
+    }
+
+    // items of pages that failed to be read are lost
+    dropLogEntries(partition, beginPageId, endPageId);
+    partition.oldestPageId = endPageId;
+  }
+
+  // The newer values of these keys are in the log, which is looked up
+  // first. Until they are moved, which only a reclaim does, the older values
+  // in the sets can be removed without the lock.
+  for (const auto& setKeys : staleKeys) {
+    removeFromSet(setKeys.first, setKeys.second);
+  }
+}
+
+bool Kangaroo::writeItemsToSet(uint32_t setId,
+                               Buffer& set,
+                               const std::vector<HashedKey>& keys,
+                               const std::vector<BufferView>& values,
+                               const DestructorCallback& cb) {
+  auto* bucket = reinterpret_cast<Bucket*>(set.data());
+  uint32_t removed = 0;
+  uint32_t evicted = 0;
+  // The older values are removed, without a destructor call, before any
+  // insert. Otherwise an insert could evict the older value of a key
+  // inserted later in the batch, which would be reported as the eviction of
+  // a live item.
+  for (const auto& key : keys) {
+    removed += bucket->remove(key, DestructorCallback{});
+  }
+  for (size_t i = 0; i < keys.size(); i++) {
+    evicted += bucket->insert(keys[i], values[i], cb);
+  }
+  itemCount_.sub(removed + evicted);
+  evictionCount_.add(evicted);
+  bfRebuild(setId, bucket);
+
+  if (!writePage(getSetOffset(setId), std::move(set))) {
+    if (bloomFilter_) {
+      bloomFilter_->clear(setId);
+    }
+    ioErrorCount_.inc();
+    return false;
+  }
+  setWriteCount_.inc();
+  return true;
+}
+
+void Kangaroo::removeFromSet(uint32_t setId,
+                             const std::vector<HashedKey>& keys) {
+  std::unique_lock<folly::SharedMutex> setLock{getSetMutex(setId)};
+  auto set = readSet(setId);
+  if (set.isNull()) {
+    ioErrorCount_.inc();
+    return;
+  }
+  auto* bucket = reinterpret_cast<Bucket*>(set.data());
+  uint32_t removed = 0;
+  for (const auto& key : keys) {
+    removed += bucket->remove(key, DestructorCallback{});
+  }
+  if (removed == 0) {
+    return;
+  }
+  writeSet(setId, bucket, std::move(set));
+}
+
+void Kangaroo::removeFromSet(uint32_t setId,
+                             const std::vector<uint64_t>& keyHashes) {
+  std::unique_lock<folly::SharedMutex> setLock{getSetMutex(setId)};
+  auto set = readSet(setId);
+  if (set.isNull()) {
+    ioErrorCount_.inc();
+    return;
+  }
+  auto* bucket = reinterpret_cast<Bucket*>(set.data());
+  const auto removed = removeByHash(*bucket, keyHashes);
+  if (removed == 0) {
+    return;
+  }
+  // unlike stale values written by a move, these are counted items
+  itemCount_.sub(removed);
+  writeSet(setId, bucket, std::move(set));
+}
+
+void Kangaroo::writeSet(uint32_t setId, const Bucket* bucket, Buffer set) {
+  bfRebuild(setId, bucket);
+  if (!writePage(getSetOffset(setId), std::move(set))) {
+    if (bloomFilter_) {
+      bloomFilter_->clear(setId);
+    }
+    ioErrorCount_.inc();
+    return;
+  }
+  setWriteCount_.inc();
+}
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/SharedMutex.h>
+#include <folly/container/F14Map.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/common/BloomFilter.h"
+#include "cachelib/navy/bighash/Bucket.h"
+#include "cachelib/navy/common/Buffer.h"
+#include "cachelib/navy/common/Device.h"
+#include "cachelib/navy/common/Hash.h"
+#include "cachelib/navy/common/Types.h"
+#include "cachelib/navy/engine/Engine.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+// Kangaroo is a small item flash-based cache engine, like BigHash, that
+// writes less to the device. Its device space is split in a small log and a
+// series of sets.
+//
+// A set is a bucket, exactly like a BigHash bucket: each item is hashed to
+// one set, and a set is read and written as a whole. Inserts don't go to the
+// sets though. They are appended to a page of the log in DRAM, which is
+// written to the device once full, and indexed by a DRAM index. When the log
+// is full, its oldest pages are moved to the sets in a batch: every set that
+// has items in these pages is rewritten once with all its items in the log,
+// not only the items in these pages. Each set write is thus shared by
+// several inserts, instead of one set write per insert in BigHash.
+//
+// The log and its index are split in partitions that each own a share of
+// the sets, so that inserts to different partitions run in parallel. Items
+// moved out of the log to a set with fewer than `setAdmissionThreshold`
+// items in the log are dropped instead of costing a whole set write, unless
+// the set has to be written anyway to drop an older version of one of them.
+//
+// Moving a segment to the sets reads and writes hundreds of pages. It runs
+// in the insert that fills the log, without holding the lock of the
+// partition: lookups and inserts of the partition go on meanwhile, and only
+// wait for the index update at the end. An insert waits for the move only
+// if it fills the page in DRAM before the move is done, and removes of the
+// partition wait for it since they write sets too.
+//
+// The log index keeps, for every set with items in the log, a vector of 16
+// byte entries. This adds a hash map slot and a heap allocation per set to
+// the 16 bytes per item, so the DRAM per item in the log is well above 16
+// bytes when the items are spread over many sets.
+// navy_kangaroo_log_index_bytes reports it. As in BigHash, sets can have a
+// bloom filter to avoid reading them on misses.
+//
+// The destructor callback is invoked when an item is removed, evicted from
+// its set or dropped out of the log. As in BlockCache, it is not invoked for
+// a value replaced in the log by a newer insert of the same key.
+class Kangaroo final : public Engine {
+ public:
+  struct Config {
+    // size of a set and of a log page
+    uint32_t bucketSize{4 * 1024};
+
+    // The range of device that Kangaroo will access is guaranteed to be
+    // within [baseOffset, baseOffset + cacheSize). The log comes first,
+    // then the sets.
+    uint64_t cacheBaseOffset{};
+    uint64_t cacheSize{};
+    Device* device{nullptr};
+
+    DestructorCallback destructorCb;
+
+    // Optional bloom filter, one per set, to reduce IO
+    std::unique_ptr<BloomFilter> bloomFilter;
+
+    // percentage of the cache size that is used for the log
+    uint32_t logSizePct{5};
+
+    // Number of partitions of the log. Each partition has a page of DRAM
+    // that is being filled, and serializes the inserts to its sets.
+    uint32_t numLogPartitions{16};
+
+    // Number of pages of a partition that are moved to the sets at once.
+    // Larger batches share set writes between more items, but the removes
+    // of the partition wait longer for them.
+    uint32_t logSegmentPages{4};
+
+    // minimum number of items of a set in the log to move them to the set
+    uint32_t setAdmissionThreshold{1};
+
+    // number of log pages of every partition
+    uint64_t numLogPagesPerPartition() const {
+      if (bucketSize == 0 || numLogPartitions == 0 || logSegmentPages == 0) {
+        return 0;
+      }
+      const uint64_t numPages =
+          cacheSize * logSizePct / 100 / bucketSize / numLogPartitions;
+      return numPages / logSegmentPages * logSegmentPages;
+    }
+
+    uint64_t logSize() const {
+      return numLogPagesPerPartition() * numLogPartitions * bucketSize;
+    }
+
+    uint64_t numSets() const {
+      return bucketSize == 0 ? 0 : (cacheSize - logSize()) / bucketSize;
+    }
+
+    Config& validate();
+  };
+
+  // Contructor can throw std::exception if config is invalid.
+  //
+  // @param config  config that was validated with Config::validate
+  //
+  // @throw std::invalid_argument on bad config
+  explicit Kangaroo(Config&& config);
+  Kangaroo(const Kangaroo&) = delete;
+  Kangaroo& operator=(const Kangaroo&) = delete;
+  ~Kangaroo() override = default;
+
+  // Check if the key could exist in the log or in its set.
+  //
+  // @return  false if the key definitely does not exist and true if it could.
+  bool couldExist(HashedKey hk) override;
+
+  // Look up a key in the log, then in its set. On success, it will return
+  // Status::Ok and populate "value" with the value found. If not found, it
+  // will return Status::NotFound. On error, it returns DeviceError.
+  Status lookup(HashedKey hk, Buffer& value) override;
+
+  // Appends key and value to the log. This replaces an existing key. It
+  // returns DeviceError if the log failed to make room for the item.
+  Status insert(HashedKey hk, BufferView value) override;
+
+  // Removes an entry from the log and its set if found. Ok on success,
+  // NotFound on miss, and DeviceError on error.
+  Status remove(HashedKey hk) override;
+
+  // flush the device file
+  void flush() override;
+
+  // reset Kangaroo, this clears the log, the bloom filter and all stats.
+  // data is invalidated even it is not physically removed.
+  void reset() override;
+
+  // Write the log pages being filled and serialize Kangaroo state and the
+  // log index to a RecordWriter
+  void persist(RecordWriter& rw) override;
+
+  // deserialize Kangaroo state from a RecordReader
+  // @return true if recovery succeed, false o/w.
+  bool recover(RecordReader& rr) override;
+
+  // returns Kangaroo stats to the visitor
+  void getCounters(const CounterVisitor& visitor) const override;
+
+  // return the maximum allowed item size
+  uint64_t getMaxItemSize() const override;
+
+ private:
+  // A log item in the index. Pages are numbered from the start of the
+  // partition's log, and page n is stored in slot n % numLogPagesPerPartition.
+  struct LogEntry {
+    uint64_t keyHash{};
+    uint64_t pageId{};
+  };
+
+  struct LogPartition {
+    // Serializes the moves of segments to the sets, and the set writes of
+    // removes with them. Taken before @mutex.
+    std::mutex reclaimMutex;
+
+    mutable folly::SharedMutex mutex;
+
+    // id of the page being filled in @buffer
+    uint64_t nextPageId{0};
+
+    // id of the oldest page on the device that can hold items of the index.
+    // The pages in [oldestPageId, nextPageId) are on the device, and there is
+    // always a free slot for the page being filled.
+    uint64_t oldestPageId{0};
+
+    Buffer buffer;
+
+    // items in the log, by set
+    folly::F14FastMap<uint32_t, std::vector<LogEntry>> index;
+
+    // total capacity of the entry vectors of @index
+    uint64_t entriesCapacity{0};
+  };
+
+  struct ValidConfigTag {};
+  Kangaroo(Config&& config, ValidConfigTag);
+
+  uint32_t getSetId(uint64_t keyHash) const {
+    return static_cast<uint32_t>(keyHash % numSets_);
+  }
+
+  LogPartition& getPartition(uint32_t setId) const {
+    return partitions_[setId % numLogPartitions_];
+  }
+
+  uint32_t getPartitionIndex(const LogPartition& partition) const {
+    return static_cast<uint32_t>(&partition - partitions_.get());
+  }
+
+  uint64_t getLogPageOffset(const LogPartition& partition,
+                            uint64_t pageId) const {
+    return cacheBaseOffset_ +
+           (getPartitionIndex(partition) * numLogPagesPerPartition_ +
+            pageId % numLogPagesPerPartition_) *
+               bucketSize_;
+  }
+
+  uint64_t getSetOffset(uint32_t setId) const {
+    return cacheBaseOffset_ + logSize_ + uint64_t{setId} * bucketSize_;
+  }
+
+  // Protects a set and its bloom filter against the moves to the sets,
+  // which don't hold the lock of the partition.
+  folly::SharedMutex& getSetMutex(uint32_t setId) const {
+    return setMutexes_[setId & (kNumSetMutexes - 1)];
+  }
+
+  // whether the slot of the page being filled is still used by the oldest
+  // segment of the log
+  bool isLogFull(const LogPartition& partition) const {
+    return partition.nextPageId - partition.oldestPageId >=
+           numLogPagesPerPartition_;
+  }
+
+  // Returns the log entry of the key in @partition, or nullptr
+  static const LogEntry* findLogEntry(const LogPartition& partition,
+                                      uint32_t setId,
+                                      uint64_t keyHash);
+
+  static void addLogEntry(LogPartition& partition,
+                          uint32_t setId,
+                          const LogEntry& entry);
+
+  // Removes the log entry of the key from @partition
+  //
+  // @return whether the key had an entry
+  static bool removeLogEntry(LogPartition& partition,
+                             uint32_t setId,
+                             uint64_t keyHash);
+
+  // Removes the log entry from @partition, unless the key was replaced or
+  // removed since.
+  //
+  // @return whether the entry was in the index
+  static bool removeLogEntry(LogPartition& partition,
+                             uint32_t setId,
+                             const LogEntry& entry);
+
+  // Reads and validates a log page or a set. Log pages that are invalid
+  // are an error, while invalid sets are just empty.
+  //
+  // @return the page, or a null buffer on error
+  Buffer readLogPage(const LogPartition& partition, uint64_t pageId);
+  Buffer readSet(uint32_t setId);
+
+  bool writePage(uint64_t offset, Buffer buffer);
+
+  // Writes the page being filled to the log. The slot of the next page must
+  // be free. The log may be full afterwards.
+  //
+  // @return false if the page could not be written
+  bool flushLogPage(LogPartition& partition);
+
+  // If the log of the partition is full, moves the items of its oldest
+  // segment to their sets, along with the other items of these sets in the
+  // log, and frees the segment. Items dropped or evicted are passed to @cb.
+  //
+  // The caller holds the reclaimMutex of the partition but not its lock:
+  // the index is snapshot under the lock, the sets are written without it,
+  // and the index is updated under it at the end. Keys replaced meanwhile
+  // stay in the log.
+  void reclaimLogSegment(LogPartition& partition,
+                         const DestructorCallback& cb);
+
+  // Removes the index entries of the pages in [beginPageId, endPageId), and
+  // the older values of their keys from the sets. The caller holds the
+  // partition lock.
+  void dropLogEntries(LogPartition& partition,
+                      uint64_t beginPageId,
+                      uint64_t endPageId);
+
+  // Rewrites the set with the given items, which have been removed from the
+  // log index.
+  //
+  // @return false on error, in which case the set's items are lost
+  bool writeItemsToSet(uint32_t setId,
+                       Buffer& setBuffer,
+                       const std::vector<HashedKey>& keys,
+                       const std::vector<BufferView>& values,
+                       const DestructorCallback& cb);
+
+  // Removes older values that a move to the set wrote along with newer
+  // values of their keys in the log.
+  void removeFromSet(uint32_t setId, const std::vector<HashedKey>& keys);
+
+  // Removes the values of keys whose newest values in the log are lost
+  void removeFromSet(uint32_t setId, const std::vector<uint64_t>& keyHashes);
+
+  // Writes the set after items were removed from it
+  void writeSet(uint32_t setId, const Bucket* bucket, Buffer set);
+
+  void initLogPage(Buffer& buffer) const;
+
+  // Finds the key in the page and copies its value
+  static Status findInPage(const Buffer& page, HashedKey hk, Buffer& value);
+
+  void bfRebuild(uint32_t setId, const Bucket* bucket);
+  bool bfReject(uint32_t setId, uint64_t keyHash) const;
+
+  // Serialization format version. Never 0. Versions < 10 reserved for testing.
+  static constexpr uint32_t kFormatVersion = 10;
+
+  // As in BigHash, enough mutexes that the moves to the sets rarely block a
+  // lookup of another set.
+  static constexpr size_t kNumSetMutexes = 16 * 1024;
+
+  const DestructorCallback destructorCb_{};
+  const uint64_t bucketSize_{};
+  const uint64_t cacheBaseOffset_{};
+  const uint32_t numLogPartitions_{};
+  const uint64_t numLogPagesPerPartition_{};
+  const uint32_t logSegmentPages_{};
+  const uint64_t logSize_{};
+  const uint64_t numSets_{};
+  const uint32_t setAdmissionThreshold_{};
+  std::unique_ptr<BloomFilter> bloomFilter_;
+  std::chrono::nanoseconds generationTime_{};
+  Device& device_;
+  std::unique_ptr<LogPartition[]> partitions_;
+  std::unique_ptr<folly::SharedMutex[]> setMutexes_{
+      new folly::SharedMutex[kNumSetMutexes]};
+
+  mutable AtomicCounter itemCount_;
+  mutable AtomicCounter logItemCount_;
+  mutable AtomicCounter insertCount_;
+  mutable AtomicCounter succInsertCount_;
+  mutable AtomicCounter lookupCount_;
+  mutable AtomicCounter succLookupCount_;
+  mutable AtomicCounter logHitCount_;
+  mutable AtomicCounter removeCount_;
+  mutable AtomicCounter succRemoveCount_;
+  mutable AtomicCounter evictionCount_;
+  mutable AtomicCounter logDropCount_;
+  mutable AtomicCounter movedItemCount_;
+  mutable AtomicCounter logPageWriteCount_;
+  mutable AtomicCounter setWriteCount_;
+  mutable AtomicCounter logicalWrittenCount_;
+  mutable AtomicCounter physicalWrittenCount_;
+  mutable AtomicCounter ioErrorCount_;
+  mutable AtomicCounter bfRejectCount_;
+
+  static_assert((kNumSetMutexes & (kNumSetMutexes - 1)) == 0,
+                "number of mutexes must be power of two");
+};
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,515 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Format.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <map>
+#include <thread>
+
+#include "cachelib/navy/kangaroo/Kangaroo.h"
+#include "cachelib/navy/testing/BufferGen.h"
+#include "cachelib/navy/testing/Callbacks.h"
+#include "cachelib/navy/testing/MockDevice.h"
+
+using testing::_;
+using testing::AtLeast;
+using testing::NiceMock;
+using testing::Return;
+using testing::StrictMock;
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+namespace tests {
+namespace {
+constexpr uint32_t kBucketSize = 256;
+constexpr uint64_t kDeviceSize = kBucketSize * 100;
+
+// A cache of 100 pages, so that the log has @numLogPages pages of a single
+// partition, reclaimed @segmentPages at a time.
+Kangaroo::Config makeConfig(Device& device,
+                            uint32_t numLogPages,
+                            uint32_t segmentPages) {
+  Kangaroo::Config config;
+  config.bucketSize = kBucketSize;
+  config.cacheSize = kDeviceSize;
+  config.device = &device;
+  config.logSizePct = numLogPages;
+  config.numLogPartitions = 1;
+  config.logSegmentPages = segmentPages;
+  return config;
+}
+
+std::map<std::string, double> getCounters(const Kangaroo& kangaroo) {
+  std::map<std::string, double> counters;
+  kangaroo.getCounters([&counters](folly::StringPiece name, double count) {
+    counters[name.str()] = count;
+  });
+  return counters;
+}
+
+std::string makeKey(int i) { return folly::sformat("key {}", i); }
+std::string makeValue(int i) { return folly::sformat("value {}", i); }
+
+// Looks up keys [0, numKeys) and returns the number found with their value
+int countFound(Kangaroo& kangaroo, int numKeys) {
+  int found = 0;
+  for (int i = 0; i < numKeys; i++) {
+    Buffer value;
+    auto status = kangaroo.lookup(makeHK(makeKey(i).c_str()), value);
+    if (status == Status::Ok) {
+      EXPECT_EQ(makeView(makeValue(i).c_str()), value.view());
+      found++;
+    } else {
+      EXPECT_EQ(Status::NotFound, status);
+    }
+  }
+  return found;
+}
+} // namespace
+
+TEST(Kangaroo, InsertAndRemove) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  Kangaroo kangaroo(makeConfig(*device, 4, 2));
+
+  Buffer value;
+  EXPECT_EQ(Status::NotFound, kangaroo.lookup(makeHK("key"), value));
+
+  EXPECT_EQ(Status::Ok, kangaroo.insert(makeHK("key"), makeView("12345")));
+  EXPECT_EQ(Status::Ok, kangaroo.lookup(makeHK("key"), value));
+  EXPECT_EQ(makeView("12345"), value.view());
+
+  EXPECT_EQ(Status::Ok, kangaroo.insert(makeHK("key"), makeView("67890")));
+  EXPECT_EQ(Status::Ok, kangaroo.lookup(makeHK("key"), value));
+  EXPECT_EQ(makeView("67890"), value.view());
+
+  auto counters = getCounters(kangaroo);
+  EXPECT_EQ(1, counters["navy_kangaroo_items"]);
+  EXPECT_EQ(2, counters["navy_kangaroo_log_hits"]);
+
+  EXPECT_EQ(Status::Ok, kangaroo.remove(makeHK("key")));
+  EXPECT_EQ(Status::NotFound, kangaroo.lookup(makeHK("key"), value));
+  EXPECT_EQ(Status::NotFound, kangaroo.remove(makeHK("key")));
+  EXPECT_EQ(0, getCounters(kangaroo)["navy_kangaroo_items"]);
+}
+
+TEST(Kangaroo, CouldExistWithBF) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  auto config = makeConfig(*device, 4, 2);
+  config.bloomFilter = std::make_unique<BloomFilter>(config.numSets(), 2, 4);
+  Kangaroo kangaroo(std::move(config));
+
+  EXPECT_FALSE(kangaroo.couldExist(makeHK("key")));
+  EXPECT_EQ(Status::Ok, kangaroo.insert(makeHK("key"), makeView("12345")));
+  EXPECT_TRUE(kangaroo.couldExist(makeHK("key")));
+  EXPECT_EQ(Status::Ok, kangaroo.remove(makeHK("key")));
+  EXPECT_FALSE(kangaroo.couldExist(makeHK("key")));
+}
+
+TEST(Kangaroo, MoveToSets) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  Kangaroo kangaroo(makeConfig(*device, 4, 2));
+
+  // Pages hold a few items each, so this goes around the log several times
+  constexpr int kNumKeys = 100;
+  for (int i = 0; i < kNumKeys; i++) {
+    EXPECT_EQ(Status::Ok,
+              kangaroo.insert(makeHK(makeKey(i).c_str()),
+                              makeView(makeValue(i).c_str())));
+  }
+
+  auto counters = getCounters(kangaroo);
+  EXPECT_LT(0, counters["navy_kangaroo_moved_items"]);
+  EXPECT_EQ(0, counters["navy_kangaroo_log_drops"]);
+  EXPECT_EQ(0, counters["navy_kangaroo_io_errors"]);
+  EXPECT_LT(0, counters["navy_kangaroo_set_writes"]);
+  EXPECT_LE(counters["navy_kangaroo_set_writes"],
+            counters["navy_kangaroo_moved_items"]);
+  EXPECT_EQ(kNumKeys,
+            counters["navy_kangaroo_items"] +
+                counters["navy_kangaroo_evictions"]);
+  EXPECT_EQ(counters["navy_kangaroo_items"], countFound(kangaroo, kNumKeys));
+  // at least an entry per item in the log
+  EXPECT_LE(counters["navy_kangaroo_log_items"] * 16,
+            counters["navy_kangaroo_log_index_bytes"]);
+}
+
+TEST(Kangaroo, SetAdmissionThreshold) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  auto config = makeConfig(*device, 4, 2);
+  // no set gets that many items in the log
+  config.setAdmissionThreshold = 1000;
+  MockDestructor helper;
+  EXPECT_CALL(helper, call(_, _, DestructorEvent::Recycled))
+      .Times(AtLeast(1));
+  config.destructorCb = toCallback(helper);
+  Kangaroo kangaroo(std::move(config));
+
+  constexpr int kNumKeys = 100;
+  for (int i = 0; i < kNumKeys; i++) {
+    EXPECT_EQ(Status::Ok,
+              kangaroo.insert(makeHK(makeKey(i).c_str()),
+                              makeView(makeValue(i).c_str())));
+  }
+
+  auto counters = getCounters(kangaroo);
+  EXPECT_EQ(0, counters["navy_kangaroo_set_writes"]);
+  EXPECT_EQ(0, counters["navy_kangaroo_moved_items"]);
+  EXPECT_LT(0, counters["navy_kangaroo_log_drops"]);
+  EXPECT_EQ(kNumKeys,
+            counters["navy_kangaroo_items"] +
+                counters["navy_kangaroo_log_drops"]);
+  EXPECT_EQ(counters["navy_kangaroo_items"],
+            counters["navy_kangaroo_log_items"]);
+  EXPECT_EQ(counters["navy_kangaroo_items"], countFound(kangaroo, kNumKeys));
+
+  // the first keys were dropped
+  Buffer value;
+  EXPECT_EQ(Status::NotFound,
+            kangaroo.lookup(makeHK(makeKey(0).c_str()), value));
+}
+
+TEST(Kangaroo, DestructorCallback) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  auto config = makeConfig(*device, 4, 2);
+  StrictMock<MockDestructor> helper;
+  // replacing "key 1" in the log doesn't call the destructor
+  EXPECT_CALL(
+      helper,
+      call(makeView("key 1"), makeView("value 2"), DestructorEvent::Removed));
+  config.destructorCb = toCallback(helper);
+  Kangaroo kangaroo(std::move(config));
+
+  EXPECT_EQ(Status::Ok, kangaroo.insert(makeHK("key 1"), makeView("value 1")));
+  EXPECT_EQ(Status::Ok, kangaroo.insert(makeHK("key 1"), makeView("value 2")));
+  EXPECT_EQ(Status::Ok, kangaroo.remove(makeHK("key 1")));
+}
+
+TEST(Kangaroo, RemoveWithOlderValueInSet) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  auto config = makeConfig(*device, 4, 2);
+  StrictMock<MockDestructor> helper;
+  // the older value in the set is removed along, without a destructor call
+  EXPECT_CALL(
+      helper,
+      call(makeView("key"), makeView("value 2"), DestructorEvent::Removed));
+  config.destructorCb = toCallback(helper);
+  Kangaroo kangaroo(std::move(config));
+
+  EXPECT_EQ(Status::Ok, kangaroo.insert(makeHK("key"), makeView("value 1")));
+  // the first segment of the log, which has "key", moves to the sets
+  int numKeys = 0;
+  while (getCounters(kangaroo)["navy_kangaroo_moved_items"] == 0) {
+    EXPECT_EQ(Status::Ok,
+              kangaroo.insert(makeHK(makeKey(numKeys).c_str()),
+                              makeView(makeValue(numKeys).c_str())));
+    numKeys++;
+  }
+  EXPECT_EQ(0, getCounters(kangaroo)["navy_kangaroo_evictions"]);
+
+  EXPECT_EQ(Status::Ok, kangaroo.insert(makeHK("key"), makeView("value 2")));
+  EXPECT_EQ(Status::Ok, kangaroo.remove(makeHK("key")));
+  Buffer value;
+  EXPECT_EQ(Status::NotFound, kangaroo.lookup(makeHK("key"), value));
+  EXPECT_EQ(Status::NotFound, kangaroo.remove(makeHK("key")));
+
+  auto counters = getCounters(kangaroo);
+  EXPECT_EQ(numKeys, counters["navy_kangaroo_items"]);
+  EXPECT_EQ(1, counters["navy_kangaroo_succ_removes"]);
+}
+
+TEST(Kangaroo, MoveToSetWithOlderValues) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  auto config = makeConfig(*device, 4, 2);
+  // whether the key was evicted since it was last inserted
+  std::map<std::string, bool> recycled;
+  config.destructorCb = [&recycled](BufferView key, BufferView,
+                                    DestructorEvent event) {
+    if (event == DestructorEvent::Recycled) {
+      recycled[std::string{reinterpret_cast<const char*>(key.data()),
+                           key.size()}] = true;
+    }
+  };
+  Kangaroo kangaroo(std::move(config));
+
+  // Far more keys than the sets hold, inserted twice. The second time, the
+  // sets are full and have the older values of the keys moved to them.
+  constexpr int kNumKeys = 1000;
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < kNumKeys; i++) {
+      const auto key = makeKey(i);
+      const auto value = folly::sformat("value {} {}", i, round);
+      EXPECT_EQ(Status::Ok,
+                kangaroo.insert(makeHK(key.c_str()), makeView(value.c_str())));
+      recycled[key] = false;
+    }
+  }
+
+  auto counters = getCounters(kangaroo);
+  EXPECT_LT(0, counters["navy_kangaroo_evictions"]);
+  int found = 0;
+  for (int i = 0; i < kNumKeys; i++) {
+    const auto key = makeKey(i);
+    Buffer value;
+    const auto status = kangaroo.lookup(makeHK(key.c_str()), value);
+    if (status != Status::Ok) {
+      EXPECT_EQ(Status::NotFound, status);
+      continue;
+    }
+    // only the newest value is ever found, and a key that is found was not
+    // reported as evicted
+    const auto expected = folly::sformat("value {} 1", i);
+    EXPECT_EQ(makeView(expected.c_str()), value.view());
+    EXPECT_FALSE(recycled[key]) << key;
+    found++;
+  }
+  EXPECT_LT(0, found);
+}
+
+TEST(Kangaroo, DeviceError) {
+  auto device =
+      std::make_unique<NiceMock<MockDevice>>(kDeviceSize, kBucketSize);
+  Kangaroo kangaroo(makeConfig(*device, 4, 2));
+  EXPECT_CALL(*device, writeImpl(_, _, _)).WillRepeatedly(Return(false));
+
+  // inserts succeed until the first page has to be written
+  int i = 0;
+  Status status;
+  while ((status = kangaroo.insert(makeHK(makeKey(i).c_str()),
+                                   makeView(makeValue(i).c_str()))) ==
+         Status::Ok) {
+    i++;
+  }
+  EXPECT_EQ(Status::DeviceError, status);
+  EXPECT_LT(0, i);
+
+  // the items of the page are lost
+  auto counters = getCounters(kangaroo);
+  EXPECT_EQ(0, counters["navy_kangaroo_items"]);
+  EXPECT_EQ(1, counters["navy_kangaroo_io_errors"]);
+  EXPECT_EQ(0, counters["navy_kangaroo_log_page_writes"]);
+  EXPECT_EQ(0, countFound(kangaroo, i));
+}
+
+TEST(Kangaroo, DeviceErrorWithOlderValueInSet) {
+  auto device =
+      std::make_unique<NiceMock<MockDevice>>(kDeviceSize, kBucketSize);
+  Kangaroo kangaroo(makeConfig(*device, 4, 2));
+
+  // fewer keys than the sets hold, so that the first ones are in the sets
+  constexpr int kNumKeys = 300;
+  for (int i = 0; i < kNumKeys; i++) {
+    EXPECT_EQ(Status::Ok,
+              kangaroo.insert(makeHK(makeKey(i).c_str()),
+                              makeView(makeValue(i).c_str())));
+  }
+  EXPECT_LT(0, countFound(kangaroo, 10));
+
+  // only the log pages, at the start of the device, fail to be written
+  constexpr uint64_t kLogSize = 4 * kBucketSize;
+  auto& realDevice = device->getRealDeviceRef();
+  EXPECT_CALL(*device, writeImpl(_, _, _))
+      .WillRepeatedly(testing::Invoke(
+          [&realDevice](uint64_t offset, uint32_t size, const void* data) {
+            if (offset < kLogSize) {
+              return false;
+            }
+            Buffer buffer = realDevice.makeIOBuffer(size);
+            std::memcpy(buffer.data(), data, size);
+            return realDevice.write(offset, std::move(buffer));
+          }));
+
+  // newer values until the page holding them fails to be written
+  int i = 0;
+  while (kangaroo.insert(makeHK(makeKey(i).c_str()),
+                         makeView(folly::sformat("value {} 1", i).c_str())) ==
+         Status::Ok) {
+    i++;
+  }
+  EXPECT_LT(0, i);
+
+  // neither the lost values nor the older ones are found
+  EXPECT_EQ(0, countFound(kangaroo, i));
+  EXPECT_EQ(countFound(kangaroo, kNumKeys),
+            getCounters(kangaroo)["navy_kangaroo_items"]);
+}
+
+TEST(Kangaroo, Recovery) {
+  constexpr int kNumKeys = 100;
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  folly::IOBufQueue queue;
+  int numItems = 0;
+  {
+    Kangaroo kangaroo(makeConfig(*device, 4, 2));
+    for (int i = 0; i < kNumKeys; i++) {
+      EXPECT_EQ(Status::Ok,
+                kangaroo.insert(makeHK(makeKey(i).c_str()),
+                                makeView(makeValue(i).c_str())));
+    }
+    numItems = countFound(kangaroo, kNumKeys);
+
+    auto rw = createMemoryRecordWriter(queue);
+    kangaroo.persist(*rw);
+  }
+
+  Kangaroo kangaroo(makeConfig(*device, 4, 2));
+  auto rr = createMemoryRecordReader(queue);
+  ASSERT_TRUE(kangaroo.recover(*rr));
+  EXPECT_EQ(numItems, getCounters(kangaroo)["navy_kangaroo_items"]);
+  EXPECT_EQ(numItems, countFound(kangaroo, kNumKeys));
+
+  // the log goes on from where it was
+  EXPECT_EQ(Status::Ok, kangaroo.insert(makeHK("key"), makeView("12345")));
+  Buffer value;
+  EXPECT_EQ(Status::Ok, kangaroo.lookup(makeHK("key"), value));
+  EXPECT_EQ(makeView("12345"), value.view());
+}
+
+TEST(Kangaroo, RecoveryBadConfig) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  folly::IOBufQueue queue;
+  {
+    Kangaroo kangaroo(makeConfig(*device, 4, 2));
+    EXPECT_EQ(Status::Ok, kangaroo.insert(makeHK("key"), makeView("12345")));
+    auto rw = createMemoryRecordWriter(queue);
+    kangaroo.persist(*rw);
+  }
+
+  // the log is larger
+  Kangaroo kangaroo(makeConfig(*device, 8, 2));
+  auto rr = createMemoryRecordReader(queue);
+  ASSERT_FALSE(kangaroo.recover(*rr));
+  Buffer value;
+  EXPECT_EQ(Status::NotFound, kangaroo.lookup(makeHK("key"), value));
+}
+
+TEST(Kangaroo, BadConfig) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  {
+    // less than a segment of log per partition
+    auto config = makeConfig(*device, 4, 8);
+    EXPECT_THROW(Kangaroo{std::move(config)}, std::invalid_argument);
+  }
+  {
+    auto config = makeConfig(*device, 4, 2);
+    config.logSizePct = 100;
+    EXPECT_THROW(Kangaroo{std::move(config)}, std::invalid_argument);
+  }
+  {
+    auto config = makeConfig(*device, 4, 2);
+    config.bloomFilter = std::make_unique<BloomFilter>(10, 2, 4);
+    EXPECT_THROW(Kangaroo{std::move(config)}, std::invalid_argument);
+  }
+}
+
+TEST(Kangaroo, ConcurrentInserts) {
+  Kangaroo::Config config;
+  config.bucketSize = kBucketSize;
+  config.cacheSize = kDeviceSize * 4;
+  auto device = createMemoryDevice(config.cacheSize, nullptr /* encryption */);
+  config.device = device.get();
+  config.logSizePct = 8;
+  config.numLogPartitions = 4;
+  config.logSegmentPages = 2;
+  Kangaroo kangaroo(std::move(config));
+
+  constexpr int kNumThreads = 4;
+  constexpr int kNumKeys = 100;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&kangaroo, t] {
+      for (int i = 0; i < kNumKeys; i++) {
+        const auto key = makeKey(t * kNumKeys + i);
+        const auto value = makeValue(t * kNumKeys + i);
+        EXPECT_EQ(Status::Ok,
+                  kangaroo.insert(makeHK(key.c_str()),
+                                  makeView(value.c_str())));
+        Buffer buffer;
+        kangaroo.lookup(makeHK(key.c_str()), buffer);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto counters = getCounters(kangaroo);
+  EXPECT_EQ(kNumThreads * kNumKeys,
+            counters["navy_kangaroo_items"] +
+                counters["navy_kangaroo_evictions"]);
+  EXPECT_EQ(counters["navy_kangaroo_items"],
+            countFound(kangaroo, kNumThreads * kNumKeys));
+}
+
+TEST(Kangaroo, ConcurrentInsertsAndRemoves) {
+  Kangaroo::Config config;
+  config.bucketSize = kBucketSize;
+  config.cacheSize = kDeviceSize * 4;
+  auto device = createMemoryDevice(config.cacheSize, nullptr /* encryption */);
+  config.device = device.get();
+  config.logSizePct = 8;
+  config.numLogPartitions = 2;
+  config.logSegmentPages = 2;
+  config.bloomFilter = std::make_unique<BloomFilter>(config.numSets(), 2, 4);
+  Kangaroo kangaroo(std::move(config));
+
+  // Threads insert the same keys, so that segments are moved to the sets
+  // while their keys are replaced and removed by other threads.
+  constexpr int kNumThreads = 4;
+  constexpr int kNumKeys = 200;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&kangaroo, t] {
+      for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < kNumKeys; i++) {
+          const auto key = makeKey(i);
+          const auto value = makeValue(i);
+          if ((i + t) % 5 == 0) {
+            const auto status = kangaroo.remove(makeHK(key.c_str()));
+            EXPECT_TRUE(status == Status::Ok || status == Status::NotFound);
+            continue;
+          }
+          EXPECT_EQ(Status::Ok,
+                    kangaroo.insert(makeHK(key.c_str()),
+                                    makeView(value.c_str())));
+          Buffer buffer;
+          const auto status = kangaroo.lookup(makeHK(key.c_str()), buffer);
+          EXPECT_TRUE(status == Status::Ok || status == Status::NotFound);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto counters = getCounters(kangaroo);
+  EXPECT_EQ(0, counters["navy_kangaroo_io_errors"]);
+  EXPECT_LT(0, counters["navy_kangaroo_moved_items"]);
+  // every key has a single value, which is the one inserted
+  EXPECT_LT(0, countFound(kangaroo, kNumKeys));
+  EXPECT_EQ(Status::Ok, kangaroo.insert(makeHK("key"), makeView("12345")));
+  kangaroo.flush();
+  Buffer value;
+  EXPECT_EQ(Status::Ok, kangaroo.lookup(makeHK("key"), value));
+}
+} // namespace tests
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
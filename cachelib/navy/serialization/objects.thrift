@@ -79,6 +79,7 @@ struct BlockCacheConfig {
   8: i64 holeCount = 0,
   9: i64 holeSizeTotal = 0,
   10: bool reinsertionPolicyEnabled = false,
+  11: i64 indexNumBuckets = 0,
 }
 
 struct BigHashPersistentData {
@@ -90,3 +91,26 @@ struct BigHashPersistentData {
   6: required i64 numBuckets = 0,
   7: map<i64, i64> sizeDist,
 }
+
+struct KangarooPersistentData {
+  1: required i32 version = 0,
+  2: required i64 generationTime = 0,
+  3: required i64 itemCount = 0,
+  4: required i64 logItemCount = 0,
+  5: required i64 bucketSize = 0,
+  6: required i64 cacheBaseOffset = 0,
+  7: required i64 numSets = 0,
+  8: required i64 logSize = 0,
+  9: required i32 numLogPartitions = 0,
+}
+
+struct KangarooLogEntry {
+  1: required i64 keyHash = 0,
+  2: required i64 pageId = 0,
+}
+
+struct KangarooLogPartition {
+  1: required i64 nextPageId = 0,
+  2: required i64 oldestPageId = 0,
+  3: list<KangarooLogEntry> entries,
+}
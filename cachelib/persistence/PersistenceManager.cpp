@@ -119,9 +119,18 @@ void PersistenceManager::saveCache(PersistenceStreamWriter& writer) {
   auto shmInfo =
       saveShm(writer, PersistenceType::ShmInfo, detail::kShmInfoName);
 
-  // save shm_hash_table
-  auto shmHT =
-      saveShm(writer, PersistenceType::ShmHT, detail::kShmHashTableName);
+  // save shm_hash_table. Once resized, its buckets live in the segment of
+  // the new generation, and while a resize is in progress in two segments.
+  std::vector<std::unique_ptr<ShmSegment>> shmHTs;
+  for (uint32_t generation = 0;
+       generation <= detail::kShmHashTableMaxGeneration; ++generation) {
+    if (ShmManager::segmentExists(
+            cacheDir_, detail::getShmHashTableName(generation), true)) {
+      shmHTs.push_back(saveShmHashTable(writer, generation));
+    }
+  }
+  CACHELIB_CHECK_THROWF(!shmHTs.empty(), "shm {} does not exist.",
+                        detail::kShmHashTableName);
 
   // save shm_chained_alloc_hash_table
   auto shmChainedHT = saveShm(writer, PersistenceType::ShmChainedItemHT,
@@ -219,6 +228,18 @@ void PersistenceManager::restoreCache(PersistenceStreamReader& reader) {
       restoreDataFromBlocks(reader, static_cast<uint8_t*>(shm.addr), dataLen);
       break;
     }
+    case PersistenceType::ShmHTGeneration: {
+      auto buf = reader.read(sizeof(uint32_t));
+      CACHELIB_CHECK_THROW(buf.length() == sizeof(uint32_t), "invalid data");
+      const auto generation = cast<uint32_t>(buf.data());
+      CACHELIB_CHECK_THROWF(
+          generation > 0 && generation <= detail::kShmHashTableMaxGeneration,
+          "invalid hash table generation: {}", generation);
+      auto shm = shmManager.createShm(detail::getShmHashTableName(generation),
+                                      dataLen);
+      restoreDataFromBlocks(reader, static_cast<uint8_t*>(shm.addr), dataLen);
+      break;
+    }
     case PersistenceType::ShmChainedItemHT: {
       auto shm =
           shmManager.createShm(detail::kShmChainedItemHashTableName, dataLen);
@@ -336,6 +357,26 @@ std::unique_ptr<ShmSegment> PersistenceManager::saveShm(
   return segment;
 }
 
+std::unique_ptr<ShmSegment> PersistenceManager::saveShmHashTable(
+    PersistenceStreamWriter& writer, uint32_t generation) {
+  if (generation == 0) {
+    // same as before the hash table could be resized
+    return saveShm(writer, PersistenceType::ShmHT, detail::kShmHashTableName);
+  }
+
+  const auto name = detail::getShmHashTableName(generation);
+  auto segment = ShmManager::attachShmReadOnly(cacheDir_, name, true);
+  auto shm = segment->getCurrentMapping();
+  CACHELIB_CHECK_THROWF(shm.size > 0, "shm {} is empty.", name);
+
+  writer.write(DATA_MARK_CHAR);
+  writer.write(makeHeader(PersistenceType::ShmHTGeneration, shm.size));
+  writer.write(folly::IOBuf(CopyBufferOp::COPY_BUFFER, &generation,
+                            sizeof(generation)));
+  saveDataInBlocks(writer, shm);
+  return segment;
+}
+
 void PersistenceManager::saveDataInBlocks(PersistenceStreamWriter& writer,
                                           const ShmAddr& shm) {
   const uint8_t* ptr = static_cast<uint8_t*>(shm.addr);
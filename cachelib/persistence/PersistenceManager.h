@@ -153,6 +153,10 @@ class PersistenceManager {
                                       PersistenceType,
                                       const std::string&);
 
+  // saves the buckets of the given generation of shm_hash_table
+  std::unique_ptr<ShmSegment> saveShmHashTable(PersistenceStreamWriter&,
+                                               uint32_t generation);
+
   void saveDataInBlocks(PersistenceStreamWriter&, const ShmAddr&);
   void restoreDataFromBlocks(PersistenceStreamReader&, uint8_t*, size_t);
 
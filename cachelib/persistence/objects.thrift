@@ -25,6 +25,9 @@ enum PersistenceType {
   ShmChainedItemHT = 5,
   ShmData = 6,
   NavyPartition = 7,
+  // buckets of shm_hash_table after a resize. The data starts with the
+  // generation of the buckets as uint32_t.
+  ShmHTGeneration = 8,
 }
 
 struct CacheLibVersions {
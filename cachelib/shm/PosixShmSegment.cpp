@@ -176,6 +176,14 @@ void* PosixShmSegment::mapAddress(void* addr) const {
     util::throwSystemError(EINVAL, "Address already mapped");
   }
   XDCHECK(retAddr == addr || addr == nullptr);
+  if (retAddr != nullptr) {
+    try {
+      detail::applyMappingOpts(retAddr, size, opts_);
+    } catch (...) {
+      detail::munmapImpl(retAddr, size);
+      throw;
+    }
+  }
   return retAddr;
 }
 
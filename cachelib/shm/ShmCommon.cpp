@@ -23,10 +23,52 @@
 #include <folly/logging/xlog.h>
 #include <sys/types.h>
 #include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+/* values from <numaif.h>, which is part of libnuma and not always present */
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#endif
+
+#ifndef MPOL_INTERLEAVE
+#define MPOL_INTERLEAVE 3
+#endif
+
+/* On Mac OS / FreeBSD, madvise(2) does not support this flag */
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE 0
+#endif
 
 namespace facebook {
 namespace cachelib {
 
+void ShmSegmentOpts::setHugePagePolicy(util::HugePagePolicy policy) {
+  switch (policy) {
+  case util::HugePagePolicy::kNone:
+    pageSize = PageSizeT::NORMAL;
+    transparentHugePages = false;
+    break;
+  case util::HugePagePolicy::kTransparent:
+    pageSize = PageSizeT::NORMAL;
+    transparentHugePages = true;
+    break;
+  case util::HugePagePolicy::kTwoMB:
+    pageSize = PageSizeT::TWO_MB;
+    transparentHugePages = false;
+    break;
+  case util::HugePagePolicy::kOneGB:
+    pageSize = PageSizeT::ONE_GB;
+    transparentHugePages = false;
+    break;
+  }
+  alignment = std::max(alignment, detail::getPageSize(pageSize));
+}
+
 namespace detail {
 size_t getPageSize(PageSizeT pageSize) {
   static size_t sizes[] = {static_cast<size_t>(sysconf(_SC_PAGESIZE)),
@@ -288,6 +330,44 @@ void munmapImpl(void* addr, size_t length) {
   }
 }
 
+void mbindImpl(void* addr, size_t length, const NumaPolicy& policy) {
+  if (policy.isDefault()) {
+    return;
+  }
+  if (policy.nodes.none()) {
+    util::throwSystemError(EINVAL, "No numa nodes in the policy");
+  }
+
+#if defined(__linux__) && defined(SYS_mbind)
+  const int mode =
+      policy.mode == NumaPolicy::Mode::kBind ? MPOL_BIND : MPOL_INTERLEAVE;
+  static_assert(kMaxNumaNodes <= sizeof(unsigned long) * 8,
+                "numa node mask does not fit into one word");
+  const unsigned long mask = policy.nodes.to_ulong();
+  // the kernel drops the last bit of maxnode, so pass one more than the
+  // number of bits in the mask.
+  const long ret = syscall(SYS_mbind, addr, length, mode, &mask,
+                           kMaxNumaNodes + 1, 0 /* flags */);
+  if (ret != 0) {
+    util::throwSystemError(errno, "Failed to apply the numa policy");
+  }
+#else
+  (void)addr;
+  (void)length;
+  util::throwSystemError(ENOTSUP, "Numa policies are not supported");
+#endif
+}
+
+void applyMappingOpts(void* addr, size_t length, const ShmSegmentOpts& opts) {
+  mbindImpl(addr, length, opts.numaPolicy);
+  if (opts.transparentHugePages && opts.pageSize == PageSizeT::NORMAL &&
+      madvise(addr, length, MADV_HUGEPAGE) != 0) {
+    // the segment works the same without them.
+    XLOGF(WARN, "Transparent huge pages are not available, errno = {}",
+          errno);
+  }
+}
+
 } // namespace detail
 } // namespace cachelib
 } // namespace facebook
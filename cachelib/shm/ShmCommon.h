@@ -20,6 +20,7 @@
 #include <sys/shm.h>
 #include <sys/stat.h>
 
+#include <bitset>
 #include <system_error>
 #include <variant>
 
@@ -89,12 +90,37 @@ struct PosixSysVSegmentOpts {
 
 using ShmTypeOpts = std::variant<FileShmSegmentOpts, PosixSysVSegmentOpts>;
 
+// highest numa node id + 1 that a segment can be placed on.
+constexpr size_t kMaxNumaNodes = 64;
+using NumaBitMask = std::bitset<kMaxNumaNodes>;
+
+// Placement of the pages of a segment across numa nodes. The policy is
+// applied to every mapping of the segment and takes effect when the pages are
+// first touched, so it needs to be set before the segment is used.
+struct NumaPolicy {
+  enum class Mode {
+    kDefault,    // allocate on the node of the thread touching the page
+    kBind,       // allocate only on the nodes in the mask
+    kInterleave, // spread the pages round robin over the nodes in the mask
+  };
+
+  Mode mode{Mode::kDefault};
+  NumaBitMask nodes{};
+
+  bool isDefault() const noexcept { return mode == Mode::kDefault; }
+};
+
 struct ShmSegmentOpts {
   PageSizeT pageSize{PageSizeT::NORMAL};
   bool readOnly{false};
   size_t alignment{1}; // alignment for mapping.
   // opts specific to segment type
   ShmTypeOpts typeOpts{PosixSysVSegmentOpts(false)};
+  // numa placement of the segment memory.
+  NumaPolicy numaPolicy{};
+  // ask the kernel to back the mappings of the segment with transparent huge
+  // pages. Only used with the NORMAL page size. This is best effort.
+  bool transparentHugePages{false};
 
   explicit ShmSegmentOpts(PageSizeT p) : pageSize(p) {}
   explicit ShmSegmentOpts(PageSizeT p, bool ro) : pageSize(p), readOnly(ro) {}
@@ -105,6 +131,11 @@ struct ShmSegmentOpts {
                                        pageSize(p), readOnly(ro),
                                        typeOpts(posix) {}
   ShmSegmentOpts() : pageSize(PageSizeT::NORMAL) {}
+
+  // sets the page size and the transparent huge page advice that back the
+  // segment as the policy asks for. Raises the alignment to the page size
+  // since huge page mappings must start on a page boundary.
+  void setHugePagePolicy(util::HugePagePolicy policy);
 };
 
 // Represents a mapping on shm with and address and size
@@ -201,6 +232,18 @@ void* mmapImpl(void* addr, size_t length, int prot, int flags, int fd, off_t off
 // @throw  std::invalid_argument if there is an error
 void munmapImpl(void* addr, size_t length);
 
+// Applies the numa policy to the mapping. No-op for the default policy.
+//
+// @throw  std::system_error if the policy can not be applied, for example
+//         when the mask contains nodes that are not online.
+void mbindImpl(void* addr, size_t length, const NumaPolicy& policy);
+
+// Applies the numa policy and the transparent huge page advice of the
+// segment options to a new mapping of the segment.
+//
+// @throw  std::system_error if the numa policy can not be applied.
+void applyMappingOpts(void* addr, size_t length, const ShmSegmentOpts& opts);
+
 } // namespace detail
 } // namespace cachelib
 } // namespace facebook
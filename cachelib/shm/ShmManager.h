@@ -139,7 +139,7 @@ class ShmManager {
                            ShmTypeOpts shmOpts);
 
   // Useful for checking whether a segment exists by name associated with a
-  // given cacheDir without instanciating. This should be ONLY used in tests.
+  // given cacheDir without instanciating.
   static bool segmentExists(const std::string& cacheDir,
                             const std::string& segName,
                             ShmTypeOpts shmOpts);
@@ -270,6 +270,14 @@ void* SysVShmSegment::mapAddress(void* addr) const {
 
   void* retAddr = detail::shmAttachImpl(shmid_, addr, shmFlags);
   XDCHECK(retAddr == addr || addr == nullptr);
+  if (retAddr != nullptr) {
+    try {
+      detail::applyMappingOpts(retAddr, getSize(), opts_);
+    } catch (...) {
+      detail::shmDtImpl(retAddr);
+      throw;
+    }
+  }
   return retAddr;
 }
 
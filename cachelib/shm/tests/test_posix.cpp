@@ -25,9 +25,12 @@ static const std::string namePrefix = "posix-shm-test-";
 
 using namespace facebook::cachelib::tests;
 
+using facebook::cachelib::kMaxNumaNodes;
+using facebook::cachelib::NumaPolicy;
 using facebook::cachelib::PosixShmSegment;
 using facebook::cachelib::ShmAttach;
 using facebook::cachelib::ShmNew;
+using facebook::cachelib::ShmSegmentOpts;
 
 class PosixShmTest : public ShmTestBase {
  public:
@@ -127,6 +130,36 @@ TEST_F(PosixShmTest, MapAddress) {
   s.unMap(addr);
 }
 
+TEST_F(PosixShmTest, MapWithNumaPolicy) {
+  const auto size = getRandomSize();
+  ShmSegmentOpts opts;
+  opts.numaPolicy.mode = NumaPolicy::Mode::kBind;
+  opts.numaPolicy.nodes.set(0);
+  PosixShmSegment s(ShmNew, segmentName, size, opts);
+
+  void* addr = nullptr;
+  try {
+    addr = s.mapAddress(getNewUnmappedAddr());
+  } catch (const std::system_error& e) {
+    if (e.code().value() == ENOSYS) {
+      GTEST_SKIP() << "kernel built without numa support";
+    }
+    throw;
+  }
+  const unsigned char magicVal = 'c';
+  writeToMemory(addr, size, magicVal);
+  checkMemory(addr, size, magicVal);
+  s.unMap(addr);
+
+  // nodes that are not online can not be bound to and the mapping is
+  // released on failure.
+  ShmSegmentOpts badOpts;
+  badOpts.numaPolicy.mode = NumaPolicy::Mode::kInterleave;
+  badOpts.numaPolicy.nodes.set(kMaxNumaNodes - 1);
+  PosixShmSegment attached(ShmAttach, segmentName, badOpts);
+  ASSERT_THROW(attached.mapAddress(nullptr), std::system_error);
+}
+
 // attach to a segment that has not been created and ensure that it fails.
 TEST_F(PosixShmTest, AttachToInvalidSegment) {
   // attach with no size